@@ -1791,6 +1791,16 @@ buddy_status_changed(PurpleBuddy *buddy, G_GNUC_UNUSED PurpleStatus *old,
 	update_buddy_display(buddy, ggblist);
 }
 
+static void
+buddies_status_changed(GList *buddies, G_GNUC_UNUSED FinchBuddyList *ggblist)
+{
+	PurpleBuddyList *list = purple_blist_get_default();
+
+	for(GList *l = buddies; l != NULL; l = l->next) {
+		node_update(list, PURPLE_BLIST_NODE(l->data));
+	}
+}
+
 static void
 buddy_idle_changed(PurpleBuddy *buddy, G_GNUC_UNUSED int old,
                    G_GNUC_UNUSED int new, FinchBuddyList *ggblist)
@@ -2819,6 +2829,8 @@ blist_show(G_GNUC_UNUSED PurpleBuddyList *list)
 				G_CALLBACK(reconstruct_accounts_menu), NULL);
 	purple_signal_connect(purple_blist_get_handle(), "buddy-status-changed", finch_blist_get_handle(),
 				G_CALLBACK(buddy_status_changed), ggblist);
+	purple_signal_connect(purple_blist_get_handle(), "buddies-status-changed", finch_blist_get_handle(),
+				G_CALLBACK(buddies_status_changed), ggblist);
 	purple_signal_connect(purple_blist_get_handle(), "buddy-idle-changed", finch_blist_get_handle(),
 				G_CALLBACK(buddy_idle_changed), ggblist);
 
@@ -752,6 +752,8 @@ finch_create_conversation(PurpleConversation *conv)
 	gnt_widget_set_name(ggc->tv, "conversation-window-textview");
 	gnt_widget_set_size(ggc->tv, purple_prefs_get_int(PREF_ROOT "/size/width"),
 			purple_prefs_get_int(PREF_ROOT "/size/height"));
+	gnt_text_view_set_max_lines(GNT_TEXT_VIEW(ggc->tv),
+			MAX(purple_prefs_get_int(PREF_ROOT "/scrollback"), 0));
 
 	if (PURPLE_IS_CHAT_CONVERSATION(conv)) {
 		GntWidget *hbox, *tree;
@@ -50,6 +50,7 @@ finch_prefs_init(void)
 	purple_prefs_add_none("/finch/conversations");
 	purple_prefs_add_bool("/finch/conversations/timestamps", TRUE);
 	purple_prefs_add_bool("/finch/conversations/notify_typing", FALSE);
+	purple_prefs_add_int("/finch/conversations/scrollback", 5000);
 
 	purple_prefs_add_none("/finch/filelocations");
 	purple_prefs_add_path("/finch/filelocations/last_save_folder", "");
@@ -203,6 +204,7 @@ static Prefs convs[] =
 {
 	{PURPLE_PREF_BOOLEAN, "/finch/conversations/timestamps", N_("Show Timestamps"), NULL},
 	{PURPLE_PREF_BOOLEAN, "/finch/conversations/notify_typing", N_("Notify buddies when you are typing"), NULL},
+	{PURPLE_PREF_INT, "/finch/conversations/scrollback", N_("Lines of scrollback (0 for no limit)"), NULL},
 	{PURPLE_PREF_NONE, NULL, NULL, NULL}
 };
 
@@ -26,6 +26,7 @@
 #include "debug.h"
 #include "network.h"
 #include "purpleaccountmanager.h"
+#include "purpleconnectionscheduler.h"
 #include "purpleconversationmanager.h"
 #include "purplecredentialmanager.h"
 #include "purpleenums.h"
@@ -34,16 +35,6 @@
 static guint    save_timer = 0;
 static gboolean accounts_loaded = FALSE;
 
-static void
-purple_accounts_network_changed_cb(G_GNUC_UNUSED GNetworkMonitor *m,
-                                   gboolean available,
-                                   G_GNUC_UNUSED gpointer data)
-{
-	if(available) {
-		purple_accounts_restore_current_statuses();
-	}
-}
-
 /*********************************************************************
  * Writing to disk                                                   *
  *********************************************************************/
@@ -570,15 +561,21 @@ purple_accounts_delete(PurpleAccount *account)
 }
 
 static void
-purple_accounts_restore_current_status(PurpleAccount *account,
-                                       G_GNUC_UNUSED gpointer data) {
+purple_accounts_restore_current_status(PurpleAccount *account, gpointer data) {
+	PurpleConnectionScheduler *scheduler = data;
 	gboolean enabled = FALSE, online = FALSE;
 
 	enabled = purple_account_get_enabled(account);
 	online = purple_presence_is_online(purple_account_get_presence(account));
 
-	if(enabled && online) {
-		purple_account_connect(account);
+	if(!enabled || !online || !purple_account_is_disconnected(account)) {
+		return;
+	}
+
+	/* Accounts that are waiting to reconnect keep waiting. */
+	if(!purple_connection_scheduler_is_pending(scheduler, account)) {
+		purple_connection_scheduler_connect(scheduler, account,
+		                                    G_PRIORITY_DEFAULT);
 	}
 }
 
@@ -596,7 +593,7 @@ purple_accounts_restore_current_statuses(void) {
 	manager = purple_account_manager_get_default();
 	purple_account_manager_foreach(manager,
 	                               purple_accounts_restore_current_status,
-	                               NULL);
+	                               purple_connection_scheduler_get_default());
 }
 
 void *
@@ -669,10 +666,6 @@ purple_accounts_init(void)
 	                      G_CALLBACK(connection_error_cb), NULL);
 
 	load_accounts();
-
-	g_signal_connect(G_OBJECT(g_network_monitor_get_default()),
-	                 "network-changed",
-	                 G_CALLBACK(purple_accounts_network_changed_cb), NULL);
 }
 
 void
@@ -55,6 +55,10 @@ void purple_accounts_delete(PurpleAccount *account);
  * to their startup status by signing them on, setting them
  * away, etc.
  *
+ * The accounts are queued with the default
+ * [class@Purple.ConnectionScheduler] rather than all being
+ * connected at once.
+ *
  * You probably shouldn't call this unless you really know
  * what you're doing.
  */
@@ -26,6 +26,7 @@
 #include "purplebuddypresence.h"
 #include "purplecontactmanager.h"
 #include "purpleconversationmanager.h"
+#include "purpleprivate.h"
 #include "purpleprotocolclient.h"
 #include "util.h"
 
@@ -661,8 +662,53 @@ purple_buddy_get_presence(PurpleBuddy *buddy) {
 }
 
 void
-purple_buddy_update_status(PurpleBuddy *buddy, PurpleStatus *old_status) {
-	PurpleBuddyList *blist = NULL;
+purple_buddy_update_online_count(PurpleBuddy *buddy, PurpleStatus *old_status)
+{
+	PurpleBuddyPrivate *priv = NULL;
+	PurpleBlistNode *cnode = NULL, *gnode = NULL;
+	PurpleCountingNode *contact_counter = NULL, *group_counter = NULL;
+	PurpleStatus *status = NULL;
+	gboolean old_online = FALSE, new_online = FALSE;
+	gint delta = 0, limit = 0;
+
+	g_return_if_fail(PURPLE_IS_BUDDY(buddy));
+
+	priv = purple_buddy_get_instance_private(buddy);
+	status = purple_presence_get_active_status(priv->presence);
+
+	old_online = purple_status_is_online(old_status);
+	new_online = purple_status_is_online(status);
+
+	if(old_online == new_online) {
+		return;
+	}
+
+	cnode = purple_blist_node_get_parent(PURPLE_BLIST_NODE(buddy));
+	if(cnode == NULL) {
+		return;
+	}
+
+	if(new_online) {
+		delta = 1;
+		limit = 1;
+	} else {
+		delta = -1;
+		limit = 0;
+	}
+
+	contact_counter = PURPLE_COUNTING_NODE(cnode);
+	gnode = purple_blist_node_get_parent(cnode);
+	group_counter = PURPLE_COUNTING_NODE(gnode);
+
+	purple_counting_node_change_online_count(contact_counter, delta);
+	if(purple_counting_node_get_online_count(contact_counter) == limit) {
+		purple_counting_node_change_online_count(group_counter, delta);
+	}
+}
+
+void
+purple_buddy_emit_status_changed(PurpleBuddy *buddy, PurpleStatus *old_status)
+{
 	PurpleBuddyPrivate *priv = NULL;
 	PurpleStatus *status = NULL;
 	gpointer handle = NULL;
@@ -673,7 +719,6 @@ purple_buddy_update_status(PurpleBuddy *buddy, PurpleStatus *old_status) {
 
 	priv = purple_buddy_get_instance_private(buddy);
 	status = purple_presence_get_active_status(priv->presence);
-	blist = purple_blist_get_default();
 	handle = purple_blist_get_handle();
 
 	purple_debug_info("blistnodetypes", "Updating buddy status for %s (%s)\n",
@@ -684,33 +729,13 @@ purple_buddy_update_status(PurpleBuddy *buddy, PurpleStatus *old_status) {
 	new_online = purple_status_is_online(status);
 
 	if(old_online != new_online) {
-		PurpleBlistNode *cnode = NULL, *gnode = NULL;
-		PurpleMetaContact *contact = NULL;
-		PurpleCountingNode *contact_counter = NULL, *group_counter = NULL;
-		gint delta = 0, limit = 0;
-
 		if(new_online) {
 			purple_signal_emit(handle, "buddy-signed-on", buddy);
-			delta = 1;
-			limit = 1;
 		} else {
 			purple_blist_node_set_int(PURPLE_BLIST_NODE(buddy), "last_seen",
 			                          time(NULL));
 
 			purple_signal_emit(handle, "buddy-signed-off", buddy);
-			delta = -1;
-			limit = 0;
-		}
-
-		cnode = purple_blist_node_get_parent(PURPLE_BLIST_NODE(buddy));
-		contact = PURPLE_META_CONTACT(cnode);
-		contact_counter = PURPLE_COUNTING_NODE(contact);
-		gnode = purple_blist_node_get_parent(cnode);
-		group_counter = PURPLE_COUNTING_NODE(gnode);
-
-		purple_counting_node_change_online_count(contact_counter, delta);
-		if(purple_counting_node_get_online_count(contact_counter) == limit) {
-			purple_counting_node_change_online_count(group_counter, delta);
 		}
 	} else {
 		purple_signal_emit(handle, "buddy-status-changed", buddy, old_status,
@@ -718,7 +743,7 @@ purple_buddy_update_status(PurpleBuddy *buddy, PurpleStatus *old_status) {
 	}
 
 	/*
-	 * This function used to only call the following two functions if one of
+	 * This function used to only invalidate the priority buddy if one of
 	 * the above signals had been triggered, but that's not good, because
 	 * if someone's away message changes and they don't go from away to back
 	 * to away then no signal is triggered.
@@ -728,8 +753,17 @@ purple_buddy_update_status(PurpleBuddy *buddy, PurpleStatus *old_status) {
 	 * certainly won't hurt anything.  Unless you're on a K6-2 300.
 	 */
 	purple_meta_contact_invalidate_priority_buddy(purple_buddy_get_contact(buddy));
+}
 
-	purple_blist_update_node(blist, PURPLE_BLIST_NODE(buddy));
+void
+purple_buddy_update_status(PurpleBuddy *buddy, PurpleStatus *old_status) {
+	g_return_if_fail(PURPLE_IS_BUDDY(buddy));
+
+	purple_buddy_update_online_count(buddy, old_status);
+	purple_buddy_emit_status_changed(buddy, old_status);
+
+	purple_blist_update_node(purple_blist_get_default(),
+	                         PURPLE_BLIST_NODE(buddy));
 }
 
 PurpleMediaCaps
@@ -537,6 +537,17 @@ purple_buddy_icon_get_stream(PurpleBuddyIcon *icon) {
 	return g_memory_input_stream_new_from_data(data, (gssize)len, NULL);
 }
 
+GBytes *
+purple_buddy_icon_get_contents(PurpleBuddyIcon *icon) {
+	g_return_val_if_fail(icon != NULL, NULL);
+
+	if(icon->img == NULL) {
+		return NULL;
+	}
+
+	return purple_image_get_contents(icon->img);
+}
+
 const char *
 purple_buddy_icon_get_extension(const PurpleBuddyIcon *icon)
 {
@@ -235,6 +235,19 @@ gconstpointer purple_buddy_icon_get_data(const PurpleBuddyIcon *icon, size_t *le
  */
 GInputStream *purple_buddy_icon_get_stream(PurpleBuddyIcon *icon);
 
+/**
+ * purple_buddy_icon_get_contents:
+ * @icon: The #PurpleBuddyIcon instance.
+ *
+ * Gets the data of @icon without copying it.
+ *
+ * Returns: (transfer full) (nullable): A #GBytes of the icon data or %NULL if
+ *          @icon has no data.
+ *
+ * Since: 3.0.0
+ */
+GBytes *purple_buddy_icon_get_contents(PurpleBuddyIcon *icon);
+
 /**
  * purple_buddy_icon_get_extension:
  * @icon: The buddy icon.
@@ -2086,6 +2086,10 @@ purple_blist_init(void)
 	                     purple_marshal_VOID__POINTER_POINTER_POINTER,
 	                     G_TYPE_NONE, 3, PURPLE_TYPE_BUDDY, PURPLE_TYPE_STATUS, 
 	                     PURPLE_TYPE_STATUS);
+	purple_signal_register(handle, "buddies-status-changed",
+	                     purple_marshal_VOID__POINTER, G_TYPE_NONE, 1,
+	                     G_TYPE_POINTER); /* (GList *) of PurpleBuddy */
+
 	purple_signal_register(handle, "buddy-privacy-changed",
 	                     purple_marshal_VOID__POINTER, G_TYPE_NONE,
 	                     1, PURPLE_TYPE_BUDDY);
@@ -2177,6 +2181,8 @@ purple_blist_uninit(void)
 		purple_blist_sync();
 	}
 
+	purple_buddy_presence_clear_updates();
+
 	purple_debug_info("buddylist", "Destroying");
 
 	g_hash_table_destroy(buddies_cache);
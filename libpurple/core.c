@@ -172,6 +172,7 @@ purple_core_init(PurpleUi *ui, G_GNUC_UNUSED GError **error) {
 
 	purple_account_manager_startup();
 	purple_accounts_init();
+	purple_connection_scheduler_startup();
 	purple_contact_manager_startup();
 	purple_savedstatuses_init();
 	purple_notify_init();
@@ -180,8 +181,11 @@ purple_core_init(PurpleUi *ui, G_GNUC_UNUSED GError **error) {
 	purple_whiteboard_manager_startup();
 	purple_blist_init();
 	purple_history_manager_startup();
+	purple_resolver_startup();
 	purple_network_init();
 	purple_proxy_init();
+	purple_http_service_startup();
+	purple_tls_session_cache_startup();
 	purple_stun_init();
 	purple_xfers_init();
 	purple_idle_init();
@@ -247,20 +251,25 @@ purple_core_quit(void)
 	purple_conversations_uninit();
 	purple_blist_uninit();
 	purple_notify_uninit();
+	purple_connection_scheduler_shutdown();
 	purple_connections_uninit();
 	purple_buddy_icons_uninit();
 	purple_savedstatuses_uninit();
 	purple_statuses_uninit();
 	purple_accounts_uninit();
 	purple_xfers_uninit();
+	purple_tls_session_cache_shutdown();
+	purple_http_service_shutdown();
 	purple_proxy_uninit();
 	_purple_image_store_uninit();
 	purple_network_uninit();
+	purple_resolver_shutdown();
 
 	purple_ui_stop(core->ui);
 
 	/* Everything after prefs_uninit must not try to read any prefs */
 	g_clear_object(&settings_backend);
+	purple_debug_uninit();
 	purple_prefs_uninit();
 	purple_plugins_uninit();
 
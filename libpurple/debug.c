@@ -20,9 +20,14 @@
  * along with this program; if not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include "debug.h"
 #include "prefs.h"
 
+#define PURPLE_DEBUG_PREF_LEVEL "/purple/debug/level"
+#define PURPLE_DEBUG_PREF_CATEGORIES "/purple/debug/categories"
+
 /*
  * These determine whether verbose or unsafe debugging are desired.  I
  * don't want to make these purple preferences because their values should
@@ -31,42 +36,241 @@
 static gboolean debug_verbose = FALSE;
 static gboolean debug_unsafe = FALSE;
 
+/* Messages can be logged from any thread, so everything below is protected by
+ * this lock.  The thresholds of the categories are read without it, which at
+ * worst lets one message through or drops one while they are changing.
+ */
+G_LOCK_DEFINE_STATIC(categories);
+
+/* The registered categories, linked through their next pointers. */
+static PurpleDebugCategory *categories = NULL;
+
+/* The level preference, and the floor the UI set with
+ * purple_debug_set_minimum_level().
+ */
+static gint pref_level = PURPLE_DEBUG_ALL;
+static gint minimum_level = PURPLE_DEBUG_ALL;
+
+/* The threshold of categories that aren't in thresholds.  This is read
+ * without the lock, so it's only set atomically.
+ */
+static gint default_threshold = PURPLE_DEBUG_ALL;
+
+/* Category name to level, from the categories preference, and its size which
+ * is read without the lock.
+ */
+static GHashTable *thresholds = NULL;
+static gint n_thresholds = 0;
+
+static guint level_callback_id = 0;
+static guint categories_callback_id = 0;
+
+static const struct {
+	const gchar *name;
+	PurpleDebugLevel level;
+} level_names[] = {
+	{ "all", PURPLE_DEBUG_ALL },
+	{ "misc", PURPLE_DEBUG_MISC },
+	{ "info", PURPLE_DEBUG_INFO },
+	{ "warning", PURPLE_DEBUG_WARNING },
+	{ "error", PURPLE_DEBUG_ERROR },
+	{ "fatal", PURPLE_DEBUG_FATAL },
+};
+
+/******************************************************************************
+ * Thresholds
+ *****************************************************************************/
+static gint
+purple_debug_get_threshold_locked(const gchar *name) {
+	gpointer value = NULL;
+
+	if(name != NULL && thresholds != NULL &&
+	   g_hash_table_lookup_extended(thresholds, name, NULL, &value))
+	{
+		return MAX(GPOINTER_TO_INT(value), minimum_level);
+	}
+
+	return default_threshold;
+}
+
 static void
-purple_debug_vargs(PurpleDebugLevel level, const gchar *category,
-                   const gchar *format, va_list args)
-{
-	GLogLevelFlags log_level = G_LOG_LEVEL_DEBUG;
-	gchar *msg = NULL;
+purple_debug_apply_thresholds_locked(void) {
+	g_atomic_int_set(&default_threshold, MAX(pref_level, minimum_level));
+	g_atomic_int_set(&n_thresholds,
+	                 thresholds != NULL ? g_hash_table_size(thresholds) : 0);
+
+	for(PurpleDebugCategory *category = categories; category != NULL;
+	    category = category->next)
+	{
+		g_atomic_int_set(&category->threshold,
+		                 purple_debug_get_threshold_locked(category->name));
+	}
+}
 
-	g_return_if_fail(format != NULL);
+static void
+purple_debug_category_register_locked(PurpleDebugCategory *category) {
+	category->threshold = purple_debug_get_threshold_locked(category->name);
+	category->next = categories;
+	category->registered = TRUE;
+
+	categories = category;
+}
+
+static void
+purple_debug_parse_thresholds(GList *entries, GHashTable *table) {
+	for(GList *l = entries; l != NULL; l = l->next) {
+		gchar **parts = g_strsplit(l->data, "=", 2);
+
+		if(parts[0] != NULL && parts[1] != NULL) {
+			gboolean found = FALSE;
+
+			for(gsize i = 0; i < G_N_ELEMENTS(level_names); i++) {
+				if(g_ascii_strcasecmp(parts[1], level_names[i].name) == 0) {
+					g_hash_table_insert(table, g_strdup(parts[0]),
+					                    GINT_TO_POINTER(level_names[i].level));
+					found = TRUE;
+					break;
+				}
+			}
+
+			if(!found) {
+				g_warning("unknown debug level '%s' for category '%s'",
+				          parts[1], parts[0]);
+			}
+		}
+
+		g_strfreev(parts);
+	}
+}
+
+static void
+purple_debug_update_thresholds(void) {
+	GHashTable *table = NULL;
+	GList *entries = NULL;
+	gint level = PURPLE_DEBUG_ALL;
+
+	level = purple_prefs_get_int(PURPLE_DEBUG_PREF_LEVEL);
+	level = CLAMP(level, PURPLE_DEBUG_ALL, PURPLE_DEBUG_FATAL);
+
+	table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	entries = purple_prefs_get_string_list(PURPLE_DEBUG_PREF_CATEGORIES);
+	purple_debug_parse_thresholds(entries, table);
+	g_list_free_full(entries, g_free);
 
+	G_LOCK(categories);
+
+	g_clear_pointer(&thresholds, g_hash_table_destroy);
+	thresholds = table;
+	pref_level = level;
+
+	purple_debug_apply_thresholds_locked();
+
+	G_UNLOCK(categories);
+}
+
+static void
+purple_debug_prefs_changed_cb(G_GNUC_UNUSED const char *name,
+                              G_GNUC_UNUSED PurplePrefType type,
+                              G_GNUC_UNUSED gconstpointer value,
+                              G_GNUC_UNUSED gpointer data)
+{
+	purple_debug_update_thresholds();
+}
+
+/******************************************************************************
+ * Output
+ *****************************************************************************/
+static GLogLevelFlags
+purple_debug_get_log_level(PurpleDebugLevel level) {
 	/* GLib's debug levels are not quite the same as ours, so we need to
 	 * re-assign them. */
 	switch(level) {
 		case PURPLE_DEBUG_MISC:
-			log_level = G_LOG_LEVEL_INFO;
-			break;
+			return G_LOG_LEVEL_INFO;
 		case PURPLE_DEBUG_INFO:
-			log_level = G_LOG_LEVEL_MESSAGE;
-			break;
+			return G_LOG_LEVEL_MESSAGE;
 		case PURPLE_DEBUG_WARNING:
-			log_level = G_LOG_LEVEL_WARNING;
-			break;
+			return G_LOG_LEVEL_WARNING;
 		case PURPLE_DEBUG_ERROR:
-			log_level = G_LOG_LEVEL_CRITICAL;
-			break;
+			return G_LOG_LEVEL_CRITICAL;
 		case PURPLE_DEBUG_FATAL:
-			log_level = G_LOG_LEVEL_ERROR;
-			break;
+			return G_LOG_LEVEL_ERROR;
+		default:
+			return 0;
+	}
+}
+
+/* The syslog priorities that g_log_structured() would use. */
+static const gchar *
+purple_debug_get_priority(GLogLevelFlags log_level) {
+	switch(log_level) {
+		case G_LOG_LEVEL_ERROR:
+			return "3";
+		case G_LOG_LEVEL_CRITICAL:
+			return "4";
+		case G_LOG_LEVEL_WARNING:
+			return "4";
+		case G_LOG_LEVEL_MESSAGE:
+			return "5";
+		case G_LOG_LEVEL_INFO:
+			return "6";
 		default:
-			g_return_if_reached();
+			return "7";
+	}
+}
+
+static void
+purple_debug_vargs(PurpleDebugLevel level, const gchar *category,
+                   const gchar *format, va_list args)
+{
+	GLogLevelFlags log_level = G_LOG_LEVEL_DEBUG;
+	gsize length = 0;
+
+	g_return_if_fail(format != NULL);
+
+	log_level = purple_debug_get_log_level(level);
+	g_return_if_fail(log_level != 0);
+
+	/* Strip trailing linefeeds, but only copy the format when there are
+	 * any. */
+	length = strlen(format);
+	if(length > 0 && g_ascii_isspace(format[length - 1])) {
+		gchar *msg = g_strchomp(g_strdup(format));
+
+		g_logv(category, log_level, msg, args);
+		g_free(msg);
+	} else {
+		g_logv(category, log_level, format, args);
+	}
+}
+
+static void
+purple_debug_vargs_structured(PurpleDebugLevel level, const gchar *category,
+                              const GLogField *fields, gsize n_fields,
+                              const gchar *format, va_list args)
+{
+	GLogLevelFlags log_level = G_LOG_LEVEL_DEBUG;
+	GLogField *all_fields = NULL;
+	gchar *msg = NULL;
+
+	log_level = purple_debug_get_log_level(level);
+	g_return_if_fail(log_level != 0);
+
+	msg = g_strchomp(g_strdup_vprintf(format, args));
+
+	all_fields = g_new(GLogField, n_fields + 3);
+	all_fields[0] = (GLogField){ "MESSAGE", msg, -1 };
+	all_fields[1] = (GLogField){
+		"PRIORITY", purple_debug_get_priority(log_level), -1
+	};
+	all_fields[2] = (GLogField){ "GLIB_DOMAIN", category, -1 };
+	if(n_fields > 0) {
+		memcpy(all_fields + 3, fields, n_fields * sizeof(GLogField));
 	}
 
-	/* strip trailing linefeeds */
-	msg = g_strdup(format);
-	g_strchomp(msg);
+	g_log_structured_array(log_level, all_fields, n_fields + 3);
 
-	g_logv(category, log_level, msg, args);
+	g_free(all_fields);
 	g_free(msg);
 }
 
@@ -79,6 +283,10 @@ purple_debug(PurpleDebugLevel level, const gchar *category,
 	g_return_if_fail(level != PURPLE_DEBUG_ALL);
 	g_return_if_fail(format != NULL);
 
+	if(!purple_debug_is_enabled(level, category)) {
+		return;
+	}
+
 	va_start(args, format);
 	purple_debug_vargs(level, category, format, args);
 	va_end(args);
@@ -90,6 +298,10 @@ purple_debug_misc(const gchar *category, const gchar *format, ...) {
 
 	g_return_if_fail(format != NULL);
 
+	if(!purple_debug_is_enabled(PURPLE_DEBUG_MISC, category)) {
+		return;
+	}
+
 	va_start(args, format);
 	purple_debug_vargs(PURPLE_DEBUG_MISC, category, format, args);
 	va_end(args);
@@ -101,6 +313,10 @@ purple_debug_info(const gchar *category, const gchar *format, ...) {
 
 	g_return_if_fail(format != NULL);
 
+	if(!purple_debug_is_enabled(PURPLE_DEBUG_INFO, category)) {
+		return;
+	}
+
 	va_start(args, format);
 	purple_debug_vargs(PURPLE_DEBUG_INFO, category, format, args);
 	va_end(args);
@@ -112,6 +328,10 @@ purple_debug_warning(const gchar *category, const gchar *format, ...) {
 
 	g_return_if_fail(format != NULL);
 
+	if(!purple_debug_is_enabled(PURPLE_DEBUG_WARNING, category)) {
+		return;
+	}
+
 	va_start(args, format);
 	purple_debug_vargs(PURPLE_DEBUG_WARNING, category, format, args);
 	va_end(args);
@@ -123,6 +343,10 @@ purple_debug_error(const gchar *category, const gchar *format, ...) {
 
 	g_return_if_fail(format != NULL);
 
+	if(!purple_debug_is_enabled(PURPLE_DEBUG_ERROR, category)) {
+		return;
+	}
+
 	va_start(args, format);
 	purple_debug_vargs(PURPLE_DEBUG_ERROR, category, format, args);
 	va_end(args);
@@ -139,6 +363,90 @@ purple_debug_fatal(const gchar *category, const gchar *format, ...) {
 	va_end(args);
 }
 
+gboolean
+purple_debug_category_is_enabled(PurpleDebugCategory *category,
+                                 PurpleDebugLevel level)
+{
+	g_return_val_if_fail(category != NULL, FALSE);
+	g_return_val_if_fail(category->name != NULL, FALSE);
+
+	if(G_UNLIKELY(!category->registered)) {
+		G_LOCK(categories);
+		if(!category->registered) {
+			purple_debug_category_register_locked(category);
+		}
+		G_UNLOCK(categories);
+	}
+
+	return level >= g_atomic_int_get(&category->threshold);
+}
+
+void
+purple_debug_category_log(PurpleDebugCategory *category,
+                          PurpleDebugLevel level, const gchar *format, ...)
+{
+	va_list args;
+
+	g_return_if_fail(level != PURPLE_DEBUG_ALL);
+	g_return_if_fail(format != NULL);
+
+	if(!purple_debug_category_is_enabled(category, level)) {
+		return;
+	}
+
+	va_start(args, format);
+	purple_debug_vargs(level, category->name, format, args);
+	va_end(args);
+}
+
+void
+purple_debug_category_log_structured(PurpleDebugCategory *category,
+                                     PurpleDebugLevel level,
+                                     const GLogField *fields, gsize n_fields,
+                                     const gchar *format, ...)
+{
+	va_list args;
+
+	g_return_if_fail(level != PURPLE_DEBUG_ALL);
+	g_return_if_fail(fields != NULL || n_fields == 0);
+	g_return_if_fail(format != NULL);
+
+	if(!purple_debug_category_is_enabled(category, level)) {
+		return;
+	}
+
+	va_start(args, format);
+	purple_debug_vargs_structured(level, category->name, fields, n_fields,
+	                              format, args);
+	va_end(args);
+}
+
+gboolean
+purple_debug_is_enabled(PurpleDebugLevel level, const gchar *category) {
+	gint threshold = PURPLE_DEBUG_ALL;
+
+	/* Without per-category levels, every category has the same threshold. */
+	if(g_atomic_int_get(&n_thresholds) == 0) {
+		return level >= g_atomic_int_get(&default_threshold);
+	}
+
+	G_LOCK(categories);
+	threshold = purple_debug_get_threshold_locked(category);
+	G_UNLOCK(categories);
+
+	return level >= threshold;
+}
+
+void
+purple_debug_set_minimum_level(PurpleDebugLevel level) {
+	g_return_if_fail(level >= PURPLE_DEBUG_ALL && level <= PURPLE_DEBUG_FATAL);
+
+	G_LOCK(categories);
+	minimum_level = level;
+	purple_debug_apply_thresholds_locked();
+	G_UNLOCK(categories);
+}
+
 gboolean
 purple_debug_is_verbose(void) {
 	return debug_verbose;
@@ -171,4 +479,28 @@ purple_debug_init(void) {
 	}
 
 	purple_prefs_add_none("/purple/debug");
+	purple_prefs_add_int(PURPLE_DEBUG_PREF_LEVEL, PURPLE_DEBUG_ALL);
+	purple_prefs_add_string_list(PURPLE_DEBUG_PREF_CATEGORIES, NULL);
+
+	purple_debug_update_thresholds();
+
+	level_callback_id =
+		purple_prefs_connect_callback(NULL, PURPLE_DEBUG_PREF_LEVEL,
+		                              purple_debug_prefs_changed_cb, NULL);
+	categories_callback_id =
+		purple_prefs_connect_callback(NULL, PURPLE_DEBUG_PREF_CATEGORIES,
+		                              purple_debug_prefs_changed_cb, NULL);
+}
+
+void
+purple_debug_uninit(void) {
+	if(level_callback_id != 0) {
+		purple_prefs_disconnect_callback(level_callback_id);
+		level_callback_id = 0;
+	}
+
+	if(categories_callback_id != 0) {
+		purple_prefs_disconnect_callback(categories_callback_id);
+		categories_callback_id = 0;
+	}
 }
@@ -55,6 +55,96 @@ typedef enum {
 
 } PurpleDebugLevel;
 
+/**
+ * PurpleDebugCategory:
+ * @name: The name of the category, which is used as the log domain.
+ *
+ * A debug category that code can log to.  Each category has a threshold
+ * below which messages are dropped before anything is formatted, so a
+ * category that is turned off costs a single comparison.
+ *
+ * Categories are normally defined statically with
+ * [func@Purple.DEBUG_CATEGORY_DEFINE_STATIC] and logged to with
+ * [func@Purple.DEBUG_CATEGORY_LOG].  They register themselves the first time
+ * they are used.
+ *
+ * The threshold of every category is the value of the `/purple/debug/level`
+ * preference, unless the `/purple/debug/categories` preference has an entry
+ * of the form `name=level` for it, where level is one of `all`, `misc`,
+ * `info`, `warning`, `error` or `fatal`.  Both can be changed at runtime.
+ * On top of that, the UI can drop everything below a level with
+ * purple_debug_set_minimum_level() when nothing would show the messages.
+ * Fatal messages are always output since they abort the program.
+ *
+ * Since: 3.0.0
+ */
+typedef struct _PurpleDebugCategory PurpleDebugCategory;
+
+struct _PurpleDebugCategory {
+	const gchar *name;
+
+	/*< private >*/
+	gint threshold;
+	gboolean registered;
+	PurpleDebugCategory *next;
+};
+
+/**
+ * PURPLE_DEBUG_CATEGORY_INIT:
+ * @name: The name of the category.
+ *
+ * Initializes a [struct@Purple.DebugCategory].  Until it has registered
+ * itself, the category lets everything through to
+ * [func@Purple.debug_category_log] which does the registration.
+ *
+ * Since: 3.0.0
+ */
+#define PURPLE_DEBUG_CATEGORY_INIT(name) { (name), PURPLE_DEBUG_ALL, FALSE, NULL }
+
+/**
+ * PURPLE_DEBUG_CATEGORY_DEFINE_STATIC:
+ * @var: The name of the variable.
+ * @name: The name of the category.
+ *
+ * Defines a static [struct@Purple.DebugCategory] named @var.
+ *
+ * Since: 3.0.0
+ */
+#define PURPLE_DEBUG_CATEGORY_DEFINE_STATIC(var, name) \
+	static PurpleDebugCategory var = PURPLE_DEBUG_CATEGORY_INIT(name)
+
+/**
+ * PURPLE_DEBUG_CATEGORY_ENABLED:
+ * @category: The [struct@Purple.DebugCategory].
+ * @level: The [enum@Purple.DebugLevel].
+ *
+ * Checks whether a message at @level could be output for @category.  Use
+ * this to skip work that is only done to build a debug message.
+ *
+ * Since: 3.0.0
+ */
+#define PURPLE_DEBUG_CATEGORY_ENABLED(category, level) \
+	(G_UNLIKELY((gint)(level) >= (category)->threshold) && \
+	 purple_debug_category_is_enabled((category), (level)))
+
+/**
+ * PURPLE_DEBUG_CATEGORY_LOG:
+ * @category: The [struct@Purple.DebugCategory].
+ * @level: The [enum@Purple.DebugLevel].
+ * @...: The format string followed by its parameters.
+ *
+ * Outputs a message to @category.  The arguments are not evaluated unless
+ * the category is enabled for @level.
+ *
+ * Since: 3.0.0
+ */
+#define PURPLE_DEBUG_CATEGORY_LOG(category, level, ...) \
+	G_STMT_START { \
+		if(PURPLE_DEBUG_CATEGORY_ENABLED((category), (level))) { \
+			purple_debug_category_log((category), (level), __VA_ARGS__); \
+		} \
+	} G_STMT_END
+
 #include "purpledebugui.h"
 
 /**
@@ -143,6 +233,85 @@ void purple_debug_error(const gchar *category, const gchar *format, ...) G_GNUC_
  */
 void purple_debug_fatal(const gchar *category, const gchar *format, ...) G_GNUC_PRINTF(2, 3);
 
+/**
+ * purple_debug_category_is_enabled:
+ * @category: The category.
+ * @level: The debug level.
+ *
+ * Checks whether a message at @level would be output for @category,
+ * registering @category if this is the first time it is used.
+ *
+ * Prefer [func@Purple.DEBUG_CATEGORY_ENABLED] which avoids the call when the
+ * category is turned off.
+ *
+ * Returns: %TRUE if messages at @level are output for @category.
+ *
+ * Since: 3.0.0
+ */
+gboolean purple_debug_category_is_enabled(PurpleDebugCategory *category, PurpleDebugLevel level);
+
+/**
+ * purple_debug_category_log:
+ * @category: The category.
+ * @level: The debug level.
+ * @format: The format string.
+ * @...: The parameters to insert into the format string.
+ *
+ * Outputs debug information to @category.
+ *
+ * Prefer [func@Purple.DEBUG_CATEGORY_LOG] which skips evaluating the
+ * parameters when the category is turned off.
+ *
+ * Since: 3.0.0
+ */
+void purple_debug_category_log(PurpleDebugCategory *category, PurpleDebugLevel level, const gchar *format, ...) G_GNUC_PRINTF(3, 4);
+
+/**
+ * purple_debug_category_log_structured:
+ * @category: The category.
+ * @level: The debug level.
+ * @fields: (array length=n_fields) (nullable): Extra fields to log with the
+ *          message.
+ * @n_fields: The number of elements in @fields.
+ * @format: The format string.
+ * @...: The parameters to insert into the format string.
+ *
+ * Outputs debug information to @category along with @fields, which are
+ * passed on to the log writer as is.  Field names should follow the
+ * conventions of [func@GLib.log_structured], for example `PURPLE_ACCOUNT`.
+ *
+ * Since: 3.0.0
+ */
+void purple_debug_category_log_structured(PurpleDebugCategory *category, PurpleDebugLevel level, const GLogField *fields, gsize n_fields, const gchar *format, ...) G_GNUC_PRINTF(5, 6);
+
+/**
+ * purple_debug_is_enabled:
+ * @level: The debug level.
+ * @category: (nullable): The name of the category.
+ *
+ * Checks whether a message at @level would be output for the category named
+ * @category.  This is what purple_debug() and its wrappers check before
+ * formatting their message.
+ *
+ * Returns: %TRUE if messages at @level are output for @category.
+ *
+ * Since: 3.0.0
+ */
+gboolean purple_debug_is_enabled(PurpleDebugLevel level, const gchar *category);
+
+/**
+ * purple_debug_set_minimum_level:
+ * @level: The lowest level that may be output.
+ *
+ * Drops every message below @level, whatever the debug preferences say.  This
+ * is meant for user interfaces that don't show messages below a certain level
+ * unless, for example, a debug window is open.  Unlike the preferences, it is
+ * not saved.  The default is %PURPLE_DEBUG_ALL.
+ *
+ * Since: 3.0.0
+ */
+void purple_debug_set_minimum_level(PurpleDebugLevel level);
+
 /**
  * purple_debug_set_verbose:
  * @verbose: %TRUE to enable verbose debugging or %FALSE to disable it.
@@ -196,6 +365,15 @@ gboolean purple_debug_is_unsafe(void);
  */
 void purple_debug_init(void);
 
+/**
+ * purple_debug_uninit:
+ *
+ * Uninitializes the debug subsystem.
+ *
+ * Since: 3.0.0
+ */
+void purple_debug_uninit(void);
+
 G_END_DECLS
 
 #endif /* PURPLE_DEBUG_H */
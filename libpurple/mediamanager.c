@@ -104,6 +104,11 @@ typedef struct {
 	GCond readable_cond;
 } PurpleMediaAppDataInfo;
 
+typedef struct {
+	GstBuffer *buffer;
+	GstMapInfo info;
+} PurpleMediaAppDataMapping;
+
 static void purple_media_manager_finalize (GObject *object);
 static void free_appdata_info_locked (PurpleMediaAppDataInfo *info);
 static void purple_media_manager_init_device_monitor(PurpleMediaManager *manager);
@@ -1571,6 +1576,47 @@ purple_media_manager_get_backend_type(PurpleMediaManager *manager)
 	return manager->priv->backend_type;
 }
 
+static void
+app_data_mapping_free(gpointer data)
+{
+	PurpleMediaAppDataMapping *mapping = data;
+
+	gst_buffer_unmap(mapping->buffer, &mapping->info);
+	gst_buffer_unref(mapping->buffer);
+	g_free(mapping);
+}
+
+/* Creates a GBytes that points directly into the mapped memory of @sample's
+ * buffer, starting at @offset. The buffer stays mapped and referenced until
+ * the last reference to the GBytes is dropped. Returns %NULL if there is
+ * nothing left to read. */
+static GBytes *
+app_data_sample_to_bytes(GstSample *sample, gsize offset)
+{
+	PurpleMediaAppDataMapping *mapping = NULL;
+	GstBuffer *buffer = gst_sample_get_buffer(sample);
+
+	if (buffer == NULL) {
+		return NULL;
+	}
+
+	mapping = g_new(PurpleMediaAppDataMapping, 1);
+	mapping->buffer = gst_buffer_ref(buffer);
+	if (!gst_buffer_map(mapping->buffer, &mapping->info, GST_MAP_READ)) {
+		gst_buffer_unref(mapping->buffer);
+		g_free(mapping);
+		return NULL;
+	}
+
+	if (offset >= mapping->info.size) {
+		app_data_mapping_free(mapping);
+		return NULL;
+	}
+
+	return g_bytes_new_with_free_func(mapping->info.data + offset,
+		mapping->info.size - offset, app_data_mapping_free, mapping);
+}
+
 void
 purple_media_manager_set_application_data_callbacks(PurpleMediaManager *manager,
 		PurpleMedia *media, const gchar *session_id,
@@ -1616,12 +1662,40 @@ purple_media_manager_send_application_data (
 	PurpleMediaManager *manager, PurpleMedia *media, const gchar *session_id,
 	const gchar *participant, gpointer buffer, guint size, gboolean blocking)
 {
-	PurpleMediaAppDataInfo * info = get_app_data_info_and_lock (manager,
-		media, session_id, participant);
+	GBytes *bytes = g_bytes_new(buffer, size);
+	gint ret;
+
+	ret = purple_media_manager_send_application_bytes(manager, media,
+		session_id, participant, bytes, blocking);
+	g_bytes_unref(bytes);
+
+	return ret;
+}
+
+gint
+purple_media_manager_send_application_bytes(PurpleMediaManager *manager,
+		PurpleMedia *media, const gchar *session_id,
+		const gchar *participant, GBytes *bytes, gboolean blocking)
+{
+	PurpleMediaAppDataInfo * info = NULL;
+	gconstpointer data = NULL;
+	gsize size = 0;
+
+	g_return_val_if_fail(bytes != NULL, -1);
+
+	data = g_bytes_get_data(bytes, &size);
+	g_return_val_if_fail(size <= G_MAXINT, -1);
+
+	info = get_app_data_info_and_lock(manager, media, session_id,
+		participant);
 
 	if (info && info->appsrc && info->connected) {
-		GstBuffer *gstbuffer = gst_buffer_new_wrapped (g_memdup2(buffer, size),
-			size);
+		/* The buffer borrows the caller's memory and keeps a reference on
+		 * @bytes until GStreamer is done with it, so nothing is copied on
+		 * the way to the network. */
+		GstBuffer *gstbuffer = gst_buffer_new_wrapped_full(
+			GST_MEMORY_FLAG_READONLY, (gpointer)data, size, 0, size,
+			g_bytes_ref(bytes), (GDestroyNotify)g_bytes_unref);
 		GstAppSrc *appsrc = gst_object_ref (info->appsrc);
 
 		g_mutex_unlock (&manager->priv->appdata_mutex);
@@ -1730,6 +1804,59 @@ purple_media_manager_receive_application_data (
 	return -1;
 }
 
+GBytes *
+purple_media_manager_receive_application_bytes(PurpleMediaManager *manager,
+		PurpleMedia *media, const gchar *session_id,
+		const gchar *participant, gboolean blocking)
+{
+	PurpleMediaAppDataInfo * info = get_app_data_info_and_lock (manager,
+		media, session_id, participant);
+	GBytes *bytes = NULL;
+
+	while (info != NULL) {
+		if (!info->current_sample && info->appsink && info->num_samples > 0) {
+			info->current_sample = gst_app_sink_pull_sample (info->appsink);
+			info->sample_offset = 0;
+			if (info->current_sample) {
+				info->num_samples--;
+			}
+		}
+
+		if (info->current_sample) {
+			/* Hand out whatever is left of the current sample, which is all
+			 * of it unless purple_media_manager_receive_application_data()
+			 * already consumed part of it. */
+			bytes = app_data_sample_to_bytes(info->current_sample,
+				info->sample_offset);
+			gst_sample_unref (info->current_sample);
+			info->current_sample = NULL;
+			info->sample_offset = 0;
+
+			if (bytes != NULL) {
+				break;
+			}
+
+			continue;
+		}
+
+		if (!blocking || info->appsink == NULL) {
+			break;
+		}
+
+		g_cond_wait (&info->readable_cond, &manager->priv->appdata_mutex);
+
+		/* We've been signaled, we need to unlock and regrab the info struct
+		 * to make sure nothing changed */
+		g_mutex_unlock (&manager->priv->appdata_mutex);
+		info = get_app_data_info_and_lock (manager, media, session_id,
+			participant);
+	}
+
+	g_mutex_unlock (&manager->priv->appdata_mutex);
+
+	return bytes;
+}
+
 static void
 videosink_disable_last_sample(GstElement *sink)
 {
@@ -352,6 +352,54 @@ gint purple_media_manager_receive_application_data (
 	const gchar *participant, gpointer buffer, guint max_size,
 	gboolean blocking);
 
+/**
+ * purple_media_manager_send_application_bytes:
+ * @manager: The manager to send data with.
+ * @media: The media instance to which the session belongs.
+ * @session_id: The session to send data to.
+ * @participant: The participant to send data to.
+ * @bytes: The data to send.
+ * @blocking: Whether to block until the data was send or not.
+ *
+ * Sends @bytes to a #PURPLE_MEDIA_APPLICATION session without copying it.
+ * A reference to @bytes is held until the data has been sent, so the caller
+ * may drop its own reference as soon as this returns.
+ *
+ * This otherwise behaves like purple_media_manager_send_application_data().
+ *
+ * Returns: Number of bytes sent or -1 in case of error.
+ *
+ * Since: 3.0.0
+ */
+gint purple_media_manager_send_application_bytes(
+	PurpleMediaManager *manager, PurpleMedia *media, const gchar *session_id,
+	const gchar *participant, GBytes *bytes, gboolean blocking);
+
+/**
+ * purple_media_manager_receive_application_bytes:
+ * @manager: The manager to receive data with.
+ * @media: The media instance to which the session belongs.
+ * @session_id: The session to receive data from.
+ * @participant: The participant to receive data from.
+ * @blocking: Whether to block until data is available.
+ *
+ * Receives the next chunk of data from a #PURPLE_MEDIA_APPLICATION session.
+ * The returned #GBytes points directly at the received buffer instead of
+ * copying it, and holds on to that buffer until it is unreferenced.
+ *
+ * Each call returns at most one received buffer. If part of that buffer was
+ * already read with purple_media_manager_receive_application_data(), only
+ * the remainder is returned.
+ *
+ * Returns: (transfer full) (nullable): The received data, or %NULL if there
+ *          is no data available or an error occurred.
+ *
+ * Since: 3.0.0
+ */
+GBytes *purple_media_manager_receive_application_bytes(
+	PurpleMediaManager *manager, PurpleMedia *media, const gchar *session_id,
+	const gchar *participant, gboolean blocking);
+
 /*}@*/
 
 G_END_DECLS
@@ -30,6 +30,7 @@
 #include "purpleconversation.h"
 #include "purpleconversationmanager.h"
 #include "purplecredentialmanager.h"
+#include "purpleprivate.h"
 #include "purpleprotocol.h"
 #include "purpleprotocolmanager.h"
 #include "purpleprotocolmedia.h"
@@ -104,7 +105,7 @@ purple_protocol_got_user_status_with_attributes(PurpleAccount *account,
 
 		purple_status_set_active_with_attributes(status, TRUE, attributes);
 
-		purple_buddy_update_status(buddy, old_status);
+		purple_buddy_presence_queue_update(buddy, old_status);
 	}
 
 	g_slist_free(list);
@@ -161,7 +162,7 @@ void purple_protocol_got_user_status_deactive(PurpleAccount *account, const char
 
 		if (purple_status_is_active(status)) {
 			purple_status_set_active(status, FALSE);
-			purple_buddy_update_status(buddy, status);
+			purple_buddy_presence_queue_update(buddy, status);
 		}
 	}
 
@@ -21,9 +21,12 @@
 #include "purpledemoconnection.h"
 
 #include "purpledemocontacts.h"
+#include "purpledemoload.h"
 
 struct _PurpleDemoConnection {
 	PurpleConnection parent;
+
+	PurpleDemoLoad *load;
 };
 
 G_DEFINE_DYNAMIC_TYPE(PurpleDemoConnection, purple_demo_connection,
@@ -36,19 +39,28 @@ static gboolean
 purple_demo_connection_connect(PurpleConnection *connection,
                                G_GNUC_UNUSED GError **error)
 {
+	PurpleDemoConnection *demo = PURPLE_DEMO_CONNECTION(connection);
 	PurpleAccount *account = purple_connection_get_account(connection);
 
 	purple_connection_set_state(connection, PURPLE_CONNECTION_STATE_CONNECTED);
 
-	purple_demo_contacts_load(account);
+	/* The load generator replaces the static contacts when it's enabled. */
+	demo->load = purple_demo_load_start(connection);
+	if(demo->load == NULL) {
+		purple_demo_contacts_load(account);
+	}
 
 	return TRUE;
 }
 
 static gboolean
-purple_demo_connection_disconnect(G_GNUC_UNUSED PurpleConnection *connection,
+purple_demo_connection_disconnect(PurpleConnection *connection,
                                   G_GNUC_UNUSED GError **error)
 {
+	PurpleDemoConnection *demo = PURPLE_DEMO_CONNECTION(connection);
+
+	g_clear_pointer(&demo->load, purple_demo_load_stop);
+
 	return TRUE;
 }
 
@@ -59,14 +71,26 @@ static void
 purple_demo_connection_init(G_GNUC_UNUSED PurpleDemoConnection *connection) {
 }
 
+static void
+purple_demo_connection_finalize(GObject *obj) {
+	PurpleDemoConnection *demo = PURPLE_DEMO_CONNECTION(obj);
+
+	g_clear_pointer(&demo->load, purple_demo_load_stop);
+
+	G_OBJECT_CLASS(purple_demo_connection_parent_class)->finalize(obj);
+}
+
 static void
 purple_demo_connection_class_finalize(G_GNUC_UNUSED PurpleDemoConnectionClass *klass) {
 }
 
 static void
 purple_demo_connection_class_init(PurpleDemoConnectionClass *klass) {
+	GObjectClass *obj_class = G_OBJECT_CLASS(klass);
 	PurpleConnectionClass *connection_class = PURPLE_CONNECTION_CLASS(klass);
 
+	obj_class->finalize = purple_demo_connection_finalize;
+
 	connection_class->connect = purple_demo_connection_connect;
 	connection_class->disconnect = purple_demo_connection_disconnect;
 }
@@ -0,0 +1,361 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <time.h>
+
+#include <glib/gi18n-lib.h>
+
+#include "purpledemoload.h"
+
+#define PURPLE_DEMO_LOAD_GROUP N_("Load Generator")
+
+/* How often the generator wakes up. Everything that came due since the last
+ * tick is sent in one go, like a server that is writing faster than we read.
+ */
+#define PURPLE_DEMO_LOAD_TICK (10)
+
+#define PURPLE_DEMO_LOAD_NAME_SIZE (16)
+
+struct _PurpleDemoLoad {
+	PurpleConnection *connection;
+	PurpleAccount *account;
+
+	guint n_contacts;
+	guint presence_rate;
+	guint n_chats;
+	guint n_occupants;
+	guint n_ims;
+	guint message_rate;
+	gboolean typing;
+
+	guint tick_id;
+	gint64 started;
+	gint64 last_tick;
+
+	gdouble presence_due;
+	gdouble messages_due;
+	guint64 n_presence;
+	guint64 n_messages;
+};
+
+static const gchar *messages[] = {
+	"hey, are you around?",
+	"did the build finish yet?",
+	"I'll be a few minutes late to the meeting",
+	"<b>heads up:</b> the staging server is going down at noon",
+	"see https://pidgin.im/ for the release notes",
+	"lol",
+};
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static void
+purple_demo_load_contact_name(guint index, gchar name[PURPLE_DEMO_LOAD_NAME_SIZE])
+{
+	g_snprintf(name, PURPLE_DEMO_LOAD_NAME_SIZE, "load-%06u", index);
+}
+
+static gint
+purple_demo_load_get_count(PurpleAccount *account, const gchar *name,
+                           gint default_value)
+{
+	return MAX(purple_account_get_int(account, name, default_value), 0);
+}
+
+static void
+purple_demo_load_add_contacts(PurpleDemoLoad *load) {
+	PurpleAccount *account = purple_connection_get_account(load->connection);
+	PurpleGroup *group = NULL;
+
+	group = purple_blist_find_group(_(PURPLE_DEMO_LOAD_GROUP));
+	if(group == NULL) {
+		group = purple_group_new(_(PURPLE_DEMO_LOAD_GROUP));
+		purple_blist_add_group(group, NULL);
+	}
+
+	for(guint i = 0; i < load->n_contacts; i++) {
+		gchar name[PURPLE_DEMO_LOAD_NAME_SIZE];
+
+		purple_demo_load_contact_name(i, name);
+
+		if(purple_blist_find_buddy(account, name) == NULL) {
+			PurpleBuddy *buddy = purple_buddy_new(account, name, NULL);
+
+			purple_blist_add_buddy(buddy, NULL, group, NULL);
+		}
+
+		purple_protocol_got_user_status(account, name, "available", NULL);
+	}
+}
+
+/* The contacts only exist for the run, so they don't pile up in the saved
+ * buddy list.
+ */
+static void
+purple_demo_load_remove_contacts(PurpleDemoLoad *load) {
+	PurpleGroup *group = NULL;
+
+	/* We might be stopped after the buddy list has been shut down. */
+	if(purple_blist_get_default() == NULL) {
+		return;
+	}
+
+	for(guint i = 0; i < load->n_contacts; i++) {
+		PurpleBuddy *buddy = NULL;
+		gchar name[PURPLE_DEMO_LOAD_NAME_SIZE];
+
+		purple_demo_load_contact_name(i, name);
+
+		buddy = purple_blist_find_buddy(load->account, name);
+		if(buddy != NULL) {
+			purple_blist_remove_buddy(buddy);
+		}
+	}
+
+	/* This leaves the group alone if anything else was put in it. */
+	group = purple_blist_find_group(_(PURPLE_DEMO_LOAD_GROUP));
+	if(group != NULL) {
+		purple_blist_remove_group(group);
+	}
+}
+
+static void
+purple_demo_load_join_chats(PurpleDemoLoad *load) {
+	GList *users = NULL, *flags = NULL;
+
+	for(guint i = 0; i < load->n_occupants; i++) {
+		gchar name[PURPLE_DEMO_LOAD_NAME_SIZE];
+
+		purple_demo_load_contact_name(i, name);
+
+		users = g_list_prepend(users, g_strdup(name));
+		flags = g_list_prepend(flags, GINT_TO_POINTER(PURPLE_CHAT_USER_NONE));
+	}
+
+	for(guint i = 0; i < load->n_chats; i++) {
+		PurpleConversation *chat = NULL;
+		gchar *name = g_strdup_printf("load-chat-%03u", i);
+
+		/* Chat ids start at 1 so we never hand out 0. */
+		chat = purple_serv_got_joined_chat(load->connection, i + 1, name);
+		if(PURPLE_IS_CHAT_CONVERSATION(chat)) {
+			purple_chat_conversation_add_users(PURPLE_CHAT_CONVERSATION(chat),
+			                                   users, NULL, flags, FALSE);
+		}
+
+		g_free(name);
+	}
+
+	g_list_free_full(users, g_free);
+	g_list_free(flags);
+}
+
+/* Flips the next contact between available and away, so that every update is
+ * a real change.
+ */
+static void
+purple_demo_load_send_presence(PurpleDemoLoad *load) {
+	PurpleAccount *account = purple_connection_get_account(load->connection);
+	gchar name[PURPLE_DEMO_LOAD_NAME_SIZE];
+	guint index = load->n_presence % load->n_contacts;
+	guint round = load->n_presence / load->n_contacts;
+	const gchar *status_id = ((index + round) % 2) ? "available" : "away";
+
+	purple_demo_load_contact_name(index, name);
+	purple_protocol_got_user_status(account, name, status_id, NULL);
+
+	load->n_presence++;
+}
+
+static void
+purple_demo_load_send_message(PurpleDemoLoad *load) {
+	gchar name[PURPLE_DEMO_LOAD_NAME_SIZE];
+	guint conversations = load->n_chats + load->n_ims;
+	guint index = load->n_messages % conversations;
+	guint round = load->n_messages / conversations;
+	const gchar *contents = messages[load->n_messages % G_N_ELEMENTS(messages)];
+
+	if(index < load->n_chats) {
+		/* Rotate through the occupants so every chat hears from everyone. */
+		purple_demo_load_contact_name(round % MAX(load->n_occupants, 1), name);
+		purple_serv_got_chat_in(load->connection, index + 1, name,
+		                        PURPLE_MESSAGE_RECV, contents, time(NULL));
+	} else {
+		purple_demo_load_contact_name(index - load->n_chats, name);
+		purple_serv_got_im(load->connection, name, contents,
+		                   PURPLE_MESSAGE_RECV, time(NULL));
+
+		/* And they're already typing the next one. */
+		if(load->typing) {
+			purple_serv_got_typing(load->connection, name, 0,
+			                       PURPLE_IM_TYPING);
+		}
+	}
+
+	load->n_messages++;
+}
+
+/******************************************************************************
+ * Callbacks
+ *****************************************************************************/
+static gboolean
+purple_demo_load_tick_cb(gpointer data) {
+	PurpleDemoLoad *load = data;
+	gint64 now = g_get_monotonic_time();
+	gdouble elapsed = (gdouble)(now - load->last_tick) / G_USEC_PER_SEC;
+
+	load->last_tick = now;
+
+	if(load->n_contacts > 0) {
+		load->presence_due += load->presence_rate * elapsed;
+		while(load->presence_due >= 1.0) {
+			purple_demo_load_send_presence(load);
+			load->presence_due -= 1.0;
+		}
+	}
+
+	if(load->n_chats + load->n_ims > 0) {
+		load->messages_due += (gdouble)load->message_rate *
+		                      (load->n_chats + load->n_ims) * elapsed;
+		while(load->messages_due >= 1.0) {
+			purple_demo_load_send_message(load);
+			load->messages_due -= 1.0;
+		}
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+/******************************************************************************
+ * Internal API
+ *****************************************************************************/
+GList *
+purple_demo_load_get_account_options(void) {
+	PurpleAccountOption *option = NULL;
+	GList *options = NULL;
+
+	option = purple_account_option_int_new(_("Load generator contacts "
+	                                         "(0 to disable)"),
+	                                       PURPLE_DEMO_LOAD_CONTACTS, 0);
+	options = g_list_append(options, option);
+
+	option = purple_account_option_int_new(_("Presence updates per second"),
+	                                       PURPLE_DEMO_LOAD_PRESENCE_RATE,
+	                                       100);
+	options = g_list_append(options, option);
+
+	option = purple_account_option_int_new(_("Chats"), PURPLE_DEMO_LOAD_CHATS,
+	                                       0);
+	options = g_list_append(options, option);
+
+	option = purple_account_option_int_new(_("Occupants per chat"),
+	                                       PURPLE_DEMO_LOAD_CHAT_OCCUPANTS, 50);
+	options = g_list_append(options, option);
+
+	option = purple_account_option_int_new(_("Instant message conversations"),
+	                                       PURPLE_DEMO_LOAD_IMS, 0);
+	options = g_list_append(options, option);
+
+	option = purple_account_option_int_new(_("Messages per second per "
+	                                         "conversation"),
+	                                       PURPLE_DEMO_LOAD_MESSAGE_RATE, 1);
+	options = g_list_append(options, option);
+
+	option = purple_account_option_bool_new(_("Send typing notifications"),
+	                                        PURPLE_DEMO_LOAD_TYPING, TRUE);
+	options = g_list_append(options, option);
+
+	return options;
+}
+
+PurpleDemoLoad *
+purple_demo_load_start(PurpleConnection *connection) {
+	PurpleAccount *account = NULL;
+	PurpleDemoLoad *load = NULL;
+	guint n_contacts = 0;
+
+	g_return_val_if_fail(PURPLE_IS_CONNECTION(connection), NULL);
+
+	account = purple_connection_get_account(connection);
+
+	n_contacts = purple_demo_load_get_count(account,
+	                                        PURPLE_DEMO_LOAD_CONTACTS, 0);
+	if(n_contacts == 0) {
+		return NULL;
+	}
+
+	load = g_new0(PurpleDemoLoad, 1);
+	load->connection = connection;
+	load->account = g_object_ref(account);
+	load->n_contacts = n_contacts;
+	load->presence_rate = purple_demo_load_get_count(account,
+	                                                 PURPLE_DEMO_LOAD_PRESENCE_RATE,
+	                                                 100);
+	load->n_chats = purple_demo_load_get_count(account, PURPLE_DEMO_LOAD_CHATS,
+	                                           0);
+	load->n_occupants = purple_demo_load_get_count(account,
+	                                               PURPLE_DEMO_LOAD_CHAT_OCCUPANTS,
+	                                               50);
+	/* We only have so many contacts to talk to. */
+	load->n_ims = MIN((guint)purple_demo_load_get_count(account,
+	                                                    PURPLE_DEMO_LOAD_IMS,
+	                                                    0),
+	                  n_contacts);
+	load->message_rate = purple_demo_load_get_count(account,
+	                                                PURPLE_DEMO_LOAD_MESSAGE_RATE,
+	                                                1);
+	load->typing = purple_account_get_bool(account, PURPLE_DEMO_LOAD_TYPING,
+	                                       TRUE);
+
+	purple_demo_load_add_contacts(load);
+	purple_demo_load_join_chats(load);
+
+	load->started = load->last_tick = g_get_monotonic_time();
+	load->tick_id = g_timeout_add(PURPLE_DEMO_LOAD_TICK,
+	                              purple_demo_load_tick_cb, load);
+
+	g_message("Load generator: %u contacts at %u presence updates/s, %u chats "
+	          "with %u occupants, %u IMs at %u messages/s each",
+	          load->n_contacts, load->presence_rate, load->n_chats,
+	          load->n_occupants, load->n_ims, load->message_rate);
+
+	return load;
+}
+
+void
+purple_demo_load_stop(PurpleDemoLoad *load) {
+	gdouble elapsed = 0.0;
+
+	if(load == NULL) {
+		return;
+	}
+
+	g_clear_handle_id(&load->tick_id, g_source_remove);
+
+	elapsed = (gdouble)(g_get_monotonic_time() - load->started) /
+	          G_USEC_PER_SEC;
+	g_message("Load generator: sent %" G_GUINT64_FORMAT " presence updates "
+	          "and %" G_GUINT64_FORMAT " messages in %.1fs",
+	          load->n_presence, load->n_messages, elapsed);
+
+	purple_demo_load_remove_contacts(load);
+
+	g_clear_object(&load->account);
+	g_free(load);
+}
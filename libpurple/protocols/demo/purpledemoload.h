@@ -0,0 +1,49 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURPLE_DEMO_LOAD_H
+#define PURPLE_DEMO_LOAD_H
+
+#include <glib.h>
+
+#include <purple.h>
+
+G_BEGIN_DECLS
+
+/* The account settings that configure the load generator. Setting
+ * PURPLE_DEMO_LOAD_CONTACTS to anything other than 0 turns it on in place of
+ * the static contact list.
+ */
+#define PURPLE_DEMO_LOAD_CONTACTS "load-contacts"
+#define PURPLE_DEMO_LOAD_PRESENCE_RATE "load-presence-rate"
+#define PURPLE_DEMO_LOAD_CHATS "load-chats"
+#define PURPLE_DEMO_LOAD_CHAT_OCCUPANTS "load-chat-occupants"
+#define PURPLE_DEMO_LOAD_IMS "load-ims"
+#define PURPLE_DEMO_LOAD_MESSAGE_RATE "load-message-rate"
+#define PURPLE_DEMO_LOAD_TYPING "load-typing"
+
+typedef struct _PurpleDemoLoad PurpleDemoLoad;
+
+G_GNUC_INTERNAL GList *purple_demo_load_get_account_options(void);
+
+G_GNUC_INTERNAL PurpleDemoLoad *purple_demo_load_start(PurpleConnection *connection);
+G_GNUC_INTERNAL void purple_demo_load_stop(PurpleDemoLoad *load);
+
+G_END_DECLS
+
+#endif /* PURPLE_DEMO_LOAD_H */
@@ -23,6 +23,7 @@
 #include "purpledemoprotocol.h"
 
 #include "purpledemoconnection.h"
+#include "purpledemoload.h"
 #include "purpledemoprotocolactions.h"
 #include "purpledemoprotocolclient.h"
 #include "purpledemoprotocolim.h"
@@ -53,6 +54,12 @@ purple_demo_protocol_create_connection(PurpleProtocol *protocol,
 
 }
 
+static GList *
+purple_demo_protocol_get_account_options(G_GNUC_UNUSED PurpleProtocol *protocol)
+{
+	return purple_demo_load_get_account_options();
+}
+
 static GList *
 purple_demo_protocol_status_types(G_GNUC_UNUSED PurpleProtocol *protocol,
                                   G_GNUC_UNUSED PurpleAccount *account)
@@ -118,6 +125,7 @@ static void
 purple_demo_protocol_class_init(PurpleDemoProtocolClass *klass) {
 	PurpleProtocolClass *protocol_class = PURPLE_PROTOCOL_CLASS(klass);
 
+	protocol_class->get_account_options = purple_demo_protocol_get_account_options;
 	protocol_class->status_types = purple_demo_protocol_status_types;
 	protocol_class->create_connection = purple_demo_protocol_create_connection;
 }
@@ -0,0 +1,302 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Signs on a demo account with the load generator turned on, lets it run
+ * against a headless libpurple for a while, and reports how much libpurple
+ * took in, how much memory that took, and how long the main loop was kept
+ * from running other work.
+ */
+
+#include <glib.h>
+
+#ifdef G_OS_UNIX
+# include <sys/resource.h>
+#endif
+
+#include <purple.h>
+
+#include "bench_latency.h"
+#include "test_ui.h"
+
+#define DEFAULT_DURATION (10)
+
+/* The main loop is probed this often. A probe that runs late means something
+ * else was hogging the loop.
+ */
+#define PROBE_INTERVAL (5)
+
+static gint duration = DEFAULT_DURATION;
+static gint contacts = 5000;
+static gint presence_rate = 2000;
+static gint chats = 20;
+static gint occupants = 200;
+static gint ims = 50;
+static gint message_rate = 5;
+
+static GOptionEntry entries[] = {
+	{
+		"duration", 'd', 0, G_OPTION_ARG_INT, &duration,
+		"How long to run the load for in seconds", "SECONDS"
+	}, {
+		"contacts", 'c', 0, G_OPTION_ARG_INT, &contacts,
+		"Number of contacts", "N"
+	}, {
+		"presence-rate", 'p', 0, G_OPTION_ARG_INT, &presence_rate,
+		"Presence updates per second", "N"
+	}, {
+		"chats", 0, 0, G_OPTION_ARG_INT, &chats,
+		"Number of chats", "N"
+	}, {
+		"occupants", 0, 0, G_OPTION_ARG_INT, &occupants,
+		"Occupants per chat", "N"
+	}, {
+		"ims", 0, 0, G_OPTION_ARG_INT, &ims,
+		"Number of instant message conversations", "N"
+	}, {
+		"message-rate", 'm', 0, G_OPTION_ARG_INT, &message_rate,
+		"Messages per second per conversation", "N"
+	},
+	G_OPTION_ENTRY_NULL
+};
+
+typedef struct {
+	GMainLoop *loop;
+
+	gboolean running;
+	gint64 started;
+	gint64 elapsed;
+
+	guint64 messages;
+	guint64 presence_updates;
+
+	gint64 probe_due;
+	GArray *latencies;
+} BenchData;
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static glong
+peak_rss(void) {
+#ifdef G_OS_UNIX
+	struct rusage usage;
+
+	if(getrusage(RUSAGE_SELF, &usage) == 0) {
+		/* kilobytes on Linux */
+		return usage.ru_maxrss;
+	}
+#endif
+
+	return -1;
+}
+
+static void
+report(BenchData *data) {
+	gdouble seconds = (gdouble)data->elapsed / G_USEC_PER_SEC;
+	glong rss = peak_rss();
+
+	bench_latency_sort(data->latencies);
+
+	g_print("duration            %10.1f s\n", seconds);
+	g_print("messages            %10.0f /s\n", data->messages / seconds);
+	g_print("presence updates    %10.0f /s\n",
+	        data->presence_updates / seconds);
+	if(rss >= 0) {
+		g_print("peak rss            %10.1f MiB\n", rss / 1024.0);
+	}
+	g_print("main loop latency   p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, "
+	        "max %.2f ms\n",
+	        bench_latency_percentile(data->latencies, 50),
+	        bench_latency_percentile(data->latencies, 90),
+	        bench_latency_percentile(data->latencies, 99),
+	        bench_latency_percentile(data->latencies, 100));
+}
+
+/******************************************************************************
+ * Callbacks
+ *****************************************************************************/
+static void
+received_im_msg_cb(G_GNUC_UNUSED PurpleAccount *account,
+                   G_GNUC_UNUSED const gchar *sender,
+                   G_GNUC_UNUSED const gchar *message,
+                   G_GNUC_UNUSED PurpleConversation *conv,
+                   G_GNUC_UNUSED PurpleMessageFlags flags, gpointer user_data)
+{
+	BenchData *data = user_data;
+
+	if(data->running) {
+		data->messages++;
+	}
+}
+
+static void
+received_chat_msg_cb(G_GNUC_UNUSED PurpleAccount *account,
+                     G_GNUC_UNUSED const gchar *sender,
+                     G_GNUC_UNUSED const gchar *message,
+                     G_GNUC_UNUSED PurpleConversation *chat,
+                     G_GNUC_UNUSED PurpleMessageFlags flags, gpointer user_data)
+{
+	BenchData *data = user_data;
+
+	if(data->running) {
+		data->messages++;
+	}
+}
+
+static void
+buddy_status_changed_cb(G_GNUC_UNUSED PurpleBuddy *buddy,
+                        G_GNUC_UNUSED PurpleStatus *old_status,
+                        G_GNUC_UNUSED PurpleStatus *new_status,
+                        gpointer user_data)
+{
+	BenchData *data = user_data;
+
+	if(data->running) {
+		data->presence_updates++;
+	}
+}
+
+static gboolean
+probe_cb(gpointer user_data) {
+	BenchData *data = user_data;
+	gint64 now = g_get_monotonic_time();
+	gint64 latency = MAX(now - data->probe_due, 0);
+
+	g_array_append_val(data->latencies, latency);
+	data->probe_due = now + PROBE_INTERVAL * 1000;
+
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+stop_cb(gpointer user_data) {
+	BenchData *data = user_data;
+
+	data->running = FALSE;
+	data->elapsed = g_get_monotonic_time() - data->started;
+
+	g_main_loop_quit(data->loop);
+
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+start_cb(gpointer user_data) {
+	BenchData *data = user_data;
+
+	data->running = TRUE;
+	data->started = g_get_monotonic_time();
+	data->probe_due = data->started + PROBE_INTERVAL * 1000;
+
+	g_timeout_add(PROBE_INTERVAL, probe_cb, data);
+	g_timeout_add_seconds(duration, stop_cb, data);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+signed_on_cb(G_GNUC_UNUSED PurpleConnection *connection, gpointer user_data) {
+	/* The demo protocol signs on before it creates the contacts and joins
+	 * the chats, and that setup is the same every run, so the window starts
+	 * once connecting has returned.  This has to be at the priority of the
+	 * generator's tick, or a saturated main loop would never get to it.
+	 */
+	g_idle_add_full(G_PRIORITY_DEFAULT, start_cb, user_data, NULL);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+gint
+main(gint argc, gchar *argv[]) {
+	GOptionContext *context = NULL;
+	GError *error = NULL;
+	PurpleAccountManager *account_manager = NULL;
+	PurpleProtocolManager *protocol_manager = NULL;
+	PurpleAccount *account = NULL;
+	BenchData data = {
+		.loop = NULL,
+	};
+	static int handle;
+
+	context = g_option_context_new(NULL);
+	g_option_context_add_main_entries(context, entries, NULL);
+	if(!g_option_context_parse(context, &argc, &argv, &error)) {
+		g_printerr("%s\n", error->message);
+		g_clear_error(&error);
+		g_option_context_free(context);
+
+		return 1;
+	}
+	g_option_context_free(context);
+
+	test_ui_purple_init();
+
+	/* The demo protocol is a plugin; PURPLE_PLUGIN_PATH points at it. */
+	purple_plugins_refresh();
+
+	protocol_manager = purple_protocol_manager_get_default();
+	if(purple_protocol_manager_find(protocol_manager, "prpl-demo") == NULL) {
+		g_printerr("the demo protocol plugin could not be loaded\n");
+
+		return 1;
+	}
+
+	data.loop = g_main_loop_new(NULL, FALSE);
+	data.latencies = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+	purple_signal_connect(purple_conversations_get_handle(), "received-im-msg",
+	                      &handle, G_CALLBACK(received_im_msg_cb), &data);
+	purple_signal_connect(purple_conversations_get_handle(),
+	                      "received-chat-msg", &handle,
+	                      G_CALLBACK(received_chat_msg_cb), &data);
+	purple_signal_connect(purple_blist_get_handle(), "buddy-status-changed",
+	                      &handle, G_CALLBACK(buddy_status_changed_cb),
+	                      &data);
+	purple_signal_connect(purple_connections_get_handle(), "signed-on",
+	                      &handle, G_CALLBACK(signed_on_cb), &data);
+
+	account = purple_account_new("bench", "prpl-demo");
+	purple_account_set_int(account, "load-contacts", contacts);
+	purple_account_set_int(account, "load-presence-rate", presence_rate);
+	purple_account_set_int(account, "load-chats", chats);
+	purple_account_set_int(account, "load-chat-occupants", occupants);
+	purple_account_set_int(account, "load-ims", ims);
+	purple_account_set_int(account, "load-message-rate", message_rate);
+	purple_account_set_bool(account, "load-typing", TRUE);
+
+	account_manager = purple_account_manager_get_default();
+	purple_account_manager_add(account_manager, account);
+
+	purple_account_set_enabled(account, TRUE);
+	if(purple_account_is_disconnected(account)) {
+		purple_account_connect(account);
+	}
+
+	g_main_loop_run(data.loop);
+
+	report(&data);
+
+	purple_signals_disconnect_by_handle(&handle);
+	purple_account_set_enabled(account, FALSE);
+
+	g_array_free(data.latencies, TRUE);
+	g_main_loop_unref(data.loop);
+
+	return 0;
+}
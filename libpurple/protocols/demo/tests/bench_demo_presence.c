@@ -0,0 +1,209 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Signs on a demo account whose load generator only creates the contacts,
+ * then replays bursts of presence updates for all of them like the one
+ * received when signing on to an account with a large roster. It reports how
+ * long libpurple took to take each burst in and to apply it to the buddy
+ * list.
+ *
+ * The contacts are removed again when the account goes offline, and the
+ * buddy list is saved under the build directory rather than the user's.
+ */
+
+#include <glib.h>
+
+#include <purple.h>
+
+#include "test_ui.h"
+
+static gint contacts = 10000;
+static gint rounds = 10;
+
+static GOptionEntry entries[] = {
+	{
+		"contacts", 'c', 0, G_OPTION_ARG_INT, &contacts,
+		"Number of contacts in each burst", "N"
+	}, {
+		"rounds", 'r', 0, G_OPTION_ARG_INT, &rounds,
+		"Number of bursts to replay", "N"
+	},
+	G_OPTION_ENTRY_NULL
+};
+
+typedef struct {
+	GMainLoop *loop;
+	PurpleAccount *account;
+
+	guint batches;
+	guint64 batched;
+} BenchData;
+
+/******************************************************************************
+ * Callbacks
+ *****************************************************************************/
+static void
+buddies_status_changed_cb(GList *buddies, gpointer user_data) {
+	BenchData *data = user_data;
+
+	data->batches++;
+	data->batched += g_list_length(buddies);
+}
+
+static gboolean
+run_cb(gpointer user_data) {
+	BenchData *data = user_data;
+	GSList *buddies = NULL;
+	GTimer *timer = NULL;
+	gdouble total_replay = 0.0, total_apply = 0.0;
+	guint n_buddies = 0;
+
+	/* Signing on queued an update for every contact, that isn't part of the
+	 * bursts.
+	 */
+	purple_buddy_presence_flush_updates();
+	data->batches = 0;
+	data->batched = 0;
+
+	buddies = purple_blist_find_buddies(data->account, NULL);
+	n_buddies = g_slist_length(buddies);
+
+	g_print("round       received         applied\n");
+
+	timer = g_timer_new();
+	for(gint round = 0; round < rounds; round++) {
+		/* The contacts start out available, so flipping all of them on every
+		 * round makes every update a real change.
+		 */
+		const gchar *status_id = (round % 2) ? "available" : "away";
+		gdouble replay = 0.0, apply = 0.0;
+
+		g_timer_start(timer);
+		for(GSList *l = buddies; l != NULL; l = l->next) {
+			purple_protocol_got_user_status(data->account,
+			                                purple_buddy_get_name(l->data),
+			                                status_id, NULL);
+		}
+		replay = g_timer_elapsed(timer, NULL);
+
+		g_timer_start(timer);
+		purple_buddy_presence_flush_updates();
+		apply = g_timer_elapsed(timer, NULL);
+
+		g_print("%5d  %10.2f ms   %10.2f ms\n", round, replay * 1000.0,
+		        apply * 1000.0);
+
+		total_replay += replay;
+		total_apply += apply;
+	}
+	g_timer_destroy(timer);
+
+	g_slist_free(buddies);
+
+	if(rounds > 0) {
+		g_print("mean   %10.2f ms   %10.2f ms\n",
+		        total_replay * 1000.0 / rounds,
+		        total_apply * 1000.0 / rounds);
+		g_print("%u updates per burst, %" G_GUINT64_FORMAT " applied in %u "
+		        "batches\n", n_buddies, data->batched, data->batches);
+	}
+
+	g_main_loop_quit(data->loop);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+signed_on_cb(G_GNUC_UNUSED PurpleConnection *connection, gpointer user_data) {
+	/* The load generator adds the contacts once connecting has returned. */
+	g_idle_add(run_cb, user_data);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+gint
+main(gint argc, gchar *argv[]) {
+	GOptionContext *context = NULL;
+	GError *error = NULL;
+	PurpleAccountManager *account_manager = NULL;
+	PurpleProtocolManager *protocol_manager = NULL;
+	BenchData data = {
+		.loop = NULL,
+	};
+	static int handle;
+
+	context = g_option_context_new(NULL);
+	g_option_context_add_main_entries(context, entries, NULL);
+	if(!g_option_context_parse(context, &argc, &argv, &error)) {
+		g_printerr("%s\n", error->message);
+		g_clear_error(&error);
+		g_option_context_free(context);
+
+		return 1;
+	}
+	g_option_context_free(context);
+
+	test_ui_purple_init();
+
+	/* The demo protocol is a plugin; PURPLE_PLUGIN_PATH points at it. */
+	purple_plugins_refresh();
+
+	protocol_manager = purple_protocol_manager_get_default();
+	if(purple_protocol_manager_find(protocol_manager, "prpl-demo") == NULL) {
+		g_printerr("the demo protocol plugin could not be loaded\n");
+
+		return 1;
+	}
+
+	data.loop = g_main_loop_new(NULL, FALSE);
+
+	purple_signal_connect(purple_blist_get_handle(), "buddies-status-changed",
+	                      &handle, G_CALLBACK(buddies_status_changed_cb),
+	                      &data);
+	purple_signal_connect(purple_connections_get_handle(), "signed-on",
+	                      &handle, G_CALLBACK(signed_on_cb), &data);
+
+	/* Only the contacts, the bursts are replayed by hand. */
+	data.account = purple_account_new("bench", "prpl-demo");
+	purple_account_set_int(data.account, "load-contacts", contacts);
+	purple_account_set_int(data.account, "load-presence-rate", 0);
+	purple_account_set_int(data.account, "load-chats", 0);
+	purple_account_set_int(data.account, "load-ims", 0);
+	purple_account_set_int(data.account, "load-message-rate", 0);
+	purple_account_set_bool(data.account, "load-typing", FALSE);
+
+	account_manager = purple_account_manager_get_default();
+	purple_account_manager_add(account_manager, data.account);
+
+	purple_account_set_enabled(data.account, TRUE);
+	if(purple_account_is_disconnected(data.account)) {
+		purple_account_connect(data.account);
+	}
+
+	g_main_loop_run(data.loop);
+
+	purple_signals_disconnect_by_handle(&handle);
+
+	/* This removes the contacts again. */
+	purple_account_set_enabled(data.account, FALSE);
+
+	g_main_loop_unref(data.loop);
+
+	return 0;
+}
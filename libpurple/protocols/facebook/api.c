@@ -34,6 +34,9 @@
 #include "thrift.h"
 #include "util.h"
 
+/* Inflate buffers grown past this by a large publish are not kept around. */
+#define FB_API_INFLATED_MAX (256 * 1024)
+
 enum
 {
 	PROP_0,
@@ -58,6 +61,7 @@ struct _FbApi {
 
 	FbMqtt *mqtt;
 	SoupSession *cons;
+	GCancellable *cancellable;
 	PurpleConnection *gc;
 	gboolean retrying;
 
@@ -74,6 +78,10 @@ struct _FbApi {
 	guint unread;
 	FbId lastmid;
 	gchar *contacts_delta;
+
+	/* Reused for every compressed publish on the connection. */
+	GConverter *inflater;
+	GByteArray *inflated;
 };
 
 static void fb_api_error_literal(FbApi *api, FbApiError error,
@@ -169,13 +177,16 @@ fb_api_dispose(GObject *obj)
 {
 	FbApi *api = FB_API(obj);
 
-	if(api->cons != NULL) {
-		soup_session_abort(api->cons);
+	/* The session is shared with other accounts, so only cancel our own
+	 * requests. */
+	if(api->cancellable != NULL) {
+		g_cancellable_cancel(api->cancellable);
 	}
 
 	g_clear_object(&api->mqtt);
 
 	g_clear_object(&api->cons);
+	g_clear_object(&api->cancellable);
 	if(api->msgs != NULL) {
 		g_queue_free_full(api->msgs, (GDestroyNotify)fb_api_message_free);
 		api->msgs = NULL;
@@ -186,6 +197,12 @@ fb_api_dispose(GObject *obj)
 	g_clear_pointer(&api->stoken, g_free);
 	g_clear_pointer(&api->token, g_free);
 	g_clear_pointer(&api->contacts_delta, g_free);
+
+	g_clear_object(&api->inflater);
+	if(api->inflated != NULL) {
+		g_byte_array_free(api->inflated, TRUE);
+		api->inflated = NULL;
+	}
 }
 
 static void
@@ -730,9 +747,12 @@ fb_api_http_req(FbApi *api, const gchar *url, const gchar *name,
 		g_free(data);
 	}
 
+	soup_message_headers_replace(soup_message_get_request_headers(msg),
+	                             "User-Agent", FB_API_AGENT);
+
 	g_object_set_data(G_OBJECT(msg), "facebook-api", api);
-	soup_session_send_and_read_async(api->cons, msg, G_PRIORITY_DEFAULT, NULL,
-	                                 callback, msg);
+	soup_session_send_and_read_async(api->cons, msg, G_PRIORITY_DEFAULT,
+	                                 api->cancellable, callback, msg);
 
 	fb_util_debug(FB_UTIL_DEBUG_INFO, "HTTP Request (%p):", msg);
 	fb_util_debug(FB_UTIL_DEBUG_INFO, "  Request URL: %s", url);
@@ -1068,13 +1088,14 @@ fb_api_cb_mqtt_connect(FbMqtt *mqtt, gpointer data)
 }
 
 static void
-fb_api_cb_publish_mark(FbApi *api, GByteArray *pload)
+fb_api_cb_publish_mark(FbApi *api, GBytes *pload)
 {
 	FbJsonValues *values;
 	GError *err = NULL;
 	JsonNode *root;
 
-	if (!fb_api_json_chk(api, pload->data, pload->len, &root)) {
+	if (!fb_api_json_chk(api, g_bytes_get_data(pload, NULL),
+	                     g_bytes_get_size(pload), &root)) {
 		return;
 	}
 
@@ -1182,7 +1203,7 @@ fb_api_event_parse(G_GNUC_UNUSED FbApi *api, FbApiEvent *event, GSList *events,
 }
 
 static void
-fb_api_cb_publish_mercury(FbApi *api, GByteArray *pload)
+fb_api_cb_publish_mercury(FbApi *api, GBytes *pload)
 {
 	const gchar *str;
 	FbApiEvent event;
@@ -1192,7 +1213,8 @@ fb_api_cb_publish_mercury(FbApi *api, GByteArray *pload)
 	JsonNode *root;
 	JsonNode *node;
 
-	if (!fb_api_json_chk(api, pload->data, pload->len, &root)) {
+	if (!fb_api_json_chk(api, g_bytes_get_data(pload, NULL),
+	                     g_bytes_get_size(pload), &root)) {
 		return;
 	}
 
@@ -1223,7 +1245,7 @@ fb_api_cb_publish_mercury(FbApi *api, GByteArray *pload)
 }
 
 static void
-fb_api_cb_publish_typing(FbApi *api, GByteArray *pload)
+fb_api_cb_publish_typing(FbApi *api, GBytes *pload)
 {
 	const gchar *str;
 	FbApiTyping typg;
@@ -1231,7 +1253,8 @@ fb_api_cb_publish_typing(FbApi *api, GByteArray *pload)
 	GError *err = NULL;
 	JsonNode *root;
 
-	if (!fb_api_json_chk(api, pload->data, pload->len, &root)) {
+	if (!fb_api_json_chk(api, g_bytes_get_data(pload, NULL),
+	                     g_bytes_get_size(pload), &root)) {
 		return;
 	}
 
@@ -1263,14 +1286,15 @@ fb_api_cb_publish_typing(FbApi *api, GByteArray *pload)
 }
 
 static void
-fb_api_cb_publish_ms_r(FbApi *api, GByteArray *pload)
+fb_api_cb_publish_ms_r(FbApi *api, GBytes *pload)
 {
 	FbApiMessage *msg;
 	FbJsonValues *values;
 	GError *err = NULL;
 	JsonNode *root;
 
-	if (!fb_api_json_chk(api, pload->data, pload->len, &root)) {
+	if (!fb_api_json_chk(api, g_bytes_get_data(pload, NULL),
+	                     g_bytes_get_size(pload), &root)) {
 		return;
 	}
 
@@ -1435,13 +1459,13 @@ fb_api_cb_publish_mst(FbThrift *thft, GError **error)
 		FB_API_TCHK(fb_thrift_read_field(thft, &type, &id, 0));
 		FB_API_TCHK(type == FB_THRIFT_TYPE_STRING);
 		// FB_API_TCHK(id == 2);
-		FB_API_TCHK(fb_thrift_read_str(thft, NULL));
+		FB_API_TCHK(fb_thrift_read_str_view(thft, NULL, NULL));
 		FB_API_TCHK(fb_thrift_read_stop(thft));
 	}
 }
 
 static void
-fb_api_cb_publish_ms(FbApi *api, GByteArray *pload)
+fb_api_cb_publish_ms(FbApi *api, GBytes *pload)
 {
 	const gchar *data;
 	FbJsonValues *values;
@@ -1468,7 +1492,7 @@ fb_api_cb_publish_ms(FbApi *api, GByteArray *pload)
 	};
 
 	/* Read identifier string (for Facebook employees) */
-	thft = fb_thrift_new(pload, 0);
+	thft = fb_thrift_new_from_bytes(pload);
 	fb_api_cb_publish_mst(thft, &err);
 	size = fb_thrift_get_pos(thft);
 	g_object_unref(thft);
@@ -1477,9 +1501,9 @@ fb_api_cb_publish_ms(FbApi *api, GByteArray *pload)
 		return;
 	);
 
-	g_return_if_fail(size < pload->len);
-	data = (gchar *) pload->data + size;
-	size = pload->len - size;
+	g_return_if_fail(size < g_bytes_get_size(pload));
+	data = (const gchar *) g_bytes_get_data(pload, NULL) + size;
+	size = g_bytes_get_size(pload) - size;
 
 	if (!fb_api_json_chk(api, data, size, &root)) {
 		return;
@@ -1752,7 +1776,7 @@ fb_api_cb_publish_pt(FbThrift *thft, GSList **presences, GError **error)
 	guint size = 0;
 
 	/* Read identifier string (for Facebook employees) */
-	FB_API_TCHK(fb_thrift_read_str(thft, NULL));
+	FB_API_TCHK(fb_thrift_read_str_view(thft, NULL, NULL));
 
 	/* Read the full list boolean field */
 	FB_API_TCHK(fb_thrift_read_field(thft, &type, &id, 0));
@@ -1843,13 +1867,13 @@ fb_api_cb_publish_pt(FbThrift *thft, GSList **presences, GError **error)
 }
 
 static void
-fb_api_cb_publish_p(FbApi *api, GByteArray *pload)
+fb_api_cb_publish_p(FbApi *api, GBytes *pload)
 {
 	FbThrift *thft;
 	GError *err = NULL;
 	GSList *presences = NULL;
 
-	thft = fb_thrift_new(pload, 0);
+	thft = fb_thrift_new_from_bytes(pload);
 	fb_api_cb_publish_pt(thft, &presences, &err);
 	g_object_unref(thft);
 
@@ -1862,19 +1886,29 @@ fb_api_cb_publish_p(FbApi *api, GByteArray *pload)
 	g_slist_free_full(presences, (GDestroyNotify)fb_api_presence_free);
 }
 
+static void
+fb_api_inflated_trim(FbApi *api)
+{
+	if ((api->inflated != NULL) &&
+	    (api->inflated->len > FB_API_INFLATED_MAX))
+	{
+		g_byte_array_free(api->inflated, TRUE);
+		api->inflated = g_byte_array_new();
+	}
+}
+
 static void
 fb_api_cb_mqtt_publish(G_GNUC_UNUSED FbMqtt *mqtt, const char *topic,
-                       GByteArray *pload, gpointer data)
+                       GBytes *pload, gpointer data)
 {
 	FbApi *api = data;
-	gboolean comp;
-	GByteArray *bytes;
+	GBytes *bytes;
 	GError *err = NULL;
 	guint i;
 
 	static const struct {
 		const gchar *topic;
-		void (*func) (FbApi *api, GByteArray *pload);
+		void (*func) (FbApi *api, GBytes *pload);
 	} parsers[] = {
 		{"/mark_thread_response", fb_api_cb_publish_mark},
 		{"/mercury", fb_api_cb_publish_mercury},
@@ -1884,18 +1918,38 @@ fb_api_cb_mqtt_publish(G_GNUC_UNUSED FbMqtt *mqtt, const char *topic,
 		{"/t_p", fb_api_cb_publish_p}
 	};
 
-	comp = fb_util_zlib_test(pload);
+	if (G_LIKELY(fb_util_zlib_test(pload))) {
+		if (G_UNLIKELY(api->inflater == NULL)) {
+			api->inflater = G_CONVERTER(g_zlib_decompressor_new(
+				G_ZLIB_COMPRESSOR_FORMAT_ZLIB));
+			api->inflated = g_byte_array_new();
+		}
+
+		if (!fb_util_zlib_inflate_into(api->inflater, pload, api->inflated,
+		                               &err))
+		{
+			FB_API_ERROR_EMIT(api, err,
+				fb_api_inflated_trim(api);
+				return;
+			);
+		}
 
-	if (G_LIKELY(comp)) {
-		bytes = fb_util_zlib_inflate(pload, &err);
-		FB_API_ERROR_EMIT(api, err, return);
+		/* The parsers are done with it before the next publish. */
+		bytes = g_bytes_new_static(api->inflated->data, api->inflated->len);
 	} else {
-		bytes = (GByteArray *) pload;
+		bytes = g_bytes_ref(pload);
 	}
 
-	fb_util_debug_hexdump(FB_UTIL_DEBUG_INFO, bytes,
-	                      "Reading message (topic: %s)",
-			      topic);
+	if (fb_util_debug_is_enabled(FB_UTIL_DEBUG_INFO)) {
+		GByteArray dump = {
+			.data = (guint8 *) g_bytes_get_data(bytes, NULL),
+			.len = g_bytes_get_size(bytes)
+		};
+
+		fb_util_debug_hexdump(FB_UTIL_DEBUG_INFO, &dump,
+		                      "Reading message (topic: %s)",
+		                      topic);
+	}
 
 	for (i = 0; i < G_N_ELEMENTS(parsers); i++) {
 		if (g_ascii_strcasecmp(topic, parsers[i].topic) == 0) {
@@ -1904,23 +1958,20 @@ fb_api_cb_mqtt_publish(G_GNUC_UNUSED FbMqtt *mqtt, const char *topic,
 		}
 	}
 
-	if (G_LIKELY(comp)) {
-		g_byte_array_free(bytes, TRUE);
-	}
+	g_bytes_unref(bytes);
+	fb_api_inflated_trim(api);
 }
 
 FbApi *
-fb_api_new(PurpleConnection *gc, GProxyResolver *resolver)
+fb_api_new(PurpleConnection *gc, SoupSession *session)
 {
 	FbApi *api;
 
 	api = g_object_new(FB_TYPE_API, NULL);
 
 	api->gc = gc;
-	api->cons = soup_session_new_with_options(
-	        "proxy-resolver", resolver,
-	        "user-agent", FB_API_AGENT,
-	        NULL);
+	api->cons = g_object_ref(session);
+	api->cancellable = g_cancellable_new();
 	api->mqtt = fb_mqtt_new(gc);
 
 	g_signal_connect(api->mqtt,
@@ -547,14 +547,14 @@ fb_api_error_quark(void);
 /**
  * fb_api_new:
  * @gc: The #PurpleConnection.
- * @resolver: The proxy resolver to use from the account.
+ * @session: The #SoupSession of the account from the #PurpleHttpService.
  *
  * Creates a new #FbApi. The returned #FbApi should be freed with
  * #g_object_unref() when no longer needed.
  *
  * Returns: The new #FbApi.
  */
-FbApi *fb_api_new(PurpleConnection *gc, GProxyResolver *resolver);
+FbApi *fb_api_new(PurpleConnection *gc, SoupSession *session);
 
 /**
  * fb_api_rehash:
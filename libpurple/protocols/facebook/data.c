@@ -37,7 +37,7 @@ struct _FbData {
 	GObject parent;
 
 	FbApi *api;
-	SoupSession *cons;
+	GCancellable *cancellable;
 	PurpleConnection *gc;
 	PurpleRoomlist *roomlist;
 	GQueue *msgs;
@@ -80,8 +80,8 @@ fb_data_dispose(GObject *obj)
 {
 	FbData *fata = FB_DATA(obj);
 
-	if(fata->cons != NULL) {
-		soup_session_abort(fata->cons);
+	if(fata->cancellable != NULL) {
+		g_cancellable_cancel(fata->cancellable);
 	}
 
 	if(fata->evs != NULL) {
@@ -96,7 +96,7 @@ fb_data_dispose(GObject *obj)
 
 	g_clear_object(&fata->api);
 
-	g_clear_object(&fata->cons);
+	g_clear_object(&fata->cancellable);
 	if(fata->msgs != NULL) {
 		g_queue_free_full(fata->msgs, (GDestroyNotify)fb_api_message_free);
 		fata->msgs = NULL;
@@ -156,15 +156,14 @@ fb_data_image_init(G_GNUC_UNUSED FbDataImage *img)
 }
 
 FbData *
-fb_data_new(PurpleConnection *gc, GProxyResolver *resolver)
+fb_data_new(PurpleConnection *gc, SoupSession *session)
 {
 	FbData *fata;
 
 	fata = g_object_new(FB_TYPE_DATA, NULL);
 
-	fata->cons = soup_session_new_with_options("proxy-resolver", resolver,
-	                                           NULL);
-	fata->api = fb_api_new(gc, resolver);
+	fata->cancellable = g_cancellable_new();
+	fata->api = fb_api_new(gc, session);
 	fata->gc = gc;
 
 	return fata;
@@ -487,18 +486,21 @@ fb_data_image_get_url(FbDataImage *img)
 
 static void
 fb_data_image_cb(GObject *source, GAsyncResult *result, gpointer data) {
-	SoupMessage *msg = data;
-	FbDataImage *img = g_object_get_data(G_OBJECT(msg), "facebook-data-image");
+	FbDataImage *img = data;
+	GBytes *bytes = NULL;
 	GError *err = NULL;
 
-	if(fb_http_error_chk(msg, &err)) {
-		GBytes *bytes = NULL;
+	bytes = purple_http_service_fetch_finish(PURPLE_HTTP_SERVICE(source),
+	                                         result, &err);
 
-		bytes = soup_session_send_and_read_finish(SOUP_SESSION(source),
-		                                          result, &err);
-		if(bytes != NULL) {
-			img->image = g_bytes_unref_to_data(bytes, &img->size);
-		}
+	/* The images were freed along with the FbData that cancelled them. */
+	if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		g_error_free(err);
+		return;
+	}
+
+	if (bytes != NULL) {
+		img->image = g_bytes_unref_to_data(bytes, &img->size);
 	}
 
 	img->func(img, err);
@@ -510,7 +512,6 @@ fb_data_image_cb(GObject *source, GAsyncResult *result, gpointer data) {
 	}
 
 	g_object_unref(img);
-	g_object_unref(msg);
 }
 
 void
@@ -519,6 +520,8 @@ fb_data_image_queue(FbData *fata)
 	const gchar *url;
 	FbDataImage *img;
 	GHashTableIter iter;
+	PurpleAccount *acct;
+	PurpleHttpService *service;
 	guint active = 0;
 
 	g_return_if_fail(FB_IS_DATA(fata));
@@ -534,10 +537,11 @@ fb_data_image_queue(FbData *fata)
 		return;
 	}
 
+	acct = purple_connection_get_account(fata->gc);
+	service = purple_http_service_get_default();
+
 	g_hash_table_iter_init(&iter, fata->imgs);
 	while (g_hash_table_iter_next(&iter, (gpointer *) &img, NULL)) {
-		SoupMessage *msg;
-
 		if (fb_data_image_get_active(img)) {
 			continue;
 		}
@@ -545,11 +549,10 @@ fb_data_image_queue(FbData *fata)
 		img->active = TRUE;
 		url = fb_data_image_get_url(img);
 
-		msg = soup_message_new("GET", url);
-		g_object_set_data(G_OBJECT(msg), "facebook-data-image", img);
 		// purple_http_request_set_max_len(req, FB_DATA_ICON_SIZE_MAX);
-		soup_session_send_and_read_async(fata->cons, msg, G_PRIORITY_DEFAULT,
-		                                 NULL, fb_data_image_cb, msg);
+		purple_http_service_fetch_async(service, acct, url,
+		                                fata->cancellable,
+		                                fb_data_image_cb, img);
 
 		if (++active >= FB_DATA_ICON_MAX) {
 			break;
@@ -63,14 +63,14 @@ typedef void (*FbDataImageFunc) (FbDataImage *img, GError *error);
 /**
  * fb_data_new:
  * @gc: The #PurpleConnection.
- * @resolver: The proxy resolver to use from the account.
+ * @session: The #SoupSession of the account from the #PurpleHttpService.
  *
  * Creates a new #FbData. The returned #FbData should be freed with
  * #g_object_unref() when no longer needed.
  *
  * Returns: The new #FbData.
  */
-FbData *fb_data_new(PurpleConnection *gc, GProxyResolver *resolver);
+FbData *fb_data_new(PurpleConnection *gc, SoupSession *session);
 
 /**
  * fb_data_load:
@@ -1021,20 +1021,23 @@ fb_login(G_GNUC_UNUSED PurpleProtocol *protocol, PurpleAccount *acct) {
 	FbData *fata;
 	gpointer convh;
 	PurpleConnection *gc;
-	GProxyResolver *resolver;
+	PurpleHttpService *service;
+	SoupSession *session;
 	GError *error = NULL;
 
 	gc = purple_account_get_connection(acct);
 
-	resolver = purple_proxy_get_proxy_resolver(acct, &error);
-	if (resolver == NULL) {
-		fb_util_debug_error("Unable to get account proxy resolver: %s",
+	service = purple_http_service_get_default();
+	session = purple_http_service_get_session(service, acct, &error);
+	if (session == NULL) {
+		fb_util_debug_error("Unable to get account HTTP session: %s",
 		                    error->message);
 		purple_connection_take_error(gc, error);
 		return;
 	}
 
-	fata = fb_data_new(gc, resolver);
+	fata = fb_data_new(gc, session);
+	g_object_unref(session);
 	api = fb_data_get_api(fata);
 	convh = purple_conversations_get_handle();
 	purple_connection_set_protocol_data(gc, fata);
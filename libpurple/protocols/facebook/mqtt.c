@@ -146,7 +146,9 @@ fb_mqtt_class_init(FbMqttClass *klass)
 	 * @topic: The topic.
 	 * @pload: The payload.
 	 *
-	 * Emitted upon an incoming message from the steam.
+	 * Emitted upon an incoming message from the steam. The payload
+	 * points into the read buffer, so it is only valid until the
+	 * handler returns.
 	 */
 	g_signal_new("publish",
 	             G_TYPE_FROM_CLASS(klass),
@@ -154,7 +156,8 @@ fb_mqtt_class_init(FbMqttClass *klass)
 	             0,
 	             NULL, NULL, NULL,
 	             G_TYPE_NONE,
-	             2, G_TYPE_STRING, G_TYPE_BYTE_ARRAY);
+	             2, G_TYPE_STRING,
+	             G_TYPE_BYTES | G_SIGNAL_TYPE_STATIC_SCOPE);
 }
 
 static void
@@ -465,7 +468,7 @@ void
 fb_mqtt_read(FbMqtt *mqtt, FbMqttMessage *msg)
 {
 	FbMqttMessage *nsg;
-	GByteArray *wytes;
+	GBytes *wytes;
 	gchar *str;
 	guint8 chr;
 	guint16 mid;
@@ -520,10 +523,9 @@ fb_mqtt_read(FbMqtt *mqtt, FbMqttMessage *msg)
 			g_object_unref(nsg);
 		}
 
-		wytes = g_byte_array_new();
-		fb_mqtt_message_read_r(msg, wytes);
+		wytes = fb_mqtt_message_peek_r(msg);
 		g_signal_emit_by_name(mqtt, "publish", str, wytes);
-		g_byte_array_free(wytes, TRUE);
+		g_bytes_unref(wytes);
 		g_free(str);
 		return;
 
@@ -925,6 +927,19 @@ fb_mqtt_message_read_r(FbMqttMessage *msg, GByteArray *bytes)
 	return TRUE;
 }
 
+GBytes *
+fb_mqtt_message_peek_r(FbMqttMessage *msg)
+{
+	g_return_val_if_fail(FB_IS_MQTT_MESSAGE(msg), NULL);
+
+	if (G_UNLIKELY(msg->pos >= msg->bytes->len)) {
+		return g_bytes_new_static(NULL, 0);
+	}
+
+	return g_bytes_new_static(msg->bytes->data + msg->pos,
+	                          msg->bytes->len - msg->pos);
+}
+
 gboolean
 fb_mqtt_message_read_byte(FbMqttMessage *msg, guint8 *value)
 {
@@ -412,6 +412,21 @@ fb_mqtt_message_read(FbMqttMessage *msg, gpointer data, guint size);
 gboolean
 fb_mqtt_message_read_r(FbMqttMessage *msg, GByteArray *bytes);
 
+/**
+ * fb_mqtt_message_peek_r:
+ * @msg: The #FbMqttMessage.
+ *
+ * Gets the remaining data of the #FbMqttMessage without copying it,
+ * like #fb_mqtt_message_read_r() does. The returned #GBytes points into
+ * the message, so it must not be used once the message data is freed or
+ * reused. The returned #GBytes should be freed with #g_bytes_unref()
+ * when no longer needed.
+ *
+ * Returns: (transfer full): The remaining data.
+ */
+GBytes *
+fb_mqtt_message_peek_r(FbMqttMessage *msg);
+
 /**
  * fb_mqtt_message_read_byte:
  * @msg: The #FbMqttMessage.
@@ -0,0 +1,331 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Replays /t_ms MQTT publishes through the decoding the Facebook protocol
+ * does before a payload reaches the JSON parser: reading the MQTT message,
+ * inflating the payload and skipping the Thrift header.  It is done once by
+ * copying at every step with a new decompressor per message, as it used to
+ * be, and once with views and a reused decompressor.
+ *
+ * Packets are read back to back from the file given with --capture, or
+ * generated when there is none.
+ */
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <purple.h>
+
+#include "protocols/facebook/mqtt.h"
+#include "protocols/facebook/thrift.h"
+#include "protocols/facebook/util.h"
+
+static gchar *capture = NULL;
+static gint count = 50000;
+static gint rounds = 5;
+
+static GOptionEntry entries[] = {
+	{
+		"capture", 'c', 0, G_OPTION_ARG_FILENAME, &capture,
+		"File of raw MQTT packets to replay", "FILE"
+	}, {
+		"count", 'n', 0, G_OPTION_ARG_INT, &count,
+		"Number of messages to generate without a capture", "N"
+	}, {
+		"rounds", 'r', 0, G_OPTION_ARG_INT, &rounds,
+		"Times to replay the messages", "N"
+	},
+	G_OPTION_ENTRY_NULL
+};
+
+/******************************************************************************
+ * Packets
+ *****************************************************************************/
+static GByteArray *
+generate_packet(gint i) {
+	FbMqttMessage *msg = NULL;
+	FbThrift *thft = NULL;
+	GByteArray *pload = NULL;
+	GByteArray *packet = NULL;
+	GError *error = NULL;
+	const GByteArray *bytes = NULL;
+	gchar *json = NULL;
+
+	/* Every other message carries the identifier string. */
+	thft = fb_thrift_new(NULL, 0);
+	if(i % 2 == 0) {
+		fb_thrift_write_field(thft, FB_THRIFT_TYPE_STRING, 2, 0);
+		fb_thrift_write_str(thft, "rlhQ");
+	}
+	fb_thrift_write_stop(thft);
+
+	json = g_strdup_printf(
+		"{\"deltas\":[{\"deltaNewMessage\":{\"messageMetadata\":{"
+		"\"threadKey\":{\"otherUserFbId\":\"1000%05d\"},"
+		"\"messageId\":\"mid.$%08x\",\"offlineThreadingId\":\"%d\","
+		"\"actorFbId\":\"1000%05d\",\"timestamp\":\"1600000%06d\","
+		"\"tags\":[\"source:messenger:web\",\"inbox\"]},"
+		"\"body\":\"message %d, has anyone tried the new build yet? it "
+		"seems a lot quicker on busy accounts\",\"attachments\":[]}}],"
+		"\"firstDeltaSeqId\":%d,\"lastIssuedSeqId\":%d,"
+		"\"queueEntityId\":10000%d}",
+		i % 500, (guint)g_random_int(), i, i % 500, i, i, i, i, i % 7);
+
+	pload = g_byte_array_new();
+	g_byte_array_append(pload, fb_thrift_get_bytes(thft)->data,
+	                    fb_thrift_get_bytes(thft)->len);
+	g_byte_array_append(pload, (const guint8 *)json, strlen(json));
+	g_free(json);
+	g_object_unref(thft);
+
+	packet = fb_util_zlib_deflate(pload, &error);
+	g_assert_no_error(error);
+	g_byte_array_free(pload, TRUE);
+
+	msg = fb_mqtt_message_new(FB_MQTT_MESSAGE_TYPE_PUBLISH,
+	                          FB_MQTT_MESSAGE_FLAG_QOS1);
+	fb_mqtt_message_write_str(msg, "/t_ms");
+	fb_mqtt_message_write_u16(msg, i & 0xFFFF);
+	fb_mqtt_message_write(msg, packet->data, packet->len);
+	g_byte_array_free(packet, TRUE);
+
+	bytes = fb_mqtt_message_bytes(msg);
+	packet = g_byte_array_sized_new(bytes->len);
+	g_byte_array_append(packet, bytes->data, bytes->len);
+	g_object_unref(msg);
+
+	return packet;
+}
+
+static gboolean
+load_capture(GPtrArray *packets, GError **error) {
+	gchar *contents = NULL;
+	gsize length = 0;
+	gsize pos = 0;
+
+	if(!g_file_get_contents(capture, &contents, &length, error)) {
+		return FALSE;
+	}
+
+	while(pos + 2 <= length) {
+		GByteArray *packet = NULL;
+		gsize size = 0;
+		gsize mult = 1;
+		gsize header = 1;
+		guint8 byte = 0;
+
+		do {
+			if(pos + header >= length) {
+				break;
+			}
+
+			byte = contents[pos + header++];
+			size += (byte & 127) * mult;
+			mult *= 128;
+		} while((byte & 128) != 0);
+
+		if(pos + header + size > length) {
+			break;
+		}
+
+		packet = g_byte_array_sized_new(header + size);
+		g_byte_array_append(packet, (guint8 *)contents + pos, header + size);
+		g_ptr_array_add(packets, packet);
+
+		pos += header + size;
+	}
+
+	g_free(contents);
+
+	return TRUE;
+}
+
+/******************************************************************************
+ * Decoding
+ *****************************************************************************/
+static gsize
+decode_copying(GByteArray *packet) {
+	FbMqttMessage *msg = fb_mqtt_message_new_bytes(packet);
+	FbThrift *thft = NULL;
+	FbThriftType type;
+	GByteArray *pload = NULL;
+	GByteArray *bytes = NULL;
+	gchar *topic = NULL;
+	gsize json = 0;
+	gint16 id;
+	guint16 mid;
+
+	fb_mqtt_message_read_str(msg, &topic);
+	fb_mqtt_message_read_mid(msg, &mid);
+
+	pload = g_byte_array_new();
+	fb_mqtt_message_read_r(msg, pload);
+	bytes = fb_util_zlib_inflate(pload, NULL);
+
+	thft = fb_thrift_new(bytes, 0);
+	if(fb_thrift_read_isstop(thft)) {
+		fb_thrift_read_stop(thft);
+	} else {
+		fb_thrift_read_field(thft, &type, &id, 0);
+		fb_thrift_read_str(thft, NULL);
+		fb_thrift_read_stop(thft);
+	}
+	json = bytes->len - fb_thrift_get_pos(thft);
+
+	g_object_unref(thft);
+	g_byte_array_free(bytes, TRUE);
+	g_byte_array_free(pload, TRUE);
+	g_free(topic);
+	g_object_unref(msg);
+
+	return json;
+}
+
+static gsize
+decode_views(GByteArray *packet, GConverter *inflater, GByteArray *inflated) {
+	FbMqttMessage *msg = fb_mqtt_message_new_bytes(packet);
+	FbThrift *thft = NULL;
+	FbThriftType type;
+	GBytes *pload = NULL;
+	GBytes *bytes = NULL;
+	gchar *topic = NULL;
+	gsize json = 0;
+	gint16 id;
+	guint16 mid;
+
+	fb_mqtt_message_read_str(msg, &topic);
+	fb_mqtt_message_read_mid(msg, &mid);
+
+	pload = fb_mqtt_message_peek_r(msg);
+	fb_util_zlib_inflate_into(inflater, pload, inflated, NULL);
+	bytes = g_bytes_new_static(inflated->data, inflated->len);
+
+	thft = fb_thrift_new_from_bytes(bytes);
+	if(fb_thrift_read_isstop(thft)) {
+		fb_thrift_read_stop(thft);
+	} else {
+		fb_thrift_read_field(thft, &type, &id, 0);
+		fb_thrift_read_str_view(thft, NULL, NULL);
+		fb_thrift_read_stop(thft);
+	}
+	json = inflated->len - fb_thrift_get_pos(thft);
+
+	g_object_unref(thft);
+	g_bytes_unref(bytes);
+	g_bytes_unref(pload);
+	g_free(topic);
+	g_object_unref(msg);
+
+	return json;
+}
+
+static void
+report(const gchar *name, GPtrArray *packets, gint64 elapsed, gsize json) {
+	gdouble seconds = (gdouble)elapsed / G_USEC_PER_SEC;
+	gdouble messages = (gdouble)packets->len * rounds;
+
+	g_print("%-10s %12.0f messages/s %10.1f MiB/s of JSON\n", name,
+	        messages / seconds, json / seconds / (1024.0 * 1024.0));
+}
+
+static void
+bench_copying(GPtrArray *packets) {
+	gint64 start = g_get_monotonic_time();
+	gsize json = 0;
+
+	for(gint r = 0; r < rounds; r++) {
+		for(guint i = 0; i < packets->len; i++) {
+			json += decode_copying(g_ptr_array_index(packets, i));
+		}
+	}
+
+	report("copying", packets, g_get_monotonic_time() - start, json);
+}
+
+static void
+bench_views(GPtrArray *packets) {
+	GZlibDecompressor *inflater = NULL;
+	GByteArray *inflated = g_byte_array_new();
+	gint64 start = g_get_monotonic_time();
+	gsize json = 0;
+
+	inflater = g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB);
+
+	for(gint r = 0; r < rounds; r++) {
+		for(guint i = 0; i < packets->len; i++) {
+			json += decode_views(g_ptr_array_index(packets, i),
+			                     G_CONVERTER(inflater), inflated);
+		}
+	}
+
+	report("views", packets, g_get_monotonic_time() - start, json);
+
+	g_object_unref(inflater);
+	g_byte_array_free(inflated, TRUE);
+}
+
+gint
+main(gint argc, gchar *argv[]) {
+	GOptionContext *context = NULL;
+	GPtrArray *packets = NULL;
+	GError *error = NULL;
+
+	context = g_option_context_new(NULL);
+	g_option_context_add_main_entries(context, entries, NULL);
+	if(!g_option_context_parse(context, &argc, &argv, &error)) {
+		g_printerr("%s\n", error->message);
+		g_clear_error(&error);
+		g_option_context_free(context);
+
+		return 1;
+	}
+	g_option_context_free(context);
+
+	packets = g_ptr_array_new_with_free_func((GDestroyNotify)g_byte_array_unref);
+
+	if(capture != NULL) {
+		if(!load_capture(packets, &error)) {
+			g_printerr("failed to read %s: %s\n", capture, error->message);
+			g_clear_error(&error);
+			g_ptr_array_unref(packets);
+
+			return 1;
+		}
+	} else {
+		for(gint i = 0; i < count; i++) {
+			g_ptr_array_add(packets, generate_packet(i));
+		}
+	}
+
+	if(packets->len == 0) {
+		g_printerr("no messages to replay\n");
+		g_ptr_array_unref(packets);
+
+		return 1;
+	}
+
+	g_print("replaying %u messages %d times\n", packets->len, rounds);
+
+	bench_copying(packets);
+	bench_views(packets);
+
+	g_ptr_array_unref(packets);
+	g_free(capture);
+
+	return 0;
+}
@@ -36,6 +36,11 @@ struct _FbThrift {
 	guint offset;
 	guint pos;
 	guint lastbool;
+
+	/* Set instead of bytes when reading a #GBytes in place. */
+	GBytes *view;
+	const guint8 *vdata;
+	guint vsize;
 };
 
 G_DEFINE_TYPE(FbThrift, fb_thrift, G_TYPE_OBJECT);
@@ -50,6 +55,12 @@ fb_thrift_dispose(GObject *obj)
 		thft->bytes = NULL;
 		thft->internal = FALSE;
 	}
+
+	g_clear_pointer(&thft->view, g_bytes_unref);
+	thft->vdata = NULL;
+	thft->vsize = 0;
+
+	G_OBJECT_CLASS(fb_thrift_parent_class)->dispose(obj);
 }
 
 static void
@@ -84,6 +95,34 @@ fb_thrift_new(GByteArray *bytes, guint offset)
 	return thft;
 }
 
+FbThrift *
+fb_thrift_new_from_bytes(GBytes *bytes)
+{
+	FbThrift *thft;
+	gsize size;
+
+	g_return_val_if_fail(bytes != NULL, NULL);
+
+	thft = g_object_new(FB_TYPE_THRIFT, NULL);
+	thft->view = g_bytes_ref(bytes);
+	thft->vdata = g_bytes_get_data(bytes, &size);
+	thft->vsize = MIN(size, G_MAXUINT);
+
+	return thft;
+}
+
+static inline const guint8 *
+fb_thrift_data(FbThrift *thft, guint *size)
+{
+	if (thft->view != NULL) {
+		*size = thft->vsize;
+		return thft->vdata;
+	}
+
+	*size = thft->bytes->len;
+	return thft->bytes->data;
+}
+
 const GByteArray *
 fb_thrift_get_bytes(FbThrift *thft)
 {
@@ -119,14 +158,19 @@ fb_thrift_reset(FbThrift *thft)
 gboolean
 fb_thrift_read(FbThrift *thft, gpointer data, guint size)
 {
+	const guint8 *buf;
+	guint len;
+
 	g_return_val_if_fail(FB_IS_THRIFT(thft), FALSE);
 
-	if ((thft->pos + size) > thft->bytes->len) {
+	buf = fb_thrift_data(thft, &len);
+
+	if ((thft->pos > len) || (size > (len - thft->pos))) {
 		return FALSE;
 	}
 
 	if ((data != NULL) && (size > 0)) {
-		memcpy(data, thft->bytes->data + thft->pos, size);
+		memcpy(data, buf + thft->pos, size);
 	}
 
 	thft->pos += size;
@@ -164,7 +208,24 @@ fb_thrift_read_bool(FbThrift *thft, gboolean *value)
 gboolean
 fb_thrift_read_byte(FbThrift *thft, guint8 *value)
 {
-	return fb_thrift_read(thft, value, sizeof *value);
+	const guint8 *buf;
+	guint len;
+
+	g_return_val_if_fail(FB_IS_THRIFT(thft), FALSE);
+
+	/* Every varint goes through here a byte at a time. */
+	buf = fb_thrift_data(thft, &len);
+
+	if (thft->pos >= len) {
+		return FALSE;
+	}
+
+	if (value != NULL) {
+		*value = buf[thft->pos];
+	}
+
+	thft->pos++;
+	return TRUE;
 }
 
 gboolean
@@ -293,29 +354,48 @@ fb_thrift_read_vi64(FbThrift *thft, guint64 *value)
 gboolean
 fb_thrift_read_str(FbThrift *thft, gchar **value)
 {
-	guint8 *data;
-	guint32 size;
+	const gchar *data;
+	guint size;
 
-	if (!fb_thrift_read_vi32(thft, &size)) {
+	if (!fb_thrift_read_str_view(thft, (value != NULL) ? &data : NULL,
+	                             &size))
+	{
 		return FALSE;
 	}
 
 	if (value != NULL) {
-		data = g_new(guint8, size + 1);
-		data[size] = 0;
-	} else {
-		data = NULL;
+		*value = g_strndup(data, size);
 	}
 
-	if (!fb_thrift_read(thft, data, size)) {
-		g_free(data);
+	return TRUE;
+}
+
+gboolean
+fb_thrift_read_str_view(FbThrift *thft, const gchar **value, guint *size)
+{
+	const guint8 *buf;
+	guint32 u32;
+	guint len;
+
+	if (!fb_thrift_read_vi32(thft, &u32)) {
+		return FALSE;
+	}
+
+	buf = fb_thrift_data(thft, &len);
+
+	if ((thft->pos > len) || (u32 > (len - thft->pos))) {
 		return FALSE;
 	}
 
 	if (value != NULL) {
-		*value = (gchar *) data;
+		*value = (const gchar *) buf + thft->pos;
+	}
+
+	if (size != NULL) {
+		*size = u32;
 	}
 
+	thft->pos += u32;
 	return TRUE;
 }
 
@@ -453,6 +533,7 @@ void
 fb_thrift_write(FbThrift *thft, gconstpointer data, guint size)
 {
 	g_return_if_fail(FB_IS_THRIFT(thft));
+	g_return_if_fail(thft->view == NULL);
 
 	g_byte_array_append(thft->bytes, data, size);
 	thft->pos += size;
@@ -84,13 +84,28 @@ G_DECLARE_FINAL_TYPE(FbThrift, fb_thrift, FB, THRIFT, GObject)
 FbThrift *
 fb_thrift_new(GByteArray *bytes, guint offset);
 
+/**
+ * fb_thrift_new_from_bytes:
+ * @bytes: The #GBytes to read.
+ *
+ * Creates a new #FbThrift which reads @bytes in place, without copying
+ * it. The #FbThrift holds a reference on @bytes and cannot be written to.
+ * The returned #FbThrift should be freed with #g_object_unref() when no
+ * longer needed.
+ *
+ * Returns: The new #FbThrift.
+ */
+FbThrift *
+fb_thrift_new_from_bytes(GBytes *bytes);
+
 /**
  * fb_thrift_get_bytes:
  * @thft: The #FbThrift.
  *
  * Gets the underlying #GByteArray of an #FbThrift.
  *
- * Returns: The #GByteArray.
+ * Returns: The #GByteArray, or #NULL if the #FbThrift was created with
+ *          #fb_thrift_new_from_bytes().
  */
 const GByteArray *
 fb_thrift_get_bytes(FbThrift *thft);
@@ -276,6 +291,22 @@ fb_thrift_read_vi64(FbThrift *thft, guint64 *value);
 gboolean
 fb_thrift_read_str(FbThrift *thft, gchar **value);
 
+/**
+ * fb_thrift_read_str_view:
+ * @thft: The #FbThrift.
+ * @value: The return location for the string or #NULL.
+ * @size: The return location for the size of the string or #NULL.
+ *
+ * Reads a string value from the #FbThrift without copying it. The value
+ * returned to @value points into the data being read, is not nul
+ * terminated, and is only valid for as long as that data is. Use
+ * #fb_thrift_read_str() for strings which need to outlive it.
+ *
+ * Returns: #TRUE if the value was read, otherwise #FALSE.
+ */
+gboolean
+fb_thrift_read_str_view(FbThrift *thft, const gchar **value, guint *size);
+
 /**
  * fb_thrift_read_field:
  * @thft: The #FbThrift.
@@ -102,21 +102,27 @@ fb_util_debug(PurpleDebugLevel level, const gchar *format, ...)
 	va_end(ap);
 }
 
-void
-fb_util_vdebug(PurpleDebugLevel level, const gchar *format, va_list ap)
+gboolean
+fb_util_debug_is_enabled(PurpleDebugLevel level)
 {
 	gboolean unsafe;
 	gboolean verbose;
-	gchar *str;
-
-	g_return_if_fail(format != NULL);
 
 	unsafe = (level & FB_UTIL_DEBUG_FLAG_UNSAFE) != 0;
 	verbose = (level & FB_UTIL_DEBUG_FLAG_VERBOSE) != 0;
 
-	if ((unsafe && !purple_debug_is_unsafe()) ||
-	    (verbose && !purple_debug_is_verbose()))
-	{
+	return (!unsafe || purple_debug_is_unsafe()) &&
+	       (!verbose || purple_debug_is_verbose());
+}
+
+void
+fb_util_vdebug(PurpleDebugLevel level, const gchar *format, va_list ap)
+{
+	gchar *str;
+
+	g_return_if_fail(format != NULL);
+
+	if (!fb_util_debug_is_enabled(level)) {
 		return;
 	}
 
@@ -192,6 +198,11 @@ fb_util_debug_hexdump(PurpleDebugLevel level, const GByteArray *bytes,
 
 	g_return_if_fail(bytes != NULL);
 
+	/* Don't format a whole payload just to throw it away. */
+	if (!fb_util_debug_is_enabled(level)) {
+		return;
+	}
+
 	if (format != NULL) {
 		va_start(ap, format);
 		fb_util_vdebug(level, format, ap);
@@ -531,60 +542,84 @@ fb_util_strtest(const gchar *str, GAsciiType type)
 }
 
 gboolean
-fb_util_zlib_test(const GByteArray *bytes)
+fb_util_zlib_test(GBytes *bytes)
 {
+	const guint8 *data;
+	gsize size;
 	guint8 b0;
 	guint8 b1;
 
 	g_return_val_if_fail(bytes != NULL, FALSE);
 
-	if (bytes->len < 2) {
+	data = g_bytes_get_data(bytes, &size);
+
+	if (size < 2) {
 		return FALSE;
 	}
 
-	b0 = *(bytes->data + 0);
-	b1 = *(bytes->data + 1);
+	b0 = *(data + 0);
+	b1 = *(data + 1);
 
 	return ((((b0 << 8) | b1) % 31) == 0) &&    /* Check the header */
 	       ((b0 & 0x0F) == 8 /* Z_DEFLATED */); /* Check the method */
 }
 
-static GByteArray *
-fb_util_zlib_conv(GConverter *conv, const GByteArray *bytes, GError **error)
+static gboolean
+fb_util_zlib_conv_into(GConverter *conv, const guint8 *data, gsize size,
+                       GByteArray *out, GError **error)
 {
-	GByteArray *ret;
 	GConverterResult res;
+	GError *err = NULL;
+	gsize avail;
 	gsize cize = 0;
 	gsize rize;
 	gsize wize;
-	guint8 data[1024];
+	guint len;
 
-	ret = g_byte_array_new();
+	g_byte_array_set_size(out, 0);
+
+	/* Convert straight into the output, growing it when it fills up. */
+	avail = MAX(size * 4, 1024);
 
 	while (TRUE) {
 		rize = 0;
 		wize = 0;
 
+		len = out->len;
+		g_byte_array_set_size(out, len + avail);
+
 		res = g_converter_convert(conv,
-		                          bytes->data + cize,
-		                          bytes->len - cize,
-		                          data, sizeof data,
+		                          data + cize,
+		                          size - cize,
+		                          out->data + len, avail,
 		                          G_CONVERTER_INPUT_AT_END,
-		                          &rize, &wize, error);
+		                          &rize, &wize, &err);
+
+		g_byte_array_set_size(out, len + wize);
 
 		switch (res) {
 		case G_CONVERTER_CONVERTED:
-			g_byte_array_append(ret, data, wize);
 			cize += rize;
+
+			if (wize == avail) {
+				avail *= 2;
+			}
 			break;
 
 		case G_CONVERTER_ERROR:
-			g_byte_array_free(ret, TRUE);
-			return NULL;
+			/* Not even a single block fit into what was left. */
+			if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_NO_SPACE)) {
+				g_clear_error(&err);
+				avail *= 2;
+				break;
+			}
+
+			g_propagate_error(error, err);
+			g_byte_array_set_size(out, 0);
+			return FALSE;
 
 		case G_CONVERTER_FINISHED:
-			g_byte_array_append(ret, data, wize);
-			return ret;
+			return TRUE;
 
 		default:
 			break;
@@ -592,6 +627,21 @@ fb_util_zlib_conv(GConverter *conv, const GByteArray *bytes, GError **error)
 	}
 }
 
+static GByteArray *
+fb_util_zlib_conv(GConverter *conv, const GByteArray *bytes, GError **error)
+{
+	GByteArray *ret;
+
+	ret = g_byte_array_new();
+
+	if (!fb_util_zlib_conv_into(conv, bytes->data, bytes->len, ret, error)) {
+		g_byte_array_free(ret, TRUE);
+		return NULL;
+	}
+
+	return ret;
+}
+
 GByteArray *
 fb_util_zlib_deflate(const GByteArray *bytes, GError **error)
 {
@@ -615,3 +665,20 @@ fb_util_zlib_inflate(const GByteArray *bytes, GError **error)
 	g_object_unref(conv);
 	return ret;
 }
+
+gboolean
+fb_util_zlib_inflate_into(GConverter *conv, GBytes *bytes, GByteArray *out,
+                          GError **error)
+{
+	const guint8 *data;
+	gsize size;
+
+	g_return_val_if_fail(G_IS_CONVERTER(conv), FALSE);
+	g_return_val_if_fail(bytes != NULL, FALSE);
+	g_return_val_if_fail(out != NULL, FALSE);
+
+	g_converter_reset(conv);
+	data = g_bytes_get_data(bytes, &size);
+
+	return fb_util_zlib_conv_into(conv, data, size, out, error);
+}
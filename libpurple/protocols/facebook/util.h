@@ -185,6 +185,19 @@ void
 fb_util_debug_fatal(const gchar *format, ...)
                     G_GNUC_PRINTF(1, 2);
 
+/**
+ * fb_util_debug_is_enabled:
+ * @level: The #PurpleDebugLevel.
+ *
+ * Checks whether messages at @level would be logged, taking the
+ * #FbUtilDebugFlags of @level into account. Use this to skip preparing
+ * debugging output which would be thrown away.
+ *
+ * Returns: #TRUE if messages at @level are logged, otherwise #FALSE.
+ */
+gboolean
+fb_util_debug_is_enabled(PurpleDebugLevel level);
+
 /**
  * fb_util_debug_hexdump:
  * @level: The #PurpleDebugLevel.
@@ -297,14 +310,14 @@ fb_util_strtest(const gchar *str, GAsciiType type);
 
 /**
  * fb_util_zlib_test:
- * @bytes: The #GByteArray.
+ * @bytes: The #GBytes.
  *
- * Tests if the #GByteArray is zlib compressed.
+ * Tests if the #GBytes is zlib compressed.
  *
- * Returns: #TRUE if the #GByteArray is compressed, otherwise #FALSE.
+ * Returns: #TRUE if the #GBytes is compressed, otherwise #FALSE.
  */
 gboolean
-fb_util_zlib_test(const GByteArray *bytes);
+fb_util_zlib_test(GBytes *bytes);
 
 /**
  * fb_util_zlib_deflate:
@@ -332,4 +345,22 @@ fb_util_zlib_deflate(const GByteArray *bytes, GError **error);
 GByteArray *
 fb_util_zlib_inflate(const GByteArray *bytes, GError **error);
 
+/**
+ * fb_util_zlib_inflate_into:
+ * @conv: The #GZlibDecompressor.
+ * @bytes: The #GBytes.
+ * @out: The #GByteArray to inflate into.
+ * @error: The return location for the #GError or #NULL.
+ *
+ * Inflates a #GBytes with zlib, replacing the contents of @out. The
+ * decompressor is reset first, so @conv and @out can be kept for the life
+ * of a connection instead of being created for every message, and @out
+ * keeps the space it grew to.
+ *
+ * Returns: #TRUE if @bytes was inflated, otherwise #FALSE.
+ */
+gboolean
+fb_util_zlib_inflate_into(GConverter *conv, GBytes *bytes, GByteArray *out,
+                          GError **error);
+
 #endif /* PURPLE_FACEBOOK_UTIL_H */
@@ -232,7 +232,8 @@ ggp_avatar_buddy_update(PurpleConnection *gc, uin_t uin, time_t timestamp)
 	soup_message_headers_replace(soup_message_get_request_headers(req),
 	                             "User-Agent", GGP_AVATAR_USERAGENT);
 	// purple_http_request_set_max_len(req, GGP_AVATAR_SIZE_MAX);
-	soup_session_send_and_read_async(info->http, req, G_PRIORITY_DEFAULT, NULL,
+	soup_session_send_and_read_async(info->http, req, G_PRIORITY_DEFAULT,
+	                                 info->http_cancellable,
 	                                 ggp_avatar_buddy_update_received,
 	                                 pending_update);
 }
@@ -314,7 +315,8 @@ ggp_avatar_own_got_token(PurpleConnection *gc, const gchar *token,
 	headers = soup_message_get_request_headers(req);
 	soup_message_headers_replace(headers, "Authorization", token);
 	soup_message_headers_replace(headers, "From", "avatars to avatars");
-	soup_session_send_and_read_async(info->http, req, G_PRIORITY_DEFAULT, NULL,
+	soup_session_send_and_read_async(info->http, req, G_PRIORITY_DEFAULT,
+	                                 info->http_cancellable,
 	                                 ggp_avatar_own_sent, req);
 	g_free(img_data);
 	g_free(uin_str);
@@ -111,6 +111,8 @@ ggp_edisc_setup(PurpleConnection *gc, GProxyResolver *resolver)
 
 	accdata->edisc_data = sdata;
 
+	/* This one isn't from the HTTP service, as its cookie jar holds the
+	 * login of this account only. */
 	sdata->session = soup_session_new_with_options("proxy-resolver", resolver,
 	                                               NULL);
 	soup_session_add_feature_by_type(sdata->session, SOUP_TYPE_COOKIE_JAR);
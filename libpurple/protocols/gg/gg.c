@@ -803,6 +803,7 @@ ggp_login(G_GNUC_UNUSED PurpleProtocol *protocol, PurpleAccount *account) {
 	const char *address;
 	const gchar *encryption_type, *protocol_version;
 	GProxyResolver *resolver;
+	SoupSession *http;
 	GError *error = NULL;
 
 	purple_connection_set_flags(gc,
@@ -817,14 +818,24 @@ ggp_login(G_GNUC_UNUSED PurpleProtocol *protocol, PurpleAccount *account) {
 		return;
 	}
 
+	http = purple_http_service_get_session(purple_http_service_get_default(),
+	                                       account, &error);
+	if (http == NULL) {
+		purple_debug_error("gg", "Unable to get account HTTP session: %s",
+		                   error->message);
+		purple_connection_take_error(gc, error);
+		g_object_unref(resolver);
+		return;
+	}
+
 	glp = g_new0(struct gg_login_params, 1);
 	glp->struct_size = sizeof(struct gg_login_params);
 	info = g_new0(GGPInfo, 1);
 
 	purple_connection_set_protocol_data(gc, info);
 
-	info->http = soup_session_new_with_options("proxy-resolver", resolver,
-	                                           NULL);
+	info->http = http;
+	info->http_cancellable = g_cancellable_new();
 
 	ggp_tcpsocket_setup(gc, glp);
 	ggp_image_setup(gc);
@@ -951,10 +962,11 @@ ggp_close(G_GNUC_UNUSED PurpleProtocol *protocol, PurpleConnection *gc) {
 			g_source_remove(info->inpa);
 		g_free(info->imtoken);
 
-		if (info->http) {
-			soup_session_abort(info->http);
-			g_object_unref(info->http);
+		if (info->http_cancellable) {
+			g_cancellable_cancel(info->http_cancellable);
+			g_object_unref(info->http_cancellable);
 		}
+		g_clear_object(&info->http);
 
 		purple_connection_set_protocol_data(gc, NULL);
 		g_free(info);
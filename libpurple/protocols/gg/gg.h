@@ -48,6 +48,7 @@ G_DECLARE_FINAL_TYPE(GGPProtocol, ggp_protocol, GGP, PROTOCOL, PurpleProtocol)
 typedef struct {
 	struct gg_session *session;
 	SoupSession *http;
+	GCancellable *http_cancellable;
 	guint inpa;
 
 	gchar *imtoken;
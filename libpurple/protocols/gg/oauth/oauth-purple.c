@@ -133,21 +133,37 @@ ggp_oauth_access_token_got(GObject *source, GAsyncResult *result,
 }
 
 static void
-ggp_oauth_authorization_done(GObject *source,
-                             G_GNUC_UNUSED GAsyncResult *result,
+ggp_oauth_authorization_done(GObject *source, GAsyncResult *result,
                              gpointer user_data)
 {
 	ggp_oauth_data *data = user_data;
+	GGPInfo *gg_info = NULL;
 	PurpleAccount *account;
 	PurpleContactInfo *info = NULL;
+	GBytes *response_body = NULL;
 	SoupStatus status_code;
 	char *auth;
 	SoupMessage *msg = NULL;
 	const char *method = "POST";
 	const char *url = "http://api.gadu-gadu.pl/access_token";
+	GError *error = NULL;
+
+	/* This fails with G_IO_ERROR_CANCELLED once the connection is closed, so
+	 * don't touch it before we know. */
+	response_body = soup_session_send_and_read_finish(SOUP_SESSION(source),
+	                                                  result, &error);
+	if(response_body == NULL) {
+		purple_debug_error("gg", "ggp_oauth_authorization_done: failed: %s",
+		                   error->message);
+		ggp_oauth_data_free(data);
+		g_error_free(error);
+		return;
+	}
+	g_bytes_unref(response_body);
 
 	PURPLE_ASSERT_CONNECTION_IS_VALID(data->gc);
 
+	gg_info = purple_connection_get_protocol_data(data->gc);
 	account = purple_connection_get_account(data->gc);
 	info = PURPLE_CONTACT_INFO(account);
 
@@ -173,8 +189,8 @@ ggp_oauth_authorization_done(GObject *source,
 	// purple_http_request_set_max_len(req, GGP_OAUTH_RESPONSE_MAX);
 	soup_message_headers_replace(soup_message_get_request_headers(msg),
 	                             "Authorization", auth);
-	soup_session_send_and_read_async(SOUP_SESSION(source), msg,
-	                                 G_PRIORITY_DEFAULT, NULL,
+	soup_session_send_and_read_async(gg_info->http, msg, G_PRIORITY_DEFAULT,
+	                                 gg_info->http_cancellable,
 	                                 ggp_oauth_access_token_got, data);
 
 	g_free(auth);
@@ -186,6 +202,7 @@ ggp_oauth_request_token_got(GObject *source, GAsyncResult *result,
 {
 	SoupSession *session = SOUP_SESSION(source);
 	ggp_oauth_data *data = user_data;
+	GGPInfo *info = NULL;
 	GBytes *response_body = NULL;
 	const char *buffer = NULL;
 	gsize size = 0;
@@ -197,26 +214,30 @@ ggp_oauth_request_token_got(GObject *source, GAsyncResult *result,
 	gboolean succ = TRUE;
 	GError *error = NULL;
 
+	/* This fails with G_IO_ERROR_CANCELLED once the connection is closed, so
+	 * don't touch it before we know. */
+	response_body = soup_session_send_and_read_finish(session, result, &error);
+	if(response_body == NULL) {
+		purple_debug_error("gg", "ggp_oauth_request_token_got: failed: %s",
+		                   error->message);
+		ggp_oauth_data_free(data);
+		g_error_free(error);
+		return;
+	}
+
 	PURPLE_ASSERT_CONNECTION_IS_VALID(data->gc);
 
+	info = purple_connection_get_protocol_data(data->gc);
 	account = purple_connection_get_account(data->gc);
 
 	if(!SOUP_STATUS_IS_SUCCESSFUL(soup_message_get_status(data->msg))) {
 		purple_debug_error("gg", "ggp_oauth_request_token_got: "
 			"requested token not received\n");
+		g_bytes_unref(response_body);
 		ggp_oauth_data_free(data);
 		return;
 	}
 
-	response_body = soup_session_send_and_read_finish(session, result, &error);
-	if(response_body == NULL) {
-		purple_debug_error("gg", "ggp_oauth_access_token_got: failed: %s",
-		                   error->message);
-		ggp_oauth_data_free(data);
-		g_error_free(error);
-		return;
-	}
-
 	purple_debug_misc("gg", "ggp_oauth_request_token_got: "
 		"got request token, doing authorization...\n");
 
@@ -259,7 +280,8 @@ ggp_oauth_request_token_got(GObject *source, GAsyncResult *result,
 	                                         "application/x-www-form-urlencoded",
 	                                         body);
 	g_bytes_unref(body);
-	soup_session_send_and_read_async(session, msg, G_PRIORITY_DEFAULT, NULL,
+	soup_session_send_and_read_async(info->http, msg, G_PRIORITY_DEFAULT,
+	                                 info->http_cancellable,
 	                                 ggp_oauth_authorization_done, data);
 }
 
@@ -294,7 +316,8 @@ ggp_oauth_request(PurpleConnection *gc, ggp_oauth_request_cb callback,
 	// purple_http_request_set_max_len(req, GGP_OAUTH_RESPONSE_MAX);
 	soup_message_headers_replace(soup_message_get_request_headers(msg),
 	                             "Authorization", auth);
-	soup_session_send_and_read_async(info->http, msg, G_PRIORITY_DEFAULT, NULL,
+	soup_session_send_and_read_async(info->http, msg, G_PRIORITY_DEFAULT,
+	                                 info->http_cancellable,
 	                                 ggp_oauth_request_token_got, data);
 
 	g_free(auth);
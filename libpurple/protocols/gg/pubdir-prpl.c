@@ -309,7 +309,8 @@ ggp_pubdir_get_info_got_token(PurpleConnection *gc, const gchar *token,
 	g_free(url);
 	soup_message_headers_replace(soup_message_get_request_headers(msg),
 	                             "Authorization", token);
-	soup_session_send_and_read_async(info->http, msg, G_PRIORITY_DEFAULT, NULL,
+	soup_session_send_and_read_async(info->http, msg, G_PRIORITY_DEFAULT,
+	                                 info->http_cancellable,
 	                                 ggp_pubdir_got_data, request);
 	g_object_unref(msg);
 }
@@ -555,7 +556,8 @@ static void ggp_pubdir_search_got_token(PurpleConnection *gc,
 	msg = soup_message_new("GET", url);
 	soup_message_headers_replace(soup_message_get_request_headers(msg),
 	                             "Authorization", token);
-	soup_session_send_and_read_async(info->http, msg, G_PRIORITY_DEFAULT, NULL,
+	soup_session_send_and_read_async(info->http, msg, G_PRIORITY_DEFAULT,
+	                                 info->http_cancellable,
 	                                 ggp_pubdir_got_data, request);
 
 	g_object_unref(msg);
@@ -884,7 +886,8 @@ static void ggp_pubdir_set_info_got_token(PurpleConnection *gc,
 	                                         "application/x-www-form-urlencoded",
 	                                         body);
 	g_bytes_unref(body);
-	soup_session_send_and_read_async(info->http, msg, G_PRIORITY_DEFAULT, NULL,
+	soup_session_send_and_read_async(info->http, msg, G_PRIORITY_DEFAULT,
+	                                 info->http_cancellable,
 	                                 ggp_pubdir_set_info_got_response, msg);
 
 	g_free(url);
@@ -34,6 +34,8 @@
 
 #define PING_TIMEOUT 60
 
+PurpleDebugCategory irc_debug = PURPLE_DEBUG_CATEGORY_INIT("irc");
+
 struct _IRCProtocol {
 	PurpleProtocol parent;
 };
@@ -287,10 +289,13 @@ irc_send_len(struct irc_conn *irc, const char *buf, G_GNUC_UNUSED int buflen) {
 	if (tosend == NULL)
 		return 0;
 
-	if (purple_debug_is_verbose()) {
+	if (purple_debug_is_verbose() &&
+	    PURPLE_DEBUG_CATEGORY_ENABLED(&irc_debug, PURPLE_DEBUG_MISC))
+	{
 		gchar *clean = g_utf8_make_valid(tosend, -1);
 		clean = g_strstrip(clean);
-		purple_debug_misc("irc", "<< %s\n", clean);
+		purple_debug_category_log(&irc_debug, PURPLE_DEBUG_MISC, "<< %s",
+		                          clean);
 		g_free(clean);
 	}
 
@@ -718,6 +723,7 @@ irc_close(G_GNUC_UNUSED PurpleProtocol *protocol, PurpleConnection *gc) {
 	g_free(irc->server);
 
 	g_free(irc->mode_chars);
+	g_free(irc->elist);
 	g_free(irc->reqnick);
 
 	g_clear_object(&irc->hasl_ctx);
@@ -1024,10 +1030,13 @@ irc_chat_set_topic(G_GNUC_UNUSED PurpleProtocolChat *protocol_chat,
 }
 
 static PurpleRoomlist *
-irc_roomlist_get_list(G_GNUC_UNUSED PurpleProtocolRoomlist *protocol_roomlist,
-                      PurpleConnection *gc)
+irc_roomlist_query_list(G_GNUC_UNUSED PurpleProtocolRoomlist *protocol_roomlist,
+                        PurpleConnection *gc, const gchar *filter,
+                        guint min_users)
 {
 	struct irc_conn *irc;
+	GPtrArray *conditions;
+	char *mask = NULL;
 	char *buf;
 
 	irc = purple_connection_get_protocol_data(gc);
@@ -1037,13 +1046,67 @@ irc_roomlist_get_list(G_GNUC_UNUSED PurpleProtocolRoomlist *protocol_roomlist,
 
 	irc->roomlist = purple_roomlist_new(purple_connection_get_account(gc));
 
-	buf = irc_format(irc, "v", "LIST");
+	/* Channel names include their prefix, so a search for "foo*" has to be
+	 * turned into "#foo*" to match anything. Plain text is matched anywhere
+	 * in the name.
+	 */
+	if (filter != NULL && *filter != '\0') {
+		if (strpbrk(filter, "*?") == NULL) {
+			mask = g_strdup_printf("*%s*", filter);
+		} else if (*filter == '*' || irc_ischannel(filter)) {
+			mask = g_strdup(filter);
+		} else {
+			mask = g_strdup_printf("#%s", filter);
+		}
+	}
+
+	/* The room list applies the whole query to whatever the server sends,
+	 * in case it ignores part of it. */
+	purple_roomlist_set_filter(irc->roomlist, mask);
+	purple_roomlist_set_min_users(irc->roomlist, min_users);
+
+	/* Push as much of the query as the server supports down to it, so we
+	 * don't have to download every channel on the network. See the ELIST
+	 * token of RPL_ISUPPORT.
+	 */
+	conditions = g_ptr_array_new_with_free_func(g_free);
+	if (irc->elist != NULL) {
+		if (min_users > 0 && strchr(irc->elist, 'U') != NULL) {
+			/* ">n" means more than n users. */
+			g_ptr_array_add(conditions, g_strdup_printf(">%u", min_users - 1));
+		}
+
+		if (mask != NULL && strchr(irc->elist, 'M') != NULL) {
+			g_ptr_array_add(conditions, g_strdup(mask));
+		}
+	}
+	g_free(mask);
+
+	if (conditions->len > 0) {
+		char *query;
+
+		g_ptr_array_add(conditions, NULL);
+		query = g_strjoinv(",", (char **)conditions->pdata);
+		buf = irc_format(irc, "vn", "LIST", query);
+		g_free(query);
+	} else {
+		buf = irc_format(irc, "v", "LIST");
+	}
+	g_ptr_array_free(conditions, TRUE);
+
 	irc_send(irc, buf);
 	g_free(buf);
 
 	return irc->roomlist;
 }
 
+static PurpleRoomlist *
+irc_roomlist_get_list(PurpleProtocolRoomlist *protocol_roomlist,
+                      PurpleConnection *gc)
+{
+	return irc_roomlist_query_list(protocol_roomlist, gc, NULL, 0);
+}
+
 static void
 irc_roomlist_cancel(G_GNUC_UNUSED PurpleProtocolRoomlist *protocol_roomlist,
                     PurpleRoomlist *list)
@@ -1162,6 +1225,7 @@ static void
 irc_protocol_roomlist_iface_init(PurpleProtocolRoomlistInterface *roomlist_iface)
 {
 	roomlist_iface->get_list = irc_roomlist_get_list;
+	roomlist_iface->query_list = irc_roomlist_query_list;
 	roomlist_iface->cancel   = irc_roomlist_cancel;
 }
 
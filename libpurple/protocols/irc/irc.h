@@ -93,6 +93,7 @@ struct irc_conn {
 	time_t recv_time;
 
 	char *mode_chars;
+	char *elist;
 	char *reqnick;
 	gboolean nickused;
 
@@ -109,6 +110,9 @@ struct irc_buddy {
 
 typedef int (*IRCCmdCallback) (struct irc_conn *irc, const char *cmd, const char *target, const char **args);
 
+/* The debug category for the raw traffic, defined in irc.c. */
+extern PurpleDebugCategory irc_debug;
+
 int irc_send(struct irc_conn *irc, const char *buf);
 int irc_send_len(struct irc_conn *irc, const char *buf, int len);
 gboolean irc_blist_timeout(struct irc_conn *irc);
@@ -211,6 +211,9 @@ irc_msg_features(struct irc_conn *irc, G_GNUC_UNUSED const char *name,
 		if (!strncmp(features[i], "PREFIX=", 7)) {
 			if ((val = strchr(features[i] + 7, ')')) != NULL)
 				irc->mode_chars = g_strdup(val + 1);
+		} else if (!strncmp(features[i], "ELIST=", 6)) {
+			g_free(irc->elist);
+			irc->elist = g_ascii_strup(features[i] + 6, -1);
 		}
 	}
 
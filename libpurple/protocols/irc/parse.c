@@ -689,10 +689,13 @@ void irc_parse_msg(struct irc_conn *irc, char *input)
 	 */
 	purple_signal_emit(_irc_protocol, "irc-receiving-text", gc, &input);
 
-	if (purple_debug_is_verbose()) {
+	if (purple_debug_is_verbose() &&
+	    PURPLE_DEBUG_CATEGORY_ENABLED(&irc_debug, PURPLE_DEBUG_MISC))
+	{
 		char *clean = g_utf8_make_valid(input, -1);
 		clean = g_strstrip(clean);
-		purple_debug_misc("irc", ">> %s\n", clean);
+		purple_debug_category_log(&irc_debug, PURPLE_DEBUG_MISC, ">> %s",
+		                          clean);
 		g_free(clean);
 	}
 
@@ -556,6 +556,8 @@ void jabber_auth_init(void)
 
 void jabber_auth_uninit(void)
 {
+	jabber_auth_scram_uninit();
+
 	g_slist_free(auth_mechs);
 	auth_mechs = NULL;
 }
@@ -58,6 +58,8 @@ JabberSaslMech *jabber_auth_get_digest_md5_mech(void);
 JabberSaslMech **jabber_auth_get_scram_mechs(gint *count);
 JabberSaslMech *jabber_auth_get_webex_token_mech(void);
 
+void jabber_auth_scram_uninit(void);
+
 void jabber_auth_init(void);
 void jabber_auth_uninit(void);
 
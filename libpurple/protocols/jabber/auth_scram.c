@@ -49,7 +49,7 @@ static const JabberScramHash *mech_to_hash(const char *mech)
 guchar *jabber_scram_hi(const JabberScramHash *hash, const GString *str,
                         GString *salt, guint iterations)
 {
-	GHmac *hmac;
+	GHmac *base, *hmac;
 	gsize digest_len;
 	guchar *result;
 	guint i;
@@ -65,13 +65,17 @@ guchar *jabber_scram_hi(const JabberScramHash *hash, const GString *str,
 	tmp    = g_new0(guchar, digest_len);
 	result = g_new0(guchar, digest_len);
 
-	hmac = g_hmac_new(hash->type, (guchar *)str->str, str->len);
+	/* Key the HMAC once. Every round below starts from a copy of this keyed
+	 * state instead of hashing the password into fresh inner and outer pads
+	 * again, which roughly halves the cost of each iteration. */
+	base = g_hmac_new(hash->type, (guchar *)str->str, str->len);
 
 	/* Append INT(1), a four-octet encoding of the integer 1, most significant
 	 * octet first. */
 	g_string_append_len(salt, "\0\0\0\1", 4);
 
 	/* Compute U0 */
+	hmac = g_hmac_copy(base);
 	g_hmac_update(hmac, (guchar *)salt->str, salt->len);
 	g_hmac_get_digest(hmac, result, &digest_len);
 	g_hmac_unref(hmac);
@@ -81,7 +85,7 @@ guchar *jabber_scram_hi(const JabberScramHash *hash, const GString *str,
 	/* Compute U1...Ui */
 	for (i = 1; i < iterations; ++i) {
 		guint j;
-		hmac = g_hmac_new(hash->type, (guchar *)str->str, str->len);
+		hmac = g_hmac_copy(base);
 		g_hmac_update(hmac, prev, digest_len);
 		g_hmac_get_digest(hmac, tmp, &digest_len);
 		g_hmac_unref(hmac);
@@ -92,6 +96,9 @@ guchar *jabber_scram_hi(const JabberScramHash *hash, const GString *str,
 		memcpy(prev, tmp, digest_len);
 	}
 
+	g_hmac_unref(base);
+	memset(tmp, 0, digest_len);
+	memset(prev, 0, digest_len);
 	g_free(tmp);
 	g_free(prev);
 	return result;
@@ -131,22 +138,14 @@ jabber_scram_hash(const JabberScramHash *hash, guchar *out, const guchar *data)
 }
 
 gboolean
-jabber_scram_calc_proofs(JabberScramData *data, GString *salt, guint iterations)
+jabber_scram_derive_keys(const JabberScramHash *hash, const gchar *password,
+                         GString *salt, guint iterations,
+                         guchar *client_key, guchar *server_key)
 {
-	guint hash_len = g_checksum_type_get_length(data->hash->type);
-	guint i;
-
-	GString *pass = g_string_new(data->password);
-
+	GString *pass = g_string_new(password);
 	guchar *salted_password;
-	guchar *client_key, *stored_key, *client_signature, *server_key;
 
-	data->client_proof = g_string_sized_new(hash_len);
-	data->client_proof->len = hash_len;
-	data->server_signature = g_string_sized_new(hash_len);
-	data->server_signature->len = hash_len;
-
-	salted_password = jabber_scram_hi(data->hash, pass, salt, iterations);
+	salted_password = jabber_scram_hi(hash, pass, salt, iterations);
 
 	memset(pass->str, 0, pass->allocated_len);
 	g_string_free(pass, TRUE);
@@ -154,17 +153,35 @@ jabber_scram_calc_proofs(JabberScramData *data, GString *salt, guint iterations)
 	if (!salted_password)
 		return FALSE;
 
-	client_key = g_new0(guchar, hash_len);
-	stored_key = g_new0(guchar, hash_len);
-	client_signature = g_new0(guchar, hash_len);
-	server_key = g_new0(guchar, hash_len);
-
 	/* client_key = HMAC(salted_password, "Client Key") */
-	jabber_scram_hmac(data->hash, client_key, salted_password, "Client Key");
+	jabber_scram_hmac(hash, client_key, salted_password, "Client Key");
 	/* server_key = HMAC(salted_password, "Server Key") */
-	jabber_scram_hmac(data->hash, server_key, salted_password, "Server Key");
+	jabber_scram_hmac(hash, server_key, salted_password, "Server Key");
+
+	memset(salted_password, 0, g_checksum_type_get_length(hash->type));
 	g_free(salted_password);
 
+	return TRUE;
+}
+
+void
+jabber_scram_calc_proofs_from_keys(JabberScramData *data,
+                                   const guchar *client_key,
+                                   const guchar *server_key)
+{
+	guint hash_len = g_checksum_type_get_length(data->hash->type);
+	guint i;
+
+	guchar *stored_key, *client_signature;
+
+	data->client_proof = g_string_sized_new(hash_len);
+	data->client_proof->len = hash_len;
+	data->server_signature = g_string_sized_new(hash_len);
+	data->server_signature->len = hash_len;
+
+	stored_key = g_new0(guchar, hash_len);
+	client_signature = g_new0(guchar, hash_len);
+
 	/* stored_key = HASH(client_key) */
 	jabber_scram_hash(data->hash, stored_key, client_key);
 
@@ -177,12 +194,31 @@ jabber_scram_calc_proofs(JabberScramData *data, GString *salt, guint iterations)
 	for (i = 0; i < hash_len; ++i)
 		data->client_proof->str[i] = client_key[i] ^ client_signature[i];
 
-	g_free(server_key);
 	g_free(client_signature);
 	g_free(stored_key);
+}
+
+gboolean
+jabber_scram_calc_proofs(JabberScramData *data, GString *salt, guint iterations)
+{
+	guint hash_len = g_checksum_type_get_length(data->hash->type);
+	guchar *client_key, *server_key;
+	gboolean ret;
+
+	client_key = g_new0(guchar, hash_len);
+	server_key = g_new0(guchar, hash_len);
+
+	ret = jabber_scram_derive_keys(data->hash, data->password, salt,
+	                               iterations, client_key, server_key);
+	if (ret)
+		jabber_scram_calc_proofs_from_keys(data, client_key, server_key);
+
+	memset(client_key, 0, hash_len);
+	memset(server_key, 0, hash_len);
+	g_free(server_key);
 	g_free(client_key);
 
-	return TRUE;
+	return ret;
 }
 
 static gboolean
@@ -273,6 +309,44 @@ parse_server_step2(G_GNUC_UNUSED JabberScramData *data, const char *challenge,
 	return TRUE;
 }
 
+/*
+ * Parses the server-first-message and finishes the AuthMessage with the
+ * client-final-message-without-proof.
+ */
+static gboolean
+read_server_step1(JabberScramData *data, const char *challenge,
+                  gchar **out_nonce, GString **out_salt, guint *out_iterations)
+{
+	if (!parse_server_step1(data, challenge, out_nonce, out_salt,
+	                        out_iterations))
+	{
+		return FALSE;
+	}
+
+	g_string_append_c(data->auth_message, ',');
+
+	/* "biws" is the base64 encoding of "n,,". I promise. */
+	g_string_append_printf(data->auth_message, "c=%s,r=%s", "biws",
+	                       *out_nonce);
+#ifdef CHANNEL_BINDING
+#error fix this
+#endif
+
+	return TRUE;
+}
+
+static gchar *
+client_final_message(JabberScramData *data, const gchar *nonce)
+{
+	gchar *proof, *ret;
+
+	proof = g_base64_encode((guchar *)data->client_proof->str, data->client_proof->len);
+	ret = g_strdup_printf("c=%s,r=%s,p=%s", "biws", nonce, proof);
+	g_free(proof);
+
+	return ret;
+}
+
 gboolean
 jabber_scram_feed_parser(JabberScramData *data, gchar *in, gchar **out)
 {
@@ -284,22 +358,14 @@ jabber_scram_feed_parser(JabberScramData *data, gchar *in, gchar **out)
 	g_string_append(data->auth_message, in);
 
 	if (data->step == 1) {
-		gchar *nonce, *proof;
+		gchar *nonce;
 		GString *salt;
 		guint iterations;
 
-		ret = parse_server_step1(data, in, &nonce, &salt, &iterations);
+		ret = read_server_step1(data, in, &nonce, &salt, &iterations);
 		if (!ret)
 			return FALSE;
 
-		g_string_append_c(data->auth_message, ',');
-
-		/* "biws" is the base64 encoding of "n,,". I promise. */
-		g_string_append_printf(data->auth_message, "c=%s,r=%s", "biws", nonce);
-#ifdef CHANNEL_BINDING
-#error fix this
-#endif
-
 		ret = jabber_scram_calc_proofs(data, salt, iterations);
 
 		g_string_free(salt, TRUE);
@@ -309,10 +375,8 @@ jabber_scram_feed_parser(JabberScramData *data, gchar *in, gchar **out)
 			return FALSE;
 		}
 
-		proof = g_base64_encode((guchar *)data->client_proof->str, data->client_proof->len);
-		*out = g_strdup_printf("c=%s,r=%s,p=%s", "biws", nonce, proof);
+		*out = client_final_message(data, nonce);
 		g_free(nonce);
-		g_free(proof);
 	} else if (data->step == 2) {
 		gchar *server_sig, *enc_server_sig;
 		gsize len;
@@ -354,6 +418,305 @@ static gchar *escape_username(const gchar *in)
 	return tmp2;
 }
 
+/******************************************************************************
+ * Derived key cache
+ *****************************************************************************/
+/*
+ * RFC 5802 lets a client keep ClientKey and ServerKey around instead of
+ * running Hi() again, as long as the salt and iteration count the server
+ * sends are unchanged.  Entries are keyed by bare JID and remember a digest
+ * of the password they were derived from so that a password change is
+ * treated as a miss.
+ */
+typedef struct {
+	GChecksumType type;
+	GBytes *salt;
+	guint iterations;
+	gchar *password_digest;
+	guchar *client_key;
+	guchar *server_key;
+} JabberScramCachedKeys;
+
+static GHashTable *cached_keys = NULL;
+
+static void
+jabber_scram_cached_keys_free(gpointer data)
+{
+	JabberScramCachedKeys *keys = data;
+	gsize len = g_checksum_type_get_length(keys->type);
+
+	g_bytes_unref(keys->salt);
+	g_free(keys->password_digest);
+	memset(keys->client_key, 0, len);
+	g_free(keys->client_key);
+	memset(keys->server_key, 0, len);
+	g_free(keys->server_key);
+	g_free(keys);
+}
+
+static gchar *
+jabber_scram_password_digest(const gchar *password)
+{
+	return g_compute_checksum_for_string(G_CHECKSUM_SHA256, password, -1);
+}
+
+gboolean
+jabber_scram_lookup_keys(const gchar *jid, const JabberScramHash *hash,
+                         const gchar *password, GString *salt,
+                         guint iterations, guchar *client_key,
+                         guchar *server_key)
+{
+	JabberScramCachedKeys *keys = NULL;
+	gsize len = g_checksum_type_get_length(hash->type);
+	gchar *digest = NULL;
+	gboolean match = FALSE;
+
+	if (cached_keys == NULL || jid == NULL)
+		return FALSE;
+
+	keys = g_hash_table_lookup(cached_keys, jid);
+	if (keys == NULL)
+		return FALSE;
+
+	if (keys->type == hash->type && keys->iterations == iterations &&
+	    g_bytes_get_size(keys->salt) == salt->len &&
+	    memcmp(g_bytes_get_data(keys->salt, NULL), salt->str, salt->len) == 0)
+	{
+		digest = jabber_scram_password_digest(password);
+		match = purple_strequal(digest, keys->password_digest);
+		g_free(digest);
+	}
+
+	if (!match) {
+		g_hash_table_remove(cached_keys, jid);
+		return FALSE;
+	}
+
+	memcpy(client_key, keys->client_key, len);
+	memcpy(server_key, keys->server_key, len);
+
+	return TRUE;
+}
+
+void
+jabber_scram_store_keys(const gchar *jid, const JabberScramHash *hash,
+                        const gchar *password, GString *salt,
+                        guint iterations, const guchar *client_key,
+                        const guchar *server_key)
+{
+	JabberScramCachedKeys *keys = NULL;
+	gsize len = g_checksum_type_get_length(hash->type);
+
+	if (jid == NULL)
+		return;
+
+	if (cached_keys == NULL) {
+		cached_keys = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+		                                    jabber_scram_cached_keys_free);
+	}
+
+	keys = g_new0(JabberScramCachedKeys, 1);
+	keys->type = hash->type;
+	keys->salt = g_bytes_new(salt->str, salt->len);
+	keys->iterations = iterations;
+	keys->password_digest = jabber_scram_password_digest(password);
+	keys->client_key = g_memdup2(client_key, len);
+	keys->server_key = g_memdup2(server_key, len);
+
+	g_hash_table_insert(cached_keys, g_strdup(jid), keys);
+}
+
+void
+jabber_auth_scram_uninit(void)
+{
+	g_clear_pointer(&cached_keys, g_hash_table_destroy);
+}
+
+/******************************************************************************
+ * Off-thread key derivation
+ *****************************************************************************/
+typedef struct {
+	const JabberScramHash *hash;
+	gchar *password;
+	GString *salt;
+	guint iterations;
+	gchar *nonce;
+	gchar *jid;
+
+	guchar *client_key;
+	guchar *server_key;
+} JabberScramDerivation;
+
+static void
+jabber_scram_derivation_free(gpointer data)
+{
+	JabberScramDerivation *derivation = data;
+	gsize len = g_checksum_type_get_length(derivation->hash->type);
+
+	memset(derivation->password, 0, strlen(derivation->password));
+	g_free(derivation->password);
+	g_string_free(derivation->salt, TRUE);
+	g_free(derivation->nonce);
+	g_free(derivation->jid);
+	memset(derivation->client_key, 0, len);
+	g_free(derivation->client_key);
+	memset(derivation->server_key, 0, len);
+	g_free(derivation->server_key);
+	g_free(derivation);
+}
+
+static void
+jabber_scram_derive_keys_thread(GTask *task,
+                                G_GNUC_UNUSED gpointer source_object,
+                                gpointer task_data,
+                                G_GNUC_UNUSED GCancellable *cancellable)
+{
+	JabberScramDerivation *derivation = task_data;
+	GString *salt = NULL;
+	gboolean ret;
+
+	/* Hi() appends INT(1) to the salt, so keep the original for the cache. */
+	salt = g_string_new_len(derivation->salt->str, derivation->salt->len);
+	ret = jabber_scram_derive_keys(derivation->hash, derivation->password,
+	                               salt, derivation->iterations,
+	                               derivation->client_key,
+	                               derivation->server_key);
+	g_string_free(salt, TRUE);
+
+	if (!ret) {
+		g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_FAILED,
+		                        "failed to derive the SCRAM keys");
+		return;
+	}
+
+	g_task_return_boolean(task, TRUE);
+}
+
+static PurpleXmlNode *
+scram_response(const gchar *dec_out)
+{
+	PurpleXmlNode *reply = purple_xmlnode_new("response");
+
+	purple_xmlnode_set_namespace(reply, NS_XMPP_SASL);
+
+	purple_debug_misc("jabber", "decoded response: %s\n", dec_out ? dec_out : "(null)");
+	if (dec_out) {
+		gchar *enc_out = g_base64_encode((guchar *)dec_out, strlen(dec_out));
+		purple_xmlnode_insert_data(reply, enc_out, -1);
+		g_free(enc_out);
+	}
+
+	return reply;
+}
+
+static void
+jabber_scram_derive_keys_cb(G_GNUC_UNUSED GObject *source,
+                            GAsyncResult *result, gpointer user_data)
+{
+	JabberStream *js = user_data;
+	JabberScramData *data = NULL;
+	JabberScramDerivation *derivation = NULL;
+	PurpleXmlNode *reply = NULL;
+	GError *error = NULL;
+	gchar *dec_out = NULL;
+
+	if (!g_task_propagate_boolean(G_TASK(result), &error)) {
+		/* If we were cancelled the stream is already gone. */
+		if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+			purple_connection_error(js->gc,
+				PURPLE_CONNECTION_ERROR_AUTHENTICATION_IMPOSSIBLE,
+				_("Invalid challenge from server"));
+		}
+		g_error_free(error);
+		return;
+	}
+
+	data = js->auth_mech_data;
+	derivation = g_task_get_task_data(G_TASK(result));
+
+	jabber_scram_store_keys(derivation->jid, derivation->hash,
+	                        derivation->password, derivation->salt,
+	                        derivation->iterations, derivation->client_key,
+	                        derivation->server_key);
+
+	jabber_scram_calc_proofs_from_keys(data, derivation->client_key,
+	                                   derivation->server_key);
+	dec_out = client_final_message(data, derivation->nonce);
+
+	data->step += 1;
+
+	reply = scram_response(dec_out);
+	jabber_send(js, reply);
+	purple_xmlnode_free(reply);
+	g_free(dec_out);
+}
+
+/*
+ * Handles the server-first-message.  If ClientKey and ServerKey are cached
+ * the client-final-message is returned in @out right away.  Otherwise @out is
+ * set to %NULL and Hi() runs on a worker thread; the response is sent from
+ * jabber_scram_derive_keys_cb() once it finishes.
+ */
+static gboolean
+scram_handle_step1(JabberStream *js, JabberScramData *data, gchar *in,
+                   gchar **out)
+{
+	JabberScramDerivation *derivation = NULL;
+	GTask *task = NULL;
+	GString *salt = NULL;
+	gchar *nonce = NULL, *jid = NULL;
+	guint iterations;
+	gsize len;
+
+	g_string_append_c(data->auth_message, ',');
+	g_string_append(data->auth_message, in);
+
+	if (!read_server_step1(data, in, &nonce, &salt, &iterations))
+		return FALSE;
+
+	jid = jabber_id_get_bare_jid(js->user);
+	len = g_checksum_type_get_length(data->hash->type);
+
+	derivation = g_new0(JabberScramDerivation, 1);
+	derivation->hash = data->hash;
+	derivation->password = g_strdup(data->password);
+	derivation->salt = salt;
+	derivation->iterations = iterations;
+	derivation->nonce = nonce;
+	derivation->jid = jid;
+	derivation->client_key = g_new0(guchar, len);
+	derivation->server_key = g_new0(guchar, len);
+
+	if (jabber_scram_lookup_keys(jid, data->hash, data->password, salt,
+	                             iterations, derivation->client_key,
+	                             derivation->server_key))
+	{
+		purple_debug_info("jabber", "SCRAM: using cached keys\n");
+
+		jabber_scram_calc_proofs_from_keys(data, derivation->client_key,
+		                                   derivation->server_key);
+		*out = client_final_message(data, nonce);
+
+		jabber_scram_derivation_free(derivation);
+
+		return TRUE;
+	}
+
+	if (data->cancellable == NULL)
+		data->cancellable = g_cancellable_new();
+
+	task = g_task_new(NULL, data->cancellable, jabber_scram_derive_keys_cb,
+	                  js);
+	g_task_set_source_tag(task, scram_handle_step1);
+	g_task_set_task_data(task, derivation, jabber_scram_derivation_free);
+	g_task_run_in_thread(task, jabber_scram_derive_keys_thread);
+	g_object_unref(task);
+
+	*out = NULL;
+
+	return TRUE;
+}
+
 static JabberSaslState
 scram_start(JabberStream *js, G_GNUC_UNUSED PurpleXmlNode *mechanisms,
             PurpleXmlNode **out, char **error)
@@ -427,8 +790,9 @@ scram_handle_challenge(JabberStream *js, PurpleXmlNode *challenge, PurpleXmlNode
 	JabberScramData *data = js->auth_mech_data;
 	PurpleXmlNode *reply;
 	gchar *enc_in, *dec_in = NULL;
-	gchar *enc_out = NULL, *dec_out = NULL;
+	gchar *dec_out = NULL;
 	gsize len;
+	gboolean ret;
 	JabberSaslState state = JABBER_SASL_STATE_FAIL;
 
 	enc_in = purple_xmlnode_get_data(challenge);
@@ -452,7 +816,13 @@ scram_handle_challenge(JabberStream *js, PurpleXmlNode *challenge, PurpleXmlNode
 
 	purple_debug_misc("jabber", "decoded challenge: %s\n", dec_in);
 
-	if (!jabber_scram_feed_parser(data, dec_in, &dec_out)) {
+	if (data->step == 1) {
+		ret = scram_handle_step1(js, data, dec_in, &dec_out);
+	} else {
+		ret = jabber_scram_feed_parser(data, dec_in, &dec_out);
+	}
+
+	if (!ret) {
 		reply = purple_xmlnode_new("abort");
 		purple_xmlnode_set_namespace(reply, NS_XMPP_SASL);
 		data->step = -1;
@@ -460,23 +830,21 @@ scram_handle_challenge(JabberStream *js, PurpleXmlNode *challenge, PurpleXmlNode
 		goto out;
 	}
 
-	data->step += 1;
-
-	reply = purple_xmlnode_new("response");
-	purple_xmlnode_set_namespace(reply, NS_XMPP_SASL);
+	state = JABBER_SASL_STATE_CONTINUE;
 
-	purple_debug_misc("jabber", "decoded response: %s\n", dec_out ? dec_out : "(null)");
-	if (dec_out) {
-		enc_out = g_base64_encode((guchar *)dec_out, strlen(dec_out));
-		purple_xmlnode_insert_data(reply, enc_out, -1);
+	if (data->step == 1 && dec_out == NULL) {
+		/* The keys are being derived off the main thread. */
+		reply = NULL;
+		goto out;
 	}
 
-	state = JABBER_SASL_STATE_CONTINUE;
+	data->step += 1;
+
+	reply = scram_response(dec_out);
 
 out:
 	g_free(enc_in);
 	g_free(dec_in);
-	g_free(enc_out);
 	g_free(dec_out);
 
 	*out = reply;
@@ -538,6 +906,10 @@ scram_handle_success(JabberStream *js, PurpleXmlNode *packet, char **error)
 
 void jabber_scram_data_destroy(JabberScramData *data)
 {
+	if (data->cancellable) {
+		g_cancellable_cancel(data->cancellable);
+		g_object_unref(data->cancellable);
+	}
 	g_free(data->cnonce);
 	if (data->auth_message)
 		g_string_free(data->auth_message, TRUE);
@@ -49,6 +49,8 @@ typedef struct {
 	gchar *password;
 	gboolean channel_binding;
 	int step;
+
+	GCancellable *cancellable;
 } JabberScramData;
 
 #include "auth.h"
@@ -68,6 +70,39 @@ typedef struct {
 guchar *jabber_scram_hi(const JabberScramHash *hash, const GString *str,
                         GString *salt, guint iterations);
 
+/**
+ * Derives ClientKey and ServerKey from the password as described in Section 3
+ * of the SASL-SCRAM I-D.  This is the expensive part of the exchange and is
+ * safe to call from a worker thread.
+ *
+ * @param hash       The struct corresponding to the hash function to be used.
+ * @param password   The SASLprep'd password.
+ * @param salt       The salt (as specified by the server). INT(1) is appended
+ *                   to it.
+ * @param iterations The number of iterations to perform.
+ * @param client_key Output buffer for ClientKey, the length of the hash.
+ * @param server_key Output buffer for ServerKey, the length of the hash.
+ *
+ * @returns TRUE if the keys were successfully derived. FALSE otherwise.
+ */
+gboolean jabber_scram_derive_keys(const JabberScramHash *hash,
+                                  const gchar *password, GString *salt,
+                                  guint iterations, guchar *client_key,
+                                  guchar *server_key);
+
+/**
+ * Calculates the proofs from already derived keys.
+ *
+ * @param data       A JabberScramData structure. hash and auth_message must
+ *                   be set. client_proof and server_signature will be set as
+ *                   a result of this function.
+ * @param client_key ClientKey, as returned by jabber_scram_derive_keys().
+ * @param server_key ServerKey, as returned by jabber_scram_derive_keys().
+ */
+void jabber_scram_calc_proofs_from_keys(JabberScramData *data,
+                                        const guchar *client_key,
+                                        const guchar *server_key);
+
 /**
  * Calculates the proofs as described in Section 3 of the SASL-SCRAM I-D.
  *
@@ -82,6 +117,38 @@ guchar *jabber_scram_hi(const JabberScramHash *hash, const GString *str,
 gboolean jabber_scram_calc_proofs(JabberScramData *data, GString *salt,
                                   guint iterations);
 
+/**
+ * Looks up the ClientKey and ServerKey last derived for a bare JID.  RFC 5802
+ * lets them be reused as long as the server sends the same salt and iteration
+ * count.  An entry derived with a different hash, password, salt or iteration
+ * count is dropped.
+ *
+ * @param jid        The bare JID the keys were derived for.
+ * @param hash       The struct corresponding to the hash function in use.
+ * @param password   The SASLprep'd password.
+ * @param salt       The salt (as specified by the server).
+ * @param iterations The iteration count (as specified by the server).
+ * @param client_key Output buffer for ClientKey, the length of the hash.
+ * @param server_key Output buffer for ServerKey, the length of the hash.
+ *
+ * @returns TRUE if the keys were found and copied out. FALSE otherwise.
+ */
+gboolean jabber_scram_lookup_keys(const gchar *jid,
+                                  const JabberScramHash *hash,
+                                  const gchar *password, GString *salt,
+                                  guint iterations, guchar *client_key,
+                                  guchar *server_key);
+
+/**
+ * Remembers the ClientKey and ServerKey derived for a bare JID, replacing
+ * any that were there before.  The arguments are as for
+ * jabber_scram_lookup_keys().
+ */
+void jabber_scram_store_keys(const gchar *jid, const JabberScramHash *hash,
+                             const gchar *password, GString *salt,
+                             guint iterations, const guchar *client_key,
+                             const guchar *server_key);
+
 /**
  * Feed the algorithm with the data from the server.
  */
@@ -33,15 +33,34 @@ TODO: test, what happens, if the http server (BOSH server) doesn't support
 keep-alive (sends connection: close).
 */
 
-#define JABBER_BOSH_SEND_DELAY 250
-
 #define JABBER_BOSH_TIMEOUT 10
 
+/* We never keep more requests than this open, whatever the connection
+ * manager allows. */
+#define JABBER_BOSH_MAX_REQUESTS 4
+
+/* Times a request is retransmitted with the same rid before giving up. */
+#define JABBER_BOSH_MAX_RETRIES 3
+
 static gchar *jabber_bosh_useragent = NULL;
 
+typedef struct {
+	PurpleJabberBOSHConnection *conn;
+
+	guint64 rid;
+	GBytes *body;
+	SoupMessage *msg;
+	guint retries;
+
+	/* Set once the response arrived, until every older rid has been
+	 * processed too. */
+	PurpleXmlNode *response;
+} JabberBOSHRequest;
+
 struct _PurpleJabberBOSHConnection {
 	JabberStream *js;
 	SoupSession *payload_reqs;
+	GCancellable *cancellable;
 
 	gchar *url;
 	gboolean is_ssl;
@@ -50,16 +69,26 @@ struct _PurpleJabberBOSHConnection {
 	gchar *sid;
 	guint64 rid; /* Must be big enough to hold 2^53 - 1 */
 
+	/* XEP-0124 section 7.1, how many requests the connection manager lets
+	 * us have open at once and how many of those it may hold on to. */
+	guint requests;
+	guint hold;
+
+	/* The JabberBOSHRequests we're waiting on, oldest rid first. */
+	GQueue *in_flight;
+
 	GString *send_buff;
-	guint send_timer;
+	guint send_source;
 };
 
 static SoupMessage *jabber_bosh_connection_http_request_new(
-        PurpleJabberBOSHConnection *conn, const GString *data);
+        PurpleJabberBOSHConnection *conn, GBytes *body);
 static void
 jabber_bosh_connection_session_create(PurpleJabberBOSHConnection *conn);
 static void
 jabber_bosh_connection_send_now(PurpleJabberBOSHConnection *conn);
+static void
+jabber_bosh_connection_flush(PurpleJabberBOSHConnection *conn);
 
 void
 jabber_bosh_init(void)
@@ -88,6 +117,15 @@ void jabber_bosh_uninit(void)
 	jabber_bosh_useragent = NULL;
 }
 
+static void
+jabber_bosh_request_free(JabberBOSHRequest *req)
+{
+	g_clear_pointer(&req->body, g_bytes_unref);
+	g_clear_object(&req->msg);
+	g_clear_pointer(&req->response, purple_xmlnode_free);
+	g_free(req);
+}
+
 PurpleJabberBOSHConnection*
 jabber_bosh_connection_new(JabberStream *js, const gchar *url)
 {
@@ -116,15 +154,24 @@ jabber_bosh_connection_new(JabberStream *js, const gchar *url)
 	}
 
 	conn = g_new0(PurpleJabberBOSHConnection, 1);
+	/* Held requests would tie up the connections the HTTP service shares
+	 * between accounts, so BOSH keeps a session of its own. */
 	conn->payload_reqs = soup_session_new_with_options(
 	        "proxy-resolver", resolver,
 	        "timeout", JABBER_BOSH_TIMEOUT + 2,
 	        "user-agent", jabber_bosh_useragent,
+	        "max-conns-per-host", JABBER_BOSH_MAX_REQUESTS + 1,
 	        NULL);
+	conn->cancellable = g_cancellable_new();
 	conn->url = g_strdup(url);
 	conn->js = js;
 	conn->is_ssl = g_str_equal(scheme, "https");
 	conn->send_buff = g_string_new(NULL);
+	conn->in_flight = g_queue_new();
+
+	/* What a connection manager that doesn't tell us has to support. */
+	conn->requests = 2;
+	conn->hold = 1;
 
 	/*
 	 * Random 64-bit integer masked off by 2^52 - 1.
@@ -156,12 +203,25 @@ jabber_bosh_connection_destroy(PurpleJabberBOSHConnection *conn)
 		jabber_bosh_connection_send_now(conn);
 	}
 
-	if (conn->send_timer)
-		g_source_remove(conn->send_timer);
+	g_clear_handle_id(&conn->send_source, g_source_remove);
+
+	/* Requests still on the wire free themselves when they see they were
+	 * cancelled, only the ones waiting on an older rid are ours to free. */
+	g_cancellable_cancel(conn->cancellable);
+	for (GList *l = conn->in_flight->head; l != NULL; l = l->next) {
+		JabberBOSHRequest *req = l->data;
+
+		if (req->response != NULL) {
+			jabber_bosh_request_free(req);
+		}
+	}
+	g_queue_free(conn->in_flight);
+	conn->in_flight = NULL;
 
 	soup_session_abort(conn->payload_reqs);
 
 	g_clear_object(&conn->payload_reqs);
+	g_clear_object(&conn->cancellable);
 	g_string_free(conn->send_buff, TRUE);
 	conn->send_buff = NULL;
 
@@ -211,6 +271,15 @@ jabber_bosh_connection_parse(PurpleJabberBOSHConnection *conn,
 
 	body = g_bytes_get_data(response_body, &length);
 	root = purple_xmlnode_from_str(body, length);
+	if (root == NULL) {
+		/* Later responses can't be handled without this one, so there's
+		 * no way to carry on. */
+		purple_connection_error(conn->js->gc,
+			PURPLE_CONNECTION_ERROR_NETWORK_ERROR,
+			_("Unable to parse the response from the BOSH connection "
+			"manager."));
+		return NULL;
+	}
 
 	type = purple_xmlnode_get_attrib(root, "type");
 	if (purple_strequal(type, "terminate")) {
@@ -224,19 +293,78 @@ jabber_bosh_connection_parse(PurpleJabberBOSHConnection *conn,
 	return root;
 }
 
+static void
+jabber_bosh_connection_process(PurpleJabberBOSHConnection *conn,
+                               PurpleXmlNode *node)
+{
+	PurpleXmlNode *child = node->child;
+
+	while (child != NULL) {
+		/* jabber_process_packet might free child */
+		PurpleXmlNode *next = child->next;
+		const gchar *xmlns;
+
+		if (child->type != PURPLE_XMLNODE_TYPE_TAG) {
+			child = next;
+			continue;
+		}
+
+		/* Workaround for non-compliant servers that don't stamp
+		 * the right xmlns on these packets. See #11315.
+		 */
+		xmlns = purple_xmlnode_get_namespace(child);
+		if ((xmlns == NULL || purple_strequal(xmlns, NS_BOSH)) &&
+			(purple_strequal(child->name, "iq") ||
+			purple_strequal(child->name, "message") ||
+			purple_strequal(child->name, "presence")))
+		{
+			purple_xmlnode_set_namespace(child, NS_XMPP_CLIENT);
+		}
+
+		jabber_process_packet(conn->js, &child);
+
+		child = next;
+	}
+}
+
+static void jabber_bosh_request_send(JabberBOSHRequest *req);
+
 static void
 jabber_bosh_connection_recv(GObject *source, GAsyncResult *result,
                             gpointer data)
 {
-	SoupMessage *msg = data;
+	JabberBOSHRequest *req = data;
 	PurpleJabberBOSHConnection *bosh_conn = NULL;
 	GBytes *response_body = NULL;
 	GError *error = NULL;
-	PurpleXmlNode *node, *child;
+	PurpleXmlNode *node;
 
 	response_body = soup_session_send_and_read_finish(SOUP_SESSION(source),
 	                                                  result, &error);
-	bosh_conn = g_object_get_data(G_OBJECT(msg), "bosh-connection");
+
+	/* The connection is already gone. */
+	if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		g_error_free(error);
+		jabber_bosh_request_free(req);
+		return;
+	}
+
+	bosh_conn = req->conn;
+
+	/* XEP-0124 section 14.3, a request that never made it gets sent again
+	 * as is, so the connection manager can tell it apart from a new one. */
+	if (error != NULL && req->retries < JABBER_BOSH_MAX_RETRIES &&
+	    !bosh_conn->is_terminating)
+	{
+		req->retries++;
+		purple_debug_info("jabber-bosh",
+		                  "Retransmitting rid %" G_GUINT64_FORMAT
+		                  " (attempt %u): %s", req->rid, req->retries,
+		                  error->message);
+		g_error_free(error);
+		jabber_bosh_request_send(req);
+		return;
+	}
 
 	if (response_body != NULL && purple_debug_is_verbose() &&
 	    purple_debug_is_unsafe())
@@ -248,58 +376,61 @@ jabber_bosh_connection_recv(GObject *source, GAsyncResult *result,
 		purple_debug_misc("jabber-bosh", "received: %.*s", (int)length, body);
 	}
 
-	node = jabber_bosh_connection_parse(bosh_conn, msg, response_body, error);
+	node = jabber_bosh_connection_parse(bosh_conn, req->msg, response_body,
+	                                    error);
 	g_clear_pointer(&response_body, g_bytes_unref);
 	g_clear_error(&error);
-	g_clear_object(&msg);
 
+	/* Every path that gets here without a node has either raised a
+	 * connection error or is tearing the connection down already. */
 	if (node == NULL) {
+		g_queue_remove(bosh_conn->in_flight, req);
+		jabber_bosh_request_free(req);
 		return;
 	}
 
-	child = node->child;
-	while (child != NULL) {
-		/* jabber_process_packet might free child */
-		PurpleXmlNode *next = child->next;
-		const gchar *xmlns;
+	req->response = node;
 
-		if (child->type != PURPLE_XMLNODE_TYPE_TAG) {
-			child = next;
-			continue;
-		}
+	/* Responses can come back in any order when several requests are open,
+	 * but their stanzas have to be handled in rid order. */
+	while (!g_queue_is_empty(bosh_conn->in_flight)) {
+		JabberBOSHRequest *head = g_queue_peek_head(bosh_conn->in_flight);
 
-		/* Workaround for non-compliant servers that don't stamp
-		 * the right xmlns on these packets. See #11315.
-		 */
-		xmlns = purple_xmlnode_get_namespace(child);
-		if ((xmlns == NULL || purple_strequal(xmlns, NS_BOSH)) &&
-			(purple_strequal(child->name, "iq") ||
-			purple_strequal(child->name, "message") ||
-			purple_strequal(child->name, "presence")))
-		{
-			purple_xmlnode_set_namespace(child, NS_XMPP_CLIENT);
+		if (head->response == NULL) {
+			break;
 		}
 
-		jabber_process_packet(bosh_conn->js, &child);
-
-		child = next;
+		g_queue_pop_head(bosh_conn->in_flight);
+		jabber_bosh_connection_process(bosh_conn, head->response);
+		jabber_bosh_request_free(head);
 	}
 
-	jabber_bosh_connection_send(bosh_conn, NULL);
+	jabber_bosh_connection_flush(bosh_conn);
+}
+
+static void
+jabber_bosh_request_send(JabberBOSHRequest *req)
+{
+	PurpleJabberBOSHConnection *conn = req->conn;
+
+	g_clear_object(&req->msg);
+	req->msg = jabber_bosh_connection_http_request_new(conn, req->body);
+
+	soup_session_send_and_read_async(conn->payload_reqs, req->msg,
+	                                 G_PRIORITY_DEFAULT, conn->cancellable,
+	                                 jabber_bosh_connection_recv, req);
 }
 
 static void
 jabber_bosh_connection_send_now(PurpleJabberBOSHConnection *conn)
 {
-	SoupMessage *req;
+	JabberBOSHRequest *req;
 	GString *data;
+	gsize len;
 
 	g_return_if_fail(conn != NULL);
 
-	if (conn->send_timer != 0) {
-		g_source_remove(conn->send_timer);
-		conn->send_timer = 0;
-	}
+	g_clear_handle_id(&conn->send_source, g_source_remove);
 
 	if (conn->sid == NULL)
 		return;
@@ -330,35 +461,67 @@ jabber_bosh_connection_send_now(PurpleJabberBOSHConnection *conn)
 	if (purple_debug_is_verbose() && purple_debug_is_unsafe())
 		purple_debug_misc("jabber-bosh", "sending: %s\n", data->str);
 
-	req = jabber_bosh_connection_http_request_new(conn, data);
-	g_string_free(data, FALSE);
+	len = data->len;
+	req = g_new0(JabberBOSHRequest, 1);
+	req->conn = conn;
+	req->rid = conn->rid;
+	req->body = g_bytes_new_take(g_string_free(data, FALSE), len);
 
 	if (conn->is_terminating) {
+		SoupMessage *msg = jabber_bosh_connection_http_request_new(conn,
+		                                                           req->body);
+
 #if SOUP_MAJOR_VERSION >= 3
-		soup_session_send_async(conn->payload_reqs, req, G_PRIORITY_DEFAULT,
+		soup_session_send_async(conn->payload_reqs, msg, G_PRIORITY_DEFAULT,
 		                        NULL, NULL, NULL);
 #else
-		soup_session_send_async(conn->payload_reqs, req, NULL, NULL, NULL);
+		soup_session_send_async(conn->payload_reqs, msg, NULL, NULL, NULL);
 #endif
+		g_object_unref(msg);
+		jabber_bosh_request_free(req);
 		g_free(conn->sid);
 		conn->sid = NULL;
 	} else {
-		g_object_set_data(G_OBJECT(req), "bosh-connection", conn);
-		soup_session_send_and_read_async(conn->payload_reqs, req,
-		                                 G_PRIORITY_DEFAULT, NULL,
-		                                 jabber_bosh_connection_recv, req);
+		g_queue_push_tail(conn->in_flight, req);
+		jabber_bosh_request_send(req);
+	}
+}
+
+/* Sends whatever is waiting if the connection manager lets us open another
+ * request, and makes sure one is always left open for it to push stanzas
+ * down.
+ */
+static void
+jabber_bosh_connection_flush(PurpleJabberBOSHConnection *conn)
+{
+	guint open = 0;
+
+	g_clear_handle_id(&conn->send_source, g_source_remove);
+
+	if (conn->sid == NULL || conn->is_terminating)
+		return;
+
+	open = g_queue_get_length(conn->in_flight);
+
+	if (conn->send_buff->len > 0 || conn->js->reinit) {
+		/* Otherwise this goes out as soon as a response frees a slot. */
+		if (open < conn->requests) {
+			jabber_bosh_connection_send_now(conn);
+		}
+	} else if (open == 0) {
+		jabber_bosh_connection_send_now(conn);
 	}
 }
 
 static gboolean
-jabber_bosh_connection_send_delayed(gpointer _conn)
+jabber_bosh_connection_flush_cb(gpointer data)
 {
-	PurpleJabberBOSHConnection *conn = _conn;
+	PurpleJabberBOSHConnection *conn = data;
 
-	conn->send_timer = 0;
-	jabber_bosh_connection_send_now(conn);
+	conn->send_source = 0;
+	jabber_bosh_connection_flush(conn);
 
-	return FALSE;
+	return G_SOURCE_REMOVE;
 }
 
 void
@@ -370,10 +533,12 @@ jabber_bosh_connection_send(PurpleJabberBOSHConnection *conn,
 	if (data)
 		g_string_append(conn->send_buff, data);
 
-	if (conn->send_timer == 0) {
-		conn->send_timer = g_timeout_add(
-			JABBER_BOSH_SEND_DELAY,
-			jabber_bosh_connection_send_delayed, conn);
+	/* Stanzas sent from the same main loop iteration share a request, but
+	 * nothing waits any longer than that. */
+	if (conn->send_source == 0) {
+		conn->send_source = g_idle_add_full(G_PRIORITY_DEFAULT,
+		                                    jabber_bosh_connection_flush_cb,
+		                                    conn, NULL);
 	}
 }
 
@@ -382,6 +547,11 @@ jabber_bosh_connection_send_keepalive(PurpleJabberBOSHConnection *conn)
 {
 	g_return_if_fail(conn != NULL);
 
+	/* A request that is already open keeps the session alive. */
+	if (g_queue_get_length(conn->in_flight) >= conn->requests) {
+		return;
+	}
+
 	jabber_bosh_connection_send_now(conn);
 }
 
@@ -415,11 +585,16 @@ jabber_bosh_connection_session_created(GObject *source, GAsyncResult *result,
 	GBytes *response_body = NULL;
 	GError *error = NULL;
 	PurpleXmlNode *node, *features;
-	const gchar *sid, *ver, *inactivity_str;
+	const gchar *sid, *ver, *inactivity_str, *requests_str, *hold_str;
 	int inactivity = 0;
 
 	response_body = soup_session_send_and_read_finish(SOUP_SESSION(source),
 	                                                  result, &error);
+	if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		g_error_free(error);
+		g_object_unref(msg);
+		return;
+	}
 	bosh_conn = g_object_get_data(G_OBJECT(msg), "bosh-connection");
 
 	if (response_body != NULL && purple_debug_is_verbose() &&
@@ -445,7 +620,8 @@ jabber_bosh_connection_session_created(GObject *source, GAsyncResult *result,
 	sid = purple_xmlnode_get_attrib(node, "sid");
 	ver = purple_xmlnode_get_attrib(node, "ver");
 	inactivity_str = purple_xmlnode_get_attrib(node, "inactivity");
-	/* requests = purple_xmlnode_get_attrib(node, "requests"); */
+	requests_str = purple_xmlnode_get_attrib(node, "requests");
+	hold_str = purple_xmlnode_get_attrib(node, "hold");
 
 	if (!sid) {
 		purple_connection_error(bosh_conn->js->gc,
@@ -471,6 +647,18 @@ jabber_bosh_connection_session_created(GObject *source, GAsyncResult *result,
 
 	bosh_conn->sid = g_strdup(sid);
 
+	if (hold_str) {
+		bosh_conn->hold = CLAMP(atoi(hold_str), 0, JABBER_BOSH_MAX_REQUESTS - 1);
+	}
+	if (requests_str) {
+		/* We need one more than the server holds to be able to send at all. */
+		bosh_conn->requests = CLAMP(atoi(requests_str),
+		                            (gint)bosh_conn->hold + 1,
+		                            JABBER_BOSH_MAX_REQUESTS);
+	}
+	purple_debug_misc("jabber-bosh", "Using up to %u requests, %u held",
+	                  bosh_conn->requests, bosh_conn->hold);
+
 	if (inactivity_str)
 		inactivity = atoi(inactivity_str);
 	if (inactivity < 0 || inactivity > 3600) {
@@ -506,7 +694,9 @@ static void
 jabber_bosh_connection_session_create(PurpleJabberBOSHConnection *conn)
 {
 	SoupMessage *req;
+	GBytes *body;
 	GString *data;
+	gsize len;
 
 	purple_debug_misc("jabber-bosh", "Requesting Session Create for %p\n",
 		conn);
@@ -527,30 +717,29 @@ jabber_bosh_connection_session_create(PurpleJabberBOSHConnection *conn)
 		"/>",
 		++conn->rid, conn->js->user->domain, JABBER_BOSH_TIMEOUT);
 
-	req = jabber_bosh_connection_http_request_new(conn, data);
-	g_string_free(data, FALSE);
+	len = data->len;
+	body = g_bytes_new_take(g_string_free(data, FALSE), len);
+	req = jabber_bosh_connection_http_request_new(conn, body);
+	g_bytes_unref(body);
 
 	g_object_set_data(G_OBJECT(req), "bosh-connection", conn);
 	soup_session_send_and_read_async(conn->payload_reqs, req,
-	                                 G_PRIORITY_DEFAULT, NULL,
+	                                 G_PRIORITY_DEFAULT, conn->cancellable,
 	                                 jabber_bosh_connection_session_created,
 	                                 req);
 }
 
 static SoupMessage *
 jabber_bosh_connection_http_request_new(PurpleJabberBOSHConnection *conn,
-                                        const GString *data)
+                                        GBytes *body)
 {
 	SoupMessage *req;
-	GBytes *body = NULL;
 
 	jabber_stream_restart_inactivity_timer(conn->js);
 
 	req = soup_message_new("POST", conn->url);
-	body = g_bytes_new_take(data->str, data->len);
 	soup_message_set_request_body_from_bytes(req, "text/xml; charset=utf-8",
 	                                         body);
-	g_bytes_unref(body);
 
 	return req;
 }
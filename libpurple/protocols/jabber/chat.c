@@ -26,6 +26,7 @@
 
 #include "chat.h"
 #include "iq.h"
+#include "mam.h"
 #include "message.h"
 #include "presence.h"
 #include "xdata.h"
@@ -216,8 +217,7 @@ static void insert_in_hash_table(gpointer key, gpointer value, gpointer user_dat
 
 static JabberChat *
 jabber_chat_new(JabberStream *js, const char *room, const char *server,
-                const char *handle, G_GNUC_UNUSED const char *password,
-                GHashTable *data)
+                const char *handle, const char *password, GHashTable *data)
 {
 	JabberChat *chat;
 	char *jid;
@@ -240,7 +240,8 @@ jabber_chat_new(JabberStream *js, const char *room, const char *server,
 		g_hash_table_insert(chat->components, g_strdup("handle"), g_strdup(handle));
 		g_hash_table_insert(chat->components, g_strdup("room"), g_strdup(room));
 		g_hash_table_insert(chat->components, g_strdup("server"), g_strdup(server));
-		/* g_hash_table_insert(chat->components, g_strdup("password"), g_strdup(server)); */
+		if (password != NULL)
+			g_hash_table_insert(chat->components, g_strdup("password"), g_strdup(password));
 	} else {
 		g_hash_table_foreach(data, insert_in_hash_table, chat->components);
 	}
@@ -265,49 +266,93 @@ jabber_chat_new(JabberStream *js, const char *room, const char *server,
  * In-protocol function for joining a chat room. Doesn't require sticking goop
  * into a hash table.
  */
-static JabberChat *
-jabber_join_chat(JabberStream *js, const char *room, const char *server,
-                 const char *handle, const char *password, GHashTable *data)
+static void
+jabber_chat_send_join(JabberChat *chat, gboolean archived)
 {
-	JabberChat *chat;
-
-	PurpleConnection *gc;
+	JabberStream *js = chat->js;
 	PurpleAccount *account;
 	PurpleStatus *status;
 
 	PurpleXmlNode *presence, *x;
 	JabberBuddyState state;
+	const char *password;
 	char *msg;
 	int priority;
 
 	char *jid;
 
-	chat = jabber_chat_new(js, room, server, handle, password, data);
-	if (chat == NULL)
-		return NULL;
-
-	gc = js->gc;
-	account = purple_connection_get_account(gc);
+	account = purple_connection_get_account(js->gc);
 	status = purple_account_get_active_status(account);
 	purple_status_to_jabber(status, &state, &msg, &priority);
 
 	presence = jabber_presence_create_js(js, state, msg, priority);
 	g_free(msg);
 
-	jid = g_strdup_printf("%s@%s/%s", room, server, handle);
+	jid = g_strdup_printf("%s@%s/%s", chat->room, chat->server, chat->handle);
 	purple_xmlnode_set_attrib(presence, "to", jid);
 	g_free(jid);
 
 	x = purple_xmlnode_new_child(presence, "x");
 	purple_xmlnode_set_namespace(x, "http://jabber.org/protocol/muc");
 
+	password = g_hash_table_lookup(chat->components, "password");
 	if (password && *password) {
 		PurpleXmlNode *p = purple_xmlnode_new_child(x, "password");
 		purple_xmlnode_insert_data(p, password, -1);
 	}
 
+	/* The archive has everything the room would replay, and lets us fetch
+	 * just the part we don't have yet. */
+	if (archived) {
+		PurpleXmlNode *history = purple_xmlnode_new_child(x, "history");
+		purple_xmlnode_set_attrib(history, "maxstanzas", "0");
+	}
+
 	jabber_send(js, presence);
 	purple_xmlnode_free(presence);
+}
+
+static void
+jabber_chat_room_checked_cb(JabberStream *js, const char *room_jid,
+                            gboolean supported,
+                            G_GNUC_UNUSED gpointer data)
+{
+	JabberChat *chat = g_hash_table_lookup(js->chats, room_jid);
+
+	/* The join may have been cancelled while we were waiting. */
+	if (chat == NULL || chat->conv != NULL)
+		return;
+
+	jabber_chat_send_join(chat, supported);
+}
+
+/*
+ * jabber_join_chat:
+ * @room: The room to join. This MUST be normalized already.
+ * @server: The server the room is on. This MUST be normalized already.
+ * @password: (nullable): The password (if required) to join the room.
+ * @data: (nullable): The chat hash table. If NULL, it will be generated for
+ *        current core<>protocol API interface.
+ *
+ * In-protocol function for joining a chat room. Doesn't require sticking goop
+ * into a hash table.
+ */
+static JabberChat *
+jabber_join_chat(JabberStream *js, const char *room, const char *server,
+                 const char *handle, const char *password, GHashTable *data)
+{
+	JabberChat *chat;
+	char *room_jid;
+
+	chat = jabber_chat_new(js, room, server, handle, password, data);
+	if (chat == NULL)
+		return NULL;
+
+	/* Find out if the room keeps an archive before joining, so we know
+	 * whether to ask for a history replay. */
+	room_jid = g_strdup_printf("%s@%s", room, server);
+	jabber_mam_check_room(js, room_jid, jabber_chat_room_checked_cb, NULL);
+	g_free(room_jid);
 
 	return chat;
 }
@@ -777,13 +822,22 @@ void jabber_chat_part(JabberChat *chat, const char *msg)
 	g_free(room_jid);
 }
 
+/* How many rooms to ask a conference server for at a time. */
+#define JABBER_ROOMLIST_PAGE_SIZE (250)
+
+static void roomlist_request_page(JabberStream *js, const char *server,
+                                  const char *after);
+
 static void
-roomlist_disco_result_cb(JabberStream *js, G_GNUC_UNUSED const char *from,
+roomlist_disco_result_cb(JabberStream *js, const char *from,
                          JabberIqType type, G_GNUC_UNUSED const char *id,
                          PurpleXmlNode *packet, G_GNUC_UNUSED gpointer data)
 {
 	PurpleXmlNode *query;
 	PurpleXmlNode *item;
+	PurpleXmlNode *set;
+	char *last = NULL;
+	guint count = 0;
 
 	if(!js->roomlist)
 		return;
@@ -830,12 +884,67 @@ roomlist_disco_result_cb(JabberStream *js, G_GNUC_UNUSED const char *from,
 		g_object_unref(room);
 
 		jabber_id_free(jid);
+		count++;
 	}
+
+	/* If the server pages its results (XEP-0059), keep asking for the next
+	 * page for as long as the user still wants the list. The room list adds
+	 * each page as a batch, so the UI stays responsive on huge servers.
+	 */
+	set = purple_xmlnode_get_child_with_namespace(query, "set", NS_RSM);
+	if(set != NULL) {
+		PurpleXmlNode *node = purple_xmlnode_get_child(set, "last");
+
+		if(node != NULL) {
+			last = purple_xmlnode_get_data(node);
+		}
+	}
+
+	if(count > 0 && last != NULL && *last != '\0' && from != NULL &&
+	   purple_roomlist_get_in_progress(js->roomlist))
+	{
+		roomlist_request_page(js, from, last);
+		g_free(last);
+		return;
+	}
+	g_free(last);
+
 	purple_roomlist_set_in_progress(js->roomlist, FALSE);
 	g_object_unref(js->roomlist);
 	js->roomlist = NULL;
 }
 
+static void
+roomlist_request_page(JabberStream *js, const char *server, const char *after)
+{
+	JabberIq *iq;
+	PurpleXmlNode *query, *set, *node;
+	char *max;
+
+	iq = jabber_iq_new_query(js, JABBER_IQ_GET, NS_DISCO_ITEMS);
+
+	purple_xmlnode_set_attrib(iq->node, "to", server);
+
+	/* Servers that don't support RSM ignore this and send everything. */
+	query = purple_xmlnode_get_child(iq->node, "query");
+	set = purple_xmlnode_new_child(query, "set");
+	purple_xmlnode_set_namespace(set, NS_RSM);
+
+	max = g_strdup_printf("%d", JABBER_ROOMLIST_PAGE_SIZE);
+	node = purple_xmlnode_new_child(set, "max");
+	purple_xmlnode_insert_data(node, max, -1);
+	g_free(max);
+
+	if(after != NULL) {
+		node = purple_xmlnode_new_child(set, "after");
+		purple_xmlnode_insert_data(node, after, -1);
+	}
+
+	jabber_iq_set_callback(iq, roomlist_disco_result_cb, NULL);
+
+	jabber_iq_send(iq);
+}
+
 static void
 roomlist_cancel_cb(JabberStream *js, G_GNUC_UNUSED const char *server) {
 	if(js->roomlist) {
@@ -847,8 +956,6 @@ roomlist_cancel_cb(JabberStream *js, G_GNUC_UNUSED const char *server) {
 
 static void roomlist_ok_cb(JabberStream *js, const char *server)
 {
-	JabberIq *iq;
-
 	if(!js->roomlist)
 		return;
 
@@ -862,13 +969,7 @@ static void roomlist_ok_cb(JabberStream *js, const char *server)
 
 	purple_roomlist_set_in_progress(js->roomlist, TRUE);
 
-	iq = jabber_iq_new_query(js, JABBER_IQ_GET, NS_DISCO_ITEMS);
-
-	purple_xmlnode_set_attrib(iq->node, "to", server);
-
-	jabber_iq_set_callback(iq, roomlist_disco_result_cb, NULL);
-
-	jabber_iq_send(iq);
+	roomlist_request_page(js, server, NULL);
 }
 
 PurpleRoomlist *
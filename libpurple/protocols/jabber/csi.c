@@ -0,0 +1,241 @@
+/*
+ * purple - Jabber Protocol Plugin
+ *
+ * Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ */
+
+#include <purple.h>
+
+#include "csi.h"
+#include "jabber.h"
+#include "message.h"
+#include "presence.h"
+
+/* If this many updates pile up they're applied even though the user is still
+ * away, so the queue can't grow without bounds on huge rosters. */
+#define JABBER_CSI_MAX_DEFERRED 2000
+
+struct _JabberClientState {
+	/* Whether the server advertised CSI in its stream features. */
+	gboolean supported;
+
+	gboolean inactive;
+
+	/* Deferred packets in arrival order, indexed by what they update so that
+	 * a newer update replaces an older one instead of piling up. */
+	GQueue deferred;
+	GHashTable *index;
+};
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static void
+jabber_csi_send_state(JabberStream *js)
+{
+	PurpleXmlNode *state;
+
+	if (!js->csi->supported || js->state != JABBER_STREAM_CONNECTED) {
+		return;
+	}
+
+	state = purple_xmlnode_new(js->csi->inactive ? "inactive" : "active");
+	purple_xmlnode_set_namespace(state, NS_CLIENT_STATE_INDICATION);
+	jabber_send(js, state);
+	purple_xmlnode_free(state);
+}
+
+/*
+ * Returns the key a deferrable packet is coalesced under, or NULL if the
+ * packet has to be handled right away.
+ */
+static gchar *
+jabber_csi_get_key(PurpleXmlNode *packet)
+{
+	const gchar *from = purple_xmlnode_get_attrib(packet, "from");
+	const gchar *type = purple_xmlnode_get_attrib(packet, "type");
+
+	if (from == NULL) {
+		return NULL;
+	}
+
+	if (purple_strequal(packet->name, "presence")) {
+		/* Subscriptions, probes and errors need attention, and MUC
+		 * presence keeps the occupant list of open chats correct. */
+		if (type != NULL && !purple_strequal(type, "unavailable")) {
+			return NULL;
+		}
+		if (purple_xmlnode_get_child_with_namespace(packet, "x",
+		        "http://jabber.org/protocol/muc#user") != NULL) {
+			return NULL;
+		}
+
+		return g_strconcat("presence/", from, NULL);
+	}
+
+	if (purple_strequal(packet->name, "message")) {
+		PurpleXmlNode *event, *items;
+		const gchar *node;
+
+		/* Only bare PEP notifications, anything with a body is a real
+		 * message. */
+		if (purple_xmlnode_get_child(packet, "body") != NULL) {
+			return NULL;
+		}
+
+		event = purple_xmlnode_get_child_with_namespace(packet, "event",
+		        "http://jabber.org/protocol/pubsub#event");
+		items = purple_xmlnode_get_child(event, "items");
+		node = purple_xmlnode_get_attrib(items, "node");
+		if (node == NULL || purple_xmlnode_get_next_twin(items) != NULL) {
+			return NULL;
+		}
+
+		return g_strconcat("pep/", from, "/", node, NULL);
+	}
+
+	return NULL;
+}
+
+static void
+jabber_csi_handle(JabberStream *js, PurpleXmlNode *packet)
+{
+	if (purple_strequal(packet->name, "presence")) {
+		jabber_presence_parse(js, packet);
+	} else {
+		jabber_message_parse(js, packet);
+	}
+}
+
+/******************************************************************************
+ * API
+ *****************************************************************************/
+JabberClientState *
+jabber_csi_new(void)
+{
+	JabberClientState *csi = g_new0(JabberClientState, 1);
+
+	g_queue_init(&csi->deferred);
+	csi->index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	return csi;
+}
+
+void
+jabber_csi_free(JabberClientState *csi)
+{
+	if (csi == NULL) {
+		return;
+	}
+
+	g_queue_clear_full(&csi->deferred, (GDestroyNotify)purple_xmlnode_free);
+	g_hash_table_destroy(csi->index);
+	g_free(csi);
+}
+
+void
+jabber_csi_features_parse(JabberStream *js, PurpleXmlNode *features)
+{
+	if (purple_xmlnode_get_child_with_namespace(features, "csi",
+	        NS_CLIENT_STATE_INDICATION) != NULL) {
+		js->csi->supported = TRUE;
+	}
+}
+
+void
+jabber_csi_set_inactive(JabberStream *js, gboolean inactive)
+{
+	JabberClientState *csi = js->csi;
+
+	/* The server assumes a new session is active, so being told we're
+	 * inactive again is never redundant, but being told we're active is. */
+	if (!inactive && !csi->inactive) {
+		return;
+	}
+
+	csi->inactive = inactive;
+	jabber_csi_send_state(js);
+
+	if (!inactive) {
+		jabber_csi_flush(js);
+	}
+}
+
+gboolean
+jabber_csi_defer(JabberStream *js, PurpleXmlNode *packet)
+{
+	JabberClientState *csi = js->csi;
+	PurpleXmlNode *copy;
+	GList *link;
+	gchar *key;
+
+	if (!csi->inactive || js->state != JABBER_STREAM_CONNECTED) {
+		return FALSE;
+	}
+
+	key = jabber_csi_get_key(packet);
+	if (key == NULL) {
+		return FALSE;
+	}
+
+	copy = purple_xmlnode_copy(packet);
+
+	link = g_hash_table_lookup(csi->index, key);
+	if (link != NULL) {
+		/* Only the latest update matters, but keep it in the position of the
+		 * first one. */
+		purple_xmlnode_free(link->data);
+		link->data = copy;
+		g_free(key);
+	} else {
+		g_queue_push_tail(&csi->deferred, copy);
+		g_hash_table_insert(csi->index, key, csi->deferred.tail);
+	}
+
+	if (g_queue_get_length(&csi->deferred) >= JABBER_CSI_MAX_DEFERRED) {
+		jabber_csi_flush(js);
+	}
+
+	return TRUE;
+}
+
+void
+jabber_csi_flush(JabberStream *js)
+{
+	JabberClientState *csi = js->csi;
+	GQueue deferred = G_QUEUE_INIT;
+
+	if (g_queue_is_empty(&csi->deferred)) {
+		return;
+	}
+
+	purple_debug_info("jabber", "Applying %u deferred updates",
+	                  g_queue_get_length(&csi->deferred));
+
+	deferred = csi->deferred;
+	g_queue_init(&csi->deferred);
+	g_hash_table_remove_all(csi->index);
+
+	while (!g_queue_is_empty(&deferred)) {
+		PurpleXmlNode *packet = g_queue_pop_head(&deferred);
+
+		jabber_csi_handle(js, packet);
+		purple_xmlnode_free(packet);
+	}
+}
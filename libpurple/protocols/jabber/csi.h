@@ -0,0 +1,45 @@
+/**
+ * @file csi.h Client State Indication functions
+ *
+ * purple
+ *
+ * Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ */
+
+#ifndef PURPLE_JABBER_CSI_H
+#define PURPLE_JABBER_CSI_H
+
+#include <purple.h>
+
+#include "jabber.h"
+
+/* XEP-0352 Client State Indication, plus holding back low priority presence
+ * and PEP updates on our side while the user is away. */
+
+JabberClientState *jabber_csi_new(void);
+void jabber_csi_free(JabberClientState *csi);
+
+void jabber_csi_features_parse(JabberStream *js, PurpleXmlNode *features);
+void jabber_csi_set_inactive(JabberStream *js, gboolean inactive);
+
+/* Returns TRUE if packet was queued to be handled once the user is back. */
+gboolean jabber_csi_defer(JabberStream *js, PurpleXmlNode *packet);
+void jabber_csi_flush(JabberStream *js);
+
+#endif /* PURPLE_JABBER_CSI_H */
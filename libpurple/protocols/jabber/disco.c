@@ -29,6 +29,7 @@
 #include "iq.h"
 #include "jabber.h"
 #include "jingle/jingle.h"
+#include "mam.h"
 #include "pep.h"
 #include "presence.h"
 #include "roster.h"
@@ -347,6 +348,11 @@ jabber_disco_finish_server_info_result_cb(JabberStream *js)
 		jabber_iq_send(iq);
 	}
 
+	/* Fetch what we missed while we were away from the archive. */
+	if(js->server_caps & JABBER_CAP_MAM) {
+		jabber_mam_catch_up(js);
+	}
+
 	/* If there are manually specified bytestream proxies, query them */
 	ft_proxies = purple_account_get_string(purple_connection_get_account(js->gc), "ft_proxies", NULL);
 	if (ft_proxies) {
@@ -446,6 +452,8 @@ jabber_disco_server_info_result_cb(JabberStream *js, const char *from,
 			js->server_caps |= JABBER_CAP_BLOCKING;
 		} else if (purple_strequal(NS_MESSAGE_CARBONS, var)) {
 			js->server_caps |= JABBER_CAP_MESSAGE_CARBONS;
+		} else if (purple_strequal(NS_MAM, var)) {
+			js->server_caps |= JABBER_CAP_MAM;
 		}
 	}
 
@@ -36,11 +36,13 @@
 #include "buddy.h"
 #include "caps.h"
 #include "chat.h"
+#include "csi.h"
 #include "data.h"
 #include "disco.h"
 #include "ibb.h"
 #include "iq.h"
 #include "jutil.h"
+#include "mam.h"
 #include "message.h"
 #include "parser.h"
 #include "presence.h"
@@ -49,6 +51,7 @@
 #include "oob.h"
 #include "ping.h"
 #include "si.h"
+#include "sm.h"
 #include "usermood.h"
 #include "xdata.h"
 #include "pep.h"
@@ -77,7 +80,11 @@ static GHashTable *jabber_cmds = NULL; /* PurpleProtocol * => GSList of ids */
 
 static gint plugin_ref = 0;
 
+PURPLE_DEBUG_CATEGORY_DEFINE_STATIC(jabber_debug, "jabber");
+
 static void jabber_send_raw(PurpleProtocolServer *protocol_server, JabberStream *js, const gchar *data, gint len);
+static void jabber_stream_connect(JabberStream *js);
+static void jabber_stream_connection_lost(JabberStream *js, GError *error);
 static void jabber_remove_feature(const gchar *namespace);
 static gboolean jabber_initiate_media(PurpleProtocolMedia *media, PurpleAccount *account, const char *who, PurpleMediaSessionType type);
 static PurpleMediaCaps jabber_get_media_caps(PurpleProtocolMedia *media, PurpleAccount *account, const char *who);
@@ -89,6 +96,19 @@ static void jabber_stream_init(JabberStream *js)
 	g_free(js->stream_id);
 	js->stream_id = NULL;
 
+	if (js->websocket) {
+		/* RFC 7395 frames every element on its own, so the stream header
+		 * is a complete <open/> and there's no stream parser to reset. */
+		open_stream = g_strdup_printf("<open to='%s' "
+		                              "xmlns='" NS_XMPP_FRAMING "' "
+		                              "version='1.0'/>",
+		                              js->user->domain);
+		jabber_send_raw(NULL, js, open_stream, -1);
+		js->reinit = FALSE;
+		g_free(open_stream);
+		return;
+	}
+
 	open_stream = g_strdup_printf("<stream:stream to='%s' "
 				          "xmlns='" NS_XMPP_CLIENT "' "
 						  "xmlns:stream='" NS_XMPP_STREAMS "' "
@@ -159,6 +179,8 @@ jabber_bind_result_cb(JabberStream *js, G_GNUC_UNUSED const char *from,
 
 			g_free(full_jid);
 		}
+
+		jabber_sm_enable(js);
 	} else {
 		PurpleConnectionError reason = PURPLE_CONNECTION_ERROR_NETWORK_ERROR;
 		char *msg = jabber_parse_error(js, packet, &reason);
@@ -219,10 +241,15 @@ jabber_process_starttls(JabberStream *js, PurpleXmlNode *packet)
 		return FALSE;
 	}
 
+	/* RFC 7395 likewise leaves TLS to the WebSocket layer. */
+	if (js->websocket && jabber_websocket_is_ssl(js->websocket)) {
+		return FALSE;
+	}
+
 	/* Otherwise, it's a standard XMPP connection, or a HTTP (insecure) BOSH connection.
 	 * We request STARTTLS for standard XMPP connections, but we do nothing for insecure
 	 * BOSH connections, per XEP-0206. */
-	if(!js->bosh) {
+	if(!js->bosh && !js->websocket) {
 		jabber_send_raw(NULL, js,
 				"<starttls xmlns='urn:ietf:params:xml:ns:xmpp-tls'/>", -1);
 		return TRUE;
@@ -233,7 +260,8 @@ jabber_process_starttls(JabberStream *js, PurpleXmlNode *packet)
 	 * entirely (sysadmin is responsible to provide HTTPS-only BOSH if security is required),
 	 * and emit errors if encryption is required by the user. */
 	starttls = purple_xmlnode_get_child(packet, "starttls");
-	if(!js->bosh && purple_xmlnode_get_child(starttls, "required")) {
+	if(!js->bosh && !js->websocket &&
+	   purple_xmlnode_get_child(starttls, "required")) {
 		purple_connection_error(js->gc,
 				PURPLE_CONNECTION_ERROR_NO_SSL_SUPPORT,
 				_("Server requires TLS/SSL, but no TLS/SSL support was found."));
@@ -269,9 +297,22 @@ void jabber_stream_features_parse(JabberStream *js, PurpleXmlNode *packet)
 		return;
 	}
 
+	jabber_sm_features_parse(js, packet);
+	jabber_csi_features_parse(js, packet);
+
 	if(purple_xmlnode_get_child(packet, "mechanisms")) {
 		jabber_stream_set_state(js, JABBER_STREAM_AUTHENTICATING);
 		jabber_auth_start(js, packet);
+	} else if(jabber_sm_is_resuming(js)) {
+		/* We're back after losing the connection, pick up the old session
+		 * instead of binding a new one. */
+		if(jabber_sm_is_supported(js)) {
+			jabber_sm_resume(js);
+		} else {
+			purple_connection_error(js->gc,
+				PURPLE_CONNECTION_ERROR_NETWORK_ERROR,
+				_("Unable to resume the XMPP stream"));
+		}
 	} else if(purple_xmlnode_get_child(packet, "bind")) {
 		PurpleXmlNode *bind, *resource;
 		char *requested_resource;
@@ -327,6 +368,11 @@ void jabber_process_packet(JabberStream *js, PurpleXmlNode **packet)
 	name = (*packet)->name;
 	xmlns = purple_xmlnode_get_namespace(*packet);
 
+	jabber_sm_stanza_received(js, *packet);
+
+	if (jabber_csi_defer(js, *packet))
+		return;
+
 	if (purple_strequal(name, "iq")) {
 		jabber_iq_parse(js, *packet);
 	} else if (purple_strequal(name, "presence")) {
@@ -349,6 +395,8 @@ void jabber_process_packet(JabberStream *js, PurpleXmlNode **packet)
 			else if (purple_strequal(name, "failure"))
 				jabber_auth_handle_failure(js, *packet);
 		}
+	} else if (purple_strequal(xmlns, NS_STREAM_MANAGEMENT)) {
+		jabber_sm_parse(js, *packet);
 	} else if (purple_strequal(xmlns, NS_XMPP_TLS)) {
 		if (js->state != JABBER_STREAM_INITIALIZING_ENCRYPTION ||
 		    G_IS_TLS_CONNECTION(js->stream)) {
@@ -378,7 +426,7 @@ jabber_push_bytes_cb(GObject *source, GAsyncResult *res, gpointer data)
 
 		if (error->code != G_IO_ERROR_CANCELLED) {
 			g_prefix_error(&error, "%s", _("Lost connection with server: "));
-			purple_connection_take_error(js->gc, error);
+			jabber_stream_connection_lost(js, error);
 		} else {
 			g_error_free(error);
 		}
@@ -392,6 +440,13 @@ static gboolean do_jabber_send_raw(JabberStream *js, const char *data, int len)
 
 	g_return_val_if_fail(len > 0, FALSE);
 
+	/* There's no connection while we're trying to resume the stream. */
+	if (js->output == NULL) {
+		purple_debug_warning("jabber", "Dropping data written while "
+		                     "disconnected");
+		return FALSE;
+	}
+
 	if (js->state == JABBER_STREAM_CONNECTED)
 		jabber_stream_restart_inactivity_timer(js);
 
@@ -417,9 +472,12 @@ jabber_send_raw(G_GNUC_UNUSED PurpleProtocolServer *protocol_server,
 	g_return_if_fail(data != NULL);
 
 	/* because printing a tab to debug every minute gets old */
-	if (!purple_strequal(data, "\t")) {
+	if (PURPLE_DEBUG_CATEGORY_ENABLED(&jabber_debug, PURPLE_DEBUG_MISC) &&
+	    !purple_strequal(data, "\t"))
+	{
 		const char *username;
 		char *text = NULL, *last_part = NULL, *tag_start = NULL;
+		GLogField fields[1];
 
 		/* Because debug logs with plaintext passwords make me sad */
 		if (!purple_debug_is_unsafe() && js->state != JABBER_STREAM_CONNECTED &&
@@ -449,7 +507,10 @@ jabber_send_raw(G_GNUC_UNUSED PurpleProtocolServer *protocol_server,
 			username = purple_contact_info_get_username(info);
 		}
 
-		purple_debug_misc("jabber", "Sending%s (%s): %s%s%s\n",
+		fields[0] = (GLogField){ "PURPLE_ACCOUNT", username, -1 };
+		purple_debug_category_log_structured(&jabber_debug, PURPLE_DEBUG_MISC,
+				fields, G_N_ELEMENTS(fields),
+				"Sending%s (%s): %s%s%s",
 				jabber_stream_is_ssl(js) ? " (ssl)" : "", username,
 				text ? text : data,
 				last_part ? "password removed" : "",
@@ -467,6 +528,8 @@ jabber_send_raw(G_GNUC_UNUSED PurpleProtocolServer *protocol_server,
 
 	if (js->bosh)
 		jabber_bosh_connection_send(js->bosh, data);
+	else if (js->websocket)
+		jabber_websocket_send(js->websocket, data, len);
 	else
 		do_jabber_send_raw(js, data, len);
 }
@@ -483,7 +546,13 @@ jabber_protocol_send_raw(G_GNUC_UNUSED PurpleProtocolServer *protocol_server,
 	 * to do things during the connection process.
 	 */
 
-	jabber_send_raw(NULL, js, buf, len);
+	/* Stanzas count towards the h of stream management, so they have to be
+	 * queued like the ones we build ourselves. */
+	if (!jabber_sm_is_enabled(js)) {
+		jabber_send_raw(NULL, js, buf, len);
+	} else if (!jabber_sm_send_raw(js, buf, len)) {
+		return -1;
+	}
 	return (len < 0 ? (int)strlen(buf) : len);
 }
 
@@ -505,7 +574,10 @@ jabber_send_signal_cb(PurpleConnection *pc, PurpleXmlNode **packet,
 	if (NULL == js)
 		return;
 
-	if (js->bosh)
+	if (!jabber_sm_stanza_sent(js, *packet))
+		return;
+
+	if (js->bosh || js->websocket)
 		if (purple_strequal((*packet)->name, "message") ||
 				purple_strequal((*packet)->name, "iq") ||
 				purple_strequal((*packet)->name, "presence"))
@@ -523,9 +595,11 @@ void jabber_send(JabberStream *js, PurpleXmlNode *packet)
 static gboolean jabber_keepalive_timeout(PurpleConnection *gc)
 {
 	JabberStream *js = purple_connection_get_protocol_data(gc);
-	purple_connection_error(gc, PURPLE_CONNECTION_ERROR_NETWORK_ERROR,
-					_("Ping timed out"));
 	js->keepalive_timeout = 0;
+	jabber_stream_connection_lost(js,
+		g_error_new_literal(PURPLE_CONNECTION_ERROR,
+		                    PURPLE_CONNECTION_ERROR_NETWORK_ERROR,
+		                    _("Ping timed out")));
 	return FALSE;
 }
 
@@ -564,10 +638,11 @@ jabber_recv_cb(GObject *stream, gpointer data)
 		        G_POLLABLE_INPUT_STREAM(stream), buf, sizeof(buf) - 1,
 		        js->cancellable, &error);
 		if (len == 0) {
-			purple_connection_error(js->gc,
-			                        PURPLE_CONNECTION_ERROR_NETWORK_ERROR,
-			                        _("Server closed the connection"));
 			js->inpa = 0;
+			jabber_stream_connection_lost(js,
+				g_error_new_literal(PURPLE_CONNECTION_ERROR,
+				                    PURPLE_CONNECTION_ERROR_NETWORK_ERROR,
+				                    _("Server closed the connection")));
 			return G_SOURCE_REMOVE;
 		} else if (len < 0) {
 			if (error->code == G_IO_ERROR_WOULD_BLOCK) {
@@ -576,9 +651,11 @@ jabber_recv_cb(GObject *stream, gpointer data)
 			} else if (error->code == G_IO_ERROR_CANCELLED) {
 				g_error_free(error);
 			} else {
+				js->inpa = 0;
 				g_prefix_error(&error, "%s",
 				               _("Lost connection with server: "));
-				purple_connection_take_error(js->gc, error);
+				jabber_stream_connection_lost(js, error);
+				return G_SOURCE_REMOVE;
 			}
 			js->inpa = 0;
 			return G_SOURCE_REMOVE;
@@ -586,8 +663,8 @@ jabber_recv_cb(GObject *stream, gpointer data)
 
 		purple_connection_update_last_received(gc);
 		buf[len] = '\0';
-		purple_debug_misc("jabber", "Recv (%" G_GSSIZE_FORMAT "): %s", len,
-		                  buf);
+		PURPLE_DEBUG_CATEGORY_LOG(&jabber_debug, PURPLE_DEBUG_MISC,
+		                          "Recv (%" G_GSSIZE_FORMAT "): %s", len, buf);
 		jabber_parser_process(js, buf, len);
 		if(js->reinit)
 			jabber_stream_init(js);
@@ -724,6 +801,10 @@ static void tls_init(JabberStream *js)
 		return;
 	}
 
+	purple_tls_session_cache_prepare(purple_tls_session_cache_get_default(),
+	                                 purple_connection_get_account(js->gc),
+	                                 G_TLS_CLIENT_CONNECTION(tls_conn));
+
 	g_clear_object(&js->stream);
 	js->stream = G_IO_STREAM(tls_conn);
 
@@ -779,16 +860,17 @@ jabber_stream_new(PurpleAccount *account)
 {
 	PurpleConnection *gc = purple_account_get_connection(account);
 	PurpleContactInfo *info = PURPLE_CONTACT_INFO(account);
-	GProxyResolver *resolver;
+	SoupSession *session;
 	GError *error = NULL;
 	JabberStream *js;
 	PurplePresence *presence;
 	gchar *user;
 	gchar *slash;
 
-	resolver = purple_proxy_get_proxy_resolver(account, &error);
-	if (resolver == NULL) {
-		purple_debug_error("jabber", "Unable to get account proxy resolver: %s",
+	session = purple_http_service_get_session(purple_http_service_get_default(),
+	                                          account, &error);
+	if (session == NULL) {
+		purple_debug_error("jabber", "Unable to get account HTTP session: %s",
 		                   error->message);
 		g_error_free(error);
 		return NULL;
@@ -797,9 +879,8 @@ jabber_stream_new(PurpleAccount *account)
 	js = g_new0(JabberStream, 1);
 	purple_connection_set_protocol_data(gc, js);
 	js->gc = gc;
-	js->http_conns = soup_session_new_with_options("proxy-resolver", resolver,
-	                                               NULL);
-	g_object_unref(resolver);
+	js->http_conns = session;
+	js->http_cancellable = g_cancellable_new();
 
 	/* we might want to expose this at some point */
 	js->cancellable = g_cancellable_new();
@@ -871,6 +952,9 @@ jabber_stream_new(PurpleAccount *account)
 	js->protocol_version.major = 1;
 	js->protocol_version.minor = 0;
 	js->sessions = NULL;
+	js->sm = jabber_sm_new();
+	js->csi = jabber_csi_new();
+	js->mam = jabber_mam_new();
 
 	/* if we are idle, set idle-ness on the stream (this could happen if we get
 		disconnected and the reconnects while being idle. I don't think it makes
@@ -888,6 +972,130 @@ jabber_stream_new(PurpleAccount *account)
 	return js;
 }
 
+/*
+ * Throws away the connection to the server, but keeps everything else in the
+ * JabberStream around, and connects again to resume the stream.
+ */
+static void
+jabber_stream_reconnect(JabberStream *js)
+{
+	if (js->inpa) {
+		g_source_remove(js->inpa);
+		js->inpa = 0;
+	}
+
+	/* Cancel anything still pending on the old connection. */
+	g_cancellable_cancel(js->cancellable);
+	g_object_unref(js->cancellable);
+	js->cancellable = g_cancellable_new();
+
+	if (js->output != NULL) {
+		purple_queued_output_stream_clear_queue(js->output);
+	}
+	g_clear_object(&js->output);
+	g_clear_object(&js->input);
+	g_clear_object(&js->stream);
+	g_clear_object(&js->client);
+	g_clear_pointer(&js->certificate_CN, g_free);
+
+	if (js->current != NULL) {
+		PurpleXmlNode *root = js->current;
+
+		while (root->parent != NULL) {
+			root = root->parent;
+		}
+		purple_xmlnode_free(root);
+		js->current = NULL;
+	}
+	jabber_parser_free(js);
+
+	if (js->auth_mech && js->auth_mech->dispose) {
+		js->auth_mech->dispose(js);
+	}
+	js->auth_mech = NULL;
+	js->reinit = FALSE;
+
+	if (js->keepalive_timeout != 0) {
+		g_source_remove(js->keepalive_timeout);
+		js->keepalive_timeout = 0;
+	}
+	if (js->inactivity_timer != 0) {
+		g_source_remove(js->inactivity_timer);
+		js->inactivity_timer = 0;
+	}
+
+	jabber_sm_begin_resume(js);
+	jabber_stream_connect(js);
+}
+
+/*
+ * Called when the connection to the server goes away. If the server agreed to
+ * let us resume the stream we reconnect quietly and only fall back to a full
+ * login if that fails.
+ */
+static void
+jabber_stream_connection_lost(JabberStream *js, GError *error)
+{
+	if (!jabber_sm_can_resume(js)) {
+		purple_connection_take_error(js->gc, error);
+		return;
+	}
+
+	purple_debug_info("jabber", "%s, trying to resume the stream",
+	                  error->message);
+	g_error_free(error);
+
+	jabber_stream_reconnect(js);
+}
+
+static void
+jabber_stream_connect_bosh(JabberStream *js, const char *bosh_url)
+{
+	js->bosh = jabber_bosh_connection_new(js, bosh_url);
+	if (!js->bosh) {
+		purple_connection_error(js->gc,
+			PURPLE_CONNECTION_ERROR_INVALID_SETTINGS,
+			_("Malformed BOSH URL"));
+	}
+}
+
+static void
+jabber_stream_websocket_discovered_cb(G_GNUC_UNUSED GObject *source,
+                                      GAsyncResult *result, gpointer data)
+{
+	JabberStream *js = NULL;
+	PurpleAccount *account = NULL;
+	GError *error = NULL;
+	gchar *url = NULL;
+
+	url = jabber_websocket_discover_finish(result, &error);
+	if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		/* The stream is already gone. */
+		g_error_free(error);
+		return;
+	}
+
+	js = data;
+
+	if (url != NULL) {
+		purple_debug_info("jabber", "Using discovered WebSocket endpoint %s",
+		                  url);
+		js->websocket = jabber_websocket_new(js, url);
+		g_free(url);
+		if (js->websocket != NULL) {
+			return;
+		}
+	} else {
+		purple_debug_info("jabber", "No WebSocket endpoint found: %s",
+		                  error->message);
+		g_error_free(error);
+	}
+
+	account = purple_connection_get_account(js->gc);
+	jabber_stream_connect_bosh(js,
+		purple_account_get_string(account, "bosh_url", ""));
+}
+
 static void
 jabber_stream_connect(JabberStream *js)
 {
@@ -897,24 +1105,35 @@ jabber_stream_connect(JabberStream *js)
 			"connect_server", "");
 	const char *bosh_url = purple_account_get_string(account,
 			"bosh_url", "");
+	const char *websocket_url = purple_account_get_string(account,
+			"websocket_url", "");
 	GError *error = NULL;
 
 	jabber_stream_set_state(js, JABBER_STREAM_CONNECTING);
 
-	/* If both BOSH and a Connect Server are specified, we prefer BOSH. I'm not
-	 * attached to that choice, though.
+	/* WebSocket wins over BOSH and BOSH wins over a Connect Server.  A
+	 * WebSocket keeps a single connection open in both directions instead of
+	 * holding HTTP requests, so when only BOSH is configured we still look
+	 * for an advertised WebSocket endpoint first.
 	 */
-	if (*bosh_url) {
-		js->bosh = jabber_bosh_connection_new(js, bosh_url);
-		if (!js->bosh) {
+	if (*websocket_url) {
+		js->websocket = jabber_websocket_new(js, websocket_url);
+		if (!js->websocket) {
 			purple_connection_error(gc,
 				PURPLE_CONNECTION_ERROR_INVALID_SETTINGS,
-				_("Malformed BOSH URL"));
+				_("Malformed WebSocket URL"));
 		}
 
 		return;
 	}
 
+	if (*bosh_url) {
+		jabber_websocket_discover(js, js->cancellable,
+		                          jabber_stream_websocket_discovered_cb, js);
+
+		return;
+	}
+
 	js->client = purple_gio_socket_client_new(account, &error);
 	if (js->client == NULL) {
 		purple_connection_take_error(gc, error);
@@ -998,6 +1217,9 @@ jabber_close(G_GNUC_UNUSED PurpleProtocol *protocol, PurpleConnection *gc) {
 	if (js->bosh) {
 		jabber_bosh_connection_destroy(js->bosh);
 		js->bosh = NULL;
+	} else if (js->websocket) {
+		jabber_websocket_destroy(js->websocket);
+		js->websocket = NULL;
 	} else if (js->output != NULL) {
 		/* We should emit the stream termination message here
 		 * normally, but since we destroy the jabber stream just
@@ -1038,10 +1260,11 @@ jabber_close(G_GNUC_UNUSED PurpleProtocol *protocol, PurpleConnection *gc) {
 
 	g_list_free_full(js->bs_proxies, (GDestroyNotify)jabber_bytestreams_streamhost_free);
 
-	if (js->http_conns) {
-		soup_session_abort(js->http_conns);
-		g_object_unref(js->http_conns);
+	if (js->http_cancellable) {
+		g_cancellable_cancel(js->http_cancellable);
+		g_object_unref(js->http_cancellable);
 	}
+	g_clear_object(&js->http_conns);
 
 	g_free(js->stream_id);
 	if(js->user)
@@ -1064,6 +1287,10 @@ jabber_close(G_GNUC_UNUSED PurpleProtocol *protocol, PurpleConnection *gc) {
 	g_free(js->old_uri);
 	g_free(js->old_track);
 
+	jabber_sm_free(js->sm);
+	jabber_csi_free(js->csi);
+	jabber_mam_free(js->mam);
+
 	if (js->keepalive_timeout != 0)
 		g_source_remove(js->keepalive_timeout);
 	if (js->inactivity_timer != 0)
@@ -1090,6 +1317,9 @@ void jabber_stream_set_state(JabberStream *js, JabberStreamState state)
 		/* Start up the inactivity timer */
 		jabber_stream_restart_inactivity_timer(js);
 
+		/* Tell the server if we connected while the user is away */
+		jabber_csi_set_inactive(js, js->idle != 0);
+
 		purple_connection_set_state(js->gc, PURPLE_CONNECTION_STATE_CONNECTED);
 	}
 }
@@ -1111,6 +1341,10 @@ jabber_idle_set(G_GNUC_UNUSED PurpleProtocolServer *protocol_server,
 	/* send out an updated prescence */
 	purple_debug_info("jabber", "sending updated presence for idle\n");
 	jabber_presence_send(js, FALSE);
+
+	/* Let the server hold back unimportant traffic while we're away, and
+	 * catch up on what we held back ourselves when we return. */
+	jabber_csi_set_inactive(js, idle != 0);
 }
 
 void
@@ -1434,7 +1668,8 @@ void jabber_bytestreams_streamhost_free(JabberBytestreamsStreamhost *sh)
 gboolean jabber_stream_is_ssl(JabberStream *js)
 {
 	return (js->bosh && jabber_bosh_connection_is_ssl(js->bosh)) ||
-	       (!js->bosh && G_IS_TLS_CONNECTION(js->stream));
+	       (js->websocket && jabber_websocket_is_ssl(js->websocket)) ||
+	       (!js->bosh && !js->websocket && G_IS_TLS_CONNECTION(js->stream));
 }
 
 static gboolean
@@ -1449,6 +1684,9 @@ inactivity_cb(gpointer data)
 
 	if (js->bosh) {
 		jabber_bosh_connection_send_keepalive(js->bosh);
+	} else if (js->websocket) {
+		/* WebSocket pings keep the connection alive; whitespace isn't a
+		 * valid frame. */
 	} else {
 		jabber_send_raw(NULL, js, "\t", 1);
 	}
@@ -45,11 +45,15 @@ typedef enum {
 	JABBER_CAP_ROSTER_VERSIONING = 1 << 15,
 
 	JABBER_CAP_MESSAGE_CARBONS = 1 << 19,
+	JABBER_CAP_MAM            = 1 << 20,
 
 	JABBER_CAP_RETRIEVED      = 1 << 31
 } JabberCapabilities;
 
 typedef struct _JabberStream JabberStream;
+typedef struct _JabberStreamManagement JabberStreamManagement;
+typedef struct _JabberClientState JabberClientState;
+typedef struct _JabberMam JabberMam;
 
 #include <libxml/parser.h>
 #include <glib.h>
@@ -68,6 +72,7 @@ typedef struct _JabberStream JabberStream;
 #include "jutil.h"
 #include "buddy.h"
 #include "bosh.h"
+#include "websocket.h"
 
 #define CAPS0115_NODE "https://pidgin.im/"
 
@@ -226,11 +231,22 @@ struct _JabberStream
 	guint conn_close_timeout;
 
 	PurpleJabberBOSHConnection *bosh;
+	PurpleJabberWebSocket *websocket;
 
 	SoupSession *http_conns;
+	GCancellable *http_cancellable;
 
 	/* keep a hash table of JingleSessions */
 	GHashTable *sessions;
+
+	/* XEP-0198 acks and resumption state */
+	JabberStreamManagement *sm;
+
+	/* XEP-0352 state and updates held back while we're inactive */
+	JabberClientState *csi;
+
+	/* XEP-0313 archive queries in flight and which rooms have an archive */
+	JabberMam *mam;
 };
 
 typedef gboolean (JabberFeatureEnabled)(JabberStream *js, const gchar *namespace);
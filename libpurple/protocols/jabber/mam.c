@@ -0,0 +1,730 @@
+/*
+ * purple - Jabber Protocol Plugin
+ *
+ * Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ */
+
+#include <purple.h>
+
+#include "chat.h"
+#include "iq.h"
+#include "jabber.h"
+#include "jutil.h"
+#include "mam.h"
+#include "namespaces.h"
+
+/* How many messages we ask for per page while catching up. */
+#define JABBER_MAM_PAGE_SIZE 100
+
+/* When we have never been in a room we only fetch its most recent messages,
+ * which is about what the room would have replayed on join. */
+#define JABBER_MAM_INITIAL_PAGE_SIZE 20
+
+/* Stop after this many pages so a long absence can't keep us paging forever;
+ * whatever is older than that is still in the archive. */
+#define JABBER_MAM_MAX_PAGES 50
+
+struct _JabberMam {
+	/* queryid -> JabberMamQuery */
+	GHashTable *queries;
+
+	/* room JID -> GINT_TO_POINTER(supported) */
+	GHashTable *rooms;
+};
+
+typedef struct {
+	gchar *conversation;
+	gchar *id;
+	gchar *author;
+	gchar *recipient;
+	gchar *contents;
+	GDateTime *timestamp;
+	PurpleMessageFlags flags;
+} JabberMamEntry;
+
+typedef struct {
+	JabberStream *js;
+	gchar *queryid;
+
+	/* NULL for our own archive, otherwise the bare JID of the room. */
+	gchar *archive;
+
+	/* The archive id of the newest message we have.  If the server does not
+	 * know it anymore we fall back to asking for everything since start.  The
+	 * history drops what it already has by archive id, so only a boundary
+	 * message without one has to be recognized by its contents. */
+	gchar *after;
+	GDateTime *start;
+	gchar *boundary_author;
+	gchar *boundary_contents;
+
+	/* Only fetch the newest page instead of paging forward. */
+	gboolean latest;
+
+	GArray *page;
+	guint pages;
+} JabberMamQuery;
+
+typedef struct {
+	JabberMamRoomCallback *callback;
+	gpointer data;
+	gchar *room_jid;
+} JabberMamRoomCheck;
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static void
+jabber_mam_entry_clear(gpointer data)
+{
+	JabberMamEntry *entry = data;
+
+	g_free(entry->conversation);
+	g_free(entry->id);
+	g_free(entry->author);
+	g_free(entry->recipient);
+	g_free(entry->contents);
+	g_clear_pointer(&entry->timestamp, g_date_time_unref);
+}
+
+static void
+jabber_mam_query_free(JabberMamQuery *query)
+{
+	g_free(query->queryid);
+	g_free(query->archive);
+	g_free(query->after);
+	g_clear_pointer(&query->start, g_date_time_unref);
+	g_free(query->boundary_author);
+	g_free(query->boundary_contents);
+	g_array_unref(query->page);
+	g_free(query);
+}
+
+static JabberMamQuery *
+jabber_mam_query_new(JabberStream *js, const char *archive)
+{
+	JabberMamQuery *query = g_new0(JabberMamQuery, 1);
+
+	query->js = js;
+	query->queryid = jabber_get_next_id(js);
+	query->archive = g_strdup(archive);
+	query->page = g_array_new(FALSE, TRUE, sizeof(JabberMamEntry));
+	g_array_set_clear_func(query->page, jabber_mam_entry_clear);
+
+	g_hash_table_insert(js->mam->queries, query->queryid, query);
+
+	return query;
+}
+
+static void
+jabber_mam_query_resume_from(JabberMamQuery *query, PurpleMessage *last)
+{
+	const gchar *id = purple_message_get_id(last);
+
+	query->after = g_strdup(id);
+	query->start = g_date_time_to_utc(purple_message_get_timestamp(last));
+
+	/* Messages we received live carry the stanza-id the archive gave them.
+	 * The ones we sent ourselves in a one to one conversation don't. */
+	if(id == NULL) {
+		query->boundary_author = g_strdup(purple_message_get_author(last));
+		query->boundary_contents = g_strdup(purple_message_get_contents(last));
+	}
+}
+
+static gboolean
+jabber_mam_is_boundary(JabberMamQuery *query, const gchar *author,
+                       const gchar *contents, GDateTime *timestamp)
+{
+	if(query->after != NULL || query->start == NULL ||
+	   query->boundary_author == NULL)
+	{
+		return FALSE;
+	}
+
+	return g_date_time_to_unix(timestamp) ==
+	       g_date_time_to_unix(query->start) &&
+	       purple_strequal(author, query->boundary_author) &&
+	       purple_strequal(contents, query->boundary_contents);
+}
+
+static gboolean
+jabber_mam_is_own_bare_jid(JabberStream *js, const char *str)
+{
+	JabberID *jid = jabber_id_new(str);
+	gboolean equal = FALSE;
+
+	if(jid != NULL) {
+		equal = purple_strequal(jid->node, js->user->node) &&
+		        purple_strequal(jid->domain, js->user->domain);
+		jabber_id_free(jid);
+	}
+
+	return equal;
+}
+
+static void
+jabber_mam_add_field(PurpleXmlNode *x, const char *var, const char *type,
+                     const char *value)
+{
+	PurpleXmlNode *field = purple_xmlnode_new_child(x, "field");
+	PurpleXmlNode *child = NULL;
+
+	purple_xmlnode_set_attrib(field, "var", var);
+	if(type != NULL) {
+		purple_xmlnode_set_attrib(field, "type", type);
+	}
+
+	child = purple_xmlnode_new_child(field, "value");
+	purple_xmlnode_insert_data(child, value, -1);
+}
+
+static PurpleConversation *
+jabber_mam_get_conversation(JabberMamQuery *query, const gchar *name)
+{
+	JabberStream *js = query->js;
+	PurpleAccount *account = purple_connection_get_account(js->gc);
+	PurpleConversationManager *manager = NULL;
+	PurpleConversation *conv = NULL;
+
+	if(query->archive != NULL) {
+		JabberChat *chat = NULL;
+		JabberID *jid = jabber_id_new(name);
+
+		if(jid == NULL) {
+			return NULL;
+		}
+
+		chat = jabber_chat_find(js, jid->node, jid->domain);
+		jabber_id_free(jid);
+
+		/* We may have left the room while the page was in flight. */
+		if(chat == NULL || chat->conv == NULL) {
+			return NULL;
+		}
+
+		return PURPLE_CONVERSATION(chat->conv);
+	}
+
+	/* Open conversations the same way an offline message would. */
+	manager = purple_conversation_manager_get_default();
+	conv = purple_conversation_manager_find_im(manager, account, name);
+	if(conv == NULL) {
+		conv = purple_im_conversation_new(account, name);
+	}
+
+	return conv;
+}
+
+static void
+jabber_mam_write_conversation(JabberMamQuery *query, const gchar *name,
+                              GPtrArray *entries)
+{
+	PurpleConversation *conv = NULL;
+	PurpleHistoryManager *manager = NULL;
+	PurpleMessageEntry *batch = NULL;
+	GPtrArray *messages = NULL;
+	GError *error = NULL;
+
+	conv = jabber_mam_get_conversation(query, name);
+	if(conv == NULL) {
+		return;
+	}
+
+	batch = g_new0(PurpleMessageEntry, entries->len);
+	for(guint i = 0; i < entries->len; i++) {
+		JabberMamEntry *entry = g_ptr_array_index(entries, i);
+
+		batch[i].id = entry->id;
+		batch[i].author = entry->author;
+		batch[i].author_alias = entry->author;
+		batch[i].recipient = entry->recipient;
+		batch[i].contents = entry->contents;
+		batch[i].content_type = PURPLE_MESSAGE_CONTENT_TYPE_HTML;
+		batch[i].timestamp = entry->timestamp;
+		batch[i].flags = entry->flags;
+	}
+
+	messages = purple_message_new_batch(batch, entries->len);
+	g_free(batch);
+
+	/* This drops the messages we already have, which is what makes it safe
+	 * to overlap with what we saw live or on an earlier catch up. */
+	manager = purple_history_manager_get_default();
+	if(!purple_history_manager_write_messages(manager, conv, messages,
+	                                          &error))
+	{
+		purple_debug_warning("jabber", "Failed to write archived messages "
+		                     "for %s: %s", name,
+		                     error != NULL ? error->message : "unknown error");
+		g_clear_error(&error);
+	}
+
+	for(guint i = 0; i < messages->len; i++) {
+		PurpleMessage *message = g_ptr_array_index(messages, i);
+
+		/* They're already in the history, don't write them twice. */
+		purple_message_set_flags(message, purple_message_get_flags(message) |
+		                         PURPLE_MESSAGE_NO_LOG);
+		purple_conversation_write_message(conv, message);
+	}
+
+	g_ptr_array_unref(messages);
+}
+
+static void
+jabber_mam_query_flush(JabberMamQuery *query)
+{
+	GHashTable *groups = NULL;
+	GPtrArray *names = NULL;
+
+	if(query->page->len == 0) {
+		return;
+	}
+
+	/* Our own archive mixes all of our one to one conversations, so split the
+	 * page up per conversation while keeping each in archive order. */
+	groups = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+	                               (GDestroyNotify)g_ptr_array_unref);
+	names = g_ptr_array_new();
+
+	for(guint i = 0; i < query->page->len; i++) {
+		JabberMamEntry *entry = &g_array_index(query->page, JabberMamEntry, i);
+		GPtrArray *entries = NULL;
+
+		entries = g_hash_table_lookup(groups, entry->conversation);
+		if(entries == NULL) {
+			entries = g_ptr_array_new();
+			g_hash_table_insert(groups, entry->conversation, entries);
+			g_ptr_array_add(names, entry->conversation);
+		}
+
+		g_ptr_array_add(entries, entry);
+	}
+
+	for(guint i = 0; i < names->len; i++) {
+		const gchar *name = g_ptr_array_index(names, i);
+
+		jabber_mam_write_conversation(query, name,
+		                              g_hash_table_lookup(groups, name));
+	}
+
+	g_ptr_array_free(names, TRUE);
+	g_hash_table_destroy(groups);
+
+	g_array_set_size(query->page, 0);
+}
+
+static void jabber_mam_query_send(JabberMamQuery *query);
+
+static void
+jabber_mam_query_result_cb(JabberStream *js, G_GNUC_UNUSED const char *from,
+                           JabberIqType type, G_GNUC_UNUSED const char *id,
+                           PurpleXmlNode *packet, gpointer data)
+{
+	JabberMamQuery *query = data;
+	PurpleXmlNode *fin = NULL, *set = NULL, *last = NULL;
+	gboolean complete = FALSE;
+
+	if(type == JABBER_IQ_ERROR) {
+		PurpleXmlNode *error = purple_xmlnode_get_child(packet, "error");
+
+		if(query->after != NULL && query->start != NULL &&
+		   purple_xmlnode_get_child_with_namespace(error, "item-not-found",
+		                                           NS_XMPP_STANZAS) != NULL)
+		{
+			/* The last message we have isn't in the archive anymore, most
+			 * likely because it expired.  Ask by time instead. */
+			g_clear_pointer(&query->after, g_free);
+			g_array_set_size(query->page, 0);
+			jabber_mam_query_send(query);
+
+			return;
+		}
+
+		purple_debug_warning("jabber", "Archive query for %s failed",
+		                     query->archive ? query->archive : "our account");
+		g_hash_table_remove(js->mam->queries, query->queryid);
+
+		return;
+	}
+
+	jabber_mam_query_flush(query);
+
+	fin = purple_xmlnode_get_child_with_namespace(packet, "fin", NS_MAM);
+	set = purple_xmlnode_get_child_with_namespace(fin, "set", NS_RSM);
+	last = purple_xmlnode_get_child(set, "last");
+	complete = purple_strequal(purple_xmlnode_get_attrib(fin, "complete"),
+	                           "true");
+
+	query->pages++;
+	if(!complete && !query->latest && last != NULL &&
+	   query->pages < JABBER_MAM_MAX_PAGES)
+	{
+		g_free(query->after);
+		query->after = purple_xmlnode_get_data(last);
+		jabber_mam_query_send(query);
+
+		return;
+	}
+
+	g_hash_table_remove(js->mam->queries, query->queryid);
+}
+
+static void
+jabber_mam_query_send(JabberMamQuery *query)
+{
+	JabberStream *js = query->js;
+	JabberIq *iq = NULL;
+	PurpleXmlNode *node = NULL, *x = NULL, *set = NULL, *child = NULL;
+	gchar *max = NULL;
+
+	iq = jabber_iq_new_query(js, JABBER_IQ_SET, NS_MAM);
+	if(query->archive != NULL) {
+		purple_xmlnode_set_attrib(iq->node, "to", query->archive);
+	}
+
+	node = purple_xmlnode_get_child(iq->node, "query");
+	purple_xmlnode_set_attrib(node, "queryid", query->queryid);
+
+	x = purple_xmlnode_new_child(node, "x");
+	purple_xmlnode_set_namespace(x, NS_XDATA);
+	purple_xmlnode_set_attrib(x, "type", "submit");
+	jabber_mam_add_field(x, "FORM_TYPE", "hidden", NS_MAM);
+
+	if(query->after == NULL && query->start != NULL) {
+		gchar *start = g_date_time_format(query->start, "%Y-%m-%dT%H:%M:%SZ");
+
+		jabber_mam_add_field(x, "start", NULL, start);
+		g_free(start);
+	}
+
+	set = purple_xmlnode_new_child(node, "set");
+	purple_xmlnode_set_namespace(set, NS_RSM);
+
+	max = g_strdup_printf("%d", query->latest ? JABBER_MAM_INITIAL_PAGE_SIZE
+	                                          : JABBER_MAM_PAGE_SIZE);
+	child = purple_xmlnode_new_child(set, "max");
+	purple_xmlnode_insert_data(child, max, -1);
+	g_free(max);
+
+	if(query->after != NULL) {
+		child = purple_xmlnode_new_child(set, "after");
+		purple_xmlnode_insert_data(child, query->after, -1);
+	} else if(query->latest) {
+		/* An empty before asks for the last page of the archive. */
+		purple_xmlnode_new_child(set, "before");
+	}
+
+	jabber_iq_set_callback(iq, jabber_mam_query_result_cb, query);
+	jabber_iq_send(iq);
+}
+
+static void
+jabber_mam_check_room_cb(JabberStream *js, G_GNUC_UNUSED const char *from,
+                         JabberIqType type, G_GNUC_UNUSED const char *id,
+                         PurpleXmlNode *packet, gpointer data)
+{
+	JabberMamRoomCheck *check = data;
+	gboolean supported = FALSE;
+
+	if(type == JABBER_IQ_RESULT) {
+		PurpleXmlNode *query = purple_xmlnode_get_child(packet, "query");
+		PurpleXmlNode *feature = NULL;
+
+		for(feature = purple_xmlnode_get_child(query, "feature");
+		    feature != NULL;
+		    feature = purple_xmlnode_get_next_twin(feature))
+		{
+			const char *var = purple_xmlnode_get_attrib(feature, "var");
+
+			if(purple_strequal(var, NS_MAM)) {
+				supported = TRUE;
+				break;
+			}
+		}
+	}
+
+	g_hash_table_insert(js->mam->rooms, g_strdup(check->room_jid),
+	                    GINT_TO_POINTER(supported));
+
+	check->callback(js, check->room_jid, supported, check->data);
+
+	g_free(check->room_jid);
+	g_free(check);
+}
+
+/******************************************************************************
+ * API
+ *****************************************************************************/
+JabberMam *
+jabber_mam_new(void)
+{
+	JabberMam *mam = g_new0(JabberMam, 1);
+
+	mam->queries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+	                                     (GDestroyNotify)jabber_mam_query_free);
+	mam->rooms = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	return mam;
+}
+
+void
+jabber_mam_free(JabberMam *mam)
+{
+	if(mam == NULL) {
+		return;
+	}
+
+	g_hash_table_destroy(mam->queries);
+	g_hash_table_destroy(mam->rooms);
+	g_free(mam);
+}
+
+void
+jabber_mam_check_room(JabberStream *js, const char *room_jid,
+                      JabberMamRoomCallback *callback, gpointer data)
+{
+	JabberMamRoomCheck *check = NULL;
+	JabberIq *iq = NULL;
+	gpointer supported = NULL;
+
+	if(g_hash_table_lookup_extended(js->mam->rooms, room_jid, NULL,
+	                                &supported))
+	{
+		callback(js, room_jid, GPOINTER_TO_INT(supported), data);
+
+		return;
+	}
+
+	check = g_new0(JabberMamRoomCheck, 1);
+	check->callback = callback;
+	check->data = data;
+	check->room_jid = g_strdup(room_jid);
+
+	iq = jabber_iq_new_query(js, JABBER_IQ_GET, NS_DISCO_INFO);
+	purple_xmlnode_set_attrib(iq->node, "to", room_jid);
+	jabber_iq_set_callback(iq, jabber_mam_check_room_cb, check);
+	jabber_iq_send(iq);
+}
+
+gboolean
+jabber_mam_room_supported(JabberStream *js, const char *room_jid)
+{
+	return GPOINTER_TO_INT(g_hash_table_lookup(js->mam->rooms, room_jid));
+}
+
+void
+jabber_mam_catch_up(JabberStream *js)
+{
+	PurpleAccount *account = purple_connection_get_account(js->gc);
+	PurpleHistoryManager *manager = purple_history_manager_get_default();
+	PurpleMessage *last = NULL;
+	JabberMamQuery *query = NULL;
+
+	/* The newest message we have on this account tells us roughly when we
+	 * went away.  It could have come from a room, so only its time is useful
+	 * against our own archive.  Without it this account is new here and
+	 * there's nothing to catch up with. */
+	last = purple_history_manager_get_last_message(manager, account, NULL,
+	                                               NULL);
+	if(last == NULL) {
+		return;
+	}
+
+	query = jabber_mam_query_new(js, NULL);
+	jabber_mam_query_resume_from(query, last);
+	g_clear_pointer(&query->after, g_free);
+	g_object_unref(last);
+
+	jabber_mam_query_send(query);
+}
+
+void
+jabber_mam_catch_up_room(JabberChat *chat)
+{
+	JabberStream *js = chat->js;
+	PurpleAccount *account = purple_connection_get_account(js->gc);
+	PurpleHistoryManager *manager = purple_history_manager_get_default();
+	PurpleMessage *last = NULL;
+	JabberMamQuery *query = NULL;
+	gchar *room_jid = NULL;
+
+	room_jid = g_strdup_printf("%s@%s", chat->room, chat->server);
+	if(!jabber_mam_room_supported(js, room_jid)) {
+		g_free(room_jid);
+
+		return;
+	}
+
+	query = jabber_mam_query_new(js, room_jid);
+
+	last = purple_history_manager_get_last_message(manager, account, room_jid,
+	                                               NULL);
+	if(last != NULL) {
+		jabber_mam_query_resume_from(query, last);
+		g_object_unref(last);
+	} else {
+		query->latest = TRUE;
+	}
+
+	g_free(room_jid);
+
+	jabber_mam_query_send(query);
+}
+
+gboolean
+jabber_mam_parse_result(JabberStream *js, PurpleXmlNode *packet)
+{
+	PurpleXmlNode *result = NULL, *forwarded = NULL, *message = NULL;
+	PurpleXmlNode *delay = NULL, *body = NULL;
+	JabberMamQuery *query = NULL;
+	JabberMamEntry entry = { NULL, };
+	const char *queryid = NULL, *archive_id = NULL, *from = NULL;
+	const char *msg_from = NULL, *msg_to = NULL, *type = NULL;
+	gchar *text = NULL, *escaped = NULL;
+
+	result = purple_xmlnode_get_child_with_namespace(packet, "result", NS_MAM);
+	if(result == NULL) {
+		return FALSE;
+	}
+
+	/* From here on the packet is ours, even if we end up ignoring it. */
+	queryid = purple_xmlnode_get_attrib(result, "queryid");
+	if(queryid != NULL) {
+		query = g_hash_table_lookup(js->mam->queries, queryid);
+	}
+
+	if(query == NULL) {
+		purple_debug_info("jabber", "Ignoring unexpected archive result");
+
+		return TRUE;
+	}
+
+	/* Only the archive we asked may answer. */
+	from = purple_xmlnode_get_attrib(packet, "from");
+	if(query->archive == NULL ? !jabber_is_own_account(js, from)
+	                          : !purple_strequal(from, query->archive))
+	{
+		purple_debug_warning("jabber", "Ignoring archive result from %s",
+		                     from ? from : "(null)");
+
+		return TRUE;
+	}
+
+	archive_id = purple_xmlnode_get_attrib(result, "id");
+	forwarded = purple_xmlnode_get_child_with_namespace(result, "forwarded",
+	                                                    NS_FORWARD);
+	message = purple_xmlnode_get_child_with_namespace(forwarded, "message",
+	                                                  NS_XMPP_CLIENT);
+	body = purple_xmlnode_get_child(message, "body");
+	if(archive_id == NULL || body == NULL) {
+		return TRUE;
+	}
+
+	msg_from = purple_xmlnode_get_attrib(message, "from");
+	msg_to = purple_xmlnode_get_attrib(message, "to");
+	type = purple_xmlnode_get_attrib(message, "type");
+
+	if(query->archive != NULL) {
+		JabberID *jid = jabber_id_new(msg_from);
+		JabberChat *chat = NULL;
+
+		/* Messages from the room itself have no nick. */
+		if(jid == NULL || jid->resource == NULL) {
+			jabber_id_free(jid);
+
+			return TRUE;
+		}
+
+		chat = jabber_chat_find(js, jid->node, jid->domain);
+
+		entry.conversation = g_strdup(query->archive);
+		entry.author = g_strdup(jid->resource);
+		entry.flags = PURPLE_MESSAGE_RECV;
+		if(chat != NULL && purple_strequal(chat->handle, jid->resource)) {
+			entry.flags = PURPLE_MESSAGE_SEND;
+		}
+
+		jabber_id_free(jid);
+	} else {
+		if(purple_strequal(type, "groupchat") ||
+		   purple_strequal(type, "error") ||
+		   purple_strequal(type, "headline") ||
+		   msg_from == NULL || msg_to == NULL)
+		{
+			return TRUE;
+		}
+
+		if(jabber_mam_is_own_bare_jid(js, msg_from)) {
+			entry.conversation = jabber_get_bare_jid(msg_to);
+			entry.author = jabber_get_bare_jid(msg_from);
+			entry.recipient = g_strdup(entry.conversation);
+			entry.flags = PURPLE_MESSAGE_SEND;
+		} else {
+			entry.conversation = jabber_get_bare_jid(msg_from);
+			entry.author = g_strdup(entry.conversation);
+			entry.recipient = jabber_get_bare_jid(msg_to);
+			entry.flags = PURPLE_MESSAGE_RECV;
+		}
+
+		if(entry.conversation == NULL) {
+			jabber_mam_entry_clear(&entry);
+
+			return TRUE;
+		}
+	}
+
+	delay = purple_xmlnode_get_child_with_namespace(forwarded, "delay",
+	                                                NS_DELAYED_DELIVERY);
+	if(delay != NULL) {
+		const char *stamp = purple_xmlnode_get_attrib(delay, "stamp");
+
+		if(stamp != NULL) {
+			GTimeZone *tz = g_time_zone_new_utc();
+
+			entry.timestamp = g_date_time_new_from_iso8601(stamp, tz);
+			g_time_zone_unref(tz);
+		}
+	}
+	if(entry.timestamp == NULL) {
+		entry.timestamp = g_date_time_new_now_utc();
+	}
+
+	text = purple_xmlnode_get_data(body);
+	escaped = g_markup_escape_text(text ? text : "", -1);
+	entry.contents = purple_strdup_withhtml(escaped);
+	g_free(escaped);
+	g_free(text);
+
+	if(jabber_mam_is_boundary(query, entry.author, entry.contents,
+	                          entry.timestamp))
+	{
+		jabber_mam_entry_clear(&entry);
+
+		return TRUE;
+	}
+
+	entry.id = g_strdup(archive_id);
+	entry.flags |= PURPLE_MESSAGE_DELAYED;
+
+	g_array_append_val(query->page, entry);
+
+	return TRUE;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file mam.h Message Archive Management functions
+ *
+ * purple
+ *
+ * Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ */
+
+#ifndef PURPLE_JABBER_MAM_H
+#define PURPLE_JABBER_MAM_H
+
+#include <purple.h>
+
+#include "jabber.h"
+#include "chat.h"
+
+/* XEP-0313 Message Archive Management.  After a disconnect we page through
+ * the server's archives from the last message we have in the history and
+ * write each page out in one go, instead of relying on MUC history replays. */
+
+typedef void (JabberMamRoomCallback)(JabberStream *js, const char *room_jid,
+                                     gboolean supported, gpointer data);
+
+JabberMam *jabber_mam_new(void);
+void jabber_mam_free(JabberMam *mam);
+
+/* Finds out whether a room keeps an archive.  The answer is cached for the
+ * rest of the connection, so callback may be called before this returns. */
+void jabber_mam_check_room(JabberStream *js, const char *room_jid,
+                           JabberMamRoomCallback *callback, gpointer data);
+gboolean jabber_mam_room_supported(JabberStream *js, const char *room_jid);
+
+/* Fetches what we missed from our own archive and from a room's archive. */
+void jabber_mam_catch_up(JabberStream *js);
+void jabber_mam_catch_up_room(JabberChat *chat);
+
+/* Returns TRUE if packet was an archive result and has been consumed. */
+gboolean jabber_mam_parse_result(JabberStream *js, PurpleXmlNode *packet);
+
+#endif /* PURPLE_JABBER_MAM_H */
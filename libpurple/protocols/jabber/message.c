@@ -28,6 +28,7 @@
 #include "buddy.h"
 #include "chat.h"
 #include "data.h"
+#include "mam.h"
 #include "message.h"
 #include "pep.h"
 #include "iq.h"
@@ -81,6 +82,7 @@ void jabber_message_free(JabberMessage *jm)
 	g_free(jm->from);
 	g_free(jm->to);
 	g_free(jm->id);
+	g_free(jm->stanza_id);
 	g_free(jm->subject);
 	g_free(jm->body);
 	g_free(jm->xhtml);
@@ -95,6 +97,33 @@ void jabber_message_free(JabberMessage *jm)
 	g_free(jm);
 }
 
+static gboolean
+jabber_message_is_archive(JabberMessage *jm, const char *by)
+{
+	JabberID *archive = NULL, *room = NULL;
+	gboolean equal = FALSE;
+
+	if(by == NULL || *by == '\0') {
+		return FALSE;
+	}
+
+	if(jm->type != JABBER_MESSAGE_GROUPCHAT) {
+		return jabber_is_own_account(jm->js, by);
+	}
+
+	archive = jabber_id_new(by);
+	room = jabber_id_new(jm->from);
+	if(archive != NULL && room != NULL) {
+		equal = archive->resource == NULL &&
+		        purple_strequal(archive->node, room->node) &&
+		        purple_strequal(archive->domain, room->domain);
+	}
+	jabber_id_free(archive);
+	jabber_id_free(room);
+
+	return equal;
+}
+
 static void handle_chat(JabberMessage *jm)
 {
 	const gchar *contact = jm->outgoing ? jm->to : jm->from;
@@ -206,8 +235,9 @@ static void handle_chat(JabberMessage *jm)
 		}
 		flags |= jm->outgoing ? PURPLE_MESSAGE_SEND : PURPLE_MESSAGE_RECV;
 
-		purple_serv_got_im(gc, contact, body->str, flags,
-		                   (time_t)g_date_time_to_unix(jm->sent));
+		purple_serv_got_im_with_id(gc, contact, body->str, flags,
+		                           (time_t)g_date_time_to_unix(jm->sent),
+		                           jm->stanza_id);
 	}
 
 	jabber_id_free(jid);
@@ -272,9 +302,10 @@ static void handle_groupchat(JabberMessage *jm)
 		if(jid->resource) {
 			time_t sent = (time_t)g_date_time_to_unix(jm->sent);
 
-			purple_serv_got_chat_in(jm->js->gc, chat->id, jid->resource,
+			purple_serv_got_chat_in_with_id(jm->js->gc, chat->id, jid->resource,
 							messageFlags | (jm->delayed ? PURPLE_MESSAGE_DELAYED : 0),
-							jm->xhtml ? jm->xhtml : jm->body, sent);
+							jm->xhtml ? jm->xhtml : jm->body, sent,
+							jm->stanza_id);
 		} else if(chat->muc) {
 			purple_conversation_write_system_message(
 				PURPLE_CONVERSATION(chat->conv),
@@ -398,7 +429,14 @@ void jabber_message_parse(JabberStream *js, PurpleXmlNode *packet)
 	PurpleXmlNode *child = NULL, *received = NULL;
 	gboolean signal_return;
 	gboolean delayed = FALSE, is_outgoing = FALSE, is_forwarded = FALSE;
-	GDateTime *timestamp = g_date_time_new_now_utc();
+	GDateTime *timestamp = NULL;
+
+	/* Archive results are collected and written out a page at a time. */
+	if(jabber_mam_parse_result(js, packet)) {
+		return;
+	}
+
+	timestamp = g_date_time_new_now_utc();
 
 	/* Check if we have a carbons received element from our own account. */
 	from = purple_xmlnode_get_attrib(packet, "from");
@@ -597,6 +635,18 @@ void jabber_message_parse(JabberStream *js, PurpleXmlNode *packet)
 			jm->type = JABBER_MESSAGE_EVENT;
 			for(items = purple_xmlnode_get_child(child,"items"); items; items = items->next)
 				jm->eventitems = g_list_append(jm->eventitems, items);
+		} else if(purple_strequal(child->name, "stanza-id") && purple_strequal(xmlns, NS_STANZA_ID)) {
+			const char *by = purple_xmlnode_get_attrib(child, "by");
+			const char *stanza_id = purple_xmlnode_get_attrib(child, "id");
+
+			/* Anyone can add a stanza-id, so only use the one from the
+			 * archive the message went through: the room for groupchats
+			 * and our own account otherwise. */
+			if(stanza_id != NULL && jm->stanza_id == NULL &&
+			   jabber_message_is_archive(jm, by))
+			{
+				jm->stanza_id = g_strdup(stanza_id);
+			}
 		} else if(purple_strequal(child->name, "delay") && purple_strequal(xmlns, NS_DELAYED_DELIVERY)) {
 			const char *stamp = purple_xmlnode_get_attrib(child, "stamp");
 			if(stamp != NULL) {
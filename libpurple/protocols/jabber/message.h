@@ -46,6 +46,7 @@ typedef struct {
 	gboolean forwarded;
 	gboolean outgoing;
 	char *id;
+	char *stanza_id;
 	char *from;
 	char *to;
 	char *subject;
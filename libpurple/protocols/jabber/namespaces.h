@@ -30,6 +30,7 @@
 #define NS_XMPP_SESSION "urn:ietf:params:xml:ns:xmpp-session"
 #define NS_XMPP_STANZAS "urn:ietf:params:xml:ns:xmpp-stanzas"
 #define NS_XMPP_STREAMS "http://etherx.jabber.org/streams"
+#define NS_XMPP_STREAM_ERRORS "urn:ietf:params:xml:ns:xmpp-streams"
 #define NS_XMPP_TLS "urn:ietf:params:xml:ns:xmpp-tls"
 
 /* XEP-0012 Last Activity (and XEP-0256 Last Activity in Presence) */
@@ -39,9 +40,15 @@
 #define NS_DISCO_INFO "http://jabber.org/protocol/disco#info"
 #define NS_DISCO_ITEMS "http://jabber.org/protocol/disco#items"
 
+/* XEP-0004 Data Forms */
+#define NS_XDATA "jabber:x:data"
+
 /* XEP-0047 IBB (In-band bytestreams) */
 #define NS_IBB "http://jabber.org/protocol/ibb"
 
+/* XEP-0059 Result Set Management */
+#define NS_RSM "http://jabber.org/protocol/rsm"
+
 /* XEP-0065 SOCKS5 Bytestreams */
 #define NS_BYTESTREAMS "http://jabber.org/protocol/bytestreams"
 
@@ -66,6 +73,9 @@
 /* XEP-0191 Simple Communications Blocking */
 #define NS_SIMPLE_BLOCKING "urn:xmpp:blocking"
 
+/* XEP-0198 Stream Management */
+#define NS_STREAM_MANAGEMENT "urn:xmpp:sm:3"
+
 /* XEP-0199 Ping */
 #define NS_PING "urn:xmpp:ping"
 
@@ -79,6 +89,9 @@
 /* XEP-0206 XMPP over BOSH */
 #define NS_XMPP_BOSH "urn:xmpp:xbosh"
 
+/* RFC 7395 XMPP Subprotocol for WebSocket */
+#define NS_XMPP_FRAMING "urn:ietf:params:xml:ns:xmpp-framing"
+
 /* XEP-0231 BoB (Bits of Binary) */
 #define NS_BOB "urn:xmpp:bob"
 
@@ -97,4 +110,13 @@
 /* XEP-0297 Stanza Forwarding */
 #define NS_FORWARD "urn:xmpp:forward:0"
 
+/* XEP-0313 Message Archive Management */
+#define NS_MAM "urn:xmpp:mam:2"
+
+/* XEP-0352 Client State Indication */
+#define NS_CLIENT_STATE_INDICATION "urn:xmpp:csi:0"
+
+/* XEP-0359 Unique and Stable Stanza IDs */
+#define NS_STANZA_ID "urn:xmpp:sid:0"
+
 #endif /* PURPLE_JABBER_NAMESPACES_H */
@@ -69,7 +69,6 @@ jabber_oob_xfer_got_content_length(SoupMessage *msg, gpointer user_data)
 	purple_xfer_set_size(xfer, total);
 }
 
-#if SOUP_MAJOR_VERSION >= 3
 static void
 jabber_oob_xfer_writer(GObject *source, GAsyncResult *result, gpointer data) {
 	GInputStream *input = G_INPUT_STREAM(source);
@@ -88,7 +87,7 @@ jabber_oob_xfer_writer(GObject *source, GAsyncResult *result, gpointer data) {
 		purple_xfer_end(xfer);
 		g_clear_pointer(&bytes, g_bytes_unref);
 		g_clear_object(&input);
-		jox->msg = NULL;
+		g_clear_object(&jox->msg);
 		return;
 	}
 
@@ -99,7 +98,7 @@ jabber_oob_xfer_writer(GObject *source, GAsyncResult *result, gpointer data) {
 		purple_xfer_set_completed(xfer, TRUE);
 		purple_xfer_end(xfer);
 		g_clear_object(&input);
-		jox->msg = NULL;
+		g_clear_object(&jox->msg);
 		return;
 	}
 
@@ -107,7 +106,7 @@ jabber_oob_xfer_writer(GObject *source, GAsyncResult *result, gpointer data) {
 		purple_xfer_set_status(xfer, PURPLE_XFER_STATUS_CANCEL_LOCAL);
 		purple_xfer_end(xfer);
 		g_clear_object(&input);
-		jox->msg = NULL;
+		g_clear_object(&jox->msg);
 		return;
 	}
 
@@ -127,7 +126,7 @@ jabber_oob_xfer_send_cb(GObject *source, GAsyncResult *result, gpointer data) {
 	if(!SOUP_STATUS_IS_SUCCESSFUL(soup_message_get_status(jox->msg))) {
 		purple_xfer_set_status(xfer, PURPLE_XFER_STATUS_CANCEL_REMOTE);
 		purple_xfer_end(xfer);
-		jox->msg = NULL;
+		g_clear_object(&jox->msg);
 		return;
 	}
 
@@ -138,7 +137,7 @@ jabber_oob_xfer_send_cb(GObject *source, GAsyncResult *result, gpointer data) {
 		purple_xfer_set_status(xfer, PURPLE_XFER_STATUS_CANCEL_REMOTE);
 		purple_xfer_end(xfer);
 		g_clear_object(&input);
-		jox->msg = NULL;
+		g_clear_object(&jox->msg);
 		return;
 	}
 
@@ -148,64 +147,29 @@ jabber_oob_xfer_send_cb(GObject *source, GAsyncResult *result, gpointer data) {
 	                                jabber_oob_xfer_writer, xfer);
 }
 
-#else /* SOUP_MAJOR_VERSION < 3 */
-
-static void
-jabber_oob_xfer_got(G_GNUC_UNUSED SoupSession *session, SoupMessage *msg,
-                    gpointer user_data)
-{
-	PurpleXfer *xfer = user_data;
-	JabberOOBXfer *jox;
-
-	if (purple_xfer_is_cancelled(xfer))
-		return;
-
-	jox = JABBER_OOB_XFER(xfer);
-	jox->msg = NULL;
-
-	if (!SOUP_STATUS_IS_SUCCESSFUL(soup_message_get_status(msg)) ||
-	    purple_xfer_get_bytes_remaining(xfer) > 0) {
-		purple_xfer_set_status(xfer, PURPLE_XFER_STATUS_CANCEL_REMOTE);
-		purple_xfer_end(xfer);
-	} else {
-		purple_xfer_set_completed(xfer, TRUE);
-		purple_xfer_end(xfer);
-	}
-}
-
 static void
-jabber_oob_xfer_writer(SoupMessage *msg, SoupBuffer *chunk, gpointer user_data)
+jabber_oob_xfer_stream_cancelled_cb(G_GNUC_UNUSED GCancellable *stream,
+                                    gpointer data)
 {
-	PurpleXfer *xfer = user_data;
-
-	if (!purple_xfer_write_file(xfer, (const guchar *)chunk->data,
-	                            chunk->length)) {
-		JabberOOBXfer *jox = JABBER_OOB_XFER(xfer);
-		soup_session_cancel_message(jox->js->http_conns, msg,
-		                            SOUP_STATUS_IO_ERROR);
-	}
+	g_cancellable_cancel(data);
 }
-#endif
 
 static void jabber_oob_xfer_start(PurpleXfer *xfer)
 {
-	SoupMessage *msg;
 	JabberOOBXfer *jox = JABBER_OOB_XFER(xfer);
 
-	msg = soup_message_new("GET", jox->url);
+	/* The session is shared with other accounts, so disconnecting only
+	 * cancels the requests of this stream. */
+	g_cancellable_connect(jox->js->http_cancellable,
+	                      G_CALLBACK(jabber_oob_xfer_stream_cancelled_cb),
+	                      g_object_ref(jox->cancellable), g_object_unref);
+
+	jox->msg = soup_message_new("GET", jox->url);
 	soup_message_add_header_handler(
-	        msg, "got-headers", "Content-Length",
+	        jox->msg, "got-headers", "Content-Length",
 	        G_CALLBACK(jabber_oob_xfer_got_content_length), xfer);
-#if SOUP_MAJOR_VERSION >= 3
-	soup_session_send_async(jox->js->http_conns, msg, G_PRIORITY_DEFAULT,
+	soup_session_send_async(jox->js->http_conns, jox->msg, G_PRIORITY_DEFAULT,
 	                        jox->cancellable, jabber_oob_xfer_send_cb, xfer);
-#else
-	soup_message_body_set_accumulate(msg->response_body, FALSE);
-	g_signal_connect(msg, "got-chunk", G_CALLBACK(jabber_oob_xfer_writer),
-	                 xfer);
-	soup_session_queue_message(jox->js->http_conns, msg, jabber_oob_xfer_got,
-	                           xfer);
-#endif
 }
 
 static void jabber_oob_xfer_recv_error(PurpleXfer *xfer, const char *code) {
@@ -237,12 +201,7 @@ static void jabber_oob_xfer_recv_denied(PurpleXfer *xfer) {
 static void jabber_oob_xfer_recv_cancelled(PurpleXfer *xfer) {
 	JabberOOBXfer *jox = JABBER_OOB_XFER(xfer);
 
-#if SOUP_MAJOR_VERSION >= 3
 	g_cancellable_cancel(jox->cancellable);
-#else
-	soup_session_cancel_message(jox->js->http_conns, jox->msg,
-	                            SOUP_STATUS_CANCELLED);
-#endif
 
 	jabber_oob_xfer_recv_error(xfer, "404");
 }
@@ -295,9 +254,7 @@ void jabber_oob_parse(JabberStream *js, const char *from, JabberIqType type,
 
 static void
 jabber_oob_xfer_init(JabberOOBXfer *xfer) {
-#if SOUP_MAJOR_VERSION >= 3
 	xfer->cancellable = g_cancellable_new();
-#endif
 }
 
 static void
@@ -313,6 +270,7 @@ jabber_oob_xfer_finalize(GObject *obj) {
 		g_cancellable_cancel(jox->cancellable);
 	}
 	g_clear_object(&jox->cancellable);
+	g_clear_object(&jox->msg);
 
 	G_OBJECT_CLASS(jabber_oob_xfer_parent_class)->finalize(obj);
 }
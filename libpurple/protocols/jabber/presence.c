@@ -29,6 +29,7 @@
 #include "presence.h"
 #include "iq.h"
 #include "jutil.h"
+#include "mam.h"
 #include "adhoccommands.h"
 
 #include "usermood.h"
@@ -595,6 +596,7 @@ handle_presence_chat(JabberStream *js, JabberPresence *presence, PurpleXmlNode *
 			purple_chat_conversation_set_nick(chat->conv, chat->handle);
 
 			jabber_chat_disco_traffic(chat);
+			jabber_mam_catch_up_room(chat);
 			g_free(room_jid);
 		}
 
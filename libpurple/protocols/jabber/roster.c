@@ -45,12 +45,137 @@ static gchar *roster_groups_join(GSList *list)
 	return g_string_free(out, FALSE);
 }
 
+/* Roster versioning (XEP-0237) keeps the last roster version in the account
+ * and the items themselves on the buddy list. The buddy list already stores
+ * the names, aliases and groups, so only the subscription state needs to be
+ * saved on each buddy.
+ */
+#define ROSTER_VERSION_SETTING "roster_ver"
+#define ROSTER_SUBSCRIPTION_SETTING "roster-subscription"
+
+static gboolean
+roster_versioning_supported(JabberStream *js)
+{
+	return (js->server_caps & JABBER_CAP_ROSTER_VERSIONING) != 0;
+}
+
+static void
+roster_save_version(JabberStream *js, const char *ver)
+{
+	PurpleAccount *account = purple_connection_get_account(js->gc);
+
+	if (ver == NULL || !roster_versioning_supported(js))
+		return;
+
+	purple_account_set_string(account, ROSTER_VERSION_SETTING, ver);
+}
+
+static void
+roster_save_subscription(JabberStream *js, const char *jid, JabberBuddy *jb)
+{
+	GSList *buddies;
+
+	buddies = purple_blist_find_buddies(purple_connection_get_account(js->gc),
+	                                    jid);
+	while (buddies) {
+		purple_blist_node_set_int(PURPLE_BLIST_NODE(buddies->data),
+		                          ROSTER_SUBSCRIPTION_SETTING,
+		                          jb->subscription);
+		buddies = g_slist_delete_link(buddies, buddies);
+	}
+}
+
+/*
+ * Returns the version of the roster stored on the buddy list, or an empty
+ * string if there isn't a usable one. The stored version is only trusted if
+ * the buddy list still has the items it describes, otherwise the server would
+ * tell us nothing changed and we would end up with an empty roster.
+ */
+static const char *
+roster_get_cached_version(JabberStream *js)
+{
+	PurpleAccount *account = purple_connection_get_account(js->gc);
+	const char *ver;
+	GSList *buddies, *l;
+	gboolean usable = FALSE;
+
+	ver = purple_account_get_string(account, ROSTER_VERSION_SETTING, "");
+	if (*ver == '\0')
+		return "";
+
+	buddies = purple_blist_find_buddies(account, NULL);
+	for (l = buddies; l; l = l->next) {
+		if (purple_blist_node_has_setting(PURPLE_BLIST_NODE(l->data),
+		                                  ROSTER_SUBSCRIPTION_SETTING)) {
+			usable = TRUE;
+			break;
+		}
+	}
+	g_slist_free(buddies);
+
+	return usable ? ver : "";
+}
+
+/*
+ * The server told us the roster hasn't changed since the version we sent, so
+ * rebuild the subscription state from what we saved on the buddy list.
+ */
+static void
+roster_load_cached(JabberStream *js)
+{
+	PurpleAccount *account = purple_connection_get_account(js->gc);
+	GSList *buddies;
+	gboolean self = FALSE;
+
+	buddies = purple_blist_find_buddies(account, NULL);
+	while (buddies) {
+		PurpleBlistNode *node = PURPLE_BLIST_NODE(buddies->data);
+		JabberBuddy *jb;
+
+		buddies = g_slist_delete_link(buddies, buddies);
+
+		if (!purple_blist_node_has_setting(node, ROSTER_SUBSCRIPTION_SETTING))
+			continue;
+
+		jb = jabber_buddy_find(js, purple_buddy_get_name(PURPLE_BUDDY(node)),
+		                       TRUE);
+		if (jb == NULL)
+			continue;
+
+		jb->subscription = purple_blist_node_get_int(node,
+		                                             ROSTER_SUBSCRIPTION_SETTING);
+		if (jb == js->user_jb)
+			self = TRUE;
+	}
+
+	if (self)
+		jabber_presence_fake_to_self(js, NULL);
+}
+
+/*
+ * We're about to receive the whole roster, forget the saved subscriptions so
+ * that anything which was removed while we were offline doesn't linger.
+ */
+static void
+roster_clear_cached(JabberStream *js)
+{
+	GSList *buddies;
+
+	buddies = purple_blist_find_buddies(purple_connection_get_account(js->gc),
+	                                    NULL);
+	while (buddies) {
+		purple_blist_node_remove_setting(PURPLE_BLIST_NODE(buddies->data),
+		                                 ROSTER_SUBSCRIPTION_SETTING);
+		buddies = g_slist_delete_link(buddies, buddies);
+	}
+}
+
 static void
 roster_request_cb(JabberStream *js, const char *from, JabberIqType type,
-                  const char *id, PurpleXmlNode *packet,
-                  G_GNUC_UNUSED gpointer data)
+                  const char *id, PurpleXmlNode *packet, gpointer data)
 {
 	PurpleXmlNode *query;
+	gboolean sent_version = GPOINTER_TO_INT(data);
 
 	if (type == JABBER_IQ_ERROR) {
 		/*
@@ -65,10 +190,18 @@ roster_request_cb(JabberStream *js, const char *from, JabberIqType type,
 
 	query = purple_xmlnode_get_child(packet, "query");
 	if (query == NULL) {
+		/* An empty result to a versioned request means our copy is current
+		 * and any changes will follow as roster pushes. */
+		if (sent_version) {
+			purple_debug_info("jabber", "Roster is unchanged, using the "
+			                  "cached copy\n");
+			roster_load_cached(js);
+		}
 		jabber_stream_set_state(js, JABBER_STREAM_CONNECTED);
 		return;
 	}
 
+	roster_clear_cached(js);
 	jabber_roster_parse(js, from, type, id, query);
 	jabber_stream_set_state(js, JABBER_STREAM_CONNECTED);
 }
@@ -76,10 +209,21 @@ roster_request_cb(JabberStream *js, const char *from, JabberIqType type,
 void jabber_roster_request(JabberStream *js)
 {
 	JabberIq *iq;
+	gboolean sent_version = FALSE;
 
 	iq = jabber_iq_new_query(js, JABBER_IQ_GET, "jabber:iq:roster");
 
-	jabber_iq_set_callback(iq, roster_request_cb, NULL);
+	if (roster_versioning_supported(js)) {
+		PurpleXmlNode *query = purple_xmlnode_get_child(iq->node, "query");
+		const char *ver = roster_get_cached_version(js);
+
+		/* An empty version asks for the whole roster, but lets the server
+		 * know we want a version to go with it. */
+		purple_xmlnode_set_attrib(query, "ver", ver);
+		sent_version = (*ver != '\0');
+	}
+
+	jabber_iq_set_callback(iq, roster_request_cb, GINT_TO_POINTER(sent_version));
 	jabber_iq_send(iq);
 }
 
@@ -259,11 +403,15 @@ void jabber_roster_parse(JabberStream *js, const char *from,
 			}
 
 			add_purple_buddy_to_groups(js, jid, name, groups);
+			roster_save_subscription(js, jid, jb);
 			if (jb == js->user_jb)
 				jabber_presence_fake_to_self(js, NULL);
 		}
 	}
 
+	/* Only remember the version once all of its items have been applied. */
+	roster_save_version(js, purple_xmlnode_get_attrib(query, "ver"));
+
 	if (type == JABBER_IQ_SET) {
 		JabberIq *ack = jabber_iq_new(js, JABBER_IQ_RESULT);
 		jabber_iq_set_id(ack, id);
@@ -0,0 +1,527 @@
+/*
+ * purple - Jabber Protocol Plugin
+ *
+ * Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ */
+
+#include <glib/gi18n-lib.h>
+
+#include <purple.h>
+
+#include "jabber.h"
+#include "sm.h"
+
+/* Ask the server to acknowledge after this many stanzas, or after this many
+ * seconds if fewer were sent. */
+#define JABBER_SM_REQUEST_EVERY 5
+#define JABBER_SM_REQUEST_DELAY 10
+
+struct _JabberStreamManagement {
+	/* Whether the current stream features offered stream management. */
+	gboolean supported;
+
+	/* Counting our stanzas starts when we send <enable/>, counting the
+	 * server's starts when it answers with <enabled/>. */
+	gboolean enabled;
+	gboolean inbound_enabled;
+
+	/* The id to resume with, NULL if the server doesn't allow resumption. */
+	gchar *resume_id;
+	gboolean resuming;
+
+	/* The number of stanzas we've handled, the 'h' we report. */
+	guint32 inbound;
+
+	/* The number of our stanzas the server has acknowledged so far. */
+	guint32 acked;
+	GQueue unacked;
+
+	guint unrequested;
+	guint request_timer;
+};
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static gboolean
+jabber_sm_is_stanza(PurpleXmlNode *node)
+{
+	return purple_strequal(node->name, "message") ||
+	       purple_strequal(node->name, "presence") ||
+	       purple_strequal(node->name, "iq");
+}
+
+static gboolean
+jabber_sm_parse_h(PurpleXmlNode *packet, guint32 *h)
+{
+	const gchar *value = purple_xmlnode_get_attrib(packet, "h");
+	guint64 parsed = 0;
+
+	if (value == NULL ||
+	    !g_ascii_string_to_unsigned(value, 10, 0, G_MAXUINT32, &parsed, NULL))
+	{
+		return FALSE;
+	}
+
+	*h = (guint32)parsed;
+
+	return TRUE;
+}
+
+static void
+jabber_sm_request_ack(JabberStream *js)
+{
+	PurpleXmlNode *r = purple_xmlnode_new("r");
+
+	purple_xmlnode_set_namespace(r, NS_STREAM_MANAGEMENT);
+	jabber_send(js, r);
+	purple_xmlnode_free(r);
+
+	js->sm->unrequested = 0;
+}
+
+static gboolean
+jabber_sm_request_timeout_cb(gpointer data)
+{
+	JabberStream *js = data;
+	JabberStreamManagement *sm = js->sm;
+
+	sm->request_timer = 0;
+
+	if (!sm->resuming && !g_queue_is_empty(&sm->unacked)) {
+		jabber_sm_request_ack(js);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+/* XEP-0198 section 4: acknowledging stanzas we never sent is a protocol
+ * error, there's no telling what the server did with the ones we did send. */
+static void
+jabber_sm_handled_count_too_high(JabberStream *js, guint32 h)
+{
+	JabberStreamManagement *sm = js->sm;
+	PurpleXmlNode *error, *child;
+	gchar *value;
+
+	purple_debug_error("jabber", "Server acknowledged stanza %u but we only "
+	                   "sent %u", h,
+	                   sm->acked + g_queue_get_length(&sm->unacked));
+
+	error = purple_xmlnode_new("stream:error");
+	child = purple_xmlnode_new_child(error, "undefined-condition");
+	purple_xmlnode_set_namespace(child, NS_XMPP_STREAM_ERRORS);
+
+	child = purple_xmlnode_new_child(error, "handled-count-too-high");
+	purple_xmlnode_set_namespace(child, NS_STREAM_MANAGEMENT);
+	value = g_strdup_printf("%u", h);
+	purple_xmlnode_set_attrib(child, "h", value);
+	g_free(value);
+	value = g_strdup_printf("%u",
+	                        sm->acked + g_queue_get_length(&sm->unacked));
+	purple_xmlnode_set_attrib(child, "send-count", value);
+	g_free(value);
+
+	jabber_send(js, error);
+	purple_xmlnode_free(error);
+
+	/* Resuming would only replay the same mismatch. */
+	g_clear_pointer(&sm->resume_id, g_free);
+
+	purple_connection_error(js->gc, PURPLE_CONNECTION_ERROR_NETWORK_ERROR,
+	                        _("The server acknowledged more stanzas than "
+	                          "were sent"));
+}
+
+static gboolean
+jabber_sm_handle_h(JabberStream *js, guint32 h)
+{
+	if (!jabber_sm_queue_ack(js->sm, h, NULL)) {
+		jabber_sm_handled_count_too_high(js, h);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+jabber_sm_handle_ack(JabberStream *js, PurpleXmlNode *packet)
+{
+	guint32 h = 0;
+
+	if (!jabber_sm_parse_h(packet, &h)) {
+		purple_debug_warning("jabber", "Ignoring stream management ack "
+		                     "without a valid h");
+		return;
+	}
+
+	jabber_sm_handle_h(js, h);
+}
+
+static void
+jabber_sm_handle_request(JabberStream *js)
+{
+	PurpleXmlNode *a;
+	gchar *h;
+
+	if (!js->sm->inbound_enabled) {
+		return;
+	}
+
+	h = g_strdup_printf("%u", js->sm->inbound);
+	a = purple_xmlnode_new("a");
+	purple_xmlnode_set_namespace(a, NS_STREAM_MANAGEMENT);
+	purple_xmlnode_set_attrib(a, "h", h);
+	jabber_send(js, a);
+	purple_xmlnode_free(a);
+	g_free(h);
+}
+
+static void
+jabber_sm_handle_enabled(JabberStream *js, PurpleXmlNode *packet)
+{
+	JabberStreamManagement *sm = js->sm;
+	const gchar *resume = purple_xmlnode_get_attrib(packet, "resume");
+
+	sm->inbound_enabled = TRUE;
+	sm->inbound = 0;
+
+	g_clear_pointer(&sm->resume_id, g_free);
+	if (purple_strequal(resume, "true") || purple_strequal(resume, "1")) {
+		sm->resume_id = g_strdup(purple_xmlnode_get_attrib(packet, "id"));
+	}
+
+	purple_debug_info("jabber", "Stream management enabled%s",
+	                  sm->resume_id != NULL ? " with resumption" : "");
+}
+
+static void
+jabber_sm_handle_resumed(JabberStream *js, PurpleXmlNode *packet)
+{
+	JabberStreamManagement *sm = js->sm;
+	GQueue pending = G_QUEUE_INIT;
+	guint32 h = 0;
+
+	if (jabber_sm_parse_h(packet, &h) && !jabber_sm_handle_h(js, h)) {
+		return;
+	}
+
+	purple_debug_info("jabber", "Stream resumed, resending %u stanzas",
+	                  g_queue_get_length(&sm->unacked));
+
+	sm->resuming = FALSE;
+	js->state = JABBER_STREAM_CONNECTED;
+	jabber_stream_restart_inactivity_timer(js);
+
+	/* Everything left was either lost with the old connection or queued
+	 * while we were away. Send it again; jabber_send() puts each stanza back
+	 * in the queue in the same order. */
+	pending = sm->unacked;
+	g_queue_init(&sm->unacked);
+
+	while (!g_queue_is_empty(&pending)) {
+		PurpleXmlNode *stanza = g_queue_pop_head(&pending);
+
+		jabber_send(js, stanza);
+		purple_xmlnode_free(stanza);
+	}
+}
+
+static void
+jabber_sm_handle_failed(JabberStream *js)
+{
+	JabberStreamManagement *sm = js->sm;
+
+	if (sm->resuming) {
+		/* The old session is gone, start over with a full login. */
+		purple_connection_error(js->gc, PURPLE_CONNECTION_ERROR_NETWORK_ERROR,
+		                        _("Unable to resume the XMPP stream"));
+		return;
+	}
+
+	purple_debug_warning("jabber", "Server refused to enable stream "
+	                     "management");
+
+	sm->enabled = FALSE;
+	sm->inbound_enabled = FALSE;
+	g_queue_clear_full(&sm->unacked, (GDestroyNotify)purple_xmlnode_free);
+}
+
+/******************************************************************************
+ * Queue
+ *****************************************************************************/
+JabberStreamManagement *
+jabber_sm_new(void)
+{
+	JabberStreamManagement *sm = g_new0(JabberStreamManagement, 1);
+
+	g_queue_init(&sm->unacked);
+
+	return sm;
+}
+
+void
+jabber_sm_free(JabberStreamManagement *sm)
+{
+	if (sm == NULL) {
+		return;
+	}
+
+	g_clear_handle_id(&sm->request_timer, g_source_remove);
+	g_queue_clear_full(&sm->unacked, (GDestroyNotify)purple_xmlnode_free);
+	g_free(sm->resume_id);
+	g_free(sm);
+}
+
+void
+jabber_sm_queue_push(JabberStreamManagement *sm, PurpleXmlNode *stanza)
+{
+	g_return_if_fail(sm != NULL);
+	g_return_if_fail(stanza != NULL);
+
+	g_queue_push_tail(&sm->unacked, stanza);
+}
+
+gboolean
+jabber_sm_queue_ack(JabberStreamManagement *sm, guint32 h, guint *dropped)
+{
+	guint32 count;
+
+	g_return_val_if_fail(sm != NULL, FALSE);
+
+	/* h wraps around at 2^32, unsigned arithmetic takes care of that. Every
+	 * stanza that counts towards h is queued, so the server can't be ahead
+	 * of us. */
+	count = h - sm->acked;
+	if (count > g_queue_get_length(&sm->unacked)) {
+		return FALSE;
+	}
+
+	if (dropped != NULL) {
+		*dropped = count;
+	}
+
+	for (guint32 i = 0; i < count; i++) {
+		purple_xmlnode_free(g_queue_pop_head(&sm->unacked));
+	}
+
+	sm->acked = h;
+
+	return TRUE;
+}
+
+void
+jabber_sm_queue_reset(JabberStreamManagement *sm, guint32 h)
+{
+	g_return_if_fail(sm != NULL);
+
+	g_queue_clear_full(&sm->unacked, (GDestroyNotify)purple_xmlnode_free);
+	sm->acked = h;
+}
+
+guint
+jabber_sm_queue_get_length(JabberStreamManagement *sm)
+{
+	g_return_val_if_fail(sm != NULL, 0);
+
+	return g_queue_get_length(&sm->unacked);
+}
+
+/******************************************************************************
+ * Stream
+ *****************************************************************************/
+void
+jabber_sm_features_parse(JabberStream *js, PurpleXmlNode *features)
+{
+	js->sm->supported = purple_xmlnode_get_child_with_namespace(features, "sm",
+	                            NS_STREAM_MANAGEMENT) != NULL;
+}
+
+gboolean
+jabber_sm_is_supported(JabberStream *js)
+{
+	return js->sm->supported;
+}
+
+void
+jabber_sm_enable(JabberStream *js)
+{
+	JabberStreamManagement *sm = js->sm;
+	PurpleXmlNode *enable;
+
+	/* BOSH has its own way of surviving connection loss, and resumption only
+	 * knows how to reconnect plain TCP streams. */
+	if (!sm->supported || sm->enabled || js->bosh != NULL ||
+	    js->websocket != NULL) {
+		return;
+	}
+
+	enable = purple_xmlnode_new("enable");
+	purple_xmlnode_set_namespace(enable, NS_STREAM_MANAGEMENT);
+	purple_xmlnode_set_attrib(enable, "resume", "true");
+	jabber_send(js, enable);
+	purple_xmlnode_free(enable);
+
+	sm->enabled = TRUE;
+	jabber_sm_queue_reset(sm, 0);
+}
+
+void
+jabber_sm_parse(JabberStream *js, PurpleXmlNode *packet)
+{
+	const gchar *name = packet->name;
+
+	if (purple_strequal(name, "a")) {
+		jabber_sm_handle_ack(js, packet);
+	} else if (purple_strequal(name, "r")) {
+		jabber_sm_handle_request(js);
+	} else if (purple_strequal(name, "enabled")) {
+		jabber_sm_handle_enabled(js, packet);
+	} else if (purple_strequal(name, "resumed")) {
+		jabber_sm_handle_resumed(js, packet);
+	} else if (purple_strequal(name, "failed")) {
+		jabber_sm_handle_failed(js);
+	} else {
+		purple_debug_warning("jabber", "Unknown stream management "
+		                     "element: %s", name);
+	}
+}
+
+void
+jabber_sm_stanza_received(JabberStream *js, PurpleXmlNode *stanza)
+{
+	if (js->sm->inbound_enabled && jabber_sm_is_stanza(stanza)) {
+		js->sm->inbound++;
+	}
+}
+
+gboolean
+jabber_sm_stanza_sent(JabberStream *js, PurpleXmlNode *stanza)
+{
+	JabberStreamManagement *sm = js->sm;
+
+	if (!sm->enabled || !jabber_sm_is_stanza(stanza)) {
+		return TRUE;
+	}
+
+	jabber_sm_queue_push(sm, purple_xmlnode_copy(stanza));
+
+	/* While we're reconnecting the stanza just waits in the queue. */
+	if (sm->resuming) {
+		return FALSE;
+	}
+
+	sm->unrequested++;
+	if (sm->unrequested >= JABBER_SM_REQUEST_EVERY) {
+		g_clear_handle_id(&sm->request_timer, g_source_remove);
+		/* The <r/> has to follow the stanza, so hold it until this one has
+		 * been written. */
+		sm->request_timer = g_idle_add(jabber_sm_request_timeout_cb, js);
+	} else if (sm->request_timer == 0) {
+		sm->request_timer = g_timeout_add_seconds(JABBER_SM_REQUEST_DELAY,
+		                                          jabber_sm_request_timeout_cb,
+		                                          js);
+	}
+
+	return TRUE;
+}
+
+gboolean
+jabber_sm_is_enabled(JabberStream *js)
+{
+	return js->sm->enabled;
+}
+
+gboolean
+jabber_sm_send_raw(JabberStream *js, const gchar *data, gint len)
+{
+	PurpleXmlNode *root, *child;
+	gchar *wrapped;
+
+	g_return_val_if_fail(js->sm->enabled, FALSE);
+
+	if (len < 0) {
+		len = strlen(data);
+	}
+
+	/* The text may hold any number of elements, parse them all at once. */
+	wrapped = g_strdup_printf("<raw>%.*s</raw>", len, data);
+	root = purple_xmlnode_from_str(wrapped, -1);
+	g_free(wrapped);
+
+	/* Writing it anyway could send stanzas we don't count, and the server's
+	 * h would then be ahead of us, which ends the stream. */
+	if (root == NULL) {
+		purple_debug_warning("jabber", "Not sending unparsable raw data, "
+		                     "stream management can't count it");
+		return FALSE;
+	}
+
+	for (child = root->child; child != NULL; child = child->next) {
+		if (child->type == PURPLE_XMLNODE_TYPE_TAG) {
+			jabber_send(js, child);
+		}
+	}
+
+	purple_xmlnode_free(root);
+
+	return TRUE;
+}
+
+gboolean
+jabber_sm_can_resume(JabberStream *js)
+{
+	return js->sm->resume_id != NULL && !js->sm->resuming &&
+	       js->state == JABBER_STREAM_CONNECTED;
+}
+
+gboolean
+jabber_sm_is_resuming(JabberStream *js)
+{
+	return js->sm->resuming;
+}
+
+void
+jabber_sm_begin_resume(JabberStream *js)
+{
+	JabberStreamManagement *sm = js->sm;
+
+	sm->resuming = TRUE;
+	sm->supported = FALSE;
+	sm->unrequested = 0;
+	g_clear_handle_id(&sm->request_timer, g_source_remove);
+}
+
+void
+jabber_sm_resume(JabberStream *js)
+{
+	JabberStreamManagement *sm = js->sm;
+	PurpleXmlNode *resume;
+	gchar *h;
+
+	h = g_strdup_printf("%u", sm->inbound);
+	resume = purple_xmlnode_new("resume");
+	purple_xmlnode_set_namespace(resume, NS_STREAM_MANAGEMENT);
+	purple_xmlnode_set_attrib(resume, "previd", sm->resume_id);
+	purple_xmlnode_set_attrib(resume, "h", h);
+	jabber_send(js, resume);
+	purple_xmlnode_free(resume);
+	g_free(h);
+}
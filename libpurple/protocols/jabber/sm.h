@@ -0,0 +1,69 @@
+/**
+ * @file sm.h Stream Management functions
+ *
+ * purple
+ *
+ * Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
+ */
+
+#ifndef PURPLE_JABBER_SM_H
+#define PURPLE_JABBER_SM_H
+
+#include <purple.h>
+
+#include "jabber.h"
+
+/* XEP-0198 Stream Management */
+
+JabberStreamManagement *jabber_sm_new(void);
+void jabber_sm_free(JabberStreamManagement *sm);
+
+/* Unacknowledged stanza queue. jabber_sm_queue_push() takes ownership of
+ * stanza, jabber_sm_queue_ack() drops everything the server has handled
+ * according to h and sets dropped to how many stanzas that was. It returns
+ * FALSE without dropping anything if h counts more stanzas than were queued. */
+void jabber_sm_queue_push(JabberStreamManagement *sm, PurpleXmlNode *stanza);
+gboolean jabber_sm_queue_ack(JabberStreamManagement *sm, guint32 h, guint *dropped);
+guint jabber_sm_queue_get_length(JabberStreamManagement *sm);
+
+/* Drops the whole queue and starts counting our stanzas again from h. */
+void jabber_sm_queue_reset(JabberStreamManagement *sm, guint32 h);
+
+void jabber_sm_features_parse(JabberStream *js, PurpleXmlNode *features);
+gboolean jabber_sm_is_supported(JabberStream *js);
+void jabber_sm_enable(JabberStream *js);
+void jabber_sm_parse(JabberStream *js, PurpleXmlNode *packet);
+
+void jabber_sm_stanza_received(JabberStream *js, PurpleXmlNode *stanza);
+gboolean jabber_sm_stanza_sent(JabberStream *js, PurpleXmlNode *stanza);
+
+gboolean jabber_sm_is_enabled(JabberStream *js);
+
+/* Sends raw text as elements while stream management is enabled, so that
+ * any stanzas in it are queued and counted. Returns FALSE without sending
+ * anything if the text can't be parsed, since stanzas in it would go
+ * uncounted. */
+gboolean jabber_sm_send_raw(JabberStream *js, const gchar *data, gint len);
+
+gboolean jabber_sm_can_resume(JabberStream *js);
+gboolean jabber_sm_is_resuming(JabberStream *js);
+void jabber_sm_begin_resume(JabberStream *js);
+void jabber_sm_resume(JabberStream *js);
+
+#endif /* PURPLE_JABBER_SM_H */
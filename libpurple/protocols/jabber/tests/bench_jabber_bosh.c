@@ -0,0 +1,271 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Signs an XMPP account on over BOSH to a stand-in connection manager
+ * running in the same process, then sends bursts of pings through it and
+ * reports how long each took to be answered.  The stand-in adds a fixed
+ * delay to every HTTP response to play the part of the network.
+ */
+
+#include <glib.h>
+
+#include <purple.h>
+
+#include "bench_latency.h"
+#include "bosh_stub.h"
+#include "test_ui.h"
+
+/* Seconds the stand-in holds an empty request before answering it. */
+#define STUB_WAIT (5)
+
+static gint duration = 10;
+static gint rate = 200;
+static gint burst = 10;
+static gint rtt = 50;
+
+static GOptionEntry entries[] = {
+	{
+		"duration", 'd', 0, G_OPTION_ARG_INT, &duration,
+		"How long to send pings for in seconds", "SECONDS"
+	}, {
+		"rate", 'r', 0, G_OPTION_ARG_INT, &rate,
+		"Pings per second", "N"
+	}, {
+		"burst", 'b', 0, G_OPTION_ARG_INT, &burst,
+		"Pings sent at once", "N"
+	}, {
+		"rtt", 0, 0, G_OPTION_ARG_INT, &rtt,
+		"Delay added to every HTTP response in milliseconds", "MS"
+	},
+	G_OPTION_ENTRY_NULL
+};
+
+typedef struct {
+	GMainLoop *loop;
+	BoshStub *stub;
+	PurpleConnection *connection;
+
+	gboolean running;
+	gint64 started;
+	gint64 elapsed;
+
+	GArray *sent;
+	GArray *latencies;
+} BenchData;
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static void
+report(BenchData *data) {
+	gdouble seconds = (gdouble)data->elapsed / G_USEC_PER_SEC;
+
+	bench_latency_sort(data->latencies);
+
+	g_print("duration            %10.1f s\n", seconds);
+	g_print("pings sent          %10u\n", data->sent->len);
+	g_print("pings answered      %10.0f /s\n", data->latencies->len / seconds);
+	g_print("http requests       %10u\n", data->stub->requests);
+	g_print("max open requests   %10u\n", data->stub->max_open);
+	g_print("round trip          p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, "
+	        "max %.2f ms\n",
+	        bench_latency_percentile(data->latencies, 50),
+	        bench_latency_percentile(data->latencies, 90),
+	        bench_latency_percentile(data->latencies, 99),
+	        bench_latency_percentile(data->latencies, 100));
+}
+
+/******************************************************************************
+ * Callbacks
+ *****************************************************************************/
+static void
+receiving_xmlnode_cb(G_GNUC_UNUSED PurpleConnection *connection,
+                     PurpleXmlNode **packet, gpointer user_data)
+{
+	BenchData *data = user_data;
+	const gchar *id = NULL;
+	guint64 index = 0;
+
+	if(*packet == NULL || !purple_strequal((*packet)->name, "iq")) {
+		return;
+	}
+
+	id = purple_xmlnode_get_attrib(*packet, "id");
+	if(id == NULL || !g_str_has_prefix(id, "bench-")) {
+		return;
+	}
+
+	index = g_ascii_strtoull(id + 6, NULL, 10);
+	if(index < data->sent->len) {
+		gint64 latency = g_get_monotonic_time() -
+		                 g_array_index(data->sent, gint64, index);
+
+		g_array_append_val(data->latencies, latency);
+	}
+}
+
+static gboolean
+send_cb(gpointer user_data) {
+	BenchData *data = user_data;
+	PurpleProtocol *protocol = NULL;
+
+	protocol = purple_connection_get_protocol(data->connection);
+
+	for(gint i = 0; i < burst; i++) {
+		gint64 now = g_get_monotonic_time();
+		gchar *ping = NULL;
+
+		ping = g_strdup_printf("<iq type='get' id='bench-%u'>"
+		                       "<ping xmlns='urn:xmpp:ping'/></iq>",
+		                       data->sent->len);
+		g_array_append_val(data->sent, now);
+
+		purple_protocol_server_send_raw(PURPLE_PROTOCOL_SERVER(protocol),
+		                                data->connection, ping, -1);
+		g_free(ping);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+stop_cb(gpointer user_data) {
+	BenchData *data = user_data;
+
+	data->running = FALSE;
+	data->elapsed = g_get_monotonic_time() - data->started;
+
+	g_main_loop_quit(data->loop);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+signing_on_cb(PurpleConnection *connection, G_GNUC_UNUSED gpointer user_data)
+{
+	/* The stand-in takes any password, but PLAIN needs one to send. */
+	purple_connection_set_password(connection, "bench");
+}
+
+static void
+signed_on_cb(PurpleConnection *connection, gpointer user_data) {
+	BenchData *data = user_data;
+	guint interval = MAX(1000 * burst / MAX(rate, 1), 1);
+
+	data->connection = connection;
+	data->running = TRUE;
+	data->started = g_get_monotonic_time();
+
+	g_timeout_add(interval, send_cb, data);
+	g_timeout_add_seconds(duration, stop_cb, data);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+gint
+main(gint argc, gchar *argv[]) {
+	GOptionContext *context = NULL;
+	GError *error = NULL;
+	PurpleAccountManager *account_manager = NULL;
+	PurpleProtocolManager *protocol_manager = NULL;
+	PurpleProtocol *protocol = NULL;
+	PurpleAccount *account = NULL;
+	BenchData data = {
+		.loop = NULL,
+	};
+	gchar *url = NULL;
+	static int handle;
+
+	context = g_option_context_new(NULL);
+	g_option_context_add_main_entries(context, entries, NULL);
+	if(!g_option_context_parse(context, &argc, &argv, &error)) {
+		g_printerr("%s\n", error->message);
+		g_clear_error(&error);
+		g_option_context_free(context);
+
+		return 1;
+	}
+	g_option_context_free(context);
+
+	test_ui_purple_init();
+
+	/* The XMPP protocol is a plugin; PURPLE_PLUGIN_PATH points at it. */
+	purple_plugins_refresh();
+
+	protocol_manager = purple_protocol_manager_get_default();
+	protocol = purple_protocol_manager_find(protocol_manager, "prpl-jabber");
+	if(protocol == NULL) {
+		g_printerr("the XMPP protocol plugin could not be loaded\n");
+
+		return 1;
+	}
+
+	data.stub = bosh_stub_new("bench@localhost/bench", STUB_WAIT, &error);
+	if(data.stub == NULL) {
+		g_printerr("failed to start the BOSH stand-in: %s\n",
+		           error->message);
+		g_clear_error(&error);
+
+		return 1;
+	}
+	data.stub->delay = MAX(rtt, 0);
+
+	data.loop = g_main_loop_new(NULL, FALSE);
+	data.sent = g_array_new(FALSE, FALSE, sizeof(gint64));
+	data.latencies = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+	purple_signal_connect(protocol, "jabber-receiving-xmlnode", &handle,
+	                      G_CALLBACK(receiving_xmlnode_cb), &data);
+	purple_signal_connect(purple_connections_get_handle(), "signing-on",
+	                      &handle, G_CALLBACK(signing_on_cb), &data);
+	purple_signal_connect(purple_connections_get_handle(), "signed-on",
+	                      &handle, G_CALLBACK(signed_on_cb), &data);
+
+	url = bosh_stub_get_url(data.stub);
+
+	account = purple_account_new("bench@localhost/bench", "prpl-jabber");
+	purple_account_set_require_password(account, FALSE);
+	purple_account_set_string(account, "bosh_url", url);
+	purple_account_set_string(account, "connection_security",
+	                          "opportunistic_tls");
+	purple_account_set_bool(account, "auth_plain_in_clear", TRUE);
+
+	account_manager = purple_account_manager_get_default();
+	purple_account_manager_add(account_manager, account);
+
+	purple_account_set_enabled(account, TRUE);
+	if(purple_account_is_disconnected(account)) {
+		purple_account_connect(account);
+	}
+
+	g_main_loop_run(data.loop);
+
+	report(&data);
+
+	purple_signals_disconnect_by_handle(&handle);
+	purple_account_set_enabled(account, FALSE);
+
+	g_free(url);
+	g_array_free(data.sent, TRUE);
+	g_array_free(data.latencies, TRUE);
+	g_main_loop_unref(data.loop);
+	bosh_stub_free(data.stub);
+
+	return 0;
+}
@@ -0,0 +1,347 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "bosh_stub.h"
+
+#define NS_HTTPBIND "http://jabber.org/protocol/httpbind"
+#define NS_STREAMS "http://etherx.jabber.org/streams"
+
+typedef struct {
+	SoupServerMessage *msg;
+	gint64 since;
+} BoshStubHeld;
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static void
+bosh_stub_pause(BoshStub *stub, SoupServerMessage *msg) {
+	g_object_ref(msg);
+	g_object_set_data(G_OBJECT(msg), "server", stub->server);
+	g_object_set_data(G_OBJECT(msg), "bosh-stub-paused",
+	                  GINT_TO_POINTER(TRUE));
+#if SOUP_CHECK_VERSION(3, 2, 0)
+	soup_server_message_pause(msg);
+#else
+	soup_server_pause_message(stub->server, msg);
+#endif
+}
+
+static gboolean
+bosh_stub_unpause_cb(gpointer data) {
+	SoupServerMessage *msg = data;
+
+#if SOUP_CHECK_VERSION(3, 2, 0)
+	soup_server_message_unpause(msg);
+#else
+	soup_server_unpause_message(g_object_get_data(G_OBJECT(msg), "server"),
+	                            msg);
+#endif
+	g_object_unref(msg);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+bosh_stub_release(BoshStub *stub) {
+	SoupServerMessage *msg = NULL;
+
+	while((msg = bosh_stub_pop_held(stub)) != NULL) {
+		bosh_stub_respond(stub, msg, stub->delay, NULL, stub->outgoing->str);
+		g_string_truncate(stub->outgoing, 0);
+	}
+}
+
+static void
+bosh_stub_handle_iq(BoshStub *stub, PurpleXmlNode *iq) {
+	const gchar *type = purple_xmlnode_get_attrib(iq, "type");
+	const gchar *id = purple_xmlnode_get_attrib(iq, "id");
+	const gchar *to = purple_xmlnode_get_attrib(iq, "to");
+	gchar *reply = NULL;
+
+	if(!purple_strequal(type, "get") && !purple_strequal(type, "set")) {
+		return;
+	}
+
+	if(purple_xmlnode_get_child(iq, "bind") != NULL) {
+		reply = g_markup_printf_escaped(
+			"<iq type='result' id='%s'>"
+			"<bind xmlns='urn:ietf:params:xml:ns:xmpp-bind'>"
+			"<jid>%s</jid></bind></iq>",
+			id ? id : "", stub->jid);
+	} else if(to != NULL) {
+		reply = g_markup_printf_escaped("<iq type='result' id='%s' "
+		                                "from='%s'/>", id ? id : "", to);
+	} else {
+		/* Everything else gets an empty answer, that's enough to sign on. */
+		reply = g_markup_printf_escaped("<iq type='result' id='%s'/>",
+		                                id ? id : "");
+	}
+
+	g_string_append(stub->outgoing, reply);
+	g_free(reply);
+}
+
+/******************************************************************************
+ * Callbacks
+ *****************************************************************************/
+static gboolean
+bosh_stub_wait_cb(gpointer data) {
+	BoshStub *stub = data;
+	gint64 now = g_get_monotonic_time();
+
+	while(!g_queue_is_empty(stub->held)) {
+		BoshStubHeld *held = g_queue_peek_head(stub->held);
+
+		if(now - held->since < stub->wait * G_USEC_PER_SEC) {
+			break;
+		}
+
+		bosh_stub_respond(stub, bosh_stub_pop_held(stub), stub->delay, NULL,
+		                  NULL);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+bosh_stub_handler(G_GNUC_UNUSED SoupServer *server, SoupServerMessage *msg,
+                  G_GNUC_UNUSED const char *path,
+                  G_GNUC_UNUSED GHashTable *query, gpointer data)
+{
+	BoshStub *stub = data;
+	SoupMessageBody *request = NULL;
+	PurpleXmlNode *body = NULL;
+
+	stub->requests++;
+	stub->open++;
+	stub->max_open = MAX(stub->max_open, stub->open);
+
+	request = soup_server_message_get_request_body(msg);
+	body = purple_xmlnode_from_str(request->data, request->length);
+	if(body == NULL) {
+		stub->open--;
+		soup_server_message_set_status(msg, SOUP_STATUS_BAD_REQUEST, NULL);
+		return;
+	}
+
+	if(purple_xmlnode_get_attrib(body, "sid") == NULL) {
+		gchar *attributes = NULL;
+
+		attributes = g_strdup_printf(" sid='stub' wait='%u' requests='2' "
+		                             "hold='1' inactivity='60' ver='1.6'",
+		                             stub->wait);
+		bosh_stub_respond(stub, msg, stub->delay, attributes,
+		                  "<stream:features>"
+		                  "<mechanisms xmlns='urn:ietf:params:xml:ns:"
+		                  "xmpp-sasl'><mechanism>PLAIN</mechanism>"
+		                  "</mechanisms></stream:features>");
+		g_free(attributes);
+		purple_xmlnode_free(body);
+		return;
+	}
+
+	if(purple_strequal(purple_xmlnode_get_attrib(body, "type"), "terminate")) {
+		bosh_stub_release(stub);
+		bosh_stub_respond(stub, msg, stub->delay, " type='terminate'", NULL);
+		purple_xmlnode_free(body);
+		return;
+	}
+
+	if(stub->filter != NULL && stub->filter(stub, msg, body, stub->filter_data))
+	{
+		purple_xmlnode_free(body);
+		return;
+	}
+
+	if(purple_xmlnode_get_attrib(body, "restart") != NULL) {
+		g_string_append(stub->outgoing,
+		                "<stream:features>"
+		                "<bind xmlns='urn:ietf:params:xml:ns:xmpp-bind'/>"
+		                "</stream:features>");
+	}
+
+	for(PurpleXmlNode *child = body->child; child != NULL;
+	    child = child->next)
+	{
+		if(child->type != PURPLE_XMLNODE_TYPE_TAG) {
+			continue;
+		}
+
+		if(purple_strequal(child->name, "auth")) {
+			g_string_append(stub->outgoing,
+			                "<success xmlns='urn:ietf:params:xml:ns:"
+			                "xmpp-sasl'/>");
+		} else if(purple_strequal(child->name, "iq")) {
+			bosh_stub_handle_iq(stub, child);
+		}
+	}
+
+	purple_xmlnode_free(body);
+
+	/* Like a real connection manager we answer the oldest request first and
+	 * only hold on to one of them. */
+	bosh_stub_release(stub);
+
+	if(stub->outgoing->len > 0) {
+		bosh_stub_respond(stub, msg, stub->delay, NULL, stub->outgoing->str);
+		g_string_truncate(stub->outgoing, 0);
+	} else {
+		BoshStubHeld *held = g_new(BoshStubHeld, 1);
+
+		bosh_stub_pause(stub, msg);
+
+		held->msg = msg;
+		held->since = g_get_monotonic_time();
+		g_queue_push_tail(stub->held, held);
+	}
+}
+
+/******************************************************************************
+ * Public API
+ *****************************************************************************/
+BoshStub *
+bosh_stub_new(const gchar *jid, guint wait, GError **error) {
+	BoshStub *stub = g_new0(BoshStub, 1);
+	GSList *uris = NULL;
+
+	stub->server = soup_server_new(NULL, NULL);
+	stub->jid = g_strdup(jid);
+	stub->wait = wait;
+	stub->held = g_queue_new();
+	stub->outgoing = g_string_new(NULL);
+
+	soup_server_add_handler(stub->server, "/http-bind", bosh_stub_handler,
+	                        stub, NULL);
+
+	if(!soup_server_listen_local(stub->server, 0, SOUP_SERVER_LISTEN_IPV4_ONLY,
+	                             error))
+	{
+		bosh_stub_free(stub);
+
+		return NULL;
+	}
+
+	uris = soup_server_get_uris(stub->server);
+	stub->port = g_uri_get_port(uris->data);
+	g_slist_free_full(uris, (GDestroyNotify)g_uri_unref);
+
+	stub->wait_id = g_timeout_add_seconds(1, bosh_stub_wait_cb, stub);
+
+	return stub;
+}
+
+void
+bosh_stub_free(BoshStub *stub) {
+	SoupServerMessage *msg = NULL;
+
+	g_clear_handle_id(&stub->wait_id, g_source_remove);
+
+	soup_server_disconnect(stub->server);
+	g_clear_object(&stub->server);
+
+	while((msg = bosh_stub_pop_held(stub)) != NULL) {
+		g_object_unref(msg);
+	}
+	g_queue_free(stub->held);
+	g_string_free(stub->outgoing, TRUE);
+
+	g_free(stub->jid);
+	g_free(stub);
+}
+
+gchar *
+bosh_stub_get_url(BoshStub *stub) {
+	return g_strdup_printf("http://127.0.0.1:%u/http-bind", stub->port);
+}
+
+void
+bosh_stub_respond(BoshStub *stub, SoupServerMessage *msg, guint delay,
+                  const gchar *attributes, const gchar *payload)
+{
+	gchar *body = NULL;
+
+	body = g_strdup_printf("<body xmlns='" NS_HTTPBIND "' "
+	                       "xmlns:stream='" NS_STREAMS "'%s>%s</body>",
+	                       attributes ? attributes : "",
+	                       payload ? payload : "");
+	bosh_stub_respond_raw(stub, msg, delay, body);
+	g_free(body);
+}
+
+void
+bosh_stub_respond_raw(BoshStub *stub, SoupServerMessage *msg, guint delay,
+                      const gchar *data)
+{
+	soup_server_message_set_status(msg, SOUP_STATUS_OK, NULL);
+	soup_server_message_set_response(msg, "text/xml; charset=utf-8",
+	                                 SOUP_MEMORY_COPY, data, strlen(data));
+
+	stub->open--;
+
+	if(g_object_get_data(G_OBJECT(msg), "bosh-stub-paused") == NULL) {
+		/* We're still in the handler, the response goes out once it
+		 * returns. */
+		if(delay == 0) {
+			return;
+		}
+
+		bosh_stub_pause(stub, msg);
+	}
+
+	g_timeout_add(delay, bosh_stub_unpause_cb, msg);
+}
+
+void
+bosh_stub_drop(BoshStub *stub, SoupServerMessage *msg) {
+	GIOStream *stream = NULL;
+
+	stream = soup_server_message_steal_connection(msg);
+	g_io_stream_close(stream, NULL, NULL);
+	g_object_unref(stream);
+
+	stub->open--;
+}
+
+SoupServerMessage *
+bosh_stub_pop_held(BoshStub *stub) {
+	BoshStubHeld *held = g_queue_pop_head(stub->held);
+	SoupServerMessage *msg = NULL;
+
+	if(held == NULL) {
+		return NULL;
+	}
+
+	msg = held->msg;
+	g_free(held);
+
+	return msg;
+}
+
+gboolean
+bosh_stub_has_iq(PurpleXmlNode *body, const gchar *id) {
+	for(PurpleXmlNode *child = purple_xmlnode_get_child(body, "iq");
+	    child != NULL; child = purple_xmlnode_get_next_twin(child))
+	{
+		if(purple_strequal(purple_xmlnode_get_attrib(child, "id"), id)) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
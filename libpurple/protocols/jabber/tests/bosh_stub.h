@@ -0,0 +1,89 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURPLE_JABBER_BOSH_STUB_H
+#define PURPLE_JABBER_BOSH_STUB_H
+
+#include <glib.h>
+
+#include <libsoup/soup.h>
+
+#include <purple.h>
+
+G_BEGIN_DECLS
+
+typedef struct _BoshStub BoshStub;
+
+/* Called for every request of a session before the stand-in looks at its
+ * contents. Returns TRUE if it answered or dropped the request itself.
+ */
+typedef gboolean (*BoshStubFilter)(BoshStub *stub, SoupServerMessage *msg,
+                                   PurpleXmlNode *body, gpointer data);
+
+/* A connection manager stand-in that signs any account on with PLAIN, binds
+ * it to a fixed JID and answers every iq it gets with an empty result.
+ */
+struct _BoshStub {
+	SoupServer *server;
+	guint port;
+
+	gchar *jid;
+	guint wait;
+
+	/* Milliseconds added to every response, to play the part of the
+	 * network.
+	 */
+	guint delay;
+
+	BoshStubFilter filter;
+	gpointer filter_data;
+
+	/* Requests we're sitting on until there's something to say. */
+	GQueue *held;
+	GString *outgoing;
+	guint wait_id;
+
+	guint requests;
+	guint open;
+	guint max_open;
+};
+
+BoshStub *bosh_stub_new(const gchar *jid, guint wait, GError **error);
+void bosh_stub_free(BoshStub *stub);
+
+gchar *bosh_stub_get_url(BoshStub *stub);
+
+/* Answers msg after delay milliseconds with a body element carrying
+ * attributes and payload.
+ */
+void bosh_stub_respond(BoshStub *stub, SoupServerMessage *msg, guint delay, const gchar *attributes, const gchar *payload);
+
+/* Answers msg after delay milliseconds with data as is. */
+void bosh_stub_respond_raw(BoshStub *stub, SoupServerMessage *msg, guint delay, const gchar *data);
+
+/* Closes the connection msg came in on without answering it. */
+void bosh_stub_drop(BoshStub *stub, SoupServerMessage *msg);
+
+/* Returns the oldest held request, which still has to be answered. */
+SoupServerMessage *bosh_stub_pop_held(BoshStub *stub);
+
+gboolean bosh_stub_has_iq(PurpleXmlNode *body, const gchar *id);
+
+G_END_DECLS
+
+#endif /* PURPLE_JABBER_BOSH_STUB_H */
@@ -0,0 +1,405 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* These tests sign an XMPP account on over BOSH to a stand-in connection
+ * manager running in the same process. Once the account is online the
+ * stand-in misbehaves in the way each test asks for.
+ */
+
+#include <glib.h>
+
+#include <purple.h>
+
+#include "bosh_stub.h"
+#include "test_ui.h"
+
+/* How many times the stand-in drops the request carrying the retry ping. */
+#define TEST_BOSH_DROPS (2)
+
+typedef enum {
+	TEST_BOSH_MODE_REORDER,
+	TEST_BOSH_MODE_RETRY,
+	TEST_BOSH_MODE_MALFORMED,
+} TestBoshMode;
+
+typedef struct {
+	TestBoshMode mode;
+
+	GMainLoop *loop;
+	BoshStub *stub;
+	PurpleAccount *account;
+
+	/* The ids of the iq results the account handled, in order. */
+	GPtrArray *received;
+
+	gchar *dropped_rid;
+	gchar *dropped_body;
+	guint attempts;
+
+	gboolean errored;
+	gboolean timed_out;
+} TestBosh;
+
+/******************************************************************************
+ * Connection manager stand-in
+ *****************************************************************************/
+/* Answers the newer of two requests well before the older one. */
+static gboolean
+test_bosh_reorder(BoshStub *stub, SoupServerMessage *msg, PurpleXmlNode *body)
+{
+	SoupServerMessage *older = NULL;
+
+	if(!bosh_stub_has_iq(body, "reorder") || g_queue_is_empty(stub->held)) {
+		return FALSE;
+	}
+
+	older = bosh_stub_pop_held(stub);
+
+	g_string_append(stub->outgoing,
+	                "<iq type='result' id='b' from='localhost'/>");
+	bosh_stub_respond(stub, msg, 0, NULL, stub->outgoing->str);
+	g_string_truncate(stub->outgoing, 0);
+
+	bosh_stub_respond(stub, older, 200, NULL,
+	                  "<iq type='result' id='a' from='localhost'/>");
+
+	return TRUE;
+}
+
+/* Drops the request carrying the retry ping on the floor the first few
+ * times, and checks that every retransmission is the exact same request.
+ */
+static gboolean
+test_bosh_retry(TestBosh *bosh, SoupServerMessage *msg, PurpleXmlNode *body)
+{
+	const gchar *rid = purple_xmlnode_get_attrib(body, "rid");
+	SoupMessageBody *request = NULL;
+
+	if(!bosh_stub_has_iq(body, "retry")) {
+		return FALSE;
+	}
+
+	request = soup_server_message_get_request_body(msg);
+
+	bosh->attempts++;
+
+	if(bosh->dropped_rid == NULL) {
+		bosh->dropped_rid = g_strdup(rid);
+		bosh->dropped_body = g_strndup(request->data, request->length);
+	} else {
+		g_assert_cmpstr(rid, ==, bosh->dropped_rid);
+		g_assert_cmpmem(request->data, request->length, bosh->dropped_body,
+		                strlen(bosh->dropped_body));
+	}
+
+	if(bosh->attempts > TEST_BOSH_DROPS) {
+		return FALSE;
+	}
+
+	bosh_stub_drop(bosh->stub, msg);
+
+	return TRUE;
+}
+
+static gboolean
+test_bosh_malformed(BoshStub *stub, SoupServerMessage *msg,
+                    PurpleXmlNode *body)
+{
+	if(!bosh_stub_has_iq(body, "malformed")) {
+		return FALSE;
+	}
+
+	bosh_stub_respond_raw(stub, msg, 0, "this is not xml");
+	g_string_truncate(stub->outgoing, 0);
+
+	return TRUE;
+}
+
+static gboolean
+test_bosh_filter(BoshStub *stub, SoupServerMessage *msg, PurpleXmlNode *body,
+                 gpointer data)
+{
+	TestBosh *bosh = data;
+
+	switch(bosh->mode) {
+		case TEST_BOSH_MODE_REORDER:
+			return test_bosh_reorder(stub, msg, body);
+		case TEST_BOSH_MODE_RETRY:
+			return test_bosh_retry(bosh, msg, body);
+		case TEST_BOSH_MODE_MALFORMED:
+			return test_bosh_malformed(stub, msg, body);
+	}
+
+	return FALSE;
+}
+
+/******************************************************************************
+ * Callbacks
+ *****************************************************************************/
+static void
+test_bosh_receiving_xmlnode_cb(G_GNUC_UNUSED PurpleConnection *connection,
+                               PurpleXmlNode **packet, gpointer data)
+{
+	TestBosh *bosh = data;
+	const gchar *id = NULL;
+	gboolean done = FALSE;
+
+	if(*packet == NULL || !purple_strequal((*packet)->name, "iq")) {
+		return;
+	}
+
+	id = purple_xmlnode_get_attrib(*packet, "id");
+	if(!purple_strequal(id, "a") && !purple_strequal(id, "b") &&
+	   !purple_strequal(id, "retry"))
+	{
+		return;
+	}
+
+	g_ptr_array_add(bosh->received, g_strdup(id));
+
+	if(bosh->mode == TEST_BOSH_MODE_REORDER) {
+		done = bosh->received->len == 2;
+	} else {
+		done = TRUE;
+	}
+
+	if(done) {
+		g_main_loop_quit(bosh->loop);
+	}
+}
+
+static void
+test_bosh_connection_error_cb(G_GNUC_UNUSED PurpleConnection *connection,
+                              G_GNUC_UNUSED PurpleConnectionError reason,
+                              G_GNUC_UNUSED const gchar *description,
+                              gpointer data)
+{
+	TestBosh *bosh = data;
+
+	bosh->errored = TRUE;
+	g_main_loop_quit(bosh->loop);
+}
+
+static void
+test_bosh_signing_on_cb(PurpleConnection *connection,
+                        G_GNUC_UNUSED gpointer data)
+{
+	/* The stand-in takes any password, but PLAIN needs one to send. */
+	purple_connection_set_password(connection, "test");
+}
+
+static gboolean
+test_bosh_trigger_cb(gpointer data) {
+	TestBosh *bosh = data;
+	PurpleConnection *connection = NULL;
+	PurpleProtocol *protocol = NULL;
+	const gchar *id = NULL;
+	gchar *stanza = NULL;
+
+	connection = purple_account_get_connection(bosh->account);
+	protocol = purple_connection_get_protocol(connection);
+
+	switch(bosh->mode) {
+		case TEST_BOSH_MODE_REORDER:
+			id = "reorder";
+			break;
+		case TEST_BOSH_MODE_RETRY:
+			id = "retry";
+			break;
+		case TEST_BOSH_MODE_MALFORMED:
+			id = "malformed";
+			break;
+	}
+
+	stanza = g_strdup_printf("<iq type='get' id='%s' to='localhost'>"
+	                         "<ping xmlns='urn:xmpp:ping'/></iq>", id);
+	purple_protocol_server_send_raw(PURPLE_PROTOCOL_SERVER(protocol),
+	                                connection, stanza, -1);
+	g_free(stanza);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+test_bosh_signed_on_cb(G_GNUC_UNUSED PurpleConnection *connection,
+                       gpointer data)
+{
+	/* Let the requests sent while signing on settle first. */
+	g_timeout_add(100, test_bosh_trigger_cb, data);
+}
+
+static gboolean
+test_bosh_timeout_cb(gpointer data) {
+	TestBosh *bosh = data;
+
+	bosh->timed_out = TRUE;
+	g_main_loop_quit(bosh->loop);
+
+	return G_SOURCE_REMOVE;
+}
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static void
+test_bosh_run(TestBosh *bosh, TestBoshMode mode) {
+	PurpleAccountManager *manager = NULL;
+	PurpleProtocolManager *protocol_manager = NULL;
+	PurpleProtocol *protocol = NULL;
+	GError *error = NULL;
+	gchar *url = NULL;
+	guint timeout = 0;
+	static int handle;
+
+	protocol_manager = purple_protocol_manager_get_default();
+	protocol = purple_protocol_manager_find(protocol_manager, "prpl-jabber");
+	g_assert_nonnull(protocol);
+
+	bosh->mode = mode;
+	bosh->loop = g_main_loop_new(NULL, FALSE);
+	bosh->received = g_ptr_array_new_with_free_func(g_free);
+
+	bosh->stub = bosh_stub_new("test@localhost/test", 60, &error);
+	g_assert_no_error(error);
+	bosh->stub->filter = test_bosh_filter;
+	bosh->stub->filter_data = bosh;
+
+	url = bosh_stub_get_url(bosh->stub);
+
+	purple_signal_connect(protocol, "jabber-receiving-xmlnode", &handle,
+	                      G_CALLBACK(test_bosh_receiving_xmlnode_cb), bosh);
+	purple_signal_connect(purple_connections_get_handle(), "signing-on",
+	                      &handle, G_CALLBACK(test_bosh_signing_on_cb), bosh);
+	purple_signal_connect(purple_connections_get_handle(), "signed-on",
+	                      &handle, G_CALLBACK(test_bosh_signed_on_cb), bosh);
+	purple_signal_connect(purple_connections_get_handle(), "connection-error",
+	                      &handle, G_CALLBACK(test_bosh_connection_error_cb),
+	                      bosh);
+
+	bosh->account = purple_account_new("test@localhost/test", "prpl-jabber");
+	purple_account_set_require_password(bosh->account, FALSE);
+	purple_account_set_string(bosh->account, "bosh_url", url);
+	purple_account_set_string(bosh->account, "connection_security",
+	                          "opportunistic_tls");
+	purple_account_set_bool(bosh->account, "auth_plain_in_clear", TRUE);
+
+	manager = purple_account_manager_get_default();
+	purple_account_manager_add(manager, bosh->account);
+
+	timeout = g_timeout_add_seconds(10, test_bosh_timeout_cb, bosh);
+
+	purple_account_set_enabled(bosh->account, TRUE);
+	if(purple_account_is_disconnected(bosh->account)) {
+		purple_account_connect(bosh->account);
+	}
+
+	g_main_loop_run(bosh->loop);
+
+	g_clear_handle_id(&timeout, g_source_remove);
+	purple_signals_disconnect_by_handle(&handle);
+
+	purple_account_set_enabled(bosh->account, FALSE);
+	purple_account_manager_remove(manager, bosh->account);
+	g_clear_object(&bosh->account);
+
+	g_assert_false(bosh->timed_out);
+
+	g_free(url);
+}
+
+static void
+test_bosh_clear(TestBosh *bosh) {
+	g_clear_pointer(&bosh->stub, bosh_stub_free);
+
+	g_ptr_array_free(bosh->received, TRUE);
+	g_main_loop_unref(bosh->loop);
+
+	g_free(bosh->dropped_rid);
+	g_free(bosh->dropped_body);
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_jabber_bosh_reorder(void) {
+	TestBosh bosh = {
+		.loop = NULL,
+	};
+
+	test_bosh_run(&bosh, TEST_BOSH_MODE_REORDER);
+
+	/* The answer to the newer request arrived first, but it can only be
+	 * handled after the one to the older request. */
+	g_assert_false(bosh.errored);
+	g_assert_cmpuint(bosh.received->len, ==, 2);
+	g_assert_cmpstr(g_ptr_array_index(bosh.received, 0), ==, "a");
+	g_assert_cmpstr(g_ptr_array_index(bosh.received, 1), ==, "b");
+
+	test_bosh_clear(&bosh);
+}
+
+static void
+test_jabber_bosh_retry(void) {
+	TestBosh bosh = {
+		.loop = NULL,
+	};
+
+	test_bosh_run(&bosh, TEST_BOSH_MODE_RETRY);
+
+	/* Every attempt was checked against the first one in the handler. */
+	g_assert_false(bosh.errored);
+	g_assert_cmpuint(bosh.attempts, >, TEST_BOSH_DROPS);
+	g_assert_cmpuint(bosh.received->len, ==, 1);
+	g_assert_cmpstr(g_ptr_array_index(bosh.received, 0), ==, "retry");
+
+	test_bosh_clear(&bosh);
+}
+
+static void
+test_jabber_bosh_malformed(void) {
+	TestBosh bosh = {
+		.loop = NULL,
+	};
+
+	test_bosh_run(&bosh, TEST_BOSH_MODE_MALFORMED);
+
+	g_assert_true(bosh.errored);
+	g_assert_cmpuint(bosh.received->len, ==, 0);
+
+	test_bosh_clear(&bosh);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+gint
+main(gint argc, gchar *argv[]) {
+	g_test_init(&argc, &argv, NULL);
+
+	test_ui_purple_init();
+
+	/* The XMPP protocol is a plugin; PURPLE_PLUGIN_PATH points at it. */
+	purple_plugins_refresh();
+
+	g_test_add_func("/jabber/bosh/reorder", test_jabber_bosh_reorder);
+	g_test_add_func("/jabber/bosh/retry", test_jabber_bosh_retry);
+	g_test_add_func("/jabber/bosh/malformed", test_jabber_bosh_malformed);
+
+	return g_test_run();
+}
@@ -54,6 +54,36 @@ test_jabber_scram_proofs(void) {
 	jabber_scram_data_destroy(data);
 }
 
+static void
+test_jabber_scram_proofs_from_keys(void) {
+	JabberScramData *data = g_new0(JabberScramData, 1);
+	guchar client_key[20], server_key[20];
+	gboolean ret;
+	GString *salt;
+	const char *client_proof;
+
+	data->hash = &sha1_mech;
+	data->password = g_strdup("password");
+	data->auth_message = g_string_new("n=username@jabber.org,r=8jLxB5515dhFxBil5A0xSXMH,"
+			"r=8jLxB5515dhFxBil5A0xSXMHabc,s=c2FsdA==,i=1,"
+			"c=biws,r=8jLxB5515dhFxBil5A0xSXMHabc");
+	client_proof = "\x48\x61\x30\xa5\x61\x0b\xae\xb9\xe4\x11\xa8\xfd\xa5\xcd\x34\x1d\x8a\x3c\x28\x17";
+
+	/* Deriving the keys once and reusing them must produce the same proof as
+	 * the all in one calculation. */
+	salt = g_string_new("salt");
+	ret = jabber_scram_derive_keys(&sha1_mech, data->password, salt, 1,
+	                               client_key, server_key);
+	g_assert_true(ret);
+	g_string_free(salt, TRUE);
+
+	jabber_scram_calc_proofs_from_keys(data, client_key, server_key);
+
+	g_assert_cmpmem(client_proof, 20, data->client_proof->str, 20);
+
+	jabber_scram_data_destroy(data);
+}
+
 #define assert_successful_exchange(pw, nonce, start_data, challenge1, response1, success) { \
 	JabberScramData *data = g_new0(JabberScramData, 1); \
 	gboolean ret; \
@@ -94,6 +124,155 @@ test_jabber_scram_exchange(void) {
 			"v=4TkZwKWy6JHNmrUbU2+IdAaXtos=");
 }
 
+/* The salt from the first exchange above. */
+static GString *
+test_jabber_scram_salt(void) {
+	guchar *raw = NULL;
+	gsize len = 0;
+	GString *salt = NULL;
+
+	raw = g_base64_decode("3rXeErP/os7jUNqU", &len);
+	salt = g_string_new_len((gchar *)raw, len);
+	g_free(raw);
+
+	return salt;
+}
+
+static void
+test_jabber_scram_cache_store(GString *salt) {
+	guchar client_key[20], server_key[20];
+
+	memset(client_key, 'c', sizeof(client_key));
+	memset(server_key, 's', sizeof(server_key));
+
+	jabber_auth_scram_uninit();
+	jabber_scram_store_keys("paul@example.com", &sha1_mech, "password", salt,
+	                        4096, client_key, server_key);
+}
+
+static void
+test_jabber_scram_cache_hit(void) {
+	GString *salt = test_jabber_scram_salt();
+	guchar client_key[20], server_key[20];
+	gboolean ret;
+
+	test_jabber_scram_cache_store(salt);
+
+	ret = jabber_scram_lookup_keys("paul@example.com", &sha1_mech, "password",
+	                               salt, 4096, client_key, server_key);
+	g_assert_true(ret);
+	g_assert_cmpmem(client_key, 20, "cccccccccccccccccccc", 20);
+	g_assert_cmpmem(server_key, 20, "ssssssssssssssssssss", 20);
+
+	/* A hit leaves the entry in place. */
+	ret = jabber_scram_lookup_keys("paul@example.com", &sha1_mech, "password",
+	                               salt, 4096, client_key, server_key);
+	g_assert_true(ret);
+
+	/* Other accounts have their own keys. */
+	ret = jabber_scram_lookup_keys("peter@example.com", &sha1_mech,
+	                               "password", salt, 4096, client_key,
+	                               server_key);
+	g_assert_false(ret);
+
+	g_string_free(salt, TRUE);
+	jabber_auth_scram_uninit();
+}
+
+static void
+test_jabber_scram_cache_miss(void) {
+	GString *salt = test_jabber_scram_salt();
+	GString *other_salt = g_string_new("salt");
+	guchar client_key[20], server_key[20];
+	gboolean ret;
+
+	test_jabber_scram_cache_store(salt);
+	ret = jabber_scram_lookup_keys("paul@example.com", &sha1_mech, "password",
+	                               other_salt, 4096, client_key, server_key);
+	g_assert_false(ret);
+
+	/* A miss drops the entry, even for the parameters it was stored with. */
+	ret = jabber_scram_lookup_keys("paul@example.com", &sha1_mech, "password",
+	                               salt, 4096, client_key, server_key);
+	g_assert_false(ret);
+
+	test_jabber_scram_cache_store(salt);
+	ret = jabber_scram_lookup_keys("paul@example.com", &sha1_mech, "password",
+	                               salt, 4095, client_key, server_key);
+	g_assert_false(ret);
+
+	test_jabber_scram_cache_store(salt);
+	ret = jabber_scram_lookup_keys("paul@example.com", &sha1_mech,
+	                               "drowssap", salt, 4096, client_key,
+	                               server_key);
+	g_assert_false(ret);
+
+	g_string_free(other_salt, TRUE);
+	g_string_free(salt, TRUE);
+	jabber_auth_scram_uninit();
+}
+
+static void
+test_jabber_scram_dispose_cancels(void) {
+	JabberSaslMech **mechs = NULL;
+	JabberStream *js = g_new0(JabberStream, 1);
+	JabberScramData *data = g_new0(JabberScramData, 1);
+	JabberSaslState state;
+	PurpleXmlNode *challenge = NULL, *reply = NULL;
+	GString *salt = NULL;
+	guchar client_key[20], server_key[20];
+	const gchar *dec_in = NULL;
+	gchar *enc_in = NULL, *error = NULL;
+	gint count = 0;
+
+	jabber_auth_scram_uninit();
+
+	mechs = jabber_auth_get_scram_mechs(&count);
+	g_assert_cmpint(count, >, 0);
+
+	/* There is no connection, so anything the derivation does to the stream
+	 * once it's finished would crash. */
+	js->user = jabber_id_new("paul@example.com/test");
+	js->auth_mech = mechs[0];
+	js->auth_mech_data = data;
+
+	data->step = 1;
+	data->hash = &sha1_mech;
+	data->password = g_strdup("password");
+	data->cnonce = g_strdup("H7yDYKAWBCrM2Fa5SxGa4iez");
+	data->auth_message = g_string_new("n=paul,r=H7yDYKAWBCrM2Fa5SxGa4iez");
+
+	dec_in = "r=H7yDYKAWBCrM2Fa5SxGa4iezFPVDPpDUcGxPkH3RzP,"
+	         "s=3rXeErP/os7jUNqU,i=4096";
+	enc_in = g_base64_encode((const guchar *)dec_in, strlen(dec_in));
+	challenge = purple_xmlnode_new("challenge");
+	purple_xmlnode_insert_data(challenge, enc_in, -1);
+	g_free(enc_in);
+
+	/* Nothing is cached, so Hi() goes to a worker thread. */
+	state = mechs[0]->handle_challenge(js, challenge, &reply, &error);
+	g_assert_cmpint(state, ==, JABBER_SASL_STATE_CONTINUE);
+	g_assert_null(reply);
+	g_assert_null(error);
+	purple_xmlnode_free(challenge);
+
+	mechs[0]->dispose(js);
+	g_assert_null(js->auth_mech_data);
+
+	/* Wait for the task to complete. It has to see it was cancelled and
+	 * leave the stream and the cache alone. */
+	g_main_context_iteration(NULL, TRUE);
+
+	salt = test_jabber_scram_salt();
+	g_assert_false(jabber_scram_lookup_keys("paul@example.com", &sha1_mech,
+	                                        "password", salt, 4096,
+	                                        client_key, server_key));
+	g_string_free(salt, TRUE);
+
+	jabber_id_free(js->user);
+	g_free(js);
+}
+
 gint
 main(gint argc, gchar **argv) {
 	g_test_init(&argc, &argv, NULL);
@@ -102,8 +281,16 @@ main(gint argc, gchar **argv) {
 	                test_jabber_scram_pbkdf2);
 	g_test_add_func("/jabber/scram/proofs",
 	                test_jabber_scram_proofs);
+	g_test_add_func("/jabber/scram/proofs-from-keys",
+	                test_jabber_scram_proofs_from_keys);
 	g_test_add_func("/jabber/scram/exchange",
 	                test_jabber_scram_exchange);
+	g_test_add_func("/jabber/scram/cache/hit",
+	                test_jabber_scram_cache_hit);
+	g_test_add_func("/jabber/scram/cache/miss",
+	                test_jabber_scram_cache_miss);
+	g_test_add_func("/jabber/scram/dispose-cancels",
+	                test_jabber_scram_dispose_cancels);
 
 	return g_test_run();
 }
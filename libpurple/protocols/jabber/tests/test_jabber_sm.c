@@ -0,0 +1,103 @@
+#include <glib.h>
+
+#include <purple.h>
+
+#include "protocols/jabber/sm.h"
+
+static JabberStreamManagement *
+test_jabber_sm_new_with_stanzas(guint count) {
+	JabberStreamManagement *sm = jabber_sm_new();
+
+	for(guint i = 0; i < count; i++) {
+		PurpleXmlNode *stanza = purple_xmlnode_new("message");
+		gchar *id = g_strdup_printf("%u", i);
+
+		purple_xmlnode_set_attrib(stanza, "id", id);
+		jabber_sm_queue_push(sm, stanza);
+
+		g_free(id);
+	}
+
+	return sm;
+}
+
+static void
+test_jabber_sm_queue_ack(void) {
+	JabberStreamManagement *sm = test_jabber_sm_new_with_stanzas(5);
+	guint dropped = 0;
+
+	g_assert_cmpuint(jabber_sm_queue_get_length(sm), ==, 5);
+
+	/* Acknowledging the same h twice only drops the stanzas once. */
+	g_assert_true(jabber_sm_queue_ack(sm, 2, &dropped));
+	g_assert_cmpuint(dropped, ==, 2);
+	g_assert_true(jabber_sm_queue_ack(sm, 2, &dropped));
+	g_assert_cmpuint(dropped, ==, 0);
+	g_assert_cmpuint(jabber_sm_queue_get_length(sm), ==, 3);
+
+	g_assert_true(jabber_sm_queue_ack(sm, 5, &dropped));
+	g_assert_cmpuint(dropped, ==, 3);
+	g_assert_cmpuint(jabber_sm_queue_get_length(sm), ==, 0);
+
+	jabber_sm_free(sm);
+}
+
+static void
+test_jabber_sm_queue_ack_too_high(void) {
+	JabberStreamManagement *sm = test_jabber_sm_new_with_stanzas(3);
+	guint dropped = 0;
+
+	g_assert_true(jabber_sm_queue_ack(sm, 1, &dropped));
+	g_assert_cmpuint(dropped, ==, 1);
+
+	/* The server can't have handled stanzas we never sent, and nothing is
+	 * dropped when it claims it did. */
+	g_assert_false(jabber_sm_queue_ack(sm, 4, &dropped));
+	g_assert_cmpuint(jabber_sm_queue_get_length(sm), ==, 2);
+
+	/* Counting still continues from the last valid h. */
+	g_assert_true(jabber_sm_queue_ack(sm, 3, &dropped));
+	g_assert_cmpuint(dropped, ==, 2);
+	g_assert_cmpuint(jabber_sm_queue_get_length(sm), ==, 0);
+
+	jabber_sm_free(sm);
+}
+
+static void
+test_jabber_sm_queue_ack_wrap(void) {
+	JabberStreamManagement *sm = jabber_sm_new();
+	guint dropped = 0;
+
+	/* Start just short of 2^32 rather than sending that many stanzas. */
+	jabber_sm_queue_reset(sm, G_MAXUINT32 - 1);
+	for(guint i = 0; i < 4; i++) {
+		jabber_sm_queue_push(sm, purple_xmlnode_new("presence"));
+	}
+
+	g_assert_true(jabber_sm_queue_ack(sm, G_MAXUINT32, &dropped));
+	g_assert_cmpuint(dropped, ==, 1);
+
+	/* h wraps to 0 after 2^32 - 1. */
+	g_assert_true(jabber_sm_queue_ack(sm, 1, &dropped));
+	g_assert_cmpuint(dropped, ==, 2);
+	g_assert_cmpuint(jabber_sm_queue_get_length(sm), ==, 1);
+
+	/* Past the wrap is still ahead of what we sent. */
+	g_assert_false(jabber_sm_queue_ack(sm, 3, &dropped));
+	g_assert_cmpuint(jabber_sm_queue_get_length(sm), ==, 1);
+
+	jabber_sm_free(sm);
+}
+
+gint
+main(gint argc, gchar **argv) {
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/jabber/sm/queue/ack", test_jabber_sm_queue_ack);
+	g_test_add_func("/jabber/sm/queue/ack-too-high",
+	                test_jabber_sm_queue_ack_too_high);
+	g_test_add_func("/jabber/sm/queue/ack-wrap",
+	                test_jabber_sm_queue_ack_wrap);
+
+	return g_test_run();
+}
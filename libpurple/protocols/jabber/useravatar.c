@@ -209,7 +209,6 @@ typedef struct {
 	JabberStream *js;
 	char *from;
 	char *id;
-	SoupMessage *msg;
 } JabberBuddyAvatarUpdateURLInfo;
 
 static void
@@ -221,19 +220,13 @@ do_buddy_avatar_update_fromurl(GObject *source, GAsyncResult *result,
 	gpointer icon_data = NULL;
 	gsize length = 0;
 	GError *error = NULL;
-	const gchar *error_message = NULL;
 
-	if(SOUP_STATUS_IS_SUCCESSFUL(soup_message_get_status(info->msg))) {
-		response_body = soup_session_send_and_read_finish(SOUP_SESSION(source),
-		                                                  result, &error);
-		error_message = error ? error->message : "unknown";
-	} else {
-		error_message = soup_message_get_reason_phrase(info->msg);
-	}
+	response_body = purple_http_service_fetch_finish(PURPLE_HTTP_SERVICE(source),
+	                                                 result, &error);
 	if(response_body == NULL) {
 		purple_debug_error("jabber",
 		                   "do_buddy_avatar_update_fromurl got error \"%s\"",
-		                   error_message);
+		                   error->message);
 		goto out;
 	}
 
@@ -244,7 +237,6 @@ do_buddy_avatar_update_fromurl(GObject *source, GAsyncResult *result,
 out:
 	g_free(info->from);
 	g_free(info->id);
-	g_object_unref(info->msg);
 	g_free(info);
 	g_clear_error(&error);
 }
@@ -344,17 +336,17 @@ update_buddy_metadata(JabberStream *js, const char *from, PurpleXmlNode *items)
 				jabber_pep_request_item(js, from, NS_AVATAR_1_1_DATA, id,
 				                        do_buddy_avatar_update_data);
 			} else {
-				SoupMessage *msg;
 				JabberBuddyAvatarUpdateURLInfo *info = g_new0(JabberBuddyAvatarUpdateURLInfo, 1);
 				info->js = js;
 				info->from = g_strdup(from);
 				info->id = g_strdup(id);
 
-				info->msg = msg = soup_message_new("GET", url);
-				soup_session_send_and_read_async(js->http_conns, msg,
-				                                 G_PRIORITY_DEFAULT, NULL,
-				                                 do_buddy_avatar_update_fromurl,
-				                                 info);
+				/* Contacts sharing an avatar only download it once. */
+				purple_http_service_fetch_async(
+				        purple_http_service_get_default(),
+				        purple_connection_get_account(js->gc), url,
+				        js->http_cancellable, do_buddy_avatar_update_fromurl,
+				        info);
 			}
 		}
 	}
@@ -0,0 +1,501 @@
+/*
+ * purple - Jabber Protocol Plugin
+ *
+ * Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
+ *
+ */
+#include <glib/gi18n-lib.h>
+
+#include <purple.h>
+
+#include <libsoup/soup.h>
+
+#include "websocket.h"
+
+/* Seconds to wait for host-meta before trying the TXT record instead. */
+#define JABBER_WEBSOCKET_DISCOVERY_TIMEOUT 10
+
+#define JABBER_WEBSOCKET_TXT_PREFIX "_xmpp-client-websocket="
+#define JABBER_WEBSOCKET_LINK_REL "urn:xmpp:alt-connections:websocket"
+
+struct _PurpleJabberWebSocket {
+	JabberStream *js;
+	SoupSession *session;
+	SoupWebsocketConnection *connection;
+	GCancellable *cancellable;
+
+	gchar *url;
+	gboolean is_ssl;
+	gboolean is_closing;
+};
+
+typedef struct {
+	/* Cancels the host-meta request when the discovery is cancelled or it
+	 * takes too long. */
+	GCancellable *cancellable;
+	GCancellable *parent;
+	gulong cancelled_id;
+	guint timeout_id;
+
+	gchar *domain;
+} JabberWebSocketDiscovery;
+
+/******************************************************************************
+ * Connection
+ *****************************************************************************/
+static void
+jabber_websocket_message_cb(G_GNUC_UNUSED SoupWebsocketConnection *connection,
+                            G_GNUC_UNUSED gint type, GBytes *message,
+                            gpointer data)
+{
+	PurpleJabberWebSocket *ws = data;
+	JabberStream *js = ws->js;
+	PurpleXmlNode *node = NULL;
+	gconstpointer body = NULL;
+	gsize length = 0;
+	const gchar *xmlns = NULL;
+
+	body = g_bytes_get_data(message, &length);
+
+	if (purple_debug_is_verbose() && purple_debug_is_unsafe()) {
+		purple_debug_misc("jabber-websocket", "received: %.*s", (int)length,
+		                  (const gchar *)body);
+	}
+
+	/* Every frame is a complete element, so there's no need for the
+	 * streaming parser the TCP transport uses. */
+	node = purple_xmlnode_from_str(body, length);
+	if (node == NULL) {
+		purple_connection_error(js->gc,
+			PURPLE_CONNECTION_ERROR_NETWORK_ERROR,
+			_("Invalid XML received from the server"));
+		return;
+	}
+
+	xmlns = purple_xmlnode_get_namespace(node);
+	if (purple_strequal(xmlns, NS_XMPP_FRAMING)) {
+		if (purple_strequal(node->name, "open")) {
+			g_free(js->stream_id);
+			js->stream_id = g_strdup(purple_xmlnode_get_attrib(node, "id"));
+		} else if (purple_strequal(node->name, "close")) {
+			purple_connection_error(js->gc,
+				PURPLE_CONNECTION_ERROR_NETWORK_ERROR,
+				_("The server closed the connection"));
+		}
+
+		purple_xmlnode_free(node);
+		return;
+	}
+
+	/* Same workaround as BOSH for servers that leave the namespace off. */
+	if (xmlns == NULL &&
+	    (purple_strequal(node->name, "iq") ||
+	     purple_strequal(node->name, "message") ||
+	     purple_strequal(node->name, "presence")))
+	{
+		purple_xmlnode_set_namespace(node, NS_XMPP_CLIENT);
+	}
+
+	jabber_process_packet(js, &node);
+	if (node != NULL) {
+		purple_xmlnode_free(node);
+	}
+
+	/* A restart after authentication is just a new <open/>. */
+	if (js->reinit && !ws->is_closing) {
+		jabber_stream_set_state(js, JABBER_STREAM_INITIALIZING);
+	}
+}
+
+static void
+jabber_websocket_closed_cb(G_GNUC_UNUSED SoupWebsocketConnection *connection,
+                           gpointer data)
+{
+	PurpleJabberWebSocket *ws = data;
+
+	if (ws->is_closing) {
+		return;
+	}
+
+	purple_connection_error(ws->js->gc,
+		PURPLE_CONNECTION_ERROR_NETWORK_ERROR,
+		_("Server closed the connection"));
+}
+
+static void
+jabber_websocket_connected_cb(GObject *source, GAsyncResult *result,
+                              gpointer data)
+{
+	PurpleJabberWebSocket *ws = NULL;
+	SoupWebsocketConnection *connection = NULL;
+	GError *error = NULL;
+	const gchar *protocol = NULL;
+
+	connection = soup_session_websocket_connect_finish(SOUP_SESSION(source),
+	                                                   result, &error);
+	if (connection == NULL) {
+		/* ws is already gone if we were cancelled. */
+		if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+			ws = data;
+			purple_connection_take_error(ws->js->gc, error);
+		} else {
+			g_error_free(error);
+		}
+		return;
+	}
+
+	ws = data;
+
+	protocol = soup_websocket_connection_get_protocol(connection);
+	if (!purple_strequal(protocol, "xmpp")) {
+		purple_connection_error(ws->js->gc,
+			PURPLE_CONNECTION_ERROR_NETWORK_ERROR,
+			_("The WebSocket server does not support XMPP"));
+		g_object_unref(connection);
+		return;
+	}
+
+	purple_debug_misc("jabber-websocket", "Connected to %s", ws->url);
+
+	ws->connection = connection;
+
+	/* Whitespace keepalives aren't allowed between frames, so keep proxies
+	 * from timing us out with WebSocket pings instead. */
+	g_object_set(connection, "keepalive-interval", ws->js->max_inactivity,
+	             NULL);
+
+	g_signal_connect(connection, "message",
+	                 G_CALLBACK(jabber_websocket_message_cb), ws);
+	g_signal_connect(connection, "closed",
+	                 G_CALLBACK(jabber_websocket_closed_cb), ws);
+
+	jabber_stream_set_state(ws->js, JABBER_STREAM_INITIALIZING);
+}
+
+PurpleJabberWebSocket *
+jabber_websocket_new(JabberStream *js, const gchar *url)
+{
+	PurpleJabberWebSocket *ws;
+	SoupMessage *msg;
+	const gchar *scheme;
+	const gchar *protocols[] = { "xmpp", NULL };
+
+	scheme = g_uri_peek_scheme(url);
+	if (!purple_strequal(scheme, "ws") && !purple_strequal(scheme, "wss")) {
+		purple_debug_error("jabber-websocket",
+		                   "Unable to parse given WebSocket URL: %s", url);
+		return NULL;
+	}
+
+	msg = soup_message_new("GET", url);
+	if (msg == NULL) {
+		purple_debug_error("jabber-websocket",
+		                   "Unable to parse given WebSocket URL: %s", url);
+		return NULL;
+	}
+
+	ws = g_new0(PurpleJabberWebSocket, 1);
+	ws->js = js;
+	ws->session = g_object_ref(js->http_conns);
+	ws->cancellable = g_cancellable_new();
+	ws->url = g_strdup(url);
+	ws->is_ssl = purple_strequal(scheme, "wss");
+
+	soup_session_websocket_connect_async(ws->session, msg, NULL,
+	                                     (gchar **)protocols,
+	                                     G_PRIORITY_DEFAULT, ws->cancellable,
+	                                     jabber_websocket_connected_cb, ws);
+	g_object_unref(msg);
+
+	return ws;
+}
+
+void
+jabber_websocket_destroy(PurpleJabberWebSocket *ws)
+{
+	if (ws == NULL || ws->is_closing)
+		return;
+	ws->is_closing = TRUE;
+
+	g_cancellable_cancel(ws->cancellable);
+
+	if (ws->connection != NULL) {
+		g_signal_handlers_disconnect_by_data(ws->connection, ws);
+
+		if (soup_websocket_connection_get_state(ws->connection) ==
+		    SOUP_WEBSOCKET_STATE_OPEN)
+		{
+			soup_websocket_connection_send_text(ws->connection,
+				"<close xmlns='" NS_XMPP_FRAMING "'/>");
+			soup_websocket_connection_close(ws->connection,
+				SOUP_WEBSOCKET_CLOSE_NORMAL, NULL);
+		}
+	}
+
+	g_clear_object(&ws->connection);
+	g_clear_object(&ws->cancellable);
+	g_clear_object(&ws->session);
+	g_free(ws->url);
+
+	g_free(ws);
+}
+
+gboolean
+jabber_websocket_is_ssl(const PurpleJabberWebSocket *ws)
+{
+	return ws->is_ssl;
+}
+
+void
+jabber_websocket_send(PurpleJabberWebSocket *ws, const gchar *data,
+	gssize len)
+{
+	GBytes *bytes;
+
+	g_return_if_fail(ws != NULL);
+
+	if (ws->connection == NULL ||
+	    soup_websocket_connection_get_state(ws->connection) !=
+	    SOUP_WEBSOCKET_STATE_OPEN)
+	{
+		purple_debug_warning("jabber-websocket",
+		                     "Dropping data sent while not connected");
+		return;
+	}
+
+	if (len < 0)
+		len = strlen(data);
+
+	/* One frame per element, straight onto the open connection. */
+	bytes = g_bytes_new(data, len);
+	soup_websocket_connection_send_message(ws->connection,
+	                                       SOUP_WEBSOCKET_DATA_TEXT, bytes);
+	g_bytes_unref(bytes);
+}
+
+/******************************************************************************
+ * Discovery
+ *****************************************************************************/
+static void
+jabber_websocket_discovery_free(gpointer data)
+{
+	JabberWebSocketDiscovery *discovery = data;
+
+	g_clear_handle_id(&discovery->timeout_id, g_source_remove);
+	if (discovery->parent != NULL) {
+		g_cancellable_disconnect(discovery->parent, discovery->cancelled_id);
+	}
+
+	g_clear_object(&discovery->cancellable);
+	g_clear_object(&discovery->parent);
+	g_free(discovery->domain);
+	g_free(discovery);
+}
+
+static void
+jabber_websocket_discovery_cancelled_cb(G_GNUC_UNUSED GCancellable *parent,
+                                        gpointer data)
+{
+	g_cancellable_cancel(G_CANCELLABLE(data));
+}
+
+static gboolean
+jabber_websocket_discovery_timeout_cb(gpointer data)
+{
+	JabberWebSocketDiscovery *discovery = data;
+
+	discovery->timeout_id = 0;
+	g_cancellable_cancel(discovery->cancellable);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+jabber_websocket_txt_cb(GObject *source, GAsyncResult *result, gpointer data)
+{
+	GTask *task = data;
+	GList *records = NULL;
+	GError *error = NULL;
+	gchar *url = NULL;
+
+	records = g_resolver_lookup_records_finish(G_RESOLVER(source), result,
+	                                           &error);
+	if (error != NULL) {
+		g_task_return_error(task, error);
+		g_object_unref(task);
+		return;
+	}
+
+	for (GList *l = records; l != NULL && url == NULL; l = l->next) {
+		GVariantIter *iter = NULL;
+		const gchar *txt = NULL;
+
+		g_variant_get(l->data, "(as)", &iter);
+		while (url == NULL && g_variant_iter_next(iter, "&s", &txt)) {
+			const gchar *value = NULL;
+
+			if (!g_str_has_prefix(txt, JABBER_WEBSOCKET_TXT_PREFIX))
+				continue;
+
+			/* TXT records aren't authenticated, so never let one downgrade
+			 * us to an unencrypted connection. */
+			value = txt + strlen(JABBER_WEBSOCKET_TXT_PREFIX);
+			if (g_str_has_prefix(value, "wss://"))
+				url = g_strdup(value);
+		}
+		g_variant_iter_free(iter);
+	}
+
+	g_list_free_full(records, (GDestroyNotify)g_variant_unref);
+
+	if (url != NULL) {
+		g_task_return_pointer(task, url, g_free);
+	} else {
+		g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+		                        "No WebSocket endpoint advertised");
+	}
+	g_object_unref(task);
+}
+
+static void
+jabber_websocket_lookup_txt(GTask *task)
+{
+	JabberWebSocketDiscovery *discovery = g_task_get_task_data(task);
+	GResolver *resolver = g_resolver_get_default();
+	gchar *name = g_strdup_printf("_xmppconnect.%s", discovery->domain);
+
+	g_resolver_lookup_records_async(resolver, name, G_RESOLVER_RECORD_TXT,
+	                                g_task_get_cancellable(task),
+	                                jabber_websocket_txt_cb, task);
+
+	g_free(name);
+	g_object_unref(resolver);
+}
+
+static gchar *
+jabber_websocket_parse_host_meta(GBytes *body)
+{
+	PurpleXmlNode *xrd = NULL, *link = NULL;
+	gconstpointer data = NULL;
+	gsize length = 0;
+	gchar *url = NULL;
+
+	data = g_bytes_get_data(body, &length);
+	xrd = purple_xmlnode_from_str(data, length);
+	if (xrd == NULL)
+		return NULL;
+
+	for (link = purple_xmlnode_get_child(xrd, "Link"); link != NULL;
+	     link = purple_xmlnode_get_next_twin(link))
+	{
+		const gchar *rel = purple_xmlnode_get_attrib(link, "rel");
+		const gchar *href = purple_xmlnode_get_attrib(link, "href");
+
+		if (purple_strequal(rel, JABBER_WEBSOCKET_LINK_REL) &&
+		    href != NULL && g_str_has_prefix(href, "wss://"))
+		{
+			url = g_strdup(href);
+			break;
+		}
+	}
+
+	purple_xmlnode_free(xrd);
+
+	return url;
+}
+
+static void
+jabber_websocket_host_meta_cb(GObject *source, GAsyncResult *result,
+                              gpointer data)
+{
+	GTask *task = data;
+	JabberWebSocketDiscovery *discovery = g_task_get_task_data(task);
+	GBytes *body = NULL;
+	GError *error = NULL;
+	gchar *url = NULL;
+
+	body = purple_http_service_fetch_finish(PURPLE_HTTP_SERVICE(source),
+	                                        result, &error);
+	g_clear_handle_id(&discovery->timeout_id, g_source_remove);
+
+	if (body == NULL) {
+		g_error_free(error);
+
+		/* Unless we were cancelled, try the TXT record instead. */
+		if (g_task_return_error_if_cancelled(task)) {
+			g_object_unref(task);
+			return;
+		}
+	} else {
+		url = jabber_websocket_parse_host_meta(body);
+		g_bytes_unref(body);
+	}
+
+	if (url != NULL) {
+		g_task_return_pointer(task, url, g_free);
+		g_object_unref(task);
+		return;
+	}
+
+	jabber_websocket_lookup_txt(task);
+}
+
+void
+jabber_websocket_discover(JabberStream *js, GCancellable *cancellable,
+	GAsyncReadyCallback callback, gpointer data)
+{
+	JabberWebSocketDiscovery *discovery;
+	GTask *task;
+	gchar *url;
+
+	task = g_task_new(NULL, cancellable, callback, data);
+	g_task_set_source_tag(task, jabber_websocket_discover);
+
+	discovery = g_new0(JabberWebSocketDiscovery, 1);
+	discovery->cancellable = g_cancellable_new();
+	discovery->domain = g_strdup(js->user->domain);
+	g_task_set_task_data(task, discovery, jabber_websocket_discovery_free);
+
+	if (cancellable != NULL) {
+		discovery->parent = g_object_ref(cancellable);
+		discovery->cancelled_id = g_cancellable_connect(cancellable,
+			G_CALLBACK(jabber_websocket_discovery_cancelled_cb),
+			discovery->cancellable, NULL);
+	}
+
+	discovery->timeout_id = g_timeout_add_seconds(
+		JABBER_WEBSOCKET_DISCOVERY_TIMEOUT,
+		jabber_websocket_discovery_timeout_cb, discovery);
+
+	url = g_strdup_printf("https://%s/.well-known/host-meta",
+	                      discovery->domain);
+	purple_http_service_fetch_async(purple_http_service_get_default(),
+	                                purple_connection_get_account(js->gc), url,
+	                                discovery->cancellable,
+	                                jabber_websocket_host_meta_cb, task);
+	g_free(url);
+}
+
+gchar *
+jabber_websocket_discover_finish(GAsyncResult *result, GError **error)
+{
+	g_return_val_if_fail(g_task_is_valid(result, NULL), NULL);
+
+	return g_task_propagate_pointer(G_TASK(result), error);
+}
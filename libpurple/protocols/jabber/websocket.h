@@ -0,0 +1,55 @@
+/**
+ * @file websocket.h XMPP over WebSocket (RFC 7395)
+ *
+ * purple
+ *
+ * Purple is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
+ */
+
+#ifndef PURPLE_JABBER_WEBSOCKET_H
+#define PURPLE_JABBER_WEBSOCKET_H
+
+typedef struct _PurpleJabberWebSocket PurpleJabberWebSocket;
+
+#include "jabber.h"
+
+PurpleJabberWebSocket *
+jabber_websocket_new(JabberStream *js, const gchar *url);
+
+void
+jabber_websocket_destroy(PurpleJabberWebSocket *ws);
+
+gboolean
+jabber_websocket_is_ssl(const PurpleJabberWebSocket *ws);
+
+void
+jabber_websocket_send(PurpleJabberWebSocket *ws, const gchar *data,
+	gssize len);
+
+/* Looks up the WebSocket endpoint of the account's domain, first through
+ * https://domain/.well-known/host-meta and then the _xmppconnect TXT record
+ * (XEP-0156).  Only secure (wss://) endpoints are returned. */
+void
+jabber_websocket_discover(JabberStream *js, GCancellable *cancellable,
+	GAsyncReadyCallback callback, gpointer data);
+
+gchar *
+jabber_websocket_discover_finish(GAsyncResult *result, GError **error);
+
+#endif /* PURPLE_JABBER_WEBSOCKET_H */
@@ -74,6 +74,10 @@ xmpp_protocol_get_account_options(G_GNUC_UNUSED PurpleProtocol *protocol) {
 	option = purple_account_option_string_new(_("BOSH URL"), "bosh_url", NULL);
 	opts = g_list_append(opts, option);
 
+	option = purple_account_option_string_new(_("WebSocket URL"),
+	                                          "websocket_url", NULL);
+	opts = g_list_append(opts, option);
+
 	return opts;
 }
 
@@ -23,8 +23,16 @@ struct _PurpleAvatar {
 
 	char *filename;
 
+	GBytes *data;
+	gboolean loaded;
+
 	GdkPixbuf *pixbuf;
 
+	/* This avatar's links in cache_lru, so it can drop its entries without
+	 * walking the whole cache.
+	 */
+	GSList *cache_links;
+
 	gboolean animated;
 	GdkPixbufAnimation *animation;
 
@@ -44,28 +52,202 @@ static GParamSpec *properties[N_PROPERTIES] = {NULL, };
 
 G_DEFINE_TYPE(PurpleAvatar, purple_avatar, G_TYPE_OBJECT)
 
+/* The most pixel data, in bytes, that the decoded avatar cache will hold
+ * before it starts evicting the least recently used entries.
+ */
+#define PURPLE_AVATAR_CACHE_MAX_BYTES (8 * 1024 * 1024)
+
+/******************************************************************************
+ * Decoded Avatar Cache
+ *****************************************************************************/
+typedef struct {
+	PurpleAvatar *avatar;
+	int size;
+
+	GdkPixbuf *pixbuf;
+	gsize cost;
+} PurpleAvatarCacheEntry;
+
+/* Maps entries to their link in cache_lru. The most recently used entry is
+ * at the head of cache_lru.
+ */
+static GHashTable *cache = NULL;
+static GQueue cache_lru = G_QUEUE_INIT;
+static gsize cache_bytes = 0;
+
+static guint
+purple_avatar_cache_entry_hash(gconstpointer key) {
+	const PurpleAvatarCacheEntry *entry = key;
+
+	return g_direct_hash(entry->avatar) ^ g_int_hash(&entry->size);
+}
+
+static gboolean
+purple_avatar_cache_entry_equal(gconstpointer a, gconstpointer b) {
+	const PurpleAvatarCacheEntry *entry_a = a;
+	const PurpleAvatarCacheEntry *entry_b = b;
+
+	return entry_a->avatar == entry_b->avatar && entry_a->size == entry_b->size;
+}
+
+static void
+purple_avatar_cache_remove_link(GList *link) {
+	PurpleAvatarCacheEntry *entry = link->data;
+
+	g_hash_table_remove(cache, entry);
+	g_queue_delete_link(&cache_lru, link);
+	entry->avatar->cache_links = g_slist_remove(entry->avatar->cache_links,
+	                                            link);
+
+	cache_bytes -= entry->cost;
+
+	g_clear_object(&entry->pixbuf);
+	g_free(entry);
+}
+
+static GdkPixbuf *
+purple_avatar_cache_lookup(PurpleAvatar *avatar, int size) {
+	PurpleAvatarCacheEntry key = {.avatar = avatar, .size = size};
+	PurpleAvatarCacheEntry *entry = NULL;
+	GList *link = NULL;
+
+	if(cache == NULL) {
+		return NULL;
+	}
+
+	link = g_hash_table_lookup(cache, &key);
+	if(link == NULL) {
+		return NULL;
+	}
+
+	g_queue_unlink(&cache_lru, link);
+	g_queue_push_head_link(&cache_lru, link);
+
+	entry = link->data;
+
+	return g_object_ref(entry->pixbuf);
+}
+
+static void
+purple_avatar_cache_insert(PurpleAvatar *avatar, int size, GdkPixbuf *pixbuf) {
+	PurpleAvatarCacheEntry *entry = NULL;
+
+	if(cache == NULL) {
+		cache = g_hash_table_new(purple_avatar_cache_entry_hash,
+		                         purple_avatar_cache_entry_equal);
+	}
+
+	entry = g_new0(PurpleAvatarCacheEntry, 1);
+	entry->avatar = avatar;
+	entry->size = size;
+	entry->pixbuf = g_object_ref(pixbuf);
+	entry->cost = gdk_pixbuf_get_byte_length(pixbuf);
+
+	g_queue_push_head(&cache_lru, entry);
+	g_hash_table_insert(cache, entry, cache_lru.head);
+	avatar->cache_links = g_slist_prepend(avatar->cache_links, cache_lru.head);
+	cache_bytes += entry->cost;
+
+	/* Evict from the tail, but never the entry we just added. */
+	while(cache_bytes > PURPLE_AVATAR_CACHE_MAX_BYTES &&
+	      cache_lru.tail != cache_lru.head)
+	{
+		purple_avatar_cache_remove_link(cache_lru.tail);
+	}
+}
+
+static void
+purple_avatar_cache_remove_avatar(PurpleAvatar *avatar) {
+	while(avatar->cache_links != NULL) {
+		purple_avatar_cache_remove_link(avatar->cache_links->data);
+	}
+}
+
 /******************************************************************************
  * Helpers
  *****************************************************************************/
+static GdkPixbufLoader *purple_avatar_load_bytes(GBytes *data, int size,
+                                                 GError **error);
+
+/* Decodes the bytes of avatar to fit in size and adds the result to the
+ * cache.
+ */
+static GdkPixbuf *
+purple_avatar_decode(PurpleAvatar *avatar, int size) {
+	GdkPixbufLoader *loader = NULL;
+	GdkPixbuf *pixbuf = NULL;
+
+	loader = purple_avatar_load_bytes(avatar->data, size, NULL);
+	if(loader == NULL) {
+		return NULL;
+	}
+
+	pixbuf = gdk_pixbuf_loader_get_pixbuf(loader);
+	if(GDK_IS_PIXBUF(pixbuf)) {
+		g_object_ref(pixbuf);
+		purple_avatar_cache_insert(avatar, size, pixbuf);
+	}
+
+	g_clear_object(&loader);
+
+	return pixbuf;
+}
+
 static void
-purple_avatar_set_filename(PurpleAvatar *avatar, const char *filename) {
-	g_return_if_fail(PURPLE_IS_AVATAR(avatar));
+purple_avatar_size_prepared_cb(GdkPixbufLoader *loader, int width, int height,
+                               gpointer data)
+{
+	int size = GPOINTER_TO_INT(data);
 
-	g_free(avatar->filename);
-	avatar->filename = g_strdup(filename);
+	if(width <= size && height <= size) {
+		return;
+	}
 
-	g_object_notify_by_pspec(G_OBJECT(avatar), properties[PROP_FILENAME]);
+	/* Scale while decoding so we never hold the full sized image. */
+	if(width > height) {
+		height = MAX(1, height * size / width);
+		width = size;
+	} else {
+		width = MAX(1, width * size / height);
+		height = size;
+	}
+
+	gdk_pixbuf_loader_set_size(loader, width, height);
 }
 
-static PurpleAvatar *
-purple_avatar_new_common(const char *filename, GdkPixbufAnimation *animation) {
-	PurpleAvatar *avatar = NULL;
+static GdkPixbufLoader *
+purple_avatar_load_bytes(GBytes *data, int size, GError **error) {
+	GdkPixbufLoader *loader = gdk_pixbuf_loader_new();
 
-	avatar = g_object_new(PURPLE_TYPE_AVATAR, "filename", filename, NULL);
+	if(size > 0) {
+		g_signal_connect(loader, "size-prepared",
+		                 G_CALLBACK(purple_avatar_size_prepared_cb),
+		                 GINT_TO_POINTER(size));
+	}
+
+	if(!gdk_pixbuf_loader_write_bytes(loader, data, error)) {
+		gdk_pixbuf_loader_close(loader, NULL);
+		g_clear_object(&loader);
+
+		return NULL;
+	}
+
+	if(!gdk_pixbuf_loader_close(loader, error)) {
+		g_clear_object(&loader);
+
+		return NULL;
+	}
 
+	return loader;
+}
+
+static void
+purple_avatar_set_animation(PurpleAvatar *avatar,
+                            GdkPixbufAnimation *animation)
+{
 	if(gdk_pixbuf_animation_is_static_image(animation)) {
 		/* If we loaded a static image, grab the static image and set it to our
-		 * pixbuf member, clear the animation, and return the new avatar.
+		 * pixbuf member and clear the animation.
 		 */
 
 		avatar->pixbuf = gdk_pixbuf_animation_get_static_image(animation);
@@ -73,13 +255,65 @@ purple_avatar_new_common(const char *filename, GdkPixbufAnimation *animation) {
 
 		g_clear_object(&animation);
 	} else {
-		/* If we did load an animation, set the appropriate properties and
-		 * return the avatar.
-		 */
+		/* If we did load an animation, set the appropriate properties. */
 		avatar->animated = TRUE;
 		avatar->animation = animation;
 	}
 
+	avatar->loaded = TRUE;
+}
+
+/* Avatars created from bytes are not decoded until someone asks for the
+ * pixbuf or the animation.
+ */
+static void
+purple_avatar_ensure_loaded(PurpleAvatar *avatar) {
+	GdkPixbufLoader *loader = NULL;
+	GdkPixbufAnimation *animation = NULL;
+	GError *error = NULL;
+
+	if(avatar->loaded || avatar->data == NULL) {
+		return;
+	}
+
+	/* Only try once, even if the data turns out to be garbage. */
+	avatar->loaded = TRUE;
+
+	loader = purple_avatar_load_bytes(avatar->data, 0, &error);
+	if(loader == NULL) {
+		g_warning("failed to decode avatar: %s",
+		          error != NULL ? error->message : "unknown error");
+		g_clear_error(&error);
+
+		return;
+	}
+
+	animation = gdk_pixbuf_loader_get_animation(loader);
+	if(GDK_IS_PIXBUF_ANIMATION(animation)) {
+		purple_avatar_set_animation(avatar, g_object_ref(animation));
+	}
+
+	g_clear_object(&loader);
+}
+
+static void
+purple_avatar_set_filename(PurpleAvatar *avatar, const char *filename) {
+	g_return_if_fail(PURPLE_IS_AVATAR(avatar));
+
+	g_free(avatar->filename);
+	avatar->filename = g_strdup(filename);
+
+	g_object_notify_by_pspec(G_OBJECT(avatar), properties[PROP_FILENAME]);
+}
+
+static PurpleAvatar *
+purple_avatar_new_common(const char *filename, GdkPixbufAnimation *animation) {
+	PurpleAvatar *avatar = NULL;
+
+	avatar = g_object_new(PURPLE_TYPE_AVATAR, "filename", filename, NULL);
+
+	purple_avatar_set_animation(avatar, animation);
+
 	return avatar;
 }
 
@@ -134,7 +368,10 @@ static void
 purple_avatar_finalize(GObject *obj) {
 	PurpleAvatar *avatar = PURPLE_AVATAR(obj);
 
+	purple_avatar_cache_remove_avatar(avatar);
+
 	g_clear_pointer(&avatar->filename, g_free);
+	g_clear_pointer(&avatar->data, g_bytes_unref);
 	g_clear_object(&avatar->pixbuf);
 	g_clear_object(&avatar->animation);
 	g_clear_object(&avatar->tags);
@@ -268,6 +505,18 @@ purple_avatar_new_from_resource(const char *resource_path, GError **error) {
 	return purple_avatar_new_common(NULL, animation);
 }
 
+PurpleAvatar *
+purple_avatar_new_from_bytes(GBytes *data) {
+	PurpleAvatar *avatar = NULL;
+
+	g_return_val_if_fail(data != NULL, NULL);
+
+	avatar = g_object_new(PURPLE_TYPE_AVATAR, NULL);
+	avatar->data = g_bytes_ref(data);
+
+	return avatar;
+}
+
 const char *
 purple_avatar_get_filename(PurpleAvatar *avatar) {
 	g_return_val_if_fail(PURPLE_IS_AVATAR(avatar), NULL);
@@ -279,6 +528,12 @@ GdkPixbuf *
 purple_avatar_get_pixbuf(PurpleAvatar *avatar) {
 	g_return_val_if_fail(PURPLE_IS_AVATAR(avatar), NULL);
 
+	/* The full sized image belongs to the avatar and is handed out without a
+	 * reference, so it never goes into the cache where it could be evicted
+	 * from under the caller.
+	 */
+	purple_avatar_ensure_loaded(avatar);
+
 	if(avatar->animated) {
 		return gdk_pixbuf_animation_get_static_image(avatar->animation);
 	}
@@ -290,6 +545,8 @@ gboolean
 purple_avatar_get_animated(PurpleAvatar *avatar) {
 	g_return_val_if_fail(PURPLE_IS_AVATAR(avatar), FALSE);
 
+	purple_avatar_ensure_loaded(avatar);
+
 	return avatar->animated;
 }
 
@@ -297,9 +554,63 @@ GdkPixbufAnimation *
 purple_avatar_get_animation(PurpleAvatar *avatar) {
 	g_return_val_if_fail(PURPLE_IS_AVATAR(avatar), NULL);
 
+	purple_avatar_ensure_loaded(avatar);
+
 	return avatar->animation;
 }
 
+GBytes *
+purple_avatar_get_data(PurpleAvatar *avatar) {
+	g_return_val_if_fail(PURPLE_IS_AVATAR(avatar), NULL);
+
+	return avatar->data;
+}
+
+GdkPixbuf *
+purple_avatar_get_pixbuf_for_size(PurpleAvatar *avatar, int size) {
+	GdkPixbuf *full = NULL;
+	GdkPixbuf *pixbuf = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_AVATAR(avatar), NULL);
+	g_return_val_if_fail(size > 0, NULL);
+
+	pixbuf = purple_avatar_cache_lookup(avatar, size);
+	if(GDK_IS_PIXBUF(pixbuf)) {
+		return pixbuf;
+	}
+
+	/* Decode straight to the requested size without keeping the full sized
+	 * image around.
+	 */
+	if(avatar->data != NULL && !avatar->loaded) {
+		return purple_avatar_decode(avatar, size);
+	}
+
+	full = purple_avatar_get_pixbuf(avatar);
+	if(GDK_IS_PIXBUF(full)) {
+		int width = gdk_pixbuf_get_width(full);
+		int height = gdk_pixbuf_get_height(full);
+
+		if(width <= size && height <= size) {
+			pixbuf = g_object_ref(full);
+		} else if(width > height) {
+			pixbuf = gdk_pixbuf_scale_simple(full, size,
+			                                 MAX(1, height * size / width),
+			                                 GDK_INTERP_BILINEAR);
+		} else {
+			pixbuf = gdk_pixbuf_scale_simple(full,
+			                                 MAX(1, width * size / height),
+			                                 size, GDK_INTERP_BILINEAR);
+		}
+	}
+
+	if(GDK_IS_PIXBUF(pixbuf)) {
+		purple_avatar_cache_insert(avatar, size, pixbuf);
+	}
+
+	return pixbuf;
+}
+
 PurpleTags *
 purple_avatar_get_tags(PurpleAvatar *avatar) {
 	g_return_val_if_fail(PURPLE_IS_AVATAR(avatar), NULL);
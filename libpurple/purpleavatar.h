@@ -70,6 +70,19 @@ PurpleAvatar *purple_avatar_new_from_filename(const char *filename, GError **err
  */
 PurpleAvatar *purple_avatar_new_from_resource(const char *resource_path, GError **error);
 
+/**
+ * purple_avatar_new_from_bytes:
+ * @data: The encoded image data.
+ *
+ * Creates a new avatar from @data without decoding it. The image is only
+ * decoded when one of the pixbuf or animation accessors is called.
+ *
+ * Returns: (transfer full): The new instance.
+ *
+ * Since: 3.0.0
+ */
+PurpleAvatar *purple_avatar_new_from_bytes(GBytes *data);
+
 /**
  * purple_avatar_get_filename:
  * @avatar: The instance.
@@ -92,6 +105,10 @@ const char *purple_avatar_get_filename(PurpleAvatar *avatar);
  * of the animation. To get the animation see
  * [method@Purple.Avatar.get_animation].
  *
+ * For avatars created with [ctor@Purple.Avatar.new_from_bytes] this decodes
+ * the full sized image and keeps it for the lifetime of @avatar.  To display
+ * an avatar prefer [method@Purple.Avatar.get_pixbuf_for_size].
+ *
  * Returns: (transfer none): The pixbuf of the avatar which could be %NULL.
  *
  * Since: 3.0.0
@@ -123,6 +140,38 @@ gboolean purple_avatar_get_animated(PurpleAvatar *avatar);
  */
 GdkPixbufAnimation *purple_avatar_get_animation(PurpleAvatar *avatar);
 
+/**
+ * purple_avatar_get_data:
+ * @avatar: The instance.
+ *
+ * Gets the encoded image data that @avatar was created from with
+ * [ctor@Purple.Avatar.new_from_bytes].
+ *
+ * Returns: (transfer none) (nullable): The encoded data or %NULL.
+ *
+ * Since: 3.0.0
+ */
+GBytes *purple_avatar_get_data(PurpleAvatar *avatar);
+
+/**
+ * purple_avatar_get_pixbuf_for_size:
+ * @avatar: The instance.
+ * @size: The maximum width and height in pixels.
+ *
+ * Gets a [class@GdkPixbuf.Pixbuf] of @avatar that fits within @size pixels
+ * while keeping its aspect ratio. Images that are already small enough are
+ * not scaled up.
+ *
+ * Results are kept in a cache that is shared by all avatars and bounded in
+ * size, so repeated calls for the same size are cheap.
+ *
+ * Returns: (transfer full) (nullable): The pixbuf or %NULL if @avatar could
+ *          not be decoded.
+ *
+ * Since: 3.0.0
+ */
+GdkPixbuf *purple_avatar_get_pixbuf_for_size(PurpleAvatar *avatar, int size);
+
 /**
  * purple_avatar_get_tags:
  * @avatar: The instance.
@@ -25,6 +25,9 @@
 
 #include "purpleprivate.h"
 
+/* How long status changes are collected before they are applied. */
+#define PURPLE_BUDDY_PRESENCE_BATCH_INTERVAL (100) /* milliseconds */
+
 struct _PurpleBuddyPresence {
 	PurplePresence parent;
 
@@ -40,6 +43,18 @@ enum {
 };
 static GParamSpec *properties[N_PROPERTIES];
 
+typedef struct {
+	PurpleBuddy *buddy;
+	PurpleStatus *old_status;
+} PurpleBuddyPresenceUpdate;
+
+/* The pending updates in the order they were first queued, and an index of
+ * them by buddy so repeated changes to the same buddy are folded together.
+ */
+static GPtrArray *pending_updates = NULL;
+static GHashTable *pending_buddies = NULL;
+static guint pending_timeout = 0;
+
 /******************************************************************************
  * Helpers
  *****************************************************************************/
@@ -133,6 +148,27 @@ purple_buddy_presence_compare(PurpleBuddyPresence *buddy_presence1,
 	return 0;
 }
 
+/******************************************************************************
+ * Update Batching
+ *****************************************************************************/
+static void
+purple_buddy_presence_update_free(gpointer data) {
+	PurpleBuddyPresenceUpdate *update = data;
+
+	g_clear_object(&update->buddy);
+	g_clear_object(&update->old_status);
+	g_free(update);
+}
+
+static gboolean
+purple_buddy_presence_flush_updates_cb(G_GNUC_UNUSED gpointer data) {
+	pending_timeout = 0;
+
+	purple_buddy_presence_flush_updates();
+
+	return G_SOURCE_REMOVE;
+}
+
 /******************************************************************************
  * PurplePresence Implementation
  *****************************************************************************/
@@ -274,3 +310,97 @@ purple_buddy_presence_get_buddy(PurpleBuddyPresence *presence) {
 
 	return presence->buddy;
 }
+
+void
+purple_buddy_presence_queue_update(PurpleBuddy *buddy,
+                                   PurpleStatus *old_status)
+{
+	PurpleBuddyPresenceUpdate *update = NULL;
+
+	g_return_if_fail(PURPLE_IS_BUDDY(buddy));
+
+	purple_buddy_update_online_count(buddy, old_status);
+
+	if(pending_updates == NULL) {
+		pending_updates = g_ptr_array_new_with_free_func(
+			purple_buddy_presence_update_free);
+		pending_buddies = g_hash_table_new(g_direct_hash, g_direct_equal);
+	}
+
+	/* If the buddy already has a pending update, keep the status it had when
+	 * the batch started so the signals describe the whole transition.
+	 */
+	if(g_hash_table_contains(pending_buddies, buddy)) {
+		return;
+	}
+
+	update = g_new0(PurpleBuddyPresenceUpdate, 1);
+	update->buddy = g_object_ref(buddy);
+	if(old_status != NULL) {
+		update->old_status = g_object_ref(old_status);
+	}
+
+	g_ptr_array_add(pending_updates, update);
+	g_hash_table_add(pending_buddies, buddy);
+
+	if(pending_timeout == 0) {
+		pending_timeout = g_timeout_add(PURPLE_BUDDY_PRESENCE_BATCH_INTERVAL,
+		                                purple_buddy_presence_flush_updates_cb,
+		                                NULL);
+	}
+}
+
+void
+purple_buddy_presence_flush_updates(void) {
+	GPtrArray *updates = NULL;
+	GList *changed = NULL;
+
+	g_clear_handle_id(&pending_timeout, g_source_remove);
+
+	if(pending_updates == NULL) {
+		return;
+	}
+
+	/* Detach the batch first, anything queued by a signal handler below will
+	 * start a new one.
+	 */
+	updates = g_steal_pointer(&pending_updates);
+	g_clear_pointer(&pending_buddies, g_hash_table_destroy);
+
+	for(guint i = 0; i < updates->len; i++) {
+		PurpleBuddyPresenceUpdate *update = g_ptr_array_index(updates, i);
+		PurpleBlistNode *node = PURPLE_BLIST_NODE(update->buddy);
+
+		/* The buddy was removed from the list while the update was pending.
+		 * Its online counts were already settled when it was removed.
+		 */
+		if(purple_blist_node_get_parent(node) == NULL) {
+			continue;
+		}
+
+		purple_buddy_emit_status_changed(update->buddy, update->old_status);
+
+		changed = g_list_prepend(changed, update->buddy);
+	}
+
+	if(changed != NULL) {
+		changed = g_list_reverse(changed);
+
+		purple_signal_emit(purple_blist_get_handle(), "buddies-status-changed",
+		                   changed);
+
+		g_list_free(changed);
+	}
+
+	g_ptr_array_free(updates, TRUE);
+}
+
+void
+purple_buddy_presence_clear_updates(void) {
+	g_clear_handle_id(&pending_timeout, g_source_remove);
+
+	g_clear_pointer(&pending_buddies, g_hash_table_destroy);
+	if(pending_updates != NULL) {
+		g_ptr_array_free(g_steal_pointer(&pending_updates), TRUE);
+	}
+}
@@ -78,6 +78,18 @@ PurpleBuddy *purple_buddy_presence_get_buddy(PurpleBuddyPresence *presence);
 gint purple_buddy_presence_compare(PurpleBuddyPresence *buddy_presence1,
                                    PurpleBuddyPresence *buddy_presence2);
 
+/**
+ * purple_buddy_presence_flush_updates:
+ *
+ * Buddy status changes reported by protocols are collected for a short while
+ * and then applied to the buddy list in one pass, which is followed by a
+ * single `buddies-status-changed` signal. This applies any
+ * changes that are still pending right away.
+ *
+ * Since: 3.0.0
+ */
+void purple_buddy_presence_flush_updates(void);
+
 G_END_DECLS
 
 #endif /* PURPLE_BUDDY_PRESENCE_H */
@@ -0,0 +1,685 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gio/gio.h>
+
+#include "purpleconnectionscheduler.h"
+
+#include "accounts.h"
+#include "connection.h"
+#include "debug.h"
+#include "network.h"
+#include "purpleaccountmanager.h"
+#include "purpleprivate.h"
+#include "signals.h"
+#include "status.h"
+
+#define PURPLE_CONNECTION_SCHEDULER_MAX_CONNECTING (4)
+
+/* How long an account may take to sign on before the next one is started. */
+#define PURPLE_CONNECTION_SCHEDULER_CONNECT_TIMEOUT (60)
+
+/* The range of reconnect delays in seconds. */
+#define PURPLE_CONNECTION_SCHEDULER_MIN_DELAY (8)
+#define PURPLE_CONNECTION_SCHEDULER_MAX_DELAY (600)
+
+enum {
+	PROP_ZERO,
+	PROP_MAX_CONNECTING,
+	N_PROPERTIES,
+};
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+struct _PurpleConnectionScheduler {
+	GObject parent;
+
+	guint max_connecting;
+	guint connecting;
+
+	/* Queued PurpleConnectionSchedulerEntry's, most urgent first. */
+	GQueue *queue;
+	guint64 sequence;
+	guint dispatch_id;
+
+	/* Account to PurpleConnectionSchedulerEntry for every account that is
+	 * queued, waiting to reconnect or signing on.
+	 */
+	GHashTable *entries;
+
+	gboolean network_available;
+};
+
+typedef struct {
+	PurpleConnectionScheduler *scheduler;
+	PurpleAccount *account;
+
+	gint priority;
+	guint64 sequence;
+	gboolean queued;
+
+	/* Failed attempts since the account was last signed on. */
+	guint attempts;
+	guint reconnect_id;
+
+	/* Set while the account holds one of the connecting slots. */
+	guint connecting_id;
+} PurpleConnectionSchedulerEntry;
+
+static PurpleConnectionScheduler *default_scheduler = NULL;
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static void
+purple_connection_scheduler_entry_free(PurpleConnectionSchedulerEntry *entry) {
+	g_clear_handle_id(&entry->reconnect_id, g_source_remove);
+	g_clear_handle_id(&entry->connecting_id, g_source_remove);
+	g_clear_object(&entry->account);
+
+	g_free(entry);
+}
+
+static gint
+purple_connection_scheduler_entry_compare(gconstpointer a, gconstpointer b,
+                                          G_GNUC_UNUSED gpointer data)
+{
+	const PurpleConnectionSchedulerEntry *entry_a = a;
+	const PurpleConnectionSchedulerEntry *entry_b = b;
+
+	if(entry_a->priority != entry_b->priority) {
+		return (entry_a->priority < entry_b->priority) ? -1 : 1;
+	}
+
+	return (entry_a->sequence < entry_b->sequence) ? -1 : 1;
+}
+
+static PurpleConnectionSchedulerEntry *
+purple_connection_scheduler_lookup(PurpleConnectionScheduler *scheduler,
+                                   PurpleAccount *account, gboolean create)
+{
+	PurpleConnectionSchedulerEntry *entry = NULL;
+
+	entry = g_hash_table_lookup(scheduler->entries, account);
+	if(entry == NULL && create) {
+		entry = g_new0(PurpleConnectionSchedulerEntry, 1);
+		entry->scheduler = scheduler;
+		entry->account = g_object_ref(account);
+
+		g_hash_table_insert(scheduler->entries, account, entry);
+	}
+
+	return entry;
+}
+
+static void
+purple_connection_scheduler_remove(PurpleConnectionScheduler *scheduler,
+                                   PurpleConnectionSchedulerEntry *entry)
+{
+	if(entry->queued) {
+		g_queue_remove(scheduler->queue, entry);
+	}
+
+	if(entry->connecting_id != 0) {
+		scheduler->connecting--;
+	}
+
+	g_hash_table_remove(scheduler->entries, entry->account);
+}
+
+/* Removes the entry if nothing is going to happen with it anymore. */
+static void
+purple_connection_scheduler_forget(PurpleConnectionScheduler *scheduler,
+                                   PurpleConnectionSchedulerEntry *entry)
+{
+	if(!entry->queued && entry->reconnect_id == 0 &&
+	   entry->connecting_id == 0)
+	{
+		purple_connection_scheduler_remove(scheduler, entry);
+	}
+}
+
+static gboolean purple_connection_scheduler_dispatch_cb(gpointer data);
+
+static void
+purple_connection_scheduler_schedule_dispatch(PurpleConnectionScheduler *scheduler)
+{
+	if(scheduler->dispatch_id == 0) {
+		scheduler->dispatch_id =
+			g_idle_add(purple_connection_scheduler_dispatch_cb, scheduler);
+	}
+}
+
+static void
+purple_connection_scheduler_release(PurpleConnectionScheduler *scheduler,
+                                    PurpleConnectionSchedulerEntry *entry)
+{
+	if(entry->connecting_id != 0) {
+		g_clear_handle_id(&entry->connecting_id, g_source_remove);
+		scheduler->connecting--;
+
+		purple_connection_scheduler_schedule_dispatch(scheduler);
+	}
+}
+
+static void
+purple_connection_scheduler_enqueue(PurpleConnectionScheduler *scheduler,
+                                    PurpleConnectionSchedulerEntry *entry,
+                                    gint priority)
+{
+	g_clear_handle_id(&entry->reconnect_id, g_source_remove);
+
+	if(entry->queued) {
+		if(priority >= entry->priority) {
+			return;
+		}
+
+		g_queue_remove(scheduler->queue, entry);
+	}
+
+	entry->priority = priority;
+	entry->sequence = scheduler->sequence++;
+	entry->queued = TRUE;
+
+	g_queue_insert_sorted(scheduler->queue, entry,
+	                      purple_connection_scheduler_entry_compare, NULL);
+
+	purple_connection_scheduler_schedule_dispatch(scheduler);
+}
+
+/* Whether the user still wants @account to be online. */
+static gboolean
+purple_connection_scheduler_wants_online(PurpleAccount *account) {
+	PurplePresence *presence = NULL;
+
+	if(!purple_account_get_enabled(account)) {
+		return FALSE;
+	}
+
+	presence = purple_account_get_presence(account);
+
+	return presence != NULL && purple_presence_is_online(presence);
+}
+
+/* The delay doubles with every attempt, and half of it is random so that
+ * accounts which failed together don't all come back at the same time.
+ */
+static guint
+purple_connection_scheduler_get_delay(guint attempts) {
+	guint delay = PURPLE_CONNECTION_SCHEDULER_MIN_DELAY;
+
+	for(guint i = 1; i < attempts; i++) {
+		delay *= 2;
+		if(delay >= PURPLE_CONNECTION_SCHEDULER_MAX_DELAY) {
+			delay = PURPLE_CONNECTION_SCHEDULER_MAX_DELAY;
+			break;
+		}
+	}
+
+	return delay / 2 + g_random_int_range(0, delay / 2 + 1);
+}
+
+/******************************************************************************
+ * Callbacks
+ *****************************************************************************/
+static gboolean
+purple_connection_scheduler_connect_timeout_cb(gpointer data) {
+	PurpleConnectionSchedulerEntry *entry = data;
+	PurpleConnectionScheduler *scheduler = entry->scheduler;
+
+	/* The account is still allowed to finish signing on, but it has taken
+	 * long enough that it shouldn't hold up the ones behind it.
+	 */
+	entry->connecting_id = 0;
+	scheduler->connecting--;
+
+	purple_connection_scheduler_schedule_dispatch(scheduler);
+
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+purple_connection_scheduler_dispatch_cb(gpointer data) {
+	PurpleConnectionScheduler *scheduler = data;
+
+	scheduler->dispatch_id = 0;
+
+	if(!purple_network_is_available()) {
+		return G_SOURCE_REMOVE;
+	}
+
+	while(scheduler->connecting < scheduler->max_connecting) {
+		PurpleConnectionSchedulerEntry *entry = NULL;
+		PurpleAccount *account = NULL;
+
+		entry = g_queue_pop_head(scheduler->queue);
+		if(entry == NULL) {
+			break;
+		}
+
+		entry->queued = FALSE;
+		account = entry->account;
+
+		if(!purple_connection_scheduler_wants_online(account) ||
+		   !purple_account_is_disconnected(account))
+		{
+			purple_connection_scheduler_forget(scheduler, entry);
+
+			continue;
+		}
+
+		entry->connecting_id = g_timeout_add_seconds(
+			PURPLE_CONNECTION_SCHEDULER_CONNECT_TIMEOUT,
+			purple_connection_scheduler_connect_timeout_cb, entry);
+		scheduler->connecting++;
+
+		purple_account_connect(account);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+purple_connection_scheduler_reconnect_cb(gpointer data) {
+	PurpleConnectionSchedulerEntry *entry = data;
+	PurpleConnectionScheduler *scheduler = entry->scheduler;
+
+	entry->reconnect_id = 0;
+
+	purple_connection_scheduler_enqueue(scheduler, entry, G_PRIORITY_LOW);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+purple_connection_scheduler_signed_on_cb(PurpleConnection *connection,
+                                         gpointer data)
+{
+	PurpleConnectionScheduler *scheduler = data;
+	PurpleConnectionSchedulerEntry *entry = NULL;
+	PurpleAccount *account = purple_connection_get_account(connection);
+
+	entry = purple_connection_scheduler_lookup(scheduler, account, FALSE);
+	if(entry != NULL) {
+		purple_connection_scheduler_release(scheduler, entry);
+
+		entry->attempts = 0;
+		purple_connection_scheduler_forget(scheduler, entry);
+	}
+}
+
+static void
+purple_connection_scheduler_signed_off_cb(PurpleConnection *connection,
+                                          gpointer data)
+{
+	PurpleConnectionScheduler *scheduler = data;
+	PurpleConnectionSchedulerEntry *entry = NULL;
+	PurpleAccount *account = purple_connection_get_account(connection);
+
+	entry = purple_connection_scheduler_lookup(scheduler, account, FALSE);
+	if(entry != NULL) {
+		purple_connection_scheduler_release(scheduler, entry);
+		purple_connection_scheduler_forget(scheduler, entry);
+	}
+}
+
+static void
+purple_connection_scheduler_connection_error_cb(PurpleConnection *connection,
+                                                PurpleConnectionError reason,
+                                                G_GNUC_UNUSED const char *description,
+                                                gpointer data)
+{
+	PurpleConnectionScheduler *scheduler = data;
+	PurpleConnectionSchedulerEntry *entry = NULL;
+	PurpleAccount *account = purple_connection_get_account(connection);
+	guint delay = 0;
+
+	if(purple_connection_error_is_fatal(reason)) {
+		entry = purple_connection_scheduler_lookup(scheduler, account, FALSE);
+		if(entry != NULL) {
+			purple_connection_scheduler_remove(scheduler, entry);
+			purple_connection_scheduler_schedule_dispatch(scheduler);
+		}
+
+		return;
+	}
+
+	entry = purple_connection_scheduler_lookup(scheduler, account, TRUE);
+	purple_connection_scheduler_release(scheduler, entry);
+
+	entry->attempts++;
+	delay = purple_connection_scheduler_get_delay(entry->attempts);
+
+	purple_debug_info("connection-scheduler",
+	                  "reconnecting %s in %u seconds (attempt %u)",
+	                  purple_contact_info_get_username(PURPLE_CONTACT_INFO(account)),
+	                  delay, entry->attempts);
+
+	g_clear_handle_id(&entry->reconnect_id, g_source_remove);
+	entry->reconnect_id =
+		g_timeout_add_seconds(delay, purple_connection_scheduler_reconnect_cb,
+		                      entry);
+}
+
+static void
+purple_connection_scheduler_account_removed_cb(G_GNUC_UNUSED PurpleAccountManager *manager,
+                                               PurpleAccount *account,
+                                               gpointer data)
+{
+	purple_connection_scheduler_cancel(data, account);
+}
+
+/* The user set the account offline, so it shouldn't be reconnected. */
+static void
+purple_connection_scheduler_account_status_changed_cb(PurpleAccount *account,
+                                                      G_GNUC_UNUSED PurpleStatus *old_status,
+                                                      PurpleStatus *new_status,
+                                                      gpointer data)
+{
+	if(!purple_status_is_online(new_status)) {
+		purple_connection_scheduler_cancel(data, account);
+	}
+}
+
+static void
+purple_connection_scheduler_account_enabled_cb(G_GNUC_UNUSED PurpleAccountManager *manager,
+                                               PurpleAccount *account,
+                                               G_GNUC_UNUSED GParamSpec *pspec,
+                                               gpointer data)
+{
+	if(!purple_account_get_enabled(account)) {
+		purple_connection_scheduler_cancel(data, account);
+	}
+}
+
+static void
+purple_connection_scheduler_network_changed_cb(G_GNUC_UNUSED GNetworkMonitor *monitor,
+                                               gboolean available,
+                                               gpointer data)
+{
+	PurpleConnectionScheduler *scheduler = data;
+	gboolean was_available = scheduler->network_available;
+
+	scheduler->network_available = available;
+	if(!scheduler->network_available) {
+		return;
+	}
+
+	/* Coming back online is a fresh start, so the accounts that were waiting
+	 * to reconnect go right away and their failed attempts are forgotten.
+	 */
+	if(!was_available) {
+		GHashTableIter iter;
+		gpointer value = NULL;
+
+		g_hash_table_iter_init(&iter, scheduler->entries);
+		while(g_hash_table_iter_next(&iter, NULL, &value)) {
+			PurpleConnectionSchedulerEntry *entry = value;
+
+			entry->attempts = 0;
+
+			if(entry->reconnect_id != 0) {
+				purple_connection_scheduler_enqueue(scheduler, entry,
+				                                    G_PRIORITY_DEFAULT);
+			}
+		}
+	}
+
+	purple_accounts_restore_current_statuses();
+	purple_connection_scheduler_schedule_dispatch(scheduler);
+}
+
+/******************************************************************************
+ * GObject Implementation
+ *****************************************************************************/
+G_DEFINE_TYPE(PurpleConnectionScheduler, purple_connection_scheduler,
+              G_TYPE_OBJECT)
+
+static void
+purple_connection_scheduler_get_property(GObject *obj, guint param_id,
+                                         GValue *value, GParamSpec *pspec)
+{
+	PurpleConnectionScheduler *scheduler = PURPLE_CONNECTION_SCHEDULER(obj);
+
+	switch(param_id) {
+		case PROP_MAX_CONNECTING:
+			g_value_set_uint(value,
+			                 purple_connection_scheduler_get_max_connecting(scheduler));
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, param_id, pspec);
+			break;
+	}
+}
+
+static void
+purple_connection_scheduler_set_property(GObject *obj, guint param_id,
+                                         const GValue *value,
+                                         GParamSpec *pspec)
+{
+	PurpleConnectionScheduler *scheduler = PURPLE_CONNECTION_SCHEDULER(obj);
+
+	switch(param_id) {
+		case PROP_MAX_CONNECTING:
+			purple_connection_scheduler_set_max_connecting(scheduler,
+			                                               g_value_get_uint(value));
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, param_id, pspec);
+			break;
+	}
+}
+
+static void
+purple_connection_scheduler_finalize(GObject *obj) {
+	PurpleConnectionScheduler *scheduler = PURPLE_CONNECTION_SCHEDULER(obj);
+
+	g_clear_handle_id(&scheduler->dispatch_id, g_source_remove);
+
+	g_queue_free(scheduler->queue);
+	g_hash_table_destroy(scheduler->entries);
+
+	G_OBJECT_CLASS(purple_connection_scheduler_parent_class)->finalize(obj);
+}
+
+static void
+purple_connection_scheduler_init(PurpleConnectionScheduler *scheduler) {
+	scheduler->max_connecting = PURPLE_CONNECTION_SCHEDULER_MAX_CONNECTING;
+	scheduler->queue = g_queue_new();
+	scheduler->entries = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+	                                           NULL,
+	                                           (GDestroyNotify)purple_connection_scheduler_entry_free);
+	scheduler->network_available = purple_network_is_available();
+}
+
+static void
+purple_connection_scheduler_class_init(PurpleConnectionSchedulerClass *klass) {
+	GObjectClass *obj_class = G_OBJECT_CLASS(klass);
+
+	obj_class->get_property = purple_connection_scheduler_get_property;
+	obj_class->set_property = purple_connection_scheduler_set_property;
+	obj_class->finalize = purple_connection_scheduler_finalize;
+
+	/**
+	 * PurpleConnectionScheduler:max-connecting:
+	 *
+	 * The number of accounts that may be signing on at the same time.
+	 *
+	 * Since: 3.0.0
+	 */
+	properties[PROP_MAX_CONNECTING] = g_param_spec_uint(
+		"max-connecting", "max-connecting",
+		"The number of accounts that may be signing on at the same time.",
+		1, G_MAXUINT, PURPLE_CONNECTION_SCHEDULER_MAX_CONNECTING,
+		G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
+	g_object_class_install_properties(obj_class, N_PROPERTIES, properties);
+}
+
+/******************************************************************************
+ * Private API
+ *****************************************************************************/
+void
+purple_connection_scheduler_startup(void) {
+	PurpleAccountManager *manager = NULL;
+	void *handle = purple_connections_get_handle();
+
+	if(default_scheduler != NULL) {
+		return;
+	}
+
+	default_scheduler = g_object_new(PURPLE_TYPE_CONNECTION_SCHEDULER, NULL);
+	g_object_add_weak_pointer(G_OBJECT(default_scheduler),
+	                          (gpointer *)&default_scheduler);
+
+	purple_signal_connect(handle, "signed-on", default_scheduler,
+	                      G_CALLBACK(purple_connection_scheduler_signed_on_cb),
+	                      default_scheduler);
+	purple_signal_connect(handle, "signed-off", default_scheduler,
+	                      G_CALLBACK(purple_connection_scheduler_signed_off_cb),
+	                      default_scheduler);
+	purple_signal_connect(handle, "connection-error", default_scheduler,
+	                      G_CALLBACK(purple_connection_scheduler_connection_error_cb),
+	                      default_scheduler);
+	purple_signal_connect(purple_accounts_get_handle(),
+	                      "account-status-changed", default_scheduler,
+	                      G_CALLBACK(purple_connection_scheduler_account_status_changed_cb),
+	                      default_scheduler);
+
+	manager = purple_account_manager_get_default();
+	g_signal_connect_object(manager, "removed",
+	                        G_CALLBACK(purple_connection_scheduler_account_removed_cb),
+	                        default_scheduler, 0);
+	g_signal_connect_object(manager, "account-changed::enabled",
+	                        G_CALLBACK(purple_connection_scheduler_account_enabled_cb),
+	                        default_scheduler, 0);
+
+	g_signal_connect_object(g_network_monitor_get_default(), "network-changed",
+	                        G_CALLBACK(purple_connection_scheduler_network_changed_cb),
+	                        default_scheduler, 0);
+}
+
+void
+purple_connection_scheduler_shutdown(void) {
+	if(default_scheduler == NULL) {
+		return;
+	}
+
+	purple_signals_disconnect_by_handle(default_scheduler);
+
+	g_clear_object(&default_scheduler);
+}
+
+/******************************************************************************
+ * Public API
+ *****************************************************************************/
+PurpleConnectionScheduler *
+purple_connection_scheduler_get_default(void) {
+	return default_scheduler;
+}
+
+void
+purple_connection_scheduler_connect(PurpleConnectionScheduler *scheduler,
+                                    PurpleAccount *account, gint priority)
+{
+	PurpleConnectionSchedulerEntry *entry = NULL;
+
+	g_return_if_fail(PURPLE_IS_CONNECTION_SCHEDULER(scheduler));
+	g_return_if_fail(PURPLE_IS_ACCOUNT(account));
+
+	entry = purple_connection_scheduler_lookup(scheduler, account, TRUE);
+	purple_connection_scheduler_enqueue(scheduler, entry, priority);
+}
+
+void
+purple_connection_scheduler_cancel(PurpleConnectionScheduler *scheduler,
+                                   PurpleAccount *account)
+{
+	PurpleConnectionSchedulerEntry *entry = NULL;
+
+	g_return_if_fail(PURPLE_IS_CONNECTION_SCHEDULER(scheduler));
+	g_return_if_fail(PURPLE_IS_ACCOUNT(account));
+
+	entry = purple_connection_scheduler_lookup(scheduler, account, FALSE);
+	if(entry != NULL) {
+		gboolean connecting = entry->connecting_id != 0;
+
+		purple_connection_scheduler_remove(scheduler, entry);
+
+		if(connecting) {
+			purple_connection_scheduler_schedule_dispatch(scheduler);
+		}
+	}
+}
+
+gboolean
+purple_connection_scheduler_is_pending(PurpleConnectionScheduler *scheduler,
+                                       PurpleAccount *account)
+{
+	PurpleConnectionSchedulerEntry *entry = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_CONNECTION_SCHEDULER(scheduler), FALSE);
+	g_return_val_if_fail(PURPLE_IS_ACCOUNT(account), FALSE);
+
+	entry = purple_connection_scheduler_lookup(scheduler, account, FALSE);
+	if(entry == NULL) {
+		return FALSE;
+	}
+
+	return entry->queued || entry->reconnect_id != 0;
+}
+
+gboolean
+purple_connection_scheduler_is_connecting(PurpleConnectionScheduler *scheduler,
+                                          PurpleAccount *account)
+{
+	PurpleConnectionSchedulerEntry *entry = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_CONNECTION_SCHEDULER(scheduler), FALSE);
+	g_return_val_if_fail(PURPLE_IS_ACCOUNT(account), FALSE);
+
+	entry = purple_connection_scheduler_lookup(scheduler, account, FALSE);
+
+	return entry != NULL && entry->connecting_id != 0;
+}
+
+guint
+purple_connection_scheduler_get_max_connecting(PurpleConnectionScheduler *scheduler)
+{
+	g_return_val_if_fail(PURPLE_IS_CONNECTION_SCHEDULER(scheduler), 0);
+
+	return scheduler->max_connecting;
+}
+
+void
+purple_connection_scheduler_set_max_connecting(PurpleConnectionScheduler *scheduler,
+                                               guint max_connecting)
+{
+	g_return_if_fail(PURPLE_IS_CONNECTION_SCHEDULER(scheduler));
+	g_return_if_fail(max_connecting > 0);
+
+	if(scheduler->max_connecting == max_connecting) {
+		return;
+	}
+
+	scheduler->max_connecting = max_connecting;
+
+	g_object_notify_by_pspec(G_OBJECT(scheduler),
+	                         properties[PROP_MAX_CONNECTING]);
+
+	purple_connection_scheduler_schedule_dispatch(scheduler);
+}
@@ -0,0 +1,147 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(PURPLE_GLOBAL_HEADER_INSIDE) && !defined(PURPLE_COMPILATION)
+# error "only <purple.h> may be included directly"
+#endif
+
+#ifndef PURPLE_CONNECTION_SCHEDULER_H
+#define PURPLE_CONNECTION_SCHEDULER_H
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include "account.h"
+
+G_BEGIN_DECLS
+
+#define PURPLE_TYPE_CONNECTION_SCHEDULER (purple_connection_scheduler_get_type())
+
+/**
+ * PurpleConnectionScheduler:
+ *
+ * #PurpleConnectionScheduler decides when accounts connect.  Accounts are
+ * queued by priority and only a limited number of them are signing on at any
+ * time, which keeps a large number of accounts from doing their DNS lookups,
+ * TLS handshakes and authentication all at once.
+ *
+ * Accounts that lose their connection to a temporary error are reconnected
+ * after a randomized delay that doubles with every failed attempt, and all
+ * accounts are reconnected when the network becomes available again.
+ *
+ * Since: 3.0.0
+ */
+G_DECLARE_FINAL_TYPE(PurpleConnectionScheduler, purple_connection_scheduler,
+                     PURPLE, CONNECTION_SCHEDULER, GObject)
+
+/**
+ * purple_connection_scheduler_get_default:
+ *
+ * Gets the default #PurpleConnectionScheduler instance.
+ *
+ * Returns: (transfer none): The default #PurpleConnectionScheduler instance.
+ *
+ * Since: 3.0.0
+ */
+PurpleConnectionScheduler *purple_connection_scheduler_get_default(void);
+
+/**
+ * purple_connection_scheduler_connect:
+ * @scheduler: The instance.
+ * @account: The account to connect.
+ * @priority: The priority of the request, like %G_PRIORITY_DEFAULT.  Lower
+ *            values connect first.
+ *
+ * Queues @account to be connected.  Accounts with the same priority are
+ * connected in the order they were queued.  If @account is already queued
+ * it keeps its place unless @priority is more urgent, and if it is waiting
+ * to reconnect it is queued right away.
+ *
+ * Accounts that are disabled, set to an offline status, or no longer
+ * disconnected by the time their turn comes are skipped.  Disabling an account
+ * or setting it offline also cancels its pending connect.
+ *
+ * Since: 3.0.0
+ */
+void purple_connection_scheduler_connect(PurpleConnectionScheduler *scheduler, PurpleAccount *account, gint priority);
+
+/**
+ * purple_connection_scheduler_cancel:
+ * @scheduler: The instance.
+ * @account: The account.
+ *
+ * Removes @account from the queue and stops any pending reconnect for it.
+ * This does not disconnect @account if it is already signing on.
+ *
+ * Since: 3.0.0
+ */
+void purple_connection_scheduler_cancel(PurpleConnectionScheduler *scheduler, PurpleAccount *account);
+
+/**
+ * purple_connection_scheduler_is_pending:
+ * @scheduler: The instance.
+ * @account: The account.
+ *
+ * Gets whether @account is queued or waiting to reconnect.
+ *
+ * Returns: %TRUE if @account will be connected by @scheduler.
+ *
+ * Since: 3.0.0
+ */
+gboolean purple_connection_scheduler_is_pending(PurpleConnectionScheduler *scheduler, PurpleAccount *account);
+
+/**
+ * purple_connection_scheduler_is_connecting:
+ * @scheduler: The instance.
+ * @account: The account.
+ *
+ * Gets whether @account was started by @scheduler and is holding one of the
+ * connecting slots while it signs on.
+ *
+ * Returns: %TRUE if @account is signing on in one of the slots.
+ *
+ * Since: 3.0.0
+ */
+gboolean purple_connection_scheduler_is_connecting(PurpleConnectionScheduler *scheduler, PurpleAccount *account);
+
+/**
+ * purple_connection_scheduler_get_max_connecting:
+ * @scheduler: The instance.
+ *
+ * Gets the number of accounts that may be signing on at the same time.
+ *
+ * Returns: The maximum number of accounts signing on at once.
+ *
+ * Since: 3.0.0
+ */
+guint purple_connection_scheduler_get_max_connecting(PurpleConnectionScheduler *scheduler);
+
+/**
+ * purple_connection_scheduler_set_max_connecting:
+ * @scheduler: The instance.
+ * @max_connecting: The new maximum, at least 1.
+ *
+ * Sets the number of accounts that may be signing on at the same time.
+ *
+ * Since: 3.0.0
+ */
+void purple_connection_scheduler_set_max_connecting(PurpleConnectionScheduler *scheduler, guint max_connecting);
+
+G_END_DECLS
+
+#endif /* PURPLE_CONNECTION_SCHEDULER_H */
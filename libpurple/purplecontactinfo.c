@@ -31,7 +31,13 @@ typedef struct  {
 
 	char *name_for_display;
 
+	/* purple_str_search_key() of the names that searches match against. */
+	char *username_key;
+	char *display_name_key;
+	char *alias_key;
+
 	GdkPixbuf *avatar;
+	PurpleAvatar *encoded_avatar;
 
 	PurplePresence *presence;
 
@@ -50,6 +56,7 @@ enum {
 	PROP_ALIAS,
 	PROP_COLOR,
 	PROP_AVATAR,
+	PROP_ENCODED_AVATAR,
 	PROP_PRESENCE,
 	PROP_TAGS,
 	PROP_PERSON,
@@ -174,6 +181,10 @@ purple_contact_info_get_property(GObject *obj, guint param_id, GValue *value,
 		case PROP_AVATAR:
 			g_value_set_object(value, purple_contact_info_get_avatar(info));
 			break;
+		case PROP_ENCODED_AVATAR:
+			g_value_set_object(value,
+			                   purple_contact_info_get_encoded_avatar(info));
+			break;
 		case PROP_PRESENCE:
 			g_value_set_object(value, purple_contact_info_get_presence(info));
 			break;
@@ -222,6 +233,10 @@ purple_contact_info_set_property(GObject *obj, guint param_id,
 		case PROP_AVATAR:
 			purple_contact_info_set_avatar(info, g_value_get_object(value));
 			break;
+		case PROP_ENCODED_AVATAR:
+			purple_contact_info_set_encoded_avatar(info,
+			                                       g_value_get_object(value));
+			break;
 		case PROP_PERSON:
 			purple_contact_info_set_person(info, g_value_get_object(value));
 			break;
@@ -242,6 +257,7 @@ purple_contact_info_dispose(GObject *obj) {
 	priv = purple_contact_info_get_instance_private(info);
 
 	g_clear_object(&priv->avatar);
+	g_clear_object(&priv->encoded_avatar);
 	g_clear_object(&priv->presence);
 	g_clear_object(&priv->tags);
 	g_clear_object(&priv->person);
@@ -262,6 +278,9 @@ purple_contact_info_finalize(GObject *obj) {
 	g_clear_pointer(&priv->alias, g_free);
 	g_clear_pointer(&priv->color, g_free);
 	g_clear_pointer(&priv->name_for_display, g_free);
+	g_clear_pointer(&priv->username_key, g_free);
+	g_clear_pointer(&priv->display_name_key, g_free);
+	g_clear_pointer(&priv->alias_key, g_free);
 
 	G_OBJECT_CLASS(purple_contact_info_parent_class)->finalize(obj);
 }
@@ -392,6 +411,25 @@ purple_contact_info_class_init(PurpleContactInfoClass *klass) {
 		GDK_TYPE_PIXBUF,
 		G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+	/**
+	 * PurpleContactInfo:encoded-avatar:
+	 *
+	 * The avatar for this contact as the encoded image data it was received
+	 * as. It is only decoded when someone asks for it, so user interfaces
+	 * should use [method@Purple.Avatar.get_pixbuf_for_size] to get an image
+	 * at the size they will display it at.
+	 *
+	 * If [property@Purple.ContactInfo:avatar] has not been set, it will be
+	 * decoded from this avatar when read.
+	 *
+	 * Since: 3.0.0
+	 */
+	properties[PROP_ENCODED_AVATAR] = g_param_spec_object(
+		"encoded-avatar", "encoded-avatar",
+		"The encoded avatar of the contact",
+		PURPLE_TYPE_AVATAR,
+		G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
 	/**
 	 * PurpleContactInfo:presence:
 	 *
@@ -579,6 +617,9 @@ purple_contact_info_set_username(PurpleContactInfo *info,
 	priv->username = g_strdup(username);
 
 	if(changed) {
+		g_free(priv->username_key);
+		priv->username_key = purple_str_search_key(username);
+
 		g_object_freeze_notify(G_OBJECT(info));
 
 		g_object_notify_by_pspec(G_OBJECT(info), properties[PROP_USERNAME]);
@@ -617,6 +658,9 @@ purple_contact_info_set_display_name(PurpleContactInfo *info,
 	priv->display_name = g_strdup(display_name);
 
 	if(changed) {
+		g_free(priv->display_name_key);
+		priv->display_name_key = purple_str_search_key(display_name);
+
 		g_object_freeze_notify(G_OBJECT(info));
 
 		g_object_notify_by_pspec(G_OBJECT(info), properties[PROP_DISPLAY_NAME]);
@@ -653,6 +697,9 @@ purple_contact_info_set_alias(PurpleContactInfo *info, const gchar *alias) {
 	priv->alias = g_strdup(alias);
 
 	if(changed) {
+		g_free(priv->alias_key);
+		priv->alias_key = purple_str_search_key(alias);
+
 		g_object_freeze_notify(G_OBJECT(info));
 
 		g_object_notify_by_pspec(G_OBJECT(info), properties[PROP_ALIAS]);
@@ -698,6 +745,10 @@ purple_contact_info_get_avatar(PurpleContactInfo *info) {
 
 	priv = purple_contact_info_get_instance_private(info);
 
+	if(priv->avatar == NULL && PURPLE_IS_AVATAR(priv->encoded_avatar)) {
+		return purple_avatar_get_pixbuf(priv->encoded_avatar);
+	}
+
 	return priv->avatar;
 }
 
@@ -714,6 +765,39 @@ purple_contact_info_set_avatar(PurpleContactInfo *info, GdkPixbuf *avatar) {
 	}
 }
 
+PurpleAvatar *
+purple_contact_info_get_encoded_avatar(PurpleContactInfo *info) {
+	PurpleContactInfoPrivate *priv = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_CONTACT_INFO(info), NULL);
+
+	priv = purple_contact_info_get_instance_private(info);
+
+	return priv->encoded_avatar;
+}
+
+void
+purple_contact_info_set_encoded_avatar(PurpleContactInfo *info,
+                                       PurpleAvatar *avatar)
+{
+	PurpleContactInfoPrivate *priv = NULL;
+
+	g_return_if_fail(PURPLE_IS_CONTACT_INFO(info));
+
+	priv = purple_contact_info_get_instance_private(info);
+
+	if(g_set_object(&priv->encoded_avatar, avatar)) {
+		GObject *obj = G_OBJECT(info);
+
+		g_object_freeze_notify(obj);
+		g_object_notify_by_pspec(obj, properties[PROP_ENCODED_AVATAR]);
+		if(priv->avatar == NULL) {
+			g_object_notify_by_pspec(obj, properties[PROP_AVATAR]);
+		}
+		g_object_thaw_notify(obj);
+	}
+}
+
 PurplePresence *
 purple_contact_info_get_presence(PurpleContactInfo *info) {
 	PurpleContactInfoPrivate *priv = NULL;
@@ -852,7 +936,8 @@ purple_contact_info_compare(PurpleContactInfo *a, PurpleContactInfo *b) {
 
 gboolean
 purple_contact_info_matches(PurpleContactInfo *info, const char *needle) {
-	PurpleContactInfoPrivate *priv = NULL;
+	char *key = NULL;
+	gboolean ret = FALSE;
 
 	g_return_val_if_fail(PURPLE_IS_CONTACT_INFO(info), FALSE);
 
@@ -860,24 +945,37 @@ purple_contact_info_matches(PurpleContactInfo *info, const char *needle) {
 		return TRUE;
 	}
 
+	key = purple_str_search_key(needle);
+	ret = purple_contact_info_matches_search_key(info, key);
+	g_free(key);
+
+	return ret;
+}
+
+gboolean
+purple_contact_info_matches_search_key(PurpleContactInfo *info,
+                                       const char *key)
+{
+	PurpleContactInfoPrivate *priv = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_CONTACT_INFO(info), FALSE);
+
+	if(purple_strempty(key)) {
+		return TRUE;
+	}
+
 	priv = purple_contact_info_get_instance_private(info);
 
-	if(!purple_strempty(priv->username)) {
-		if(purple_strmatches(needle, priv->username)) {
-			return TRUE;
-		}
+	if(purple_strmatches_search_key(key, priv->username_key)) {
+		return TRUE;
 	}
 
-	if(!purple_strempty(priv->alias)) {
-		if(purple_strmatches(needle, priv->alias)) {
-			return TRUE;
-		}
+	if(purple_strmatches_search_key(key, priv->alias_key)) {
+		return TRUE;
 	}
 
-	if(!purple_strempty(priv->display_name)) {
-		if(purple_strmatches(needle, priv->display_name)) {
-			return TRUE;
-		}
+	if(purple_strmatches_search_key(key, priv->display_name_key)) {
+		return TRUE;
 	}
 
 	/* Nothing matched, so return FALSE. */
@@ -28,6 +28,7 @@
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
+#include <libpurple/purpleavatar.h>
 #include <libpurple/purplepresence.h>
 #include <libpurple/purpletags.h>
 
@@ -256,6 +257,34 @@ GdkPixbuf *purple_contact_info_get_avatar(PurpleContactInfo *info);
  */
 void purple_contact_info_set_avatar(PurpleContactInfo *info, GdkPixbuf *avatar);
 
+/**
+ * purple_contact_info_get_encoded_avatar:
+ * @info: The instance.
+ *
+ * Gets the encoded avatar for @info if one is set.
+ *
+ * Returns: (transfer none) (nullable): The encoded avatar if set, otherwise
+ *          %NULL.
+ *
+ * Since: 3.0.0
+ */
+PurpleAvatar *purple_contact_info_get_encoded_avatar(PurpleContactInfo *info);
+
+/**
+ * purple_contact_info_set_encoded_avatar:
+ * @info: The instance.
+ * @avatar: (nullable): The new encoded avatar to set.
+ *
+ * Sets the encoded avatar for @info to @avatar. Unlike
+ * [method@Purple.ContactInfo.set_avatar], @avatar is not decoded until a user
+ * interface asks for it.
+ *
+ * Typically this should only called by the protocol plugin.
+ *
+ * Since: 3.0.0
+ */
+void purple_contact_info_set_encoded_avatar(PurpleContactInfo *info, PurpleAvatar *avatar);
+
 /**
  * purple_contact_info_get_presence:
  * @info: The instance.
@@ -373,6 +402,24 @@ int purple_contact_info_compare(PurpleContactInfo *a, PurpleContactInfo *b);
  */
 gboolean purple_contact_info_matches(PurpleContactInfo *info, const char *needle);
 
+/**
+ * purple_contact_info_matches_search_key:
+ * @info: The instance.
+ * @key: (nullable): The search key to match.
+ *
+ * Like [method@Purple.ContactInfo.matches] but @key has already been passed
+ * through [func@Purple.str_search_key], which saves doing that for every
+ * contact when matching many of them against the same string.
+ *
+ * If @key is %NULL or empty string, %TRUE will be returned.
+ *
+ * Returns: %TRUE if @key matches the alias, display name, or username,
+ *          otherwise %FALSE.
+ *
+ * Since: 3.0.0
+ */
+gboolean purple_contact_info_matches_search_key(PurpleContactInfo *info, const char *key);
+
 G_END_DECLS
 
 #endif /* PURPLE_CONTACT_INFO_H */
@@ -20,7 +20,6 @@
 
 #include "purplecontactmanager.h"
 
-#include "purplegdkpixbuf.h"
 #include "purpleprivate.h"
 #include "util.h"
 
@@ -79,65 +78,36 @@ purple_contact_manager_find_with_id_helper(gconstpointer a, gconstpointer b) {
 	return purple_strequal(id_a, id_b);
 }
 
-static gboolean
-purple_contact_manager_convert_icon_to_avatar(G_GNUC_UNUSED GBinding *binding,
-                                              const GValue *from_value,
-                                              GValue *to_value,
-                                              G_GNUC_UNUSED gpointer user_data)
-{
-	PurpleBuddyIcon *icon = g_value_get_pointer(from_value);
-	GdkPixbuf *avatar = NULL;
-	gconstpointer data = NULL;
-	size_t len;
-
-	if(icon == NULL) {
-		g_value_set_object(to_value, NULL);
-		return TRUE;
-	}
-
-	data = purple_buddy_icon_get_data(icon, &len);
-
-	avatar = purple_gdk_pixbuf_from_data(data, len);
-
-	g_value_take_object(to_value, avatar);
-
-	return TRUE;
-}
-
-static gboolean
-purple_contact_manager_convert_avatar_to_icon(G_GNUC_UNUSED GBinding *binding,
-                                              const GValue *from_value,
-                                              GValue *to_value,
-                                              G_GNUC_UNUSED gpointer user_data)
+/******************************************************************************
+ * Callbacks
+ *****************************************************************************/
+static void
+purple_contact_manager_buddy_icon_changed_cb(GObject *obj,
+                                             G_GNUC_UNUSED GParamSpec *pspec,
+                                             gpointer data)
 {
 	PurpleBuddyIcon *icon = NULL;
-	GdkPixbuf *avatar = g_value_get_object(from_value);
-	gchar *buffer = NULL;
-	gsize len;
-	gboolean result = FALSE;
+	PurpleAvatar *avatar = NULL;
+	GBytes *contents = NULL;
 
-	if(!GDK_IS_PIXBUF(avatar)) {
-		g_value_set_pointer(to_value, NULL);
-
-		return TRUE;
+	/* Hand the encoded icon data to the contact as is. It only gets decoded
+	 * if a user interface actually displays it.
+	 */
+	icon = purple_buddy_get_icon(PURPLE_BUDDY(obj));
+	if(icon != NULL) {
+		contents = purple_buddy_icon_get_contents(icon);
 	}
 
-	result = gdk_pixbuf_save_to_buffer(avatar, &buffer, &len, "png", NULL,
-	                                   "compression", "9", NULL);
-	if(!result) {
-		return FALSE;
+	if(contents != NULL) {
+		avatar = purple_avatar_new_from_bytes(contents);
+		g_bytes_unref(contents);
 	}
 
-	purple_buddy_icon_set_data(icon, (guchar *)buffer, len, NULL);
-
-	g_free(buffer);
+	purple_contact_info_set_encoded_avatar(PURPLE_CONTACT_INFO(data), avatar);
 
-	return TRUE;
+	g_clear_object(&avatar);
 }
 
-/******************************************************************************
- * Callbacks
- *****************************************************************************/
 static void
 purple_contact_manager_contact_person_changed_cb(GObject *obj,
                                                  G_GNUC_UNUSED GParamSpec *pspec,
@@ -621,11 +591,11 @@ purple_contact_manager_add_buddy(PurpleContactManager *manager,
 	                       "active-status",
 	                       G_BINDING_SYNC_CREATE | G_BINDING_BIDIRECTIONAL);
 
-	g_object_bind_property_full(buddy, "icon", contact, "avatar",
-	                            G_BINDING_SYNC_CREATE | G_BINDING_BIDIRECTIONAL,
-	                            purple_contact_manager_convert_icon_to_avatar,
-	                            purple_contact_manager_convert_avatar_to_icon,
-	                            NULL, NULL);
+	g_signal_connect_object(buddy, "notify::icon",
+	                        G_CALLBACK(purple_contact_manager_buddy_icon_changed_cb),
+	                        contact, 0);
+	purple_contact_manager_buddy_icon_changed_cb(G_OBJECT(buddy), NULL,
+	                                             contact);
 
 	/* Finally add it to the manager. */
 	purple_contact_manager_add(manager, contact);
@@ -25,6 +25,7 @@
 
 #include "debug.h"
 #include "proxy.h"
+#include "purpletlssessioncache.h"
 
 typedef struct {
 	GIOStream *stream;
@@ -114,6 +115,22 @@ purple_gio_graceful_close(GIOStream *stream,
 	}
 }
 
+static void
+purple_gio_socket_client_event_cb(G_GNUC_UNUSED GSocketClient *client,
+                                  GSocketClientEvent event,
+                                  G_GNUC_UNUSED GSocketConnectable *connectable,
+                                  GIOStream *connection, gpointer data)
+{
+	PurpleTlsSessionCache *cache = purple_tls_session_cache_get_default();
+
+	if(event != G_SOCKET_CLIENT_TLS_HANDSHAKING || cache == NULL) {
+		return;
+	}
+
+	purple_tls_session_cache_prepare(cache, data,
+	                                 G_TLS_CLIENT_CONNECTION(connection));
+}
+
 GSocketClient *
 purple_gio_socket_client_new(PurpleAccount *account, GError **error)
 {
@@ -130,6 +147,13 @@ purple_gio_socket_client_new(PurpleAccount *account, GError **error)
 	g_socket_client_set_proxy_resolver(client, resolver);
 	g_object_unref(resolver);
 
+	/* Let TLS connections resume the account's earlier sessions. */
+	if (PURPLE_IS_ACCOUNT(account)) {
+		g_signal_connect_object(client, "event",
+		                        G_CALLBACK(purple_gio_socket_client_event_cb),
+		                        account, 0);
+	}
+
 	return client;
 }
 
@@ -66,6 +66,11 @@ purple_gio_graceful_close(GIOStream *stream,
  * A helper function to simplify creating a #GSocketClient. It's intended
  * to be used in protocol plugins.
  *
+ * Host name and SRV lookups made by the client go through the default
+ * #PurpleResolver, so they are shared with every other account.  TLS
+ * connections made by the client offer to resume @account's last session
+ * with the same server from the #PurpleTlsSessionCache.
+ *
  * Returns: (transfer full): A new #GSocketClient with the appropriate
  * GProxyResolver, based on the #PurpleAccount settings and
  * TLS Certificate handling, or NULL if an error occurred.
@@ -299,3 +299,61 @@ purple_history_adapter_write(PurpleHistoryAdapter *adapter,
 
 	return FALSE;
 }
+
+gboolean
+purple_history_adapter_write_messages(PurpleHistoryAdapter *adapter,
+                                      PurpleConversation *conversation,
+                                      GPtrArray *messages,
+                                      GError **error)
+{
+	PurpleHistoryAdapterClass *klass = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_HISTORY_ADAPTER(adapter), FALSE);
+	g_return_val_if_fail(PURPLE_IS_CONVERSATION(conversation), FALSE);
+	g_return_val_if_fail(messages != NULL, FALSE);
+
+	if(messages->len == 0) {
+		return TRUE;
+	}
+
+	klass = PURPLE_HISTORY_ADAPTER_GET_CLASS(adapter);
+	if(klass != NULL && klass->write_messages != NULL) {
+		return klass->write_messages(adapter, conversation, messages, error);
+	}
+
+	for(guint i = 0; i < messages->len; i++) {
+		PurpleMessage *message = g_ptr_array_index(messages, i);
+
+		if(!purple_history_adapter_write(adapter, conversation, message,
+		                                 error))
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+PurpleMessage *
+purple_history_adapter_get_last_message(PurpleHistoryAdapter *adapter,
+                                        PurpleAccount *account,
+                                        const gchar *conversation_id,
+                                        GError **error)
+{
+	PurpleHistoryAdapterClass *klass = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_HISTORY_ADAPTER(adapter), NULL);
+	g_return_val_if_fail(PURPLE_IS_ACCOUNT(account), NULL);
+
+	klass = PURPLE_HISTORY_ADAPTER_GET_CLASS(adapter);
+	if(klass != NULL && klass->get_last_message != NULL) {
+		return klass->get_last_message(adapter, account, conversation_id,
+		                               error);
+	}
+
+	g_set_error(error, PURPLE_HISTORY_ADAPTER_DOMAIN, 0,
+	            "%s does not implement the get_last_message function.",
+	            G_OBJECT_TYPE_NAME(G_OBJECT(adapter)));
+
+	return NULL;
+}
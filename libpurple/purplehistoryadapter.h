@@ -72,11 +72,13 @@ struct _PurpleHistoryAdapterClass {
 	GList* (*query)(PurpleHistoryAdapter *adapter, const gchar *query, GError **error);
 	gboolean (*remove)(PurpleHistoryAdapter *adapter, const gchar *query, GError **error);
 	gboolean (*write)(PurpleHistoryAdapter *adapter, PurpleConversation *conversation, PurpleMessage *message, GError **error);
+	gboolean (*write_messages)(PurpleHistoryAdapter *adapter, PurpleConversation *conversation, GPtrArray *messages, GError **error);
+	PurpleMessage *(*get_last_message)(PurpleHistoryAdapter *adapter, PurpleAccount *account, const gchar *conversation_id, GError **error);
 
 	/*< private >*/
 
 	/* Some extra padding to play it safe. */
-	gpointer reserved[8];
+	gpointer reserved[6];
 };
 
 /**
@@ -121,6 +123,54 @@ gboolean purple_history_adapter_write(PurpleHistoryAdapter *adapter,
                                       PurpleMessage *message,
                                       GError **error);
 
+/**
+ * purple_history_adapter_write_messages:
+ * @adapter: The #PurpleHistoryAdapter instance.
+ * @conversation: The #PurpleConversation the messages belong to.
+ * @messages: (element-type PurpleMessage) (inout): The messages to write.
+ * @error: A return address for a #GError.
+ *
+ * Writes all of @messages to @adapter at once.  This is meant for protocols
+ * that fetch history from a server archive a page at a time and is a lot
+ * cheaper than calling purple_history_adapter_write() for each message.
+ *
+ * Messages whose id is already stored for @conversation are skipped and
+ * removed from @messages, so when this returns @messages only holds the
+ * messages that were actually written.  Adapters that do not implement this
+ * fall back to writing each message individually without checking for
+ * duplicates.
+ *
+ * Returns: %TRUE if the messages were written successfully.
+ *
+ * Since: 3.0.0
+ */
+gboolean purple_history_adapter_write_messages(PurpleHistoryAdapter *adapter,
+                                               PurpleConversation *conversation,
+                                               GPtrArray *messages,
+                                               GError **error);
+
+/**
+ * purple_history_adapter_get_last_message:
+ * @adapter: The #PurpleHistoryAdapter instance.
+ * @account: The #PurpleAccount to look in.
+ * @conversation_id: (nullable): The name of the conversation to look in.
+ * @error: A return address for a #GError.
+ *
+ * Gets the message that was written to @adapter most recently for
+ * @conversation_id on @account, or for any conversation on @account if
+ * @conversation_id is %NULL.  Protocols use this to find out where to resume
+ * fetching history from a server archive.
+ *
+ * Returns: (transfer full) (nullable): The last message written or %NULL if
+ *          nothing has been written yet or an error occurred.
+ *
+ * Since: 3.0.0
+ */
+PurpleMessage *purple_history_adapter_get_last_message(PurpleHistoryAdapter *adapter,
+                                                       PurpleAccount *account,
+                                                       const gchar *conversation_id,
+                                                       GError **error);
+
 /**
  * purple_history_adapter_query:
  * @adapter: The #PurpleHistoryAdapter instance.
@@ -381,6 +381,47 @@ purple_history_manager_write(PurpleHistoryManager *manager,
 	                                    message, error);
 }
 
+gboolean
+purple_history_manager_write_messages(PurpleHistoryManager *manager,
+                                      PurpleConversation *conversation,
+                                      GPtrArray *messages,
+                                      GError **error)
+{
+	g_return_val_if_fail(PURPLE_IS_HISTORY_MANAGER(manager), FALSE);
+	g_return_val_if_fail(PURPLE_IS_CONVERSATION(conversation), FALSE);
+	g_return_val_if_fail(messages != NULL, FALSE);
+
+	if(manager->active_adapter == NULL) {
+		g_set_error_literal(error, PURPLE_HISTORY_MANAGER_DOMAIN, 0,
+		                    _("no active history adapter"));
+		return FALSE;
+	}
+
+	return purple_history_adapter_write_messages(manager->active_adapter,
+	                                             conversation, messages,
+	                                             error);
+}
+
+PurpleMessage *
+purple_history_manager_get_last_message(PurpleHistoryManager *manager,
+                                        PurpleAccount *account,
+                                        const gchar *conversation_id,
+                                        GError **error)
+{
+	g_return_val_if_fail(PURPLE_IS_HISTORY_MANAGER(manager), NULL);
+	g_return_val_if_fail(PURPLE_IS_ACCOUNT(account), NULL);
+
+	if(manager->active_adapter == NULL) {
+		g_set_error_literal(error, PURPLE_HISTORY_MANAGER_DOMAIN, 0,
+		                    _("no active history adapter"));
+		return NULL;
+	}
+
+	return purple_history_adapter_get_last_message(manager->active_adapter,
+	                                               account, conversation_id,
+	                                               error);
+}
+
 void
 purple_history_manager_foreach(PurpleHistoryManager *manager,
                                PurpleHistoryManagerForeachFunc func,
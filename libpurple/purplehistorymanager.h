@@ -205,6 +205,40 @@ gboolean purple_history_manager_remove(PurpleHistoryManager *manager, const gcha
  */
 gboolean purple_history_manager_write(PurpleHistoryManager *manager, PurpleConversation *conversation, PurpleMessage *message, GError **error);
 
+/**
+ * purple_history_manager_write_messages:
+ * @manager: The #PurpleHistoryManager instance.
+ * @conversation: The #PurpleConversation the messages belong to.
+ * @messages: (element-type PurpleMessage) (inout): The messages to write.
+ * @error: A return address for a #GError.
+ *
+ * Writes @messages to the active adapter of @manager in one go.  Messages that
+ * the adapter already has are removed from @messages; see
+ * purple_history_adapter_write_messages() for details.
+ *
+ * Returns: %TRUE if @messages were successfully written, %FALSE otherwise.
+ *
+ * Since: 3.0.0
+ */
+gboolean purple_history_manager_write_messages(PurpleHistoryManager *manager, PurpleConversation *conversation, GPtrArray *messages, GError **error);
+
+/**
+ * purple_history_manager_get_last_message:
+ * @manager: The #PurpleHistoryManager instance.
+ * @account: The #PurpleAccount to look in.
+ * @conversation_id: (nullable): The name of the conversation to look in.
+ * @error: A return address for a #GError.
+ *
+ * Gets the most recently written message for @conversation_id on @account
+ * from the active adapter of @manager.  If @conversation_id is %NULL, the most
+ * recent message of any conversation on @account is returned.
+ *
+ * Returns: (transfer full) (nullable): The last message or %NULL.
+ *
+ * Since: 3.0.0
+ */
+PurpleMessage *purple_history_manager_get_last_message(PurpleHistoryManager *manager, PurpleAccount *account, const gchar *conversation_id, GError **error);
+
 /**
  * purple_history_manager_foreach:
  * @manager: The #PurpleHistoryManager instance.
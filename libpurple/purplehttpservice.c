@@ -0,0 +1,436 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <glib/gi18n-lib.h>
+
+#include "purplehttpservice.h"
+
+#include "debug.h"
+#include "proxy.h"
+#include "purplepath.h"
+#include "purpleprivate.h"
+
+#define PURPLE_HTTP_SERVICE_MAX_CONNS (48)
+#define PURPLE_HTTP_SERVICE_MAX_CONNS_PER_HOST (6)
+#define PURPLE_HTTP_SERVICE_CACHE_SIZE (50 * 1024 * 1024)
+
+struct _PurpleHttpService {
+	GObject parent;
+
+	/* Proxy configuration to SoupSession. */
+	GHashTable *sessions;
+
+	/* Session and URI to the PurpleHttpServiceFetch that is getting it. */
+	GHashTable *fetches;
+};
+
+typedef struct {
+	PurpleHttpService *service;
+	gchar *key;
+
+	SoupMessage *msg;
+	GCancellable *cancellable;
+
+	/* The GTasks of everyone waiting for the body. */
+	GPtrArray *tasks;
+} PurpleHttpServiceFetch;
+
+static PurpleHttpService *default_service = NULL;
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static gchar *
+purple_http_service_session_key(PurpleAccount *account) {
+	PurpleProxyInfo *info = purple_proxy_get_setup(account);
+	PurpleProxyType type = purple_proxy_info_get_proxy_type(info);
+
+	if(type == PURPLE_PROXY_TYPE_NONE) {
+		return g_strdup("direct");
+	}
+
+	return g_strdup_printf("%d:%s:%d:%s:%s", type,
+	                       purple_proxy_info_get_hostname(info),
+	                       purple_proxy_info_get_port(info),
+	                       purple_proxy_info_get_username(info),
+	                       purple_proxy_info_get_password(info));
+}
+
+static void
+purple_http_service_request_queued_cb(G_GNUC_UNUSED SoupSession *session,
+                                      SoupMessage *msg,
+                                      G_GNUC_UNUSED gpointer data)
+{
+	SoupMessageHeaders *headers = soup_message_get_request_headers(msg);
+
+	/* Accounts share the session, so nothing fetched with credentials may be
+	 * handed to another one from the cache. */
+	if(soup_message_headers_get_one(headers, "Authorization") != NULL) {
+		soup_message_disable_feature(msg, SOUP_TYPE_CACHE);
+	}
+}
+
+static SoupSession *
+purple_http_service_lookup_session(PurpleHttpService *service,
+                                   PurpleAccount *account, GError **error)
+{
+	GProxyResolver *resolver = NULL;
+	SoupCache *cache = NULL;
+	SoupSession *session = NULL;
+	gchar *checksum = NULL;
+	gchar *dir = NULL;
+	gchar *key = NULL;
+
+	key = purple_http_service_session_key(account);
+	session = g_hash_table_lookup(service->sessions, key);
+	if(session != NULL) {
+		g_free(key);
+
+		return session;
+	}
+
+	resolver = purple_proxy_get_proxy_resolver(account, error);
+	if(resolver == NULL) {
+		g_free(key);
+
+		return NULL;
+	}
+
+	session = soup_session_new_with_options(
+	        "proxy-resolver", resolver,
+	        "max-conns", PURPLE_HTTP_SERVICE_MAX_CONNS,
+	        "max-conns-per-host", PURPLE_HTTP_SERVICE_MAX_CONNS_PER_HOST,
+	        NULL);
+	g_object_unref(resolver);
+	g_signal_connect(session, "request-queued",
+	                 G_CALLBACK(purple_http_service_request_queued_cb), NULL);
+
+	/* The key has the proxy credentials in it, so it doesn't go on disk. */
+	checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA256, key, -1);
+	dir = g_build_filename(purple_cache_dir(), "http", checksum, NULL);
+	g_free(checksum);
+
+	/* A shared cache keeps responses marked private out as well. */
+	cache = soup_cache_new(dir, SOUP_CACHE_SHARED);
+	soup_cache_set_max_size(cache, PURPLE_HTTP_SERVICE_CACHE_SIZE);
+	soup_cache_load(cache);
+	soup_session_add_feature(session, SOUP_SESSION_FEATURE(cache));
+	g_object_unref(cache);
+	g_free(dir);
+
+	g_hash_table_insert(service->sessions, key, session);
+
+	return session;
+}
+
+static void
+purple_http_service_save_caches(PurpleHttpService *service) {
+	GHashTableIter iter;
+	gpointer value = NULL;
+
+	g_hash_table_iter_init(&iter, service->sessions);
+	while(g_hash_table_iter_next(&iter, NULL, &value)) {
+		SoupSessionFeature *cache = NULL;
+
+		cache = soup_session_get_feature(value, SOUP_TYPE_CACHE);
+		if(cache != NULL) {
+			soup_cache_flush(SOUP_CACHE(cache));
+			soup_cache_dump(SOUP_CACHE(cache));
+		}
+	}
+}
+
+/******************************************************************************
+ * Fetches
+ *****************************************************************************/
+static void
+purple_http_service_fetch_free(PurpleHttpServiceFetch *fetch) {
+	g_free(fetch->key);
+	g_clear_object(&fetch->msg);
+	g_clear_object(&fetch->cancellable);
+	g_ptr_array_free(fetch->tasks, TRUE);
+
+	g_free(fetch);
+}
+
+static void
+purple_http_service_fetch_forget(PurpleHttpServiceFetch *fetch) {
+	GHashTable *fetches = fetch->service->fetches;
+
+	if(g_hash_table_lookup(fetches, fetch->key) == fetch) {
+		g_hash_table_remove(fetches, fetch->key);
+	}
+}
+
+static void
+purple_http_service_fetch_cancelled_cb(G_GNUC_UNUSED GCancellable *cancellable,
+                                       gpointer data)
+{
+	PurpleHttpServiceFetch *fetch = data;
+
+	/* The request goes on while anyone still wants the body. */
+	for(guint i = 0; i < fetch->tasks->len; i++) {
+		GTask *task = g_ptr_array_index(fetch->tasks, i);
+
+		if(!g_cancellable_is_cancelled(g_task_get_cancellable(task))) {
+			return;
+		}
+	}
+
+	/* Nobody is waiting anymore, so whoever asks for the URI next needs a
+	 * request of its own rather than joining this one.
+	 */
+	purple_http_service_fetch_forget(fetch);
+
+	g_cancellable_cancel(fetch->cancellable);
+}
+
+static void
+purple_http_service_fetch_cb(GObject *source, GAsyncResult *result,
+                             gpointer data)
+{
+	PurpleHttpServiceFetch *fetch = data;
+	GBytes *bytes = NULL;
+	GError *error = NULL;
+
+	bytes = soup_session_send_and_read_finish(SOUP_SESSION(source), result,
+	                                          &error);
+	if(bytes != NULL) {
+		SoupStatus status = soup_message_get_status(fetch->msg);
+
+		if(!SOUP_STATUS_IS_SUCCESSFUL(status)) {
+			g_set_error_literal(&error, PURPLE_HTTP_SERVICE_DOMAIN, status,
+			                    soup_message_get_reason_phrase(fetch->msg));
+			g_clear_pointer(&bytes, g_bytes_unref);
+		}
+	}
+
+	/* Anyone asking for the URI from now on gets a new request. */
+	purple_http_service_fetch_forget(fetch);
+
+	for(guint i = 0; i < fetch->tasks->len; i++) {
+		GTask *task = g_ptr_array_index(fetch->tasks, i);
+		GCancellable *cancellable = g_task_get_cancellable(task);
+		gulong id = GPOINTER_TO_SIZE(g_object_get_data(G_OBJECT(task),
+		                                               "cancelled-id"));
+
+		if(id != 0) {
+			g_cancellable_disconnect(cancellable, id);
+		}
+
+		if(error != NULL) {
+			g_task_return_error(task, g_error_copy(error));
+		} else {
+			g_task_return_pointer(task, g_bytes_ref(bytes),
+			                      (GDestroyNotify)g_bytes_unref);
+		}
+	}
+
+	g_clear_pointer(&bytes, g_bytes_unref);
+	g_clear_error(&error);
+
+	purple_http_service_fetch_free(fetch);
+}
+
+/******************************************************************************
+ * GObject Implementation
+ *****************************************************************************/
+G_DEFINE_TYPE(PurpleHttpService, purple_http_service, G_TYPE_OBJECT)
+
+static void
+purple_http_service_dispose(GObject *obj) {
+	PurpleHttpService *service = PURPLE_HTTP_SERVICE(obj);
+
+	if(service->sessions != NULL) {
+		GHashTableIter iter;
+		gpointer value = NULL;
+
+		purple_http_service_save_caches(service);
+
+		g_hash_table_iter_init(&iter, service->sessions);
+		while(g_hash_table_iter_next(&iter, NULL, &value)) {
+			soup_session_abort(value);
+		}
+	}
+
+	g_clear_pointer(&service->sessions, g_hash_table_destroy);
+
+	G_OBJECT_CLASS(purple_http_service_parent_class)->dispose(obj);
+}
+
+static void
+purple_http_service_finalize(GObject *obj) {
+	PurpleHttpService *service = PURPLE_HTTP_SERVICE(obj);
+
+	g_clear_pointer(&service->fetches, g_hash_table_destroy);
+
+	G_OBJECT_CLASS(purple_http_service_parent_class)->finalize(obj);
+}
+
+static void
+purple_http_service_init(PurpleHttpService *service) {
+	service->sessions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+	                                          g_object_unref);
+	service->fetches = g_hash_table_new(g_str_hash, g_str_equal);
+}
+
+static void
+purple_http_service_class_init(PurpleHttpServiceClass *klass) {
+	GObjectClass *obj_class = G_OBJECT_CLASS(klass);
+
+	obj_class->dispose = purple_http_service_dispose;
+	obj_class->finalize = purple_http_service_finalize;
+}
+
+/******************************************************************************
+ * Private API
+ *****************************************************************************/
+void
+purple_http_service_startup(void) {
+	if(default_service == NULL) {
+		default_service = g_object_new(PURPLE_TYPE_HTTP_SERVICE, NULL);
+		g_object_add_weak_pointer(G_OBJECT(default_service),
+		                          (gpointer *)&default_service);
+	}
+}
+
+void
+purple_http_service_shutdown(void) {
+	GHashTableIter iter;
+	gpointer value = NULL;
+
+	if(default_service == NULL) {
+		return;
+	}
+
+	/* The fetches hold the service until their callbacks have run. */
+	g_hash_table_iter_init(&iter, default_service->fetches);
+	while(g_hash_table_iter_next(&iter, NULL, &value)) {
+		PurpleHttpServiceFetch *fetch = value;
+
+		g_cancellable_cancel(fetch->cancellable);
+	}
+
+	purple_http_service_save_caches(default_service);
+
+	g_clear_object(&default_service);
+}
+
+/******************************************************************************
+ * Public API
+ *****************************************************************************/
+PurpleHttpService *
+purple_http_service_get_default(void) {
+	return default_service;
+}
+
+SoupSession *
+purple_http_service_get_session(PurpleHttpService *service,
+                                PurpleAccount *account, GError **error)
+{
+	SoupSession *session = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_HTTP_SERVICE(service), NULL);
+
+	session = purple_http_service_lookup_session(service, account, error);
+	if(session == NULL) {
+		return NULL;
+	}
+
+	return g_object_ref(session);
+}
+
+void
+purple_http_service_fetch_async(PurpleHttpService *service,
+                                PurpleAccount *account, const gchar *uri,
+                                GCancellable *cancellable,
+                                GAsyncReadyCallback callback, gpointer data)
+{
+	PurpleHttpServiceFetch *fetch = NULL;
+	SoupSession *session = NULL;
+	GError *error = NULL;
+	GTask *task = NULL;
+	gchar *key = NULL;
+
+	g_return_if_fail(PURPLE_IS_HTTP_SERVICE(service));
+	g_return_if_fail(uri != NULL);
+
+	session = purple_http_service_lookup_session(service, account, &error);
+	if(session == NULL) {
+		g_task_report_error(service, callback, data,
+		                    purple_http_service_fetch_async, error);
+
+		return;
+	}
+
+	task = g_task_new(service, cancellable, callback, data);
+	g_task_set_source_tag(task, purple_http_service_fetch_async);
+
+	key = g_strdup_printf("%p %s", (gpointer)session, uri);
+	fetch = g_hash_table_lookup(service->fetches, key);
+	if(fetch != NULL) {
+		purple_debug_misc("http-service", "joining the fetch of %s", uri);
+		g_free(key);
+	} else {
+		SoupMessage *msg = soup_message_new("GET", uri);
+
+		if(msg == NULL) {
+			g_task_return_new_error(task, G_IO_ERROR,
+			                        G_IO_ERROR_INVALID_ARGUMENT,
+			                        _("Invalid URI: %s"), uri);
+			g_object_unref(task);
+			g_free(key);
+
+			return;
+		}
+
+		fetch = g_new0(PurpleHttpServiceFetch, 1);
+		fetch->service = service;
+		fetch->key = key;
+		fetch->msg = msg;
+		fetch->cancellable = g_cancellable_new();
+		fetch->tasks = g_ptr_array_new_with_free_func(g_object_unref);
+
+		g_hash_table_insert(service->fetches, fetch->key, fetch);
+
+		soup_session_send_and_read_async(session, msg, G_PRIORITY_DEFAULT,
+		                                  fetch->cancellable,
+		                                  purple_http_service_fetch_cb, fetch);
+	}
+
+	g_ptr_array_add(fetch->tasks, task);
+
+	if(cancellable != NULL) {
+		gulong id = g_cancellable_connect(cancellable,
+		                                  G_CALLBACK(purple_http_service_fetch_cancelled_cb),
+		                                  fetch, NULL);
+
+		g_object_set_data(G_OBJECT(task), "cancelled-id",
+		                  GSIZE_TO_POINTER(id));
+	}
+}
+
+GBytes *
+purple_http_service_fetch_finish(PurpleHttpService *service,
+                                 GAsyncResult *result, GError **error)
+{
+	g_return_val_if_fail(PURPLE_IS_HTTP_SERVICE(service), NULL);
+	g_return_val_if_fail(g_task_is_valid(result, service), NULL);
+
+	return g_task_propagate_pointer(G_TASK(result), error);
+}
@@ -0,0 +1,136 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(PURPLE_GLOBAL_HEADER_INSIDE) && !defined(PURPLE_COMPILATION)
+# error "only <purple.h> may be included directly"
+#endif
+
+#ifndef PURPLE_HTTP_SERVICE_H
+#define PURPLE_HTTP_SERVICE_H
+
+#include <glib.h>
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include <libsoup/soup.h>
+
+#include "account.h"
+
+G_BEGIN_DECLS
+
+/**
+ * PURPLE_HTTP_SERVICE_DOMAIN:
+ *
+ * A #GError domain for errors from #PurpleHttpService.  The error codes are
+ * the HTTP status codes of the responses.
+ *
+ * Since: 3.0.0
+ */
+#define PURPLE_HTTP_SERVICE_DOMAIN (g_quark_from_static_string("purple-http-service"))
+
+#define PURPLE_TYPE_HTTP_SERVICE (purple_http_service_get_type())
+
+/**
+ * PurpleHttpService:
+ *
+ * #PurpleHttpService hands out the [class@Soup.Session]s that protocols and
+ * plugins make HTTP requests with.  There is one session per proxy
+ * configuration, so accounts that connect the same way share connections,
+ * and every session keeps an on-disk cache that revalidates responses with
+ * their `ETag` and `Last-Modified` headers.  Since the cache is shared too,
+ * responses marked private and requests with an `Authorization` header never
+ * go through it.
+ *
+ * Since: 3.0.0
+ */
+G_DECLARE_FINAL_TYPE(PurpleHttpService, purple_http_service, PURPLE,
+                     HTTP_SERVICE, GObject)
+
+/**
+ * purple_http_service_get_default:
+ *
+ * Gets the default #PurpleHttpService instance.
+ *
+ * Returns: (transfer none): The default #PurpleHttpService instance.
+ *
+ * Since: 3.0.0
+ */
+PurpleHttpService *purple_http_service_get_default(void);
+
+/**
+ * purple_http_service_get_session:
+ * @service: The instance.
+ * @account: (nullable): The account the requests are made for, or %NULL to
+ *           use the global proxy settings.
+ * @error: Return address for a #GError, or %NULL.
+ *
+ * Gets the session to make requests for @account with.  It is shared with
+ * every other account that uses the same proxy, so callers must not change
+ * its properties, add features to it, or abort it; pending requests should
+ * be cancelled with a [class@Gio.Cancellable] instead.  Headers like
+ * `User-Agent` should be set on the messages themselves.
+ *
+ * Returns: (transfer full): The session, or %NULL if the proxy settings of
+ *          @account are invalid.
+ *
+ * Since: 3.0.0
+ */
+SoupSession *purple_http_service_get_session(PurpleHttpService *service, PurpleAccount *account, GError **error);
+
+/**
+ * purple_http_service_fetch_async:
+ * @service: The instance.
+ * @account: (nullable): The account the request is made for, or %NULL to
+ *           use the global proxy settings.
+ * @uri: The URI to get.
+ * @cancellable: (nullable): A #GCancellable.
+ * @callback: (scope async): The callback to call when the body has been
+ *            read.
+ * @data: User data to pass to @callback.
+ *
+ * Gets the body of @uri.  If the same URI is already being fetched through
+ * the same session, no new request is made and @callback gets the body of
+ * the one that is already in flight.
+ *
+ * If @cancellable is cancelled, @callback gets %G_IO_ERROR_CANCELLED, but the
+ * request itself is only cancelled once everyone waiting for it has
+ * cancelled.
+ *
+ * Since: 3.0.0
+ */
+void purple_http_service_fetch_async(PurpleHttpService *service, PurpleAccount *account, const gchar *uri, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer data);
+
+/**
+ * purple_http_service_fetch_finish:
+ * @service: The instance.
+ * @result: The #GAsyncResult passed to the callback.
+ * @error: Return address for a #GError, or %NULL.
+ *
+ * Finishes a call to [method@Purple.HttpService.fetch_async].  Responses
+ * with an unsuccessful status are reported as an error in
+ * %PURPLE_HTTP_SERVICE_DOMAIN.
+ *
+ * Returns: (transfer full): The body of the response or %NULL on error.
+ *
+ * Since: 3.0.0
+ */
+GBytes *purple_http_service_fetch_finish(PurpleHttpService *service, GAsyncResult *result, GError **error);
+
+G_END_DECLS
+
+#endif /* PURPLE_HTTP_SERVICE_H */
@@ -24,34 +24,161 @@
 
 #include "util.h"
 
+/******************************************************************************
+ * Scanning
+ *****************************************************************************/
+
+/* Classes of bytes the parsers below need to stop at. Everything else is
+ * copied through in runs. The NUL terminator is in every class so a scan can
+ * never run off the end of the string.
+ */
+#define PURPLE_MARKUP_CLASS_SPECIAL (1 << 0) /* starts a tag or an entity */
+#define PURPLE_MARKUP_CLASS_LINK    (1 << 1) /* may start a link or a tag */
+
+#define BOTH_CASES(c, v) [c] = (v), [(c) - 'a' + 'A'] = (v)
+
+static const guint8 markup_classes[256] = {
+	['\0'] = PURPLE_MARKUP_CLASS_SPECIAL | PURPLE_MARKUP_CLASS_LINK,
+	['&'] = PURPLE_MARKUP_CLASS_SPECIAL,
+	['<'] = PURPLE_MARKUP_CLASS_SPECIAL | PURPLE_MARKUP_CLASS_LINK,
+	['('] = PURPLE_MARKUP_CLASS_LINK,
+	[')'] = PURPLE_MARKUP_CLASS_LINK,
+	['@'] = PURPLE_MARKUP_CLASS_LINK,
+	/* http://, https://, ftp://, ftp., file://, sftp://, www., xmpp:,
+	 * mailto:
+	 */
+	BOTH_CASES('f', PURPLE_MARKUP_CLASS_LINK),
+	BOTH_CASES('h', PURPLE_MARKUP_CLASS_LINK),
+	BOTH_CASES('m', PURPLE_MARKUP_CLASS_LINK),
+	BOTH_CASES('s', PURPLE_MARKUP_CLASS_LINK),
+	BOTH_CASES('w', PURPLE_MARKUP_CLASS_LINK),
+	BOTH_CASES('x', PURPLE_MARKUP_CLASS_LINK),
+};
+
+#undef BOTH_CASES
+
+/* Returns the number of bytes at the start of text that are not in any of the
+ * classes in mask. This checks four bytes per iteration, which lets the
+ * compiler keep the table lookups in flight together.
+ */
+static inline gsize
+purple_markup_scan(const char *text, guint8 mask) {
+	const guchar *p = (const guchar *)text;
+
+	while(TRUE) {
+		if(markup_classes[p[0]] & mask) {
+			return (const char *)p - text;
+		}
+		if(markup_classes[p[1]] & mask) {
+			return (const char *)p - text + 1;
+		}
+		if(markup_classes[p[2]] & mask) {
+			return (const char *)p - text + 2;
+		}
+		if(markup_classes[p[3]] & mask) {
+			return (const char *)p - text + 3;
+		}
+
+		p += 4;
+	}
+}
+
+/* The tags purple_markup_html_to_xhtml() translates. Anything else is
+ * escaped, so we can reject it without walking the whole list of probes.
+ */
+static const char *const markup_known_tags[] = {
+	"a", "b", "blockquote", "body", "bold", "br", "cite", "div", "em",
+	"font", "h1", "h2", "h3", "h4", "h5", "h6", "hr", "html", "i", "img",
+	"italic", "li", "ol", "p", "pre", "q", "s", "span", "strike", "strong",
+	"sub", "sup", "u", "ul", "underline",
+};
+
+#define PURPLE_MARKUP_MAX_TAG_NAME (10) /* strlen("blockquote") */
+
+static gboolean
+purple_markup_is_known_tag(const char *name) {
+	char lower[PURPLE_MARKUP_MAX_TAG_NAME + 1];
+	gsize len = 0;
+
+	while(g_ascii_isalnum(name[len])) {
+		if(len == PURPLE_MARKUP_MAX_TAG_NAME) {
+			return FALSE;
+		}
+
+		lower[len] = g_ascii_tolower(name[len]);
+		len++;
+	}
+
+	if(len == 0) {
+		return FALSE;
+	}
+
+	lower[len] = '\0';
+
+	for(gsize i = 0; i < G_N_ELEMENTS(markup_known_tags); i++) {
+		if(markup_known_tags[i][0] == lower[0] &&
+		   purple_strequal(markup_known_tags[i], lower))
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+typedef struct {
+	const char *name;
+	int length;
+	const char *text;
+} PurpleMarkupEntity;
+
+#define ENTITY(name, text) { name, sizeof(name) - 1, text }
+
+static const PurpleMarkupEntity markup_entities[] = {
+	ENTITY("&amp;", "&"),
+	ENTITY("&apos;", "\'"),
+	ENTITY("&copy;", "\302\251"), /* or use g_unichar_to_utf8(0xa9); */
+	ENTITY("&gt;", ">"),
+	ENTITY("&lt;", "<"),
+	ENTITY("&nbsp;", " "),
+	ENTITY("&quot;", "\""),
+	ENTITY("&reg;", "\302\256"), /* or use g_unichar_to_utf8(0xae); */
+};
+
+#undef ENTITY
+
+/******************************************************************************
+ * Public API
+ *****************************************************************************/
 const char *
 purple_markup_unescape_entity(const char *text, int *length)
 {
-	const char *pln;
-	int len;
+	const char *pln = NULL;
+	int len = 0;
+	char first;
 
 	if (!text || *text != '&')
 		return NULL;
 
-#define IS_ENTITY(s)  (!g_ascii_strncasecmp(text, s, (len = sizeof(s) - 1)))
-
-	if(IS_ENTITY("&amp;"))
-		pln = "&";
-	else if(IS_ENTITY("&lt;"))
-		pln = "<";
-	else if(IS_ENTITY("&gt;"))
-		pln = ">";
-	else if(IS_ENTITY("&nbsp;"))
-		pln = " ";
-	else if(IS_ENTITY("&copy;"))
-		pln = "\302\251";      /* or use g_unichar_to_utf8(0xa9); */
-	else if(IS_ENTITY("&quot;"))
-		pln = "\"";
-	else if(IS_ENTITY("&reg;"))
-		pln = "\302\256";      /* or use g_unichar_to_utf8(0xae); */
-	else if(IS_ENTITY("&apos;"))
-		pln = "\'";
-	else if(text[1] == '#' && (g_ascii_isxdigit(text[2]) || text[2] == 'x')) {
+	/* None of the named entities share a first letter with an unrelated
+	 * one, so this rejects almost everything after a single compare.
+	 */
+	first = g_ascii_tolower(text[1]);
+	for(gsize i = 0; i < G_N_ELEMENTS(markup_entities); i++) {
+		const PurpleMarkupEntity *entity = &markup_entities[i];
+
+		if(entity->name[1] == first &&
+		   !g_ascii_strncasecmp(text, entity->name, entity->length))
+		{
+			pln = entity->text;
+			len = entity->length;
+			break;
+		}
+	}
+
+	if(pln == NULL && text[1] == '#' &&
+	   (g_ascii_isxdigit(text[2]) || text[2] == 'x'))
+	{
 		static char buf[7];
 		const char *start = text + 2;
 		char *end;
@@ -75,8 +202,10 @@ purple_markup_unescape_entity(const char *text, int *length)
 		buf[buflen] = '\0';
 		pln = buf;
 	}
-	else
+
+	if(pln == NULL) {
 		return NULL;
+	}
 
 	if (length)
 		*length = len;
@@ -252,6 +381,14 @@ purple_markup_html_to_xhtml(const char *html, char **xhtml_out,
 						c++;
 					}
 				}
+			} else if(c[1] != '!' && !purple_markup_is_known_tag(c + 1)) {
+				/* not a tag we translate, so none of the probes below
+				 * can match it */
+				if(xhtml)
+					xhtml = g_string_append(xhtml, "&lt;");
+				if(plain)
+					plain = g_string_append_c(plain, '<');
+				c++;
 			} else { /* opening tag */
 				ALLOW_TAG("blockquote");
 				ALLOW_TAG("cite");
@@ -581,30 +718,32 @@ purple_markup_html_to_xhtml(const char *html, char **xhtml_out,
 				c++;
 			}
 		} else if(*c == '&') {
-			char buf[7];
 			const char *pln;
 			int len;
 
 			if ((pln = purple_markup_unescape_entity(c, &len)) == NULL) {
 				len = 1;
-				g_snprintf(buf, sizeof(buf), "%c", *c);
-				pln = buf;
+				if(plain)
+					plain = g_string_append_c(plain, *c);
+			} else if(plain) {
+				plain = g_string_append(plain, pln);
 			}
 			if(xhtml)
 				xhtml = g_string_append_len(xhtml, c, len);
-			if(plain)
-				plain = g_string_append(plain, pln);
 			if(cdata)
 				cdata = g_string_append_len(cdata, c, len);
 			c += len;
 		} else {
+			/* copy everything up to the next tag or entity at once */
+			gsize len = purple_markup_scan(c, PURPLE_MARKUP_CLASS_SPECIAL);
+
 			if(xhtml)
-				xhtml = g_string_append_c(xhtml, *c);
+				xhtml = g_string_append_len(xhtml, c, len);
 			if(plain)
-				plain = g_string_append_c(plain, *c);
+				plain = g_string_append_len(plain, c, len);
 			if(cdata)
-				cdata = g_string_append_c(cdata, *c);
-			c++;
+				cdata = g_string_append_len(cdata, c, len);
+			c += len;
 		}
 	}
 	if(xhtml) {
@@ -835,6 +974,10 @@ badchar(char c)
 static gboolean
 badentity(const char *c)
 {
+	if (*c != '&') {
+		return FALSE;
+	}
+
 	if (!g_ascii_strncasecmp(c, "&lt;", 4) ||
 		!g_ascii_strncasecmp(c, "&gt;", 4) ||
 		!g_ascii_strncasecmp(c, "&quot;", 6)) {
@@ -899,6 +1042,17 @@ purple_markup_linkify(const char *text)
 
 	c = text;
 	while (*c) {
+		if(!inside_html) {
+			/* Nothing can happen until a character that might start a
+			 * link or a tag, so copy the text before it in one go. */
+			gsize len = purple_markup_scan(c, PURPLE_MARKUP_CLASS_LINK);
+
+			if(len > 0) {
+				ret = g_string_append_len(ret, c, len);
+				c += len;
+				continue;
+			}
+		}
 
 		if(*c == '(' && !inside_html) {
 			inside_paren++;
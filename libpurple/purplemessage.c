@@ -31,6 +31,10 @@ struct _PurpleMessage {
 	GObject parent;
 
 	gchar *id;
+
+	/* These are interned GRefStrings as they are almost always the same for
+	 * every message in a conversation.
+	 */
 	gchar *author;
 	gchar *author_name_color;
 	gchar *author_alias;
@@ -44,6 +48,7 @@ struct _PurpleMessage {
 
 	GError *error;
 
+	/* Created on demand as very few messages have attachments. */
 	GHashTable *attachments;
 };
 
@@ -68,18 +73,37 @@ G_DEFINE_TYPE(PurpleMessage, purple_message, G_TYPE_OBJECT)
 /******************************************************************************
  * Helpers
  *****************************************************************************/
+static inline gchar *
+purple_message_intern(const gchar *str) {
+	if(str == NULL) {
+		return NULL;
+	}
+
+	return g_ref_string_new_intern(str);
+}
+
+static inline void
+purple_message_release(gchar *str) {
+	if(str != NULL) {
+		g_ref_string_release(str);
+	}
+}
+
+/* Swaps the interned string in member for str. The new string is acquired
+ * before the old one is released in case they are the same.
+ */
 static void
-purple_message_set_id(PurpleMessage *message, const gchar *id) {
-	g_free(message->id);
-	message->id = g_strdup(id);
+purple_message_set_interned(gchar **member, const gchar *str) {
+	gchar *old = *member;
 
-	g_object_notify_by_pspec(G_OBJECT(message), properties[PROP_ID]);
+	*member = purple_message_intern(str);
+
+	purple_message_release(old);
 }
 
 static void
 purple_message_set_author(PurpleMessage *message, const gchar *author) {
-	g_free(message->author);
-	message->author = g_strdup(author);
+	purple_message_set_interned(&message->author, author);
 
 	g_object_notify_by_pspec(G_OBJECT(message), properties[PROP_AUTHOR]);
 }
@@ -180,10 +204,10 @@ purple_message_finalize(GObject *obj) {
 	PurpleMessage *message = PURPLE_MESSAGE(obj);
 
 	g_free(message->id);
-	g_free(message->author);
-	g_free(message->author_name_color);
-	g_free(message->author_alias);
-	g_free(message->recipient);
+	purple_message_release(message->author);
+	purple_message_release(message->author_name_color);
+	purple_message_release(message->author_alias);
+	purple_message_release(message->recipient);
 	g_free(message->contents);
 
 	g_clear_error(&message->error);
@@ -192,15 +216,13 @@ purple_message_finalize(GObject *obj) {
 		g_date_time_unref(message->timestamp);
 	}
 
-	g_hash_table_destroy(message->attachments);
+	g_clear_pointer(&message->attachments, g_hash_table_destroy);
 
 	G_OBJECT_CLASS(purple_message_parent_class)->finalize(obj);
 }
 
 static void
-purple_message_init(PurpleMessage *message) {
-	message->attachments = g_hash_table_new_full(g_int64_hash, g_int64_equal,
-	                                             NULL, g_object_unref);
+purple_message_init(G_GNUC_UNUSED PurpleMessage *message) {
 }
 
 static void
@@ -222,7 +244,7 @@ purple_message_class_init(PurpleMessageClass *klass) {
 		"id", "ID",
 		"The session-unique message id",
 		NULL,
-		G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+		G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
 
 	/**
 	 * PurpleMessage::author:
@@ -432,6 +454,82 @@ purple_message_new_system(G_GNUC_UNUSED PurpleAccount *account,
 	return message;
 }
 
+/* Interns str, reusing the previous entry's string when it is the same so
+ * that runs of messages from one author skip the global intern table.
+ */
+static gchar *
+purple_message_intern_run(const gchar *str, gchar **previous) {
+	if(str == NULL) {
+		return NULL;
+	}
+
+	if(*previous == NULL || !g_str_equal(*previous, str)) {
+		*previous = g_ref_string_new_intern(str);
+
+		return *previous;
+	}
+
+	return g_ref_string_acquire(*previous);
+}
+
+GPtrArray *
+purple_message_new_batch(const PurpleMessageEntry *entries, gsize n_entries) {
+	GPtrArray *messages = NULL;
+	GDateTime *now = NULL;
+	gchar *author = NULL, *alias = NULL, *recipient = NULL;
+
+	g_return_val_if_fail(entries != NULL || n_entries == 0, NULL);
+
+	messages = g_ptr_array_new_full(n_entries, g_object_unref);
+
+	for(gsize i = 0; i < n_entries; i++) {
+		const PurpleMessageEntry *entry = &entries[i];
+		PurpleMessage *message = NULL;
+
+		/* Fill in the instance directly. Nobody can be listening for
+		 * property notifications yet, so going through the property setters
+		 * would only cost us GValue boxing and notify queues.
+		 */
+		message = g_object_new(PURPLE_TYPE_MESSAGE, NULL);
+
+		message->id = g_strdup(entry->id);
+		message->author = purple_message_intern_run(entry->author, &author);
+		message->author_alias = purple_message_intern_run(entry->author_alias,
+		                                                  &alias);
+		message->recipient = purple_message_intern_run(entry->recipient,
+		                                               &recipient);
+		message->contents = g_strdup(entry->contents);
+		message->content_type = entry->content_type;
+		message->flags = entry->flags;
+
+		if(entry->timestamp != NULL) {
+			message->timestamp = g_date_time_ref(entry->timestamp);
+		} else {
+			if(now == NULL) {
+				now = g_date_time_new_now_local();
+			}
+
+			message->timestamp = g_date_time_ref(now);
+		}
+
+		g_ptr_array_add(messages, message);
+	}
+
+	g_clear_pointer(&now, g_date_time_unref);
+
+	return messages;
+}
+
+void
+purple_message_set_id(PurpleMessage *message, const gchar *id) {
+	g_return_if_fail(PURPLE_IS_MESSAGE(message));
+
+	g_free(message->id);
+	message->id = g_strdup(id);
+
+	g_object_notify_by_pspec(G_OBJECT(message), properties[PROP_ID]);
+}
+
 const gchar *
 purple_message_get_id(PurpleMessage *message) {
 	g_return_val_if_fail(PURPLE_IS_MESSAGE(message), 0);
@@ -452,8 +550,7 @@ purple_message_set_author_name_color(PurpleMessage *message,
 {
 	g_return_if_fail(PURPLE_IS_MESSAGE(message));
 
-	g_free(message->author_name_color);
-	message->author_name_color = g_strdup(color);
+	purple_message_set_interned(&message->author_name_color, color);
 
 	g_object_notify_by_pspec(G_OBJECT(message),
 	                         properties[PROP_AUTHOR_NAME_COLOR]);
@@ -470,8 +567,7 @@ void
 purple_message_set_recipient(PurpleMessage *message, const gchar *recipient) {
 	g_return_if_fail(PURPLE_IS_MESSAGE(message));
 
-	g_free(message->recipient);
-	message->recipient = g_strdup(recipient);
+	purple_message_set_interned(&message->recipient, recipient);
 
 	g_object_notify_by_pspec(G_OBJECT(message), properties[PROP_RECIPIENT]);
 }
@@ -489,8 +585,7 @@ purple_message_set_author_alias(PurpleMessage *message,
 {
 	g_return_if_fail(PURPLE_IS_MESSAGE(message));
 
-	g_free(message->author_alias);
-	message->author_alias = g_strdup(author_alias);
+	purple_message_set_interned(&message->author_alias, author_alias);
 
 	g_object_notify_by_pspec(G_OBJECT(message), properties[PROP_AUTHOR_ALIAS]);
 }
@@ -625,6 +720,12 @@ purple_message_add_attachment(PurpleMessage *message,
 	g_return_val_if_fail(PURPLE_IS_MESSAGE(message), FALSE);
 	g_return_val_if_fail(PURPLE_IS_ATTACHMENT(attachment), FALSE);
 
+	if(message->attachments == NULL) {
+		message->attachments = g_hash_table_new_full(g_int64_hash,
+		                                             g_int64_equal, NULL,
+		                                             g_object_unref);
+	}
+
 	return g_hash_table_insert(message->attachments,
 	                           purple_attachment_get_hash_key(attachment),
 	                           g_object_ref(G_OBJECT(attachment)));
@@ -634,6 +735,10 @@ gboolean
 purple_message_remove_attachment(PurpleMessage *message, guint64 id) {
 	g_return_val_if_fail(PURPLE_IS_MESSAGE(message), FALSE);
 
+	if(message->attachments == NULL) {
+		return FALSE;
+	}
+
 	return g_hash_table_remove(message->attachments, &id);
 }
 
@@ -643,6 +748,10 @@ purple_message_get_attachment(PurpleMessage *message, guint64 id) {
 
 	g_return_val_if_fail(PURPLE_IS_MESSAGE(message), NULL);
 
+	if(message->attachments == NULL) {
+		return NULL;
+	}
+
 	attachment = g_hash_table_lookup(message->attachments, &id);
 	if(PURPLE_IS_ATTACHMENT(attachment)) {
 		return PURPLE_ATTACHMENT(g_object_ref(G_OBJECT(attachment)));
@@ -662,6 +771,10 @@ purple_message_foreach_attachment(PurpleMessage *message,
 	g_return_if_fail(PURPLE_IS_MESSAGE(message));
 	g_return_if_fail(func != NULL);
 
+	if(message->attachments == NULL) {
+		return;
+	}
+
 	g_hash_table_iter_init(&iter, message->attachments);
 	while(g_hash_table_iter_next(&iter, NULL, &value)) {
 		func(PURPLE_ATTACHMENT(value), data);
@@ -672,5 +785,7 @@ void
 purple_message_clear_attachments(PurpleMessage *message) {
 	g_return_if_fail(PURPLE_IS_MESSAGE(message));
 
-	g_hash_table_remove_all(message->attachments);
+	if(message->attachments != NULL) {
+		g_hash_table_remove_all(message->attachments);
+	}
 }
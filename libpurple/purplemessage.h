@@ -110,6 +110,34 @@ G_DECLARE_FINAL_TYPE(PurpleMessage, purple_message, PURPLE, MESSAGE, GObject)
 
 #include "account.h"
 
+/**
+ * PurpleMessageEntry:
+ * @id: (nullable): The account specific identifier of the message.
+ * @author: (nullable): The author of the message.
+ * @author_alias: (nullable): The alias of the author.
+ * @recipient: (nullable): The recipient of the message.
+ * @contents: (nullable): The contents of the message.
+ * @content_type: The #PurpleMessageContentType of @contents.
+ * @timestamp: (nullable): The timestamp of the message. If %NULL the current
+ *             time is used.
+ * @flags: The #PurpleMessageFlags for the message.
+ *
+ * Describes a single message for purple_message_new_batch(). None of the
+ * members are taken over by the message.
+ *
+ * Since: 3.0.0
+ */
+typedef struct {
+	const gchar *id;
+	const gchar *author;
+	const gchar *author_alias;
+	const gchar *recipient;
+	const gchar *contents;
+	PurpleMessageContentType content_type;
+	GDateTime *timestamp;
+	PurpleMessageFlags flags;
+} PurpleMessageEntry;
+
 /**
  * purple_message_new_outgoing:
  * @account: The account for this message.
@@ -163,6 +191,36 @@ PurpleMessage *purple_message_new_incoming(PurpleAccount *account, const gchar *
  */
 PurpleMessage *purple_message_new_system(PurpleAccount *account, const gchar *contents, PurpleMessageFlags flags);
 
+/**
+ * purple_message_new_batch: (skip)
+ * @entries: (array length=n_entries): The messages to create.
+ * @n_entries: The number of items in @entries.
+ *
+ * Creates a #PurpleMessage for each item in @entries. This is meant for
+ * protocols that deliver a lot of messages at once, like when catching up on
+ * history, and is considerably cheaper than creating each message with
+ * g_object_new().
+ *
+ * Returns: (transfer full) (element-type PurpleMessage): The new messages in
+ *          the same order as @entries.
+ *
+ * Since: 3.0.0
+ */
+GPtrArray *purple_message_new_batch(const PurpleMessageEntry *entries, gsize n_entries);
+
+/**
+ * purple_message_set_id:
+ * @message: The message.
+ * @id: (nullable): The new id.
+ *
+ * Sets the id of @message.  Protocols use this for ids the server assigned,
+ * like an archive id, so the history can recognize the message when the
+ * server sends it again.
+ *
+ * Since: 3.0.0
+ */
+void purple_message_set_id(PurpleMessage *message, const gchar *id);
+
 /**
  * purple_message_get_id:
  * @message: The message.
@@ -28,6 +28,7 @@ struct _PurplePerson {
 	gchar *id;
 
 	gchar *alias;
+	gchar *alias_key;
 	GdkPixbuf *avatar;
 	PurpleTags *tags;
 
@@ -124,15 +125,15 @@ purple_person_sort_contacts(PurplePerson *person) {
 	}
 }
 
-/* This function is used by purple_person_matches to determine if a contact info
- * matches the needle.
+/* This function is used by purple_person_matches_search_key to determine if a
+ * contact info matches the key.
  */
 static gboolean
 purple_person_matches_find_func(gconstpointer a, gconstpointer b) {
 	PurpleContactInfo *info = (gpointer)a;
-	const char *needle = b;
+	const char *key = b;
 
-	return purple_contact_info_matches(info, needle);
+	return purple_contact_info_matches_search_key(info, key);
 }
 
 /******************************************************************************
@@ -267,6 +268,7 @@ purple_person_finalize(GObject *obj) {
 
 	g_clear_pointer(&person->id, g_free);
 	g_clear_pointer(&person->alias, g_free);
+	g_clear_pointer(&person->alias_key, g_free);
 
 	G_OBJECT_CLASS(purple_person_parent_class)->finalize(obj);
 }
@@ -438,6 +440,9 @@ purple_person_set_alias(PurplePerson *person, const gchar *alias) {
 		g_free(person->alias);
 		person->alias = g_strdup(alias);
 
+		g_free(person->alias_key);
+		person->alias_key = purple_str_search_key(alias);
+
 		g_object_freeze_notify(obj);
 		g_object_notify_by_pspec(obj, properties[PROP_ALIAS]);
 		g_object_notify_by_pspec(obj, properties[PROP_NAME_FOR_DISPLAY]);
@@ -585,21 +590,37 @@ purple_person_has_contacts(PurplePerson *person) {
 
 gboolean
 purple_person_matches(PurplePerson *person, const char *needle) {
+	char *key = NULL;
+	gboolean ret = FALSE;
+
 	g_return_val_if_fail(PURPLE_IS_PERSON(person), FALSE);
 
 	if(purple_strempty(needle)) {
 		return TRUE;
 	}
 
+	key = purple_str_search_key(needle);
+	ret = purple_person_matches_search_key(person, key);
+	g_free(key);
+
+	return ret;
+}
+
+gboolean
+purple_person_matches_search_key(PurplePerson *person, const char *key) {
+	g_return_val_if_fail(PURPLE_IS_PERSON(person), FALSE);
+
+	if(purple_strempty(key)) {
+		return TRUE;
+	}
+
 	/* Check if the person's alias matches. */
-	if(!purple_strempty(person->alias)) {
-		if(purple_strmatches(needle, person->alias)) {
-			return TRUE;
-		}
+	if(purple_strmatches_search_key(key, person->alias_key)) {
+		return TRUE;
 	}
 
 	/* See if any of the contact infos match. */
-	return g_ptr_array_find_with_equal_func(person->contacts, needle,
+	return g_ptr_array_find_with_equal_func(person->contacts, key,
 	                                        purple_person_matches_find_func,
 	                                        NULL);
 }
@@ -237,6 +237,23 @@ gboolean purple_person_has_contacts(PurplePerson *person);
  */
 gboolean purple_person_matches(PurplePerson *person, const char *needle);
 
+/**
+ * purple_person_matches_search_key:
+ * @person: The instance.
+ * @key: (nullable): The search key to match on.
+ *
+ * Like [method@Purple.Person.matches] but @key has already been passed
+ * through [func@Purple.str_search_key].  User interfaces filtering a long
+ * list of people should create the key once and use this.
+ *
+ * If @key is %NULL or empty string, %TRUE will be returned.
+ *
+ * Returns: %TRUE if @person matches @key in any way.
+ *
+ * Since: 3.0.0
+ */
+gboolean purple_person_matches_search_key(PurplePerson *person, const char *key);
+
 G_END_DECLS
 
 #endif /* PURPLE_PERSON_H */
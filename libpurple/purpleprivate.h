@@ -66,6 +66,55 @@ _purple_buddy_icons_account_loaded_cb(void);
 void
 _purple_buddy_icons_blist_loaded_cb(void);
 
+/**
+ * purple_buddy_update_online_count:
+ * @buddy: The buddy whose status changed.
+ * @old_status: (nullable): The status @buddy had before the change.
+ *
+ * Updates the online counts of the contact and group of @buddy if it went
+ * online or offline.  This is the part of purple_buddy_update_status() that
+ * can't wait for a batch, since adding, moving and removing buddies adjust
+ * the same counts from the current presence.
+ *
+ * Since: 3.0.0
+ */
+void purple_buddy_update_online_count(PurpleBuddy *buddy, PurpleStatus *old_status);
+
+/**
+ * purple_buddy_emit_status_changed:
+ * @buddy: The buddy whose status changed.
+ * @old_status: (nullable): The status @buddy had before the change.
+ *
+ * Emits the signals for a status change of @buddy and invalidates the
+ * priority buddy of its contact, without touching the online counts or
+ * updating the buddy list node.
+ *
+ * Since: 3.0.0
+ */
+void purple_buddy_emit_status_changed(PurpleBuddy *buddy, PurpleStatus *old_status);
+
+/**
+ * purple_buddy_presence_queue_update:
+ * @buddy: The buddy whose status changed.
+ * @old_status: (nullable): The status @buddy had before the change.
+ *
+ * Updates the online counts for @buddy right away and queues the rest of
+ * purple_buddy_update_status().  Queued updates are applied together by
+ * purple_buddy_presence_flush_updates().
+ *
+ * Since: 3.0.0
+ */
+void purple_buddy_presence_queue_update(PurpleBuddy *buddy, PurpleStatus *old_status);
+
+/**
+ * purple_buddy_presence_clear_updates:
+ *
+ * Drops all pending buddy status updates without applying them.
+ *
+ * Since: 3.0.0
+ */
+void purple_buddy_presence_clear_updates(void);
+
 /**
  * _purple_connection_wants_to_die:
  * @gc:  The connection to check
@@ -184,6 +233,25 @@ void purple_conversation_manager_startup(void);
  */
 void purple_conversation_manager_shutdown(void);
 
+/**
+ * purple_connection_scheduler_startup:
+ *
+ * Starts up the connection scheduler by creating the default instance.
+ *
+ * Since: 3.0.0
+ */
+void purple_connection_scheduler_startup(void);
+
+/**
+ * purple_connection_scheduler_shutdown:
+ *
+ * Shuts down the connection scheduler by dropping its queue and pending
+ * reconnects and destroying the default instance.
+ *
+ * Since: 3.0.0
+ */
+void purple_connection_scheduler_shutdown(void);
+
 /**
  * purple_credential_manager_startup:
  *
@@ -287,6 +355,64 @@ void purple_history_manager_startup(void);
  */
 void purple_history_manager_shutdown(void);
 
+/**
+ * purple_http_service_startup:
+ *
+ * Starts up the HTTP service by creating the default instance.
+ *
+ * Since: 3.0.0
+ */
+void purple_http_service_startup(void);
+
+/**
+ * purple_http_service_shutdown:
+ *
+ * Shuts down the HTTP service by cancelling its requests, saving its caches
+ * and destroying the default instance.
+ *
+ * Since: 3.0.0
+ */
+void purple_http_service_shutdown(void);
+
+/**
+ * purple_resolver_startup:
+ *
+ * Starts up the resolver by creating the default instance and installing it
+ * as the default [class@Gio.Resolver].
+ *
+ * Since: 3.0.0
+ */
+void purple_resolver_startup(void);
+
+/**
+ * purple_resolver_shutdown:
+ *
+ * Shuts down the resolver by putting the previous default [class@Gio.Resolver]
+ * back and destroying the default instance.
+ *
+ * Since: 3.0.0
+ */
+void purple_resolver_shutdown(void);
+
+/**
+ * purple_tls_session_cache_startup:
+ *
+ * Starts up the TLS session cache by creating the default instance.
+ *
+ * Since: 3.0.0
+ */
+void purple_tls_session_cache_startup(void);
+
+/**
+ * purple_tls_session_cache_shutdown:
+ *
+ * Shuts down the TLS session cache by forgetting its sessions and destroying
+ * the default instance.
+ *
+ * Since: 3.0.0
+ */
+void purple_tls_session_cache_shutdown(void);
+
 /**
  * purple_notification_manager_startup:
  *
@@ -53,6 +53,24 @@ purple_protocol_roomlist_get_list(PurpleProtocolRoomlist *protocol_roomlist,
 	return NULL;
 }
 
+PurpleRoomlist *
+purple_protocol_roomlist_query_list(PurpleProtocolRoomlist *protocol_roomlist,
+                                    PurpleConnection *gc,
+                                    const gchar *filter, guint min_users)
+{
+	PurpleProtocolRoomlistInterface *iface = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_PROTOCOL_ROOMLIST(protocol_roomlist), NULL);
+	g_return_val_if_fail(PURPLE_IS_CONNECTION(gc), NULL);
+
+	iface = PURPLE_PROTOCOL_ROOMLIST_GET_IFACE(protocol_roomlist);
+	if(iface != NULL && iface->query_list != NULL) {
+		return iface->query_list(protocol_roomlist, gc, filter, min_users);
+	}
+
+	return NULL;
+}
+
 void
 purple_protocol_roomlist_cancel(PurpleProtocolRoomlist *protocol_roomlist,
                                 PurpleRoomlist *list)
@@ -69,8 +69,10 @@ struct _PurpleProtocolRoomlistInterface {
 
 	gchar *(*room_serialize)(PurpleProtocolRoomlist *protocol_roomlist, PurpleRoomlistRoom *room);
 
+	PurpleRoomlist *(*query_list)(PurpleProtocolRoomlist *protocol_roomlist, PurpleConnection *gc, const gchar *filter, guint min_users);
+
 	/*< private >*/
-	gpointer reserved[4];
+	gpointer reserved[3];
 };
 
 /**
@@ -86,6 +88,27 @@ struct _PurpleProtocolRoomlistInterface {
  */
 PurpleRoomlist *purple_protocol_roomlist_get_list(PurpleProtocolRoomlist *protocol_roomlist, PurpleConnection *gc);
 
+/**
+ * purple_protocol_roomlist_query_list:
+ * @protocol_roomlist: The #PurpleProtocolRoomlist instance.
+ * @gc: The #PurpleConnection to get the roomlist for.
+ * @filter: (nullable): Only list rooms whose name matches this.
+ * @min_users: Only list rooms with at least this many users.
+ *
+ * Gets the list of rooms for @gc, asking the server to only send the rooms
+ * that match @filter and @min_users.
+ *
+ * Implementations should also set the query on the returned list with
+ * purple_roomlist_set_filter() and purple_roomlist_set_min_users(), adjusted
+ * to how room names look on the protocol, so that anything the server didn't
+ * filter out is dropped locally.
+ *
+ * Returns: (transfer full): The roomlist for @gc.
+ *
+ * Since: 3.0.0
+ */
+PurpleRoomlist *purple_protocol_roomlist_query_list(PurpleProtocolRoomlist *protocol_roomlist, PurpleConnection *gc, const gchar *filter, guint min_users);
+
 /**
  * purple_protocol_roomlist_cancel:
  * @protocol_roomlist: The #PurpleProtocolRoomlist instance.
@@ -0,0 +1,890 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "purpleresolver.h"
+
+#include "debug.h"
+#include "purpleprivate.h"
+
+/* GResolver doesn't tell us the TTLs of the records it looks up, so answers
+ * are kept for a fixed time that is shorter than most TTLs in practice.
+ * Names that don't exist are remembered for less time than that.
+ */
+#define PURPLE_RESOLVER_TTL (60)
+#define PURPLE_RESOLVER_NEGATIVE_TTL (10)
+#define PURPLE_RESOLVER_MAX_ENTRIES (512)
+
+enum {
+	PROP_0,
+	PROP_RESOLVER,
+	N_PROPERTIES,
+};
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+typedef enum {
+	PURPLE_RESOLVER_LOOKUP_NAME,
+	PURPLE_RESOLVER_LOOKUP_SERVICE,
+	PURPLE_RESOLVER_LOOKUP_RECORDS,
+} PurpleResolverLookupType;
+
+struct _PurpleResolver {
+	GResolver parent;
+
+	GResolver *resolver;
+
+	/* Lookups can happen in any thread, so the tables are locked. */
+	GMutex lock;
+
+	/* Key to PurpleResolverEntry. */
+	GHashTable *cache;
+
+	/* Key to the PurpleResolverLookup that is looking it up. */
+	GHashTable *lookups;
+};
+
+typedef struct {
+	PurpleResolverLookupType type;
+	GList *results;
+	GError *error;
+	gint64 expires;
+} PurpleResolverEntry;
+
+typedef struct {
+	PurpleResolver *resolver;
+	PurpleResolverLookupType type;
+	gchar *key;
+
+	/* The key in PurpleResolver.lookups, which is per main context. */
+	gchar *lookup_key;
+
+	GCancellable *cancellable;
+
+	/* The GTasks of everyone waiting for the answer. */
+	GPtrArray *tasks;
+} PurpleResolverLookup;
+
+static PurpleResolver *default_resolver = NULL;
+static GResolver *system_resolver = NULL;
+
+/******************************************************************************
+ * Results
+ *****************************************************************************/
+static void
+purple_resolver_free_records(GList *records) {
+	g_list_free_full(records, (GDestroyNotify)g_variant_unref);
+}
+
+static GDestroyNotify
+purple_resolver_get_free_func(PurpleResolverLookupType type) {
+	switch(type) {
+		case PURPLE_RESOLVER_LOOKUP_NAME:
+			return (GDestroyNotify)g_resolver_free_addresses;
+		case PURPLE_RESOLVER_LOOKUP_SERVICE:
+			return (GDestroyNotify)g_resolver_free_targets;
+		case PURPLE_RESOLVER_LOOKUP_RECORDS:
+		default:
+			return (GDestroyNotify)purple_resolver_free_records;
+	}
+}
+
+static GList *
+purple_resolver_copy_results(PurpleResolverLookupType type, GList *results) {
+	switch(type) {
+		case PURPLE_RESOLVER_LOOKUP_NAME:
+			return g_list_copy_deep(results, (GCopyFunc)(void *)g_object_ref,
+			                        NULL);
+		case PURPLE_RESOLVER_LOOKUP_SERVICE:
+			return g_list_copy_deep(results,
+			                        (GCopyFunc)(void *)g_srv_target_copy,
+			                        NULL);
+		case PURPLE_RESOLVER_LOOKUP_RECORDS:
+		default:
+			return g_list_copy_deep(results,
+			                        (GCopyFunc)(void *)g_variant_ref, NULL);
+	}
+}
+
+static gchar *
+purple_resolver_make_key(PurpleResolverLookupType type, const gchar *name,
+                         guint arg)
+{
+	gchar *lower = g_ascii_strdown(name, -1);
+	gchar *key = NULL;
+
+	key = g_strdup_printf("%d %u %s", type, arg, lower);
+	g_free(lower);
+
+	return key;
+}
+
+/******************************************************************************
+ * Cache
+ *****************************************************************************/
+static void
+purple_resolver_entry_free(PurpleResolverEntry *entry) {
+	if(entry->results != NULL) {
+		purple_resolver_get_free_func(entry->type)(entry->results);
+	}
+	g_clear_error(&entry->error);
+
+	g_free(entry);
+}
+
+static gboolean
+purple_resolver_entry_is_expired(G_GNUC_UNUSED gpointer key, gpointer value,
+                                 gpointer data)
+{
+	PurpleResolverEntry *entry = value;
+	gint64 *now = data;
+
+	return entry->expires <= *now;
+}
+
+static gboolean
+purple_resolver_cache_lookup_locked(PurpleResolver *resolver,
+                                    const gchar *key,
+                                    PurpleResolverLookupType type,
+                                    GList **results, GError **error)
+{
+	PurpleResolverEntry *entry = NULL;
+
+	entry = g_hash_table_lookup(resolver->cache, key);
+	if(entry == NULL) {
+		return FALSE;
+	}
+
+	if(entry->expires <= g_get_monotonic_time()) {
+		g_hash_table_remove(resolver->cache, key);
+
+		return FALSE;
+	}
+
+	if(entry->error != NULL) {
+		g_propagate_error(error, g_error_copy(entry->error));
+	} else {
+		*results = purple_resolver_copy_results(type, entry->results);
+	}
+
+	return TRUE;
+}
+
+static void
+purple_resolver_cache_store_locked(PurpleResolver *resolver, const gchar *key,
+                                   PurpleResolverLookupType type,
+                                   GList *results, const GError *error)
+{
+	PurpleResolverEntry *entry = NULL;
+	gint64 now = g_get_monotonic_time();
+	gint ttl = PURPLE_RESOLVER_TTL;
+
+	/* Temporary failures and cancellations say nothing about the name. */
+	if(error != NULL) {
+		if(!g_error_matches(error, G_RESOLVER_ERROR,
+		                    G_RESOLVER_ERROR_NOT_FOUND))
+		{
+			return;
+		}
+
+		ttl = PURPLE_RESOLVER_NEGATIVE_TTL;
+	}
+
+	if(g_hash_table_size(resolver->cache) >= PURPLE_RESOLVER_MAX_ENTRIES) {
+		g_hash_table_foreach_remove(resolver->cache,
+		                            purple_resolver_entry_is_expired, &now);
+
+		if(g_hash_table_size(resolver->cache) >= PURPLE_RESOLVER_MAX_ENTRIES) {
+			g_hash_table_remove_all(resolver->cache);
+		}
+	}
+
+	entry = g_new0(PurpleResolverEntry, 1);
+	entry->type = type;
+	entry->expires = now + ttl * G_USEC_PER_SEC;
+
+	if(error != NULL) {
+		entry->error = g_error_copy(error);
+	} else {
+		entry->results = purple_resolver_copy_results(type, results);
+	}
+
+	g_hash_table_replace(resolver->cache, g_strdup(key), entry);
+}
+
+/******************************************************************************
+ * Synchronous Lookups
+ *****************************************************************************/
+static GList *
+purple_resolver_lookup_sync(PurpleResolver *resolver,
+                            PurpleResolverLookupType type, const gchar *name,
+                            guint arg, GCancellable *cancellable,
+                            GError **error)
+{
+	GResolverClass *klass = G_RESOLVER_GET_CLASS(resolver->resolver);
+	GList *results = NULL;
+	GError *local_error = NULL;
+	gchar *key = NULL;
+	gboolean found = FALSE;
+
+	key = purple_resolver_make_key(type, name, arg);
+
+	g_mutex_lock(&resolver->lock);
+	found = purple_resolver_cache_lookup_locked(resolver, key, type, &results,
+	                                            &local_error);
+	g_mutex_unlock(&resolver->lock);
+
+	if(found) {
+		g_free(key);
+
+		if(local_error != NULL) {
+			g_propagate_error(error, local_error);
+		}
+
+		return results;
+	}
+
+	switch(type) {
+		case PURPLE_RESOLVER_LOOKUP_NAME:
+			results = g_resolver_lookup_by_name_with_flags(resolver->resolver,
+			                                               name, arg,
+			                                               cancellable,
+			                                               &local_error);
+			break;
+		case PURPLE_RESOLVER_LOOKUP_SERVICE:
+			results = klass->lookup_service(resolver->resolver, name,
+			                                cancellable, &local_error);
+			break;
+		case PURPLE_RESOLVER_LOOKUP_RECORDS:
+			results = g_resolver_lookup_records(resolver->resolver, name, arg,
+			                                    cancellable, &local_error);
+			break;
+	}
+
+	g_mutex_lock(&resolver->lock);
+	purple_resolver_cache_store_locked(resolver, key, type, results,
+	                                   local_error);
+	g_mutex_unlock(&resolver->lock);
+
+	g_free(key);
+
+	if(local_error != NULL) {
+		g_propagate_error(error, local_error);
+	}
+
+	return results;
+}
+
+/******************************************************************************
+ * Asynchronous Lookups
+ *****************************************************************************/
+static void
+purple_resolver_lookup_free(PurpleResolverLookup *lookup) {
+	g_clear_object(&lookup->resolver);
+	g_free(lookup->key);
+	g_free(lookup->lookup_key);
+	g_clear_object(&lookup->cancellable);
+	g_ptr_array_free(lookup->tasks, TRUE);
+
+	g_free(lookup);
+}
+
+/* Must be called with the resolver's lock held. */
+static void
+purple_resolver_lookup_forget_locked(PurpleResolverLookup *lookup) {
+	GHashTable *lookups = lookup->resolver->lookups;
+
+	if(g_hash_table_lookup(lookups, lookup->lookup_key) == lookup) {
+		g_hash_table_remove(lookups, lookup->lookup_key);
+	}
+}
+
+static void
+purple_resolver_lookup_cancelled_cb(G_GNUC_UNUSED GCancellable *cancellable,
+                                    gpointer data)
+{
+	PurpleResolverLookup *lookup = data;
+	gboolean wanted = FALSE;
+
+	/* The lookup goes on while anyone still wants the answer. */
+	g_mutex_lock(&lookup->resolver->lock);
+	for(guint i = 0; i < lookup->tasks->len; i++) {
+		GTask *task = g_ptr_array_index(lookup->tasks, i);
+
+		if(!g_cancellable_is_cancelled(g_task_get_cancellable(task))) {
+			wanted = TRUE;
+			break;
+		}
+	}
+
+	/* Nobody is waiting anymore, so whoever asks next needs a lookup of its
+	 * own rather than joining this one.
+	 */
+	if(!wanted) {
+		purple_resolver_lookup_forget_locked(lookup);
+	}
+	g_mutex_unlock(&lookup->resolver->lock);
+
+	if(!wanted) {
+		g_cancellable_cancel(lookup->cancellable);
+	}
+}
+
+static void
+purple_resolver_lookup_cb(GObject *source, GAsyncResult *result,
+                          gpointer data)
+{
+	PurpleResolverLookup *lookup = data;
+	PurpleResolver *resolver = lookup->resolver;
+	GResolver *inner = G_RESOLVER(source);
+	GDestroyNotify free_func = NULL;
+	GList *results = NULL;
+	GError *error = NULL;
+
+	switch(lookup->type) {
+		case PURPLE_RESOLVER_LOOKUP_NAME:
+			results = g_resolver_lookup_by_name_with_flags_finish(inner,
+			                                                      result,
+			                                                      &error);
+			break;
+		case PURPLE_RESOLVER_LOOKUP_SERVICE:
+			results = G_RESOLVER_GET_CLASS(inner)->lookup_service_finish(inner,
+			                                                             result,
+			                                                             &error);
+			break;
+		case PURPLE_RESOLVER_LOOKUP_RECORDS:
+			results = g_resolver_lookup_records_finish(inner, result, &error);
+			break;
+	}
+
+	/* Anyone asking from now on gets the cached answer or a new lookup. */
+	g_mutex_lock(&resolver->lock);
+	purple_resolver_lookup_forget_locked(lookup);
+	purple_resolver_cache_store_locked(resolver, lookup->key, lookup->type,
+	                                   results, error);
+	g_mutex_unlock(&resolver->lock);
+
+	free_func = purple_resolver_get_free_func(lookup->type);
+
+	for(guint i = 0; i < lookup->tasks->len; i++) {
+		GTask *task = g_ptr_array_index(lookup->tasks, i);
+		GCancellable *cancellable = g_task_get_cancellable(task);
+		gulong id = GPOINTER_TO_SIZE(g_object_get_data(G_OBJECT(task),
+		                                               "cancelled-id"));
+
+		if(id != 0) {
+			g_cancellable_disconnect(cancellable, id);
+		}
+
+		if(error != NULL) {
+			g_task_return_error(task, g_error_copy(error));
+		} else {
+			g_task_return_pointer(task,
+			                      purple_resolver_copy_results(lookup->type,
+			                                                   results),
+			                      free_func);
+		}
+	}
+
+	if(results != NULL) {
+		free_func(results);
+	}
+	g_clear_error(&error);
+
+	purple_resolver_lookup_free(lookup);
+}
+
+static void
+purple_resolver_lookup_async(PurpleResolver *resolver,
+                             PurpleResolverLookupType type, const gchar *name,
+                             guint arg, GCancellable *cancellable,
+                             GAsyncReadyCallback callback, gpointer data,
+                             gpointer source_tag)
+{
+	PurpleResolverLookup *lookup = NULL;
+	GList *results = NULL;
+	GError *error = NULL;
+	GTask *task = NULL;
+	gchar *key = NULL;
+	gchar *lookup_key = NULL;
+	gboolean found = FALSE;
+	gboolean start = FALSE;
+
+	task = g_task_new(resolver, cancellable, callback, data);
+	g_task_set_source_tag(task, source_tag);
+
+	key = purple_resolver_make_key(type, name, arg);
+
+	/* Waiters only join lookups from their own main context, so the lookup
+	 * can't finish while someone is joining it.
+	 */
+	lookup_key = g_strdup_printf("%p %s",
+	                             (gpointer)g_main_context_get_thread_default(),
+	                             key);
+
+	g_mutex_lock(&resolver->lock);
+
+	found = purple_resolver_cache_lookup_locked(resolver, key, type, &results,
+	                                            &error);
+	if(!found) {
+		lookup = g_hash_table_lookup(resolver->lookups, lookup_key);
+		if(lookup == NULL) {
+			lookup = g_new0(PurpleResolverLookup, 1);
+			lookup->resolver = g_object_ref(resolver);
+			lookup->type = type;
+			lookup->key = g_strdup(key);
+			lookup->lookup_key = g_strdup(lookup_key);
+			lookup->cancellable = g_cancellable_new();
+			lookup->tasks = g_ptr_array_new_with_free_func(g_object_unref);
+
+			g_hash_table_insert(resolver->lookups, g_strdup(lookup_key),
+			                    lookup);
+
+			start = TRUE;
+		} else {
+			purple_debug_misc("resolver", "joining the lookup of %s", name);
+		}
+
+		g_ptr_array_add(lookup->tasks, task);
+	}
+
+	g_mutex_unlock(&resolver->lock);
+
+	g_free(lookup_key);
+	g_free(key);
+
+	if(found) {
+		if(error != NULL) {
+			g_task_return_error(task, error);
+		} else {
+			g_task_return_pointer(task, results,
+			                      purple_resolver_get_free_func(type));
+		}
+		g_object_unref(task);
+
+		return;
+	}
+
+	if(cancellable != NULL) {
+		gulong id = g_cancellable_connect(cancellable,
+		                                  G_CALLBACK(purple_resolver_lookup_cancelled_cb),
+		                                  lookup, NULL);
+
+		g_object_set_data(G_OBJECT(task), "cancelled-id",
+		                  GSIZE_TO_POINTER(id));
+	}
+
+	if(!start) {
+		return;
+	}
+
+	switch(type) {
+		case PURPLE_RESOLVER_LOOKUP_NAME:
+			g_resolver_lookup_by_name_with_flags_async(resolver->resolver,
+			                                           name, arg,
+			                                           lookup->cancellable,
+			                                           purple_resolver_lookup_cb,
+			                                           lookup);
+			break;
+		case PURPLE_RESOLVER_LOOKUP_SERVICE:
+			G_RESOLVER_GET_CLASS(resolver->resolver)->lookup_service_async(
+				resolver->resolver, name, lookup->cancellable,
+				purple_resolver_lookup_cb, lookup);
+			break;
+		case PURPLE_RESOLVER_LOOKUP_RECORDS:
+			g_resolver_lookup_records_async(resolver->resolver, name, arg,
+			                                lookup->cancellable,
+			                                purple_resolver_lookup_cb,
+			                                lookup);
+			break;
+		default:
+			break;
+	}
+}
+
+static GList *
+purple_resolver_lookup_finish(GResolver *resolver, GAsyncResult *result,
+                              GError **error)
+{
+	g_return_val_if_fail(g_task_is_valid(result, resolver), NULL);
+
+	return g_task_propagate_pointer(G_TASK(result), error);
+}
+
+/******************************************************************************
+ * GResolver Implementation
+ *****************************************************************************/
+static GList *
+purple_resolver_lookup_by_name_with_flags(GResolver *resolver,
+                                          const gchar *hostname,
+                                          GResolverNameLookupFlags flags,
+                                          GCancellable *cancellable,
+                                          GError **error)
+{
+	return purple_resolver_lookup_sync(PURPLE_RESOLVER(resolver),
+	                                   PURPLE_RESOLVER_LOOKUP_NAME, hostname,
+	                                   flags, cancellable, error);
+}
+
+static void
+purple_resolver_lookup_by_name_with_flags_async(GResolver *resolver,
+                                                const gchar *hostname,
+                                                GResolverNameLookupFlags flags,
+                                                GCancellable *cancellable,
+                                                GAsyncReadyCallback callback,
+                                                gpointer data)
+{
+	purple_resolver_lookup_async(PURPLE_RESOLVER(resolver),
+	                             PURPLE_RESOLVER_LOOKUP_NAME, hostname, flags,
+	                             cancellable, callback, data,
+	                             purple_resolver_lookup_by_name_with_flags_async);
+}
+
+static GList *
+purple_resolver_lookup_by_name(GResolver *resolver, const gchar *hostname,
+                               GCancellable *cancellable, GError **error)
+{
+	return purple_resolver_lookup_by_name_with_flags(resolver, hostname,
+	                                                 G_RESOLVER_NAME_LOOKUP_FLAGS_DEFAULT,
+	                                                 cancellable, error);
+}
+
+static void
+purple_resolver_lookup_by_name_async(GResolver *resolver,
+                                     const gchar *hostname,
+                                     GCancellable *cancellable,
+                                     GAsyncReadyCallback callback,
+                                     gpointer data)
+{
+	purple_resolver_lookup_by_name_with_flags_async(resolver, hostname,
+	                                                G_RESOLVER_NAME_LOOKUP_FLAGS_DEFAULT,
+	                                                cancellable, callback,
+	                                                data);
+}
+
+static GList *
+purple_resolver_lookup_service(GResolver *resolver, const gchar *rrname,
+                               GCancellable *cancellable, GError **error)
+{
+	return purple_resolver_lookup_sync(PURPLE_RESOLVER(resolver),
+	                                   PURPLE_RESOLVER_LOOKUP_SERVICE, rrname,
+	                                   0, cancellable, error);
+}
+
+static void
+purple_resolver_lookup_service_async(GResolver *resolver, const gchar *rrname,
+                                     GCancellable *cancellable,
+                                     GAsyncReadyCallback callback,
+                                     gpointer data)
+{
+	purple_resolver_lookup_async(PURPLE_RESOLVER(resolver),
+	                             PURPLE_RESOLVER_LOOKUP_SERVICE, rrname, 0,
+	                             cancellable, callback, data,
+	                             purple_resolver_lookup_service_async);
+}
+
+static GList *
+purple_resolver_lookup_records(GResolver *resolver, const gchar *rrname,
+                               GResolverRecordType record_type,
+                               GCancellable *cancellable, GError **error)
+{
+	return purple_resolver_lookup_sync(PURPLE_RESOLVER(resolver),
+	                                   PURPLE_RESOLVER_LOOKUP_RECORDS, rrname,
+	                                   record_type, cancellable, error);
+}
+
+static void
+purple_resolver_lookup_records_async(GResolver *resolver, const gchar *rrname,
+                                     GResolverRecordType record_type,
+                                     GCancellable *cancellable,
+                                     GAsyncReadyCallback callback,
+                                     gpointer data)
+{
+	purple_resolver_lookup_async(PURPLE_RESOLVER(resolver),
+	                             PURPLE_RESOLVER_LOOKUP_RECORDS, rrname,
+	                             record_type, cancellable, callback, data,
+	                             purple_resolver_lookup_records_async);
+}
+
+/* Reverse lookups are rare enough that they aren't cached. */
+static gchar *
+purple_resolver_lookup_by_address(GResolver *resolver, GInetAddress *address,
+                                  GCancellable *cancellable, GError **error)
+{
+	PurpleResolver *purple_resolver = PURPLE_RESOLVER(resolver);
+
+	return g_resolver_lookup_by_address(purple_resolver->resolver, address,
+	                                    cancellable, error);
+}
+
+static void
+purple_resolver_lookup_by_address_cb(GObject *source, GAsyncResult *result,
+                                     gpointer data)
+{
+	GTask *task = data;
+	GError *error = NULL;
+	gchar *name = NULL;
+
+	name = g_resolver_lookup_by_address_finish(G_RESOLVER(source), result,
+	                                           &error);
+	if(error != NULL) {
+		g_task_return_error(task, error);
+	} else {
+		g_task_return_pointer(task, name, g_free);
+	}
+
+	g_object_unref(task);
+}
+
+static void
+purple_resolver_lookup_by_address_async(GResolver *resolver,
+                                        GInetAddress *address,
+                                        GCancellable *cancellable,
+                                        GAsyncReadyCallback callback,
+                                        gpointer data)
+{
+	PurpleResolver *purple_resolver = PURPLE_RESOLVER(resolver);
+	GTask *task = NULL;
+
+	task = g_task_new(resolver, cancellable, callback, data);
+	g_task_set_source_tag(task, purple_resolver_lookup_by_address_async);
+
+	g_resolver_lookup_by_address_async(purple_resolver->resolver, address,
+	                                   cancellable,
+	                                   purple_resolver_lookup_by_address_cb,
+	                                   task);
+}
+
+static gchar *
+purple_resolver_lookup_by_address_finish(GResolver *resolver,
+                                         GAsyncResult *result, GError **error)
+{
+	g_return_val_if_fail(g_task_is_valid(result, resolver), NULL);
+
+	return g_task_propagate_pointer(G_TASK(result), error);
+}
+
+static void
+purple_resolver_reload(GResolver *resolver) {
+	purple_resolver_clear_cache(PURPLE_RESOLVER(resolver));
+}
+
+/******************************************************************************
+ * Callbacks
+ *****************************************************************************/
+static void
+purple_resolver_network_changed_cb(G_GNUC_UNUSED GNetworkMonitor *monitor,
+                                   G_GNUC_UNUSED gboolean available,
+                                   gpointer data)
+{
+	purple_resolver_clear_cache(data);
+}
+
+static void
+purple_resolver_inner_reload_cb(G_GNUC_UNUSED GResolver *inner,
+                                gpointer data)
+{
+	purple_resolver_clear_cache(data);
+}
+
+/******************************************************************************
+ * GObject Implementation
+ *****************************************************************************/
+G_DEFINE_TYPE(PurpleResolver, purple_resolver, G_TYPE_RESOLVER)
+
+static void
+purple_resolver_set_resolver(PurpleResolver *resolver, GResolver *inner) {
+	if(g_set_object(&resolver->resolver, inner)) {
+		g_signal_connect_object(inner, "reload",
+		                        G_CALLBACK(purple_resolver_inner_reload_cb),
+		                        resolver, 0);
+
+		g_object_notify_by_pspec(G_OBJECT(resolver),
+		                         properties[PROP_RESOLVER]);
+	}
+}
+
+static void
+purple_resolver_get_property(GObject *obj, guint param_id, GValue *value,
+                             GParamSpec *pspec)
+{
+	PurpleResolver *resolver = PURPLE_RESOLVER(obj);
+
+	switch(param_id) {
+		case PROP_RESOLVER:
+			g_value_set_object(value, resolver->resolver);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, param_id, pspec);
+			break;
+	}
+}
+
+static void
+purple_resolver_set_property(GObject *obj, guint param_id,
+                             const GValue *value, GParamSpec *pspec)
+{
+	PurpleResolver *resolver = PURPLE_RESOLVER(obj);
+
+	switch(param_id) {
+		case PROP_RESOLVER:
+			purple_resolver_set_resolver(resolver, g_value_get_object(value));
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, param_id, pspec);
+			break;
+	}
+}
+
+static void
+purple_resolver_constructed(GObject *obj) {
+	PurpleResolver *resolver = PURPLE_RESOLVER(obj);
+
+	G_OBJECT_CLASS(purple_resolver_parent_class)->constructed(obj);
+
+	g_signal_connect_object(g_network_monitor_get_default(), "network-changed",
+	                        G_CALLBACK(purple_resolver_network_changed_cb),
+	                        resolver, 0);
+}
+
+static void
+purple_resolver_finalize(GObject *obj) {
+	PurpleResolver *resolver = PURPLE_RESOLVER(obj);
+
+	g_clear_object(&resolver->resolver);
+	g_clear_pointer(&resolver->cache, g_hash_table_destroy);
+	g_clear_pointer(&resolver->lookups, g_hash_table_destroy);
+	g_mutex_clear(&resolver->lock);
+
+	G_OBJECT_CLASS(purple_resolver_parent_class)->finalize(obj);
+}
+
+static void
+purple_resolver_init(PurpleResolver *resolver) {
+	g_mutex_init(&resolver->lock);
+
+	resolver->cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+	                                        (GDestroyNotify)purple_resolver_entry_free);
+
+	/* The lookups free themselves when they finish. */
+	resolver->lookups = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+	                                          NULL);
+}
+
+static void
+purple_resolver_class_init(PurpleResolverClass *klass) {
+	GObjectClass *obj_class = G_OBJECT_CLASS(klass);
+	GResolverClass *resolver_class = G_RESOLVER_CLASS(klass);
+
+	obj_class->get_property = purple_resolver_get_property;
+	obj_class->set_property = purple_resolver_set_property;
+	obj_class->constructed = purple_resolver_constructed;
+	obj_class->finalize = purple_resolver_finalize;
+
+	resolver_class->reload = purple_resolver_reload;
+	resolver_class->lookup_by_name = purple_resolver_lookup_by_name;
+	resolver_class->lookup_by_name_async = purple_resolver_lookup_by_name_async;
+	resolver_class->lookup_by_name_finish = purple_resolver_lookup_finish;
+	resolver_class->lookup_by_name_with_flags =
+		purple_resolver_lookup_by_name_with_flags;
+	resolver_class->lookup_by_name_with_flags_async =
+		purple_resolver_lookup_by_name_with_flags_async;
+	resolver_class->lookup_by_name_with_flags_finish =
+		purple_resolver_lookup_finish;
+	resolver_class->lookup_by_address = purple_resolver_lookup_by_address;
+	resolver_class->lookup_by_address_async =
+		purple_resolver_lookup_by_address_async;
+	resolver_class->lookup_by_address_finish =
+		purple_resolver_lookup_by_address_finish;
+	resolver_class->lookup_service = purple_resolver_lookup_service;
+	resolver_class->lookup_service_async = purple_resolver_lookup_service_async;
+	resolver_class->lookup_service_finish = purple_resolver_lookup_finish;
+	resolver_class->lookup_records = purple_resolver_lookup_records;
+	resolver_class->lookup_records_async = purple_resolver_lookup_records_async;
+	resolver_class->lookup_records_finish = purple_resolver_lookup_finish;
+
+	/**
+	 * PurpleResolver:resolver:
+	 *
+	 * The resolver that does the actual lookups.
+	 *
+	 * Since: 3.0.0
+	 */
+	properties[PROP_RESOLVER] = g_param_spec_object(
+		"resolver", "resolver",
+		"The resolver that does the actual lookups.",
+		G_TYPE_RESOLVER,
+		G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+	g_object_class_install_properties(obj_class, N_PROPERTIES, properties);
+}
+
+/******************************************************************************
+ * Private API
+ *****************************************************************************/
+void
+purple_resolver_startup(void) {
+	if(default_resolver != NULL) {
+		return;
+	}
+
+	system_resolver = g_resolver_get_default();
+
+	default_resolver = purple_resolver_new(system_resolver);
+	g_object_add_weak_pointer(G_OBJECT(default_resolver),
+	                          (gpointer *)&default_resolver);
+
+	g_resolver_set_default(G_RESOLVER(default_resolver));
+}
+
+void
+purple_resolver_shutdown(void) {
+	if(default_resolver == NULL) {
+		return;
+	}
+
+	/* GLib holds a reference to the default resolver, so putting the system
+	 * one back is what lets ours go.
+	 */
+	g_resolver_set_default(system_resolver);
+	g_clear_object(&system_resolver);
+
+	g_clear_object(&default_resolver);
+}
+
+/******************************************************************************
+ * Public API
+ *****************************************************************************/
+PurpleResolver *
+purple_resolver_new(GResolver *resolver) {
+	g_return_val_if_fail(G_IS_RESOLVER(resolver), NULL);
+
+	return g_object_new(PURPLE_TYPE_RESOLVER, "resolver", resolver, NULL);
+}
+
+PurpleResolver *
+purple_resolver_get_default(void) {
+	return default_resolver;
+}
+
+void
+purple_resolver_clear_cache(PurpleResolver *resolver) {
+	g_return_if_fail(PURPLE_IS_RESOLVER(resolver));
+
+	g_mutex_lock(&resolver->lock);
+	g_hash_table_remove_all(resolver->cache);
+	g_mutex_unlock(&resolver->lock);
+}
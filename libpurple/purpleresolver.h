@@ -0,0 +1,87 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(PURPLE_GLOBAL_HEADER_INSIDE) && !defined(PURPLE_COMPILATION)
+# error "only <purple.h> may be included directly"
+#endif
+
+#ifndef PURPLE_RESOLVER_H
+#define PURPLE_RESOLVER_H
+
+#include <glib.h>
+#include <glib-object.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define PURPLE_TYPE_RESOLVER (purple_resolver_get_type())
+
+/**
+ * PurpleResolver:
+ *
+ * #PurpleResolver is a [class@Gio.Resolver] that wraps another resolver and
+ * remembers its answers for a short while.  Host names, SRV records and other
+ * records are cached, and lookups for something that is already being looked
+ * up wait for that lookup instead of starting another one.
+ *
+ * While libpurple is running, the default instance is installed as the
+ * default [class@Gio.Resolver], so every [class@Gio.SocketClient], including
+ * the ones from purple_gio_socket_client_new(), goes through it.
+ *
+ * Since: 3.0.0
+ */
+G_DECLARE_FINAL_TYPE(PurpleResolver, purple_resolver, PURPLE, RESOLVER,
+                     GResolver)
+
+/**
+ * purple_resolver_new:
+ * @resolver: The resolver to do the actual lookups with.
+ *
+ * Creates a new resolver that caches the answers of @resolver.
+ *
+ * Returns: (transfer full): The new instance.
+ *
+ * Since: 3.0.0
+ */
+PurpleResolver *purple_resolver_new(GResolver *resolver);
+
+/**
+ * purple_resolver_get_default:
+ *
+ * Gets the default #PurpleResolver instance.
+ *
+ * Returns: (transfer none): The default #PurpleResolver instance.
+ *
+ * Since: 3.0.0
+ */
+PurpleResolver *purple_resolver_get_default(void);
+
+/**
+ * purple_resolver_clear_cache:
+ * @resolver: The instance.
+ *
+ * Forgets every cached answer.  This is done automatically when the network
+ * changes or the system's resolver configuration is reloaded.
+ *
+ * Since: 3.0.0
+ */
+void purple_resolver_clear_cache(PurpleResolver *resolver);
+
+G_END_DECLS
+
+#endif /* PURPLE_RESOLVER_H */
@@ -33,6 +33,26 @@ struct _PurpleSqliteHistoryAdapter {
 	sqlite3 *db;
 };
 
+#define INSERT_COLUMNS \
+	"INSERT INTO message_log(protocol, account, conversation_id, " \
+	"message_id, author, author_name_color, author_alias, " \
+	"recipient, content_type, content, client_timestamp) "
+
+#define INSERT_SCRIPT \
+	INSERT_COLUMNS \
+	"VALUES(?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11)"
+
+/* Same as INSERT_SCRIPT but does nothing if the conversation already has a
+ * message with the same id.  This is backed by the message_log_message_id
+ * index.
+ */
+#define INSERT_UNIQUE_SCRIPT \
+	INSERT_COLUMNS \
+	"SELECT ?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11 " \
+	"WHERE NOT EXISTS(SELECT 1 FROM message_log " \
+	"WHERE protocol = ?1 AND account = ?2 AND conversation_id = ?3 " \
+	"AND message_id = ?4)"
+
 enum {
 	PROP_0,
 	PROP_FILENAME,
@@ -63,6 +83,7 @@ purple_sqlite_history_adapter_run_migrations(PurpleSqliteHistoryAdapter *adapter
 	const char *path = "/im/pidgin/libpurple/sqlitehistoryadapter";
 	const char *migrations[] = {
 		"01-schema.sql",
+		"02-message-id-index.sql",
 		NULL
 	};
 
@@ -109,6 +130,120 @@ purple_sqlite_history_adapter_get_content_type_enum(const gchar *content_type)
 	return PURPLE_MESSAGE_CONTENT_TYPE_PLAIN;
 }
 
+static sqlite3_stmt *
+purple_sqlite_history_adapter_prepare(PurpleSqliteHistoryAdapter *adapter,
+                                      const gchar *script, GError **error)
+{
+	sqlite3_stmt *prepared_statement = NULL;
+
+	sqlite3_prepare_v2(adapter->db, script, -1, &prepared_statement, NULL);
+
+	if(prepared_statement == NULL) {
+		g_set_error(error, PURPLE_HISTORY_ADAPTER_DOMAIN, 0,
+		            "Error creating the prepared statement: %s",
+		            sqlite3_errmsg(adapter->db));
+	}
+
+	return prepared_statement;
+}
+
+static void
+purple_sqlite_history_adapter_bind_message(sqlite3_stmt *prepared_statement,
+                                           PurpleConversation *conversation,
+                                           PurpleMessage *message)
+{
+	PurpleAccount *account = NULL;
+	PurpleContactInfo *info = NULL;
+	gchar *timestamp = NULL;
+	gchar *content_type = NULL;
+	const gchar *message_id = NULL;
+
+	account = purple_conversation_get_account(conversation);
+	info = PURPLE_CONTACT_INFO(account);
+
+	sqlite3_bind_text(prepared_statement,
+	                  1, purple_account_get_protocol_name(account), -1,
+	                  SQLITE_STATIC);
+	sqlite3_bind_text(prepared_statement,
+	                  2, purple_contact_info_get_username(info), -1,
+	                  SQLITE_STATIC);
+	sqlite3_bind_text(prepared_statement,
+	                  3, purple_conversation_get_name(conversation), -1,
+	                  SQLITE_STATIC);
+	message_id = purple_message_get_id(message);
+	if(message_id != NULL) {
+		sqlite3_bind_text(prepared_statement, 4, message_id, -1,
+		                  SQLITE_STATIC);
+	} else {
+		sqlite3_bind_text(prepared_statement, 4, g_uuid_string_random(), -1,
+		                  g_free);
+	}
+	sqlite3_bind_text(prepared_statement,
+	                  5, purple_message_get_author(message), -1,
+	                  SQLITE_STATIC);
+	sqlite3_bind_text(prepared_statement,
+	                  6, purple_message_get_author_name_color(message), -1,
+	                  SQLITE_STATIC);
+	sqlite3_bind_text(prepared_statement,
+	                  7, purple_message_get_author_alias(message), -1,
+	                  SQLITE_STATIC);
+	sqlite3_bind_text(prepared_statement,
+	                  8, purple_message_get_recipient(message), -1,
+	                  SQLITE_STATIC);
+	content_type = purple_sqlite_history_adapter_get_content_type(purple_message_get_content_type(message));
+	sqlite3_bind_text(prepared_statement,
+	                  9, content_type, -1, SQLITE_STATIC);
+	sqlite3_bind_text(prepared_statement,
+	                  10, purple_message_get_contents(message), -1,
+	                  SQLITE_STATIC);
+	timestamp = g_date_time_format_iso8601(purple_message_get_timestamp(message));
+	sqlite3_bind_text(prepared_statement, 11, timestamp, -1, g_free);
+}
+
+static PurpleMessage *
+purple_sqlite_history_adapter_message_from_row(sqlite3_stmt *prepared_statement)
+{
+	PurpleMessage *message = NULL;
+	PurpleMessageContentType ct;
+	GDateTime *g_date_time = NULL;
+	const gchar *message_id = NULL;
+	const gchar *author = NULL;
+	const gchar *author_name_color = NULL;
+	const gchar *author_alias = NULL;
+	const gchar *recipient = NULL;
+	const gchar *content = NULL;
+	const gchar *content_type = NULL;
+	const gchar *timestamp = NULL;
+
+	message_id = (const gchar *)sqlite3_column_text(prepared_statement, 0);
+	author = (const gchar *)sqlite3_column_text(prepared_statement, 1);
+	author_name_color = (const gchar *)sqlite3_column_text(prepared_statement, 2);
+	author_alias = (const gchar *)sqlite3_column_text(prepared_statement, 3);
+	recipient = (const gchar *)sqlite3_column_text(prepared_statement, 4);
+	content_type = (const gchar *)sqlite3_column_text(prepared_statement, 5);
+	ct = purple_sqlite_history_adapter_get_content_type_enum(content_type);
+	content = (const gchar *)sqlite3_column_text(prepared_statement, 6);
+	timestamp = (const gchar *)sqlite3_column_text(prepared_statement, 7);
+	if(timestamp != NULL) {
+		g_date_time = g_date_time_new_from_iso8601(timestamp, NULL);
+	}
+
+	message = g_object_new(PURPLE_TYPE_MESSAGE,
+	                       "id", message_id,
+	                       "author", author,
+	                       "author_name_color", author_name_color,
+	                       "author_alias", author_alias,
+	                       "recipient", recipient,
+	                       "contents", content,
+	                       "content_type", ct,
+	                       "timestamp", g_date_time,
+	                       NULL);
+
+	g_clear_pointer(&g_date_time, g_date_time_unref);
+
+	return message;
+}
+
 static sqlite3_stmt *
 purple_sqlite_history_adapter_build_query(PurpleSqliteHistoryAdapter *adapter,
                                           const gchar * search_query,
@@ -333,38 +468,8 @@ purple_sqlite_history_adapter_query(PurpleHistoryAdapter *adapter,
 
 	while(sqlite3_step(prepared_statement) == SQLITE_ROW) {
 		PurpleMessage *message = NULL;
-		PurpleMessageContentType ct;
-		GDateTime *g_date_time = NULL;
-		const gchar *message_id = NULL;
-		const gchar *author = NULL;
-		const gchar *author_name_color = NULL;
-		const gchar *author_alias = NULL;
-		const gchar *recipient = NULL;
-		const gchar *content = NULL;
-		const gchar *content_type = NULL;
-		const gchar *timestamp = NULL;
-
-		message_id = (const gchar *)sqlite3_column_text(prepared_statement, 0);
-		author = (const gchar *)sqlite3_column_text(prepared_statement, 1);
-		author_name_color = (const gchar *)sqlite3_column_text(prepared_statement, 2);
-		author_alias = (const gchar *)sqlite3_column_text(prepared_statement, 3);
-		recipient = (const gchar *)sqlite3_column_text(prepared_statement, 4);
-		content_type = (const gchar *)sqlite3_column_text(prepared_statement, 5);
-		ct = purple_sqlite_history_adapter_get_content_type_enum(content_type);
-		content = (const gchar *)sqlite3_column_text(prepared_statement, 6);
-		timestamp = (const gchar *)sqlite3_column_text(prepared_statement, 7);
-		g_date_time = g_date_time_new_from_iso8601(timestamp, NULL);
 
-		message = g_object_new(PURPLE_TYPE_MESSAGE,
-		                       "id", message_id,
-		                       "author", author,
-		                       "author_name_color", author_name_color,
-		                       "author_alias", author_alias,
-		                       "recipient", recipient,
-		                       "contents", content,
-		                       "content_type", ct,
-		                       "timestamp", g_date_time,
-		                       NULL);
+		message = purple_sqlite_history_adapter_message_from_row(prepared_statement);
 
 		results = g_list_prepend(results, message);
 	}
@@ -424,21 +529,10 @@ purple_sqlite_history_adapter_write(PurpleHistoryAdapter *adapter,
                                     PurpleConversation *conversation,
                                     PurpleMessage *message, GError **error)
 {
-	PurpleAccount *account = NULL;
-	PurpleContactInfo *info = NULL;
 	PurpleSqliteHistoryAdapter *sqlite_adapter = NULL;
 	sqlite3_stmt *prepared_statement = NULL;
-	gchar *timestamp = NULL;
-	gchar *content_type = NULL;
-	const gchar * message_id = NULL;
-	const gchar *script = NULL;
 	gint result = 0;
 
-	script = "INSERT INTO message_log(protocol, account, conversation_id, "
-			 "message_id, author, author_name_color, author_alias, "
-			 "recipient, content_type, content, client_timestamp) "
-	         "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
-
 	sqlite_adapter = PURPLE_SQLITE_HISTORY_ADAPTER(adapter);
 
 	if(sqlite_adapter->db == NULL) {
@@ -448,16 +542,168 @@ purple_sqlite_history_adapter_write(PurpleHistoryAdapter *adapter,
 		return FALSE;
 	}
 
-	sqlite3_prepare_v2(sqlite_adapter->db, script, -1, &prepared_statement, NULL);
+	prepared_statement = purple_sqlite_history_adapter_prepare(sqlite_adapter,
+	                                                           INSERT_SCRIPT,
+	                                                           error);
+	if(prepared_statement == NULL) {
+		return FALSE;
+	}
+
+	purple_sqlite_history_adapter_bind_message(prepared_statement,
+	                                           conversation, message);
+
+	result = sqlite3_step(prepared_statement);
+
+	if(result != SQLITE_DONE) {
+		g_set_error(error, PURPLE_HISTORY_ADAPTER_DOMAIN, 0,
+		            "Error writing to the database: %s",
+		            sqlite3_errmsg(sqlite_adapter->db));
+
+		sqlite3_finalize(prepared_statement);
 
+		return FALSE;
+	}
+
+	sqlite3_finalize(prepared_statement);
+
+	return TRUE;
+}
+
+static gboolean
+purple_sqlite_history_adapter_write_messages(PurpleHistoryAdapter *adapter,
+                                             PurpleConversation *conversation,
+                                             GPtrArray *messages,
+                                             GError **error)
+{
+	PurpleSqliteHistoryAdapter *sqlite_adapter = NULL;
+	sqlite3_stmt *prepared_statement = NULL;
+	guint i = 0;
+
+	sqlite_adapter = PURPLE_SQLITE_HISTORY_ADAPTER(adapter);
+
+	if(sqlite_adapter->db == NULL) {
+		g_set_error_literal(error, PURPLE_HISTORY_ADAPTER_DOMAIN, 0,
+		                    _("Adapter has not been activated"));
+
+		return FALSE;
+	}
+
+	prepared_statement = purple_sqlite_history_adapter_prepare(sqlite_adapter,
+	                                                           INSERT_UNIQUE_SCRIPT,
+	                                                           error);
 	if(prepared_statement == NULL) {
+		return FALSE;
+	}
+
+	/* A single transaction means a single journal sync for the whole page
+	 * instead of one per message, which is where almost all of the time goes
+	 * when writing to disk.
+	 */
+	if(sqlite3_exec(sqlite_adapter->db, "BEGIN TRANSACTION", NULL, NULL,
+	                NULL) != SQLITE_OK)
+	{
 		g_set_error(error, PURPLE_HISTORY_ADAPTER_DOMAIN, 0,
-		            "Error creating the prepared statement: %s",
+		            "Error starting a transaction: %s",
 		            sqlite3_errmsg(sqlite_adapter->db));
+
+		sqlite3_finalize(prepared_statement);
+
 		return FALSE;
 	}
 
-	account = purple_conversation_get_account(conversation);
+	while(i < messages->len) {
+		PurpleMessage *message = g_ptr_array_index(messages, i);
+
+		purple_sqlite_history_adapter_bind_message(prepared_statement,
+		                                           conversation, message);
+
+		if(sqlite3_step(prepared_statement) != SQLITE_DONE) {
+			g_set_error(error, PURPLE_HISTORY_ADAPTER_DOMAIN, 0,
+			            "Error writing to the database: %s",
+			            sqlite3_errmsg(sqlite_adapter->db));
+
+			sqlite3_finalize(prepared_statement);
+			sqlite3_exec(sqlite_adapter->db, "ROLLBACK", NULL, NULL, NULL);
+
+			return FALSE;
+		}
+
+		sqlite3_reset(prepared_statement);
+		sqlite3_clear_bindings(prepared_statement);
+
+		/* Nothing was inserted if we already had a message with this id. */
+		if(sqlite3_changes(sqlite_adapter->db) == 0) {
+			g_ptr_array_remove_index(messages, i);
+		} else {
+			i++;
+		}
+	}
+
+	sqlite3_finalize(prepared_statement);
+
+	if(sqlite3_exec(sqlite_adapter->db, "COMMIT", NULL, NULL,
+	                NULL) != SQLITE_OK)
+	{
+		g_set_error(error, PURPLE_HISTORY_ADAPTER_DOMAIN, 0,
+		            "Error writing to the database: %s",
+		            sqlite3_errmsg(sqlite_adapter->db));
+
+		sqlite3_exec(sqlite_adapter->db, "ROLLBACK", NULL, NULL, NULL);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static PurpleMessage *
+purple_sqlite_history_adapter_get_last_message(PurpleHistoryAdapter *adapter,
+                                               PurpleAccount *account,
+                                               const gchar *conversation_id,
+                                               GError **error)
+{
+	PurpleContactInfo *info = NULL;
+	PurpleMessage *message = NULL;
+	PurpleSqliteHistoryAdapter *sqlite_adapter = NULL;
+	sqlite3_stmt *prepared_statement = NULL;
+	const gchar *script = NULL;
+	gint result = 0;
+
+	sqlite_adapter = PURPLE_SQLITE_HISTORY_ADAPTER(adapter);
+
+	if(sqlite_adapter->db == NULL) {
+		g_set_error_literal(error, PURPLE_HISTORY_ADAPTER_DOMAIN, 0,
+		                    _("Adapter has not been activated"));
+
+		return NULL;
+	}
+
+	/* rowid is the insertion order, which unlike the timestamps does not
+	 * depend on the time zone the message was written in.
+	 */
+	if(conversation_id != NULL) {
+		script = "SELECT "
+		         "message_id, author, author_name_color, author_alias, "
+		         "recipient, content_type, content, client_timestamp "
+		         "FROM message_log "
+		         "WHERE protocol = ?1 AND account = ?2 "
+		         "AND conversation_id = ?3 "
+		         "ORDER BY rowid DESC LIMIT 1";
+	} else {
+		script = "SELECT "
+		         "message_id, author, author_name_color, author_alias, "
+		         "recipient, content_type, content, client_timestamp "
+		         "FROM message_log "
+		         "WHERE protocol = ?1 AND account = ?2 "
+		         "ORDER BY rowid DESC LIMIT 1";
+	}
+
+	prepared_statement = purple_sqlite_history_adapter_prepare(sqlite_adapter,
+	                                                           script, error);
+	if(prepared_statement == NULL) {
+		return NULL;
+	}
+
 	info = PURPLE_CONTACT_INFO(account);
 
 	sqlite3_bind_text(prepared_statement,
@@ -466,53 +712,23 @@ purple_sqlite_history_adapter_write(PurpleHistoryAdapter *adapter,
 	sqlite3_bind_text(prepared_statement,
 	                  2, purple_contact_info_get_username(info), -1,
 	                  SQLITE_STATIC);
-	sqlite3_bind_text(prepared_statement,
-	                  3, purple_conversation_get_name(conversation), -1,
-	                  SQLITE_STATIC);
-	message_id = purple_message_get_id(message);
-	if(message_id != NULL) {
-		sqlite3_bind_text(prepared_statement, 4, message_id, -1,
+	if(conversation_id != NULL) {
+		sqlite3_bind_text(prepared_statement, 3, conversation_id, -1,
 		                  SQLITE_STATIC);
-	} else {
-		sqlite3_bind_text(prepared_statement, 4, g_uuid_string_random(), -1,
-		                  g_free);
 	}
-	sqlite3_bind_text(prepared_statement,
-	                  5, purple_message_get_author(message), -1,
-	                  SQLITE_STATIC);
-	sqlite3_bind_text(prepared_statement,
-	                  6, purple_message_get_author_name_color(message), -1,
-	                  SQLITE_STATIC);
-	sqlite3_bind_text(prepared_statement,
-	                  7, purple_message_get_author_alias(message), -1,
-	                  SQLITE_STATIC);
-	sqlite3_bind_text(prepared_statement,
-	                  8, purple_message_get_recipient(message), -1,
-	                  SQLITE_STATIC);
-	content_type = purple_sqlite_history_adapter_get_content_type(purple_message_get_content_type(message));
-	sqlite3_bind_text(prepared_statement,
-	                  9, content_type, -1, SQLITE_STATIC);
-	sqlite3_bind_text(prepared_statement,
-	                  10, purple_message_get_contents(message), -1,
-	                  SQLITE_STATIC);
-	timestamp = g_date_time_format_iso8601(purple_message_get_timestamp(message));
-	sqlite3_bind_text(prepared_statement, 11, timestamp, -1, g_free);
 
 	result = sqlite3_step(prepared_statement);
-
-	if(result != SQLITE_DONE) {
+	if(result == SQLITE_ROW) {
+		message = purple_sqlite_history_adapter_message_from_row(prepared_statement);
+	} else if(result != SQLITE_DONE) {
 		g_set_error(error, PURPLE_HISTORY_ADAPTER_DOMAIN, 0,
-		            "Error writing to the database: %s",
+		            "Error reading from the database: %s",
 		            sqlite3_errmsg(sqlite_adapter->db));
-
-		sqlite3_finalize(prepared_statement);
-
-		return FALSE;
 	}
 
 	sqlite3_finalize(prepared_statement);
 
-	return TRUE;
+	return message;
 }
 
 /******************************************************************************
@@ -591,6 +807,8 @@ purple_sqlite_history_adapter_class_init(PurpleSqliteHistoryAdapterClass *klass)
 	adapter_class->query = purple_sqlite_history_adapter_query;
 	adapter_class->remove = purple_sqlite_history_adapter_remove;
 	adapter_class->write = purple_sqlite_history_adapter_write;
+	adapter_class->write_messages = purple_sqlite_history_adapter_write_messages;
+	adapter_class->get_last_message = purple_sqlite_history_adapter_get_last_message;
 
 	/**
 	 * PurpleHistoryAdapter::filename:
@@ -0,0 +1,485 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "purpletlssessioncache.h"
+
+#include "debug.h"
+#include "purpleaccountmanager.h"
+#include "purpleprivate.h"
+#include "util.h"
+
+/* Servers rarely accept tickets that are older than a few hours, so there's
+ * no point in offering them.
+ */
+#define PURPLE_TLS_SESSION_CACHE_LIFETIME (2 * 60 * 60)
+#define PURPLE_TLS_SESSION_CACHE_MAX_ENTRIES (256)
+
+enum {
+	PROP_0,
+	PROP_RESUMABLE_HANDSHAKES,
+	PROP_FULL_HANDSHAKES,
+	N_PROPERTIES,
+};
+static GParamSpec *properties[N_PROPERTIES] = { NULL, };
+
+struct _PurpleTlsSessionCache {
+	GObject parent;
+
+	/* Account id and server identity to PurpleTlsSessionCacheEntry. */
+	GHashTable *sessions;
+
+	guint resumable_handshakes;
+	guint full_handshakes;
+};
+
+typedef struct {
+	gchar *account_id;
+
+	/* The connection that made the session, for as long as its owner keeps
+	 * it.  It's held with a toggle reference so the cache never keeps a
+	 * socket open by itself.
+	 */
+	GTlsClientConnection *connection;
+	guint release_id;
+
+	/* A connection without a socket that the session was copied to once the
+	 * owner let go of the real one.
+	 */
+	GTlsClientConnection *session;
+
+	gint64 expires;
+} PurpleTlsSessionCacheEntry;
+
+static PurpleTlsSessionCache *default_cache = NULL;
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static void purple_tls_session_cache_toggle_cb(gpointer data, GObject *obj,
+                                               gboolean is_last_ref);
+
+static void
+purple_tls_session_cache_entry_release_connection(PurpleTlsSessionCacheEntry *entry)
+{
+	GTlsClientConnection *connection = entry->connection;
+
+	g_clear_handle_id(&entry->release_id, g_source_remove);
+
+	if(connection != NULL) {
+		entry->connection = NULL;
+		g_object_remove_toggle_ref(G_OBJECT(connection),
+		                           purple_tls_session_cache_toggle_cb, entry);
+	}
+}
+
+static void
+purple_tls_session_cache_entry_free(PurpleTlsSessionCacheEntry *entry) {
+	purple_tls_session_cache_entry_release_connection(entry);
+
+	g_free(entry->account_id);
+	g_clear_object(&entry->session);
+
+	g_free(entry);
+}
+
+/* Copies the session of the entry's connection to a connection of the same
+ * type that sits on memory streams, so the session outlives the socket.
+ */
+static void
+purple_tls_session_cache_entry_snapshot(PurpleTlsSessionCacheEntry *entry) {
+	GTlsClientConnection *connection = entry->connection;
+	GInputStream *input = NULL;
+	GOutputStream *output = NULL;
+	GIOStream *base = NULL;
+	GError *error = NULL;
+	gpointer session = NULL;
+
+	input = g_memory_input_stream_new();
+	output = g_memory_output_stream_new_resizable();
+	base = g_simple_io_stream_new(input, output);
+
+	session = g_initable_new(G_OBJECT_TYPE(connection), NULL, &error,
+	                         "base-io-stream", base,
+	                         "server-identity",
+	                         g_tls_client_connection_get_server_identity(connection),
+	                         NULL);
+
+	g_object_unref(base);
+	g_object_unref(output);
+	g_object_unref(input);
+
+	if(session == NULL) {
+		purple_debug_warning("tls-session-cache",
+		                     "failed to keep a TLS session: %s",
+		                     error != NULL ? error->message : "unknown error");
+		g_clear_error(&error);
+
+		return;
+	}
+
+	g_tls_client_connection_copy_session_state(session, connection);
+
+	g_clear_object(&entry->session);
+	entry->session = session;
+}
+
+static gboolean
+purple_tls_session_cache_entry_is_expired(G_GNUC_UNUSED gpointer key,
+                                          gpointer value, gpointer data)
+{
+	PurpleTlsSessionCacheEntry *entry = value;
+	gint64 *now = data;
+
+	return entry->expires <= *now;
+}
+
+static gboolean
+purple_tls_session_cache_release_cb(gpointer data) {
+	PurpleTlsSessionCacheEntry *entry = data;
+
+	entry->release_id = 0;
+
+	purple_tls_session_cache_entry_snapshot(entry);
+	purple_tls_session_cache_entry_release_connection(entry);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+purple_tls_session_cache_toggle_cb(gpointer data,
+                                   G_GNUC_UNUSED GObject *obj,
+                                   gboolean is_last_ref)
+{
+	PurpleTlsSessionCacheEntry *entry = data;
+
+	/* Dropping the last reference from within a toggle notification isn't
+	 * allowed, so the connection is let go of from an idle callback.
+	 */
+	if(is_last_ref) {
+		if(entry->release_id == 0) {
+			entry->release_id = g_idle_add(purple_tls_session_cache_release_cb,
+			                               entry);
+		}
+	} else {
+		g_clear_handle_id(&entry->release_id, g_source_remove);
+	}
+}
+
+static gboolean
+purple_tls_session_cache_entry_has_account(G_GNUC_UNUSED gpointer key,
+                                           gpointer value, gpointer data)
+{
+	PurpleTlsSessionCacheEntry *entry = value;
+
+	return data == NULL || purple_strequal(entry->account_id, data);
+}
+
+static gchar *
+purple_tls_session_cache_make_key(const gchar *account_id,
+                                  GTlsClientConnection *connection)
+{
+	GSocketConnectable *identity = NULL;
+	gchar *server = NULL;
+	gchar *key = NULL;
+
+	identity = g_tls_client_connection_get_server_identity(connection);
+	if(identity == NULL) {
+		return NULL;
+	}
+
+	server = g_socket_connectable_to_string(identity);
+	key = g_strdup_printf("%s %s", account_id, server);
+	g_free(server);
+
+	return key;
+}
+
+static void
+purple_tls_session_cache_store(PurpleTlsSessionCache *cache,
+                               GTlsClientConnection *connection)
+{
+	PurpleTlsSessionCacheEntry *entry = NULL;
+	const gchar *account_id = NULL;
+	const gchar *key = NULL;
+	gint64 now = g_get_monotonic_time();
+
+	account_id = g_object_get_data(G_OBJECT(connection),
+	                               "purple-tls-session-account");
+	key = g_object_get_data(G_OBJECT(connection), "purple-tls-session-key");
+
+	g_hash_table_foreach_remove(cache->sessions,
+	                            purple_tls_session_cache_entry_is_expired, &now);
+
+	if(g_hash_table_size(cache->sessions) >=
+	   PURPLE_TLS_SESSION_CACHE_MAX_ENTRIES)
+	{
+		g_hash_table_remove_all(cache->sessions);
+	}
+
+	entry = g_new0(PurpleTlsSessionCacheEntry, 1);
+	entry->account_id = g_strdup(account_id);
+	entry->connection = connection;
+	g_object_add_toggle_ref(G_OBJECT(connection),
+	                        purple_tls_session_cache_toggle_cb, entry);
+	entry->expires = now + PURPLE_TLS_SESSION_CACHE_LIFETIME * G_USEC_PER_SEC;
+
+	g_hash_table_replace(cache->sessions, g_strdup(key), entry);
+}
+
+/******************************************************************************
+ * Callbacks
+ *****************************************************************************/
+static void
+purple_tls_session_cache_protocol_version_cb(GObject *obj,
+                                             G_GNUC_UNUSED GParamSpec *pspec,
+                                             gpointer data)
+{
+	PurpleTlsSessionCache *cache = data;
+	GTlsConnection *connection = G_TLS_CONNECTION(obj);
+	gboolean offered = FALSE;
+
+	/* The protocol version is known once the handshake is done. */
+	if(g_tls_connection_get_protocol_version(connection) ==
+	   G_TLS_PROTOCOL_VERSION_UNKNOWN)
+	{
+		return;
+	}
+
+	g_signal_handlers_disconnect_by_func(obj,
+	                                     purple_tls_session_cache_protocol_version_cb,
+	                                     cache);
+
+	offered = GPOINTER_TO_INT(g_object_get_data(obj,
+	                                            "purple-tls-session-offered"));
+	if(offered) {
+		cache->resumable_handshakes++;
+		g_object_notify_by_pspec(G_OBJECT(cache),
+		                         properties[PROP_RESUMABLE_HANDSHAKES]);
+	} else {
+		cache->full_handshakes++;
+		g_object_notify_by_pspec(G_OBJECT(cache),
+		                         properties[PROP_FULL_HANDSHAKES]);
+	}
+
+	purple_tls_session_cache_store(cache, G_TLS_CLIENT_CONNECTION(obj));
+}
+
+static void
+purple_tls_session_cache_account_removed_cb(G_GNUC_UNUSED PurpleAccountManager *manager,
+                                            PurpleAccount *account,
+                                            gpointer data)
+{
+	purple_tls_session_cache_clear(data, account);
+}
+
+/******************************************************************************
+ * GObject Implementation
+ *****************************************************************************/
+G_DEFINE_TYPE(PurpleTlsSessionCache, purple_tls_session_cache, G_TYPE_OBJECT)
+
+static void
+purple_tls_session_cache_get_property(GObject *obj, guint param_id,
+                                      GValue *value, GParamSpec *pspec)
+{
+	PurpleTlsSessionCache *cache = PURPLE_TLS_SESSION_CACHE(obj);
+
+	switch(param_id) {
+		case PROP_RESUMABLE_HANDSHAKES:
+			g_value_set_uint(value,
+			                 purple_tls_session_cache_get_resumable_handshakes(cache));
+			break;
+		case PROP_FULL_HANDSHAKES:
+			g_value_set_uint(value,
+			                 purple_tls_session_cache_get_full_handshakes(cache));
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, param_id, pspec);
+			break;
+	}
+}
+
+static void
+purple_tls_session_cache_finalize(GObject *obj) {
+	PurpleTlsSessionCache *cache = PURPLE_TLS_SESSION_CACHE(obj);
+
+	g_clear_pointer(&cache->sessions, g_hash_table_destroy);
+
+	G_OBJECT_CLASS(purple_tls_session_cache_parent_class)->finalize(obj);
+}
+
+static void
+purple_tls_session_cache_init(PurpleTlsSessionCache *cache) {
+	cache->sessions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+	                                        (GDestroyNotify)purple_tls_session_cache_entry_free);
+}
+
+static void
+purple_tls_session_cache_class_init(PurpleTlsSessionCacheClass *klass) {
+	GObjectClass *obj_class = G_OBJECT_CLASS(klass);
+
+	obj_class->get_property = purple_tls_session_cache_get_property;
+	obj_class->finalize = purple_tls_session_cache_finalize;
+
+	/**
+	 * PurpleTlsSessionCache:resumable-handshakes:
+	 *
+	 * The number of completed handshakes that offered a remembered session.
+	 *
+	 * Since: 3.0.0
+	 */
+	properties[PROP_RESUMABLE_HANDSHAKES] = g_param_spec_uint(
+		"resumable-handshakes", "resumable-handshakes",
+		"The number of handshakes that offered to resume a session.",
+		0, G_MAXUINT, 0,
+		G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+	/**
+	 * PurpleTlsSessionCache:full-handshakes:
+	 *
+	 * The number of completed handshakes that had no session to offer.
+	 *
+	 * Since: 3.0.0
+	 */
+	properties[PROP_FULL_HANDSHAKES] = g_param_spec_uint(
+		"full-handshakes", "full-handshakes",
+		"The number of full handshakes.",
+		0, G_MAXUINT, 0,
+		G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+	g_object_class_install_properties(obj_class, N_PROPERTIES, properties);
+}
+
+/******************************************************************************
+ * Private API
+ *****************************************************************************/
+void
+purple_tls_session_cache_startup(void) {
+	PurpleAccountManager *manager = NULL;
+
+	if(default_cache != NULL) {
+		return;
+	}
+
+	default_cache = g_object_new(PURPLE_TYPE_TLS_SESSION_CACHE, NULL);
+	g_object_add_weak_pointer(G_OBJECT(default_cache),
+	                          (gpointer *)&default_cache);
+
+	manager = purple_account_manager_get_default();
+	g_signal_connect_object(manager, "removed",
+	                        G_CALLBACK(purple_tls_session_cache_account_removed_cb),
+	                        default_cache, 0);
+}
+
+void
+purple_tls_session_cache_shutdown(void) {
+	g_clear_object(&default_cache);
+}
+
+/******************************************************************************
+ * Public API
+ *****************************************************************************/
+PurpleTlsSessionCache *
+purple_tls_session_cache_get_default(void) {
+	return default_cache;
+}
+
+void
+purple_tls_session_cache_prepare(PurpleTlsSessionCache *cache,
+                                 PurpleAccount *account,
+                                 GTlsClientConnection *connection)
+{
+	PurpleTlsSessionCacheEntry *entry = NULL;
+	GTlsClientConnection *source = NULL;
+	const gchar *account_id = NULL;
+	gchar *key = NULL;
+	gboolean offered = FALSE;
+
+	g_return_if_fail(PURPLE_IS_TLS_SESSION_CACHE(cache));
+	g_return_if_fail(PURPLE_IS_ACCOUNT(account));
+	g_return_if_fail(G_IS_TLS_CLIENT_CONNECTION(connection));
+
+	account_id = purple_contact_info_get_id(PURPLE_CONTACT_INFO(account));
+	key = purple_tls_session_cache_make_key(account_id, connection);
+	if(key == NULL) {
+		return;
+	}
+
+	entry = g_hash_table_lookup(cache->sessions, key);
+	if(entry != NULL && entry->expires <= g_get_monotonic_time()) {
+		g_hash_table_remove(cache->sessions, key);
+		entry = NULL;
+	}
+
+	if(entry != NULL) {
+		source = entry->connection != NULL ? entry->connection : entry->session;
+	}
+
+	if(source != NULL && source != connection) {
+		purple_debug_misc("tls-session-cache", "offering to resume %s", key);
+
+		g_tls_client_connection_copy_session_state(connection, source);
+		offered = TRUE;
+	}
+
+	g_object_set_data_full(G_OBJECT(connection), "purple-tls-session-account",
+	                       g_strdup(account_id), g_free);
+	g_object_set_data_full(G_OBJECT(connection), "purple-tls-session-key",
+	                       key, g_free);
+	g_object_set_data(G_OBJECT(connection), "purple-tls-session-offered",
+	                  GINT_TO_POINTER(offered));
+
+	g_signal_handlers_disconnect_by_func(connection,
+	                                     purple_tls_session_cache_protocol_version_cb,
+	                                     cache);
+	g_signal_connect_object(connection, "notify::protocol-version",
+	                        G_CALLBACK(purple_tls_session_cache_protocol_version_cb),
+	                        cache, 0);
+}
+
+void
+purple_tls_session_cache_clear(PurpleTlsSessionCache *cache,
+                               PurpleAccount *account)
+{
+	const gchar *account_id = NULL;
+
+	g_return_if_fail(PURPLE_IS_TLS_SESSION_CACHE(cache));
+	g_return_if_fail(account == NULL || PURPLE_IS_ACCOUNT(account));
+
+	if(account != NULL) {
+		account_id = purple_contact_info_get_id(PURPLE_CONTACT_INFO(account));
+	}
+
+	g_hash_table_foreach_remove(cache->sessions,
+	                            purple_tls_session_cache_entry_has_account,
+	                            (gpointer)account_id);
+}
+
+guint
+purple_tls_session_cache_get_resumable_handshakes(PurpleTlsSessionCache *cache)
+{
+	g_return_val_if_fail(PURPLE_IS_TLS_SESSION_CACHE(cache), 0);
+
+	return cache->resumable_handshakes;
+}
+
+guint
+purple_tls_session_cache_get_full_handshakes(PurpleTlsSessionCache *cache) {
+	g_return_val_if_fail(PURPLE_IS_TLS_SESSION_CACHE(cache), 0);
+
+	return cache->full_handshakes;
+}
@@ -0,0 +1,121 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(PURPLE_GLOBAL_HEADER_INSIDE) && !defined(PURPLE_COMPILATION)
+# error "only <purple.h> may be included directly"
+#endif
+
+#ifndef PURPLE_TLS_SESSION_CACHE_H
+#define PURPLE_TLS_SESSION_CACHE_H
+
+#include <glib.h>
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include "account.h"
+
+G_BEGIN_DECLS
+
+#define PURPLE_TYPE_TLS_SESSION_CACHE (purple_tls_session_cache_get_type())
+
+/**
+ * PurpleTlsSessionCache:
+ *
+ * #PurpleTlsSessionCache remembers the last TLS connection each account made
+ * to each server, so the next connection to that server can offer to resume
+ * its session instead of doing a full handshake.  This makes reconnecting
+ * and opening parallel connections to the same server cheaper for both ends.
+ *
+ * Connections made with a #GSocketClient from purple_gio_socket_client_new()
+ * use the cache automatically.  Connections that start TLS themselves, like
+ * STARTTLS, need to call purple_tls_session_cache_prepare() before the
+ * handshake.
+ *
+ * The cache only keeps a connection alive while its owner does.  Once the
+ * owner lets go of it, the session is copied to a connection without a socket
+ * and the real connection is released.
+ *
+ * Since: 3.0.0
+ */
+G_DECLARE_FINAL_TYPE(PurpleTlsSessionCache, purple_tls_session_cache, PURPLE,
+                     TLS_SESSION_CACHE, GObject)
+
+/**
+ * purple_tls_session_cache_get_default:
+ *
+ * Gets the default #PurpleTlsSessionCache instance.
+ *
+ * Returns: (transfer none): The default #PurpleTlsSessionCache instance.
+ *
+ * Since: 3.0.0
+ */
+PurpleTlsSessionCache *purple_tls_session_cache_get_default(void);
+
+/**
+ * purple_tls_session_cache_prepare:
+ * @cache: The instance.
+ * @account: The account that is connecting.
+ * @connection: The connection, before its handshake has started.
+ *
+ * Offers the session of the last connection @account made to the server
+ * identity of @connection, if there is one, and remembers @connection for
+ * the next time once its handshake is done.
+ *
+ * Since: 3.0.0
+ */
+void purple_tls_session_cache_prepare(PurpleTlsSessionCache *cache, PurpleAccount *account, GTlsClientConnection *connection);
+
+/**
+ * purple_tls_session_cache_clear:
+ * @cache: The instance.
+ * @account: (nullable): The account to forget, or %NULL for every account.
+ *
+ * Forgets the remembered sessions of @account.
+ *
+ * Since: 3.0.0
+ */
+void purple_tls_session_cache_clear(PurpleTlsSessionCache *cache, PurpleAccount *account);
+
+/**
+ * purple_tls_session_cache_get_resumable_handshakes:
+ * @cache: The instance.
+ *
+ * Gets the number of completed handshakes that offered a remembered session.
+ * The server may still have chosen to do a full handshake for some of them.
+ *
+ * Returns: The number of handshakes that offered to resume a session.
+ *
+ * Since: 3.0.0
+ */
+guint purple_tls_session_cache_get_resumable_handshakes(PurpleTlsSessionCache *cache);
+
+/**
+ * purple_tls_session_cache_get_full_handshakes:
+ * @cache: The instance.
+ *
+ * Gets the number of completed handshakes that had no session to offer.
+ *
+ * Returns: The number of full handshakes.
+ *
+ * Since: 3.0.0
+ */
+guint purple_tls_session_cache_get_full_handshakes(PurpleTlsSessionCache *cache);
+
+G_END_DECLS
+
+#endif /* PURPLE_TLS_SESSION_CACHE_H */
@@ -0,0 +1,2 @@
+CREATE INDEX message_log_message_id
+        ON message_log(protocol, account, conversation_id, message_id);
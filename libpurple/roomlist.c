@@ -19,6 +19,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301  USA
  */
 
+#include <string.h>
+
 #include "account.h"
 #include "connection.h"
 #include "debug.h"
@@ -33,8 +35,15 @@
  */
 typedef struct {
 	PurpleAccount *account;  /* The account this list belongs to. */
-	GList *rooms;            /* The list of rooms.                */
+	GListStore *rooms;       /* The list of rooms.                */
 	gboolean in_progress;    /* The listing is in progress.       */
+
+	GPtrArray *pending;      /* Rooms waiting for the next flush. */
+	guint flush_id;
+
+	gchar *filter;           /* Only keep rooms matching this.    */
+	GPatternSpec *pattern;
+	guint min_users;         /* Only keep rooms this busy.        */
 } PurpleRoomlistPrivate;
 
 /* Room list property enums */
@@ -43,13 +52,143 @@ enum
 	PROP_0,
 	PROP_ACCOUNT,
 	PROP_IN_PROGRESS,
+	PROP_FILTER,
+	PROP_MIN_USERS,
 	PROP_LAST
 };
 
+/* Rooms are added to the model in batches. A batch is flushed when it gets
+ * this big, when this many milliseconds have passed since the first room in
+ * it was added, or when the listing stops.
+ */
+#define PURPLE_ROOMLIST_BATCH_SIZE (1000)
+#define PURPLE_ROOMLIST_BATCH_INTERVAL (100)
+
 static GParamSpec *properties[PROP_LAST];
 static PurpleRoomlistUiOps *ops = NULL;
 
-G_DEFINE_TYPE_WITH_PRIVATE(PurpleRoomlist, purple_roomlist, G_TYPE_OBJECT);
+static void purple_roomlist_list_model_init(GListModelInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(PurpleRoomlist, purple_roomlist, G_TYPE_OBJECT,
+                        G_ADD_PRIVATE(PurpleRoomlist)
+                        G_IMPLEMENT_INTERFACE(G_TYPE_LIST_MODEL,
+                                              purple_roomlist_list_model_init))
+
+/**************************************************************************/
+/* Helpers                                                                */
+/**************************************************************************/
+
+static gboolean
+purple_roomlist_room_matches(PurpleRoomlistPrivate *priv,
+                             PurpleRoomlistRoom *room)
+{
+	if(priv->min_users > 0 &&
+	   purple_roomlist_room_get_user_count(room) < priv->min_users)
+	{
+		return FALSE;
+	}
+
+	if(priv->filter != NULL) {
+		const gchar *name = purple_roomlist_room_get_name(room);
+		gchar *folded = NULL;
+		gboolean ret = FALSE;
+
+		if(name == NULL) {
+			return FALSE;
+		}
+
+		folded = g_utf8_casefold(name, -1);
+		if(priv->pattern != NULL) {
+			ret = g_pattern_spec_match_string(priv->pattern, folded);
+		} else {
+			ret = (strstr(folded, priv->filter) != NULL);
+		}
+		g_free(folded);
+
+		return ret;
+	}
+
+	return TRUE;
+}
+
+static void
+purple_roomlist_flush(PurpleRoomlist *list) {
+	PurpleRoomlistPrivate *priv = purple_roomlist_get_instance_private(list);
+	guint position = 0;
+
+	g_clear_handle_id(&priv->flush_id, g_source_remove);
+
+	if(priv->pending == NULL || priv->pending->len == 0) {
+		return;
+	}
+
+	/* One splice means one items-changed for the whole batch. */
+	position = g_list_model_get_n_items(G_LIST_MODEL(priv->rooms));
+	g_list_store_splice(priv->rooms, position, 0, priv->pending->pdata,
+	                    priv->pending->len);
+
+	if(ops && ops->add_room) {
+		for(guint i = 0; i < priv->pending->len; i++) {
+			ops->add_room(list, g_ptr_array_index(priv->pending, i));
+		}
+	}
+
+	g_ptr_array_set_size(priv->pending, 0);
+}
+
+static gboolean
+purple_roomlist_flush_cb(gpointer data) {
+	PurpleRoomlist *list = data;
+	PurpleRoomlistPrivate *priv = purple_roomlist_get_instance_private(list);
+
+	priv->flush_id = 0;
+
+	purple_roomlist_flush(list);
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+purple_roomlist_rooms_changed_cb(G_GNUC_UNUSED GListModel *model,
+                                 guint position, guint removed, guint added,
+                                 gpointer data)
+{
+	g_list_model_items_changed(G_LIST_MODEL(data), position, removed, added);
+}
+
+/**************************************************************************/
+/* GListModel Implementation                                              */
+/**************************************************************************/
+
+static GType
+purple_roomlist_get_item_type(G_GNUC_UNUSED GListModel *model) {
+	return PURPLE_TYPE_ROOMLIST_ROOM;
+}
+
+static guint
+purple_roomlist_get_n_items(GListModel *model) {
+	PurpleRoomlistPrivate *priv = NULL;
+
+	priv = purple_roomlist_get_instance_private(PURPLE_ROOMLIST(model));
+
+	return g_list_model_get_n_items(G_LIST_MODEL(priv->rooms));
+}
+
+static gpointer
+purple_roomlist_get_item(GListModel *model, guint position) {
+	PurpleRoomlistPrivate *priv = NULL;
+
+	priv = purple_roomlist_get_instance_private(PURPLE_ROOMLIST(model));
+
+	return g_list_model_get_item(G_LIST_MODEL(priv->rooms), position);
+}
+
+static void
+purple_roomlist_list_model_init(GListModelInterface *iface) {
+	iface->get_item_type = purple_roomlist_get_item_type;
+	iface->get_n_items = purple_roomlist_get_n_items;
+	iface->get_item = purple_roomlist_get_item;
+}
 
 /**************************************************************************/
 /* Room List API                                                          */
@@ -80,6 +219,11 @@ void purple_roomlist_set_in_progress(PurpleRoomlist *list, gboolean in_progress)
 	priv = purple_roomlist_get_instance_private(list);
 	priv->in_progress = in_progress;
 
+	/* Don't leave the tail of the listing waiting on the timer. */
+	if(!in_progress) {
+		purple_roomlist_flush(list);
+	}
+
 	g_object_notify_by_pspec(G_OBJECT(list), properties[PROP_IN_PROGRESS]);
 }
 
@@ -98,13 +242,81 @@ void purple_roomlist_room_add(PurpleRoomlist *list, PurpleRoomlistRoom *room)
 	PurpleRoomlistPrivate *priv = NULL;
 
 	g_return_if_fail(PURPLE_IS_ROOMLIST(list));
-	g_return_if_fail(room != NULL);
+	g_return_if_fail(PURPLE_IS_ROOMLIST_ROOM(room));
 
 	priv = purple_roomlist_get_instance_private(list);
-	priv->rooms = g_list_append(priv->rooms, room);
 
-	if (ops && ops->add_room)
-		ops->add_room(list, room);
+	/* Protocols that can't filter on the server still get the query applied
+	 * here, so the UI never sees rooms it didn't ask for.
+	 */
+	if(!purple_roomlist_room_matches(priv, room)) {
+		return;
+	}
+
+	g_ptr_array_add(priv->pending, g_object_ref(room));
+
+	if(priv->pending->len >= PURPLE_ROOMLIST_BATCH_SIZE) {
+		purple_roomlist_flush(list);
+	} else if(priv->flush_id == 0) {
+		priv->flush_id = g_timeout_add(PURPLE_ROOMLIST_BATCH_INTERVAL,
+		                               purple_roomlist_flush_cb, list);
+	}
+}
+
+void
+purple_roomlist_set_filter(PurpleRoomlist *list, const gchar *filter) {
+	PurpleRoomlistPrivate *priv = NULL;
+
+	g_return_if_fail(PURPLE_IS_ROOMLIST(list));
+
+	priv = purple_roomlist_get_instance_private(list);
+
+	g_clear_pointer(&priv->filter, g_free);
+	g_clear_pointer(&priv->pattern, g_pattern_spec_free);
+
+	if(filter != NULL && *filter != '\0') {
+		priv->filter = g_utf8_casefold(filter, -1);
+
+		if(strpbrk(priv->filter, "*?") != NULL) {
+			priv->pattern = g_pattern_spec_new(priv->filter);
+		}
+	}
+
+	g_object_notify_by_pspec(G_OBJECT(list), properties[PROP_FILTER]);
+}
+
+const gchar *
+purple_roomlist_get_filter(PurpleRoomlist *list) {
+	PurpleRoomlistPrivate *priv = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_ROOMLIST(list), NULL);
+
+	priv = purple_roomlist_get_instance_private(list);
+
+	return priv->filter;
+}
+
+void
+purple_roomlist_set_min_users(PurpleRoomlist *list, guint min_users) {
+	PurpleRoomlistPrivate *priv = NULL;
+
+	g_return_if_fail(PURPLE_IS_ROOMLIST(list));
+
+	priv = purple_roomlist_get_instance_private(list);
+	priv->min_users = min_users;
+
+	g_object_notify_by_pspec(G_OBJECT(list), properties[PROP_MIN_USERS]);
+}
+
+guint
+purple_roomlist_get_min_users(PurpleRoomlist *list) {
+	PurpleRoomlistPrivate *priv = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_ROOMLIST(list), 0);
+
+	priv = purple_roomlist_get_instance_private(list);
+
+	return priv->min_users;
 }
 
 PurpleRoomlist *purple_roomlist_get_list(PurpleConnection *gc)
@@ -124,6 +336,36 @@ PurpleRoomlist *purple_roomlist_get_list(PurpleConnection *gc)
 	return NULL;
 }
 
+PurpleRoomlist *
+purple_roomlist_query(PurpleConnection *gc, const gchar *filter,
+                      guint min_users)
+{
+	PurpleProtocol *protocol = NULL;
+	PurpleRoomlist *list = NULL;
+
+	g_return_val_if_fail(PURPLE_IS_CONNECTION(gc), NULL);
+	g_return_val_if_fail(PURPLE_CONNECTION_IS_CONNECTED(gc), NULL);
+
+	protocol = purple_connection_get_protocol(gc);
+
+	/* A protocol that takes the query sets up the list's filter itself, as
+	 * the server's idea of a match may not be ours. */
+	if(PURPLE_PROTOCOL_IMPLEMENTS(protocol, ROOMLIST, query_list)) {
+		list = purple_protocol_roomlist_query_list(PURPLE_PROTOCOL_ROOMLIST(protocol),
+		                                           gc, filter, min_users);
+	} else if(PURPLE_IS_PROTOCOL_ROOMLIST(protocol)) {
+		list = purple_protocol_roomlist_get_list(PURPLE_PROTOCOL_ROOMLIST(protocol),
+		                                         gc);
+
+		if(PURPLE_IS_ROOMLIST(list)) {
+			purple_roomlist_set_filter(list, filter);
+			purple_roomlist_set_min_users(list, min_users);
+		}
+	}
+
+	return list;
+}
+
 void purple_roomlist_cancel_get_list(PurpleRoomlist *list)
 {
 	PurpleRoomlistPrivate *priv = NULL;
@@ -201,6 +443,12 @@ purple_roomlist_set_property(GObject *obj, guint param_id, const GValue *value,
 		case PROP_IN_PROGRESS:
 			purple_roomlist_set_in_progress(list, g_value_get_boolean(value));
 			break;
+		case PROP_FILTER:
+			purple_roomlist_set_filter(list, g_value_get_string(value));
+			break;
+		case PROP_MIN_USERS:
+			purple_roomlist_set_min_users(list, g_value_get_uint(value));
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, param_id, pspec);
 			break;
@@ -221,6 +469,12 @@ purple_roomlist_get_property(GObject *obj, guint param_id, GValue *value,
 		case PROP_IN_PROGRESS:
 			g_value_set_boolean(value, purple_roomlist_get_in_progress(list));
 			break;
+		case PROP_FILTER:
+			g_value_set_string(value, purple_roomlist_get_filter(list));
+			break;
+		case PROP_MIN_USERS:
+			g_value_set_uint(value, purple_roomlist_get_min_users(list));
+			break;
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, param_id, pspec);
 			break;
@@ -228,8 +482,16 @@ purple_roomlist_get_property(GObject *obj, guint param_id, GValue *value,
 }
 
 static void
-purple_roomlist_init(G_GNUC_UNUSED PurpleRoomlist *list)
+purple_roomlist_init(PurpleRoomlist *list)
 {
+	PurpleRoomlistPrivate *priv = purple_roomlist_get_instance_private(list);
+
+	priv->rooms = g_list_store_new(PURPLE_TYPE_ROOMLIST_ROOM);
+	g_signal_connect_object(priv->rooms, "items-changed",
+	                        G_CALLBACK(purple_roomlist_rooms_changed_cb), list,
+	                        0);
+
+	priv->pending = g_ptr_array_new_with_free_func(g_object_unref);
 }
 
 /* Called when done constructing */
@@ -254,7 +516,12 @@ purple_roomlist_finalize(GObject *object)
 
 	purple_debug_misc("roomlist", "destroying list %p\n", list);
 
-	g_list_free_full(priv->rooms, g_object_unref);
+	g_clear_handle_id(&priv->flush_id, g_source_remove);
+	g_clear_pointer(&priv->pending, g_ptr_array_unref);
+	g_clear_object(&priv->rooms);
+
+	g_clear_pointer(&priv->filter, g_free);
+	g_clear_pointer(&priv->pattern, g_pattern_spec_free);
 
 	G_OBJECT_CLASS(purple_roomlist_parent_class)->finalize(object);
 }
@@ -283,6 +550,31 @@ purple_roomlist_class_init(PurpleRoomlistClass *klass)
 				"Whether the room list is being fetched.", FALSE,
 				G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+	/**
+	 * PurpleRoomlist:filter:
+	 *
+	 * Only rooms whose name contains this string, or matches it if it
+	 * contains `*` or `?` wildcards, are added to the list. The comparison
+	 * is case insensitive.
+	 *
+	 * Since: 3.0.0
+	 */
+	properties[PROP_FILTER] = g_param_spec_string("filter", "filter",
+				"Only list rooms whose name matches this.", NULL,
+				G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+	/**
+	 * PurpleRoomlist:min-users:
+	 *
+	 * Only rooms with at least this many users are added to the list.
+	 *
+	 * Since: 3.0.0
+	 */
+	properties[PROP_MIN_USERS] = g_param_spec_uint("min-users", "min-users",
+				"Only list rooms with at least this many users.",
+				0, G_MAXUINT, 0,
+				G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
 	g_object_class_install_properties(obj_class, PROP_LAST, properties);
 }
 
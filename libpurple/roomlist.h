@@ -87,6 +87,9 @@ struct _PurpleRoomlistUiOps {
  * PurpleRoomlist:
  *
  * Represents a list of rooms for a given connection on a given protocol.
+ *
+ * It implements #GListModel with an item type of #PurpleRoomlistRoom, so user
+ * interfaces can display it directly.
  */
 struct _PurpleRoomlist {
 	GObject gparent;
@@ -180,13 +183,65 @@ gboolean purple_roomlist_get_in_progress(PurpleRoomlist *list);
 /**
  * purple_roomlist_room_add:
  * @list: The room list.
- * @room: The room to add to the list. The GList of fields must be in the same
-               order as was given in purple_roomlist_set_fields().
+ * @room: (transfer none): The room to add to the list.
  *
  * Adds a room to the list of them.
+ *
+ * Rooms that don't match [property@Purple.Roomlist:filter] or
+ * [property@Purple.Roomlist:min-users] are dropped. The rest are added to the
+ * list in batches, so #GListModel::items-changed is emitted once per batch
+ * rather than once per room.
 */
 void purple_roomlist_room_add(PurpleRoomlist *list, PurpleRoomlistRoom *room);
 
+/**
+ * purple_roomlist_set_filter:
+ * @list: The room list.
+ * @filter: (nullable): The filter to apply.
+ *
+ * Sets the filter that room names must match to be added to @list. If
+ * @filter contains `*` or `?` it is treated as a wildcard pattern, otherwise
+ * names only need to contain it. Matching is case insensitive.
+ *
+ * Since: 3.0.0
+ */
+void purple_roomlist_set_filter(PurpleRoomlist *list, const gchar *filter);
+
+/**
+ * purple_roomlist_get_filter:
+ * @list: The room list.
+ *
+ * Gets the filter that room names must match to be added to @list.
+ *
+ * Returns: (nullable): The case folded filter or %NULL.
+ *
+ * Since: 3.0.0
+ */
+const gchar *purple_roomlist_get_filter(PurpleRoomlist *list);
+
+/**
+ * purple_roomlist_set_min_users:
+ * @list: The room list.
+ * @min_users: The minimum number of users.
+ *
+ * Sets the minimum number of users a room must have to be added to @list.
+ *
+ * Since: 3.0.0
+ */
+void purple_roomlist_set_min_users(PurpleRoomlist *list, guint min_users);
+
+/**
+ * purple_roomlist_get_min_users:
+ * @list: The room list.
+ *
+ * Gets the minimum number of users a room must have to be added to @list.
+ *
+ * Returns: The minimum number of users.
+ *
+ * Since: 3.0.0
+ */
+guint purple_roomlist_get_min_users(PurpleRoomlist *list);
+
 /**
  * purple_roomlist_get_list:
  * @gc: The PurpleConnection to have get a list.
@@ -199,6 +254,23 @@ void purple_roomlist_room_add(PurpleRoomlist *list, PurpleRoomlistRoom *room);
  */
 PurpleRoomlist *purple_roomlist_get_list(PurpleConnection *gc);
 
+/**
+ * purple_roomlist_query:
+ * @gc: The PurpleConnection to have get a list.
+ * @filter: (nullable): Only list rooms whose name matches this.
+ * @min_users: Only list rooms with at least this many users.
+ *
+ * Like purple_roomlist_get_list(), but only asks for the rooms matching
+ * @filter and @min_users. Protocols that can filter on the server do so,
+ * for everything else the filter is applied as rooms are added.
+ *
+ * Returns: (transfer full): A PurpleRoomlist* or %NULL if the protocol doesn't
+ *          support that.
+ *
+ * Since: 3.0.0
+ */
+PurpleRoomlist *purple_roomlist_query(PurpleConnection *gc, const gchar *filter, guint min_users);
+
 /**
  * purple_roomlist_cancel_get_list:
  * @list: The room list to cancel a get_list on.
@@ -310,6 +310,14 @@ int purple_serv_chat_send(PurpleConnection *gc, int id, PurpleMessage *msg)
  */
 void purple_serv_got_im(PurpleConnection *gc, const char *who, const char *msg,
 				 PurpleMessageFlags flags, time_t mtime)
+{
+	purple_serv_got_im_with_id(gc, who, msg, flags, mtime, NULL);
+}
+
+void
+purple_serv_got_im_with_id(PurpleConnection *gc, const char *who,
+                           const char *msg, PurpleMessageFlags flags,
+                           time_t mtime, const char *id)
 {
 	PurpleAccount *account;
 	PurpleConversation *im;
@@ -378,6 +386,7 @@ void purple_serv_got_im(PurpleConnection *gc, const char *who, const char *msg,
 	}
 
 	pmsg = purple_message_new_incoming(account, name, message, flags, mtime);
+	purple_message_set_id(pmsg, id);
 	purple_conversation_write_message(im, pmsg);
 	g_free(message);
 	g_object_unref(G_OBJECT(pmsg));
@@ -589,6 +598,14 @@ void purple_serv_got_join_chat_failed(PurpleConnection *gc, GHashTable *data)
 
 void purple_serv_got_chat_in(PurpleConnection *g, int id, const char *who,
 					  PurpleMessageFlags flags, const char *message, time_t mtime)
+{
+	purple_serv_got_chat_in_with_id(g, id, who, flags, message, mtime, NULL);
+}
+
+void
+purple_serv_got_chat_in_with_id(PurpleConnection *g, int id, const char *who,
+                                PurpleMessageFlags flags, const char *message,
+                                time_t mtime, const char *message_id)
 {
 	GSList *bcs;
 	PurpleChatConversation *chat = NULL;
@@ -665,6 +682,7 @@ void purple_serv_got_chat_in(PurpleConnection *g, int id, const char *who,
 		purple_message_set_timestamp(pmsg, dt);
 		g_date_time_unref(dt);
 	}
+	purple_message_set_id(pmsg, message_id);
 	purple_conversation_write_message(PURPLE_CONVERSATION(chat), pmsg);
 
 	g_free(angel);
@@ -201,6 +201,22 @@ void purple_serv_got_typing_stopped(PurpleConnection *gc, const char *name);
 void purple_serv_got_im(PurpleConnection *gc, const char *who, const char *msg,
 				 PurpleMessageFlags flags, time_t mtime);
 
+/**
+ * purple_serv_got_im_with_id:
+ * @gc:     The connection on which the message was received.
+ * @who:    The username of the buddy that sent the message.
+ * @msg:    The actual message received.
+ * @flags:  The flags applicable to this message.
+ * @mtime:  The timestamp of the message.
+ * @id:     (nullable): The id the server gave the message.
+ *
+ * Like purple_serv_got_im(), but also sets the id of the message, so the
+ * history can recognize it if the server sends it again.
+ *
+ * Since: 3.0.0
+ */
+void purple_serv_got_im_with_id(PurpleConnection *gc, const char *who, const char *msg, PurpleMessageFlags flags, time_t mtime, const char *id);
+
 /**
  * purple_serv_join_chat:
  * @gc:   The #PurpleConnection
@@ -280,6 +296,23 @@ void purple_serv_got_chat_left(PurpleConnection *g, int id);
 void purple_serv_got_chat_in(PurpleConnection *g, int id, const char *who,
 					  PurpleMessageFlags flags, const char *message, time_t mtime);
 
+/**
+ * purple_serv_got_chat_in_with_id:
+ * @g:          The connection on which the message was received.
+ * @id:         The id of the chat, as assigned by the protocol.
+ * @who:        The name of the user who sent the message.
+ * @flags:      The flags of the message.
+ * @message:    The message received in the chat.
+ * @mtime:      The time when the message was received.
+ * @message_id: (nullable): The id the server gave the message.
+ *
+ * Like purple_serv_got_chat_in(), but also sets the id of the message, so the
+ * history can recognize it if the server sends it again.
+ *
+ * Since: 3.0.0
+ */
+void purple_serv_got_chat_in_with_id(PurpleConnection *g, int id, const char *who, PurpleMessageFlags flags, const char *message, time_t mtime, const char *message_id);
+
 /**
  * purple_serv_send_file:
  * @gc:     The connection on which the message was received.
@@ -68,6 +68,111 @@ test_purple_avatar_new_animated(void) {
 	g_clear_object(&avatar);
 }
 
+static void
+test_purple_avatar_new_from_bytes(void) {
+	PurpleAvatar *avatar = NULL;
+	GdkPixbuf *pixbuf = NULL;
+	GBytes *data = NULL;
+	GError *error = NULL;
+	const char *resource = "/im/pidgin/libpurple/tests/avatar/static.png";
+
+	data = g_resources_lookup_data(resource, G_RESOURCE_LOOKUP_FLAGS_NONE,
+	                               &error);
+	g_assert_no_error(error);
+
+	avatar = purple_avatar_new_from_bytes(data);
+	g_assert_true(PURPLE_IS_AVATAR(avatar));
+	g_assert_true(purple_avatar_get_data(avatar) == data);
+
+	g_assert_false(purple_avatar_get_animated(avatar));
+
+	pixbuf = purple_avatar_get_pixbuf(avatar);
+	g_assert_true(GDK_IS_PIXBUF(pixbuf));
+
+	g_clear_object(&avatar);
+	g_bytes_unref(data);
+}
+
+static void
+test_purple_avatar_pixbuf_for_size(void) {
+	PurpleAvatar *avatar = NULL;
+	GdkPixbuf *pixbuf1 = NULL;
+	GdkPixbuf *pixbuf2 = NULL;
+	GBytes *data = NULL;
+	GError *error = NULL;
+	const char *resource = "/im/pidgin/libpurple/tests/avatar/static.png";
+
+	data = g_resources_lookup_data(resource, G_RESOURCE_LOOKUP_FLAGS_NONE,
+	                               &error);
+	g_assert_no_error(error);
+
+	avatar = purple_avatar_new_from_bytes(data);
+
+	pixbuf1 = purple_avatar_get_pixbuf_for_size(avatar, 8);
+	g_assert_true(GDK_IS_PIXBUF(pixbuf1));
+	g_assert_cmpint(gdk_pixbuf_get_width(pixbuf1), <=, 8);
+	g_assert_cmpint(gdk_pixbuf_get_height(pixbuf1), <=, 8);
+
+	/* The second request should be served from the cache. */
+	pixbuf2 = purple_avatar_get_pixbuf_for_size(avatar, 8);
+	g_assert_true(pixbuf1 == pixbuf2);
+
+	g_clear_object(&pixbuf1);
+	g_clear_object(&pixbuf2);
+	g_clear_object(&avatar);
+	g_bytes_unref(data);
+}
+
+static void
+test_purple_avatar_pixbuf_owned(void) {
+	PurpleAvatar *avatar = NULL;
+	GdkPixbuf *pixbuf = NULL;
+	GdkPixbuf *sized = NULL;
+	GBytes *data = NULL;
+	GError *error = NULL;
+	const char *resource = "/im/pidgin/libpurple/tests/avatar/static.png";
+
+	data = g_resources_lookup_data(resource, G_RESOURCE_LOOKUP_FLAGS_NONE,
+	                               &error);
+	g_assert_no_error(error);
+
+	avatar = purple_avatar_new_from_bytes(data);
+
+	pixbuf = purple_avatar_get_pixbuf(avatar);
+	g_assert_true(GDK_IS_PIXBUF(pixbuf));
+	g_object_add_weak_pointer(G_OBJECT(pixbuf), (gpointer *)&pixbuf);
+
+	/* Decoding other avatars must not take the full sized image away from a
+	 * caller that didn't take a reference.
+	 */
+	for(int i = 0; i < 16; i++) {
+		PurpleAvatar *other = purple_avatar_new_from_bytes(data);
+
+		g_clear_object(&sized);
+		sized = purple_avatar_get_pixbuf_for_size(other, 8);
+		g_assert_true(GDK_IS_PIXBUF(sized));
+
+		g_clear_object(&other);
+	}
+	g_clear_object(&sized);
+
+	g_assert_nonnull(pixbuf);
+	g_assert_true(purple_avatar_get_pixbuf(avatar) == pixbuf);
+
+	sized = purple_avatar_get_pixbuf_for_size(avatar, 8);
+	g_assert_true(GDK_IS_PIXBUF(sized));
+	g_object_add_weak_pointer(G_OBJECT(sized), (gpointer *)&sized);
+	g_object_unref(sized);
+	g_assert_nonnull(sized);
+
+	/* Both go away with the avatar. */
+	g_clear_object(&avatar);
+	g_assert_null(pixbuf);
+	g_assert_null(sized);
+
+	g_bytes_unref(data);
+}
+
 /******************************************************************************
  * Main
  *****************************************************************************/
@@ -79,6 +184,12 @@ main(gint argc, gchar *argv[]) {
 	                test_purple_avatar_new_static);
 	g_test_add_func("/avatar/new/animated",
 	                test_purple_avatar_new_animated);
+	g_test_add_func("/avatar/new/from-bytes",
+	                test_purple_avatar_new_from_bytes);
+	g_test_add_func("/avatar/pixbuf-for-size",
+	                test_purple_avatar_pixbuf_for_size);
+	g_test_add_func("/avatar/pixbuf-owned",
+	                test_purple_avatar_pixbuf_owned);
 
 	return g_test_run();
 }
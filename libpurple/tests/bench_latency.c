@@ -0,0 +1,45 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "bench_latency.h"
+
+static gint
+bench_latency_compare(gconstpointer a, gconstpointer b) {
+	gint64 la = *(const gint64 *)a;
+	gint64 lb = *(const gint64 *)b;
+
+	return (la > lb) - (la < lb);
+}
+
+void
+bench_latency_sort(GArray *latencies) {
+	g_array_sort(latencies, bench_latency_compare);
+}
+
+gdouble
+bench_latency_percentile(GArray *sorted, gdouble pct) {
+	guint index = 0;
+
+	if(sorted->len == 0) {
+		return 0.0;
+	}
+
+	index = MIN((guint)(pct / 100.0 * sorted->len), sorted->len - 1);
+
+	return g_array_index(sorted, gint64, index) / 1000.0;
+}
@@ -0,0 +1,34 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PURPLE_BENCH_LATENCY_H
+#define PURPLE_BENCH_LATENCY_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Sorts an array of gint64 latencies in microseconds. */
+void bench_latency_sort(GArray *latencies);
+
+/* Returns the pct percentile of sorted in milliseconds. */
+gdouble bench_latency_percentile(GArray *sorted, gdouble pct);
+
+G_END_DECLS
+
+#endif /* PURPLE_BENCH_LATENCY_H */
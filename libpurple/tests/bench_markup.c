@@ -0,0 +1,144 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Runs the markup functions that incoming messages go through over a corpus
+ * of chat HTML, the way the various protocols send it, and reports the
+ * throughput of each one and of the usual receive pipeline.
+ *
+ * Only the public API is used, so to compare against an older libpurple,
+ * build this file against that tree and run both on the same machine.
+ */
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <purple.h>
+
+#define N_ROUNDS (20 * 1000)
+
+static const char *corpus[] = {
+	/* plain text, by far the most common */
+	"hey, are you around?",
+	"yeah, give me five minutes, I'm finishing up a build",
+	"ok :)",
+	"I pushed the fix for the roomlist crash last night, can you take a look before the release goes out?",
+	/* links */
+	"did you see http://pidgin.im/news/ yet?",
+	"logs are at https://example.com/builds/1234/log.txt (the second one failed)",
+	"try www.example.org or mail support@example.org.",
+	/* formatting from the old AIM and Yahoo clients */
+	"<HTML><BODY BGCOLOR=\"#ffffff\"><FONT FACE=\"Arial\" SIZE=2 COLOR=\"#000080\">brb</FONT></BODY></HTML>",
+	"<font color=\"#ff0000\"><b>URGENT:</b></font> server is down again &amp; nobody is answering",
+	"<i>sigh</i> &lt;3 you guys &quot;fixed&quot; it again",
+	/* XHTML-IM and Gadu-Gadu style */
+	"<span style='font-weight: bold;'>bold</span> and <span style='font-style: italic;'>italic</span>",
+	"<p>first paragraph</p><p>second paragraph with a <a href=\"https://example.com/\">link</a></p>",
+	"line one<br>line two<br/>line three<br />line four",
+	/* things that aren't tags at all */
+	"if x < y && y > z then swap <them>",
+	"<unknown attr='x'>what is this</unknown> &#8364;5 &copy; 2023",
+};
+
+static gsize
+corpus_bytes(void) {
+	gsize total = 0;
+
+	for(gsize i = 0; i < G_N_ELEMENTS(corpus); i++) {
+		total += strlen(corpus[i]);
+	}
+
+	return total * N_ROUNDS;
+}
+
+static void
+report(const gchar *name, gint64 elapsed) {
+	gdouble seconds = (gdouble)elapsed / G_USEC_PER_SEC;
+	gdouble messages = (gdouble)G_N_ELEMENTS(corpus) * N_ROUNDS;
+
+	g_print("%-14s %12.0f messages/s %8.1f MiB/s\n", name, messages / seconds,
+	        corpus_bytes() / seconds / (1024 * 1024));
+}
+
+typedef void (*BenchToXhtmlFunc)(const char *html, char **xhtml, char **plain);
+typedef char *(*BenchStringFunc)(const char *text);
+
+static void
+bench_html_to_xhtml(const gchar *name, BenchToXhtmlFunc html_to_xhtml) {
+	gint64 start = g_get_monotonic_time();
+
+	for(gint round = 0; round < N_ROUNDS; round++) {
+		for(gsize i = 0; i < G_N_ELEMENTS(corpus); i++) {
+			char *xhtml = NULL, *plain = NULL;
+
+			html_to_xhtml(corpus[i], &xhtml, &plain);
+			g_free(xhtml);
+			g_free(plain);
+		}
+	}
+
+	report(name, g_get_monotonic_time() - start);
+}
+
+static void
+bench_string(const gchar *name, BenchStringFunc func) {
+	gint64 start = g_get_monotonic_time();
+
+	for(gint round = 0; round < N_ROUNDS; round++) {
+		for(gsize i = 0; i < G_N_ELEMENTS(corpus); i++) {
+			g_free(func(corpus[i]));
+		}
+	}
+
+	report(name, g_get_monotonic_time() - start);
+}
+
+/* What a received message goes through: converted to XHTML and plain text
+ * for the UI and the logs, and then linkified for display.
+ */
+static void
+bench_pipeline(const gchar *name, BenchToXhtmlFunc html_to_xhtml,
+               BenchStringFunc linkify)
+{
+	gint64 start = g_get_monotonic_time();
+
+	for(gint round = 0; round < N_ROUNDS; round++) {
+		for(gsize i = 0; i < G_N_ELEMENTS(corpus); i++) {
+			char *xhtml = NULL, *plain = NULL;
+
+			html_to_xhtml(corpus[i], &xhtml, &plain);
+			g_free(linkify(xhtml));
+			g_free(xhtml);
+			g_free(plain);
+		}
+	}
+
+	report(name, g_get_monotonic_time() - start);
+}
+
+gint
+main(G_GNUC_UNUSED gint argc, G_GNUC_UNUSED gchar *argv[]) {
+	bench_html_to_xhtml("html_to_xhtml", purple_markup_html_to_xhtml);
+	bench_string("strip_html", purple_markup_strip_html);
+	bench_string("linkify", purple_markup_linkify);
+	bench_string("unescape_html", purple_unescape_html);
+	bench_pipeline("pipeline", purple_markup_html_to_xhtml,
+	               purple_markup_linkify);
+
+	return 0;
+}
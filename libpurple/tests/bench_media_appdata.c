@@ -0,0 +1,213 @@
+/*
+ * Purple
+ *
+ * Purple is the legal property of its developers, whose names are too
+ * numerous to list here. Please refer to the COPYRIGHT file distributed
+ * with this source distribution
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA
+ */
+
+/* Loopback throughput of the PurpleMediaManager application data API. The
+ * manager's application source for a session is linked straight to its
+ * application sink, and chunks are pushed through once with the copying
+ * functions and once with the GBytes ones.
+ */
+
+#include <glib.h>
+
+#include <purple.h>
+
+#include "test_ui.h"
+
+#define CHUNK_SIZE (64 * 1024)
+#define N_CHUNKS (16 * 1024)
+
+#define BENCH_SESSION "bench"
+#define BENCH_PARTICIPANT "bench"
+
+typedef struct {
+	PurpleMediaManager *manager;
+	PurpleMedia *media;
+	GstElement *src;
+	GstElement *sink;
+} Loopback;
+
+static void
+loopback_init(Loopback *loopback) {
+	GstElement *pipeline = NULL;
+
+	loopback->manager = purple_media_manager_get();
+	loopback->media = g_object_new(PURPLE_TYPE_MEDIA,
+	                               "manager", loopback->manager,
+	                               NULL);
+
+	loopback->src = purple_media_manager_get_element(loopback->manager,
+	                                                 PURPLE_MEDIA_SEND_APPLICATION,
+	                                                 loopback->media,
+	                                                 BENCH_SESSION,
+	                                                 BENCH_PARTICIPANT);
+	loopback->sink = purple_media_manager_get_element(loopback->manager,
+	                                                  PURPLE_MEDIA_RECV_APPLICATION,
+	                                                  loopback->media,
+	                                                  BENCH_SESSION,
+	                                                  BENCH_PARTICIPANT);
+
+	/* Keep the sender from running arbitrarily far ahead of the receiver. */
+	g_object_set(loopback->src, "max-bytes", (guint64)(4 * CHUNK_SIZE),
+	             "block", TRUE, NULL);
+	g_object_set(loopback->sink, "sync", FALSE, "max-buffers", 4, NULL);
+
+	pipeline = purple_media_manager_get_pipeline(loopback->manager);
+	gst_bin_add(GST_BIN(pipeline), loopback->sink);
+	gst_element_link(loopback->src, loopback->sink);
+	gst_element_sync_state_with_parent(loopback->sink);
+	gst_element_sync_state_with_parent(loopback->src);
+
+	/* Stand in for the backend connecting the session. */
+	g_signal_emit_by_name(loopback->media, "candidate-pair-established",
+	                      BENCH_SESSION, BENCH_PARTICIPANT, NULL, NULL);
+}
+
+static void
+loopback_clear(Loopback *loopback) {
+	GstElement *pipeline = NULL;
+
+	pipeline = purple_media_manager_get_pipeline(loopback->manager);
+
+	/* Unlinking the sink takes the source out of the pipeline as well. */
+	gst_element_set_state(loopback->sink, GST_STATE_NULL);
+	gst_bin_remove(GST_BIN(pipeline), loopback->sink);
+	gst_object_unref(loopback->src);
+
+	g_clear_object(&loopback->media);
+}
+
+static gpointer
+push_copy(gpointer data) {
+	Loopback *loopback = data;
+	guint8 *chunk = g_malloc0(CHUNK_SIZE);
+
+	for(gint i = 0; i < N_CHUNKS; i++) {
+		purple_media_manager_send_application_data(loopback->manager,
+		                                           loopback->media,
+		                                           BENCH_SESSION,
+		                                           BENCH_PARTICIPANT,
+		                                           chunk, CHUNK_SIZE,
+		                                           FALSE);
+	}
+
+	g_free(chunk);
+
+	return NULL;
+}
+
+static gpointer
+push_bytes(gpointer data) {
+	Loopback *loopback = data;
+	GBytes *chunk = g_bytes_new_take(g_malloc0(CHUNK_SIZE), CHUNK_SIZE);
+
+	for(gint i = 0; i < N_CHUNKS; i++) {
+		purple_media_manager_send_application_bytes(loopback->manager,
+		                                            loopback->media,
+		                                            BENCH_SESSION,
+		                                            BENCH_PARTICIPANT,
+		                                            chunk, FALSE);
+	}
+
+	g_bytes_unref(chunk);
+
+	return NULL;
+}
+
+static gsize
+pull_copy(Loopback *loopback) {
+	guint8 *chunk = g_malloc(CHUNK_SIZE);
+	gsize total = 0;
+
+	while(total < (gsize)N_CHUNKS * CHUNK_SIZE) {
+		gint read = 0;
+
+		read = purple_media_manager_receive_application_data(loopback->manager,
+		                                                     loopback->media,
+		                                                     BENCH_SESSION,
+		                                                     BENCH_PARTICIPANT,
+		                                                     chunk, CHUNK_SIZE,
+		                                                     TRUE);
+		if(read <= 0) {
+			break;
+		}
+
+		total += read;
+	}
+
+	g_free(chunk);
+
+	return total;
+}
+
+static gsize
+pull_bytes(Loopback *loopback) {
+	gsize total = 0;
+
+	while(total < (gsize)N_CHUNKS * CHUNK_SIZE) {
+		GBytes *bytes = NULL;
+
+		bytes = purple_media_manager_receive_application_bytes(
+			loopback->manager, loopback->media, BENCH_SESSION,
+			BENCH_PARTICIPANT, TRUE);
+		if(bytes == NULL) {
+			break;
+		}
+
+		total += g_bytes_get_size(bytes);
+		g_bytes_unref(bytes);
+	}
+
+	return total;
+}
+
+static void
+run(const gchar *name, GThreadFunc push, gsize (*pull)(Loopback *)) {
+	Loopback loopback;
+	GThread *pusher = NULL;
+	GTimer *timer = NULL;
+	gdouble elapsed = 0.0;
+	gsize total = 0;
+
+	loopback_init(&loopback);
+
+	timer = g_timer_new();
+	pusher = g_thread_new(name, push, &loopback);
+	total = pull(&loopback);
+	g_thread_join(pusher);
+	elapsed = g_timer_elapsed(timer, NULL);
+	g_timer_destroy(timer);
+
+	loopback_clear(&loopback);
+
+	g_print("%-6s %" G_GSIZE_FORMAT " bytes in %.3fs (%.1f MiB/s)\n", name,
+	        total, elapsed, total / elapsed / (1024.0 * 1024.0));
+}
+
+gint
+main(G_GNUC_UNUSED gint argc, G_GNUC_UNUSED gchar **argv) {
+	test_ui_purple_init();
+
+	run("copy", push_copy, pull_copy);
+	run("bytes", push_bytes, pull_bytes);
+
+	return 0;
+}
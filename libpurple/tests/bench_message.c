@@ -0,0 +1,156 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Creates a busy channel's worth of messages, once one at a time through
+ * g_object_new() like protocols historically did and once through
+ * purple_message_new_batch(), and reports messages per second and heap bytes
+ * per message for both.
+ */
+
+#include <glib.h>
+
+#if defined(__GLIBC__)
+# include <malloc.h>
+#endif
+
+#include <purple.h>
+
+#define N_MESSAGES (200 * 1000)
+#define N_AUTHORS (50)
+
+static gchar *authors[N_AUTHORS];
+
+static gsize
+heap_in_use(void) {
+#if defined(__GLIBC__) && defined(__GLIBC_PREREQ)
+# if __GLIBC_PREREQ(2, 33)
+	struct mallinfo2 info = mallinfo2();
+
+	return info.uordblks + info.hblkhd;
+# endif
+#endif
+
+	return 0;
+}
+
+static void
+report(const gchar *name, gint64 elapsed, gsize before, gsize after) {
+	gdouble seconds = (gdouble)elapsed / G_USEC_PER_SEC;
+
+	g_print("%-10s %12.0f messages/s", name, N_MESSAGES / seconds);
+
+	if(after > before) {
+		g_print(" %8.1f bytes/message",
+		        (gdouble)(after - before) / N_MESSAGES);
+	}
+
+	g_print("\n");
+}
+
+static void
+bench_single(void) {
+	GPtrArray *messages = NULL;
+	GDateTime *timestamp = g_date_time_new_now_local();
+	gsize before = 0, after = 0;
+	gint64 start = 0, elapsed = 0;
+
+	messages = g_ptr_array_new_full(N_MESSAGES, g_object_unref);
+
+	before = heap_in_use();
+	start = g_get_monotonic_time();
+
+	for(gint i = 0; i < N_MESSAGES; i++) {
+		/* Authors usually post a few lines in a row. */
+		const gchar *author = authors[(i / 4) % N_AUTHORS];
+		PurpleMessage *message = NULL;
+
+		message = g_object_new(
+			PURPLE_TYPE_MESSAGE,
+			"author", author,
+			"author-alias", author,
+			"recipient", "#pidgin",
+			"contents", "has anyone tried the new build yet?",
+			"timestamp", timestamp,
+			"flags", PURPLE_MESSAGE_RECV,
+			NULL);
+
+		g_ptr_array_add(messages, message);
+	}
+
+	elapsed = g_get_monotonic_time() - start;
+	after = heap_in_use();
+
+	report("single", elapsed, before, after);
+
+	g_ptr_array_unref(messages);
+	g_date_time_unref(timestamp);
+}
+
+static void
+bench_batch(void) {
+	PurpleMessageEntry *entries = NULL;
+	GPtrArray *messages = NULL;
+	GDateTime *timestamp = g_date_time_new_now_local();
+	gsize before = 0, after = 0;
+	gint64 start = 0, elapsed = 0;
+
+	entries = g_new0(PurpleMessageEntry, N_MESSAGES);
+	for(gint i = 0; i < N_MESSAGES; i++) {
+		const gchar *author = authors[(i / 4) % N_AUTHORS];
+
+		entries[i].author = author;
+		entries[i].author_alias = author;
+		entries[i].recipient = "#pidgin";
+		entries[i].contents = "has anyone tried the new build yet?";
+		entries[i].timestamp = timestamp;
+		entries[i].flags = PURPLE_MESSAGE_RECV;
+	}
+
+	before = heap_in_use();
+	start = g_get_monotonic_time();
+
+	messages = purple_message_new_batch(entries, N_MESSAGES);
+
+	elapsed = g_get_monotonic_time() - start;
+	after = heap_in_use();
+
+	report("batch", elapsed, before, after);
+
+	g_ptr_array_unref(messages);
+	g_free(entries);
+	g_date_time_unref(timestamp);
+}
+
+gint
+main(G_GNUC_UNUSED gint argc, G_GNUC_UNUSED gchar *argv[]) {
+	for(gint i = 0; i < N_AUTHORS; i++) {
+		authors[i] = g_strdup_printf("user%02d", i);
+	}
+
+	/* Make sure the type and its enums are registered before timing. */
+	g_type_ensure(PURPLE_TYPE_MESSAGE);
+
+	bench_single();
+	bench_batch();
+
+	for(gint i = 0; i < N_AUTHORS; i++) {
+		g_free(authors[i]);
+	}
+
+	return 0;
+}
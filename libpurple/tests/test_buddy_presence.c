@@ -0,0 +1,344 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include <purple.h>
+
+#include "test_ui.h"
+
+#define PURPLE_GLOBAL_HEADER_INSIDE
+#include "../purpleprivate.h"
+#undef PURPLE_GLOBAL_HEADER_INSIDE
+
+typedef struct {
+	PurpleAccount *account;
+	PurpleGroup *group;
+
+	guint signed_on;
+	guint signed_off;
+	guint status_changed;
+
+	guint batches;
+	GList *batch;
+} TestBuddyPresenceData;
+
+/******************************************************************************
+ * Callbacks
+ *****************************************************************************/
+static void
+test_buddy_presence_signed_on_cb(G_GNUC_UNUSED PurpleBuddy *buddy,
+                                 gpointer data)
+{
+	TestBuddyPresenceData *test = data;
+
+	test->signed_on++;
+}
+
+static void
+test_buddy_presence_signed_off_cb(G_GNUC_UNUSED PurpleBuddy *buddy,
+                                  gpointer data)
+{
+	TestBuddyPresenceData *test = data;
+
+	test->signed_off++;
+}
+
+static void
+test_buddy_presence_status_changed_cb(G_GNUC_UNUSED PurpleBuddy *buddy,
+                                      G_GNUC_UNUSED PurpleStatus *old_status,
+                                      G_GNUC_UNUSED PurpleStatus *new_status,
+                                      gpointer data)
+{
+	TestBuddyPresenceData *test = data;
+
+	test->status_changed++;
+}
+
+static void
+test_buddy_presence_batch_cb(GList *buddies, gpointer data) {
+	TestBuddyPresenceData *test = data;
+
+	test->batches++;
+
+	g_list_free(test->batch);
+	test->batch = g_list_copy(buddies);
+}
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static void
+test_buddy_presence_setup(TestBuddyPresenceData *test, const gchar *group) {
+	gpointer handle = purple_blist_get_handle();
+	GList *statuses = NULL;
+
+	/* The buddies take their statuses from the account. */
+	test->account = purple_account_new("test", "test");
+	statuses = g_list_append(statuses,
+	                         purple_status_type_new(PURPLE_STATUS_OFFLINE,
+	                                                "offline", "offline",
+	                                                TRUE));
+	statuses = g_list_append(statuses,
+	                         purple_status_type_new(PURPLE_STATUS_AVAILABLE,
+	                                                "available", "available",
+	                                                TRUE));
+	statuses = g_list_append(statuses,
+	                         purple_status_type_new(PURPLE_STATUS_AWAY, "away",
+	                                                "away", TRUE));
+	purple_account_set_status_types(test->account, statuses);
+	purple_account_manager_add(purple_account_manager_get_default(),
+	                           test->account);
+
+	test->group = purple_group_new(group);
+	purple_blist_add_group(test->group, NULL);
+
+	purple_signal_connect(handle, "buddy-signed-on", test,
+	                      G_CALLBACK(test_buddy_presence_signed_on_cb), test);
+	purple_signal_connect(handle, "buddy-signed-off", test,
+	                      G_CALLBACK(test_buddy_presence_signed_off_cb), test);
+	purple_signal_connect(handle, "buddy-status-changed", test,
+	                      G_CALLBACK(test_buddy_presence_status_changed_cb),
+	                      test);
+	purple_signal_connect(handle, "buddies-status-changed", test,
+	                      G_CALLBACK(test_buddy_presence_batch_cb), test);
+}
+
+static void
+test_buddy_presence_teardown(TestBuddyPresenceData *test) {
+	GSList *buddies = NULL;
+
+	purple_signals_disconnect_by_handle(test);
+	purple_buddy_presence_clear_updates();
+
+	buddies = purple_blist_find_buddies(test->account, NULL);
+	for(GSList *l = buddies; l != NULL; l = l->next) {
+		purple_blist_remove_buddy(l->data);
+	}
+	g_slist_free(buddies);
+
+	purple_blist_remove_group(test->group);
+
+	purple_account_manager_remove(purple_account_manager_get_default(),
+	                              test->account);
+	g_clear_object(&test->account);
+
+	g_clear_pointer(&test->batch, g_list_free);
+}
+
+static PurpleBuddy *
+test_buddy_presence_add_buddy(TestBuddyPresenceData *test, const gchar *name) {
+	PurpleBuddy *buddy = purple_buddy_new(test->account, name, NULL);
+
+	purple_blist_add_buddy(buddy, NULL, test->group, NULL);
+
+	return buddy;
+}
+
+/* Does what purple_protocol_got_user_status() does, without needing a
+ * connected account.
+ */
+static void
+test_buddy_presence_set_status(PurpleBuddy *buddy, const gchar *id) {
+	PurplePresence *presence = purple_buddy_get_presence(buddy);
+	PurpleStatus *old_status = purple_presence_get_active_status(presence);
+
+	purple_status_set_active(purple_presence_get_status(presence, id), TRUE);
+	purple_buddy_presence_queue_update(buddy, old_status);
+}
+
+static gint
+test_buddy_presence_online_count(gpointer node) {
+	return purple_counting_node_get_online_count(PURPLE_COUNTING_NODE(node));
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_buddy_presence_coalesce(void) {
+	TestBuddyPresenceData test = { NULL, };
+	PurpleBuddy *buddy = NULL;
+
+	test_buddy_presence_setup(&test, "coalesce");
+	buddy = test_buddy_presence_add_buddy(&test, "buddy");
+
+	test_buddy_presence_set_status(buddy, "available");
+	test_buddy_presence_set_status(buddy, "away");
+	test_buddy_presence_set_status(buddy, "available");
+
+	/* Nothing is emitted until the batch is applied. */
+	g_assert_cmpuint(test.signed_on, ==, 0);
+	g_assert_cmpuint(test.status_changed, ==, 0);
+	g_assert_cmpuint(test.batches, ==, 0);
+
+	purple_buddy_presence_flush_updates();
+
+	/* The three changes are one transition from offline to available. */
+	g_assert_cmpuint(test.signed_on, ==, 1);
+	g_assert_cmpuint(test.signed_off, ==, 0);
+	g_assert_cmpuint(test.status_changed, ==, 0);
+	g_assert_cmpuint(test.batches, ==, 1);
+	g_assert_cmpuint(g_list_length(test.batch), ==, 1);
+	g_assert_true(test.batch->data == buddy);
+
+	test_buddy_presence_teardown(&test);
+}
+
+static void
+test_buddy_presence_online_count_synchronous(void) {
+	TestBuddyPresenceData test = { NULL, };
+	PurpleBuddy *buddy1 = NULL, *buddy2 = NULL;
+	PurpleMetaContact *contact1 = NULL;
+
+	test_buddy_presence_setup(&test, "online-count");
+	buddy1 = test_buddy_presence_add_buddy(&test, "buddy1");
+	buddy2 = test_buddy_presence_add_buddy(&test, "buddy2");
+	contact1 = purple_buddy_get_contact(buddy1);
+
+	/* The counts follow every change right away, batched or not. */
+	test_buddy_presence_set_status(buddy1, "available");
+	g_assert_cmpint(test_buddy_presence_online_count(contact1), ==, 1);
+	g_assert_cmpint(test_buddy_presence_online_count(test.group), ==, 1);
+
+	test_buddy_presence_set_status(buddy2, "away");
+	g_assert_cmpint(test_buddy_presence_online_count(test.group), ==, 2);
+
+	/* Changing between online statuses leaves them alone. */
+	test_buddy_presence_set_status(buddy1, "away");
+	g_assert_cmpint(test_buddy_presence_online_count(contact1), ==, 1);
+	g_assert_cmpint(test_buddy_presence_online_count(test.group), ==, 2);
+
+	test_buddy_presence_set_status(buddy1, "offline");
+	g_assert_cmpint(test_buddy_presence_online_count(contact1), ==, 0);
+	g_assert_cmpint(test_buddy_presence_online_count(test.group), ==, 1);
+
+	g_assert_cmpuint(test.batches, ==, 0);
+
+	/* Applying the batch doesn't count anything twice. */
+	purple_buddy_presence_flush_updates();
+	g_assert_cmpint(test_buddy_presence_online_count(contact1), ==, 0);
+	g_assert_cmpint(test_buddy_presence_online_count(test.group), ==, 1);
+
+	test_buddy_presence_set_status(buddy2, "offline");
+	purple_buddy_presence_flush_updates();
+	g_assert_cmpint(test_buddy_presence_online_count(test.group), ==, 0);
+
+	test_buddy_presence_teardown(&test);
+}
+
+static void
+test_buddy_presence_one_batch_per_flush(void) {
+	TestBuddyPresenceData test = { NULL, };
+	PurpleBuddy *buddies[3] = { NULL, };
+	PurpleBuddy *removed = NULL;
+	GList *l = NULL;
+
+	test_buddy_presence_setup(&test, "one-batch");
+
+	for(guint i = 0; i < G_N_ELEMENTS(buddies); i++) {
+		gchar *name = g_strdup_printf("buddy%u", i);
+
+		buddies[i] = test_buddy_presence_add_buddy(&test, name);
+
+		g_free(name);
+	}
+	removed = test_buddy_presence_add_buddy(&test, "removed");
+
+	test_buddy_presence_set_status(buddies[2], "available");
+	test_buddy_presence_set_status(removed, "available");
+	test_buddy_presence_set_status(buddies[0], "available");
+	test_buddy_presence_set_status(buddies[1], "away");
+	test_buddy_presence_set_status(buddies[2], "away");
+
+	/* A buddy that is removed while its update is pending is skipped. */
+	purple_blist_remove_buddy(removed);
+
+	purple_buddy_presence_flush_updates();
+
+	g_assert_cmpuint(test.batches, ==, 1);
+	g_assert_cmpuint(test.signed_on, ==, 3);
+
+	/* The buddies are in the order their first change was queued in. */
+	g_assert_cmpuint(g_list_length(test.batch), ==, 3);
+	l = test.batch;
+	g_assert_true(l->data == buddies[2]);
+	l = l->next;
+	g_assert_true(l->data == buddies[0]);
+	l = l->next;
+	g_assert_true(l->data == buddies[1]);
+
+	/* Flushing with nothing pending emits nothing. */
+	purple_buddy_presence_flush_updates();
+	g_assert_cmpuint(test.batches, ==, 1);
+
+	/* Anything queued after the flush is a new batch. */
+	test_buddy_presence_set_status(buddies[0], "offline");
+	purple_buddy_presence_flush_updates();
+	g_assert_cmpuint(test.batches, ==, 2);
+	g_assert_cmpuint(test.signed_off, ==, 1);
+	g_assert_cmpuint(g_list_length(test.batch), ==, 1);
+	g_assert_true(test.batch->data == buddies[0]);
+
+	test_buddy_presence_teardown(&test);
+}
+
+static void
+test_buddy_presence_clear(void) {
+	TestBuddyPresenceData test = { NULL, };
+	PurpleBuddy *buddy = NULL;
+
+	test_buddy_presence_setup(&test, "clear");
+	buddy = test_buddy_presence_add_buddy(&test, "buddy");
+
+	test_buddy_presence_set_status(buddy, "available");
+	purple_buddy_presence_clear_updates();
+	purple_buddy_presence_flush_updates();
+
+	/* The signals are dropped, but the count was already updated. */
+	g_assert_cmpuint(test.signed_on, ==, 0);
+	g_assert_cmpuint(test.batches, ==, 0);
+	g_assert_cmpint(test_buddy_presence_online_count(test.group), ==, 1);
+
+	test_buddy_presence_set_status(buddy, "offline");
+	purple_buddy_presence_flush_updates();
+	g_assert_cmpuint(test.signed_off, ==, 1);
+	g_assert_cmpuint(test.batches, ==, 1);
+	g_assert_cmpint(test_buddy_presence_online_count(test.group), ==, 0);
+
+	test_buddy_presence_teardown(&test);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+gint
+main(gint argc, gchar *argv[]) {
+	g_test_init(&argc, &argv, NULL);
+
+	test_ui_purple_init();
+
+	g_test_add_func("/buddy-presence/coalesce", test_buddy_presence_coalesce);
+	g_test_add_func("/buddy-presence/online-count-synchronous",
+	                test_buddy_presence_online_count_synchronous);
+	g_test_add_func("/buddy-presence/one-batch-per-flush",
+	                test_buddy_presence_one_batch_per_flush);
+	g_test_add_func("/buddy-presence/clear", test_buddy_presence_clear);
+
+	return g_test_run();
+}
@@ -0,0 +1,350 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include <purple.h>
+
+#include "test_ui.h"
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+/* Creates an enabled account that wants to be online, but has no protocol so
+ * it never actually signs on.
+ */
+static PurpleAccount *
+test_purple_connection_scheduler_account_new(const gchar *username) {
+	PurpleAccount *account = NULL;
+	GList *types = NULL;
+
+	account = purple_account_new(username, "test");
+
+	types = g_list_append(types,
+	                      purple_status_type_new(PURPLE_STATUS_AVAILABLE,
+	                                             "available", "available",
+	                                             TRUE));
+	types = g_list_append(types,
+	                      purple_status_type_new(PURPLE_STATUS_OFFLINE,
+	                                             "offline", "offline", TRUE));
+	purple_account_set_status_types(account, types);
+
+	purple_account_set_status(account, "available", TRUE, NULL);
+	purple_account_set_enabled(account, TRUE);
+
+	return account;
+}
+
+static void
+test_purple_connection_scheduler_run_dispatch(void) {
+	while(g_main_context_iteration(NULL, FALSE)) {
+	}
+}
+
+/******************************************************************************
+ * Callbacks
+ *****************************************************************************/
+static void
+test_purple_connection_scheduler_notify_cb(G_GNUC_UNUSED GObject *obj,
+                                           G_GNUC_UNUSED GParamSpec *pspec,
+                                           gpointer data)
+{
+	guint *counter = data;
+
+	*counter = *counter + 1;
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_purple_connection_scheduler_get_default(void) {
+	PurpleConnectionScheduler *scheduler1 = NULL, *scheduler2 = NULL;
+
+	scheduler1 = purple_connection_scheduler_get_default();
+	g_assert_true(PURPLE_IS_CONNECTION_SCHEDULER(scheduler1));
+
+	scheduler2 = purple_connection_scheduler_get_default();
+	g_assert_true(scheduler1 == scheduler2);
+}
+
+static void
+test_purple_connection_scheduler_max_connecting(void) {
+	PurpleConnectionScheduler *scheduler = NULL;
+	guint counter = 0;
+	guint max_connecting = 0;
+
+	scheduler = purple_connection_scheduler_get_default();
+
+	g_signal_connect(scheduler, "notify::max-connecting",
+	                 G_CALLBACK(test_purple_connection_scheduler_notify_cb),
+	                 &counter);
+
+	purple_connection_scheduler_set_max_connecting(scheduler, 2);
+	g_assert_cmpuint(purple_connection_scheduler_get_max_connecting(scheduler),
+	                 ==, 2);
+	g_assert_cmpuint(counter, ==, 1);
+
+	/* Setting the same value again should not notify. */
+	purple_connection_scheduler_set_max_connecting(scheduler, 2);
+	g_assert_cmpuint(counter, ==, 1);
+
+	g_object_set(scheduler, "max-connecting", 8, NULL);
+	g_object_get(scheduler, "max-connecting", &max_connecting, NULL);
+	g_assert_cmpuint(max_connecting, ==, 8);
+	g_assert_cmpuint(counter, ==, 2);
+
+	g_signal_handlers_disconnect_by_func(scheduler,
+	                                     test_purple_connection_scheduler_notify_cb,
+	                                     &counter);
+}
+
+static void
+test_purple_connection_scheduler_connect_cancel(void) {
+	PurpleConnectionScheduler *scheduler = NULL;
+	PurpleAccount *account = NULL;
+
+	scheduler = purple_connection_scheduler_get_default();
+	account = purple_account_new("test", "test");
+
+	g_assert_false(purple_connection_scheduler_is_pending(scheduler, account));
+
+	purple_connection_scheduler_connect(scheduler, account, G_PRIORITY_LOW);
+	g_assert_true(purple_connection_scheduler_is_pending(scheduler, account));
+
+	/* Queueing it again with a higher priority keeps it queued once. */
+	purple_connection_scheduler_connect(scheduler, account, G_PRIORITY_HIGH);
+	g_assert_true(purple_connection_scheduler_is_pending(scheduler, account));
+
+	purple_connection_scheduler_cancel(scheduler, account);
+	g_assert_false(purple_connection_scheduler_is_pending(scheduler, account));
+
+	g_clear_object(&account);
+}
+
+static void
+test_purple_connection_scheduler_account_removed(void) {
+	PurpleAccountManager *manager = NULL;
+	PurpleConnectionScheduler *scheduler = NULL;
+	PurpleAccount *account = NULL;
+
+	manager = purple_account_manager_get_default();
+	scheduler = purple_connection_scheduler_get_default();
+	account = purple_account_new("test-removed", "test");
+
+	purple_account_manager_add(manager, account);
+
+	purple_connection_scheduler_connect(scheduler, account, G_PRIORITY_DEFAULT);
+	g_assert_true(purple_connection_scheduler_is_pending(scheduler, account));
+
+	purple_account_manager_remove(manager, account);
+	g_assert_false(purple_connection_scheduler_is_pending(scheduler, account));
+
+	g_clear_object(&account);
+}
+
+static void
+test_purple_connection_scheduler_max_connecting_cap(void) {
+	PurpleConnectionScheduler *scheduler = NULL;
+	PurpleAccount *account1 = NULL, *account2 = NULL, *account3 = NULL;
+
+	scheduler = purple_connection_scheduler_get_default();
+	purple_connection_scheduler_set_max_connecting(scheduler, 2);
+
+	account1 = test_purple_connection_scheduler_account_new("cap1");
+	account2 = test_purple_connection_scheduler_account_new("cap2");
+	account3 = test_purple_connection_scheduler_account_new("cap3");
+
+	purple_connection_scheduler_connect(scheduler, account1, G_PRIORITY_DEFAULT);
+	purple_connection_scheduler_connect(scheduler, account2, G_PRIORITY_DEFAULT);
+	purple_connection_scheduler_connect(scheduler, account3, G_PRIORITY_DEFAULT);
+	test_purple_connection_scheduler_run_dispatch();
+
+	/* Only two may sign on at once, in the order they were queued. */
+	g_assert_true(purple_connection_scheduler_is_connecting(scheduler,
+	                                                        account1));
+	g_assert_true(purple_connection_scheduler_is_connecting(scheduler,
+	                                                        account2));
+	g_assert_false(purple_connection_scheduler_is_connecting(scheduler,
+	                                                         account3));
+	g_assert_true(purple_connection_scheduler_is_pending(scheduler, account3));
+
+	/* Freeing a slot lets the next one go. */
+	purple_connection_scheduler_cancel(scheduler, account1);
+	test_purple_connection_scheduler_run_dispatch();
+
+	g_assert_true(purple_connection_scheduler_is_connecting(scheduler,
+	                                                        account3));
+	g_assert_false(purple_connection_scheduler_is_pending(scheduler, account3));
+
+	purple_connection_scheduler_cancel(scheduler, account2);
+	purple_connection_scheduler_cancel(scheduler, account3);
+
+	g_clear_object(&account1);
+	g_clear_object(&account2);
+	g_clear_object(&account3);
+}
+
+static void
+test_purple_connection_scheduler_priority(void) {
+	PurpleConnectionScheduler *scheduler = NULL;
+	PurpleAccount *low = NULL, *high = NULL;
+
+	scheduler = purple_connection_scheduler_get_default();
+	purple_connection_scheduler_set_max_connecting(scheduler, 1);
+
+	low = test_purple_connection_scheduler_account_new("priority-low");
+	high = test_purple_connection_scheduler_account_new("priority-high");
+
+	/* The more urgent account goes first even though it was queued last. */
+	purple_connection_scheduler_connect(scheduler, low, G_PRIORITY_LOW);
+	purple_connection_scheduler_connect(scheduler, high, G_PRIORITY_HIGH);
+	test_purple_connection_scheduler_run_dispatch();
+
+	g_assert_true(purple_connection_scheduler_is_connecting(scheduler, high));
+	g_assert_false(purple_connection_scheduler_is_connecting(scheduler, low));
+	g_assert_true(purple_connection_scheduler_is_pending(scheduler, low));
+
+	purple_connection_scheduler_cancel(scheduler, high);
+	purple_connection_scheduler_cancel(scheduler, low);
+
+	g_clear_object(&low);
+	g_clear_object(&high);
+}
+
+static void
+test_purple_connection_scheduler_backoff(void) {
+	PurpleConnectionScheduler *scheduler = NULL;
+	PurpleConnection *connection = NULL;
+	PurpleAccount *account = NULL;
+	GNetworkMonitor *monitor = NULL;
+
+	scheduler = purple_connection_scheduler_get_default();
+	purple_connection_scheduler_set_max_connecting(scheduler, 1);
+	monitor = g_network_monitor_get_default();
+
+	account = test_purple_connection_scheduler_account_new("backoff");
+	connection = g_object_new(PURPLE_TYPE_CONNECTION, "account", account,
+	                          NULL);
+
+	purple_connection_scheduler_connect(scheduler, account, G_PRIORITY_DEFAULT);
+	test_purple_connection_scheduler_run_dispatch();
+	g_assert_true(purple_connection_scheduler_is_connecting(scheduler,
+	                                                        account));
+
+	/* A temporary error gives up the slot and waits to reconnect. */
+	purple_signal_emit(purple_connections_get_handle(), "connection-error",
+	                   connection, PURPLE_CONNECTION_ERROR_NETWORK_ERROR,
+	                   "network error");
+	test_purple_connection_scheduler_run_dispatch();
+
+	g_assert_false(purple_connection_scheduler_is_connecting(scheduler,
+	                                                         account));
+	g_assert_true(purple_connection_scheduler_is_pending(scheduler, account));
+
+	/* Coming back online reconnects it right away. */
+	g_signal_emit_by_name(monitor, "network-changed", FALSE);
+	g_signal_emit_by_name(monitor, "network-changed", TRUE);
+	test_purple_connection_scheduler_run_dispatch();
+
+	g_assert_true(purple_connection_scheduler_is_connecting(scheduler,
+	                                                        account));
+
+	/* A fatal error stops trying altogether. */
+	purple_signal_emit(purple_connections_get_handle(), "connection-error",
+	                   connection,
+	                   PURPLE_CONNECTION_ERROR_AUTHENTICATION_FAILED,
+	                   "wrong password");
+
+	g_assert_false(purple_connection_scheduler_is_connecting(scheduler,
+	                                                         account));
+	g_assert_false(purple_connection_scheduler_is_pending(scheduler, account));
+
+	g_clear_object(&connection);
+	g_clear_object(&account);
+}
+
+static void
+test_purple_connection_scheduler_offline(void) {
+	PurpleAccountManager *manager = NULL;
+	PurpleConnectionScheduler *scheduler = NULL;
+	PurpleAccount *account = NULL;
+
+	manager = purple_account_manager_get_default();
+	scheduler = purple_connection_scheduler_get_default();
+
+	account = test_purple_connection_scheduler_account_new("offline");
+	purple_account_manager_add(manager, account);
+
+	/* Going offline cancels the pending connect. */
+	purple_connection_scheduler_connect(scheduler, account, G_PRIORITY_DEFAULT);
+	g_assert_true(purple_connection_scheduler_is_pending(scheduler, account));
+
+	purple_account_set_status(account, "offline", TRUE, NULL);
+	g_assert_false(purple_connection_scheduler_is_pending(scheduler, account));
+
+	/* An offline account that is queued anyway is skipped. */
+	purple_connection_scheduler_connect(scheduler, account, G_PRIORITY_DEFAULT);
+	test_purple_connection_scheduler_run_dispatch();
+	g_assert_false(purple_connection_scheduler_is_connecting(scheduler,
+	                                                         account));
+	g_assert_false(purple_connection_scheduler_is_pending(scheduler, account));
+
+	/* So is disabling it. */
+	purple_account_set_status(account, "available", TRUE, NULL);
+	purple_connection_scheduler_connect(scheduler, account, G_PRIORITY_DEFAULT);
+	g_assert_true(purple_connection_scheduler_is_pending(scheduler, account));
+
+	purple_account_set_enabled(account, FALSE);
+	g_assert_false(purple_connection_scheduler_is_pending(scheduler, account));
+
+	purple_account_manager_remove(manager, account);
+	g_clear_object(&account);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+gint
+main(gint argc, gchar *argv[]) {
+	g_test_init(&argc, &argv, NULL);
+
+	test_ui_purple_init();
+
+	/* Don't let the machine's connectivity decide whether accounts go. */
+	purple_network_force_online();
+
+	g_test_add_func("/connection-scheduler/get-default",
+	                test_purple_connection_scheduler_get_default);
+	g_test_add_func("/connection-scheduler/max-connecting",
+	                test_purple_connection_scheduler_max_connecting);
+	g_test_add_func("/connection-scheduler/connect-cancel",
+	                test_purple_connection_scheduler_connect_cancel);
+	g_test_add_func("/connection-scheduler/account-removed",
+	                test_purple_connection_scheduler_account_removed);
+	g_test_add_func("/connection-scheduler/max-connecting-cap",
+	                test_purple_connection_scheduler_max_connecting_cap);
+	g_test_add_func("/connection-scheduler/priority",
+	                test_purple_connection_scheduler_priority);
+	g_test_add_func("/connection-scheduler/backoff",
+	                test_purple_connection_scheduler_backoff);
+	g_test_add_func("/connection-scheduler/offline",
+	                test_purple_connection_scheduler_offline);
+
+	return g_test_run();
+}
@@ -0,0 +1,166 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include <purple.h>
+
+#include "test_ui.h"
+
+PURPLE_DEBUG_CATEGORY_DEFINE_STATIC(test_debug, "test-debug");
+PURPLE_DEBUG_CATEGORY_DEFINE_STATIC(test_debug_other, "test-debug-other");
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static void
+test_purple_debug_reset(void) {
+	purple_prefs_set_int("/purple/debug/level", PURPLE_DEBUG_ALL);
+	purple_prefs_set_string_list("/purple/debug/categories", NULL);
+	purple_debug_set_minimum_level(PURPLE_DEBUG_ALL);
+}
+
+static const gchar *
+test_purple_debug_expensive(gboolean *evaluated) {
+	*evaluated = TRUE;
+
+	return "expensive";
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_purple_debug_category_level(void) {
+	g_assert_true(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug,
+	                                            PURPLE_DEBUG_MISC));
+
+	purple_prefs_set_int("/purple/debug/level", PURPLE_DEBUG_WARNING);
+
+	g_assert_false(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug,
+	                                             PURPLE_DEBUG_MISC));
+	g_assert_false(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug,
+	                                             PURPLE_DEBUG_INFO));
+	g_assert_true(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug,
+	                                            PURPLE_DEBUG_WARNING));
+	g_assert_true(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug,
+	                                            PURPLE_DEBUG_ERROR));
+
+	g_assert_false(purple_debug_is_enabled(PURPLE_DEBUG_MISC, "test-debug"));
+	g_assert_true(purple_debug_is_enabled(PURPLE_DEBUG_ERROR, NULL));
+
+	test_purple_debug_reset();
+
+	g_assert_true(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug,
+	                                            PURPLE_DEBUG_MISC));
+}
+
+static void
+test_purple_debug_category_override(void) {
+	GList *entries = NULL;
+
+	entries = g_list_append(entries, "test-debug=error");
+	entries = g_list_append(entries, "test-debug-other=all");
+	purple_prefs_set_int("/purple/debug/level", PURPLE_DEBUG_FATAL);
+	purple_prefs_set_string_list("/purple/debug/categories", entries);
+	g_list_free(entries);
+
+	g_assert_false(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug,
+	                                             PURPLE_DEBUG_WARNING));
+	g_assert_true(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug,
+	                                            PURPLE_DEBUG_ERROR));
+	g_assert_true(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug_other,
+	                                            PURPLE_DEBUG_MISC));
+
+	/* Categories without an entry use the level. */
+	g_assert_false(purple_debug_is_enabled(PURPLE_DEBUG_ERROR, "unlisted"));
+	g_assert_true(purple_debug_is_enabled(PURPLE_DEBUG_FATAL, "unlisted"));
+
+	test_purple_debug_reset();
+}
+
+static void
+test_purple_debug_category_log_disabled(void) {
+	gboolean evaluated = FALSE;
+
+	purple_prefs_set_int("/purple/debug/level", PURPLE_DEBUG_ERROR);
+
+	PURPLE_DEBUG_CATEGORY_LOG(&test_debug, PURPLE_DEBUG_MISC, "%s",
+	                          test_purple_debug_expensive(&evaluated));
+	g_assert_false(evaluated);
+
+	test_purple_debug_reset();
+}
+
+static void
+test_purple_debug_minimum_level(void) {
+	GList *entries = NULL;
+
+	purple_debug_set_minimum_level(PURPLE_DEBUG_WARNING);
+
+	/* The floor doesn't touch the saved level. */
+	g_assert_cmpint(purple_prefs_get_int("/purple/debug/level"), ==,
+	                PURPLE_DEBUG_ALL);
+
+	g_assert_false(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug,
+	                                             PURPLE_DEBUG_INFO));
+	g_assert_true(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug,
+	                                            PURPLE_DEBUG_WARNING));
+	g_assert_false(purple_debug_is_enabled(PURPLE_DEBUG_INFO, "unlisted"));
+
+	/* It applies to categories with their own level too. */
+	entries = g_list_append(entries, "test-debug-other=all");
+	purple_prefs_set_string_list("/purple/debug/categories", entries);
+	g_list_free(entries);
+
+	g_assert_false(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug_other,
+	                                             PURPLE_DEBUG_MISC));
+	g_assert_false(purple_debug_is_enabled(PURPLE_DEBUG_MISC,
+	                                       "test-debug-other"));
+
+	/* A stricter preference still wins over a lower floor. */
+	purple_prefs_set_int("/purple/debug/level", PURPLE_DEBUG_ERROR);
+	purple_debug_set_minimum_level(PURPLE_DEBUG_ALL);
+
+	g_assert_false(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug,
+	                                             PURPLE_DEBUG_WARNING));
+	g_assert_true(PURPLE_DEBUG_CATEGORY_ENABLED(&test_debug_other,
+	                                            PURPLE_DEBUG_MISC));
+
+	test_purple_debug_reset();
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+gint
+main(gint argc, gchar *argv[]) {
+	g_test_init(&argc, &argv, NULL);
+
+	test_ui_purple_init();
+
+	g_test_add_func("/debug/category/level",
+	                test_purple_debug_category_level);
+	g_test_add_func("/debug/category/override",
+	                test_purple_debug_category_override);
+	g_test_add_func("/debug/category/log-disabled",
+	                test_purple_debug_category_log_disabled);
+	g_test_add_func("/debug/minimum-level", test_purple_debug_minimum_level);
+
+	return g_test_run();
+}
@@ -268,6 +268,140 @@ test_purple_history_adapter_test_write(void) {
 	g_clear_object(&conversation);
 }
 
+static void
+test_purple_history_adapter_test_write_messages(void) {
+	PurpleAccount *account = NULL;
+	PurpleConversation *conversation = NULL;
+	PurpleHistoryAdapter *adapter = test_purple_history_adapter_new();
+	TestPurpleHistoryAdapter *ta = TEST_PURPLE_HISTORY_ADAPTER(adapter);
+	GPtrArray *messages = NULL;
+	GError *error = NULL;
+	gboolean result = FALSE;
+
+	messages = g_ptr_array_new_with_free_func(g_object_unref);
+	g_ptr_array_add(messages, g_object_new(PURPLE_TYPE_MESSAGE, NULL));
+	g_ptr_array_add(messages, g_object_new(PURPLE_TYPE_MESSAGE, NULL));
+
+	account = purple_account_new("test", "test");
+	conversation = g_object_new(PURPLE_TYPE_IM_CONVERSATION,
+	                            "account", account,
+	                            "name", "pidgy",
+	                            NULL);
+
+	/* The test adapter does not implement write_messages, so this should fall
+	 * back to write and leave all of the messages in the array.
+	 */
+	result = purple_history_adapter_write_messages(adapter, conversation,
+	                                               messages, &error);
+
+	g_assert_no_error(error);
+	g_assert_true(result);
+	g_assert_true(ta->write);
+	g_assert_cmpuint(messages->len, ==, 2);
+
+	g_clear_object(&adapter);
+	g_ptr_array_unref(messages);
+	g_clear_object(&conversation);
+	g_clear_object(&account);
+}
+
+static void
+test_purple_history_adapter_test_sqlite_write_messages(void) {
+	PurpleAccount *account = NULL;
+	PurpleConversation *conversation = NULL;
+	PurpleHistoryAdapter *adapter = NULL;
+	PurpleMessage *message = NULL;
+	GPtrArray *messages = NULL;
+	GError *error = NULL;
+	gboolean result = FALSE;
+
+	adapter = purple_sqlite_history_adapter_new(":memory:");
+	result = purple_history_adapter_activate(adapter, &error);
+	g_assert_no_error(error);
+	g_assert_true(result);
+
+	account = purple_account_new("test", "test");
+	conversation = g_object_new(PURPLE_TYPE_CHAT_CONVERSATION,
+	                            "account", account,
+	                            "name", "room@conference.example.com",
+	                            NULL);
+
+	/* Nothing has been written yet. */
+	message = purple_history_adapter_get_last_message(adapter, account, NULL,
+	                                                  &error);
+	g_assert_no_error(error);
+	g_assert_null(message);
+
+	messages = g_ptr_array_new_with_free_func(g_object_unref);
+	g_ptr_array_add(messages, g_object_new(PURPLE_TYPE_MESSAGE, "id", "a",
+	                                       NULL));
+	g_ptr_array_add(messages, g_object_new(PURPLE_TYPE_MESSAGE, "id", "b",
+	                                       NULL));
+
+	result = purple_history_adapter_write_messages(adapter, conversation,
+	                                               messages, &error);
+	g_assert_no_error(error);
+	g_assert_true(result);
+	g_assert_cmpuint(messages->len, ==, 2);
+	g_ptr_array_unref(messages);
+
+	/* Write an overlapping page, only "c" is new. */
+	messages = g_ptr_array_new_with_free_func(g_object_unref);
+	g_ptr_array_add(messages, g_object_new(PURPLE_TYPE_MESSAGE, "id", "b",
+	                                       NULL));
+	g_ptr_array_add(messages, g_object_new(PURPLE_TYPE_MESSAGE, "id", "c",
+	                                       NULL));
+
+	result = purple_history_adapter_write_messages(adapter, conversation,
+	                                               messages, &error);
+	g_assert_no_error(error);
+	g_assert_true(result);
+	g_assert_cmpuint(messages->len, ==, 1);
+	g_assert_cmpstr(purple_message_get_id(g_ptr_array_index(messages, 0)),
+	                ==, "c");
+	g_ptr_array_unref(messages);
+
+	message = purple_history_adapter_get_last_message(adapter, account,
+	                                                  "room@conference.example.com",
+	                                                  &error);
+	g_assert_no_error(error);
+	g_assert_nonnull(message);
+	g_assert_cmpstr(purple_message_get_id(message), ==, "c");
+	g_clear_object(&message);
+
+	message = purple_history_adapter_get_last_message(adapter, account,
+	                                                  "elsewhere", &error);
+	g_assert_no_error(error);
+	g_assert_null(message);
+
+	/* A message we saw live with its archive id isn't written again when the
+	 * archive sends it.
+	 */
+	message = g_object_new(PURPLE_TYPE_MESSAGE, NULL);
+	purple_message_set_id(message, "d");
+	result = purple_history_adapter_write(adapter, conversation, message,
+	                                      &error);
+	g_assert_no_error(error);
+	g_assert_true(result);
+
+	messages = g_ptr_array_new_with_free_func(g_object_unref);
+	g_ptr_array_add(messages, message);
+
+	result = purple_history_adapter_write_messages(adapter, conversation,
+	                                               messages, &error);
+	g_assert_no_error(error);
+	g_assert_true(result);
+	g_assert_cmpuint(messages->len, ==, 0);
+	g_ptr_array_unref(messages);
+
+	result = purple_history_adapter_deactivate(adapter, &error);
+	g_assert_no_error(error);
+	g_assert_true(result);
+
+	g_clear_object(&adapter);
+	g_clear_object(&conversation);
+	g_clear_object(&account);
+}
 
 /******************************************************************************
  * Main
@@ -290,6 +424,10 @@ main(gint argc, gchar *argv[]) {
 	                test_purple_history_adapter_test_remove);
 	g_test_add_func("/history-adapter/write",
 	                test_purple_history_adapter_test_write);
+	g_test_add_func("/history-adapter/write-messages",
+	                test_purple_history_adapter_test_write_messages);
+	g_test_add_func("/history-adapter/sqlite/write-messages",
+	                test_purple_history_adapter_test_sqlite_write_messages);
 
 	return g_test_run();
 }
@@ -0,0 +1,521 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include <purple.h>
+
+#include "test_ui.h"
+
+#define TEST_HTTP_SERVICE_BODY "hello world"
+
+typedef struct {
+	SoupServer *server;
+	gchar *base;
+
+	guint requests;
+	guint revalidations;
+} TestHttpServiceServer;
+
+typedef struct _TestHttpServiceData TestHttpServiceData;
+
+typedef struct {
+	TestHttpServiceData *test;
+	guint index;
+} TestHttpServiceCall;
+
+struct _TestHttpServiceData {
+	GMainLoop *loop;
+	guint remaining;
+
+	TestHttpServiceCall calls[2];
+	GBytes *bytes[2];
+	GError *error[2];
+};
+
+/******************************************************************************
+ * Server
+ *****************************************************************************/
+static void
+test_purple_http_service_handler(G_GNUC_UNUSED SoupServer *server,
+                                 SoupServerMessage *msg,
+                                 const gchar *path,
+                                 G_GNUC_UNUSED GHashTable *query,
+                                 gpointer data)
+{
+	TestHttpServiceServer *test = data;
+	SoupMessageHeaders *request = NULL, *response = NULL;
+	const gchar *etag = NULL;
+
+	request = soup_server_message_get_request_headers(msg);
+	response = soup_server_message_get_response_headers(msg);
+
+	test->requests++;
+
+	if(g_str_equal(path, "/missing")) {
+		soup_server_message_set_status(msg, SOUP_STATUS_NOT_FOUND, NULL);
+
+		return;
+	}
+
+	if(g_str_equal(path, "/private")) {
+		if(soup_message_headers_get_one(request, "Authorization") == NULL) {
+			soup_server_message_set_status(msg, SOUP_STATUS_UNAUTHORIZED,
+			                               NULL);
+
+			return;
+		}
+
+		/* Fresh for an hour, so only the cache rules keep it out. */
+		soup_message_headers_replace(response, "Cache-Control",
+		                             "max-age=3600");
+		soup_server_message_set_status(msg, SOUP_STATUS_OK, NULL);
+		soup_server_message_set_response(msg, "text/plain",
+		                                 SOUP_MEMORY_STATIC,
+		                                 TEST_HTTP_SERVICE_BODY,
+		                                 strlen(TEST_HTTP_SERVICE_BODY));
+
+		return;
+	}
+
+	/* Every use of the response has to be checked with the server. */
+	soup_message_headers_replace(response, "ETag", "\"v1\"");
+	soup_message_headers_replace(response, "Cache-Control", "no-cache");
+
+	etag = soup_message_headers_get_one(request, "If-None-Match");
+	if(g_strcmp0(etag, "\"v1\"") == 0) {
+		test->revalidations++;
+		soup_server_message_set_status(msg, SOUP_STATUS_NOT_MODIFIED, NULL);
+
+		return;
+	}
+
+	soup_server_message_set_status(msg, SOUP_STATUS_OK, NULL);
+	soup_server_message_set_response(msg, "text/plain", SOUP_MEMORY_STATIC,
+	                                 TEST_HTTP_SERVICE_BODY,
+	                                 strlen(TEST_HTTP_SERVICE_BODY));
+}
+
+static TestHttpServiceServer *
+test_purple_http_service_server_new(void) {
+	TestHttpServiceServer *test = g_new0(TestHttpServiceServer, 1);
+	GError *error = NULL;
+	GSList *uris = NULL;
+
+	test->server = soup_server_new(NULL, NULL);
+	soup_server_add_handler(test->server, NULL,
+	                        test_purple_http_service_handler, test, NULL);
+	soup_server_listen_local(test->server, 0, SOUP_SERVER_LISTEN_IPV4_ONLY,
+	                         &error);
+	g_assert_no_error(error);
+
+	uris = soup_server_get_uris(test->server);
+	g_assert_nonnull(uris);
+	test->base = g_uri_to_string(uris->data);
+	g_slist_free_full(uris, (GDestroyNotify)g_uri_unref);
+
+	return test;
+}
+
+static void
+test_purple_http_service_server_free(TestHttpServiceServer *test) {
+	soup_server_disconnect(test->server);
+	g_clear_object(&test->server);
+	g_free(test->base);
+	g_free(test);
+}
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static void
+test_purple_http_service_fetch_cb(GObject *source, GAsyncResult *result,
+                                  gpointer data)
+{
+	TestHttpServiceCall *call = data;
+	TestHttpServiceData *test = call->test;
+	guint index = call->index;
+
+	test->bytes[index] = purple_http_service_fetch_finish(
+		PURPLE_HTTP_SERVICE(source), result, &test->error[index]);
+
+	test->remaining--;
+	if(test->remaining == 0) {
+		g_main_loop_quit(test->loop);
+	}
+}
+
+/* Starts @count fetches of @uri and cancels the ones @cancel says to once they
+ * have all been started, so they are all waiting for the same request.
+ */
+static void
+test_purple_http_service_fetch_full(const gchar *uri, guint count,
+                                    const gboolean *cancel,
+                                    TestHttpServiceData *test)
+{
+	PurpleHttpService *service = purple_http_service_get_default();
+	GCancellable *cancellables[G_N_ELEMENTS(test->calls)] = { NULL };
+
+	g_assert_cmpuint(count, <=, G_N_ELEMENTS(test->calls));
+
+	test->loop = g_main_loop_new(NULL, FALSE);
+	test->remaining = count;
+
+	for(guint i = 0; i < count; i++) {
+		test->calls[i].test = test;
+		test->calls[i].index = i;
+
+		cancellables[i] = g_cancellable_new();
+		purple_http_service_fetch_async(service, NULL, uri, cancellables[i],
+		                                 test_purple_http_service_fetch_cb,
+		                                 &test->calls[i]);
+	}
+
+	for(guint i = 0; i < count; i++) {
+		if(cancel != NULL && cancel[i]) {
+			g_cancellable_cancel(cancellables[i]);
+		}
+	}
+
+	g_main_loop_run(test->loop);
+	g_main_loop_unref(test->loop);
+
+	for(guint i = 0; i < count; i++) {
+		g_clear_object(&cancellables[i]);
+	}
+
+	/* Let the cache finish writing the entry. */
+	while(g_main_context_iteration(NULL, FALSE));
+}
+
+static void
+test_purple_http_service_fetch(const gchar *uri, guint count,
+                               TestHttpServiceData *test)
+{
+	test_purple_http_service_fetch_full(uri, count, NULL, test);
+}
+
+static void
+test_purple_http_service_send_cb(GObject *source, GAsyncResult *result,
+                                 gpointer data)
+{
+	TestHttpServiceData *test = data;
+
+	test->bytes[0] = soup_session_send_and_read_finish(SOUP_SESSION(source),
+	                                                   result,
+	                                                   &test->error[0]);
+
+	g_main_loop_quit(test->loop);
+}
+
+/* Gets @uri through the shared session with an Authorization header. */
+static void
+test_purple_http_service_send_authorized(const gchar *uri,
+                                         TestHttpServiceData *test)
+{
+	PurpleHttpService *service = purple_http_service_get_default();
+	SoupMessage *msg = NULL;
+	SoupSession *session = NULL;
+	GError *error = NULL;
+
+	session = purple_http_service_get_session(service, NULL, &error);
+	g_assert_no_error(error);
+
+	msg = soup_message_new("GET", uri);
+	soup_message_headers_replace(soup_message_get_request_headers(msg),
+	                             "Authorization", "IMToken secret");
+
+	test->loop = g_main_loop_new(NULL, FALSE);
+	soup_session_send_and_read_async(session, msg, G_PRIORITY_DEFAULT, NULL,
+	                                 test_purple_http_service_send_cb, test);
+	g_main_loop_run(test->loop);
+	g_main_loop_unref(test->loop);
+
+	g_assert_cmpuint(soup_message_get_status(msg), ==, SOUP_STATUS_OK);
+
+	g_object_unref(msg);
+	g_object_unref(session);
+
+	while(g_main_context_iteration(NULL, FALSE));
+}
+
+static void
+test_purple_http_service_data_clear(TestHttpServiceData *test) {
+	for(guint i = 0; i < G_N_ELEMENTS(test->bytes); i++) {
+		g_clear_pointer(&test->bytes[i], g_bytes_unref);
+		g_clear_error(&test->error[i]);
+	}
+}
+
+static void
+test_purple_http_service_assert_body(GBytes *bytes) {
+	gconstpointer data = NULL;
+	gsize size = 0;
+
+	g_assert_nonnull(bytes);
+	data = g_bytes_get_data(bytes, &size);
+	g_assert_cmpmem(data, size, TEST_HTTP_SERVICE_BODY,
+	                strlen(TEST_HTTP_SERVICE_BODY));
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_purple_http_service_get_default(void) {
+	PurpleHttpService *service1 = NULL, *service2 = NULL;
+
+	service1 = purple_http_service_get_default();
+	g_assert_true(PURPLE_IS_HTTP_SERVICE(service1));
+
+	service2 = purple_http_service_get_default();
+	g_assert_true(service1 == service2);
+}
+
+static void
+test_purple_http_service_session_shared(void) {
+	PurpleHttpService *service = purple_http_service_get_default();
+	SoupSession *session1 = NULL, *session2 = NULL;
+	GError *error = NULL;
+
+	session1 = purple_http_service_get_session(service, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_true(SOUP_IS_SESSION(session1));
+
+	session2 = purple_http_service_get_session(service, NULL, &error);
+	g_assert_no_error(error);
+	g_assert_true(session1 == session2);
+
+	g_assert_nonnull(soup_session_get_feature(session1, SOUP_TYPE_CACHE));
+
+	g_clear_object(&session1);
+	g_clear_object(&session2);
+}
+
+static void
+test_purple_http_service_fetch_dedup(void) {
+	TestHttpServiceServer *server = test_purple_http_service_server_new();
+	TestHttpServiceData test = { 0 };
+	gchar *uri = g_strconcat(server->base, "dedup", NULL);
+
+	test_purple_http_service_fetch(uri, 2, &test);
+
+	g_assert_no_error(test.error[0]);
+	g_assert_no_error(test.error[1]);
+	test_purple_http_service_assert_body(test.bytes[0]);
+	test_purple_http_service_assert_body(test.bytes[1]);
+	g_assert_cmpuint(server->requests, ==, 1);
+
+	test_purple_http_service_data_clear(&test);
+	test_purple_http_service_server_free(server);
+	g_free(uri);
+}
+
+static void
+test_purple_http_service_fetch_revalidate(void) {
+	TestHttpServiceServer *server = test_purple_http_service_server_new();
+	TestHttpServiceData test = { 0 };
+	gchar *uri = g_strconcat(server->base, "revalidate", NULL);
+
+	test_purple_http_service_fetch(uri, 1, &test);
+	g_assert_no_error(test.error[0]);
+	test_purple_http_service_assert_body(test.bytes[0]);
+	test_purple_http_service_data_clear(&test);
+
+	/* The second fetch is answered from the cache after a 304. */
+	test_purple_http_service_fetch(uri, 1, &test);
+	g_assert_no_error(test.error[0]);
+	test_purple_http_service_assert_body(test.bytes[0]);
+	test_purple_http_service_data_clear(&test);
+
+	g_assert_cmpuint(server->requests, ==, 2);
+	g_assert_cmpuint(server->revalidations, ==, 1);
+
+	test_purple_http_service_server_free(server);
+	g_free(uri);
+}
+
+static void
+test_purple_http_service_fetch_error(void) {
+	TestHttpServiceServer *server = test_purple_http_service_server_new();
+	TestHttpServiceData test = { 0 };
+	gchar *uri = g_strconcat(server->base, "missing", NULL);
+
+	test_purple_http_service_fetch(uri, 1, &test);
+	g_assert_error(test.error[0], PURPLE_HTTP_SERVICE_DOMAIN,
+	               SOUP_STATUS_NOT_FOUND);
+	g_assert_null(test.bytes[0]);
+
+	test_purple_http_service_data_clear(&test);
+	test_purple_http_service_server_free(server);
+	g_free(uri);
+}
+
+static void
+test_purple_http_service_fetch_cancel_one(void) {
+	TestHttpServiceServer *server = test_purple_http_service_server_new();
+	TestHttpServiceData test = { 0 };
+	gchar *uri = g_strconcat(server->base, "cancel-one", NULL);
+	const gboolean cancel[] = { TRUE, FALSE };
+
+	test_purple_http_service_fetch_full(uri, 2, cancel, &test);
+
+	/* The cancelled caller is told so, the other one still gets the body of
+	 * the one request. */
+	g_assert_error(test.error[0], G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_assert_null(test.bytes[0]);
+	g_assert_no_error(test.error[1]);
+	test_purple_http_service_assert_body(test.bytes[1]);
+	g_assert_cmpuint(server->requests, ==, 1);
+
+	test_purple_http_service_data_clear(&test);
+	test_purple_http_service_server_free(server);
+	g_free(uri);
+}
+
+static void
+test_purple_http_service_fetch_cancel_all(void) {
+	TestHttpServiceServer *server = test_purple_http_service_server_new();
+	TestHttpServiceData test = { 0 };
+	gchar *uri = g_strconcat(server->base, "cancel-all", NULL);
+	const gboolean cancel[] = { TRUE, TRUE };
+
+	test_purple_http_service_fetch_full(uri, 2, cancel, &test);
+
+	g_assert_error(test.error[0], G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_assert_null(test.bytes[0]);
+	g_assert_error(test.error[1], G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_assert_null(test.bytes[1]);
+	test_purple_http_service_data_clear(&test);
+
+	/* The cancelled request is gone, so the next fetch makes a new one. */
+	test_purple_http_service_fetch(uri, 1, &test);
+	g_assert_no_error(test.error[0]);
+	test_purple_http_service_assert_body(test.bytes[0]);
+	test_purple_http_service_data_clear(&test);
+
+	test_purple_http_service_server_free(server);
+	g_free(uri);
+}
+
+static void
+test_purple_http_service_fetch_after_cancel(void) {
+	TestHttpServiceServer *server = test_purple_http_service_server_new();
+	PurpleHttpService *service = purple_http_service_get_default();
+	TestHttpServiceData test = { 0 };
+	GCancellable *cancellable = g_cancellable_new();
+	gchar *uri = g_strconcat(server->base, "after-cancel", NULL);
+
+	test.loop = g_main_loop_new(NULL, FALSE);
+	test.remaining = 2;
+
+	for(guint i = 0; i < 2; i++) {
+		test.calls[i].test = &test;
+		test.calls[i].index = i;
+	}
+
+	purple_http_service_fetch_async(service, NULL, uri, cancellable,
+	                                 test_purple_http_service_fetch_cb,
+	                                 &test.calls[0]);
+	g_cancellable_cancel(cancellable);
+
+	/* The cancelled request hasn't finished yet, but this must not join it. */
+	purple_http_service_fetch_async(service, NULL, uri, NULL,
+	                                 test_purple_http_service_fetch_cb,
+	                                 &test.calls[1]);
+
+	g_main_loop_run(test.loop);
+	g_main_loop_unref(test.loop);
+	while(g_main_context_iteration(NULL, FALSE));
+
+	g_assert_error(test.error[0], G_IO_ERROR, G_IO_ERROR_CANCELLED);
+	g_assert_null(test.bytes[0]);
+	g_assert_no_error(test.error[1]);
+	test_purple_http_service_assert_body(test.bytes[1]);
+
+	test_purple_http_service_data_clear(&test);
+	test_purple_http_service_server_free(server);
+	g_clear_object(&cancellable);
+	g_free(uri);
+}
+
+static void
+test_purple_http_service_authorization_not_cached(void) {
+	TestHttpServiceServer *server = test_purple_http_service_server_new();
+	TestHttpServiceData test = { 0 };
+	gchar *uri = g_strconcat(server->base, "private", NULL);
+
+	test_purple_http_service_send_authorized(uri, &test);
+	g_assert_no_error(test.error[0]);
+	test_purple_http_service_assert_body(test.bytes[0]);
+	test_purple_http_service_data_clear(&test);
+
+	/* The response is still fresh, but it must not come from the cache. */
+	test_purple_http_service_send_authorized(uri, &test);
+	g_assert_no_error(test.error[0]);
+	test_purple_http_service_assert_body(test.bytes[0]);
+	test_purple_http_service_data_clear(&test);
+
+	g_assert_cmpuint(server->requests, ==, 2);
+
+	test_purple_http_service_server_free(server);
+	g_free(uri);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+gint
+main(gint argc, gchar *argv[]) {
+	gchar *dir = NULL;
+	gint ret = 0;
+
+	g_test_init(&argc, &argv, NULL);
+
+	/* Keep the on-disk cache out of the real cache directory. */
+	dir = g_dir_make_tmp("test_http_service-XXXXXX", NULL);
+	g_assert_nonnull(dir);
+	purple_util_set_user_dir(dir);
+
+	test_ui_purple_init();
+
+	g_test_add_func("/http-service/get-default",
+	                test_purple_http_service_get_default);
+	g_test_add_func("/http-service/session-shared",
+	                test_purple_http_service_session_shared);
+	g_test_add_func("/http-service/fetch/dedup",
+	                test_purple_http_service_fetch_dedup);
+	g_test_add_func("/http-service/fetch/revalidate",
+	                test_purple_http_service_fetch_revalidate);
+	g_test_add_func("/http-service/fetch/error",
+	                test_purple_http_service_fetch_error);
+	g_test_add_func("/http-service/fetch/cancel-one",
+	                test_purple_http_service_fetch_cancel_one);
+	g_test_add_func("/http-service/fetch/cancel-all",
+	                test_purple_http_service_fetch_cancel_all);
+	g_test_add_func("/http-service/fetch/after-cancel",
+	                test_purple_http_service_fetch_after_cancel);
+	g_test_add_func("/http-service/authorization-not-cached",
+	                test_purple_http_service_authorization_not_cached);
+
+	ret = g_test_run();
+
+	g_free(dir);
+
+	return ret;
+}
@@ -66,10 +66,18 @@ test_purple_markup_html_to_xhtml(void) {
 			"<unknown>",
 			"&lt;unknown>",
 			"<unknown>",
+		}, {
+			"<blockquote2>",
+			"&lt;blockquote2>",
+			"<blockquote2>",
 		}, {
 			"&eacute;&amp;",
 			"&eacute;&amp;",
 			"&eacute;&",
+		}, {
+			"&AMP;&#65;&#x42;",
+			"&AMP;&#65;&#x42;",
+			"&AB",
 		}, {
 			"<h1>A<h2>B</h2>C</h1>",
 			"<h1>A<h2>B</h2>C</h1>",
@@ -266,6 +274,72 @@ test_purple_markup_strip_html(void) {
 	}
 }
 
+static void
+test_purple_markup_unescape_entity(void) {
+	struct {
+		const char *text;
+		const char *expected;
+		int length;
+	} data[] = {
+		{ "&amp;", "&", 5 },
+		{ "&AMP;", "&", 5 },
+		{ "&apos;", "'", 6 },
+		{ "&nbsp;x", " ", 6 },
+		{ "&reg;", "\302\256", 5 },
+		{ "&#65;", "A", 5 },
+		{ "&#x41;", "A", 6 },
+		{ "&bogus;", NULL, 0 },
+		{ "&", NULL, 0 },
+		{ "amp;", NULL, 0 },
+	};
+
+	for(gsize i = 0; i < G_N_ELEMENTS(data); i++) {
+		const char *plain = NULL;
+		int length = 0;
+
+		plain = purple_markup_unescape_entity(data[i].text, &length);
+		g_assert_cmpstr(plain, ==, data[i].expected);
+		g_assert_cmpint(length, ==, data[i].length);
+	}
+}
+
+static void
+test_purple_markup_linkify(void) {
+	MarkupTestData data[] = {
+		{
+			.markup = "",
+			.xhtml = "",
+		}, {
+			.markup = "no links here",
+			.xhtml = "no links here",
+		}, {
+			.markup = "see http://pidgin.im/ now",
+			.xhtml = "see <A HREF=\"http://pidgin.im/\">http://pidgin.im/</A> now",
+		}, {
+			.markup = "(http://pidgin.im/)",
+			.xhtml = "(<A HREF=\"http://pidgin.im/\">http://pidgin.im/</A>)",
+		}, {
+			.markup = "www.pidgin.im.",
+			.xhtml = "<A HREF=\"http://www.pidgin.im\">www.pidgin.im</A>.",
+		}, {
+			.markup = "<a href='x'>http://pidgin.im/</a>",
+			.xhtml = "<a href='x'>http://pidgin.im/</a>",
+		}, {
+			.markup = "mail me@example.com.",
+			.xhtml = "mail <A HREF=\"mailto:me@example.com\">me@example.com</A>.",
+		}, {
+			.markup = NULL,
+		}
+	};
+
+	for(int i = 0; data[i].markup != NULL; i++) {
+		char *linkified = purple_markup_linkify(data[i].markup);
+
+		g_assert_cmpstr(linkified, ==, data[i].xhtml);
+		g_free(linkified);
+	}
+}
+
 /******************************************************************************
  * Main
  *****************************************************************************/
@@ -277,6 +351,10 @@ main(gint argc, gchar **argv) {
 	                test_purple_markup_html_to_xhtml);
 	g_test_add_func("/util/markup/strip-html",
 	                test_purple_markup_strip_html);
+	g_test_add_func("/util/markup/unescape-entity",
+	                test_purple_markup_unescape_entity);
+	g_test_add_func("/util/markup/linkify",
+	                test_purple_markup_linkify);
 
 	return g_test_run();
 }
@@ -0,0 +1,229 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include <purple.h>
+
+#include "test_ui.h"
+
+#define TEST_SESSION "session"
+#define TEST_PARTICIPANT "participant"
+
+typedef struct {
+	PurpleMediaManager *manager;
+	PurpleMedia *media;
+	GstElement *src;
+	GstElement *sink;
+} TestMediaLoopback;
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+
+/* Links the application source the manager hands out for a session straight
+ * to the application sink of the same session, so whatever is sent comes
+ * right back.
+ */
+static void
+test_media_loopback_init(TestMediaLoopback *loopback) {
+	GstElement *pipeline = NULL;
+
+	loopback->manager = purple_media_manager_get();
+	loopback->media = g_object_new(PURPLE_TYPE_MEDIA,
+	                               "manager", loopback->manager,
+	                               NULL);
+
+	loopback->src = purple_media_manager_get_element(loopback->manager,
+	                                                 PURPLE_MEDIA_SEND_APPLICATION,
+	                                                 loopback->media,
+	                                                 TEST_SESSION,
+	                                                 TEST_PARTICIPANT);
+	g_assert_nonnull(loopback->src);
+
+	loopback->sink = purple_media_manager_get_element(loopback->manager,
+	                                                  PURPLE_MEDIA_RECV_APPLICATION,
+	                                                  loopback->media,
+	                                                  TEST_SESSION,
+	                                                  TEST_PARTICIPANT);
+	g_assert_nonnull(loopback->sink);
+	g_object_set(loopback->sink, "sync", FALSE, NULL);
+
+	pipeline = purple_media_manager_get_pipeline(loopback->manager);
+	gst_bin_add(GST_BIN(pipeline), loopback->sink);
+	g_assert_true(gst_element_link(loopback->src, loopback->sink));
+	gst_element_sync_state_with_parent(loopback->sink);
+	gst_element_sync_state_with_parent(loopback->src);
+
+	/* This is what the backend says once the session is connected, nothing
+	 * can be sent before that. */
+	g_signal_emit_by_name(loopback->media, "candidate-pair-established",
+	                      TEST_SESSION, TEST_PARTICIPANT, NULL, NULL);
+}
+
+static void
+test_media_loopback_clear(TestMediaLoopback *loopback) {
+	GstElement *pipeline = NULL;
+
+	pipeline = purple_media_manager_get_pipeline(loopback->manager);
+
+	/* Unlinking the sink takes the source out of the pipeline as well. */
+	gst_element_set_state(loopback->sink, GST_STATE_NULL);
+	gst_bin_remove(GST_BIN(pipeline), loopback->sink);
+	gst_object_unref(loopback->src);
+
+	g_clear_object(&loopback->media);
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_media_manager_application_bytes_round_trip(void) {
+	TestMediaLoopback loopback;
+	GBytes *sent = NULL;
+	GBytes *received = NULL;
+	gconstpointer data = NULL;
+	gint ret = 0;
+
+	test_media_loopback_init(&loopback);
+
+	sent = g_bytes_new_static("hello world", 11);
+	data = g_bytes_get_data(sent, NULL);
+
+	ret = purple_media_manager_send_application_bytes(loopback.manager,
+	                                                  loopback.media,
+	                                                  TEST_SESSION,
+	                                                  TEST_PARTICIPANT, sent,
+	                                                  FALSE);
+	g_assert_cmpint(ret, ==, 11);
+
+	/* The manager holds on to the data itself. */
+	g_bytes_unref(sent);
+
+	received = purple_media_manager_receive_application_bytes(loopback.manager,
+	                                                          loopback.media,
+	                                                          TEST_SESSION,
+	                                                          TEST_PARTICIPANT,
+	                                                          TRUE);
+	g_assert_nonnull(received);
+	g_assert_cmpmem(g_bytes_get_data(received, NULL),
+	                g_bytes_get_size(received), "hello world", 11);
+
+	/* Nothing was copied on the way through. */
+	g_assert_true(g_bytes_get_data(received, NULL) == data);
+
+	g_bytes_unref(received);
+
+	received = purple_media_manager_receive_application_bytes(loopback.manager,
+	                                                          loopback.media,
+	                                                          TEST_SESSION,
+	                                                          TEST_PARTICIPANT,
+	                                                          FALSE);
+	g_assert_null(received);
+
+	test_media_loopback_clear(&loopback);
+}
+
+static void
+test_media_manager_application_bytes_remainder(void) {
+	TestMediaLoopback loopback;
+	GBytes *sent = NULL;
+	GBytes *received = NULL;
+	gchar buffer[6];
+	gint ret = 0;
+
+	test_media_loopback_init(&loopback);
+
+	sent = g_bytes_new_static("hello world", 11);
+	ret = purple_media_manager_send_application_bytes(loopback.manager,
+	                                                  loopback.media,
+	                                                  TEST_SESSION,
+	                                                  TEST_PARTICIPANT, sent,
+	                                                  FALSE);
+	g_assert_cmpint(ret, ==, 11);
+	g_bytes_unref(sent);
+
+	ret = purple_media_manager_receive_application_data(loopback.manager,
+	                                                    loopback.media,
+	                                                    TEST_SESSION,
+	                                                    TEST_PARTICIPANT,
+	                                                    buffer, sizeof(buffer),
+	                                                    TRUE);
+	g_assert_cmpint(ret, ==, 6);
+	g_assert_cmpmem(buffer, sizeof(buffer), "hello ", 6);
+
+	/* Only what the copying read left behind is handed out. */
+	received = purple_media_manager_receive_application_bytes(loopback.manager,
+	                                                          loopback.media,
+	                                                          TEST_SESSION,
+	                                                          TEST_PARTICIPANT,
+	                                                          FALSE);
+	g_assert_nonnull(received);
+	g_assert_cmpmem(g_bytes_get_data(received, NULL),
+	                g_bytes_get_size(received), "world", 5);
+	g_bytes_unref(received);
+
+	test_media_loopback_clear(&loopback);
+}
+
+static void
+test_media_manager_application_bytes_no_session(void) {
+	PurpleMediaManager *manager = purple_media_manager_get();
+	PurpleMedia *media = NULL;
+	GBytes *bytes = NULL;
+	gint ret = 0;
+
+	media = g_object_new(PURPLE_TYPE_MEDIA, "manager", manager, NULL);
+	bytes = g_bytes_new_static("hello", 5);
+
+	ret = purple_media_manager_send_application_bytes(manager, media,
+	                                                  TEST_SESSION,
+	                                                  TEST_PARTICIPANT, bytes,
+	                                                  FALSE);
+	g_assert_cmpint(ret, ==, -1);
+
+	g_assert_null(purple_media_manager_receive_application_bytes(manager,
+	                                                             media,
+	                                                             TEST_SESSION,
+	                                                             TEST_PARTICIPANT,
+	                                                             FALSE));
+
+	g_bytes_unref(bytes);
+	g_clear_object(&media);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+gint
+main(gint argc, gchar **argv) {
+	g_test_init(&argc, &argv, NULL);
+
+	test_ui_purple_init();
+
+	g_test_add_func("/media-manager/application-bytes/round-trip",
+	                test_media_manager_application_bytes_round_trip);
+	g_test_add_func("/media-manager/application-bytes/remainder",
+	                test_media_manager_application_bytes_remainder);
+	g_test_add_func("/media-manager/application-bytes/no-session",
+	                test_media_manager_application_bytes_no_session);
+
+	return g_test_run();
+}
@@ -94,6 +94,65 @@ test_purple_message_properties(void) {
 	g_clear_object(&message);
 }
 
+static void
+test_purple_message_attachments_empty(void) {
+	PurpleMessage *message = NULL;
+
+	message = g_object_new(PURPLE_TYPE_MESSAGE, NULL);
+
+	g_assert_null(purple_message_get_attachment(message, 1));
+	g_assert_false(purple_message_remove_attachment(message, 1));
+	purple_message_clear_attachments(message);
+
+	g_clear_object(&message);
+}
+
+static void
+test_purple_message_new_batch(void) {
+	PurpleMessageEntry entries[] = {
+		{
+			.id = "1", .author = "pidgy", .recipient = "me",
+			.contents = "first", .flags = PURPLE_MESSAGE_RECV,
+		}, {
+			.id = "2", .author = "pidgy", .recipient = "me",
+			.contents = "second", .flags = PURPLE_MESSAGE_RECV,
+		}, {
+			.id = "3", .author = "me", .author_alias = "Me",
+			.recipient = "pidgy", .contents = "third",
+			.content_type = PURPLE_MESSAGE_CONTENT_TYPE_MARKDOWN,
+			.flags = PURPLE_MESSAGE_SEND,
+		},
+	};
+	GPtrArray *messages = NULL;
+	PurpleMessage *message = NULL;
+
+	messages = purple_message_new_batch(entries, G_N_ELEMENTS(entries));
+	g_assert_nonnull(messages);
+	g_assert_cmpuint(messages->len, ==, G_N_ELEMENTS(entries));
+
+	message = g_ptr_array_index(messages, 0);
+	g_assert_cmpstr(purple_message_get_id(message), ==, "1");
+	g_assert_cmpstr(purple_message_get_author(message), ==, "pidgy");
+	g_assert_cmpstr(purple_message_get_author_alias(message), ==, "pidgy");
+	g_assert_cmpstr(purple_message_get_contents(message), ==, "first");
+	g_assert_nonnull(purple_message_get_timestamp(message));
+
+	/* Runs of the same author share a single string. */
+	g_assert_true(purple_message_get_author(message) ==
+	              purple_message_get_author(g_ptr_array_index(messages, 1)));
+
+	message = g_ptr_array_index(messages, 2);
+	g_assert_cmpstr(purple_message_get_author(message), ==, "me");
+	g_assert_cmpstr(purple_message_get_author_alias(message), ==, "Me");
+	g_assert_cmpstr(purple_message_get_recipient(message), ==, "pidgy");
+	g_assert_cmpint(purple_message_get_content_type(message), ==,
+	                PURPLE_MESSAGE_CONTENT_TYPE_MARKDOWN);
+	g_assert_cmpint(purple_message_get_flags(message), ==,
+	                PURPLE_MESSAGE_SEND);
+
+	g_ptr_array_unref(messages);
+}
+
 /******************************************************************************
  * Main
  *****************************************************************************/
@@ -103,6 +162,10 @@ main(gint argc, gchar *argv[]) {
 
 	g_test_add_func("/message/properties",
 	                test_purple_message_properties);
+	g_test_add_func("/message/attachments/empty",
+	                test_purple_message_attachments_empty);
+	g_test_add_func("/message/new-batch",
+	                test_purple_message_new_batch);
 
 	return g_test_run();
 }
@@ -489,6 +489,31 @@ test_purple_person_matches_contact_info(void) {
 	g_clear_object(&person);
 }
 
+static void
+test_purple_person_matches_search_key_updates(void) {
+	PurplePerson *person = purple_person_new();
+	PurpleContactInfo *info = purple_contact_info_new(NULL);
+	char *key = purple_str_search_key("ÉCLAIR");
+
+	purple_person_add_contact_info(person, info);
+
+	g_assert_false(purple_person_matches_search_key(person, key));
+
+	/* The keys follow the names as they change. */
+	purple_contact_info_set_alias(info, "Chocolate éclair");
+	g_assert_true(purple_person_matches_search_key(person, key));
+
+	purple_contact_info_set_alias(info, NULL);
+	g_assert_false(purple_person_matches_search_key(person, key));
+
+	purple_person_set_alias(person, "eclair? no, Éclair");
+	g_assert_true(purple_person_matches_search_key(person, key));
+
+	g_free(key);
+	g_clear_object(&info);
+	g_clear_object(&person);
+}
+
 /******************************************************************************
  * Main
  *****************************************************************************/
@@ -531,6 +556,8 @@ main(gint argc, gchar *argv[]) {
 	                test_purple_person_matches_alias);
 	g_test_add_func("/person/matches/contact_info",
 	                test_purple_person_matches_contact_info);
+	g_test_add_func("/person/matches/search_key_updates",
+	                test_purple_person_matches_search_key_updates);
 
 	return g_test_run();
 }
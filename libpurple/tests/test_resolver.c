@@ -0,0 +1,344 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include <purple.h>
+
+#include "test_ui.h"
+
+/******************************************************************************
+ * TestResolver
+ *****************************************************************************/
+#define TEST_TYPE_RESOLVER (test_resolver_get_type())
+G_DECLARE_FINAL_TYPE(TestResolver, test_resolver, TEST, RESOLVER, GResolver)
+
+struct _TestResolver {
+	GResolver parent;
+
+	guint lookups;
+};
+
+G_DEFINE_TYPE(TestResolver, test_resolver, G_TYPE_RESOLVER)
+
+static void
+test_resolver_lookup_by_name_with_flags_async(GResolver *resolver,
+                                              const gchar *hostname,
+                                              G_GNUC_UNUSED GResolverNameLookupFlags flags,
+                                              GCancellable *cancellable,
+                                              GAsyncReadyCallback callback,
+                                              gpointer data)
+{
+	TestResolver *test_resolver = TEST_RESOLVER(resolver);
+	GTask *task = NULL;
+	GList *addresses = NULL;
+
+	test_resolver->lookups++;
+
+	task = g_task_new(resolver, cancellable, callback, data);
+
+	if(g_str_equal(hostname, "missing.example.com")) {
+		g_task_return_new_error(task, G_RESOLVER_ERROR,
+		                        G_RESOLVER_ERROR_NOT_FOUND, "not found");
+	} else {
+		addresses = g_list_append(NULL,
+		                          g_inet_address_new_from_string("192.0.2.1"));
+		g_task_return_pointer(task, addresses,
+		                      (GDestroyNotify)g_resolver_free_addresses);
+	}
+
+	g_object_unref(task);
+}
+
+static GList *
+test_resolver_lookup_by_name_with_flags_finish(GResolver *resolver,
+                                               GAsyncResult *result,
+                                               GError **error)
+{
+	g_return_val_if_fail(g_task_is_valid(result, resolver), NULL);
+
+	return g_task_propagate_pointer(G_TASK(result), error);
+}
+
+static void
+test_resolver_lookup_by_name_async(GResolver *resolver, const gchar *hostname,
+                                   GCancellable *cancellable,
+                                   GAsyncReadyCallback callback,
+                                   gpointer data)
+{
+	test_resolver_lookup_by_name_with_flags_async(resolver, hostname,
+	                                              G_RESOLVER_NAME_LOOKUP_FLAGS_DEFAULT,
+	                                              cancellable, callback, data);
+}
+
+static void
+test_resolver_init(G_GNUC_UNUSED TestResolver *resolver) {
+}
+
+static void
+test_resolver_class_init(TestResolverClass *klass) {
+	GResolverClass *resolver_class = G_RESOLVER_CLASS(klass);
+
+	resolver_class->lookup_by_name_async = test_resolver_lookup_by_name_async;
+	resolver_class->lookup_by_name_finish =
+		test_resolver_lookup_by_name_with_flags_finish;
+	resolver_class->lookup_by_name_with_flags_async =
+		test_resolver_lookup_by_name_with_flags_async;
+	resolver_class->lookup_by_name_with_flags_finish =
+		test_resolver_lookup_by_name_with_flags_finish;
+}
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+typedef struct {
+	GMainLoop *loop;
+	guint pending;
+	guint found;
+	guint not_found;
+	guint cancelled;
+} TestPurpleResolverData;
+
+static void
+test_purple_resolver_lookup_cb(GObject *source, GAsyncResult *result,
+                               gpointer data)
+{
+	TestPurpleResolverData *test_data = data;
+	GError *error = NULL;
+	GList *addresses = NULL;
+
+	addresses = g_resolver_lookup_by_name_finish(G_RESOLVER(source), result,
+	                                             &error);
+	if(g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		g_clear_error(&error);
+
+		test_data->cancelled++;
+	} else if(error != NULL) {
+		g_assert_error(error, G_RESOLVER_ERROR, G_RESOLVER_ERROR_NOT_FOUND);
+		g_clear_error(&error);
+
+		test_data->not_found++;
+	} else {
+		g_assert_cmpuint(g_list_length(addresses), ==, 1);
+		g_resolver_free_addresses(addresses);
+
+		test_data->found++;
+	}
+
+	test_data->pending--;
+	if(test_data->pending == 0) {
+		g_main_loop_quit(test_data->loop);
+	}
+}
+
+static void
+test_purple_resolver_lookup_full(PurpleResolver *resolver,
+                                 const gchar *hostname,
+                                 GCancellable *cancellable,
+                                 TestPurpleResolverData *data)
+{
+	data->pending++;
+
+	g_resolver_lookup_by_name_async(G_RESOLVER(resolver), hostname,
+	                                cancellable,
+	                                test_purple_resolver_lookup_cb, data);
+}
+
+static void
+test_purple_resolver_lookup(PurpleResolver *resolver, const gchar *hostname,
+                            TestPurpleResolverData *data)
+{
+	test_purple_resolver_lookup_full(resolver, hostname, NULL, data);
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_purple_resolver_get_default(void) {
+	PurpleResolver *resolver = NULL;
+	GResolver *default_resolver = NULL;
+
+	resolver = purple_resolver_get_default();
+	g_assert_true(PURPLE_IS_RESOLVER(resolver));
+
+	default_resolver = g_resolver_get_default();
+	g_assert_true(G_RESOLVER(resolver) == default_resolver);
+	g_object_unref(default_resolver);
+}
+
+static void
+test_purple_resolver_coalesce(void) {
+	TestResolver *inner = NULL;
+	PurpleResolver *resolver = NULL;
+	TestPurpleResolverData data = { NULL, };
+
+	inner = g_object_new(TEST_TYPE_RESOLVER, NULL);
+	resolver = purple_resolver_new(G_RESOLVER(inner));
+	data.loop = g_main_loop_new(NULL, FALSE);
+
+	/* The second lookup waits for the first one. */
+	test_purple_resolver_lookup(resolver, "example.com", &data);
+	test_purple_resolver_lookup(resolver, "EXAMPLE.com", &data);
+	g_main_loop_run(data.loop);
+
+	g_assert_cmpuint(data.found, ==, 2);
+	g_assert_cmpuint(inner->lookups, ==, 1);
+
+	/* A different name is a different lookup. */
+	test_purple_resolver_lookup(resolver, "example.org", &data);
+	g_main_loop_run(data.loop);
+
+	g_assert_cmpuint(data.found, ==, 3);
+	g_assert_cmpuint(inner->lookups, ==, 2);
+
+	g_main_loop_unref(data.loop);
+	g_clear_object(&resolver);
+	g_clear_object(&inner);
+}
+
+static void
+test_purple_resolver_cache(void) {
+	TestResolver *inner = NULL;
+	PurpleResolver *resolver = NULL;
+	TestPurpleResolverData data = { NULL, };
+
+	inner = g_object_new(TEST_TYPE_RESOLVER, NULL);
+	resolver = purple_resolver_new(G_RESOLVER(inner));
+	data.loop = g_main_loop_new(NULL, FALSE);
+
+	test_purple_resolver_lookup(resolver, "example.com", &data);
+	g_main_loop_run(data.loop);
+	test_purple_resolver_lookup(resolver, "example.com", &data);
+	g_main_loop_run(data.loop);
+
+	g_assert_cmpuint(data.found, ==, 2);
+	g_assert_cmpuint(inner->lookups, ==, 1);
+
+	/* Names that don't exist are cached too. */
+	test_purple_resolver_lookup(resolver, "missing.example.com", &data);
+	g_main_loop_run(data.loop);
+	test_purple_resolver_lookup(resolver, "missing.example.com", &data);
+	g_main_loop_run(data.loop);
+
+	g_assert_cmpuint(data.not_found, ==, 2);
+	g_assert_cmpuint(inner->lookups, ==, 2);
+
+	/* Clearing the cache makes the next lookup ask again. */
+	purple_resolver_clear_cache(resolver);
+	test_purple_resolver_lookup(resolver, "example.com", &data);
+	g_main_loop_run(data.loop);
+
+	g_assert_cmpuint(data.found, ==, 3);
+	g_assert_cmpuint(inner->lookups, ==, 3);
+
+	/* So does reloading the resolver. */
+	g_signal_emit_by_name(inner, "reload");
+	test_purple_resolver_lookup(resolver, "example.com", &data);
+	g_main_loop_run(data.loop);
+
+	g_assert_cmpuint(data.found, ==, 4);
+	g_assert_cmpuint(inner->lookups, ==, 4);
+
+	g_main_loop_unref(data.loop);
+	g_clear_object(&resolver);
+	g_clear_object(&inner);
+}
+
+static void
+test_purple_resolver_lookup_after_clear(void) {
+	TestResolver *inner = NULL;
+	PurpleResolver *resolver = NULL;
+	TestPurpleResolverData data = { NULL, };
+
+	inner = g_object_new(TEST_TYPE_RESOLVER, NULL);
+	resolver = purple_resolver_new(G_RESOLVER(inner));
+	data.loop = g_main_loop_new(NULL, FALSE);
+
+	test_purple_resolver_lookup(resolver, "example.com", &data);
+	g_main_loop_run(data.loop);
+
+	g_assert_cmpuint(data.found, ==, 1);
+	g_assert_cmpuint(inner->lookups, ==, 1);
+
+	/* The finished lookup must not be joined by the ones after a miss. */
+	for(guint i = 0; i < 3; i++) {
+		purple_resolver_clear_cache(resolver);
+
+		test_purple_resolver_lookup(resolver, "example.com", &data);
+		test_purple_resolver_lookup(resolver, "example.com", &data);
+		g_main_loop_run(data.loop);
+
+		g_assert_cmpuint(data.found, ==, 3 + i * 2);
+		g_assert_cmpuint(inner->lookups, ==, 2 + i);
+	}
+
+	g_main_loop_unref(data.loop);
+	g_clear_object(&resolver);
+	g_clear_object(&inner);
+}
+
+static void
+test_purple_resolver_lookup_after_cancel(void) {
+	TestResolver *inner = NULL;
+	PurpleResolver *resolver = NULL;
+	GCancellable *cancellable = NULL;
+	TestPurpleResolverData data = { NULL, };
+
+	inner = g_object_new(TEST_TYPE_RESOLVER, NULL);
+	resolver = purple_resolver_new(G_RESOLVER(inner));
+	cancellable = g_cancellable_new();
+	data.loop = g_main_loop_new(NULL, FALSE);
+
+	test_purple_resolver_lookup_full(resolver, "example.com", cancellable,
+	                                 &data);
+	g_cancellable_cancel(cancellable);
+
+	/* The cancelled lookup hasn't finished yet, but this must not join it. */
+	test_purple_resolver_lookup(resolver, "example.com", &data);
+	g_main_loop_run(data.loop);
+
+	g_assert_cmpuint(data.cancelled, ==, 1);
+	g_assert_cmpuint(data.found, ==, 1);
+	g_assert_cmpuint(inner->lookups, ==, 2);
+
+	g_main_loop_unref(data.loop);
+	g_clear_object(&cancellable);
+	g_clear_object(&resolver);
+	g_clear_object(&inner);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+gint
+main(gint argc, gchar *argv[]) {
+	g_test_init(&argc, &argv, NULL);
+
+	test_ui_purple_init();
+
+	g_test_add_func("/resolver/get-default", test_purple_resolver_get_default);
+	g_test_add_func("/resolver/coalesce", test_purple_resolver_coalesce);
+	g_test_add_func("/resolver/cache", test_purple_resolver_cache);
+	g_test_add_func("/resolver/lookup-after-clear",
+	                test_purple_resolver_lookup_after_clear);
+	g_test_add_func("/resolver/lookup-after-cancel",
+	                test_purple_resolver_lookup_after_cancel);
+
+	return g_test_run();
+}
@@ -0,0 +1,411 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include <purple.h>
+
+#include "test_ui.h"
+
+/******************************************************************************
+ * TestPurpleRoomlistProtocol
+ *****************************************************************************/
+
+/* Only knows how to list every room. */
+#define TEST_PURPLE_TYPE_ROOMLIST_PROTOCOL \
+	(test_purple_roomlist_protocol_get_type())
+G_DECLARE_FINAL_TYPE(TestPurpleRoomlistProtocol,
+                     test_purple_roomlist_protocol, TEST_PURPLE,
+                     ROOMLIST_PROTOCOL, PurpleProtocol)
+
+struct _TestPurpleRoomlistProtocol {
+	PurpleProtocol parent;
+};
+
+static PurpleRoomlist *
+test_purple_roomlist_protocol_get_list(G_GNUC_UNUSED PurpleProtocolRoomlist *roomlist,
+                                       PurpleConnection *connection)
+{
+	return purple_roomlist_new(purple_connection_get_account(connection));
+}
+
+static void
+test_purple_roomlist_protocol_roomlist_init(PurpleProtocolRoomlistInterface *iface) {
+	iface->get_list = test_purple_roomlist_protocol_get_list;
+}
+
+G_DEFINE_TYPE_WITH_CODE(TestPurpleRoomlistProtocol,
+                        test_purple_roomlist_protocol, PURPLE_TYPE_PROTOCOL,
+                        G_IMPLEMENT_INTERFACE(PURPLE_TYPE_PROTOCOL_ROOMLIST,
+                                              test_purple_roomlist_protocol_roomlist_init))
+
+static void
+test_purple_roomlist_protocol_init(G_GNUC_UNUSED TestPurpleRoomlistProtocol *protocol) {
+}
+
+static void
+test_purple_roomlist_protocol_class_init(G_GNUC_UNUSED TestPurpleRoomlistProtocolClass *klass) {
+}
+
+/******************************************************************************
+ * TestPurpleRoomlistQueryProtocol
+ *****************************************************************************/
+
+/* Takes the query itself and prefixes the filter like IRC does. */
+#define TEST_PURPLE_TYPE_ROOMLIST_QUERY_PROTOCOL \
+	(test_purple_roomlist_query_protocol_get_type())
+G_DECLARE_FINAL_TYPE(TestPurpleRoomlistQueryProtocol,
+                     test_purple_roomlist_query_protocol, TEST_PURPLE,
+                     ROOMLIST_QUERY_PROTOCOL, PurpleProtocol)
+
+struct _TestPurpleRoomlistQueryProtocol {
+	PurpleProtocol parent;
+
+	gchar *filter;
+	guint min_users;
+};
+
+static PurpleRoomlist *
+test_purple_roomlist_query_protocol_get_list(G_GNUC_UNUSED PurpleProtocolRoomlist *roomlist,
+                                             G_GNUC_UNUSED PurpleConnection *connection)
+{
+	g_assert_not_reached();
+
+	return NULL;
+}
+
+static PurpleRoomlist *
+test_purple_roomlist_query_protocol_query_list(PurpleProtocolRoomlist *roomlist,
+                                               PurpleConnection *connection,
+                                               const gchar *filter,
+                                               guint min_users)
+{
+	TestPurpleRoomlistQueryProtocol *protocol = NULL;
+	PurpleRoomlist *list = NULL;
+	gchar *mask = NULL;
+
+	protocol = TEST_PURPLE_ROOMLIST_QUERY_PROTOCOL(roomlist);
+
+	g_free(protocol->filter);
+	protocol->filter = g_strdup(filter);
+	protocol->min_users = min_users;
+
+	list = purple_roomlist_new(purple_connection_get_account(connection));
+
+	mask = g_strdup_printf("#%s", filter);
+	purple_roomlist_set_filter(list, mask);
+	g_free(mask);
+
+	return list;
+}
+
+static void
+test_purple_roomlist_query_protocol_roomlist_init(PurpleProtocolRoomlistInterface *iface) {
+	iface->get_list = test_purple_roomlist_query_protocol_get_list;
+	iface->query_list = test_purple_roomlist_query_protocol_query_list;
+}
+
+G_DEFINE_TYPE_WITH_CODE(TestPurpleRoomlistQueryProtocol,
+                        test_purple_roomlist_query_protocol,
+                        PURPLE_TYPE_PROTOCOL,
+                        G_IMPLEMENT_INTERFACE(PURPLE_TYPE_PROTOCOL_ROOMLIST,
+                                              test_purple_roomlist_query_protocol_roomlist_init))
+
+static void
+test_purple_roomlist_query_protocol_init(G_GNUC_UNUSED TestPurpleRoomlistQueryProtocol *protocol) {
+}
+
+static void
+test_purple_roomlist_query_protocol_finalize(GObject *obj) {
+	TestPurpleRoomlistQueryProtocol *protocol = NULL;
+
+	protocol = TEST_PURPLE_ROOMLIST_QUERY_PROTOCOL(obj);
+	g_free(protocol->filter);
+
+	G_OBJECT_CLASS(test_purple_roomlist_query_protocol_parent_class)->finalize(obj);
+}
+
+static void
+test_purple_roomlist_query_protocol_class_init(TestPurpleRoomlistQueryProtocolClass *klass) {
+	GObjectClass *obj_class = G_OBJECT_CLASS(klass);
+
+	obj_class->finalize = test_purple_roomlist_query_protocol_finalize;
+}
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static void
+test_purple_roomlist_items_changed_cb(G_GNUC_UNUSED GListModel *model,
+                                      G_GNUC_UNUSED guint position,
+                                      guint removed, guint added,
+                                      gpointer data)
+{
+	guint *counter = data;
+
+	g_assert_cmpuint(removed, ==, 0);
+	g_assert_cmpuint(added, >, 0);
+
+	*counter = *counter + 1;
+}
+
+static void
+test_purple_roomlist_add(PurpleRoomlist *list, const gchar *name,
+                         guint user_count)
+{
+	PurpleRoomlistRoom *room = purple_roomlist_room_new(name, NULL);
+
+	purple_roomlist_room_set_user_count(room, user_count);
+	purple_roomlist_room_add(list, room);
+	g_object_unref(room);
+}
+
+static PurpleRoomlist *
+test_purple_roomlist_new(void) {
+	PurpleAccount *account = purple_account_new("test", "test");
+	PurpleRoomlist *list = purple_roomlist_new(account);
+
+	g_object_unref(account);
+
+	return list;
+}
+
+static PurpleConnection *
+test_purple_roomlist_connection_new(PurpleProtocol *protocol) {
+	PurpleAccount *account = NULL;
+	PurpleConnection *connection = NULL;
+
+	account = purple_account_new("test", purple_protocol_get_id(protocol));
+	connection = g_object_new(PURPLE_TYPE_CONNECTION,
+	                          "account", account,
+	                          "protocol", protocol,
+	                          NULL);
+	purple_connection_set_state(connection,
+	                            PURPLE_CONNECTION_STATE_CONNECTED);
+	g_object_unref(account);
+
+	return connection;
+}
+
+static void
+test_purple_roomlist_connection_free(PurpleConnection *connection) {
+	purple_connection_disconnect(connection, NULL);
+	g_object_unref(connection);
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_purple_roomlist_batch_size(void) {
+	PurpleRoomlist *list = test_purple_roomlist_new();
+	guint counter = 0;
+
+	g_signal_connect(list, "items-changed",
+	                 G_CALLBACK(test_purple_roomlist_items_changed_cb),
+	                 &counter);
+
+	purple_roomlist_set_in_progress(list, TRUE);
+
+	/* Every full batch goes into the model in one go. */
+	for(guint i = 0; i < 2500; i++) {
+		gchar *name = g_strdup_printf("#room%u", i);
+
+		test_purple_roomlist_add(list, name, 0);
+		g_free(name);
+	}
+	g_assert_cmpuint(g_list_model_get_n_items(G_LIST_MODEL(list)), ==, 2000);
+	g_assert_cmpuint(counter, ==, 2);
+
+	/* The rest goes in when the listing stops. */
+	purple_roomlist_set_in_progress(list, FALSE);
+	g_assert_cmpuint(g_list_model_get_n_items(G_LIST_MODEL(list)), ==, 2500);
+	g_assert_cmpuint(counter, ==, 3);
+
+	g_clear_object(&list);
+}
+
+static void
+test_purple_roomlist_batch_timeout(void) {
+	PurpleRoomlist *list = test_purple_roomlist_new();
+	guint counter = 0;
+
+	g_signal_connect(list, "items-changed",
+	                 G_CALLBACK(test_purple_roomlist_items_changed_cb),
+	                 &counter);
+
+	purple_roomlist_set_in_progress(list, TRUE);
+
+	test_purple_roomlist_add(list, "#one", 0);
+	test_purple_roomlist_add(list, "#two", 0);
+	test_purple_roomlist_add(list, "#three", 0);
+	g_assert_cmpuint(g_list_model_get_n_items(G_LIST_MODEL(list)), ==, 0);
+
+	/* A listing that trickles in still shows up without waiting for it to
+	 * end. */
+	while(counter == 0) {
+		g_main_context_iteration(NULL, TRUE);
+	}
+
+	g_assert_cmpuint(counter, ==, 1);
+	g_assert_cmpuint(g_list_model_get_n_items(G_LIST_MODEL(list)), ==, 3);
+
+	g_clear_object(&list);
+}
+
+static void
+test_purple_roomlist_filter_substring(void) {
+	PurpleRoomlist *list = test_purple_roomlist_new();
+	PurpleRoomlistRoom *room = NULL;
+
+	purple_roomlist_set_filter(list, "FOO");
+	g_assert_cmpstr(purple_roomlist_get_filter(list), ==, "foo");
+
+	test_purple_roomlist_add(list, "#FooBar", 0);
+	test_purple_roomlist_add(list, "#bar", 0);
+	test_purple_roomlist_add(list, "#barfoo", 0);
+	purple_roomlist_set_in_progress(list, FALSE);
+
+	g_assert_cmpuint(g_list_model_get_n_items(G_LIST_MODEL(list)), ==, 2);
+
+	room = g_list_model_get_item(G_LIST_MODEL(list), 0);
+	g_assert_cmpstr(purple_roomlist_room_get_name(room), ==, "#FooBar");
+	g_clear_object(&room);
+
+	room = g_list_model_get_item(G_LIST_MODEL(list), 1);
+	g_assert_cmpstr(purple_roomlist_room_get_name(room), ==, "#barfoo");
+	g_clear_object(&room);
+
+	g_clear_object(&list);
+}
+
+static void
+test_purple_roomlist_filter_pattern(void) {
+	PurpleRoomlist *list = test_purple_roomlist_new();
+	PurpleRoomlistRoom *room = NULL;
+
+	purple_roomlist_set_filter(list, "#foo*");
+
+	test_purple_roomlist_add(list, "#foobar", 0);
+	test_purple_roomlist_add(list, "#barfoo", 0);
+	test_purple_roomlist_add(list, "foo", 0);
+	purple_roomlist_set_in_progress(list, FALSE);
+
+	g_assert_cmpuint(g_list_model_get_n_items(G_LIST_MODEL(list)), ==, 1);
+
+	room = g_list_model_get_item(G_LIST_MODEL(list), 0);
+	g_assert_cmpstr(purple_roomlist_room_get_name(room), ==, "#foobar");
+	g_clear_object(&room);
+
+	g_clear_object(&list);
+}
+
+static void
+test_purple_roomlist_filter_min_users(void) {
+	PurpleRoomlist *list = test_purple_roomlist_new();
+
+	purple_roomlist_set_min_users(list, 5);
+
+	test_purple_roomlist_add(list, "#quiet", 4);
+	test_purple_roomlist_add(list, "#enough", 5);
+	test_purple_roomlist_add(list, "#busy", 500);
+	purple_roomlist_set_in_progress(list, FALSE);
+
+	g_assert_cmpuint(g_list_model_get_n_items(G_LIST_MODEL(list)), ==, 2);
+
+	g_clear_object(&list);
+}
+
+static void
+test_purple_roomlist_query_fallback(void) {
+	PurpleProtocol *protocol = NULL;
+	PurpleConnection *connection = NULL;
+	PurpleRoomlist *list = NULL;
+
+	protocol = g_object_new(TEST_PURPLE_TYPE_ROOMLIST_PROTOCOL,
+	                        "id", "test-roomlist", NULL);
+	connection = test_purple_roomlist_connection_new(protocol);
+
+	/* The protocol can't filter, so the list does it. */
+	list = purple_roomlist_query(connection, "foo", 3);
+	g_assert_true(PURPLE_IS_ROOMLIST(list));
+	g_assert_cmpstr(purple_roomlist_get_filter(list), ==, "foo");
+	g_assert_cmpuint(purple_roomlist_get_min_users(list), ==, 3);
+
+	test_purple_roomlist_add(list, "#foo", 3);
+	test_purple_roomlist_add(list, "#foo-quiet", 2);
+	test_purple_roomlist_add(list, "#bar", 10);
+	purple_roomlist_set_in_progress(list, FALSE);
+	g_assert_cmpuint(g_list_model_get_n_items(G_LIST_MODEL(list)), ==, 1);
+
+	g_clear_object(&list);
+	test_purple_roomlist_connection_free(connection);
+	g_clear_object(&protocol);
+}
+
+static void
+test_purple_roomlist_query_protocol(void) {
+	TestPurpleRoomlistQueryProtocol *protocol = NULL;
+	PurpleConnection *connection = NULL;
+	PurpleRoomlist *list = NULL;
+
+	protocol = g_object_new(TEST_PURPLE_TYPE_ROOMLIST_QUERY_PROTOCOL,
+	                        "id", "test-roomlist-query", NULL);
+	connection = test_purple_roomlist_connection_new(PURPLE_PROTOCOL(protocol));
+
+	list = purple_roomlist_query(connection, "foo*", 3);
+	g_assert_true(PURPLE_IS_ROOMLIST(list));
+	g_assert_cmpstr(protocol->filter, ==, "foo*");
+	g_assert_cmpuint(protocol->min_users, ==, 3);
+
+	/* What the protocol set up is left alone. */
+	g_assert_cmpstr(purple_roomlist_get_filter(list), ==, "#foo*");
+	g_assert_cmpuint(purple_roomlist_get_min_users(list), ==, 0);
+
+	g_clear_object(&list);
+	test_purple_roomlist_connection_free(connection);
+	g_clear_object(&protocol);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+gint
+main(gint argc, gchar *argv[]) {
+	g_test_init(&argc, &argv, NULL);
+
+	test_ui_purple_init();
+
+	g_test_add_func("/roomlist/batch/size", test_purple_roomlist_batch_size);
+	g_test_add_func("/roomlist/batch/timeout",
+	                test_purple_roomlist_batch_timeout);
+
+	g_test_add_func("/roomlist/filter/substring",
+	                test_purple_roomlist_filter_substring);
+	g_test_add_func("/roomlist/filter/pattern",
+	                test_purple_roomlist_filter_pattern);
+	g_test_add_func("/roomlist/filter/min-users",
+	                test_purple_roomlist_filter_min_users);
+
+	g_test_add_func("/roomlist/query/fallback",
+	                test_purple_roomlist_query_fallback);
+	g_test_add_func("/roomlist/query/protocol",
+	                test_purple_roomlist_query_protocol);
+
+	return g_test_run();
+}
@@ -0,0 +1,334 @@
+/*
+ * Purple - Internet Messaging Library
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include <purple.h>
+
+#include "test_ui.h"
+
+/******************************************************************************
+ * TestTlsConnection
+ *****************************************************************************/
+#define TEST_TYPE_TLS_CONNECTION (test_tls_connection_get_type())
+G_DECLARE_FINAL_TYPE(TestTlsConnection, test_tls_connection, TEST,
+                     TLS_CONNECTION, GTlsConnection)
+
+struct _TestTlsConnection {
+	GTlsConnection parent;
+
+	GIOStream *base;
+	GSocketConnectable *identity;
+	GTlsProtocolVersion version;
+
+	/* Stands in for the session data of a real connection. */
+	guint session;
+};
+
+enum {
+	PROP_0,
+	PROP_BASE_IO_STREAM,
+	PROP_REQUIRE_CLOSE_NOTIFY,
+	PROP_REHANDSHAKE_MODE,
+	PROP_USE_SYSTEM_CERTDB,
+	PROP_PROTOCOL_VERSION,
+	PROP_VALIDATION_FLAGS,
+	PROP_SERVER_IDENTITY,
+	PROP_USE_SSL3,
+	PROP_ACCEPTED_CAS,
+};
+
+static gboolean
+test_tls_connection_initable_init(G_GNUC_UNUSED GInitable *initable,
+                                  G_GNUC_UNUSED GCancellable *cancellable,
+                                  G_GNUC_UNUSED GError **error)
+{
+	return TRUE;
+}
+
+static void
+test_tls_connection_initable_iface_init(GInitableIface *iface) {
+	iface->init = test_tls_connection_initable_init;
+}
+
+static void
+test_tls_connection_copy_session_state(GTlsClientConnection *conn,
+                                       GTlsClientConnection *source)
+{
+	TEST_TLS_CONNECTION(conn)->session = TEST_TLS_CONNECTION(source)->session;
+}
+
+static void
+test_tls_connection_client_iface_init(GTlsClientConnectionInterface *iface) {
+	iface->copy_session_state = test_tls_connection_copy_session_state;
+}
+
+G_DEFINE_TYPE_WITH_CODE(TestTlsConnection, test_tls_connection,
+                        G_TYPE_TLS_CONNECTION,
+                        G_IMPLEMENT_INTERFACE(G_TYPE_INITABLE,
+                                              test_tls_connection_initable_iface_init)
+                        G_IMPLEMENT_INTERFACE(G_TYPE_TLS_CLIENT_CONNECTION,
+                                              test_tls_connection_client_iface_init))
+
+static GInputStream *
+test_tls_connection_get_input_stream(GIOStream *stream) {
+	return g_io_stream_get_input_stream(TEST_TLS_CONNECTION(stream)->base);
+}
+
+static GOutputStream *
+test_tls_connection_get_output_stream(GIOStream *stream) {
+	return g_io_stream_get_output_stream(TEST_TLS_CONNECTION(stream)->base);
+}
+
+static void
+test_tls_connection_get_property(GObject *obj, guint param_id, GValue *value,
+                                 GParamSpec *pspec)
+{
+	TestTlsConnection *connection = TEST_TLS_CONNECTION(obj);
+
+	switch(param_id) {
+		case PROP_BASE_IO_STREAM:
+			g_value_set_object(value, connection->base);
+			break;
+		case PROP_PROTOCOL_VERSION:
+			g_value_set_enum(value, connection->version);
+			break;
+		case PROP_SERVER_IDENTITY:
+			g_value_set_object(value, connection->identity);
+			break;
+		case PROP_REQUIRE_CLOSE_NOTIFY:
+		case PROP_REHANDSHAKE_MODE:
+		case PROP_USE_SYSTEM_CERTDB:
+		case PROP_VALIDATION_FLAGS:
+		case PROP_USE_SSL3:
+		case PROP_ACCEPTED_CAS:
+			g_param_value_set_default(pspec, value);
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, param_id, pspec);
+			break;
+	}
+}
+
+static void
+test_tls_connection_set_property(GObject *obj, guint param_id,
+                                 const GValue *value, GParamSpec *pspec)
+{
+	TestTlsConnection *connection = TEST_TLS_CONNECTION(obj);
+
+	switch(param_id) {
+		case PROP_BASE_IO_STREAM:
+			g_set_object(&connection->base, g_value_get_object(value));
+			break;
+		case PROP_SERVER_IDENTITY:
+			g_set_object(&connection->identity, g_value_get_object(value));
+			break;
+		case PROP_REQUIRE_CLOSE_NOTIFY:
+		case PROP_REHANDSHAKE_MODE:
+		case PROP_USE_SYSTEM_CERTDB:
+		case PROP_VALIDATION_FLAGS:
+		case PROP_USE_SSL3:
+			break;
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, param_id, pspec);
+			break;
+	}
+}
+
+static void
+test_tls_connection_finalize(GObject *obj) {
+	TestTlsConnection *connection = TEST_TLS_CONNECTION(obj);
+
+	g_clear_object(&connection->base);
+	g_clear_object(&connection->identity);
+
+	G_OBJECT_CLASS(test_tls_connection_parent_class)->finalize(obj);
+}
+
+static void
+test_tls_connection_init(G_GNUC_UNUSED TestTlsConnection *connection) {
+}
+
+static void
+test_tls_connection_class_init(TestTlsConnectionClass *klass) {
+	GObjectClass *obj_class = G_OBJECT_CLASS(klass);
+	GIOStreamClass *stream_class = G_IO_STREAM_CLASS(klass);
+
+	obj_class->get_property = test_tls_connection_get_property;
+	obj_class->set_property = test_tls_connection_set_property;
+	obj_class->finalize = test_tls_connection_finalize;
+
+	stream_class->get_input_stream = test_tls_connection_get_input_stream;
+	stream_class->get_output_stream = test_tls_connection_get_output_stream;
+
+	g_object_class_override_property(obj_class, PROP_BASE_IO_STREAM,
+	                                 "base-io-stream");
+	g_object_class_override_property(obj_class, PROP_REQUIRE_CLOSE_NOTIFY,
+	                                 "require-close-notify");
+	g_object_class_override_property(obj_class, PROP_REHANDSHAKE_MODE,
+	                                 "rehandshake-mode");
+	g_object_class_override_property(obj_class, PROP_USE_SYSTEM_CERTDB,
+	                                 "use-system-certdb");
+	g_object_class_override_property(obj_class, PROP_PROTOCOL_VERSION,
+	                                 "protocol-version");
+	g_object_class_override_property(obj_class, PROP_VALIDATION_FLAGS,
+	                                 "validation-flags");
+	g_object_class_override_property(obj_class, PROP_SERVER_IDENTITY,
+	                                 "server-identity");
+	g_object_class_override_property(obj_class, PROP_USE_SSL3, "use-ssl3");
+	g_object_class_override_property(obj_class, PROP_ACCEPTED_CAS,
+	                                 "accepted-cas");
+}
+
+static GTlsClientConnection *
+test_tls_connection_new(const gchar *hostname, guint16 port) {
+	GTlsClientConnection *connection = NULL;
+	GSocketConnectable *identity = NULL;
+	GInputStream *input = NULL;
+	GOutputStream *output = NULL;
+	GIOStream *base = NULL;
+
+	input = g_memory_input_stream_new();
+	output = g_memory_output_stream_new_resizable();
+	base = g_simple_io_stream_new(input, output);
+	identity = g_network_address_new(hostname, port);
+
+	connection = g_initable_new(TEST_TYPE_TLS_CONNECTION, NULL, NULL,
+	                            "base-io-stream", base,
+	                            "server-identity", identity,
+	                            NULL);
+
+	g_object_unref(identity);
+	g_object_unref(base);
+	g_object_unref(output);
+	g_object_unref(input);
+
+	return connection;
+}
+
+/* Pretends the handshake finished and the server gave out @session. */
+static void
+test_tls_connection_complete(GTlsClientConnection *connection, guint session) {
+	TestTlsConnection *test_connection = TEST_TLS_CONNECTION(connection);
+
+	test_connection->session = session;
+	test_connection->version = G_TLS_PROTOCOL_VERSION_TLS_1_3;
+
+	g_object_notify(G_OBJECT(connection), "protocol-version");
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_purple_tls_session_cache_get_default(void) {
+	PurpleTlsSessionCache *cache1 = NULL, *cache2 = NULL;
+
+	cache1 = purple_tls_session_cache_get_default();
+	g_assert_true(PURPLE_IS_TLS_SESSION_CACHE(cache1));
+
+	cache2 = purple_tls_session_cache_get_default();
+	g_assert_true(cache1 == cache2);
+}
+
+static void
+test_purple_tls_session_cache_resume(void) {
+	PurpleTlsSessionCache *cache = NULL;
+	PurpleAccount *account = NULL;
+	GTlsClientConnection *connection1 = NULL;
+	GTlsClientConnection *connection2 = NULL;
+	GTlsClientConnection *connection3 = NULL;
+	guint resumable = 0, full = 0;
+
+	cache = purple_tls_session_cache_get_default();
+	account = purple_account_new("test", "test");
+
+	resumable = purple_tls_session_cache_get_resumable_handshakes(cache);
+	full = purple_tls_session_cache_get_full_handshakes(cache);
+
+	/* Nothing is counted or remembered until the handshake is done. */
+	connection1 = test_tls_connection_new("example.com", 5223);
+	purple_tls_session_cache_prepare(cache, account, connection1);
+	g_assert_cmpuint(purple_tls_session_cache_get_full_handshakes(cache), ==,
+	                 full);
+
+	test_tls_connection_complete(connection1, 1);
+	g_assert_cmpuint(purple_tls_session_cache_get_full_handshakes(cache), ==,
+	                 full + 1);
+
+	/* The next connection to the same server is offered that session. */
+	connection2 = test_tls_connection_new("example.com", 5223);
+	purple_tls_session_cache_prepare(cache, account, connection2);
+	g_assert_cmpuint(TEST_TLS_CONNECTION(connection2)->session, ==, 1);
+
+	test_tls_connection_complete(connection2, 2);
+	g_assert_cmpuint(purple_tls_session_cache_get_resumable_handshakes(cache),
+	                 ==, resumable + 1);
+
+	/* A different server gets nothing. */
+	connection3 = test_tls_connection_new("example.org", 5223);
+	purple_tls_session_cache_prepare(cache, account, connection3);
+	g_assert_cmpuint(TEST_TLS_CONNECTION(connection3)->session, ==, 0);
+	g_clear_object(&connection3);
+
+	/* The first connection was replaced, so the cache let go of it. */
+	g_object_add_weak_pointer(G_OBJECT(connection1), (gpointer *)&connection1);
+	g_object_unref(connection1);
+	g_assert_null(connection1);
+
+	/* The cache lets go of the second connection once we do, but keeps its
+	 * session.
+	 */
+	g_object_add_weak_pointer(G_OBJECT(connection2), (gpointer *)&connection2);
+	g_object_unref(connection2);
+	while(connection2 != NULL) {
+		g_main_context_iteration(NULL, TRUE);
+	}
+
+	connection3 = test_tls_connection_new("example.com", 5223);
+	purple_tls_session_cache_prepare(cache, account, connection3);
+	g_assert_cmpuint(TEST_TLS_CONNECTION(connection3)->session, ==, 2);
+	g_clear_object(&connection3);
+
+	/* Clearing the account forgets its sessions. */
+	purple_tls_session_cache_clear(cache, account);
+
+	connection3 = test_tls_connection_new("example.com", 5223);
+	purple_tls_session_cache_prepare(cache, account, connection3);
+	g_assert_cmpuint(TEST_TLS_CONNECTION(connection3)->session, ==, 0);
+	g_clear_object(&connection3);
+
+	g_clear_object(&account);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+gint
+main(gint argc, gchar *argv[]) {
+	g_test_init(&argc, &argv, NULL);
+
+	test_ui_purple_init();
+
+	g_test_add_func("/tls-session-cache/get-default",
+	                test_purple_tls_session_cache_get_default);
+	g_test_add_func("/tls-session-cache/resume",
+	                test_purple_tls_session_cache_resume);
+
+	return g_test_run();
+}
@@ -406,12 +406,9 @@ purple_str_wipe(gchar *str)
 
 gboolean
 purple_strmatches(const char *pattern, const char *str) {
-	char *normal_pattern = NULL;
-	char *normal_str = NULL;
 	char *cmp_pattern = NULL;
 	char *cmp_str = NULL;
-	char *idx_pattern = NULL;
-	char *idx_str = NULL;
+	gboolean ret = FALSE;
 
 	g_return_val_if_fail(pattern != NULL, FALSE);
 
@@ -420,16 +417,44 @@ purple_strmatches(const char *pattern, const char *str) {
 		return FALSE;
 	}
 
-	normal_pattern = g_utf8_normalize(pattern, -1, G_NORMALIZE_ALL);
-	cmp_pattern = g_utf8_casefold(normal_pattern, -1);
-	g_free(normal_pattern);
+	cmp_pattern = purple_str_search_key(pattern);
+	cmp_str = purple_str_search_key(str);
+
+	ret = purple_strmatches_search_key(cmp_pattern != NULL ? cmp_pattern : "",
+	                                   cmp_str);
+
+	g_free(cmp_pattern);
+	g_free(cmp_str);
+
+	return ret;
+}
+
+char *
+purple_str_search_key(const char *str) {
+	char *normal = NULL;
+	char *key = NULL;
+
+	if(purple_strempty(str)) {
+		return NULL;
+	}
+
+	normal = g_utf8_normalize(str, -1, G_NORMALIZE_ALL);
+	key = g_utf8_casefold(normal, -1);
+	g_free(normal);
 
-	normal_str = g_utf8_normalize(str, -1, G_NORMALIZE_ALL);
-	cmp_str = g_utf8_casefold(normal_str, -1);
-	g_free(normal_str);
+	return key;
+}
 
-	idx_pattern = cmp_pattern;
-	idx_str = cmp_str;
+gboolean
+purple_strmatches_search_key(const char *pattern, const char *str) {
+	const char *idx_pattern = pattern;
+	const char *idx_str = str;
+
+	g_return_val_if_fail(pattern != NULL, FALSE);
+
+	if(str == NULL) {
+		return FALSE;
+	}
 
 	/* I know while(TRUE)'s suck, but the alternative would be a multi-line for
 	 * loop that wouldn't have the additional comments, which is much better
@@ -445,9 +470,6 @@ purple_strmatches(const char *pattern, const char *str) {
 
 		idx_str = g_utf8_strchr(idx_str, -1, character);
 		if(idx_str == NULL) {
-			g_free(cmp_pattern);
-			g_free(cmp_str);
-
 			return FALSE;
 		}
 
@@ -460,9 +482,6 @@ purple_strmatches(const char *pattern, const char *str) {
 		idx_str = g_utf8_next_char(idx_str);
 	};
 
-	g_free(cmp_pattern);
-	g_free(cmp_str);
-
 	return TRUE;
 }
 
@@ -428,6 +428,35 @@ void purple_str_wipe(gchar *str);
  */
 gboolean purple_strmatches(const char *pattern, const char *str);
 
+/**
+ * purple_str_search_key:
+ * @str: (nullable): The string to create a key for.
+ *
+ * Normalizes and casefolds @str so that it can be matched against many times
+ * with [func@Purple.strmatches_search_key] without doing that work again.
+ *
+ * Returns: (transfer full) (nullable): The search key for @str, or %NULL if
+ *          @str is %NULL or empty.
+ *
+ * Since: 3.0.0
+ */
+char *purple_str_search_key(const char *str);
+
+/**
+ * purple_strmatches_search_key:
+ * @pattern: The search key of the pattern to search for.
+ * @str: (nullable): The search key of the string to check.
+ *
+ * Like [func@Purple.strmatches] but for strings that have already been turned
+ * into search keys with [func@Purple.str_search_key].
+ *
+ * Returns: %TRUE if @pattern occurs in sequential order in @str, %FALSE
+ *          otherwise.
+ *
+ * Since: 3.0.0
+ */
+gboolean purple_strmatches_search_key(const char *pattern, const char *str);
+
 /**************************************************************************/
 /* URI/URL Functions                                                      */
 /**************************************************************************/
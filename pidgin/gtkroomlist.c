@@ -50,6 +50,7 @@ struct _PidginRoomlistDialog {
 	GtkWidget *view;
 	GtkSingleSelection *selection;
 	GtkFilterListModel *filter;
+	GtkWidget *search_entry;
 
 	GtkWidget *stop_button;
 	GtkWidget *list_button;
@@ -68,7 +69,6 @@ G_DEFINE_TYPE(PidginRoomlistDialog, pidgin_roomlist_dialog, GTK_TYPE_DIALOG)
 
 typedef struct {
 	PidginRoomlistDialog *dialog;
-	GListStore *model;
 } PidginRoomlist;
 
 /******************************************************************************
@@ -106,20 +106,20 @@ pidgin_roomlist_start_listing(PidginRoomlistDialog *dialog)
 {
 	PurpleConnection *gc;
 	PidginRoomlist *rl;
+	const gchar *search = NULL;
 
 	gc = purple_account_get_connection(dialog->account);
 	if (!gc)
 		return;
 
 	if (dialog->roomlist != NULL) {
-		rl = g_object_get_data(G_OBJECT(dialog->roomlist),
-		                       PIDGIN_ROOMLIST_UI_DATA);
-
-		g_clear_object(&rl->model);
 		g_object_unref(dialog->roomlist);
 	}
 
-	dialog->roomlist = purple_roomlist_get_list(gc);
+	/* Let the protocol filter on the server when it can, the filter model
+	 * still narrows the list down further as the user types. */
+	search = gtk_editable_get_text(GTK_EDITABLE(dialog->search_entry));
+	dialog->roomlist = purple_roomlist_query(gc, search, 0);
 	if (!dialog->roomlist)
 		return;
 	g_object_ref(dialog->roomlist);
@@ -130,7 +130,8 @@ pidgin_roomlist_start_listing(PidginRoomlistDialog *dialog)
 
 	gtk_widget_set_sensitive(dialog->account_widget, FALSE);
 
-	gtk_filter_list_model_set_model(dialog->filter, G_LIST_MODEL(rl->model));
+	gtk_filter_list_model_set_model(dialog->filter,
+	                                G_LIST_MODEL(dialog->roomlist));
 
 	/* some protocols (not bundled with libpurple) finish getting their
 	 * room list immediately */
@@ -280,14 +281,25 @@ dialog_select_account_cb(GObject *obj, G_GNUC_UNUSED GParamSpec *pspec,
 	dialog->account = account;
 
 	if (change && dialog->roomlist) {
-		PidginRoomlist *rl = NULL;
+		gtk_filter_list_model_set_model(dialog->filter, NULL);
+		g_clear_object(&dialog->roomlist);
+	}
+}
 
-		rl = g_object_get_data(G_OBJECT(dialog->roomlist),
-		                       PIDGIN_ROOMLIST_UI_DATA);
+static void
+search_activate_cb(G_GNUC_UNUSED GtkSearchEntry *entry, gpointer data)
+{
+	PidginRoomlistDialog *dialog = data;
 
-		g_clear_object(&rl->model);
-		g_clear_object(&dialog->roomlist);
+	/* Ask again with the new search rather than only filtering what the
+	 * last listing found. */
+	if (dialog->roomlist != NULL &&
+	    purple_roomlist_get_in_progress(dialog->roomlist))
+	{
+		pidgin_roomlist_stop_listing(dialog);
 	}
+
+	pidgin_roomlist_start_listing(dialog);
 }
 
 static void
@@ -373,6 +385,8 @@ pidgin_roomlist_dialog_class_init(PidginRoomlistDialogClass *klass)
 	                                     selection);
 	gtk_widget_class_bind_template_child(widget_class, PidginRoomlistDialog,
 	                                     filter);
+	gtk_widget_class_bind_template_child(widget_class, PidginRoomlistDialog,
+	                                     search_entry);
 	gtk_widget_class_bind_template_child(widget_class, PidginRoomlistDialog,
 	                                     add_button);
 	gtk_widget_class_bind_template_child(widget_class, PidginRoomlistDialog,
@@ -390,6 +404,8 @@ pidgin_roomlist_dialog_class_init(PidginRoomlistDialogClass *klass)
 	gtk_widget_class_bind_template_callback(widget_class, row_activated_cb);
 	gtk_widget_class_bind_template_callback(widget_class,
 	                                        dialog_select_account_cb);
+	gtk_widget_class_bind_template_callback(widget_class,
+	                                        search_activate_cb);
 	gtk_widget_class_bind_template_callback(widget_class,
 	                                        selection_changed_cb);
 	gtk_widget_class_bind_template_callback(widget_class,
@@ -473,13 +489,19 @@ static gboolean pidgin_progress_bar_pulse(gpointer data)
 	return TRUE;
 }
 
+/* The room list hands us rooms in batches, so pulse the progress bar once per
+ * batch rather than once per room.
+ */
 static void
-pidgin_roomlist_add_room(PurpleRoomlist *list, PurpleRoomlistRoom *room) {
-	PidginRoomlist *rl = NULL;
-
-	rl = g_object_get_data(G_OBJECT(list), PIDGIN_ROOMLIST_UI_DATA);
+pidgin_roomlist_items_changed(GListModel *model,
+                              G_GNUC_UNUSED guint position,
+                              G_GNUC_UNUSED guint removed, guint added,
+                              gpointer data)
+{
+	PurpleRoomlist *list = PURPLE_ROOMLIST(model);
+	PidginRoomlist *rl = data;
 
-	if (rl->dialog) {
+	if (added > 0 && rl->dialog) {
 		if (rl->dialog->pg_update_to == 0) {
 			g_object_ref(list);
 			rl->dialog->pg_update_to = g_timeout_add(100, pidgin_progress_bar_pulse, list);
@@ -487,8 +509,6 @@ pidgin_roomlist_add_room(PurpleRoomlist *list, PurpleRoomlistRoom *room) {
 		} else
 			rl->dialog->pg_needs_pulse = TRUE;
 	}
-
-	g_list_store_append(rl->model, room);
 }
 
 static void
@@ -523,8 +543,8 @@ pidgin_roomlist_new(PurpleRoomlist *list)
 	g_object_set_data_full(G_OBJECT(list), PIDGIN_ROOMLIST_UI_DATA, rl,
 	                       (GDestroyNotify)g_free);
 
-	rl->model = g_list_store_new(PURPLE_TYPE_ROOMLIST_ROOM);
-
+	g_signal_connect(list, "items-changed",
+	                 G_CALLBACK(pidgin_roomlist_items_changed), rl);
 	g_signal_connect(list, "notify::in-progress",
 	                 G_CALLBACK(pidgin_roomlist_in_progress), rl);
 }
@@ -532,7 +552,6 @@ pidgin_roomlist_new(PurpleRoomlist *list)
 static PurpleRoomlistUiOps ops = {
 	.show_with_account = pidgin_roomlist_dialog_show_with_account,
 	.create = pidgin_roomlist_new,
-	.add_room = pidgin_roomlist_add_room,
 };
 
 
@@ -26,6 +26,11 @@
 
 #include "pidgin/pidgincontactlist.h"
 
+/* The avatars are shown at the large icon size, decode them at twice that so
+ * they stay sharp on high density displays.
+ */
+#define PIDGIN_CONTACT_LIST_AVATAR_SIZE (64)
+
 struct _PidginContactList {
 	GtkBox parent;
 
@@ -34,6 +39,9 @@ struct _PidginContactList {
 
 	GtkWidget *search_entry;
 	GtkWidget *view;
+
+	/* The purple_str_search_key() of the search entry's text. */
+	char *search_key;
 };
 
 G_DEFINE_TYPE(PidginContactList, pidgin_contact_list, GTK_TYPE_BOX)
@@ -45,11 +53,8 @@ static gboolean
 pidgin_contact_list_search_filter(GObject *item, gpointer data) {
 	PidginContactList *list = data;
 	PurplePerson *person = PURPLE_PERSON(item);
-	const char *needle = NULL;
 
-	needle = gtk_editable_get_text(GTK_EDITABLE(list->search_entry));
-
-	return purple_person_matches(person, needle);
+	return purple_person_matches_search_key(person, list->search_key);
 }
 
 /******************************************************************************
@@ -60,9 +65,52 @@ pidgin_contact_list_search_changed_cb(G_GNUC_UNUSED GtkSearchEntry *self,
                                       gpointer data)
 {
 	PidginContactList *list = data;
+	GtkFilterChange change = GTK_FILTER_CHANGE_DIFFERENT;
+	const char *text = NULL;
+	char *key = NULL;
+
+	text = gtk_editable_get_text(GTK_EDITABLE(list->search_entry));
+	key = purple_str_search_key(text);
+
+	if(purple_strequal(key, list->search_key)) {
+		g_free(key);
 
-	gtk_filter_changed(GTK_FILTER(list->search_filter),
-	                   GTK_FILTER_CHANGE_DIFFERENT);
+		return;
+	}
+
+	/* Matching is by characters in order, so if one key occurs in the other
+	 * the results only shrink or grow, and the filter model only has to look
+	 * at the contacts that are, or aren't, currently shown.
+	 */
+	if(list->search_key == NULL) {
+		change = GTK_FILTER_CHANGE_MORE_STRICT;
+	} else if(key == NULL) {
+		change = GTK_FILTER_CHANGE_LESS_STRICT;
+	} else if(purple_strmatches_search_key(list->search_key, key)) {
+		change = GTK_FILTER_CHANGE_MORE_STRICT;
+	} else if(purple_strmatches_search_key(key, list->search_key)) {
+		change = GTK_FILTER_CHANGE_LESS_STRICT;
+	}
+
+	g_free(list->search_key);
+	list->search_key = key;
+
+	gtk_filter_changed(GTK_FILTER(list->search_filter), change);
+}
+
+static GdkTexture *
+pidgin_contact_list_texture_for_avatar(PurpleAvatar *avatar) {
+	GdkTexture *texture = NULL;
+	GdkPixbuf *pixbuf = NULL;
+
+	pixbuf = purple_avatar_get_pixbuf_for_size(avatar,
+	                                           PIDGIN_CONTACT_LIST_AVATAR_SIZE);
+	if(GDK_IS_PIXBUF(pixbuf)) {
+		texture = gdk_texture_new_for_pixbuf(pixbuf);
+		g_object_unref(pixbuf);
+	}
+
+	return texture;
 }
 
 static GdkTexture *
@@ -70,6 +118,7 @@ pidgin_contact_list_avatar_cb(G_GNUC_UNUSED GObject *self,
                               PurplePerson *person,
                               G_GNUC_UNUSED gpointer data)
 {
+	PurpleAvatar *avatar = NULL;
 	PurpleContactInfo *info = NULL;
 	PurpleContact *contact = NULL;
 	PurpleBuddyIcon *icon = NULL;
@@ -84,12 +133,28 @@ pidgin_contact_list_avatar_cb(G_GNUC_UNUSED GObject *self,
 		return NULL;
 	}
 
-	pixbuf = purple_person_get_avatar_for_display(person);
+	pixbuf = purple_person_get_avatar(person);
 	if(GDK_IS_PIXBUF(pixbuf)) {
 		return gdk_texture_new_for_pixbuf(pixbuf);
 	}
 
 	info = purple_person_get_priority_contact_info(person);
+	if(!PURPLE_IS_CONTACT_INFO(info)) {
+		return NULL;
+	}
+
+	/* Protocol avatars are decoded at the size we show them at, through the
+	 * shared avatar cache, instead of at full size.
+	 */
+	avatar = purple_contact_info_get_encoded_avatar(info);
+	if(PURPLE_IS_AVATAR(avatar)) {
+		return pidgin_contact_list_texture_for_avatar(avatar);
+	}
+
+	pixbuf = purple_contact_info_get_avatar(info);
+	if(GDK_IS_PIXBUF(pixbuf)) {
+		return gdk_texture_new_for_pixbuf(pixbuf);
+	}
 
 	/* All of the contact info in the manager are PurpleContact's so this cast
 	 * is fine.
@@ -101,21 +166,22 @@ pidgin_contact_list_avatar_cb(G_GNUC_UNUSED GObject *self,
 
 	if(icon != NULL) {
 		GBytes *bytes = NULL;
-		GError *error = NULL;
-		gsize size;
-		gconstpointer data = NULL;
 
-		data = purple_buddy_icon_get_data(icon, &size);
-		bytes = g_bytes_new(data, size);
+		bytes = purple_buddy_icon_get_contents(icon);
+		if(bytes == NULL) {
+			return NULL;
+		}
 
-		texture = gdk_texture_new_from_bytes(bytes, &error);
+		avatar = purple_avatar_new_from_bytes(bytes);
 		g_bytes_unref(bytes);
 
-		if(error != NULL) {
-			g_warning("Failed to create texture: %s", error->message);
-
-			g_clear_error(&error);
+		texture = pidgin_contact_list_texture_for_avatar(avatar);
+		if(texture == NULL) {
+			g_warning("Failed to create texture for the buddy icon of %s",
+			          purple_contact_info_get_username(info));
 		}
+
+		g_object_unref(avatar);
 	}
 
 	return texture;
@@ -168,6 +234,15 @@ pidgin_contact_list_message_visible_cb(G_GNUC_UNUSED GtkListItem *item,
 /******************************************************************************
  * GObject Implementation
  *****************************************************************************/
+static void
+pidgin_contact_list_finalize(GObject *obj) {
+	PidginContactList *list = PIDGIN_CONTACT_LIST(obj);
+
+	g_clear_pointer(&list->search_key, g_free);
+
+	G_OBJECT_CLASS(pidgin_contact_list_parent_class)->finalize(obj);
+}
+
 static void
 pidgin_contact_list_init(PidginContactList *list) {
 	PurpleContactManager *manager = NULL;
@@ -184,8 +259,11 @@ pidgin_contact_list_init(PidginContactList *list) {
 
 static void
 pidgin_contact_list_class_init(PidginContactListClass *klass) {
+	GObjectClass *obj_class = G_OBJECT_CLASS(klass);
 	GtkWidgetClass *widget_class = GTK_WIDGET_CLASS(klass);
 
+	obj_class->finalize = pidgin_contact_list_finalize;
+
 	gtk_widget_class_set_template_from_resource(
 	    widget_class,
 	    "/im/pidgin/Pidgin3/ContactList/widget.ui"
@@ -510,6 +510,21 @@ pidgin_debug_window_dispose(GObject *object)
 	G_OBJECT_CLASS(pidgin_debug_window_parent_class)->dispose(object);
 }
 
+/* Nothing reads the debug output unless it is being printed or the window is
+ * open, so let libpurple drop everything below warnings before formatting it.
+ */
+static void
+pidgin_debug_update_level(void)
+{
+	PurpleDebugLevel level = PURPLE_DEBUG_WARNING;
+
+	if(debug_print_enabled || debug_win != NULL) {
+		level = PURPLE_DEBUG_ALL;
+	}
+
+	purple_debug_set_minimum_level(level);
+}
+
 static void
 pidgin_debug_window_finalize(GObject *object)
 {
@@ -521,6 +536,7 @@ pidgin_debug_window_finalize(GObject *object)
 
 	debug_win = NULL;
 	purple_prefs_set_bool(PIDGIN_PREFS_ROOT "/debug/enabled", FALSE);
+	pidgin_debug_update_level();
 
 	G_OBJECT_CLASS(pidgin_debug_window_parent_class)->finalize(object);
 }
@@ -863,6 +879,8 @@ pidgin_debug_window_show(void)
 				g_object_new(PIDGIN_TYPE_DEBUG_WINDOW, NULL));
 
 		gtk_window_set_transient_for(GTK_WINDOW(debug_win), parent);
+
+		pidgin_debug_update_level();
 	}
 
 	gtk_window_present_with_time(GTK_WINDOW(debug_win), GDK_CURRENT_TIME);
@@ -920,6 +938,8 @@ pidgin_debug_init(void)
 	pref_callback_id = purple_prefs_connect_callback(NULL,
 	                                                 PIDGIN_PREFS_ROOT "/debug/enabled",
 	                                                 debug_enabled_cb, NULL);
+
+	pidgin_debug_update_level();
 }
 
 void
@@ -40,6 +40,8 @@
 
 #include <pidgin.h>
 
+#include "spellchkrules.h"
+
 #define SPELLCHECK_PLUGIN_ID "gtk-spellcheck"
 #define SPELLCHK_OBJECT_KEY "spellchk"
 
@@ -67,64 +69,75 @@ typedef struct _spellchk spellchk;
 
 static GtkListStore *model;
 
-static gboolean
-is_word_uppercase(const gchar *word)
-{
-	for (; word[0] != '\0'; word = g_utf8_find_next_char (word, NULL)) {
-		gunichar c = g_utf8_get_char(word);
-
-		if (!(g_unichar_isupper(c) ||
-		      g_unichar_ispunct(c) ||
-		      g_unichar_isspace(c)))
-			return FALSE;
-	}
+/* The list store is only used for editing. The rules are rebuilt from it the
+ * next time they're needed after it changes.
+ */
+static SpellchkRules *rules = NULL;
 
-	return TRUE;
+static void
+spellchk_invalidate_rules(void)
+{
+	g_clear_pointer(&rules, spellchk_rules_free);
 }
 
-static gboolean
-is_word_lowercase(const gchar *word)
+static void
+spellchk_row_changed_cb(G_GNUC_UNUSED GtkTreeModel *tree_model,
+                        G_GNUC_UNUSED GtkTreePath *path,
+                        G_GNUC_UNUSED GtkTreeIter *iter,
+                        G_GNUC_UNUSED gpointer data)
 {
-	for (; word[0] != '\0'; word = g_utf8_find_next_char(word, NULL)) {
-		gunichar c = g_utf8_get_char(word);
-
-		if (!(g_unichar_islower(c) ||
-		      g_unichar_ispunct(c) ||
-		      g_unichar_isspace(c)))
-			return FALSE;
-	}
-
-	return TRUE;
+	spellchk_invalidate_rules();
 }
 
-static gboolean
-is_word_proper(const gchar *word)
+static void
+spellchk_row_deleted_cb(G_GNUC_UNUSED GtkTreeModel *tree_model,
+                        G_GNUC_UNUSED GtkTreePath *path,
+                        G_GNUC_UNUSED gpointer data)
 {
-	if (word[0] == '\0')
-		return FALSE;
-
-	if (!g_unichar_isupper(g_utf8_get_char_validated(word, -1)))
-		return FALSE;
+	spellchk_invalidate_rules();
+}
 
-	return is_word_lowercase(g_utf8_offset_to_pointer(word, 1));
+static void
+spellchk_rows_reordered_cb(G_GNUC_UNUSED GtkTreeModel *tree_model,
+                           G_GNUC_UNUSED GtkTreePath *path,
+                           G_GNUC_UNUSED GtkTreeIter *iter,
+                           G_GNUC_UNUSED gpointer new_order,
+                           G_GNUC_UNUSED gpointer data)
+{
+	spellchk_invalidate_rules();
 }
 
-static gchar *
-make_word_proper(const gchar *word)
+static SpellchkRules *
+spellchk_get_rules(void)
 {
-	char buf[7];
-	gchar *lower = g_utf8_strdown(word, -1);
-	gint bytes;
-	gchar *ret;
+	GtkTreeIter iter;
 
-	bytes = g_unichar_to_utf8(g_unichar_toupper(g_utf8_get_char(word)), buf);
-	g_assert(bytes >= 0);
-	buf[MIN((gsize)bytes, sizeof(buf) - 1)] = '\0';
+	if (rules != NULL)
+		return rules;
 
-	ret = g_strconcat(buf, g_utf8_offset_to_pointer(lower, 1), NULL);
-	g_free(lower);
+	rules = spellchk_rules_new();
 
-	return ret;
+	if (gtk_tree_model_get_iter_first(GTK_TREE_MODEL(model), &iter)) {
+		do {
+			gchar *bad = NULL;
+			gchar *good = NULL;
+			gboolean word_only = FALSE;
+			gboolean case_sensitive = FALSE;
+
+			gtk_tree_model_get(GTK_TREE_MODEL(model), &iter,
+			                   BAD_COLUMN, &bad,
+			                   GOOD_COLUMN, &good,
+			                   WORD_ONLY_COLUMN, &word_only,
+			                   CASE_SENSITIVE_COLUMN, &case_sensitive,
+			                   -1);
+			spellchk_rules_add(rules, bad, good, word_only, case_sensitive);
+
+			g_free(bad);
+			g_free(good);
+		} while (gtk_tree_model_iter_next(GTK_TREE_MODEL(model), &iter));
+	}
+
+	return rules;
 }
 
 static gboolean
@@ -132,146 +145,46 @@ substitute_simple_buffer(GtkTextBuffer *buffer)
 {
 	GtkTextIter start;
 	GtkTextIter end;
-	GtkTreeIter treeiter;
+	const gchar *cursor;
+	const gchar *bad = NULL;
+	const gchar *good = NULL;
 	gchar *text = NULL;
+	glong char_pos;
+
+	if (!spellchk_rules_has_phrases(spellchk_get_rules()))
+		return FALSE;
 
 	gtk_text_buffer_get_iter_at_offset(buffer, &start, 0);
 	gtk_text_buffer_get_iter_at_offset(buffer, &end, 0);
 	gtk_text_iter_forward_to_end(&end);
 
 	text = gtk_text_buffer_get_text(buffer, &start, &end, FALSE);
+	if (text == NULL)
+		return FALSE;
 
-	if (gtk_tree_model_get_iter_first(GTK_TREE_MODEL(model), &treeiter) && text) {
-		do {
-			GValue val1;
-			const gchar *bad;
-			gchar *cursor;
-			glong char_pos;
-
-			val1.g_type = 0;
-			gtk_tree_model_get_value(GTK_TREE_MODEL(model), &treeiter, WORD_ONLY_COLUMN, &val1);
-			if (g_value_get_boolean(&val1))
-			{
-				g_value_unset(&val1);
-				continue;
-			}
-			g_value_unset(&val1);
-
-			gtk_tree_model_get_value(GTK_TREE_MODEL(model), &treeiter, BAD_COLUMN, &val1);
-			bad = g_value_get_string(&val1);
-
-			/* using g_utf8_* to get /character/ offsets instead of byte offsets for buffer */
-			if ((cursor = g_strrstr(text, bad)))
-			{
-				GValue val2;
-				const gchar *good;
-
-				val2.g_type = 0;
-				gtk_tree_model_get_value(GTK_TREE_MODEL(model), &treeiter, GOOD_COLUMN, &val2);
-				good = g_value_get_string(&val2);
-
-				char_pos = g_utf8_pointer_to_offset(text, cursor);
-				gtk_text_buffer_get_iter_at_offset(buffer, &start, char_pos);
-				gtk_text_buffer_get_iter_at_offset(buffer, &end, char_pos + g_utf8_strlen(bad, -1));
-				gtk_text_buffer_delete(buffer, &start, &end);
-
-				gtk_text_buffer_get_iter_at_offset(buffer, &start, char_pos);
-				gtk_text_buffer_insert(buffer, &start, good, -1);
-
-				g_value_unset(&val2);
-				g_free(text);
+	cursor = spellchk_rules_find_phrase(rules, text, &bad, &good);
+	if (cursor == NULL) {
+		g_free(text);
+		return FALSE;
+	}
 
-				g_value_unset(&val1);
-				return TRUE;
-			}
+	/* using g_utf8_* to get /character/ offsets instead of byte offsets for buffer */
+	char_pos = g_utf8_pointer_to_offset(text, cursor);
+	gtk_text_buffer_get_iter_at_offset(buffer, &start, char_pos);
+	gtk_text_buffer_get_iter_at_offset(buffer, &end, char_pos + g_utf8_strlen(bad, -1));
+	gtk_text_buffer_delete(buffer, &start, &end);
 
-			g_value_unset(&val1);
-		} while (gtk_tree_model_iter_next(GTK_TREE_MODEL(model), &treeiter));
-	}
+	gtk_text_buffer_get_iter_at_offset(buffer, &start, char_pos);
+	gtk_text_buffer_insert(buffer, &start, good, -1);
 
 	g_free(text);
-	return FALSE;
+	return TRUE;
 }
 
 static gchar *
 substitute_word(gchar *word)
 {
-	GtkTreeIter iter;
-	gchar *outword;
-	gchar *lowerword;
-	gchar *foldedword;
-
-	if (word == NULL)
-		return NULL;
-
-	lowerword = g_utf8_strdown(word, -1);
-	foldedword = g_utf8_casefold(word, -1);
-
-	if (gtk_tree_model_get_iter_first(GTK_TREE_MODEL(model), &iter)) {
-		do {
-			GValue val1;
-			gboolean case_sensitive;
-			const char *bad;
-			gchar *tmpbad = NULL;
-
-			val1.g_type = 0;
-			gtk_tree_model_get_value(GTK_TREE_MODEL(model), &iter, WORD_ONLY_COLUMN, &val1);
-			if (!g_value_get_boolean(&val1)) {
-				g_value_unset(&val1);
-				continue;
-			}
-			g_value_unset(&val1);
-
-			gtk_tree_model_get_value(GTK_TREE_MODEL(model), &iter, CASE_SENSITIVE_COLUMN, &val1);
-			case_sensitive = g_value_get_boolean(&val1);
-			g_value_unset(&val1);
-
-			gtk_tree_model_get_value(GTK_TREE_MODEL(model), &iter, BAD_COLUMN, &val1);
-			bad = g_value_get_string(&val1);
-
-			if ((case_sensitive && purple_strequal(bad, word)) ||
-			    (!case_sensitive && (purple_strequal(bad, lowerword) ||
-			                        (!is_word_lowercase(bad) &&
-			                         purple_strequal((tmpbad = g_utf8_casefold(bad, -1)), foldedword)))))
-			{
-				GValue val2;
-				const char *good;
-
-				g_free(tmpbad);
-
-				val2.g_type = 0;
-				gtk_tree_model_get_value(GTK_TREE_MODEL(model), &iter, GOOD_COLUMN, &val2);
-				good = g_value_get_string(&val2);
-
-				if (!case_sensitive && is_word_lowercase(bad) && is_word_lowercase(good))
-				{
-					if (is_word_uppercase(word))
-						outword = g_utf8_strup(good, -1);
-					else if (is_word_proper(word))
-						outword = make_word_proper(good);
-					else
-						outword = g_strdup(good);
-				}
-				else
-					outword = g_strdup(good);
-
-				g_value_unset(&val1);
-				g_value_unset(&val2);
-
-				g_free(lowerword);
-				g_free(foldedword);
-				return outword;
-			}
-
-			g_value_unset(&val1);
-			g_free(tmpbad);
-
-		} while (gtk_tree_model_iter_next(GTK_TREE_MODEL(model), &iter));
-	}
-	g_free(lowerword);
-	g_free(foldedword);
-
-	return NULL;
+	return spellchk_rules_substitute_word(spellchk_get_rules(), word);
 }
 
 static void
@@ -1788,6 +1701,14 @@ static void load_conf(void)
 	g_free(buf);
 
 	model = gtk_list_store_new((gint)N_COLUMNS, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_BOOLEAN, G_TYPE_BOOLEAN);
+	g_signal_connect(model, "row-changed",
+	                 G_CALLBACK(spellchk_row_changed_cb), NULL);
+	g_signal_connect(model, "row-inserted",
+	                 G_CALLBACK(spellchk_row_changed_cb), NULL);
+	g_signal_connect(model, "row-deleted",
+	                 G_CALLBACK(spellchk_row_deleted_cb), NULL);
+	g_signal_connect(model, "rows-reordered",
+	                 G_CALLBACK(spellchk_rows_reordered_cb), NULL);
 	hashes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 
 	while (ibuf && buf_get_line(ibuf, &buf, &pnt, size)) {
@@ -2341,6 +2262,8 @@ spell_check_unload(GPluginPlugin *plugin, gboolean shutdown, GError **error)
 		g_object_set_data(G_OBJECT(gtkconv->entry), SPELLCHK_OBJECT_KEY, NULL);
 	}
 
+	spellchk_invalidate_rules();
+
 	return TRUE;
 }
 
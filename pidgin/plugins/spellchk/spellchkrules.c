@@ -0,0 +1,349 @@
+/*
+ * Pidgin - Internet Messenger
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * Pidgin is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "spellchkrules.h"
+
+/* A replacement rule. index is the order the rule was added in, which is what
+ * decides between several rules that match the same text.
+ */
+typedef struct {
+	guint index;
+	gchar *bad;
+	gchar *good;
+	gboolean match_case;
+} SpellchkRule;
+
+/* Trie of the rules that replace text anywhere in the buffer rather than
+ * whole words. Children are kept as a singly linked list since most nodes
+ * only have one or two.
+ */
+typedef struct _SpellchkTrieNode SpellchkTrieNode;
+struct _SpellchkTrieNode {
+	guchar byte;
+	SpellchkTrieNode *child;
+	SpellchkTrieNode *sibling;
+	SpellchkRule *rule;
+};
+
+struct _SpellchkRules {
+	GPtrArray *rules;
+	GHashTable *exact_rules;  /* bad -> case sensitive rule */
+	GHashTable *lower_rules;  /* bad -> case insensitive rule */
+	GHashTable *folded_rules; /* casefolded bad -> rule */
+	SpellchkTrieNode *phrase_rules;
+};
+
+static gboolean
+is_word_uppercase(const gchar *word)
+{
+	for (; word[0] != '\0'; word = g_utf8_find_next_char (word, NULL)) {
+		gunichar c = g_utf8_get_char(word);
+
+		if (!(g_unichar_isupper(c) ||
+		      g_unichar_ispunct(c) ||
+		      g_unichar_isspace(c)))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+is_word_lowercase(const gchar *word)
+{
+	for (; word[0] != '\0'; word = g_utf8_find_next_char(word, NULL)) {
+		gunichar c = g_utf8_get_char(word);
+
+		if (!(g_unichar_islower(c) ||
+		      g_unichar_ispunct(c) ||
+		      g_unichar_isspace(c)))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+is_word_proper(const gchar *word)
+{
+	if (word[0] == '\0')
+		return FALSE;
+
+	if (!g_unichar_isupper(g_utf8_get_char_validated(word, -1)))
+		return FALSE;
+
+	return is_word_lowercase(g_utf8_offset_to_pointer(word, 1));
+}
+
+static gchar *
+make_word_proper(const gchar *word)
+{
+	char buf[7];
+	gchar *lower = g_utf8_strdown(word, -1);
+	gint bytes;
+	gchar *ret;
+
+	bytes = g_unichar_to_utf8(g_unichar_toupper(g_utf8_get_char(word)), buf);
+	g_assert(bytes >= 0);
+	buf[MIN((gsize)bytes, sizeof(buf) - 1)] = '\0';
+
+	ret = g_strconcat(buf, g_utf8_offset_to_pointer(lower, 1), NULL);
+	g_free(lower);
+
+	return ret;
+}
+
+static void
+spellchk_rule_free(SpellchkRule *rule)
+{
+	g_free(rule->bad);
+	g_free(rule->good);
+	g_free(rule);
+}
+
+static void
+spellchk_trie_free(SpellchkTrieNode *node)
+{
+	while (node != NULL) {
+		SpellchkTrieNode *sibling = node->sibling;
+
+		spellchk_trie_free(node->child);
+		g_free(node);
+
+		node = sibling;
+	}
+}
+
+static SpellchkTrieNode *
+spellchk_trie_find_child(SpellchkTrieNode *node, guchar byte)
+{
+	for (node = node->child; node != NULL; node = node->sibling) {
+		if (node->byte == byte)
+			return node;
+	}
+
+	return NULL;
+}
+
+static void
+spellchk_trie_add(SpellchkTrieNode *root, SpellchkRule *rule)
+{
+	SpellchkTrieNode *node = root;
+	const guchar *c;
+
+	for (c = (const guchar *)rule->bad; *c != '\0'; c++) {
+		SpellchkTrieNode *child = spellchk_trie_find_child(node, *c);
+
+		if (child == NULL) {
+			child = g_new0(SpellchkTrieNode, 1);
+			child->byte = *c;
+			child->sibling = node->child;
+			node->child = child;
+		}
+
+		node = child;
+	}
+
+	/* If two rules have the same text, the first one in the list wins. */
+	if (node->rule == NULL)
+		node->rule = rule;
+}
+
+/* Adds rule under key unless an earlier rule already has it. */
+static gboolean
+spellchk_rules_insert(GHashTable *table, gchar *key, SpellchkRule *rule)
+{
+	if (g_hash_table_contains(table, key))
+		return FALSE;
+
+	g_hash_table_insert(table, key, rule);
+
+	return TRUE;
+}
+
+/* Returns whichever of a and b comes first in the list. */
+static SpellchkRule *
+spellchk_rule_first(SpellchkRule *a, SpellchkRule *b)
+{
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+
+	return (a->index <= b->index) ? a : b;
+}
+
+SpellchkRules *
+spellchk_rules_new(void)
+{
+	SpellchkRules *rules = g_new0(SpellchkRules, 1);
+
+	rules->rules = g_ptr_array_new_with_free_func((GDestroyNotify)spellchk_rule_free);
+	rules->exact_rules = g_hash_table_new(g_str_hash, g_str_equal);
+	rules->lower_rules = g_hash_table_new(g_str_hash, g_str_equal);
+	rules->folded_rules = g_hash_table_new_full(g_str_hash, g_str_equal,
+	                                            g_free, NULL);
+	rules->phrase_rules = g_new0(SpellchkTrieNode, 1);
+
+	return rules;
+}
+
+void
+spellchk_rules_free(SpellchkRules *rules)
+{
+	if (rules == NULL)
+		return;
+
+	g_hash_table_destroy(rules->exact_rules);
+	g_hash_table_destroy(rules->lower_rules);
+	g_hash_table_destroy(rules->folded_rules);
+	spellchk_trie_free(rules->phrase_rules);
+	g_ptr_array_unref(rules->rules);
+
+	g_free(rules);
+}
+
+void
+spellchk_rules_add(SpellchkRules *rules, const gchar *bad, const gchar *good,
+                   gboolean word_only, gboolean case_sensitive)
+{
+	SpellchkRule *rule;
+
+	g_return_if_fail(rules != NULL);
+
+	if (bad == NULL || *bad == '\0' || good == NULL)
+		return;
+
+	rule = g_new0(SpellchkRule, 1);
+	rule->index = rules->rules->len;
+	rule->bad = g_strdup(bad);
+	rule->good = g_strdup(good);
+	g_ptr_array_add(rules->rules, rule);
+
+	if (!word_only) {
+		spellchk_trie_add(rules->phrase_rules, rule);
+	} else if (case_sensitive) {
+		spellchk_rules_insert(rules->exact_rules, rule->bad, rule);
+	} else {
+		spellchk_rules_insert(rules->lower_rules, rule->bad, rule);
+
+		if (!is_word_lowercase(rule->bad)) {
+			gchar *folded = g_utf8_casefold(rule->bad, -1);
+
+			if (!spellchk_rules_insert(rules->folded_rules, folded, rule))
+				g_free(folded);
+		}
+
+		rule->match_case = is_word_lowercase(rule->bad) &&
+		                   is_word_lowercase(rule->good);
+	}
+}
+
+gboolean
+spellchk_rules_has_phrases(SpellchkRules *rules)
+{
+	g_return_val_if_fail(rules != NULL, FALSE);
+
+	return rules->phrase_rules->child != NULL;
+}
+
+const gchar *
+spellchk_rules_find_phrase(SpellchkRules *rules, const gchar *text,
+                           const gchar **bad, const gchar **good)
+{
+	SpellchkRule *found = NULL;
+	const gchar *cursor = NULL;
+	const gchar *p;
+
+	g_return_val_if_fail(rules != NULL, NULL);
+	g_return_val_if_fail(text != NULL, NULL);
+
+	/* Walk the trie from every position in the text. The first rule in the
+	 * list that matches anywhere wins, and like before we replace its last
+	 * occurrence.
+	 */
+	for (p = text; *p != '\0'; p++) {
+		SpellchkTrieNode *node = rules->phrase_rules;
+		const guchar *q;
+
+		for (q = (const guchar *)p; *q != '\0'; q++) {
+			node = spellchk_trie_find_child(node, *q);
+			if (node == NULL)
+				break;
+
+			if (node->rule == NULL)
+				continue;
+
+			if (node->rule == found) {
+				cursor = p;
+			} else if (spellchk_rule_first(found, node->rule) == node->rule) {
+				found = node->rule;
+				cursor = p;
+			}
+		}
+	}
+
+	if (found == NULL)
+		return NULL;
+
+	if (bad != NULL)
+		*bad = found->bad;
+	if (good != NULL)
+		*good = found->good;
+
+	return cursor;
+}
+
+gchar *
+spellchk_rules_substitute_word(SpellchkRules *rules, const gchar *word)
+{
+	SpellchkRule *rule;
+	gchar *lowerword;
+	gchar *foldedword;
+
+	g_return_val_if_fail(rules != NULL, NULL);
+
+	if (word == NULL)
+		return NULL;
+
+	lowerword = g_utf8_strdown(word, -1);
+	foldedword = g_utf8_casefold(word, -1);
+
+	rule = g_hash_table_lookup(rules->exact_rules, word);
+	rule = spellchk_rule_first(rule, g_hash_table_lookup(rules->lower_rules, lowerword));
+	rule = spellchk_rule_first(rule, g_hash_table_lookup(rules->folded_rules, foldedword));
+
+	g_free(lowerword);
+	g_free(foldedword);
+
+	if (rule == NULL)
+		return NULL;
+
+	if (rule->match_case) {
+		if (is_word_uppercase(word))
+			return g_utf8_strup(rule->good, -1);
+		else if (is_word_proper(word))
+			return make_word_proper(rule->good);
+	}
+
+	return g_strdup(rule->good);
+}
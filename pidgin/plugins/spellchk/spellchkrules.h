@@ -0,0 +1,109 @@
+/*
+ * Pidgin - Internet Messenger
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * Pidgin is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef PIDGIN_SPELLCHK_RULES_H
+#define PIDGIN_SPELLCHK_RULES_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * SpellchkRules:
+ *
+ * An index of the replacement rules of the text replacement plugin, so that
+ * finding the rule for a word doesn't have to go through every rule.  When
+ * several rules match, the one that was added first wins.
+ */
+typedef struct _SpellchkRules SpellchkRules;
+
+/**
+ * spellchk_rules_new:
+ *
+ * Creates an empty set of rules.
+ *
+ * Returns: (transfer full): The new rules.
+ */
+SpellchkRules *spellchk_rules_new(void);
+
+/**
+ * spellchk_rules_free:
+ * @rules: The rules.
+ *
+ * Frees @rules.
+ */
+void spellchk_rules_free(SpellchkRules *rules);
+
+/**
+ * spellchk_rules_add:
+ * @rules: The rules.
+ * @bad: The text to replace.
+ * @good: The text to replace @bad with.
+ * @word_only: Whether @bad only matches whole words.
+ * @case_sensitive: Whether @bad is matched case sensitively.  Rules that are
+ *                  not @word_only are always case sensitive.
+ *
+ * Adds a rule after all of the ones that were added before.  Rules with an
+ * empty @bad or no @good never match.
+ */
+void spellchk_rules_add(SpellchkRules *rules, const gchar *bad, const gchar *good, gboolean word_only, gboolean case_sensitive);
+
+/**
+ * spellchk_rules_has_phrases:
+ * @rules: The rules.
+ *
+ * Checks whether any rule replaces text that isn't a whole word.
+ *
+ * Returns: %TRUE if spellchk_rules_find_phrase() can find anything.
+ */
+gboolean spellchk_rules_has_phrases(SpellchkRules *rules);
+
+/**
+ * spellchk_rules_find_phrase:
+ * @rules: The rules.
+ * @text: The text to search.
+ * @bad: (out) (transfer none): Return address for the text that was found.
+ * @good: (out) (transfer none): Return address for its replacement.
+ *
+ * Finds the first rule that isn't word only and matches anywhere in @text.
+ *
+ * Returns: A pointer into @text to the last occurrence of @bad, or %NULL if
+ *          no rule matches.
+ */
+const gchar *spellchk_rules_find_phrase(SpellchkRules *rules, const gchar *text, const gchar **bad, const gchar **good);
+
+/**
+ * spellchk_rules_substitute_word:
+ * @rules: The rules.
+ * @word: The word to replace.
+ *
+ * Finds the first word only rule for @word.  If a case insensitive rule is
+ * all lowercase, the replacement follows the case of @word.
+ *
+ * Returns: (transfer full): The replacement for @word, or %NULL if no rule
+ *          matches.
+ */
+gchar *spellchk_rules_substitute_word(SpellchkRules *rules, const gchar *word);
+
+G_END_DECLS
+
+#endif /* PIDGIN_SPELLCHK_RULES_H */
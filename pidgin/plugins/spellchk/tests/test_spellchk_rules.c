@@ -0,0 +1,341 @@
+/*
+ * Pidgin - Internet Messenger
+ * Copyright (C) Pidgin Developers <devel@pidgin.im>
+ *
+ * Pidgin is the legal property of its developers, whose names are too numerous
+ * to list here.  Please refer to the COPYRIGHT file distributed with this
+ * source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include "spellchkrules.h"
+
+typedef struct {
+	const gchar *bad;
+	const gchar *good;
+	gboolean word_only;
+	gboolean case_sensitive;
+} TestSpellchkRule;
+
+/* Several rules for the same words, so which one wins depends on the order. */
+static const TestSpellchkRule test_rules[] = {
+	{ "teh", "the", TRUE, FALSE },
+	{ "Teh", "THE", TRUE, TRUE },
+	{ "TEH", "tEh", TRUE, FALSE },
+	{ "TeH", "nope", TRUE, TRUE },
+	{ "dont", "don't", TRUE, FALSE },
+	{ "Dont", "do not", TRUE, TRUE },
+	{ "ÄRGER", "anger", TRUE, FALSE },
+	{ "straße", "road", TRUE, FALSE },
+	{ "Pidgin", "pidgin", TRUE, FALSE },
+	{ "c", "see", TRUE, FALSE },
+	{ "c ya", "see you", FALSE, TRUE },
+	{ "ya", "you", FALSE, TRUE },
+	{ "yaya", "nope", FALSE, TRUE },
+	{ "b4", "before", FALSE, TRUE },
+	{ "ya", "nope", FALSE, TRUE },
+	{ "dont", "nope", FALSE, TRUE },
+};
+
+static const gchar *test_words[] = {
+	"teh", "Teh", "TEH", "tEh", "TeH", "dont", "Dont", "DONT", "dOnt",
+	"ärger", "Ärger", "ÄRGER", "straße", "STRASSE", "Straße", "pidgin",
+	"Pidgin", "PIDGIN", "c", "C", "c ya", "ya", "b4", "other", "",
+};
+
+static const gchar *test_texts[] = {
+	"c ya later", "ya c ya", "yaya", "b4 ya", "ya b4", "c", "dont", "nothing",
+	"", "c yc ya", "b4b4",
+};
+
+/******************************************************************************
+ * The linear scan the index replaced, kept as the reference.
+ *****************************************************************************/
+static gboolean
+test_is_word_uppercase(const gchar *word)
+{
+	for (; word[0] != '\0'; word = g_utf8_find_next_char (word, NULL)) {
+		gunichar c = g_utf8_get_char(word);
+
+		if (!(g_unichar_isupper(c) ||
+		      g_unichar_ispunct(c) ||
+		      g_unichar_isspace(c)))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+test_is_word_lowercase(const gchar *word)
+{
+	for (; word[0] != '\0'; word = g_utf8_find_next_char(word, NULL)) {
+		gunichar c = g_utf8_get_char(word);
+
+		if (!(g_unichar_islower(c) ||
+		      g_unichar_ispunct(c) ||
+		      g_unichar_isspace(c)))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+test_is_word_proper(const gchar *word)
+{
+	if (word[0] == '\0')
+		return FALSE;
+
+	if (!g_unichar_isupper(g_utf8_get_char_validated(word, -1)))
+		return FALSE;
+
+	return test_is_word_lowercase(g_utf8_offset_to_pointer(word, 1));
+}
+
+static gchar *
+test_make_word_proper(const gchar *word)
+{
+	char buf[7];
+	gchar *lower = g_utf8_strdown(word, -1);
+	gint bytes;
+	gchar *ret;
+
+	bytes = g_unichar_to_utf8(g_unichar_toupper(g_utf8_get_char(word)), buf);
+	g_assert(bytes >= 0);
+	buf[MIN((gsize)bytes, sizeof(buf) - 1)] = '\0';
+
+	ret = g_strconcat(buf, g_utf8_offset_to_pointer(lower, 1), NULL);
+	g_free(lower);
+
+	return ret;
+}
+
+static gchar *
+test_linear_substitute_word(const gchar *word)
+{
+	gchar *outword = NULL;
+	gchar *lowerword = g_utf8_strdown(word, -1);
+	gchar *foldedword = g_utf8_casefold(word, -1);
+
+	for (guint i = 0; i < G_N_ELEMENTS(test_rules); i++) {
+		const TestSpellchkRule *rule = &test_rules[i];
+		gchar *tmpbad = NULL;
+		gboolean match;
+
+		if (!rule->word_only)
+			continue;
+
+		match = (rule->case_sensitive && g_strcmp0(rule->bad, word) == 0) ||
+		        (!rule->case_sensitive &&
+		         (g_strcmp0(rule->bad, lowerword) == 0 ||
+		          (!test_is_word_lowercase(rule->bad) &&
+		           g_strcmp0((tmpbad = g_utf8_casefold(rule->bad, -1)),
+		                     foldedword) == 0)));
+		g_free(tmpbad);
+
+		if (!match)
+			continue;
+
+		if (!rule->case_sensitive && test_is_word_lowercase(rule->bad) &&
+		    test_is_word_lowercase(rule->good))
+		{
+			if (test_is_word_uppercase(word))
+				outword = g_utf8_strup(rule->good, -1);
+			else if (test_is_word_proper(word))
+				outword = test_make_word_proper(rule->good);
+			else
+				outword = g_strdup(rule->good);
+		} else {
+			outword = g_strdup(rule->good);
+		}
+
+		break;
+	}
+
+	g_free(lowerword);
+	g_free(foldedword);
+
+	return outword;
+}
+
+static const gchar *
+test_linear_find_phrase(const gchar *text, const gchar **bad,
+                        const gchar **good)
+{
+	for (guint i = 0; i < G_N_ELEMENTS(test_rules); i++) {
+		const TestSpellchkRule *rule = &test_rules[i];
+		const gchar *cursor;
+
+		if (rule->word_only)
+			continue;
+
+		if ((cursor = g_strrstr(text, rule->bad))) {
+			*bad = rule->bad;
+			*good = rule->good;
+
+			return cursor;
+		}
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ * Helpers
+ *****************************************************************************/
+static SpellchkRules *
+test_spellchk_rules_new(void)
+{
+	SpellchkRules *rules = spellchk_rules_new();
+
+	for (guint i = 0; i < G_N_ELEMENTS(test_rules); i++) {
+		spellchk_rules_add(rules, test_rules[i].bad, test_rules[i].good,
+		                   test_rules[i].word_only,
+		                   test_rules[i].case_sensitive);
+	}
+
+	return rules;
+}
+
+/******************************************************************************
+ * Tests
+ *****************************************************************************/
+static void
+test_spellchk_rules_word_matches_linear(void)
+{
+	SpellchkRules *rules = test_spellchk_rules_new();
+
+	for (guint i = 0; i < G_N_ELEMENTS(test_words); i++) {
+		gchar *expected = test_linear_substitute_word(test_words[i]);
+		gchar *actual = spellchk_rules_substitute_word(rules, test_words[i]);
+
+		g_test_message("word '%s'", test_words[i]);
+		g_assert_cmpstr(actual, ==, expected);
+
+		g_free(expected);
+		g_free(actual);
+	}
+
+	spellchk_rules_free(rules);
+}
+
+static void
+test_spellchk_rules_phrase_matches_linear(void)
+{
+	SpellchkRules *rules = test_spellchk_rules_new();
+
+	for (guint i = 0; i < G_N_ELEMENTS(test_texts); i++) {
+		const gchar *expected_bad = NULL, *expected_good = NULL;
+		const gchar *bad = NULL, *good = NULL;
+		const gchar *expected = NULL, *actual = NULL;
+
+		expected = test_linear_find_phrase(test_texts[i], &expected_bad,
+		                                   &expected_good);
+		actual = spellchk_rules_find_phrase(rules, test_texts[i], &bad,
+		                                    &good);
+
+		g_test_message("text '%s'", test_texts[i]);
+		g_assert_true(actual == expected);
+		g_assert_cmpstr(bad, ==, expected_bad);
+		g_assert_cmpstr(good, ==, expected_good);
+	}
+
+	spellchk_rules_free(rules);
+}
+
+static void
+test_spellchk_rules_first_wins(void)
+{
+	SpellchkRules *rules = test_spellchk_rules_new();
+	const gchar *bad = NULL, *good = NULL;
+	gchar *word = NULL;
+
+	/* "teh" comes before the case sensitive "Teh", which it also matches. */
+	word = spellchk_rules_substitute_word(rules, "Teh");
+	g_assert_cmpstr(word, ==, "The");
+	g_free(word);
+
+	/* "ya" is in the list twice, and before "yaya". */
+	g_assert_nonnull(spellchk_rules_find_phrase(rules, "yaya", &bad, &good));
+	g_assert_cmpstr(bad, ==, "ya");
+	g_assert_cmpstr(good, ==, "you");
+
+	spellchk_rules_free(rules);
+}
+
+static void
+test_spellchk_rules_word_only(void)
+{
+	SpellchkRules *rules = test_spellchk_rules_new();
+	const gchar *bad = NULL, *good = NULL;
+	gchar *word = NULL;
+
+	/* Phrase rules never replace a word on their own... */
+	g_assert_null(spellchk_rules_substitute_word(rules, "b4"));
+
+	/* ...and word rules are never found inside text. */
+	g_assert_null(spellchk_rules_find_phrase(rules, "Pidgin", &bad, &good));
+
+	/* The word rule for "dont" wins over the phrase rule for words. */
+	word = spellchk_rules_substitute_word(rules, "dont");
+	g_assert_cmpstr(word, ==, "don't");
+	g_free(word);
+
+	g_assert_nonnull(spellchk_rules_find_phrase(rules, "dont", &bad, &good));
+	g_assert_cmpstr(good, ==, "nope");
+
+	g_assert_true(spellchk_rules_has_phrases(rules));
+
+	spellchk_rules_free(rules);
+}
+
+static void
+test_spellchk_rules_empty(void)
+{
+	SpellchkRules *rules = spellchk_rules_new();
+
+	spellchk_rules_add(rules, "", "empty", FALSE, TRUE);
+	spellchk_rules_add(rules, "word", "words", TRUE, FALSE);
+
+	g_assert_false(spellchk_rules_has_phrases(rules));
+	g_assert_null(spellchk_rules_find_phrase(rules, "some text", NULL, NULL));
+
+	spellchk_rules_free(rules);
+}
+
+/******************************************************************************
+ * Main
+ *****************************************************************************/
+gint
+main(gint argc, gchar *argv[])
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/spellchk/rules/word-matches-linear",
+	                test_spellchk_rules_word_matches_linear);
+	g_test_add_func("/spellchk/rules/phrase-matches-linear",
+	                test_spellchk_rules_phrase_matches_linear);
+	g_test_add_func("/spellchk/rules/first-wins",
+	                test_spellchk_rules_first_wins);
+	g_test_add_func("/spellchk/rules/word-only",
+	                test_spellchk_rules_word_only);
+	g_test_add_func("/spellchk/rules/empty",
+	                test_spellchk_rules_empty);
+
+	return g_test_run();
+}
@@ -34,39 +34,63 @@
 #include <string.h>
 #include <unistd.h>
 
-struct _GntTextView
-{
-	GntWidget parent;
-
-	GString *string;
-	GList *list; /* List of GntTextLine */
-
-	GList *tags; /* A list of tags */
-	GntTextViewFlag flags;
-};
+#define LINES_PER_CHUNK 128
 
 typedef struct
 {
 	GntTextFormatFlags tvflag;
 	chtype flags;
-	int start;
-	int end;     /* This is the next byte of the last character of this segment */
+	gsize start;
+	gsize end;   /* This is the next byte of the last character of this segment */
 } GntTextSegment;
 
 typedef struct
 {
-	GList *segments;         /* A list of GntTextSegments */
+	GArray *segments;        /* GntTextSegments, or NULL if the line is empty */
 	int length;              /* The current length of the line so far (ie. onscreen width) */
 	gboolean soft;           /* TRUE if it's an overflow from prev. line */
 } GntTextLine;
 
+typedef struct
+{
+	GntTextLine lines[LINES_PER_CHUNK];
+} GntTextChunk;
+
+/* The lines are stored oldest first in fixed size chunks. New lines go at the
+ * end, and old lines are dropped from the front a chunk at a time, so neither
+ * needs to touch the other lines. */
+typedef struct
+{
+	GPtrArray *chunks; /* GntTextChunks */
+	guint first;       /* The index of the oldest line in the first chunk */
+	guint count;       /* The number of lines */
+} GntTextLines;
+
+struct _GntTextView
+{
+	GntWidget parent;
+
+	GString *string;
+	gsize offset;   /* The position of the start of string in all the text
+	                   appended so far. Segments and tags use positions. */
+
+	GntTextLines lines;
+	guint scroll;    /* The number of lines below the bottom-most visible line */
+	guint max_lines; /* The scrollback limit, or 0 for no limit */
+
+	GList *tags; /* A list of tags */
+	GntTextViewFlag flags;
+};
+
 typedef struct
 {
 	char *name;
-	int start;
-	int end;
+	gsize start;
+	gsize end;
 } GntTextTag;
 
+#define TEXT_AT(view, pos) ((view)->string->str + ((pos) - (view)->offset))
+
 static gchar *select_start;
 static gchar *select_end;
 static gboolean double_click;
@@ -81,15 +105,201 @@ text_view_contains(GntTextView *view, const char *str)
 	return (str >= view->string->str && str < view->string->str + view->string->len);
 }
 
+static void
+free_tag(GntTextTag *tag)
+{
+	g_free(tag->name);
+	g_free(tag);
+}
+
+/******************************************************************************
+ * Line storage
+ *****************************************************************************/
+static void
+text_lines_init(GntTextLines *lines)
+{
+	lines->chunks = g_ptr_array_new_with_free_func(g_free);
+	lines->first = 0;
+	lines->count = 0;
+}
+
+/* Returns the n-th line counting from the newest line, which is 0. */
+static GntTextLine *
+text_lines_get(GntTextLines *lines, guint n)
+{
+	GntTextChunk *chunk;
+
+	n = lines->first + lines->count - 1 - n;
+	chunk = g_ptr_array_index(lines->chunks, n / LINES_PER_CHUNK);
+	return &chunk->lines[n % LINES_PER_CHUNK];
+}
+
+static GntTextLine *
+text_lines_append(GntTextLines *lines)
+{
+	guint n = lines->first + lines->count;
+
+	if (n / LINES_PER_CHUNK >= lines->chunks->len) {
+		g_ptr_array_add(lines->chunks, g_new0(GntTextChunk, 1));
+	}
+	lines->count++;
+
+	return text_lines_get(lines, 0);
+}
+
+static void
+clear_text_line(GntTextLine *line)
+{
+	g_clear_pointer(&line->segments, g_array_unref);
+	line->length = 0;
+	line->soft = FALSE;
+}
+
+static void
+text_lines_drop_oldest(GntTextLines *lines)
+{
+	GntTextChunk *chunk = g_ptr_array_index(lines->chunks, 0);
+
+	clear_text_line(&chunk->lines[lines->first]);
+	lines->count--;
+	if (++lines->first == LINES_PER_CHUNK) {
+		g_ptr_array_remove_index(lines->chunks, 0);
+		lines->first = 0;
+	}
+}
+
+static void
+text_lines_free(GntTextLines *lines)
+{
+	guint i;
+
+	if (lines->chunks == NULL) {
+		return;
+	}
+
+	for (i = 0; i < lines->count; i++) {
+		clear_text_line(text_lines_get(lines, i));
+	}
+	g_clear_pointer(&lines->chunks, g_ptr_array_unref);
+	lines->first = lines->count = 0;
+}
+
+static GntTextSegment *
+text_line_get_segment(GntTextLine *line, guint n)
+{
+	return &g_array_index(line->segments, GntTextSegment, n);
+}
+
+static guint
+text_line_get_n_segments(GntTextLine *line)
+{
+	return line->segments ? line->segments->len : 0;
+}
+
+/* Returns the position of the oldest text that is still shown. */
+static gsize
+text_lines_get_start(GntTextLines *lines, gsize end)
+{
+	guint i;
+
+	for (i = lines->count; i-- > 0;) {
+		GntTextLine *line = text_lines_get(lines, i);
+		if (text_line_get_n_segments(line) > 0) {
+			return text_line_get_segment(line, 0)->start;
+		}
+	}
+
+	return end;
+}
+
+static GntTextLine *
+add_line(GntTextView *view, gboolean soft)
+{
+	GntTextLine *line = text_lines_append(&view->lines);
+
+	line->soft = soft;
+	/* Keep the view on the line it was on */
+	if (view->lines.count > 1) {
+		view->scroll++;
+	}
+
+	return line;
+}
+
+/* Remove the n-th line counting from the newest line. */
+static void
+remove_line(GntTextView *view, guint n)
+{
+	GntTextLines *lines = &view->lines;
+	guint i;
+
+	clear_text_line(text_lines_get(lines, n));
+	for (i = n; i > 0; i--) {
+		*text_lines_get(lines, i) = *text_lines_get(lines, i - 1);
+	}
+	memset(text_lines_get(lines, 0), 0, sizeof(GntTextLine));
+	lines->count--;
+
+	if (n < view->scroll ||
+	    (n == view->scroll && n == lines->count && n > 0)) {
+		view->scroll--;
+	}
+
+	if (lines->count == 0) {
+		add_line(view, FALSE);
+	}
+}
+
+/* Drop the lines over the scrollback limit, and the text and tags for them. */
+static void
+trim_scrollback(GntTextView *view)
+{
+	gsize start;
+
+	if (view->max_lines == 0 || view->lines.count <= view->max_lines) {
+		return;
+	}
+
+	while (view->lines.count > view->max_lines) {
+		text_lines_drop_oldest(&view->lines);
+	}
+	view->scroll = MIN(view->scroll, view->lines.count - 1);
+
+	start = text_lines_get_start(&view->lines,
+	                             view->offset + view->string->len);
+
+	while (view->tags) {
+		GntTextTag *tag = view->tags->data;
+		if (tag->start >= start) {
+			break;
+		}
+		free_tag(tag);
+		view->tags = g_list_delete_link(view->tags, view->tags);
+	}
+
+	/* Moving the text is only worth it once it frees up most of the string,
+	 * so it's done rarely. */
+	if (start - view->offset > view->string->len / 2) {
+		if (text_view_contains(view, select_start) ||
+		    text_view_contains(view, select_end)) {
+			select_start = select_end = NULL;
+		}
+		g_string_erase(view->string, 0, start - view->offset);
+		view->offset = start;
+	}
+}
+
+/******************************************************************************
+ * GntWidget implementation
+ *****************************************************************************/
 static void
 gnt_text_view_draw(GntWidget *widget)
 {
 	GntTextView *view = GNT_TEXT_VIEW(widget);
 	WINDOW *window = gnt_widget_get_window(widget);
 	gint width, height;
-	int n;
+	guint n;
 	int i = 0;
-	GList *lines;
 	int rows, scrcol;
 	int comp = 0;          /* Used for top-aligned text */
 	gboolean has_scroll = !(view->flags & GNT_TEXT_VIEW_NO_SCROLL);
@@ -99,42 +309,40 @@ gnt_text_view_draw(GntWidget *widget)
 	wbkgd(window, gnt_color_pair(GNT_COLOR_NORMAL));
 	werase(window);
 
-	n = g_list_length(view->list);
-	if ((view->flags & GNT_TEXT_VIEW_TOP_ALIGN) && n < height) {
-		GList *now = view->list;
+	n = view->lines.count - view->scroll;
+	if ((view->flags & GNT_TEXT_VIEW_TOP_ALIGN) && n < (guint)height) {
 		comp = height - n;
-		view->list = g_list_nth_prev(view->list, comp);
-		if (!view->list) {
-			view->list = g_list_first(now);
-			comp = height - g_list_length(view->list);
-		} else {
+		if (view->scroll >= (guint)comp) {
+			view->scroll -= comp;
 			comp = 0;
+		} else {
+			view->scroll = 0;
+			comp = height - view->lines.count;
 		}
 	}
 
-	for (i = 0, lines = view->list; i < height && lines;
-	     i++, lines = lines->next) {
-		GList *iter;
-		GntTextLine *line = lines->data;
+	for (i = 0, n = view->scroll; i < height && n < view->lines.count;
+	     i++, n++) {
+		GntTextLine *line = text_lines_get(&view->lines, n);
+		guint s;
 
 		(void)wmove(window, height - 1 - i - comp, 0);
 
-		for (iter = line->segments; iter; iter = iter->next)
-		{
-			GntTextSegment *seg = iter->data;
-			char *end = view->string->str + seg->end;
+		for (s = 0; s < text_line_get_n_segments(line); s++) {
+			GntTextSegment *seg = text_line_get_segment(line, s);
+			char *start = TEXT_AT(view, seg->start);
+			char *end = TEXT_AT(view, seg->end);
 			char back = *end;
 			chtype fl = seg->flags;
 			*end = '\0';
-			if (select_start && select_start < view->string->str + seg->start && select_end > view->string->str + seg->end) {
+			if (select_start && select_start < start && select_end > end) {
 				fl |= A_REVERSE;
 				wattrset(window, fl);
-				wprintw(window, "%s",
-				        C_(view->string->str + seg->start));
+				wprintw(window, "%s", C_(start));
 			} else if (select_start && select_end &&
-				((select_start >= view->string->str + seg->start && select_start <= view->string->str + seg->end) ||
-				(select_end <= view->string->str + seg->end && select_start <= view->string->str + seg->start))) {
-				char *cur = view->string->str + seg->start;
+				((select_start >= start && select_start <= end) ||
+				(select_end <= end && select_start <= start))) {
+				char *cur = start;
 				while (*cur != '\0') {
 					gchar *last = g_utf8_next_char(cur);
 					gchar *str;
@@ -150,8 +358,7 @@ gnt_text_view_draw(GntWidget *widget)
 				}
 			} else {
 				wattrset(window, fl);
-				wprintw(window, "%s",
-				        C_(view->string->str + seg->start));
+				wprintw(window, "%s", C_(start));
 			}
 			*end = back;
 		}
@@ -161,16 +368,16 @@ gnt_text_view_draw(GntWidget *widget)
 
 	scrcol = width - 1;
 	rows = height - 2;
-	if (has_scroll && rows > 0 && lines != NULL)
+	if (has_scroll && rows > 0 && n < view->lines.count)
 	{
-		int total = g_list_length(g_list_first(view->list));
+		int total = view->lines.count;
 		int showing, position, up, down;
 
 		showing = rows * rows / total + 1;
 		showing = MIN(rows, showing);
 
 		total -= rows;
-		up = g_list_length(lines);
+		up = view->lines.count - n;
 		down = total - up;
 
 		position = (rows - showing) * up / MAX(1, up + down);
@@ -179,9 +386,9 @@ gnt_text_view_draw(GntWidget *widget)
 		if (showing + position > rows)
 			position = rows - showing;
 
-		if (showing + position == rows && view->list->prev)
+		if (showing + position == rows && view->scroll > 0)
 			position = MAX(1, rows - 1 - showing);
-		else if (showing + position < rows && !view->list->prev)
+		else if (showing + position < rows && view->scroll == 0)
 			position = rows - showing;
 
 		mvwvline(window, position + 1, scrcol,
@@ -191,10 +398,10 @@ gnt_text_view_draw(GntWidget *widget)
 
 	if (has_scroll) {
 		mvwaddch(window, 0, scrcol,
-		         (lines ? ACS_UARROW : ' ') |
+		         (n < view->lines.count ? ACS_UARROW : ' ') |
 		                 gnt_color_pair(GNT_COLOR_HIGHLIGHT_D));
 		mvwaddch(window, height - 1, scrcol,
-		         ((view->list && view->list->prev) ? ACS_DARROW : ' ') |
+		         (view->scroll > 0 ? ACS_DARROW : ' ') |
 		                 gnt_color_pair(GNT_COLOR_HIGHLIGHT_D));
 	}
 
@@ -227,28 +434,12 @@ gnt_text_view_key_pressed(G_GNUC_UNUSED GntWidget *widget,
 	return FALSE;
 }
 
-static void
-free_text_line(GntTextLine *line)
-{
-	g_list_free_full(line->segments, (GDestroyNotify)g_free);
-	g_free(line);
-}
-
-static void
-free_tag(GntTextTag *tag)
-{
-	g_free(tag->name);
-	g_free(tag);
-}
-
 static void
 gnt_text_view_destroy(GntWidget *widget)
 {
 	GntTextView *view = GNT_TEXT_VIEW(widget);
 
-	g_list_free_full(g_list_first(view->list),
-	                 (GDestroyNotify)free_text_line);
-	view->list = NULL;
+	text_lines_free(&view->lines);
 
 	g_list_free_full(view->tags, (GDestroyNotify)free_tag);
 	view->tags = NULL;
@@ -263,14 +454,13 @@ gnt_text_view_get_p(GntTextView *view, int x, int y)
 	gint height;
 	int n;
 	int i = 0;
+	guint index;
 	GntWidget *wid = GNT_WIDGET(view);
 	GntTextLine *line;
-	GList *lines;
-	GList *segs;
 	GntTextSegment *seg;
 	gchar *pos;
 
-	n = g_list_length(view->list);
+	n = view->lines.count - view->scroll;
 	gnt_widget_get_internal_size(wid, NULL, &height);
 	y = height - y;
 	if (n < y) {
@@ -278,19 +468,18 @@ gnt_text_view_get_p(GntTextView *view, int x, int y)
 		y = n - 1;
 	}
 
-	lines = g_list_nth(view->list, y - 1);
-	if (!lines)
+	if (y < 1)
 		return NULL;
+	index = view->scroll + y - 1;
 	do {
-		line = lines->data;
-		lines = lines->next;
-	} while (line && !line->segments && lines);
+		line = text_lines_get(&view->lines, index++);
+	} while (text_line_get_n_segments(line) == 0 &&
+	         index < view->lines.count);
 
-	if (!line || !line->segments) /* no valid line */
+	if (text_line_get_n_segments(line) == 0) /* no valid line */
 		return NULL;
-	segs = line->segments;
-	seg = (GntTextSegment *)segs->data;
-	pos = view->string->str + seg->start;
+	seg = text_line_get_segment(line, 0);
+	pos = TEXT_AT(view, seg->start);
 	x = MIN(x, line->length);
 	while (++i <= x) {
 		gunichar *u;
@@ -396,57 +585,58 @@ static void
 gnt_text_view_reflow(GntTextView *view)
 {
 	/* This is pretty ugly, and inefficient. Someone do something about it. */
-	GntTextLine *line;
-	GList *back, *iter, *list;
+	GntTextLines lines;
 	GString *string;
+	gsize offset, text_start;
+	guint i, s, index;
 	int pos = 0;    /* no. of 'real' lines */
 
-	list = view->list;
-	while (list->prev) {
-		line = list->data;
-		if (!line->soft)
+	for (i = 1; i <= view->scroll; i++) {
+		if (!text_lines_get(&view->lines, i)->soft)
 			pos++;
-		list = list->prev;
 	}
 
-	back = g_list_last(view->list);
-	view->list = NULL;
+	lines = view->lines;
+	view->lines.chunks = NULL;
 
 	string = view->string;
+	offset = view->offset;
+	text_start = text_lines_get_start(&lines, offset + string->len);
 	view->string = NULL;
 	reset_text_view(view);
 
 	view->string = g_string_set_size(view->string, string->len);
 	view->string->len = 0;
+	view->offset = text_start;
 	gnt_widget_set_drawing(GNT_WIDGET(view), TRUE);
 
-	for (; back; back = back->prev) {
-		line = back->data;
-		if (back->next && !line->soft) {
+	for (i = lines.count; i-- > 0;) {
+		GntTextLine *line = text_lines_get(&lines, i);
+		if (i + 1 < lines.count && !line->soft) {
 			gnt_text_view_append_text_with_flags(view, "\n", GNT_TEXT_FLAG_NORMAL);
 		}
 
-		for (iter = line->segments; iter; iter = iter->next) {
-			GntTextSegment *seg = iter->data;
-			char *start = string->str + seg->start;
-			char *end = string->str + seg->end;
+		for (s = 0; s < text_line_get_n_segments(line); s++) {
+			GntTextSegment *seg = text_line_get_segment(line, s);
+			char *start = string->str + (seg->start - offset);
+			char *end = string->str + (seg->end - offset);
 			char back = *end;
 			*end = '\0';
 			gnt_text_view_append_text_with_flags(view, start, seg->tvflag);
 			*end = back;
 		}
-		free_text_line(line);
 	}
-	g_list_free(list);
+	text_lines_free(&lines);
 
-	list = g_list_first(view->list);
 	/* Go back to the line that was in view before resizing started */
+	index = 0;
 	while (pos--) {
-		while (((GntTextLine*)list->data)->soft)
-			list = list->next;
-		list = list->next;
+		while (index < view->lines.count &&
+		       text_lines_get(&view->lines, index)->soft)
+			index++;
+		index++;
 	}
-	view->list = list;
+	view->scroll = MIN(index, view->lines.count - 1);
 	gnt_widget_set_drawing(GNT_WIDGET(view), FALSE);
 	if (gnt_widget_get_window(GNT_WIDGET(view))) {
 		gnt_widget_draw(GNT_WIDGET(view));
@@ -482,7 +672,6 @@ static void
 gnt_text_view_init(GntTextView *view)
 {
 	GntWidget *widget = GNT_WIDGET(view);
-	GntTextLine *line = g_new0(GntTextLine, 1);
 
 	gnt_widget_set_has_border(widget, FALSE);
 	gnt_widget_set_has_shadow(widget, FALSE);
@@ -490,7 +679,8 @@ gnt_text_view_init(GntTextView *view)
 	gnt_widget_set_grow_y(widget, TRUE);
 	gnt_widget_set_minimum_size(widget, 5, 2);
 	view->string = g_string_new(NULL);
-	view->list = g_list_append(view->list, line);
+	text_lines_init(&view->lines);
+	add_line(view, FALSE);
 }
 
 /******************************************************************************
@@ -516,7 +706,6 @@ void gnt_text_view_append_text_with_tag(GntTextView *view, const char *text,
 	gint widget_width;
 	chtype fl = 0;
 	const char *start, *end;
-	GList *list = view->list;
 	GntTextLine *line;
 	int len;
 	gboolean has_scroll = !(view->flags & GNT_TEXT_VIEW_NO_SCROLL);
@@ -534,13 +723,11 @@ void gnt_text_view_append_text_with_tag(GntTextView *view, const char *text,
 	if (tagname) {
 		GntTextTag *tag = g_new0(GntTextTag, 1);
 		tag->name = g_strdup(tagname);
-		tag->start = len;
-		tag->end = view->string->len;
+		tag->start = view->offset + len;
+		tag->end = view->offset + view->string->len;
 		view->tags = g_list_append(view->tags, tag);
 	}
 
-	view->list = g_list_first(view->list);
-
 	start = end = view->string->str + len;
 
 	while (*start) {
@@ -552,17 +739,14 @@ void gnt_text_view_append_text_with_tag(GntTextView *view, const char *text,
 				end++;
 			end++;
 			start = end;
-			gnt_text_view_next_line(view);
-			view->list = g_list_first(view->list);
+			add_line(view, FALSE);
 			continue;
 		}
 
-		line = view->list->data;
+		line = text_lines_get(&view->lines, 0);
 		if (line->length == widget_width - has_scroll) {
 			/* The last added line was exactly the same width as the widget */
-			line = g_new0(GntTextLine, 1);
-			line->soft = TRUE;
-			view->list = g_list_prepend(view->list, line);
+			line = add_line(view, TRUE);
 		}
 
 		if ((end = strchr(start, '\r')) != NULL ||
@@ -580,41 +764,46 @@ void gnt_text_view_append_text_with_tag(GntTextView *view, const char *text,
 			        &len);
 
 		/* Try to append to the previous segment if possible */
-		if (line->segments) {
-			seg = g_list_last(line->segments)->data;
+		if (text_line_get_n_segments(line) > 0) {
+			seg = text_line_get_segment(line, line->segments->len - 1);
 			if (seg->flags != fl)
 				seg = NULL;
 		}
 
 		if (seg == NULL) {
-			seg = g_new0(GntTextSegment, 1);
-			seg->start = start - view->string->str;
-			seg->tvflag = flags;
-			seg->flags = fl;
-			line->segments = g_list_append(line->segments, seg);
+			GntTextSegment newseg = {
+				.tvflag = flags,
+				.flags = fl,
+				.start = view->offset + (start - view->string->str),
+			};
+
+			if (line->segments == NULL) {
+				line->segments = g_array_sized_new(
+				        FALSE, FALSE, sizeof(GntTextSegment), 1);
+			}
+			g_array_append_val(line->segments, newseg);
+			seg = text_line_get_segment(line, line->segments->len - 1);
 		}
 
 		oldl = line;
 		if (wrap_word && *end && *end != '\n' && *end != '\r') {
 			const char *tmp = end;
 			while (end && *end != '\n' && *end != '\r' && !g_ascii_isspace(*end)) {
-				end = g_utf8_find_prev_char(seg->start + view->string->str, end);
+				end = g_utf8_find_prev_char(TEXT_AT(view, seg->start), end);
 			}
 			if (!end || !g_ascii_isspace(*end))
 				end = tmp;
 			else
 				end++; /* Remove the space */
 
-			line = g_new0(GntTextLine, 1);
-			line->soft = TRUE;
-			view->list = g_list_prepend(view->list, line);
+			add_line(view, TRUE);
 		}
-		seg->end = end - view->string->str;
+		seg->end = view->offset + (end - view->string->str);
 		oldl->length += len;
 		start = end;
 	}
 
-	view->list = list;
+	trim_scrollback(view);
 
 	gnt_widget_draw(widget);
 }
@@ -631,21 +820,19 @@ void gnt_text_view_scroll(GntTextView *view, int scroll)
 {
 	if (scroll == 0)
 	{
-		view->list = g_list_first(view->list);
+		view->scroll = 0;
 	}
 	else if (scroll > 0)
 	{
-		GList *list = g_list_nth_prev(view->list, scroll);
-		if (list == NULL)
-			list = g_list_first(view->list);
-		view->list = list;
+		if ((guint)scroll >= view->scroll)
+			view->scroll = 0;
+		else
+			view->scroll -= scroll;
 	}
 	else if (scroll < 0)
 	{
-		GList *list = g_list_nth(view->list, -scroll);
-		if (list == NULL)
-			list = g_list_last(view->list);
-		view->list = list;
+		view->scroll = MIN(view->scroll + (guint)-scroll,
+		                   view->lines.count - 1);
 	}
 
 	gnt_widget_draw(GNT_WIDGET(view));
@@ -653,11 +840,8 @@ void gnt_text_view_scroll(GntTextView *view, int scroll)
 
 void gnt_text_view_next_line(GntTextView *view)
 {
-	GntTextLine *line = g_new0(GntTextLine, 1);
-	GList *list = view->list;
-
-	view->list = g_list_prepend(g_list_first(view->list), line);
-	view->list = list; // -V519
+	add_line(view, FALSE);
+	trim_scrollback(view);
 
 	gnt_widget_draw(GNT_WIDGET(view));
 }
@@ -687,16 +871,15 @@ chtype gnt_text_format_flag_to_chtype(GntTextFormatFlags flags)
 
 static void reset_text_view(GntTextView *view)
 {
-	GntTextLine *line;
-
-	g_list_free_full(view->list, (GDestroyNotify)free_text_line);
-	view->list = NULL;
+	text_lines_free(&view->lines);
+	text_lines_init(&view->lines);
+	view->scroll = 0;
+	add_line(view, FALSE);
 
-	line = g_new0(GntTextLine, 1);
-	view->list = g_list_append(view->list, line);
 	if (view->string)
 		g_string_free(view->string, TRUE);
 	view->string = g_string_new(NULL);
+	view->offset = 0;
 }
 
 void gnt_text_view_clear(GntTextView *view)
@@ -713,25 +896,38 @@ void gnt_text_view_clear(GntTextView *view)
 
 int gnt_text_view_get_lines_below(GntTextView *view)
 {
-	int below = 0;
-	GList *list = view->list;
-	while ((list = list->prev))
-		++below;
-	return below;
+	return view->scroll;
 }
 
 int gnt_text_view_get_lines_above(GntTextView *view)
 {
-	int above = 0;
 	gint height;
-	GList *list;
+	guint shown;
 	gnt_widget_get_internal_size(GNT_WIDGET(view), NULL, &height);
-	list = g_list_nth(view->list, height);
-	if (!list)
+	shown = view->scroll + MAX(height, 0) + 1;
+	if (view->lines.count <= shown)
 		return 0;
-	while ((list = list->next))
-		++above;
-	return above;
+	return view->lines.count - shown;
+}
+
+void gnt_text_view_set_max_lines(GntTextView *view, guint lines)
+{
+	g_return_if_fail(GNT_IS_TEXT_VIEW(view));
+
+	view->max_lines = lines;
+	if (view->lines.count > lines && lines > 0) {
+		trim_scrollback(view);
+		if (gnt_widget_get_window(GNT_WIDGET(view))) {
+			gnt_widget_draw(GNT_WIDGET(view));
+		}
+	}
+}
+
+guint gnt_text_view_get_max_lines(GntTextView *view)
+{
+	g_return_val_if_fail(GNT_IS_TEXT_VIEW(view), 0);
+
+	return view->max_lines;
 }
 
 /*
@@ -739,22 +935,22 @@ int gnt_text_view_get_lines_above(GntTextView *view)
  */
 int gnt_text_view_tag_change(GntTextView *view, const char *name, const char *text, gboolean all)
 {
-	GList *alllines = g_list_first(view->list);
-	GList *list, *next, *iter, *inext;
+	GList *list, *next, *iter;
 	const int text_length = text ? strlen(text) : 0;
 	int count = 0;
 	for (list = view->tags; list; list = next) {
 		GntTextTag *tag = list->data;
 		next = list->next;
 		if (strcmp(tag->name, name) == 0) {
-			int change;
+			gssize change;
 			char *before, *after;
+			guint n;
 
 			count++;
 
-			before = g_strndup(view->string->str, tag->start);
-			after = g_strdup(view->string->str + tag->end);
-			change = (tag->end - tag->start) - text_length;
+			before = g_strndup(view->string->str, tag->start - view->offset);
+			after = g_strdup(TEXT_AT(view, tag->end));
+			change = (gssize)(tag->end - tag->start) - text_length;
 
 			g_string_printf(view->string, "%s%s%s", before, text ? text : "", after);
 			g_free(before);
@@ -768,20 +964,14 @@ int gnt_text_view_tag_change(GntTextView *view, const char *name, const char *te
 			}
 
 			/* Update the offsets of the segments */
-			for (iter = alllines; iter; iter = inext) {
-				GList *segs, *snext;
-				GntTextLine *line = iter->data;
-				inext = iter->next;
-
-				if (G_UNLIKELY(line == NULL)) {
-					g_warn_if_reached();
-					continue;
-				}
+			for (n = 0; n < view->lines.count;) {
+				GntTextLine *line = text_lines_get(&view->lines, n);
+				gboolean removed = FALSE;
+				guint s = 0;
 
-				for (segs = line->segments; line && segs; segs = snext) {
-					GntTextSegment *seg = segs->data;
+				while (s < text_line_get_n_segments(line)) {
+					GntTextSegment *seg = text_line_get_segment(line, s);
 
-					snext = segs->next;
 					if (seg->start >= tag->end) {
 						/* The segment is somewhere after the tag */
 						seg->start -= change;
@@ -791,32 +981,31 @@ int gnt_text_view_tag_change(GntTextView *view, const char *name, const char *te
 					} else if (seg->start >= tag->start) {
 						/* This segment starts in the middle of the tag */
 						if (text == NULL) {
-							g_free(seg);
-							line->segments = g_list_delete_link(line->segments, segs);
-							if (line->segments == NULL) {
-								free_text_line(line);
-								line = NULL;
-								if (view->list == iter) {
-									if (inext)
-										view->list = inext;
-									else
-										view->list = iter->prev;
-								}
-								alllines = g_list_delete_link(alllines, iter);
+							g_array_remove_index(line->segments, s);
+							if (line->segments->len == 0) {
+								/* The older lines move down */
+								remove_line(view, n);
+								removed = TRUE;
+								break;
 							}
+							line->length -= change;
+							continue;
 						} else {
 							/* XXX: (null) */
 							seg->start = tag->start;
 							seg->end = tag->end - change;
 						}
-						if (line)
-							line->length -= change;
+						line->length -= change;
 						/* XXX: Make things work if the tagged text spans over several lines. */
 					} else {
 						/* XXX: handle the rest of the conditions */
 						gnt_warning("WTF! This needs to be handled properly!!%s", "");
 					}
+					s++;
 				}
+
+				if (!removed)
+					n++;
 			}
 			if (text == NULL) {
 				/* Remove the tag */
@@ -163,6 +163,30 @@ int gnt_text_view_get_lines_below(GntTextView *view);
  */
 int gnt_text_view_get_lines_above(GntTextView *view);
 
+/**
+ * gnt_text_view_set_max_lines:
+ * @view:  The textview.
+ * @lines: The maximum number of lines to keep, or 0 for no limit.
+ *
+ * Limit the number of lines kept in the textview. When more lines are added,
+ * the oldest lines are dropped, along with their text and tags.
+ *
+ * Since: 3.0.0
+ */
+void gnt_text_view_set_max_lines(GntTextView *view, guint lines);
+
+/**
+ * gnt_text_view_get_max_lines:
+ * @view:  The textview.
+ *
+ * Get the scrollback limit of the textview.
+ *
+ * Returns: The maximum number of lines kept, or 0 if there is no limit.
+ *
+ * Since: 3.0.0
+ */
+guint gnt_text_view_get_max_lines(GntTextView *view);
+
 /**
  * gnt_text_view_tag_change:
  * @view:   The textview.
@@ -82,6 +82,7 @@ typedef struct
 
 	GList *list;      /* List of GntTreeRow s */
 	GHashTable *hash; /* We need this for quickly referencing the rows */
+	GSequence *roots; /* The toplevel rows, in display order */
 
 	int ncol;                /* No. of columns */
 	GntTreeColInfo *columns; /* Would a GList be better? */
@@ -121,6 +122,12 @@ struct _GntTreeRow
 	GntTreeRow *next;
 	GntTreeRow *prev;
 
+	/* The siblings are also kept in a GSequence, which is a balanced tree, so
+	 * that sorted inserts and moves don't need to walk all of them. */
+	GSequence *children;  /* The child rows, in display order */
+	GSequenceIter *iter;  /* Position in the parent's (or the root) sequence */
+	GList *link;          /* Position in the list of all rows */
+
 	GList *columns;
 	GntTree *tree;
 };
@@ -180,18 +187,46 @@ readjust_columns(GntTree *tree)
 	}
 }
 
-/* Move the item at position old to position new */
+/* Insert link into list right after sibling. If sibling is NULL, link is
+ * prepended. */
 static GList *
-g_list_reposition_child(GList *list, int old, int new)
+list_insert_link_after(GList *list, GList *sibling, GList *link)
 {
-	gpointer item = g_list_nth_data(list, old);
-	list = g_list_remove(list, item);
-	if (old < new)
-		new--;   /* because the positions would have shifted after removing the item */
-	list = g_list_insert(list, item, new);
+	if (sibling == NULL) {
+		link->prev = NULL;
+		link->next = list;
+		if (list)
+			list->prev = link;
+		return link;
+	}
+
+	link->prev = sibling;
+	link->next = sibling->next;
+	if (sibling->next)
+		sibling->next->prev = link;
+	sibling->next = link;
 	return list;
 }
 
+static gint
+row_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	GntTreePrivate *priv = data;
+	const GntTreeRow *ra = a, *rb = b;
+
+	return priv->compare(ra->key, rb->key);
+}
+
+static GSequence *
+get_siblings(GntTreePrivate *priv, GntTreeRow *parent)
+{
+	if (parent == NULL)
+		return priv->roots;
+	if (parent->children == NULL)
+		parent->children = g_sequence_new(NULL);
+	return parent->children;
+}
+
 static GntTreeRow *
 _get_next(GntTreeRow *row, gboolean godeep)
 {
@@ -643,7 +678,8 @@ redraw_tree(GntTree *tree)
 		int total = 0;
 		int showing, position;
 
-		get_next_n_opt(priv->root, g_list_length(priv->list), &total);
+		get_next_n_opt(priv->root, g_hash_table_size(priv->hash),
+		               &total);
 		showing = rows * rows / MAX(total, 1) + 1;
 		showing = MIN(rows, showing);
 
@@ -967,6 +1003,7 @@ gnt_tree_destroy(GntWidget *widget)
 	end_search(tree);
 	g_clear_pointer(&priv->hash, g_hash_table_destroy);
 	g_clear_pointer(&priv->list, g_list_free);
+	g_clear_pointer(&priv->roots, g_sequence_free);
 	gnt_tree_free_columns(priv);
 }
 
@@ -1240,6 +1277,7 @@ gnt_tree_init(GntTree *tree)
 	GntWidget *widget = GNT_WIDGET(tree);
 
 	priv->show_separator = TRUE;
+	priv->roots = g_sequence_new(NULL);
 
 	gnt_widget_set_grow_x(widget, TRUE);
 	gnt_widget_set_grow_y(widget, TRUE);
@@ -1269,6 +1307,7 @@ free_tree_row(gpointer data)
 		return;
 
 	g_list_free_full(row->columns, free_tree_col);
+	g_clear_pointer(&row->children, g_sequence_free);
 	g_free(row);
 }
 
@@ -1345,31 +1384,33 @@ void gnt_tree_scroll(GntTree *tree, int count)
 static gpointer
 find_position(GntTreePrivate *priv, gpointer key, gpointer parent)
 {
-	GntTreeRow *row;
+	GntTreeRow *row, lookup = { 0 };
+	GSequence *siblings;
+	GSequenceIter *iter;
 
 	if (priv->compare == NULL) {
 		return NULL;
 	}
 
-	if (parent == NULL)
-		row = priv->root;
-	else
+	if (parent == NULL) {
+		siblings = priv->roots;
+	} else {
 		row = g_hash_table_lookup(priv->hash, parent);
+		if (!row)
+			return NULL;
+		siblings = row->children;
+	}
 
-	if (!row)
+	if (siblings == NULL)
 		return NULL;
 
-	if (parent)
-		row = row->child;
-
-	while (row)
-	{
-		if (priv->compare(key, row->key) < 0) {
-			return (row->prev ? row->prev->key : NULL);
-		}
-		if (row->next)
-			row = row->next;
-		else
+	/* The new row goes after the last sibling that doesn't sort after it. */
+	lookup.key = key;
+	iter = g_sequence_search(siblings, &lookup, row_compare, priv);
+	while (!g_sequence_iter_is_begin(iter)) {
+		iter = g_sequence_iter_prev(iter);
+		row = g_sequence_get(iter);
+		if (row->key != key)
 			return row->key;
 	}
 	return NULL;
@@ -1379,7 +1420,7 @@ void gnt_tree_sort_row(GntTree *tree, gpointer key)
 {
 	GntTreePrivate *priv = NULL;
 	GntTreeRow *row, *q, *s;
-	int current, newp;
+	GSequenceIter *iter;
 
 	g_return_if_fail(GNT_IS_TREE(tree));
 	priv = gnt_tree_get_instance_private(tree);
@@ -1391,62 +1432,53 @@ void gnt_tree_sort_row(GntTree *tree, gpointer key)
 	row = g_hash_table_lookup(priv->hash, key);
 	g_return_if_fail(row != NULL);
 
-	current = g_list_index(priv->list, key);
-
-	if (row->parent)
-		s = row->parent->child;
-	else
-		s = priv->root;
+	g_sequence_sort_changed(row->iter, row_compare, priv);
 
-	q = NULL;
-	while (s) {
-		if (priv->compare(row->key, s->key) < 0) {
-			break;
-		}
-		q = s;
-		s = s->next;
-	}
+	/* Find the new neighbours of the row */
+	iter = g_sequence_iter_prev(row->iter);
+	q = (iter != row->iter) ? g_sequence_get(iter) : NULL;
+	iter = g_sequence_iter_next(row->iter);
+	s = g_sequence_iter_is_end(iter) ? NULL : g_sequence_get(iter);
 
 	/* Move row between q and s */
-	if (row == q || row == s)
+	if (row->prev == q && row->next == s)
 		return;
 
-	if (q == NULL) {
+	if (row->prev) {
+		row->prev->next = row->next;
+	} else {
+		/* row was the first child of its parent */
+		if (row->parent)
+			row->parent->child = row->next;
+		else
+			priv->root = row->next;
+	}
+	if (row->next)
+		row->next->prev = row->prev;
+
+	if (q) {
+		q->next = row;
+	} else {
 		/* row becomes the first child of its parent */
-		row->prev->next = row->next;  /* row->prev cannot be NULL at this point */
-		if (row->next)
-			row->next->prev = row->prev;
 		if (row->parent)
 			row->parent->child = row;
 		else
 			priv->root = row;
-		row->next = s;
-		g_return_if_fail(s != NULL); /* s cannot be NULL */
+	}
+	if (s)
 		s->prev = row;
-		row->prev = NULL;
-		newp = g_list_index(priv->list, s) - 1;
-	} else {
-		if (row->prev) {
-			row->prev->next = row->next;
-		} else {
-			/* row was the first child of its parent */
-			if (row->parent)
-				row->parent->child = row->next;
-			else
-				priv->top = row->next;
-		}
+	row->prev = q;
+	row->next = s;
 
-		if (row->next)
-			row->next->prev = row->prev;
-
-		q->next = row;
-		row->prev = q;
-		if (s)
-			s->prev = row;
-		row->next = s;
-		newp = g_list_index(priv->list, q) + 1;
+	priv->list = g_list_remove_link(priv->list, row->link);
+	if (q) {
+		priv->list = list_insert_link_after(priv->list, q->link,
+		                                    row->link);
+	} else {
+		g_return_if_fail(s != NULL); /* s cannot be NULL */
+		priv->list = list_insert_link_after(priv->list, s->link->prev,
+		                                    row->link);
 	}
-	priv->list = g_list_reposition_child(priv->list, current, newp);
 
 	redraw_tree(tree);
 }
@@ -1472,11 +1504,15 @@ GntTreeRow *gnt_tree_add_row_after(GntTree *tree, void *key, GntTreeRow *row, vo
 		bigbro = find_position(priv, key, parent);
 	}
 
+	row->link = g_list_alloc();
+	row->link->data = key;
+
 	if (priv->root == NULL) {
 		priv->root = row;
-		priv->list = g_list_prepend(priv->list, key);
+		row->iter = g_sequence_prepend(priv->roots, row);
+		priv->list = list_insert_link_after(priv->list, NULL, row->link);
 	} else {
-		int position = 0;
+		GList *after = NULL;
 
 		if (bigbro)
 		{
@@ -1489,7 +1525,9 @@ GntTreeRow *gnt_tree_add_row_after(GntTree *tree, void *key, GntTreeRow *row, vo
 				pr->next = row;
 				row->parent = pr->parent;
 
-				position = g_list_index(priv->list, bigbro);
+				row->iter = g_sequence_insert_before(
+				        g_sequence_iter_next(pr->iter), row);
+				after = pr->link;
 			}
 		}
 
@@ -1503,7 +1541,9 @@ GntTreeRow *gnt_tree_add_row_after(GntTree *tree, void *key, GntTreeRow *row, vo
 				pr->child = row;
 				row->parent = pr;
 
-				position = g_list_index(priv->list, parent);
+				row->iter = g_sequence_prepend(
+				        get_siblings(priv, pr), row);
+				after = pr->link;
 			}
 		}
 
@@ -1516,13 +1556,10 @@ GntTreeRow *gnt_tree_add_row_after(GntTree *tree, void *key, GntTreeRow *row, vo
 				priv->current = row;
 			}
 			priv->root = row;
-			priv->list = g_list_prepend(priv->list, key);
-		}
-		else
-		{
-			priv->list =
-			        g_list_insert(priv->list, key, position + 1);
+			row->iter = g_sequence_prepend(priv->roots, row);
 		}
+
+		priv->list = list_insert_link_after(priv->list, after, row->link);
 	}
 	redraw_tree(tree);
 
@@ -1670,8 +1707,9 @@ void gnt_tree_remove(GntTree *tree, gpointer key)
 		if (row->prev)
 			row->prev->next = row->next;
 
+		g_sequence_remove(row->iter);
+		priv->list = g_list_delete_link(priv->list, row->link);
 		g_hash_table_remove(priv->hash, key);
-		priv->list = g_list_remove(priv->list, key);
 
 		if (redraw && depth == 0)
 		{
@@ -1689,6 +1727,8 @@ void gnt_tree_remove_all(GntTree *tree)
 
 	priv->root = NULL;
 	g_hash_table_remove_all(priv->hash);
+	g_sequence_remove_range(g_sequence_get_begin_iter(priv->roots),
+	                        g_sequence_get_end_iter(priv->roots));
 	g_list_free(priv->list);
 	priv->list = NULL;
 	priv->current = priv->top = priv->bottom = NULL;
@@ -67,12 +67,25 @@
 
 #define IDLE_CHECK_INTERVAL 5 /* 5 seconds */
 
+/* The screen is updated at most once per frame. */
+#define FRAME_INTERVAL (G_USEC_PER_SEC / 30)
+/* Past this many damaged areas, the whole screen is redrawn. */
+#define MAX_DAMAGE 16
+
 typedef struct
 {
 	int x;
 	int y;
 } GntPosition;
 
+typedef struct
+{
+	int x;
+	int y;
+	int width;
+	int height;
+} GntDamage;
+
 typedef struct
 {
 	GntWidget *window;
@@ -113,6 +126,16 @@ typedef struct
 	GntKeyPressMode mode;
 
 	GHashTable *positions;
+
+	/* Screen updates are queued and done from a single idle source. */
+	guint frame_source;
+	gint64 last_frame;
+	GArray *damage;      /* GntDamage areas changed since the last frame */
+	gboolean damage_all; /* TRUE if the whole screen needs to be redrawn */
+
+	gint64 frames_start; /* Start of the second the frames are counted in */
+	guint frames;        /* Frames drawn since frames_start */
+	guint frame_rate;    /* Frames drawn in the last full second */
 } GntWMPrivate;
 
 enum
@@ -207,8 +230,41 @@ gnt_wm_copy_win(GntWidget *widget, GntNode *node)
  * Caveat: If a wide character is erased, and the panel above it is moved enough
  * to expose the entire character, it is not always redrawn.
  */
+#if NCURSES_WIDECHAR
+/* Find the rows between sy and ey whose columns sx to ex have been damaged. */
+static gboolean
+get_damaged_rows(GntWMPrivate *priv, int sx, int ex, int *sy, int *ey)
+{
+	int top = G_MAXINT, bottom = G_MININT;
+	guint i;
+
+	if (priv->damage_all) {
+		return TRUE;
+	}
+
+	for (i = 0; i < priv->damage->len; i++) {
+		GntDamage *d = &g_array_index(priv->damage, GntDamage, i);
+
+		if (d->x > ex + 1 || d->x + d->width < sx - 1 ||
+		    d->y > *ey || d->y + d->height < *sy) {
+			continue;
+		}
+		top = MIN(top, d->y);
+		bottom = MAX(bottom, d->y + d->height);
+	}
+
+	if (top > bottom) {
+		return FALSE;
+	}
+
+	*sy = MAX(*sy, top);
+	*ey = MIN(*ey, bottom);
+	return TRUE;
+}
+#endif
+
 static void
-work_around_for_ncurses_bug(void)
+work_around_for_ncurses_bug(G_GNUC_UNUSED GntWMPrivate *priv)
 {
 #if NCURSES_WIDECHAR
 	PANEL *panel = NULL;
@@ -221,6 +277,10 @@ work_around_for_ncurses_bug(void)
 		sy = getbegy(panel_window(panel));
 		ey = getmaxy(panel_window(panel)) + sy;
 
+		/* Only the edges of the changed parts of the screen can be broken. */
+		if (!get_damaged_rows(priv, sx, ex, &sy, &ey))
+			continue;
+
 		while ((below = panel_below(below)) != NULL) {
 			if (sy > getbegy(panel_window(below)) + getmaxy(panel_window(below)) ||
 					ey < getbegy(panel_window(below)))
@@ -284,6 +344,25 @@ update_act_msg(void)
 	g_string_free(text, TRUE);
 }
 
+static void
+count_frame(GntWMPrivate *priv)
+{
+	gint64 now = g_get_monotonic_time();
+
+	if (now - priv->frames_start >= G_USEC_PER_SEC) {
+		/* If the last second had no frames at all, this is 0 */
+		if (now - priv->frames_start < 2 * G_USEC_PER_SEC) {
+			priv->frame_rate = priv->frames;
+		} else {
+			priv->frame_rate = 0;
+		}
+		priv->frames = 0;
+		priv->frames_start = now;
+	}
+	priv->frames++;
+	priv->last_frame = now;
+}
+
 static gboolean
 update_screen(GntWMPrivate *priv)
 {
@@ -291,6 +370,11 @@ update_screen(GntWMPrivate *priv)
 		return TRUE;
 	}
 
+	if (priv->frame_source) {
+		g_source_remove(priv->frame_source);
+		priv->frame_source = 0;
+	}
+
 	if (priv->menu) {
 		GntMenu *top = priv->menu;
 		while (top) {
@@ -300,12 +384,57 @@ update_screen(GntWMPrivate *priv)
 			top = gnt_menu_get_submenu(top);
 		}
 	}
-	work_around_for_ncurses_bug();
+	work_around_for_ncurses_bug(priv);
 	update_panels();
 	doupdate();
+
+	g_array_set_size(priv->damage, 0);
+	priv->damage_all = FALSE;
+	count_frame(priv);
 	return TRUE;
 }
 
+static gboolean
+draw_frame(gpointer data)
+{
+	GntWMPrivate *priv = data;
+
+	priv->frame_source = 0;
+	update_screen(priv);
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Mark the area of widget, or the whole screen if widget is NULL, as changed,
+ * and make sure the screen is updated in the next frame. */
+static void
+queue_update(GntWMPrivate *priv, GntWidget *widget)
+{
+	gint64 wait;
+
+	if (widget == NULL || priv->damage->len >= MAX_DAMAGE) {
+		priv->damage_all = TRUE;
+	} else if (!priv->damage_all) {
+		GntDamage d;
+
+		gnt_widget_get_position(widget, &d.x, &d.y);
+		gnt_widget_get_size(widget, &d.width, &d.height);
+		g_array_append_val(priv->damage, d);
+	}
+
+	if (priv->frame_source) {
+		return;
+	}
+
+	wait = priv->last_frame + FRAME_INTERVAL - g_get_monotonic_time();
+	if (wait <= 0) {
+		priv->frame_source = g_idle_add(draw_frame, priv);
+	} else {
+		priv->frame_source = g_timeout_add((wait + 999) / 1000,
+		                                   draw_frame, priv);
+	}
+}
+
 static gboolean
 sanitize_position(GntWidget *widget, int *x, int *y, gboolean m)
 {
@@ -455,6 +584,7 @@ gnt_wm_init(GntWM *wm)
 	priv->nodes = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
 	                                    free_node);
 	priv->positions = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+	priv->damage = g_array_new(FALSE, FALSE, sizeof(GntDamage));
 	if (gnt_style_get_bool(GNT_STYLE_REMPOS, TRUE)) {
 		read_window_positions(priv);
 	}
@@ -565,7 +695,7 @@ window_scroll_up(GntBindable *bindable, G_GNUC_UNUSED GList *params)
 	if (node->scroll) {
 		node->scroll--;
 		gnt_wm_copy_win(window, node);
-		update_screen(priv);
+		queue_update(priv, window);
 	}
 	return TRUE;
 }
@@ -592,7 +722,7 @@ window_scroll_down(GntBindable *bindable, G_GNUC_UNUSED GList *params)
 	if (h - node->scroll > getmaxy(node->window)) {
 		node->scroll++;
 		gnt_wm_copy_win(window, node);
-		update_screen(priv);
+		queue_update(priv, window);
 	}
 	return TRUE;
 }
@@ -616,13 +746,13 @@ window_close(GntBindable *bindable, G_GNUC_UNUSED GList *params)
 }
 
 static void
-destroy__list(G_GNUC_UNUSED GntWidget *widget, GntWMPrivate *priv)
+destroy__list(GntWidget *widget, GntWMPrivate *priv)
 {
 	priv->list.window = NULL;
 	priv->list.tree = NULL;
 	priv->windows = NULL;
 	priv->actions = NULL;
-	update_screen(priv);
+	queue_update(priv, widget);
 }
 
 static void
@@ -975,9 +1105,8 @@ shift_window(GntWMPrivate *priv, GntWidget *widget, int dir)
 		GntWidget *w = gnt_ws_get_top_widget(priv->cws);
 		GntNode *node = g_hash_table_lookup(priv->nodes, w);
 		top_panel(node->panel);
-		update_panels();
-		doupdate();
 	}
+	queue_update(priv, NULL);
 }
 
 static gboolean
@@ -1149,7 +1278,7 @@ window_reverse(GntWidget *win, gboolean set, GntWMPrivate *priv)
 	for (i = 0; i < h; i += reverse_char(d, i, w-1, set));
 
 	gnt_wm_copy_win(win, g_hash_table_lookup(priv->nodes, win));
-	update_screen(priv);
+	queue_update(priv, win);
 }
 
 static void
@@ -1241,6 +1370,7 @@ refresh_screen(GntBindable *bindable, G_GNUC_UNUSED GList *params)
 	}
 
 	gnt_ws_draw_taskbar(priv->cws, TRUE);
+	priv->damage_all = TRUE;
 	update_screen(priv);
 
 	curs_set(0);   /* endwin resets the cursor to normal */
@@ -1520,6 +1650,12 @@ gnt_wm_destroy(GObject *obj)
 
 	g_clear_pointer(&priv->loop, g_main_loop_unref);
 
+	if (priv->frame_source) {
+		g_source_remove(priv->frame_source);
+		priv->frame_source = 0;
+	}
+	g_clear_pointer(&priv->damage, g_array_unref);
+
 #ifdef USE_PYTHON
 	if (started_python) {
 		Py_Finalize();
@@ -1768,7 +1904,7 @@ gnt_wm_switch_workspace(GntWM *wm, gint n)
 	gnt_ws_show(priv->cws, priv->nodes);
 
 	gnt_ws_draw_taskbar(priv->cws, TRUE);
-	update_screen(priv);
+	queue_update(priv, NULL);
 	if (!gnt_ws_is_empty(priv->cws)) {
 		gnt_wm_raise_window(wm, gnt_ws_get_top_widget(priv->cws));
 	}
@@ -2014,7 +2150,7 @@ void gnt_wm_new_window(GntWM *wm, GntWidget *widget)
 
 	if (!gnt_widget_get_visible(widget) ||
 	    g_hash_table_lookup(priv->nodes, widget)) {
-		update_screen(priv);
+		queue_update(priv, widget);
 		return;
 	}
 
@@ -2050,7 +2186,7 @@ void gnt_wm_new_window(GntWM *wm, GntWidget *widget)
 	}
 
 	gnt_ws_draw_taskbar(priv->cws, FALSE);
-	update_screen(priv);
+	queue_update(priv, widget);
 }
 
 void gnt_wm_window_decorate(GntWM *wm, GntWidget *widget)
@@ -2099,7 +2235,7 @@ void gnt_wm_window_close(GntWM *wm, GntWidget *widget)
 	}
 
 	gnt_ws_draw_taskbar(priv->cws, FALSE);
-	update_screen(priv);
+	queue_update(priv, widget);
 }
 
 time_t
@@ -2264,6 +2400,7 @@ void gnt_wm_resize_window(GntWM *wm, GntWidget *widget, int width, int height)
 	g_signal_emit(wm, signals[SIG_CONFIRM_RESIZE], 0, widget, &width, &height, &ret);
 	if (!ret)
 		return;    /* resize is not permitted */
+	queue_update(priv, widget);
 	hide_panel(node->panel);
 	gnt_widget_set_size(widget, width, height);
 	gnt_widget_draw(widget);
@@ -2278,7 +2415,7 @@ void gnt_wm_resize_window(GntWM *wm, GntWidget *widget, int width, int height)
 	g_signal_emit(wm, signals[SIG_RESIZED], 0, node);
 
 	show_panel(node->panel);
-	update_screen(priv);
+	queue_update(priv, widget);
 }
 
 static void
@@ -2338,6 +2475,7 @@ void gnt_wm_move_window(GntWM *wm, GntWidget *widget, int x, int y)
 	if (!ret)
 		return;    /* resize is not permitted */
 
+	queue_update(priv, widget);
 	gnt_widget_set_position(widget, x, y);
 	move_panel(node->panel, y, x);
 
@@ -2354,7 +2492,7 @@ void gnt_wm_move_window(GntWM *wm, GntWidget *widget, int x, int y)
 		}
 	}
 
-	update_screen(priv);
+	queue_update(priv, widget);
 }
 
 static void
@@ -2380,7 +2518,7 @@ gnt_wm_give_focus(GntWM *wm, GntWidget *widget)
 		top_panel(nd->panel);
 	}
 	gnt_ws_draw_taskbar(priv->cws, FALSE);
-	update_screen(priv);
+	queue_update(priv, widget);
 }
 
 void gnt_wm_update_window(GntWM *wm, GntWidget *widget)
@@ -2409,7 +2547,7 @@ void gnt_wm_update_window(GntWM *wm, GntWidget *widget)
 	if (ws == priv->cws || gnt_widget_get_transient(widget)) {
 		gnt_wm_copy_win(widget, node);
 		gnt_ws_draw_taskbar(priv->cws, FALSE);
-		update_screen(priv);
+		queue_update(priv, widget);
 	} else if (ws && ws != priv->cws && gnt_widget_get_is_urgent(widget)) {
 		if (!act || !g_list_find(act, ws)) {
 			act = g_list_prepend(act, ws);
@@ -2471,6 +2609,38 @@ gnt_wm_has_window_position(GntWM *wm, const gchar *title)
 	return g_hash_table_lookup(priv->positions, title) != NULL;
 }
 
+void
+gnt_wm_queue_redraw(GntWM *wm, GntWidget *widget)
+{
+	GntWMPrivate *priv = NULL;
+
+	g_return_if_fail(GNT_IS_WM(wm));
+	priv = gnt_wm_get_instance_private(wm);
+
+	if (widget != NULL) {
+		widget = gnt_widget_get_toplevel(widget);
+	}
+	queue_update(priv, widget);
+}
+
+guint
+gnt_wm_get_redraw_rate(GntWM *wm)
+{
+	GntWMPrivate *priv = NULL;
+	gint64 elapsed;
+
+	g_return_val_if_fail(GNT_IS_WM(wm), 0);
+	priv = gnt_wm_get_instance_private(wm);
+
+	elapsed = g_get_monotonic_time() - priv->frames_start;
+	if (elapsed < G_USEC_PER_SEC) {
+		return priv->frame_rate;
+	} else if (elapsed < 2 * G_USEC_PER_SEC) {
+		return priv->frames;
+	}
+	return 0;
+}
+
 /* Private. */
 void
 gnt_wm_set_mainloop(GntWM *wm, GMainLoop *loop)
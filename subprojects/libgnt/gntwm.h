@@ -328,6 +328,31 @@ time_t gnt_wm_get_idle_time(void);
  */
 gboolean gnt_wm_has_window_position(GntWM *wm, const gchar *title);
 
+/**
+ * gnt_wm_queue_redraw:
+ * @wm:     The window-manager.
+ * @widget: (nullable): The window that changed, or %NULL if the whole screen
+ *          needs to be redrawn.
+ *
+ * Mark the area of a window as changed, and schedule a screen update. Screen
+ * updates are coalesced, so the screen is refreshed at most once per frame.
+ *
+ * Since: 3.0.0
+ */
+void gnt_wm_queue_redraw(GntWM *wm, GntWidget *widget);
+
+/**
+ * gnt_wm_get_redraw_rate:
+ * @wm:    The window-manager.
+ *
+ * Get the number of times the screen was refreshed in the last second.
+ *
+ * Returns: The number of screen updates in the last full second.
+ *
+ * Since: 3.0.0
+ */
+guint gnt_wm_get_redraw_rate(GntWM *wm);
+
 G_END_DECLS
 
 #endif
@@ -144,7 +144,8 @@ gnt_ws_draw_taskbar(GntWS *ws, gboolean reposition)
 		if (i)
 			mvwaddch(taskbar, 0, width *i - 1, ACS_VLINE | A_STANDOUT | gnt_color_pair(GNT_COLOR_NORMAL));
 	}
-	wrefresh(taskbar);
+	/* This is sent to the screen with the next update of the window-manager */
+	wnoutrefresh(taskbar);
 }
 
 gboolean
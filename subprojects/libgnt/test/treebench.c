@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <gnt.h>
+
+#define ROWS 20000
+
+/* Sort key of each row, indexed by the row's key. */
+static guint32 weights[ROWS + 1];
+
+static gint
+compare_rows(gconstpointer a, gconstpointer b)
+{
+	guint32 wa = weights[GPOINTER_TO_INT(a)];
+	guint32 wb = weights[GPOINTER_TO_INT(b)];
+
+	if (wa < wb)
+		return -1;
+	if (wa > wb)
+		return 1;
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	GntWidget *tree;
+	GTimer *timer;
+	GRand *rand;
+	int rows = ROWS;
+	int i;
+
+	if (argc > 1)
+		rows = CLAMP(atoi(argv[1]), 1, ROWS);
+
+	rand = g_rand_new_with_seed(42);
+	tree = gnt_tree_new();
+	gnt_tree_set_compare_func(GNT_TREE(tree), compare_rows);
+
+	for (i = 1; i <= rows; i++)
+		weights[i] = g_rand_int(rand);
+
+	timer = g_timer_new();
+	for (i = 1; i <= rows; i++) {
+		char *text = g_strdup_printf("row %d", i);
+		GntTreeRow *row = gnt_tree_create_row(GNT_TREE(tree), text);
+		gnt_tree_add_row_after(GNT_TREE(tree), GINT_TO_POINTER(i), row,
+		                       NULL, NULL);
+		g_free(text);
+	}
+	g_timer_stop(timer);
+	printf("insert %d rows: %.3f s\n", rows, g_timer_elapsed(timer, NULL));
+
+	/* Every row changes its sort key once, like a presence flood would. */
+	g_timer_start(timer);
+	for (i = 1; i <= rows; i++) {
+		weights[i] = g_rand_int(rand);
+		gnt_tree_sort_row(GNT_TREE(tree), GINT_TO_POINTER(i));
+	}
+	g_timer_stop(timer);
+	printf("re-sort %d rows: %.3f s\n", rows, g_timer_elapsed(timer, NULL));
+
+	g_timer_destroy(timer);
+	g_rand_free(rand);
+
+	return 0;
+}